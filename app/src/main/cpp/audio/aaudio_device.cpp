@@ -0,0 +1,364 @@
+#include "audio/aaudio_device.h"
+
+#include <aaudio/AAudio.h>
+#include <android/log.h>
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "audio/callback_stats.h"
+
+#define LOG_TAG "vcmedia"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace vc {
+
+namespace {
+
+// The subset of libaaudio we use, resolved with dlsym.
+struct AAudioApi {
+  aaudio_result_t (*createStreamBuilder)(AAudioStreamBuilder**);
+  void (*setDirection)(AAudioStreamBuilder*, aaudio_direction_t);
+  void (*setSampleRate)(AAudioStreamBuilder*, int32_t);
+  void (*setChannelCount)(AAudioStreamBuilder*, int32_t);
+  void (*setFormat)(AAudioStreamBuilder*, aaudio_format_t);
+  void (*setPerformanceMode)(AAudioStreamBuilder*, aaudio_performance_mode_t);
+  void (*setSharingMode)(AAudioStreamBuilder*, aaudio_sharing_mode_t);
+  void (*setDataCallback)(AAudioStreamBuilder*, AAudioStream_dataCallback,
+                          void*);
+  void (*setErrorCallback)(AAudioStreamBuilder*, AAudioStream_errorCallback,
+                           void*);
+  aaudio_result_t (*openStream)(AAudioStreamBuilder*, AAudioStream**);
+  aaudio_result_t (*deleteBuilder)(AAudioStreamBuilder*);
+  aaudio_result_t (*requestStart)(AAudioStream*);
+  aaudio_result_t (*requestStop)(AAudioStream*);
+  aaudio_result_t (*close)(AAudioStream*);
+  aaudio_result_t (*read)(AAudioStream*, void*, int32_t, int64_t);
+  int32_t (*getXRunCount)(AAudioStream*);
+  int32_t (*getFramesPerBurst)(AAudioStream*);
+  int32_t (*getBufferCapacityInFrames)(AAudioStream*);
+  aaudio_result_t (*setBufferSizeInFrames)(AAudioStream*, int32_t);
+
+  bool Load() {
+    void* lib = dlopen("libaaudio.so", RTLD_NOW);
+    if (!lib) return false;
+    bool ok = true;
+    auto resolve = [&](auto& fn, const char* name) {
+      fn = reinterpret_cast<std::remove_reference_t<decltype(fn)>>(
+          dlsym(lib, name));
+      ok = ok && fn != nullptr;
+    };
+    resolve(createStreamBuilder, "AAudio_createStreamBuilder");
+    resolve(setDirection, "AAudioStreamBuilder_setDirection");
+    resolve(setSampleRate, "AAudioStreamBuilder_setSampleRate");
+    resolve(setChannelCount, "AAudioStreamBuilder_setChannelCount");
+    resolve(setFormat, "AAudioStreamBuilder_setFormat");
+    resolve(setPerformanceMode, "AAudioStreamBuilder_setPerformanceMode");
+    resolve(setSharingMode, "AAudioStreamBuilder_setSharingMode");
+    resolve(setDataCallback, "AAudioStreamBuilder_setDataCallback");
+    resolve(setErrorCallback, "AAudioStreamBuilder_setErrorCallback");
+    resolve(openStream, "AAudioStreamBuilder_openStream");
+    resolve(deleteBuilder, "AAudioStreamBuilder_delete");
+    resolve(requestStart, "AAudioStream_requestStart");
+    resolve(requestStop, "AAudioStream_requestStop");
+    resolve(close, "AAudioStream_close");
+    resolve(read, "AAudioStream_read");
+    resolve(getXRunCount, "AAudioStream_getXRunCount");
+    resolve(getFramesPerBurst, "AAudioStream_getFramesPerBurst");
+    resolve(getBufferCapacityInFrames, "AAudioStream_getBufferCapacityInFrames");
+    resolve(setBufferSizeInFrames, "AAudioStream_setBufferSizeInFrames");
+    return ok;
+  }
+};
+
+const AAudioApi* GetApi() {
+  static AAudioApi api;
+  static bool loaded = api.Load();
+  return loaded ? &api : nullptr;
+}
+
+// Single-threaded ring of samples used inside the audio callback. Callers
+// keep pushes within space().
+class SampleFifo {
+ public:
+  explicit SampleFifo(size_t capacity) : buffer_(capacity) {}
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return buffer_.size(); }
+  size_t space() const { return buffer_.size() - size_; }
+
+  // Empties the ring and makes room for `capacity` samples. Not for the
+  // audio callback.
+  void Reset(size_t capacity) {
+    buffer_.assign(capacity, 0.0f);
+    head_ = 0;
+    size_ = 0;
+  }
+
+  void Push(const float* samples, size_t count) {
+    count = std::min(count, space());
+    for (size_t i = 0; i < count; ++i) {
+      buffer_[(head_ + size_ + i) % buffer_.size()] = samples[i];
+    }
+    size_ += count;
+  }
+
+  void Pop(float* samples, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      samples[i] = buffer_[(head_ + i) % buffer_.size()];
+    }
+    Drop(count);
+  }
+
+  void Drop(size_t count) {
+    head_ = (head_ + count) % buffer_.size();
+    size_ -= count;
+  }
+
+ private:
+  std::vector<float> buffer_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
+// The output stream's data callback drives everything: it reads whatever
+// capture audio is ready without blocking, regroups it into 10 ms frames and
+// pulls as many playout frames as the burst needs. When the route changes
+// (a headset plugged or unplugged) AAudio disconnects the streams; they are
+// reopened on the new device from a thread of our own, since the error
+// callback may not close them.
+class AAudioDevice : public AudioDevice {
+ public:
+  AAudioDevice(const AAudioApi* api, const AudioDeviceConfig& config)
+      : api_(api),
+        config_(config),
+        frame_size_(config.sample_rate * config.frame_ms / 1000),
+        stats_(static_cast<int64_t>(config.frame_ms) * 1000000),
+        capture_fifo_(static_cast<size_t>(frame_size_) * 8),
+        playout_fifo_(static_cast<size_t>(frame_size_) *
+                      config.playout_channels * 8),
+        capture_frame_(frame_size_),
+        playout_frame_(static_cast<size_t>(frame_size_) *
+                       config.playout_channels),
+        capture_burst_(static_cast<size_t>(frame_size_) * 4) {}
+
+  ~AAudioDevice() override { Stop(); }
+
+  bool Start(AudioTransport* transport) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_ || !transport) return false;
+    transport_ = transport;
+    stats_.Reset();
+    closed_xruns_ = 0;
+    return StartLocked();
+  }
+
+  void Stop() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      StopLocked();
+    }
+    std::thread restart;
+    {
+      std::lock_guard<std::mutex> lock(restart_mutex_);
+      restart.swap(restart_thread_);
+    }
+    if (restart.joinable()) restart.join();
+  }
+
+  bool Playing() const override { return running_; }
+
+  AudioDeviceStats GetStats() const override {
+    AudioDeviceStats stats = stats_.Snapshot();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.playout_underruns += closed_xruns_;
+    if (output_) stats.playout_underruns += api_->getXRunCount(output_);
+    return stats;
+  }
+
+ private:
+  bool StartLocked() {
+    if (!OpenStream(AAUDIO_DIRECTION_INPUT, 1, &input_) ||
+        !OpenStream(AAUDIO_DIRECTION_OUTPUT, config_.playout_channels,
+                    &output_)) {
+      CloseStreams();
+      return false;
+    }
+    int32_t burst = api_->getFramesPerBurst(output_);
+    api_->setBufferSizeInFrames(output_, 2 * burst);
+    // A callback may ask for up to the buffer capacity, and the playout fifo
+    // holds up to one frame more than it was asked for.
+    const size_t max_frames = static_cast<size_t>(
+        std::max(api_->getBufferCapacityInFrames(output_), 2 * burst));
+    const size_t channels = config_.playout_channels;
+    playout_fifo_.Reset((max_frames + frame_size_) * channels);
+    capture_fifo_.Reset(max_frames + frame_size_);
+    capture_burst_.assign(max_frames, 0.0f);
+    running_ = true;
+    if (api_->requestStart(input_) != AAUDIO_OK ||
+        api_->requestStart(output_) != AAUDIO_OK) {
+      StopLocked();
+      return false;
+    }
+    return true;
+  }
+
+  void StopLocked() {
+    if (output_) api_->requestStop(output_);
+    if (input_) api_->requestStop(input_);
+    CloseStreams();
+    running_ = false;
+  }
+
+  // Reopens both streams after a disconnect, unless stopped meanwhile.
+  void Restart() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (running_) {
+        StopLocked();
+        if (!StartLocked()) LOGE("AAudio restart after disconnect failed");
+      }
+    }
+    std::lock_guard<std::mutex> lock(restart_mutex_);
+    restarting_ = false;
+  }
+
+  bool OpenStream(aaudio_direction_t direction, int channels,
+                  AAudioStream** stream) {
+    AAudioStreamBuilder* builder = nullptr;
+    if (api_->createStreamBuilder(&builder) != AAUDIO_OK) return false;
+    api_->setDirection(builder, direction);
+    api_->setSampleRate(builder, config_.sample_rate);
+    api_->setChannelCount(builder, channels);
+    api_->setFormat(builder, AAUDIO_FORMAT_PCM_FLOAT);
+    api_->setPerformanceMode(builder, AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
+    api_->setSharingMode(builder, AAUDIO_SHARING_MODE_EXCLUSIVE);
+    api_->setErrorCallback(builder, &AAudioDevice::OnError, this);
+    if (direction == AAUDIO_DIRECTION_OUTPUT) {
+      api_->setDataCallback(builder, &AAudioDevice::OnAudioReady, this);
+    }
+    aaudio_result_t result = api_->openStream(builder, stream);
+    api_->deleteBuilder(builder);
+    if (result != AAUDIO_OK) {
+      LOGE("AAudio openStream failed: %d", result);
+      *stream = nullptr;
+      return false;
+    }
+    return true;
+  }
+
+  void CloseStreams() {
+    if (output_) closed_xruns_ += api_->getXRunCount(output_);
+    if (output_) api_->close(output_);
+    if (input_) api_->close(input_);
+    output_ = nullptr;
+    input_ = nullptr;
+  }
+
+  static aaudio_data_callback_result_t OnAudioReady(AAudioStream*,
+                                                    void* user_data,
+                                                    void* audio_data,
+                                                    int32_t num_frames) {
+    static_cast<AAudioDevice*>(user_data)->Process(
+        static_cast<float*>(audio_data), num_frames);
+    return AAUDIO_CALLBACK_RESULT_CONTINUE;
+  }
+
+  static void OnError(AAudioStream*, void* user_data, aaudio_result_t error) {
+    LOGE("AAudio stream error: %d", error);
+    auto* self = static_cast<AAudioDevice*>(user_data);
+    if (error != AAUDIO_ERROR_DISCONNECTED) {
+      self->running_ = false;
+      return;
+    }
+    // Both streams report the disconnect; restart once.
+    std::lock_guard<std::mutex> lock(self->restart_mutex_);
+    if (self->restarting_ || !self->running_) return;
+    self->restarting_ = true;
+    // A previous restart has finished by now; reap its thread.
+    if (self->restart_thread_.joinable()) self->restart_thread_.join();
+    self->restart_thread_ = std::thread([self] { self->Restart(); });
+  }
+
+  void Process(float* out, int32_t num_frames) {
+    // The fifos are sized for the largest callback the stream can make;
+    // should one still ask for more, fill it in pieces.
+    const int32_t max_frames = static_cast<int32_t>(capture_burst_.size());
+    while (num_frames > max_frames) {
+      ProcessChunk(out, max_frames);
+      out += static_cast<size_t>(max_frames) * config_.playout_channels;
+      num_frames -= max_frames;
+    }
+    ProcessChunk(out, num_frames);
+  }
+
+  void ProcessChunk(float* out, int32_t num_frames) {
+    // Drain ready capture audio; drop the oldest if we fall behind.
+    aaudio_result_t read = api_->read(input_, capture_burst_.data(), num_frames, 0);
+    if (read > 0) {
+      size_t overflow = read > static_cast<int32_t>(capture_fifo_.space())
+                            ? read - capture_fifo_.space()
+                            : 0;
+      if (overflow > 0) {
+        capture_fifo_.Drop(overflow);
+        stats_.AddCaptureUnderruns(1);
+      }
+      capture_fifo_.Push(capture_burst_.data(), read);
+    }
+
+    const size_t channels = config_.playout_channels;
+    const size_t needed = static_cast<size_t>(num_frames) * channels;
+    while (playout_fifo_.size() < needed) {
+      stats_.OnFrameStart(MonotonicNowNs());
+      if (capture_fifo_.size() >= static_cast<size_t>(frame_size_)) {
+        capture_fifo_.Pop(capture_frame_.data(), frame_size_);
+      } else {
+        std::fill(capture_frame_.begin(), capture_frame_.end(), 0.0f);
+        stats_.AddCaptureUnderruns(1);
+      }
+      transport_->OnCapturedFrame(capture_frame_.data(), frame_size_);
+      transport_->OnPlayoutFrame(playout_frame_.data(), frame_size_,
+                                 config_.playout_channels);
+      playout_fifo_.Push(playout_frame_.data(), playout_frame_.size());
+      stats_.OnFrameEnd(MonotonicNowNs());
+    }
+    playout_fifo_.Pop(out, needed);
+  }
+
+  const AAudioApi* api_;
+  const AudioDeviceConfig config_;
+  const int frame_size_;
+  CallbackStats stats_;
+  SampleFifo capture_fifo_;
+  SampleFifo playout_fifo_;
+  std::vector<float> capture_frame_;
+  std::vector<float> playout_frame_;
+  std::vector<float> capture_burst_;
+  AudioTransport* transport_ = nullptr;
+  // Guards opening and closing the streams; the data callback only runs
+  // while both are open.
+  mutable std::mutex mutex_;
+  AAudioStream* input_ = nullptr;
+  AAudioStream* output_ = nullptr;
+  // Underruns of streams closed by a restart.
+  uint64_t closed_xruns_ = 0;
+  std::atomic<bool> running_{false};
+  std::mutex restart_mutex_;
+  bool restarting_ = false;
+  std::thread restart_thread_;
+};
+
+}  // namespace
+
+std::unique_ptr<AudioDevice> CreateAAudioDevice(const AudioDeviceConfig& config) {
+  const AAudioApi* api = GetApi();
+  if (!api) return nullptr;
+  return std::make_unique<AAudioDevice>(api, config);
+}
+
+}  // namespace vc
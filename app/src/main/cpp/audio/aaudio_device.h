@@ -0,0 +1,16 @@
+#ifndef VCMEDIA_AUDIO_AAUDIO_DEVICE_H_
+#define VCMEDIA_AUDIO_AAUDIO_DEVICE_H_
+
+#include <memory>
+
+#include "audio/audio_device.h"
+
+namespace vc {
+
+// Full-duplex low-latency device on AAudio. libaaudio is loaded at runtime
+// because minSdk predates it; returns nullptr on devices without it.
+std::unique_ptr<AudioDevice> CreateAAudioDevice(const AudioDeviceConfig& config);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_AAUDIO_DEVICE_H_
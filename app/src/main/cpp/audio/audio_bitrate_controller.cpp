@@ -0,0 +1,93 @@
+#include "audio/audio_bitrate_controller.h"
+
+#include <algorithm>
+
+#include "audio/red_encoder.h"
+
+namespace vc {
+
+namespace {
+
+// Loss rises quickly so protection arrives with the burst, and decays slowly
+// so it is not dropped between bursts.
+constexpr double kLossRiseAlpha = 0.5;
+constexpr double kLossDecayAlpha = 0.1;
+
+}  // namespace
+
+AudioBitrateController::AudioBitrateController()
+    : AudioBitrateController(Config()) {}
+
+AudioBitrateController::AudioBitrateController(const Config& config)
+    : config_(config) {
+  target_.codec_bitrate_bps = config_.max_codec_bitrate_bps;
+  target_.total_bitrate_bps = TotalBitrate(target_.codec_bitrate_bps, 0);
+}
+
+void AudioBitrateController::OnLossReport(double fraction_lost) {
+  fraction_lost = std::clamp(fraction_lost, 0.0, 1.0);
+  if (!has_loss_) {
+    loss_ = fraction_lost;
+    has_loss_ = true;
+  } else {
+    double alpha = fraction_lost > loss_ ? kLossRiseAlpha : kLossDecayAlpha;
+    loss_ += alpha * (fraction_lost - loss_);
+  }
+  Update();
+}
+
+void AudioBitrateController::OnBandwidthEstimate(int bitrate_bps) {
+  bandwidth_bps_ = std::max(0, bitrate_bps);
+  Update();
+}
+
+int AudioBitrateController::LossDepth() {
+  while (loss_depth_ < kRedMaxDepth &&
+         loss_ >= config_.depth_up_loss[loss_depth_]) {
+    ++loss_depth_;
+  }
+  while (loss_depth_ > 0 && loss_ < config_.depth_down_loss[loss_depth_ - 1]) {
+    --loss_depth_;
+  }
+  return loss_depth_;
+}
+
+int AudioBitrateController::TotalBitrate(int codec_bitrate_bps,
+                                         int depth) const {
+  int packets_per_second = 1000 / config_.frame_duration_ms;
+  int header_bps = (4 * depth + 1) * 8 * packets_per_second;
+  return codec_bitrate_bps * (depth + 1) + header_bps;
+}
+
+void AudioBitrateController::Update() {
+  int depth = LossDepth();
+  int codec = config_.max_codec_bitrate_bps;
+
+  if (bandwidth_bps_ > 0) {
+    int budget = static_cast<int>(bandwidth_bps_ * config_.audio_share);
+    for (;; --depth) {
+      int header_bps = TotalBitrate(0, depth);
+      codec = (budget - header_bps) / (depth + 1);
+      int floor = depth > 0 ? config_.min_codec_bitrate_with_red_bps
+                            : config_.min_codec_bitrate_bps;
+      if (codec >= floor || depth == 0) break;
+    }
+    codec = std::clamp(codec, config_.min_codec_bitrate_bps,
+                       config_.max_codec_bitrate_bps);
+  }
+
+  // Decreases apply at once; increases are rate limited so a single good
+  // estimate does not cause an audible jump.
+  int previous = target_.codec_bitrate_bps;
+  if (codec > previous) {
+    int step = std::max(1000, static_cast<int>(previous *
+                                               config_.max_increase_ratio));
+    codec = std::min(codec, previous + step);
+  }
+
+  target_.codec_bitrate_bps = codec;
+  target_.red_depth = depth;
+  target_.total_bitrate_bps = TotalBitrate(codec, depth);
+}
+
+}  // namespace vc
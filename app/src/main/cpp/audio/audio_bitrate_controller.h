@@ -0,0 +1,60 @@
+#ifndef VCMEDIA_AUDIO_AUDIO_BITRATE_CONTROLLER_H_
+#define VCMEDIA_AUDIO_AUDIO_BITRATE_CONTROLLER_H_
+
+#include <cstdint>
+
+namespace vc {
+
+// Chooses the audio codec bitrate and RED depth together so that the primary
+// stream plus its redundant copies fit inside the audio share of the
+// bandwidth estimate. Depth follows smoothed loss with hysteresis.
+class AudioBitrateController {
+ public:
+  struct Config {
+    int frame_duration_ms = 20;
+    int min_codec_bitrate_bps = 6000;
+    int max_codec_bitrate_bps = 40000;
+    // Codec bitrate below which redundancy is dropped before quality is.
+    int min_codec_bitrate_with_red_bps = 10000;
+    // Fraction of the bandwidth estimate audio may use (audio goes first).
+    double audio_share = 0.5;
+    // Loss at which depth steps up to 1, 2, 3 and back down.
+    double depth_up_loss[3] = {0.01, 0.05, 0.12};
+    double depth_down_loss[3] = {0.005, 0.03, 0.08};
+    // Largest relative codec bitrate increase per update.
+    double max_increase_ratio = 0.1;
+  };
+
+  struct Target {
+    int codec_bitrate_bps = 0;
+    int red_depth = 0;
+    // Payload rate on the wire including redundancy and RED headers.
+    int total_bitrate_bps = 0;
+  };
+
+  AudioBitrateController();
+  explicit AudioBitrateController(const Config& config);
+
+  // `fraction_lost` is the RTCP receiver report value in [0, 1].
+  void OnLossReport(double fraction_lost);
+  void OnBandwidthEstimate(int bitrate_bps);
+
+  double smoothed_loss() const { return loss_; }
+  const Target& target() const { return target_; }
+
+ private:
+  void Update();
+  int LossDepth();
+  int TotalBitrate(int codec_bitrate_bps, int depth) const;
+
+  Config config_;
+  double loss_ = 0.0;
+  bool has_loss_ = false;
+  int loss_depth_ = 0;
+  int bandwidth_bps_ = 0;
+  Target target_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_AUDIO_BITRATE_CONTROLLER_H_
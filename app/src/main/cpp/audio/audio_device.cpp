@@ -0,0 +1,201 @@
+#include "audio/audio_device.h"
+
+#include <pthread.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "audio/callback_stats.h"
+#include "audio/wav_file.h"
+
+#if defined(__ANDROID__)
+#include "audio/aaudio_device.h"
+#endif
+
+namespace vc {
+
+namespace {
+
+void RaiseThreadPriority() {
+  // Needs CAP_SYS_NICE or an rtkit grant; running at normal priority is fine
+  // for host benchmarks, it just shows up as more jitter.
+  sched_param param{};
+  param.sched_priority = 2;
+  pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+}
+
+// Drives the transport from its own thread at the frame cadence. Subclasses
+// supply the capture source and the playout sink.
+class TimerAudioDevice : public AudioDevice {
+ public:
+  explicit TimerAudioDevice(const AudioDeviceConfig& config)
+      : config_(config),
+        frame_size_(config.sample_rate * config.frame_ms / 1000),
+        period_ns_(static_cast<int64_t>(config.frame_ms) * 1000000),
+        stats_(period_ns_),
+        capture_(frame_size_),
+        playout_(static_cast<size_t>(frame_size_) * config.playout_channels) {}
+
+  ~TimerAudioDevice() override { Stop(); }
+
+  bool Start(AudioTransport* transport) override {
+    if (running_ || !transport) return false;
+    // The thread of a run that ended on its own (input exhausted) is done
+    // but still joinable.
+    if (thread_.joinable()) thread_.join();
+    transport_ = transport;
+    stats_.Reset();
+    running_ = true;
+    thread_ = std::thread([this] { Run(); });
+    return true;
+  }
+
+  void Stop() override {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+  }
+
+  bool Playing() const override { return running_; }
+  AudioDeviceStats GetStats() const override { return stats_.Snapshot(); }
+
+ protected:
+  // Returns false when the capture source is exhausted.
+  virtual bool ReadCapture(float* samples, int frames) = 0;
+  virtual void WritePlayout(const float* samples, int frames, int channels) = 0;
+
+  const AudioDeviceConfig config_;
+
+ private:
+  void Run() {
+    if (config_.realtime) RaiseThreadPriority();
+    int64_t deadline = MonotonicNowNs();
+    while (running_) {
+      int64_t now = MonotonicNowNs();
+      if (config_.realtime) {
+        if (deadline > now) {
+          std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - now));
+          now = MonotonicNowNs();
+        }
+        // Woke more than a whole period late: a real device would have
+        // played out silence for the frames in between.
+        int64_t missed = (now - deadline) / period_ns_;
+        if (missed > 0) {
+          stats_.AddPlayoutUnderruns(static_cast<uint64_t>(missed));
+          stats_.AddCaptureUnderruns(static_cast<uint64_t>(missed));
+          deadline += missed * period_ns_;
+        }
+      }
+
+      stats_.OnFrameStart(now);
+      if (!ReadCapture(capture_.data(), frame_size_)) {
+        running_ = false;
+        break;
+      }
+      transport_->OnCapturedFrame(capture_.data(), frame_size_);
+      transport_->OnPlayoutFrame(playout_.data(), frame_size_,
+                                 config_.playout_channels);
+      WritePlayout(playout_.data(), frame_size_, config_.playout_channels);
+      stats_.OnFrameEnd(MonotonicNowNs());
+      deadline += period_ns_;
+    }
+  }
+
+  const int frame_size_;
+  const int64_t period_ns_;
+  CallbackStats stats_;
+  std::vector<float> capture_;
+  std::vector<float> playout_;
+  AudioTransport* transport_ = nullptr;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+};
+
+class NullAudioDevice : public TimerAudioDevice {
+ public:
+  using TimerAudioDevice::TimerAudioDevice;
+
+ protected:
+  bool ReadCapture(float* samples, int frames) override {
+    std::fill(samples, samples + frames, 0.0f);
+    return true;
+  }
+  void WritePlayout(const float*, int, int) override {}
+};
+
+class FileAudioDevice : public TimerAudioDevice {
+ public:
+  explicit FileAudioDevice(const AudioDeviceConfig& config)
+      : TimerAudioDevice(config) {}
+
+  bool Open() {
+    if (!config_.input_path.empty()) {
+      if (!reader_.Open(config_.input_path)) return false;
+      if (reader_.sample_rate() != config_.sample_rate) return false;
+    }
+    if (!config_.output_path.empty() &&
+        !writer_.Open(config_.output_path, config_.sample_rate,
+                      config_.playout_channels)) {
+      return false;
+    }
+    return true;
+  }
+
+  ~FileAudioDevice() override {
+    Stop();
+    writer_.Close();
+  }
+
+ protected:
+  bool ReadCapture(float* samples, int frames) override {
+    if (config_.input_path.empty()) {
+      std::fill(samples, samples + frames, 0.0f);
+      return true;
+    }
+    int read = reader_.ReadMono(samples, frames);
+    if (read < frames && config_.loop_input && reader_.frames() > 0) {
+      reader_.Rewind();
+      read += reader_.ReadMono(samples + read, frames - read);
+    }
+    if (read == 0) return false;
+    std::fill(samples + read, samples + frames, 0.0f);
+    return true;
+  }
+
+  void WritePlayout(const float* samples, int frames, int) override {
+    writer_.Write(samples, frames);
+  }
+
+ private:
+  WavReader reader_;
+  WavWriter writer_;
+};
+
+}  // namespace
+
+std::unique_ptr<AudioDevice> CreateAudioDevice(AudioDeviceBackend backend,
+                                               const AudioDeviceConfig& config) {
+  if (config.sample_rate <= 0 || config.frame_ms <= 0 ||
+      config.playout_channels <= 0) {
+    return nullptr;
+  }
+  switch (backend) {
+    case AudioDeviceBackend::kNull:
+      return std::make_unique<NullAudioDevice>(config);
+    case AudioDeviceBackend::kFile: {
+      auto device = std::make_unique<FileAudioDevice>(config);
+      if (!device->Open()) return nullptr;
+      return device;
+    }
+    case AudioDeviceBackend::kPlatform:
+#if defined(__ANDROID__)
+      return CreateAAudioDevice(config);
+#else
+      return nullptr;
+#endif
+  }
+  return nullptr;
+}
+
+}  // namespace vc
@@ -0,0 +1,73 @@
+#ifndef VCMEDIA_AUDIO_AUDIO_DEVICE_H_
+#define VCMEDIA_AUDIO_AUDIO_DEVICE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace vc {
+
+// Receives audio at a fixed 10 ms cadence on the device's real-time thread.
+// Both calls must return well within the frame period and must not block.
+class AudioTransport {
+ public:
+  virtual ~AudioTransport() = default;
+  // `samples` holds one frame of mono capture audio.
+  virtual void OnCapturedFrame(const float* samples, int frames) = 0;
+  // Fill `samples` with one frame of interleaved playout audio.
+  virtual void OnPlayoutFrame(float* samples, int frames, int channels) = 0;
+};
+
+struct AudioDeviceConfig {
+  int sample_rate = 48000;
+  int playout_channels = 2;
+  int frame_ms = 10;
+  // Pace callbacks in wall-clock time. Host backends can run free for
+  // benchmarking; the platform backend is always real time.
+  bool realtime = true;
+  // File backend only.
+  std::string input_path;
+  std::string output_path;
+  bool loop_input = false;
+};
+
+struct AudioDeviceStats {
+  uint64_t frames = 0;
+  // Playout frames the device needed but the pipeline did not deliver in
+  // time (device xruns, or timer callbacks more than a period late).
+  uint64_t playout_underruns = 0;
+  // Capture frames the device dropped or could not supply.
+  uint64_t capture_underruns = 0;
+  // Deviation of the interval between frame callbacks from the frame period.
+  double mean_jitter_us = 0.0;
+  double max_jitter_us = 0.0;
+  // Time spent inside the transport per frame.
+  double mean_callback_us = 0.0;
+  double max_callback_us = 0.0;
+};
+
+class AudioDevice {
+ public:
+  virtual ~AudioDevice() = default;
+
+  virtual bool Start(AudioTransport* transport) = 0;
+  virtual void Stop() = 0;
+  // False once stopped, or when a non-looping file input has been consumed.
+  virtual bool Playing() const = 0;
+  virtual AudioDeviceStats GetStats() const = 0;
+};
+
+enum class AudioDeviceBackend {
+  kPlatform,  // AAudio on Android; unavailable elsewhere.
+  kFile,      // WAV capture input and playout output.
+  kNull,      // Silence in, output discarded.
+};
+
+// Returns nullptr if the backend is unavailable on this platform or the
+// configuration is invalid (e.g. an unreadable input file).
+std::unique_ptr<AudioDevice> CreateAudioDevice(AudioDeviceBackend backend,
+                                               const AudioDeviceConfig& config);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_AUDIO_DEVICE_H_
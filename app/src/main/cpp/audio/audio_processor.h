@@ -0,0 +1,17 @@
+#ifndef VCMEDIA_AUDIO_AUDIO_PROCESSOR_H_
+#define VCMEDIA_AUDIO_AUDIO_PROCESSOR_H_
+
+namespace vc {
+
+// A capture or render stage that rewrites 10 ms mono float frames in place.
+// Implementations run on the real-time audio thread and must not allocate,
+// lock or block in ProcessFrame().
+class AudioProcessor {
+ public:
+  virtual ~AudioProcessor() = default;
+  virtual void ProcessFrame(float* samples, int count) = 0;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_AUDIO_PROCESSOR_H_
@@ -0,0 +1,79 @@
+#include "audio/automatic_gain_control.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vc {
+
+namespace {
+
+constexpr float kNoiseFloorRiseDbPerS = 2.0f;
+constexpr float kNoiseFloorFallAlpha = 0.5f;
+constexpr float kSpeechLevelRiseTauS = 0.3f;
+constexpr float kSpeechLevelFallTauS = 1.0f;
+
+}  // namespace
+
+AutomaticGainControl::AutomaticGainControl()
+    : AutomaticGainControl(Config()) {}
+
+AutomaticGainControl::AutomaticGainControl(const Config& config)
+    : config_(config),
+      limiter_(config.sample_rate, config.limiter_lookahead_ms,
+               config.limiter_ceiling_dbfs, config.limiter_release_ms),
+      speech_level_db_(config.target_level_dbfs) {}
+
+void AutomaticGainControl::ProcessFrame(float* samples, int count) {
+  if (count <= 0) return;
+  const float frame_s = static_cast<float>(count) / config_.sample_rate;
+
+  float energy = 0.0f;
+  for (int i = 0; i < count; ++i) energy += samples[i] * samples[i];
+  float frame_db = 10.0f * std::log10(energy / count + 1e-12f);
+
+  // Noise floor: follows dips quickly, creeps up slowly through speech.
+  if (frames_processed_ == 0) {
+    noise_floor_db_ = frame_db;
+  } else if (frame_db < noise_floor_db_) {
+    noise_floor_db_ += kNoiseFloorFallAlpha * (frame_db - noise_floor_db_);
+  } else {
+    noise_floor_db_ = std::min(
+        frame_db, noise_floor_db_ + kNoiseFloorRiseDbPerS * frame_s);
+  }
+  ++frames_processed_;
+
+  speech_ = frame_db > noise_floor_db_ + config_.speech_margin_db &&
+            frame_db > config_.min_speech_level_dbfs;
+  if (speech_) {
+    if (!has_speech_level_) {
+      speech_level_db_ = frame_db;
+      has_speech_level_ = true;
+    } else {
+      float tau = frame_db > speech_level_db_ ? kSpeechLevelRiseTauS
+                                              : kSpeechLevelFallTauS;
+      speech_level_db_ += (frame_s / tau) * (frame_db - speech_level_db_);
+    }
+  }
+
+  if (has_speech_level_) {
+    float desired = std::clamp(config_.target_level_dbfs - speech_level_db_,
+                               config_.min_gain_db, config_.max_gain_db);
+    float up = config_.max_increase_db_per_s * frame_s;
+    float down = config_.max_decrease_db_per_s * frame_s;
+    gain_db_ += std::clamp(desired - gain_db_, -down, up);
+  }
+
+  // Ramp across the frame so gain steps are inaudible.
+  float target_gain = std::pow(10.0f, gain_db_ / 20.0f);
+  float step = (target_gain - applied_gain_) / count;
+  float g = applied_gain_;
+  for (int i = 0; i < count; ++i) {
+    g += step;
+    samples[i] *= g;
+  }
+  applied_gain_ = target_gain;
+
+  limiter_.Process(samples, count);
+}
+
+}  // namespace vc
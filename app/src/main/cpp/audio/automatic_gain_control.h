@@ -0,0 +1,57 @@
+#ifndef VCMEDIA_AUDIO_AUTOMATIC_GAIN_CONTROL_H_
+#define VCMEDIA_AUDIO_AUTOMATIC_GAIN_CONTROL_H_
+
+#include "audio/audio_processor.h"
+#include "audio/lookahead_limiter.h"
+
+namespace vc {
+
+// Digital AGC for the capture path. Speech level is only tracked on frames a
+// simple energy gate classifies as speech, so pauses and background noise do
+// not pump the gain up. The gain is slew limited and followed by a lookahead
+// limiter that catches what the slow loop cannot. Expects noise suppression
+// to have run already, since the gate keys off the residual noise floor.
+class AutomaticGainControl : public AudioProcessor {
+ public:
+  struct Config {
+    int sample_rate = 48000;
+    float target_level_dbfs = -18.0f;
+    float max_gain_db = 30.0f;
+    float min_gain_db = -12.0f;
+    // Gain slew limits; decreases are faster so shouting is tamed quickly.
+    float max_increase_db_per_s = 6.0f;
+    float max_decrease_db_per_s = 24.0f;
+    // A frame is speech when it is this far above the noise floor.
+    float speech_margin_db = 9.0f;
+    float min_speech_level_dbfs = -65.0f;
+    float limiter_lookahead_ms = 2.5f;
+    float limiter_ceiling_dbfs = -1.0f;
+    float limiter_release_ms = 80.0f;
+  };
+
+  AutomaticGainControl();
+  explicit AutomaticGainControl(const Config& config);
+
+  void ProcessFrame(float* samples, int count) override;
+
+  float gain_db() const { return gain_db_; }
+  float speech_level_dbfs() const { return speech_level_db_; }
+  float noise_floor_dbfs() const { return noise_floor_db_; }
+  bool speech_active() const { return speech_; }
+  int delay_samples() const { return limiter_.delay_samples(); }
+
+ private:
+  Config config_;
+  LookaheadLimiter limiter_;
+  float gain_db_ = 0.0f;
+  float applied_gain_ = 1.0f;
+  float speech_level_db_;
+  float noise_floor_db_ = -90.0f;
+  bool speech_ = false;
+  bool has_speech_level_ = false;
+  long long frames_processed_ = 0;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_AUTOMATIC_GAIN_CONTROL_H_
@@ -0,0 +1,67 @@
+#include "audio/callback_stats.h"
+
+#include <chrono>
+#include <cstdlib>
+
+namespace vc {
+
+int64_t MonotonicNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void CallbackStats::Reset() {
+  last_start_ns_ = 0;
+  frames_ = 0;
+  intervals_ = 0;
+  playout_underruns_ = 0;
+  capture_underruns_ = 0;
+  jitter_sum_ns_ = 0;
+  jitter_max_ns_ = 0;
+  callback_sum_ns_ = 0;
+  callback_max_ns_ = 0;
+}
+
+void CallbackStats::OnFrameStart(int64_t now_ns) {
+  if (last_start_ns_ != 0) {
+    int64_t jitter = std::llabs(now_ns - last_start_ns_ - period_ns_);
+    jitter_sum_ns_.fetch_add(jitter, std::memory_order_relaxed);
+    if (jitter > jitter_max_ns_.load(std::memory_order_relaxed)) {
+      jitter_max_ns_.store(jitter, std::memory_order_relaxed);
+    }
+    intervals_.fetch_add(1, std::memory_order_relaxed);
+  }
+  last_start_ns_ = now_ns;
+  current_start_ns_ = now_ns;
+}
+
+void CallbackStats::OnFrameEnd(int64_t now_ns) {
+  int64_t duration = now_ns - current_start_ns_;
+  callback_sum_ns_.fetch_add(duration, std::memory_order_relaxed);
+  if (duration > callback_max_ns_.load(std::memory_order_relaxed)) {
+    callback_max_ns_.store(duration, std::memory_order_relaxed);
+  }
+  frames_.fetch_add(1, std::memory_order_release);
+}
+
+AudioDeviceStats CallbackStats::Snapshot() const {
+  AudioDeviceStats s;
+  s.frames = frames_.load(std::memory_order_acquire);
+  s.playout_underruns = playout_underruns_.load(std::memory_order_relaxed);
+  s.capture_underruns = capture_underruns_.load(std::memory_order_relaxed);
+  uint64_t intervals = intervals_.load(std::memory_order_relaxed);
+  if (intervals > 0) {
+    s.mean_jitter_us = jitter_sum_ns_.load(std::memory_order_relaxed) /
+                       1000.0 / intervals;
+  }
+  s.max_jitter_us = jitter_max_ns_.load(std::memory_order_relaxed) / 1000.0;
+  if (s.frames > 0) {
+    s.mean_callback_us = callback_sum_ns_.load(std::memory_order_relaxed) /
+                         1000.0 / s.frames;
+  }
+  s.max_callback_us = callback_max_ns_.load(std::memory_order_relaxed) / 1000.0;
+  return s;
+}
+
+}  // namespace vc
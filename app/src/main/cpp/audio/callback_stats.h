@@ -0,0 +1,47 @@
+#ifndef VCMEDIA_AUDIO_CALLBACK_STATS_H_
+#define VCMEDIA_AUDIO_CALLBACK_STATS_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "audio/audio_device.h"
+
+namespace vc {
+
+int64_t MonotonicNowNs();
+
+// Collects frame timing on the audio thread (single writer, lock free) for
+// AudioDevice::GetStats(), which may be called from any thread.
+class CallbackStats {
+ public:
+  explicit CallbackStats(int64_t period_ns) : period_ns_(period_ns) {}
+
+  void Reset();
+  void OnFrameStart(int64_t now_ns);
+  void OnFrameEnd(int64_t now_ns);
+  void AddPlayoutUnderruns(uint64_t count) {
+    playout_underruns_.fetch_add(count, std::memory_order_relaxed);
+  }
+  void AddCaptureUnderruns(uint64_t count) {
+    capture_underruns_.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  AudioDeviceStats Snapshot() const;
+
+ private:
+  const int64_t period_ns_;
+  int64_t last_start_ns_ = 0;
+  int64_t current_start_ns_ = 0;
+  std::atomic<uint64_t> frames_{0};
+  std::atomic<uint64_t> intervals_{0};
+  std::atomic<uint64_t> playout_underruns_{0};
+  std::atomic<uint64_t> capture_underruns_{0};
+  std::atomic<int64_t> jitter_sum_ns_{0};
+  std::atomic<int64_t> jitter_max_ns_{0};
+  std::atomic<int64_t> callback_sum_ns_{0};
+  std::atomic<int64_t> callback_max_ns_{0};
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_CALLBACK_STATS_H_
@@ -0,0 +1,31 @@
+#ifndef VCMEDIA_AUDIO_CAPTURE_CHAIN_H_
+#define VCMEDIA_AUDIO_CAPTURE_CHAIN_H_
+
+#include "audio/audio_processor.h"
+
+namespace vc {
+
+// Fixed-order capture processing: noise suppression, then gain control.
+// Gain control must come last so it levels the cleaned signal rather than
+// amplifying noise the suppressor would have removed. Stages are not owned
+// and must be set before the audio thread starts.
+class CaptureChain : public AudioProcessor {
+ public:
+  void SetNoiseSuppressor(AudioProcessor* processor) {
+    noise_suppressor_ = processor;
+  }
+  void SetGainControl(AudioProcessor* processor) { gain_control_ = processor; }
+
+  void ProcessFrame(float* samples, int count) override {
+    if (noise_suppressor_) noise_suppressor_->ProcessFrame(samples, count);
+    if (gain_control_) gain_control_->ProcessFrame(samples, count);
+  }
+
+ private:
+  AudioProcessor* noise_suppressor_ = nullptr;
+  AudioProcessor* gain_control_ = nullptr;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_CAPTURE_CHAIN_H_
@@ -0,0 +1,120 @@
+#include "audio/fft.h"
+
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+namespace vc {
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+}  // namespace
+
+RealFft::RealFft(int size)
+    : size_(size),
+      half_(size / 2),
+      bit_reverse_(size / 2),
+      cos_(size / 4 > 0 ? size / 4 : 1),
+      sin_(size / 4 > 0 ? size / 4 : 1),
+      post_cos_(size / 2 + 1),
+      post_sin_(size / 2 + 1),
+      work_re_(size / 2),
+      work_im_(size / 2) {
+  assert(size >= 4 && (size & (size - 1)) == 0);
+  int bits = 0;
+  while ((1 << bits) < half_) ++bits;
+  for (int i = 0; i < half_; ++i) {
+    int r = 0;
+    for (int b = 0; b < bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+    bit_reverse_[i] = r;
+  }
+  for (int k = 0; k < half_ / 2; ++k) {
+    cos_[k] = static_cast<float>(std::cos(2 * kPi * k / half_));
+    sin_[k] = static_cast<float>(std::sin(2 * kPi * k / half_));
+  }
+  for (int k = 0; k <= half_; ++k) {
+    post_cos_[k] = static_cast<float>(std::cos(2 * kPi * k / size_));
+    post_sin_[k] = static_cast<float>(std::sin(2 * kPi * k / size_));
+  }
+}
+
+void RealFft::ComplexFft(float* re, float* im, bool inverse) const {
+  for (int i = 0; i < half_; ++i) {
+    int j = bit_reverse_[i];
+    if (j > i) {
+      std::swap(re[i], re[j]);
+      std::swap(im[i], im[j]);
+    }
+  }
+  const float sign = inverse ? 1.0f : -1.0f;
+  for (int len = 2; len <= half_; len <<= 1) {
+    int step = half_ / len;
+    int h = len / 2;
+    for (int start = 0; start < half_; start += len) {
+      for (int k = 0; k < h; ++k) {
+        float wr = cos_[k * step];
+        float wi = sign * sin_[k * step];
+        int a = start + k;
+        int b = a + h;
+        float tr = re[b] * wr - im[b] * wi;
+        float ti = re[b] * wi + im[b] * wr;
+        re[b] = re[a] - tr;
+        im[b] = im[a] - ti;
+        re[a] += tr;
+        im[a] += ti;
+      }
+    }
+  }
+}
+
+void RealFft::Forward(const float* in, float* re, float* im) {
+  float* zr = work_re_.data();
+  float* zi = work_im_.data();
+  for (int n = 0; n < half_; ++n) {
+    zr[n] = in[2 * n];
+    zi[n] = in[2 * n + 1];
+  }
+  ComplexFft(zr, zi, false);
+
+  for (int k = 0; k <= half_; ++k) {
+    int a = k % half_;
+    int b = (half_ - k) % half_;
+    float ar = zr[a], ai = zi[a];
+    float br = zr[b], bi = -zi[b];
+    float fe_r = 0.5f * (ar + br);
+    float fe_i = 0.5f * (ai + bi);
+    float fo_r = 0.5f * (ai - bi);
+    float fo_i = -0.5f * (ar - br);
+    float c = post_cos_[k];
+    float s = post_sin_[k];
+    re[k] = fe_r + c * fo_r + s * fo_i;
+    im[k] = fe_i + c * fo_i - s * fo_r;
+  }
+}
+
+void RealFft::Inverse(const float* re, const float* im, float* out) {
+  float* zr = work_re_.data();
+  float* zi = work_im_.data();
+  for (int k = 0; k < half_; ++k) {
+    float ar = re[k], ai = im[k];
+    float br = re[half_ - k], bi = -im[half_ - k];
+    float fe_r = 0.5f * (ar + br);
+    float fe_i = 0.5f * (ai + bi);
+    float dr = 0.5f * (ar - br);
+    float di = 0.5f * (ai - bi);
+    float c = post_cos_[k];
+    float s = post_sin_[k];
+    float fo_r = dr * c - di * s;
+    float fo_i = dr * s + di * c;
+    zr[k] = fe_r - fo_i;
+    zi[k] = fe_i + fo_r;
+  }
+  ComplexFft(zr, zi, true);
+  const float scale = 1.0f / half_;
+  for (int n = 0; n < half_; ++n) {
+    out[2 * n] = zr[n] * scale;
+    out[2 * n + 1] = zi[n] * scale;
+  }
+}
+
+}  // namespace vc
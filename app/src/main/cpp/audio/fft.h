@@ -0,0 +1,38 @@
+#ifndef VCMEDIA_AUDIO_FFT_H_
+#define VCMEDIA_AUDIO_FFT_H_
+
+#include <vector>
+
+namespace vc {
+
+// Real-input FFT of a fixed power-of-two size, computed as a half-size complex
+// FFT. Spectra are stored split into real and imaginary arrays of size / 2 + 1
+// bins so that per-bin loops vectorize. Not thread safe: scratch is shared.
+class RealFft {
+ public:
+  explicit RealFft(int size);
+
+  int size() const { return size_; }
+  int bins() const { return size_ / 2 + 1; }
+
+  void Forward(const float* in, float* re, float* im);
+  // Inverse transform including the 1 / size scaling.
+  void Inverse(const float* re, const float* im, float* out);
+
+ private:
+  void ComplexFft(float* re, float* im, bool inverse) const;
+
+  int size_;
+  int half_;
+  std::vector<int> bit_reverse_;
+  std::vector<float> cos_;  // Twiddles for the half-size complex FFT.
+  std::vector<float> sin_;
+  std::vector<float> post_cos_;  // Twiddles for splitting the packed spectrum.
+  std::vector<float> post_sin_;
+  std::vector<float> work_re_;
+  std::vector<float> work_im_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_FFT_H_
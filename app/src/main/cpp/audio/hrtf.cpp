@@ -0,0 +1,111 @@
+#include "audio/hrtf.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace vc {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kHeadRadius = 0.0875;  // Metres.
+constexpr double kSpeedOfSound = 343.0;
+
+// Impulse response of one ear at `incidence` radians from the ear axis
+// (0 = facing the ear), delayed by `delay` samples.
+std::vector<float> EarResponse(int sample_rate, int length, double incidence,
+                               double delay) {
+  // Brown-Duda head shadow: one pole, one zero with a zero that moves with
+  // incidence, discretised with the bilinear transform.
+  constexpr double kAlphaMin = 0.1;
+  constexpr double kThetaMin = 150.0 * kPi / 180.0;
+  double alpha = (1 + kAlphaMin / 2) +
+                 (1 - kAlphaMin / 2) * std::cos(incidence / kThetaMin * kPi);
+  double beta = 2.0 * kSpeedOfSound / kHeadRadius;
+  double k = 2.0 * sample_rate;
+  double b0 = (beta + alpha * k) / (beta + k);
+  double b1 = (beta - alpha * k) / (beta + k);
+  double a1 = (beta - k) / (beta + k);
+
+  // Fractional delay as a short Hann-windowed sinc.
+  std::vector<double> x(length, 0.0);
+  constexpr int kHalfTaps = 8;
+  int center = static_cast<int>(std::floor(delay));
+  for (int n = center - kHalfTaps + 1; n <= center + kHalfTaps; ++n) {
+    if (n < 0 || n >= length) continue;
+    double t = n - delay;
+    double sinc = std::fabs(t) < 1e-9 ? 1.0 : std::sin(kPi * t) / (kPi * t);
+    double window = 0.5 + 0.5 * std::cos(kPi * t / kHalfTaps);
+    x[n] = sinc * window;
+  }
+
+  std::vector<float> h(length);
+  double x1 = 0.0, y1 = 0.0;
+  for (int n = 0; n < length; ++n) {
+    double y = b0 * x[n] + b1 * x1 - a1 * y1;
+    x1 = x[n];
+    y1 = y;
+    h[n] = static_cast<float>(y);
+  }
+  return h;
+}
+
+}  // namespace
+
+HrtfSet HrtfSet::FromImpulseResponses(int sample_rate,
+                                      std::vector<Direction> directions) {
+  HrtfSet set;
+  set.sample_rate_ = sample_rate;
+  set.directions_ = std::move(directions);
+  std::sort(set.directions_.begin(), set.directions_.end(),
+            [](const Direction& a, const Direction& b) {
+              return a.azimuth < b.azimuth;
+            });
+  set.length_ = set.directions_.empty()
+                    ? 0
+                    : static_cast<int>(set.directions_[0].left.size());
+  return set;
+}
+
+HrtfSet HrtfSet::SphericalHead(int sample_rate, int length, float step_deg) {
+  std::vector<Direction> directions;
+  // Keep every response causal: the far ear lags by at most the full ITD.
+  const double base_delay = 8.0;
+  for (float az = -90.0f; az <= 90.0f + 1e-3f; az += step_deg) {
+    double theta = az * kPi / 180.0;
+    double itd = kHeadRadius / kSpeedOfSound *
+                 (std::fabs(theta) + std::sin(std::fabs(theta)));
+    double itd_samples = itd * sample_rate;
+    double near_delay = base_delay;
+    double far_delay = base_delay + itd_samples;
+
+    // Incidence relative to each ear, ears at -90 (left) and +90 (right).
+    double right_incidence = std::fabs(theta - kPi / 2);
+    double left_incidence = std::fabs(theta + kPi / 2);
+
+    Direction d;
+    d.azimuth = az;
+    d.right = EarResponse(sample_rate, length, right_incidence,
+                          az >= 0 ? near_delay : far_delay);
+    d.left = EarResponse(sample_rate, length, left_incidence,
+                         az >= 0 ? far_delay : near_delay);
+    directions.push_back(std::move(d));
+  }
+  return FromImpulseResponses(sample_rate, std::move(directions));
+}
+
+int HrtfSet::NearestIndex(float azimuth) const {
+  int best = 0;
+  float best_distance = 1e9f;
+  for (int i = 0; i < size(); ++i) {
+    float distance = std::fabs(directions_[i].azimuth - azimuth);
+    if (distance < best_distance) {
+      best_distance = distance;
+      best = i;
+    }
+  }
+  return best;
+}
+
+}  // namespace vc
@@ -0,0 +1,43 @@
+#ifndef VCMEDIA_AUDIO_HRTF_H_
+#define VCMEDIA_AUDIO_HRTF_H_
+
+#include <vector>
+
+namespace vc {
+
+// A set of head-related impulse responses sampled on the horizontal plane.
+// Azimuth is in degrees, 0 straight ahead and positive to the listener's
+// right.
+class HrtfSet {
+ public:
+  struct Direction {
+    float azimuth = 0.0f;
+    std::vector<float> left;
+    std::vector<float> right;
+  };
+
+  // Loads measured responses, e.g. converted from a SOFA file. All responses
+  // must have the same length.
+  static HrtfSet FromImpulseResponses(int sample_rate,
+                                      std::vector<Direction> directions);
+
+  // Analytic spherical-head model (Woodworth ITD plus Brown-Duda head
+  // shadow) for azimuths in [-90, 90]. Used when no measured set is bundled.
+  static HrtfSet SphericalHead(int sample_rate, int length, float step_deg);
+
+  int sample_rate() const { return sample_rate_; }
+  int length() const { return length_; }
+  int size() const { return static_cast<int>(directions_.size()); }
+  const Direction& direction(int index) const { return directions_[index]; }
+
+  int NearestIndex(float azimuth) const;
+
+ private:
+  int sample_rate_ = 0;
+  int length_ = 0;
+  std::vector<Direction> directions_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_HRTF_H_
@@ -0,0 +1,57 @@
+#include "audio/lookahead_limiter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vc {
+
+LookaheadLimiter::LookaheadLimiter(int sample_rate, float lookahead_ms,
+                                   float ceiling_dbfs, float release_ms)
+    : length_(std::max(2, static_cast<int>(sample_rate * lookahead_ms / 1000))),
+      ceiling_(std::pow(10.0f, ceiling_dbfs / 20.0f)),
+      release_(1.0f - std::exp(-1000.0f / (release_ms * sample_rate))),
+      delay_(length_, 0.0f),
+      min_value_(length_),
+      min_index_(length_),
+      box_(length_, 1.0f),
+      box_sum_(length_) {}
+
+void LookaheadLimiter::Process(float* samples, int count) {
+  for (int i = 0; i < count; ++i) {
+    float x = samples[i];
+    float magnitude = std::fabs(x);
+    float required = magnitude > ceiling_ ? ceiling_ / magnitude : 1.0f;
+
+    // Sliding minimum of the required gain over the lookahead window.
+    if (min_size_ > 0 && min_index_[min_head_] <= index_ - length_) {
+      min_head_ = (min_head_ + 1) % length_;
+      --min_size_;
+    }
+    while (min_size_ > 0) {
+      int back = (min_head_ + min_size_ - 1) % length_;
+      if (min_value_[back] < required) break;
+      --min_size_;
+    }
+    int slot = (min_head_ + min_size_) % length_;
+    min_value_[slot] = required;
+    min_index_[slot] = index_;
+    ++min_size_;
+    float minimum = min_value_[min_head_];
+    ++index_;
+
+    held_ = std::min(minimum, held_ + (1.0f - held_) * release_);
+
+    box_sum_ += held_ - box_[box_pos_];
+    box_[box_pos_] = held_;
+    box_pos_ = (box_pos_ + 1) % length_;
+    gain_ = static_cast<float>(box_sum_ / length_);
+
+    // Delay of length_ - 1 samples lines each peak up with the bottom of its
+    // gain ramp.
+    delay_[delay_pos_] = x;
+    delay_pos_ = (delay_pos_ + 1) % length_;
+    samples[i] = delay_[delay_pos_] * gain_;
+  }
+}
+
+}  // namespace vc
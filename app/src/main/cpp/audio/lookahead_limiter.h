@@ -0,0 +1,48 @@
+#ifndef VCMEDIA_AUDIO_LOOKAHEAD_LIMITER_H_
+#define VCMEDIA_AUDIO_LOOKAHEAD_LIMITER_H_
+
+#include <vector>
+
+namespace vc {
+
+// Peak limiter that sees `lookahead_ms` ahead so gain reduction is already in
+// place when a peak arrives. The required gain goes through a sliding minimum
+// and then a box filter of the same length, which ramps the gain down
+// smoothly without ever letting a sample exceed the ceiling. Adds
+// `lookahead_ms` of delay. Process() works in place and does not allocate.
+class LookaheadLimiter {
+ public:
+  LookaheadLimiter(int sample_rate, float lookahead_ms, float ceiling_dbfs,
+                   float release_ms);
+
+  void Process(float* samples, int count);
+
+  int delay_samples() const { return length_ - 1; }
+  // Gain applied to the most recent output sample.
+  float gain() const { return gain_; }
+
+ private:
+  int length_;
+  float ceiling_;
+  float release_;
+
+  std::vector<float> delay_;
+  int delay_pos_ = 0;
+
+  // Monotonic deque for the sliding minimum, stored in a ring.
+  std::vector<float> min_value_;
+  std::vector<long long> min_index_;
+  int min_head_ = 0;
+  int min_size_ = 0;
+  long long index_ = 0;
+
+  float held_ = 1.0f;  // Sliding minimum with release applied.
+  std::vector<float> box_;
+  int box_pos_ = 0;
+  double box_sum_ = 0.0;
+  float gain_ = 1.0f;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_LOOKAHEAD_LIMITER_H_
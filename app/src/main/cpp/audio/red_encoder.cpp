@@ -0,0 +1,61 @@
+#include "audio/red_encoder.h"
+
+#include <algorithm>
+
+namespace vc {
+
+RedEncoder::RedEncoder(uint8_t primary_payload_type)
+    : payload_type_(primary_payload_type & 0x7f) {}
+
+void RedEncoder::SetRedundancyDepth(int depth) {
+  depth_ = std::clamp(depth, 0, kRedMaxDepth);
+}
+
+int RedEncoder::Encode(const uint8_t* payload, size_t size,
+                       uint32_t rtp_timestamp, std::vector<uint8_t>* out) {
+  out->clear();
+
+  // Pick redundant frames oldest first, as RFC 2198 orders blocks by age.
+  const Frame* blocks[kRedMaxDepth];
+  int count = 0;
+  for (int age = std::min(depth_, kRedMaxDepth); age >= 1; --age) {
+    const Frame& f =
+        history_[(head_ - age + kRedMaxDepth) % kRedMaxDepth];
+    if (!f.valid || f.data.size() > kRedMaxBlockLength) continue;
+    uint32_t offset = rtp_timestamp - f.timestamp;
+    if (offset == 0 || offset > kRedMaxTimestampOffset) continue;
+    blocks[count++] = &f;
+  }
+
+  size_t total = 1 + size;
+  for (int i = 0; i < count; ++i) total += 4 + blocks[i]->data.size();
+  out->reserve(total);
+
+  for (int i = 0; i < count; ++i) {
+    uint32_t offset = rtp_timestamp - blocks[i]->timestamp;
+    uint32_t length = static_cast<uint32_t>(blocks[i]->data.size());
+    out->push_back(0x80 | payload_type_);
+    out->push_back(static_cast<uint8_t>(offset >> 6));
+    out->push_back(static_cast<uint8_t>(((offset & 0x3f) << 2) | (length >> 8)));
+    out->push_back(static_cast<uint8_t>(length & 0xff));
+  }
+  out->push_back(payload_type_);
+  for (int i = 0; i < count; ++i) {
+    out->insert(out->end(), blocks[i]->data.begin(), blocks[i]->data.end());
+  }
+  out->insert(out->end(), payload, payload + size);
+
+  Frame& slot = history_[head_];
+  slot.timestamp = rtp_timestamp;
+  slot.data.assign(payload, payload + size);
+  slot.valid = true;
+  head_ = (head_ + 1) % kRedMaxDepth;
+  return count;
+}
+
+void RedEncoder::Reset() {
+  for (Frame& f : history_) f.valid = false;
+  head_ = 0;
+}
+
+}  // namespace vc
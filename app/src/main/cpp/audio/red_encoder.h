@@ -0,0 +1,48 @@
+#ifndef VCMEDIA_AUDIO_RED_ENCODER_H_
+#define VCMEDIA_AUDIO_RED_ENCODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vc {
+
+// RFC 2198 limits: 14-bit timestamp offset and 10-bit block length.
+constexpr uint32_t kRedMaxTimestampOffset = (1u << 14) - 1;
+constexpr size_t kRedMaxBlockLength = (1u << 10) - 1;
+constexpr int kRedMaxDepth = 3;
+
+// Wraps each encoded audio frame in a RED payload carrying up to
+// `depth` previous frames as redundant blocks.
+class RedEncoder {
+ public:
+  explicit RedEncoder(uint8_t primary_payload_type);
+
+  void SetRedundancyDepth(int depth);
+  int redundancy_depth() const { return depth_; }
+
+  // Builds the RED payload for `payload` into `out` and remembers the frame
+  // for use as redundancy in later packets. Returns the number of redundant
+  // blocks actually included.
+  int Encode(const uint8_t* payload, size_t size, uint32_t rtp_timestamp,
+             std::vector<uint8_t>* out);
+
+  void Reset();
+
+ private:
+  struct Frame {
+    uint32_t timestamp = 0;
+    std::vector<uint8_t> data;
+    bool valid = false;
+  };
+
+  uint8_t payload_type_;
+  int depth_ = 0;
+  // Ring of the most recent frames, newest at `head_ - 1`.
+  Frame history_[kRedMaxDepth];
+  int head_ = 0;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_RED_ENCODER_H_
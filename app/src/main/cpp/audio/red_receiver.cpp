@@ -0,0 +1,99 @@
+#include "audio/red_receiver.h"
+
+namespace vc {
+
+int ParseRedPayload(const uint8_t* payload, size_t size, uint32_t rtp_timestamp,
+                    RedBlock* blocks, int max_blocks) {
+  size_t pos = 0;
+  int count = 0;
+  size_t data_total = 0;
+
+  // Headers first: 4 bytes per redundant block, 1 byte for the primary.
+  while (true) {
+    if (pos >= size || count >= max_blocks) return -1;
+    uint8_t first = payload[pos];
+    RedBlock& b = blocks[count];
+    b.payload_type = first & 0x7f;
+    if ((first & 0x80) == 0) {
+      b.timestamp = rtp_timestamp;
+      b.redundant = false;
+      pos += 1;
+      ++count;
+      break;
+    }
+    if (pos + 4 > size) return -1;
+    uint32_t offset = (static_cast<uint32_t>(payload[pos + 1]) << 6) |
+                      (payload[pos + 2] >> 2);
+    uint32_t length = (static_cast<uint32_t>(payload[pos + 2] & 0x03) << 8) |
+                      payload[pos + 3];
+    b.timestamp = rtp_timestamp - offset;
+    b.size = length;
+    b.redundant = true;
+    data_total += length;
+    pos += 4;
+    ++count;
+  }
+
+  if (pos + data_total > size) return -1;
+  for (int i = 0; i < count - 1; ++i) {
+    blocks[i].data = payload + pos;
+    pos += blocks[i].size;
+  }
+  blocks[count - 1].data = payload + pos;
+  blocks[count - 1].size = size - pos;
+  return count;
+}
+
+RedReceiver::RedReceiver(uint32_t history_span) : history_span_(history_span) {}
+
+bool RedReceiver::Seen(uint32_t timestamp) const {
+  for (int i = 0; i < history_count_; ++i) {
+    if (history_[i] == timestamp) return true;
+  }
+  return false;
+}
+
+void RedReceiver::Remember(uint32_t timestamp) {
+  history_[history_head_] = timestamp;
+  history_head_ = (history_head_ + 1) % kHistorySize;
+  if (history_count_ < kHistorySize) ++history_count_;
+}
+
+int RedReceiver::OnPacket(const uint8_t* payload, size_t size,
+                          uint32_t rtp_timestamp, RedBlock* out, int max_out) {
+  ++stats_.packets;
+  RedBlock blocks[kMaxBlocksPerPacket];
+  int count = ParseRedPayload(payload, size, rtp_timestamp, blocks,
+                              kMaxBlocksPerPacket);
+  if (count < 0) {
+    ++stats_.malformed;
+    return 0;
+  }
+
+  int written = 0;
+  for (int i = 0; i < count && written < max_out; ++i) {
+    const RedBlock& b = blocks[i];
+    if (has_newest_) {
+      int32_t behind = static_cast<int32_t>(newest_ - b.timestamp);
+      if (behind > 0 && static_cast<uint32_t>(behind) > history_span_) {
+        ++stats_.late_dropped;
+        continue;
+      }
+    }
+    if (Seen(b.timestamp)) {
+      ++stats_.duplicates_dropped;
+      continue;
+    }
+    Remember(b.timestamp);
+    if (!has_newest_ || static_cast<int32_t>(b.timestamp - newest_) > 0) {
+      newest_ = b.timestamp;
+      has_newest_ = true;
+    }
+    out[written++] = b;
+    ++stats_.frames_forwarded;
+    if (b.redundant) ++stats_.frames_recovered;
+  }
+  return written;
+}
+
+}  // namespace vc
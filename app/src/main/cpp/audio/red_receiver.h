@@ -0,0 +1,65 @@
+#ifndef VCMEDIA_AUDIO_RED_RECEIVER_H_
+#define VCMEDIA_AUDIO_RED_RECEIVER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vc {
+
+struct RedBlock {
+  uint8_t payload_type = 0;
+  uint32_t timestamp = 0;
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+  bool redundant = false;
+};
+
+// Splits a RED payload into its blocks. Returns the number of blocks written
+// to `blocks` (oldest first, primary last), or -1 if the payload is malformed.
+int ParseRedPayload(const uint8_t* payload, size_t size, uint32_t rtp_timestamp,
+                    RedBlock* blocks, int max_blocks);
+
+// Receive side of RED: unpacks each packet and forwards only frames that have
+// not been seen yet, so the jitter buffer never sees duplicate timestamps.
+class RedReceiver {
+ public:
+  static constexpr int kMaxBlocksPerPacket = 8;
+
+  struct Stats {
+    uint64_t packets = 0;
+    uint64_t frames_forwarded = 0;
+    uint64_t frames_recovered = 0;  // Forwarded from a redundant block.
+    uint64_t duplicates_dropped = 0;
+    uint64_t late_dropped = 0;
+    uint64_t malformed = 0;
+  };
+
+  // `history_span` is how far back (in RTP ticks) timestamps are remembered;
+  // anything older than that behind the newest frame is treated as too late.
+  explicit RedReceiver(uint32_t history_span);
+
+  // Fills `out` with the frames of this packet that are new, in timestamp
+  // order. Returns the number of frames written.
+  int OnPacket(const uint8_t* payload, size_t size, uint32_t rtp_timestamp,
+               RedBlock* out, int max_out);
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  static constexpr int kHistorySize = 64;
+
+  bool Seen(uint32_t timestamp) const;
+  void Remember(uint32_t timestamp);
+
+  uint32_t history_span_;
+  uint32_t history_[kHistorySize] = {};
+  int history_count_ = 0;
+  int history_head_ = 0;
+  uint32_t newest_ = 0;
+  bool has_newest_ = false;
+  Stats stats_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_RED_RECEIVER_H_
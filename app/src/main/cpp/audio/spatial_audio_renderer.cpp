@@ -0,0 +1,284 @@
+#include "audio/spatial_audio_renderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace vc {
+
+namespace {
+
+// Equal-power pan to the centre for streams that are not spatialized.
+constexpr float kCentreGain = 0.70710678f;
+constexpr float kLevelSmoothing = 0.1f;
+
+void MultiplyAccumulate(const float* __restrict xr, const float* __restrict xi,
+                        const float* __restrict hr, const float* __restrict hi,
+                        float* __restrict yr, float* __restrict yi, int n) {
+  for (int k = 0; k < n; ++k) {
+    yr[k] += xr[k] * hr[k] - xi[k] * hi[k];
+    yi[k] += xr[k] * hi[k] + xi[k] * hr[k];
+  }
+}
+
+}  // namespace
+
+SpatialAudioRenderer::SpatialAudioRenderer(const HrtfSet& hrtf,
+                                           const Config& config)
+    : config_(config),
+      block_size_(config.block_size),
+      bins_(config.block_size + 1),
+      partitions_(std::max(1, (hrtf.length() + config.block_size - 1) /
+                                  config.block_size)),
+      fft_(2 * config.block_size),
+      num_directions_(hrtf.size()),
+      streams_(config.max_streams),
+      scratch_(2 * config.block_size),
+      centre_(config.block_size),
+      output_(2 * config.block_size, 0.0f) {
+  const int b = block_size_;
+  const size_t filter_size =
+      static_cast<size_t>(num_directions_) * 2 * partitions_ * bins_;
+  filter_re_.resize(filter_size);
+  filter_im_.resize(filter_size);
+  for (int d = 0; d < num_directions_; ++d) {
+    const HrtfSet::Direction& dir = hrtf.direction(d);
+    directions_.push_back(dir.azimuth);
+    for (int ear = 0; ear < 2; ++ear) {
+      const std::vector<float>& h = ear == 0 ? dir.left : dir.right;
+      for (int p = 0; p < partitions_; ++p) {
+        std::fill(scratch_.begin(), scratch_.end(), 0.0f);
+        int begin = p * b;
+        int end = std::min(static_cast<int>(h.size()), begin + b);
+        if (end > begin) std::copy(h.begin() + begin, h.begin() + end,
+                                   scratch_.begin());
+        size_t offset = ((static_cast<size_t>(d) * 2 + ear) * partitions_ + p) *
+                        bins_;
+        fft_.Forward(scratch_.data(), &filter_re_[offset], &filter_im_[offset]);
+      }
+    }
+  }
+
+  for (Stream& s : streams_) {
+    s.input.assign(b, 0.0f);
+    s.last.assign(b, 0.0f);
+    s.fdl_re.assign(static_cast<size_t>(partitions_) * bins_, 0.0f);
+    s.fdl_im.assign(static_cast<size_t>(partitions_) * bins_, 0.0f);
+  }
+  for (int ear = 0; ear < 2; ++ear) {
+    acc_re_[ear].resize(bins_);
+    acc_im_[ear].resize(bins_);
+    fade_out_re_[ear].resize(bins_);
+    fade_out_im_[ear].resize(bins_);
+    fade_in_re_[ear].resize(bins_);
+    fade_in_im_[ear].resize(bins_);
+    time_[ear].resize(2 * b);
+  }
+}
+
+int SpatialAudioRenderer::NearestDirection(float azimuth) const {
+  int best = 0;
+  for (int d = 1; d < num_directions_; ++d) {
+    if (std::fabs(directions_[d] - azimuth) <
+        std::fabs(directions_[best] - azimuth)) {
+      best = d;
+    }
+  }
+  return best;
+}
+
+int SpatialAudioRenderer::AddStream(float azimuth) {
+  int spatialized = 0;
+  for (const Stream& s : streams_) spatialized += s.active && s.spatialized;
+  for (size_t id = 0; id < streams_.size(); ++id) {
+    Stream& s = streams_[id];
+    if (s.active) continue;
+    s.active = true;
+    s.spatialized = spatialized < config_.max_spatialized;
+    s.direction = NearestDirection(azimuth);
+    s.previous_direction = -1;
+    s.level = 0.0f;
+    std::fill(s.input.begin(), s.input.end(), 0.0f);
+    std::fill(s.last.begin(), s.last.end(), 0.0f);
+    std::fill(s.fdl_re.begin(), s.fdl_re.end(), 0.0f);
+    std::fill(s.fdl_im.begin(), s.fdl_im.end(), 0.0f);
+    s.fdl_head = 0;
+    return static_cast<int>(id);
+  }
+  return -1;
+}
+
+void SpatialAudioRenderer::RemoveStream(int id) {
+  if (id < 0 || id >= static_cast<int>(streams_.size())) return;
+  streams_[id].active = false;
+  streams_[id].spatialized = false;
+}
+
+void SpatialAudioRenderer::SetAzimuth(int id, float azimuth) {
+  if (id < 0 || id >= static_cast<int>(streams_.size())) return;
+  Stream& s = streams_[id];
+  int direction = NearestDirection(azimuth);
+  if (direction == s.direction) return;
+  if (s.spatialized && s.previous_direction < 0) {
+    s.previous_direction = s.direction;
+  }
+  s.direction = direction;
+}
+
+bool SpatialAudioRenderer::IsSpatialized(int id) const {
+  return id >= 0 && id < static_cast<int>(streams_.size()) &&
+         streams_[id].active && streams_[id].spatialized;
+}
+
+float SpatialAudioRenderer::AzimuthForTile(int column, int columns,
+                                           float spread_deg) {
+  if (columns <= 1) return 0.0f;
+  return -spread_deg + 2.0f * spread_deg * column / (columns - 1);
+}
+
+const float* SpatialAudioRenderer::FilterRe(int direction, int ear,
+                                            int partition) const {
+  return &filter_re_[((static_cast<size_t>(direction) * 2 + ear) *
+                          partitions_ + partition) * bins_];
+}
+
+const float* SpatialAudioRenderer::FilterIm(int direction, int ear,
+                                            int partition) const {
+  return &filter_im_[((static_cast<size_t>(direction) * 2 + ear) *
+                          partitions_ + partition) * bins_];
+}
+
+void SpatialAudioRenderer::Accumulate(const Stream& s, int direction,
+                                      std::vector<float>* acc_re,
+                                      std::vector<float>* acc_im) const {
+  for (int ear = 0; ear < 2; ++ear) {
+    for (int p = 0; p < partitions_; ++p) {
+      size_t slot = static_cast<size_t>(
+          (s.fdl_head - p + partitions_) % partitions_) * bins_;
+      MultiplyAccumulate(&s.fdl_re[slot], &s.fdl_im[slot],
+                         FilterRe(direction, ear, p),
+                         FilterIm(direction, ear, p), acc_re[ear].data(),
+                         acc_im[ear].data(), bins_);
+    }
+  }
+}
+
+void SpatialAudioRenderer::Render(const float* const* inputs, int frames,
+                                  float* out) {
+  int done = 0;
+  while (done < frames) {
+    int chunk = std::min(block_size_ - fill_, frames - done);
+    for (size_t id = 0; id < streams_.size(); ++id) {
+      Stream& s = streams_[id];
+      if (!s.active) continue;
+      float* dst = s.input.data() + fill_;
+      if (inputs[id]) {
+        std::memcpy(dst, inputs[id] + done, chunk * sizeof(float));
+      } else {
+        std::memset(dst, 0, chunk * sizeof(float));
+      }
+    }
+    std::memcpy(out + 2 * done, output_.data() + 2 * fill_,
+                2 * chunk * sizeof(float));
+    fill_ += chunk;
+    done += chunk;
+    if (fill_ == block_size_) {
+      ProcessBlock();
+      fill_ = 0;
+    }
+  }
+}
+
+void SpatialAudioRenderer::ProcessBlock() {
+  const int b = block_size_;
+  for (int ear = 0; ear < 2; ++ear) {
+    std::fill(acc_re_[ear].begin(), acc_re_[ear].end(), 0.0f);
+    std::fill(acc_im_[ear].begin(), acc_im_[ear].end(), 0.0f);
+    std::fill(fade_out_re_[ear].begin(), fade_out_re_[ear].end(), 0.0f);
+    std::fill(fade_out_im_[ear].begin(), fade_out_im_[ear].end(), 0.0f);
+    std::fill(fade_in_re_[ear].begin(), fade_in_re_[ear].end(), 0.0f);
+    std::fill(fade_in_im_[ear].begin(), fade_in_im_[ear].end(), 0.0f);
+  }
+  std::fill(centre_.begin(), centre_.end(), 0.0f);
+
+  bool fading = false;
+  for (Stream& s : streams_) {
+    if (!s.active) continue;
+    float energy = 0.0f;
+    for (int n = 0; n < b; ++n) energy += s.input[n] * s.input[n];
+    s.level += kLevelSmoothing * (energy / b - s.level);
+
+    if (!s.spatialized) {
+      for (int n = 0; n < b; ++n) centre_[n] += kCentreGain * s.input[n];
+      s.last.swap(s.input);
+      continue;
+    }
+
+    std::copy(s.last.begin(), s.last.end(), scratch_.begin());
+    std::copy(s.input.begin(), s.input.end(), scratch_.begin() + b);
+    s.fdl_head = (s.fdl_head + 1) % partitions_;
+    size_t slot = static_cast<size_t>(s.fdl_head) * bins_;
+    fft_.Forward(scratch_.data(), &s.fdl_re[slot], &s.fdl_im[slot]);
+    s.last.swap(s.input);
+
+    if (s.previous_direction >= 0) {
+      Accumulate(s, s.previous_direction, fade_out_re_, fade_out_im_);
+      Accumulate(s, s.direction, fade_in_re_, fade_in_im_);
+      s.previous_direction = -1;
+      fading = true;
+    } else {
+      Accumulate(s, s.direction, acc_re_, acc_im_);
+    }
+  }
+
+  for (int ear = 0; ear < 2; ++ear) {
+    float* y = time_[ear].data();
+    fft_.Inverse(acc_re_[ear].data(), acc_im_[ear].data(), y);
+    if (fading) {
+      const float step = 1.0f / b;
+      fft_.Inverse(fade_out_re_[ear].data(), fade_out_im_[ear].data(),
+                   scratch_.data());
+      for (int n = 0; n < b; ++n) y[b + n] += (1.0f - n * step) * scratch_[b + n];
+      fft_.Inverse(fade_in_re_[ear].data(), fade_in_im_[ear].data(),
+                   scratch_.data());
+      for (int n = 0; n < b; ++n) y[b + n] += n * step * scratch_[b + n];
+    }
+    for (int n = 0; n < b; ++n) output_[2 * n + ear] = y[b + n] + centre_[n];
+  }
+
+  if (++blocks_since_reselect_ >= config_.reselect_interval_blocks) {
+    blocks_since_reselect_ = 0;
+    Reselect();
+  }
+}
+
+void SpatialAudioRenderer::Reselect() {
+  const float margin = std::pow(10.0f, config_.reselect_margin_db / 10.0f);
+  while (true) {
+    Stream* quietest = nullptr;
+    Stream* loudest = nullptr;
+    int spatialized = 0;
+    for (Stream& s : streams_) {
+      if (!s.active) continue;
+      if (s.spatialized) {
+        ++spatialized;
+        if (!quietest || s.level < quietest->level) quietest = &s;
+      } else if (!loudest || s.level > loudest->level) {
+        loudest = &s;
+      }
+    }
+    if (!loudest) return;
+    if (spatialized >= config_.max_spatialized) {
+      if (!quietest || loudest->level <= quietest->level * margin) return;
+      quietest->spatialized = false;
+      quietest->previous_direction = -1;
+    }
+    loudest->spatialized = true;
+    loudest->previous_direction = -1;
+    std::fill(loudest->fdl_re.begin(), loudest->fdl_re.end(), 0.0f);
+    std::fill(loudest->fdl_im.begin(), loudest->fdl_im.end(), 0.0f);
+    loudest->fdl_head = 0;
+  }
+}
+
+}  // namespace vc
@@ -0,0 +1,96 @@
+#ifndef VCMEDIA_AUDIO_SPATIAL_AUDIO_RENDERER_H_
+#define VCMEDIA_AUDIO_SPATIAL_AUDIO_RENDERER_H_
+
+#include <vector>
+
+#include "audio/fft.h"
+#include "audio/hrtf.h"
+
+namespace vc {
+
+// Places each remote voice at its gallery tile by convolving it with the HRTF
+// for that direction (uniformly partitioned overlap-save convolution).
+//
+// FFT work is shared: each stream is transformed once and the result feeds
+// both ears, and all streams are accumulated in the frequency domain so there
+// is a single inverse FFT per ear per block. Only the loudest
+// `max_spatialized` streams are convolved; the rest are mixed to the centre.
+// Render() does not allocate.
+class SpatialAudioRenderer {
+ public:
+  struct Config {
+    int block_size = 128;
+    int max_streams = 32;
+    int max_spatialized = 4;
+    // A quieter spatialized stream is only displaced by one this much louder.
+    float reselect_margin_db = 3.0f;
+    int reselect_interval_blocks = 25;
+  };
+
+  SpatialAudioRenderer(const HrtfSet& hrtf, const Config& config);
+
+  // Returns the stream id, or -1 if `max_streams` are already active.
+  int AddStream(float azimuth);
+  void RemoveStream(int id);
+  void SetAzimuth(int id, float azimuth);
+  bool IsSpatialized(int id) const;
+
+  // `inputs` is indexed by stream id and holds `frames` mono samples per
+  // active stream (nullptr for silence). `out` receives `frames` interleaved
+  // stereo samples, delayed by latency_samples().
+  void Render(const float* const* inputs, int frames, float* out);
+
+  int latency_samples() const { return block_size_; }
+
+  // Azimuth for a tile in `column` of a gallery row `columns` wide, spreading
+  // the row over +/- `spread_deg`.
+  static float AzimuthForTile(int column, int columns, float spread_deg);
+
+ private:
+  struct Stream {
+    bool active = false;
+    bool spatialized = false;
+    int direction = 0;
+    int previous_direction = -1;  // Set while crossfading to `direction`.
+    float level = 0.0f;
+    std::vector<float> input;      // Current block.
+    std::vector<float> last;       // Previous block, for overlap-save.
+    std::vector<float> fdl_re;     // Frequency-domain delay line,
+    std::vector<float> fdl_im;     // `partitions_` spectra.
+    int fdl_head = 0;
+  };
+
+  void ProcessBlock();
+  void Reselect();
+  void Accumulate(const Stream& s, int direction, std::vector<float>* acc_re,
+                  std::vector<float>* acc_im) const;
+  int NearestDirection(float azimuth) const;
+  const float* FilterRe(int direction, int ear, int partition) const;
+  const float* FilterIm(int direction, int ear, int partition) const;
+
+  Config config_;
+  int block_size_;
+  int bins_;
+  int partitions_;
+  RealFft fft_;
+  int num_directions_;
+  std::vector<float> directions_;
+  std::vector<float> filter_re_;
+  std::vector<float> filter_im_;
+  std::vector<Stream> streams_;
+
+  // Per-ear accumulators: steady, fading out and fading in.
+  std::vector<float> acc_re_[2], acc_im_[2];
+  std::vector<float> fade_out_re_[2], fade_out_im_[2];
+  std::vector<float> fade_in_re_[2], fade_in_im_[2];
+  std::vector<float> time_[2];
+  std::vector<float> scratch_;
+  std::vector<float> centre_;
+  std::vector<float> output_;  // Interleaved stereo of the last block.
+  int fill_ = 0;
+  int blocks_since_reselect_ = 0;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_SPATIAL_AUDIO_RENDERER_H_
@@ -0,0 +1,165 @@
+#include "audio/wav_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace vc {
+
+namespace {
+
+uint32_t ReadU32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t ReadU16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+
+void PutU32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+void PutU16(uint8_t* p, uint16_t v) {
+  p[0] = static_cast<uint8_t>(v);
+  p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+constexpr uint16_t kFormatPcm = 1;
+constexpr uint16_t kFormatFloat = 3;
+constexpr uint16_t kFormatExtensible = 0xfffe;
+
+}  // namespace
+
+WavReader::~WavReader() {
+  if (file_) std::fclose(file_);
+}
+
+bool WavReader::Open(const std::string& path) {
+  if (file_) std::fclose(file_);
+  frames_ = 0;
+  position_ = 0;
+  file_ = std::fopen(path.c_str(), "rb");
+  if (!file_) return false;
+  uint8_t riff[12];
+  if (std::fread(riff, 1, 12, file_) != 12 || std::memcmp(riff, "RIFF", 4) != 0 ||
+      std::memcmp(riff + 8, "WAVE", 4) != 0) {
+    return false;
+  }
+
+  bool have_format = false;
+  uint8_t header[8];
+  while (std::fread(header, 1, 8, file_) == 8) {
+    uint32_t size = ReadU32(header + 4);
+    if (std::memcmp(header, "fmt ", 4) == 0) {
+      uint8_t fmt[40] = {};
+      size_t n = std::min<size_t>(size, sizeof(fmt));
+      if (std::fread(fmt, 1, n, file_) != n) return false;
+      // Chunks are padded to an even size.
+      if (size + (size & 1) > n) std::fseek(file_, size + (size & 1) - n, SEEK_CUR);
+      uint16_t format = ReadU16(fmt);
+      if (format == kFormatExtensible && n >= 26) format = ReadU16(fmt + 24);
+      channels_ = ReadU16(fmt + 2);
+      sample_rate_ = static_cast<int>(ReadU32(fmt + 4));
+      bits_ = ReadU16(fmt + 14);
+      is_float_ = format == kFormatFloat;
+      if (!((format == kFormatPcm && bits_ == 16) ||
+            (format == kFormatFloat && bits_ == 32)) ||
+          channels_ <= 0) {
+        return false;
+      }
+      have_format = true;
+    } else if (std::memcmp(header, "data", 4) == 0) {
+      if (!have_format) return false;
+      data_offset_ = std::ftell(file_);
+      frames_ = size / (channels_ * (bits_ / 8));
+      position_ = 0;
+      return true;
+    } else {
+      std::fseek(file_, size + (size & 1), SEEK_CUR);
+    }
+  }
+  return false;
+}
+
+int WavReader::ReadMono(float* out, int frames) {
+  if (!file_) return 0;
+  int64_t available = frames_ - position_;
+  int n = static_cast<int>(std::min<int64_t>(frames, available));
+  if (n <= 0) return 0;
+  const int bytes_per_sample = bits_ / 8;
+  buffer_.resize(static_cast<size_t>(n) * channels_ * bytes_per_sample);
+  n = static_cast<int>(std::fread(buffer_.data(), channels_ * bytes_per_sample,
+                                  n, file_));
+  const float scale = 1.0f / channels_;
+  for (int i = 0; i < n; ++i) {
+    float sum = 0.0f;
+    for (int c = 0; c < channels_; ++c) {
+      const uint8_t* p =
+          buffer_.data() + (static_cast<size_t>(i) * channels_ + c) * bytes_per_sample;
+      if (is_float_) {
+        float v;
+        std::memcpy(&v, p, sizeof(v));
+        sum += v;
+      } else {
+        sum += static_cast<int16_t>(ReadU16(p)) / 32768.0f;
+      }
+    }
+    out[i] = sum * scale;
+  }
+  position_ += n;
+  return n;
+}
+
+void WavReader::Rewind() {
+  if (!file_) return;
+  std::fseek(file_, data_offset_, SEEK_SET);
+  position_ = 0;
+}
+
+WavWriter::~WavWriter() { Close(); }
+
+bool WavWriter::Open(const std::string& path, int sample_rate, int channels) {
+  Close();
+  file_ = std::fopen(path.c_str(), "wb");
+  if (!file_) return false;
+  sample_rate_ = sample_rate;
+  channels_ = channels;
+  frames_ = 0;
+  uint8_t header[44] = {};
+  return std::fwrite(header, 1, sizeof(header), file_) == sizeof(header);
+}
+
+void WavWriter::Write(const float* interleaved, int frames) {
+  if (!file_ || frames <= 0) return;
+  size_t n = static_cast<size_t>(frames) * channels_;
+  buffer_.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    float v = std::clamp(interleaved[i], -1.0f, 1.0f);
+    buffer_[i] = static_cast<int16_t>(std::lrint(v * 32767.0f));
+  }
+  std::fwrite(buffer_.data(), sizeof(int16_t), n, file_);
+  frames_ += frames;
+}
+
+void WavWriter::Close() {
+  if (!file_) return;
+  uint32_t data_bytes = static_cast<uint32_t>(frames_ * channels_ * 2);
+  uint8_t h[44];
+  std::memcpy(h, "RIFF", 4);
+  PutU32(h + 4, 36 + data_bytes);
+  std::memcpy(h + 8, "WAVEfmt ", 8);
+  PutU32(h + 16, 16);
+  PutU16(h + 20, kFormatPcm);
+  PutU16(h + 22, static_cast<uint16_t>(channels_));
+  PutU32(h + 24, static_cast<uint32_t>(sample_rate_));
+  PutU32(h + 28, static_cast<uint32_t>(sample_rate_ * channels_ * 2));
+  PutU16(h + 32, static_cast<uint16_t>(channels_ * 2));
+  PutU16(h + 34, 16);
+  std::memcpy(h + 36, "data", 4);
+  PutU32(h + 40, data_bytes);
+  std::fseek(file_, 0, SEEK_SET);
+  std::fwrite(h, 1, sizeof(h), file_);
+  std::fclose(file_);
+  file_ = nullptr;
+}
+
+}  // namespace vc
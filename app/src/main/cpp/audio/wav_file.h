@@ -0,0 +1,65 @@
+#ifndef VCMEDIA_AUDIO_WAV_FILE_H_
+#define VCMEDIA_AUDIO_WAV_FILE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace vc {
+
+// Reads 16-bit PCM or 32-bit float WAV files as float samples.
+class WavReader {
+ public:
+  WavReader() = default;
+  ~WavReader();
+  WavReader(const WavReader&) = delete;
+  WavReader& operator=(const WavReader&) = delete;
+
+  // Closes any file already open first.
+  bool Open(const std::string& path);
+  int sample_rate() const { return sample_rate_; }
+  int channels() const { return channels_; }
+  int64_t frames() const { return frames_; }
+
+  // Reads up to `frames` frames downmixed to mono. Returns frames read.
+  int ReadMono(float* out, int frames);
+  void Rewind();
+
+ private:
+  std::FILE* file_ = nullptr;
+  int sample_rate_ = 0;
+  int channels_ = 0;
+  int bits_ = 0;
+  bool is_float_ = false;
+  long data_offset_ = 0;
+  int64_t frames_ = 0;
+  int64_t position_ = 0;
+  std::vector<uint8_t> buffer_;
+};
+
+// Writes interleaved float samples as a 16-bit PCM WAV file.
+class WavWriter {
+ public:
+  WavWriter() = default;
+  ~WavWriter();
+  WavWriter(const WavWriter&) = delete;
+  WavWriter& operator=(const WavWriter&) = delete;
+
+  // Closes (and finalises) any file already open first.
+  bool Open(const std::string& path, int sample_rate, int channels);
+  void Write(const float* interleaved, int frames);
+  // Patches the header sizes; also done by the destructor.
+  void Close();
+
+ private:
+  std::FILE* file_ = nullptr;
+  int sample_rate_ = 0;
+  int channels_ = 0;
+  int64_t frames_ = 0;
+  std::vector<int16_t> buffer_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_AUDIO_WAV_FILE_H_
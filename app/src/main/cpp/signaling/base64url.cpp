@@ -0,0 +1,73 @@
+#include "signaling/base64url.h"
+
+namespace vc {
+
+namespace {
+
+constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+int DecodeChar(char c) {
+  if (c >= 'A' && c <= 'Z') return c - 'A';
+  if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+  if (c >= '0' && c <= '9') return c - '0' + 52;
+  if (c == '-') return 62;
+  if (c == '_') return 63;
+  return -1;
+}
+
+}  // namespace
+
+std::string Base64UrlEncode(const void* data, size_t size) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  std::string out;
+  out.reserve((size * 4 + 2) / 3);
+  size_t i = 0;
+  for (; i + 3 <= size; i += 3) {
+    const uint32_t v = p[i] << 16 | p[i + 1] << 8 | p[i + 2];
+    out += kAlphabet[v >> 18];
+    out += kAlphabet[(v >> 12) & 63];
+    out += kAlphabet[(v >> 6) & 63];
+    out += kAlphabet[v & 63];
+  }
+  if (size - i == 1) {
+    const uint32_t v = p[i] << 16;
+    out += kAlphabet[v >> 18];
+    out += kAlphabet[(v >> 12) & 63];
+  } else if (size - i == 2) {
+    const uint32_t v = p[i] << 16 | p[i + 1] << 8;
+    out += kAlphabet[v >> 18];
+    out += kAlphabet[(v >> 12) & 63];
+    out += kAlphabet[(v >> 6) & 63];
+  }
+  return out;
+}
+
+bool Base64UrlDecode(const char* text, size_t size, std::string* out) {
+  while (size > 0 && text[size - 1] == '=') --size;
+  if (size % 4 == 1) return false;
+  out->clear();
+  out->reserve(size * 3 / 4);
+  uint32_t bits = 0;
+  int count = 0;
+  for (size_t i = 0; i < size; ++i) {
+    const int v = DecodeChar(text[i]);
+    if (v < 0) return false;
+    bits = bits << 6 | static_cast<uint32_t>(v);
+    if (++count == 4) {
+      out->push_back(static_cast<char>(bits >> 16));
+      out->push_back(static_cast<char>(bits >> 8));
+      out->push_back(static_cast<char>(bits));
+      bits = 0;
+      count = 0;
+    }
+  }
+  if (count == 2) {
+    out->push_back(static_cast<char>(bits >> 4));
+  } else if (count == 3) {
+    out->push_back(static_cast<char>(bits >> 10));
+    out->push_back(static_cast<char>(bits >> 2));
+  }
+  return true;
+}
+
+}  // namespace vc
@@ -0,0 +1,25 @@
+#ifndef VCMEDIA_SIGNALING_BASE64URL_H_
+#define VCMEDIA_SIGNALING_BASE64URL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vc {
+
+// RFC 4648 section 5 alphabet without padding, as used by JWTs and JWKs.
+std::string Base64UrlEncode(const void* data, size_t size);
+inline std::string Base64UrlEncode(const std::string& data) {
+  return Base64UrlEncode(data.data(), data.size());
+}
+
+// Decodes `size` characters at `text`; trailing '=' padding is accepted.
+// Returns false on any other character or an impossible length.
+bool Base64UrlDecode(const char* text, size_t size, std::string* out);
+inline bool Base64UrlDecode(const std::string& text, std::string* out) {
+  return Base64UrlDecode(text.data(), text.size(), out);
+}
+
+}  // namespace vc
+
+#endif  // VCMEDIA_SIGNALING_BASE64URL_H_
@@ -0,0 +1,268 @@
+#include "signaling/json.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace vc {
+
+namespace {
+
+constexpr int kMaxDepth = 32;
+
+void AppendUtf8(uint32_t cp, std::string* out) {
+  if (cp < 0x80) {
+    out->push_back(static_cast<char>(cp));
+  } else if (cp < 0x800) {
+    out->push_back(static_cast<char>(0xc0 | cp >> 6));
+    out->push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  } else if (cp < 0x10000) {
+    out->push_back(static_cast<char>(0xe0 | cp >> 12));
+    out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  } else {
+    out->push_back(static_cast<char>(0xf0 | cp >> 18));
+    out->push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  }
+}
+
+}  // namespace
+
+class JsonReader {
+ public:
+  JsonReader(const char* text, size_t size) : p_(text), end_(text + size) {}
+
+  bool ReadDocument(JsonValue* out) {
+    if (!ReadValue(out, 0)) return false;
+    SkipSpace();
+    return p_ == end_;
+  }
+
+ private:
+  void SkipSpace() {
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) ++p_;
+  }
+
+  bool Literal(const char* word) {
+    const size_t len = std::strlen(word);
+    if (static_cast<size_t>(end_ - p_) < len || std::memcmp(p_, word, len) != 0) return false;
+    p_ += len;
+    return true;
+  }
+
+  bool ReadValue(JsonValue* out, int depth) {
+    if (depth > kMaxDepth) return false;
+    SkipSpace();
+    if (p_ == end_) return false;
+    switch (*p_) {
+      case '{':
+        return ReadObject(out, depth);
+      case '[':
+        return ReadArray(out, depth);
+      case '"':
+        out->type_ = JsonValue::Type::kString;
+        return ReadString(&out->string_);
+      case 't':
+        out->type_ = JsonValue::Type::kBool;
+        out->bool_ = true;
+        return Literal("true");
+      case 'f':
+        out->type_ = JsonValue::Type::kBool;
+        out->bool_ = false;
+        return Literal("false");
+      case 'n':
+        out->type_ = JsonValue::Type::kNull;
+        return Literal("null");
+      default:
+        return ReadNumber(out);
+    }
+  }
+
+  bool ReadObject(JsonValue* out, int depth) {
+    out->type_ = JsonValue::Type::kObject;
+    ++p_;
+    SkipSpace();
+    if (p_ < end_ && *p_ == '}') {
+      ++p_;
+      return true;
+    }
+    while (true) {
+      SkipSpace();
+      if (p_ == end_ || *p_ != '"') return false;
+      out->members_.emplace_back();
+      auto& member = out->members_.back();
+      if (!ReadString(&member.first)) return false;
+      SkipSpace();
+      if (p_ == end_ || *p_++ != ':') return false;
+      if (!ReadValue(&member.second, depth + 1)) return false;
+      SkipSpace();
+      if (p_ == end_) return false;
+      if (*p_ == '}') {
+        ++p_;
+        return true;
+      }
+      if (*p_++ != ',') return false;
+    }
+  }
+
+  bool ReadArray(JsonValue* out, int depth) {
+    out->type_ = JsonValue::Type::kArray;
+    ++p_;
+    SkipSpace();
+    if (p_ < end_ && *p_ == ']') {
+      ++p_;
+      return true;
+    }
+    while (true) {
+      out->array_.emplace_back();
+      if (!ReadValue(&out->array_.back(), depth + 1)) return false;
+      SkipSpace();
+      if (p_ == end_) return false;
+      if (*p_ == ']') {
+        ++p_;
+        return true;
+      }
+      if (*p_++ != ',') return false;
+    }
+  }
+
+  bool ReadHex4(uint32_t* out) {
+    if (end_ - p_ < 4) return false;
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) {
+      const char c = *p_++;
+      v <<= 4;
+      if (c >= '0' && c <= '9') {
+        v |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        v |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        v |= c - 'A' + 10;
+      } else {
+        return false;
+      }
+    }
+    *out = v;
+    return true;
+  }
+
+  bool ReadString(std::string* out) {
+    ++p_;
+    // Fast path: copy runs without escapes in one go.
+    while (p_ < end_) {
+      const char* run = p_;
+      while (p_ < end_ && *p_ != '"' && *p_ != '\\' &&
+             static_cast<unsigned char>(*p_) >= 0x20) {
+        ++p_;
+      }
+      out->append(run, p_ - run);
+      if (p_ == end_ || static_cast<unsigned char>(*p_) < 0x20) return false;
+      if (*p_ == '"') {
+        ++p_;
+        return true;
+      }
+      if (++p_ == end_) return false;
+      const char escape = *p_++;
+      switch (escape) {
+        case '"':
+        case '\\':
+        case '/':
+          out->push_back(escape);
+          break;
+        case 'b':
+          out->push_back('\b');
+          break;
+        case 'f':
+          out->push_back('\f');
+          break;
+        case 'n':
+          out->push_back('\n');
+          break;
+        case 'r':
+          out->push_back('\r');
+          break;
+        case 't':
+          out->push_back('\t');
+          break;
+        case 'u': {
+          uint32_t cp;
+          if (!ReadHex4(&cp)) return false;
+          if (cp >= 0xd800 && cp < 0xdc00) {
+            uint32_t low;
+            if (end_ - p_ < 2 || p_[0] != '\\' || p_[1] != 'u') return false;
+            p_ += 2;
+            if (!ReadHex4(&low) || low < 0xdc00 || low >= 0xe000) return false;
+            cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+          } else if (cp >= 0xdc00 && cp < 0xe000) {
+            return false;
+          }
+          AppendUtf8(cp, out);
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+    return false;
+  }
+
+  bool ReadNumber(JsonValue* out) {
+    const char* start = p_;
+    if (p_ < end_ && *p_ == '-') ++p_;
+    if (p_ == end_ || *p_ < '0' || *p_ > '9') return false;
+    if (*p_ == '0') {
+      ++p_;
+    } else {
+      while (p_ < end_ && *p_ >= '0' && *p_ <= '9') ++p_;
+    }
+    if (p_ < end_ && *p_ == '.') {
+      ++p_;
+      if (p_ == end_ || *p_ < '0' || *p_ > '9') return false;
+      while (p_ < end_ && *p_ >= '0' && *p_ <= '9') ++p_;
+    }
+    if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+      ++p_;
+      if (p_ < end_ && (*p_ == '+' || *p_ == '-')) ++p_;
+      if (p_ == end_ || *p_ < '0' || *p_ > '9') return false;
+      while (p_ < end_ && *p_ >= '0' && *p_ <= '9') ++p_;
+    }
+    // strtod needs a terminated copy; numbers here are short.
+    const std::string digits(start, p_ - start);
+    out->type_ = JsonValue::Type::kNumber;
+    out->number_ = std::strtod(digits.c_str(), nullptr);
+    return true;
+  }
+
+  const char* p_;
+  const char* const end_;
+};
+
+bool JsonValue::Parse(const char* text, size_t size, JsonValue* out) {
+  *out = JsonValue();
+  return JsonReader(text, size).ReadDocument(out);
+}
+
+const JsonValue* JsonValue::Find(const char* key) const {
+  for (const auto& member : members_) {
+    if (member.first == key) return &member.second;
+  }
+  return nullptr;
+}
+
+const std::string* JsonValue::FindString(const char* key) const {
+  const JsonValue* v = Find(key);
+  return v && v->is_string() ? &v->string_ : nullptr;
+}
+
+bool JsonValue::FindInt(const char* key, int64_t* out) const {
+  const JsonValue* v = Find(key);
+  if (!v || !v->is_number()) return false;
+  const double d = v->number_;
+  if (d != std::floor(d) || std::fabs(d) > 9007199254740992.0) return false;
+  *out = static_cast<int64_t>(d);
+  return true;
+}
+
+}  // namespace vc
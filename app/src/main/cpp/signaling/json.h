@@ -0,0 +1,58 @@
+#ifndef VCMEDIA_SIGNALING_JSON_H_
+#define VCMEDIA_SIGNALING_JSON_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vc {
+
+// Just enough JSON for JWT headers, claims and JWKS documents: a strict
+// RFC 8259 reader into a small tree. Objects keep their members in order and
+// lookups are linear, which is faster than hashing at the sizes involved.
+class JsonValue {
+ public:
+  enum class Type { kNull, kBool, kNumber, kString, kArray, kObject };
+
+  // Returns false on malformed input, trailing garbage or nesting deeper
+  // than 32 levels.
+  static bool Parse(const char* text, size_t size, JsonValue* out);
+  static bool Parse(const std::string& text, JsonValue* out) {
+    return Parse(text.data(), text.size(), out);
+  }
+
+  Type type() const { return type_; }
+  bool is_string() const { return type_ == Type::kString; }
+  bool is_number() const { return type_ == Type::kNumber; }
+  bool is_object() const { return type_ == Type::kObject; }
+  bool is_array() const { return type_ == Type::kArray; }
+
+  bool bool_value() const { return bool_; }
+  double number() const { return number_; }
+  const std::string& string() const { return string_; }
+  const std::vector<JsonValue>& array() const { return array_; }
+  const std::vector<std::pair<std::string, JsonValue>>& members() const { return members_; }
+
+  // Member `key` of an object, or nullptr.
+  const JsonValue* Find(const char* key) const;
+  // Member `key` if it is a string, else nullptr.
+  const std::string* FindString(const char* key) const;
+  // Member `key` if it is an integral number, written to `out`.
+  bool FindInt(const char* key, int64_t* out) const;
+
+ private:
+  friend class JsonReader;
+
+  Type type_ = Type::kNull;
+  bool bool_ = false;
+  double number_ = 0;
+  std::string string_;
+  std::vector<JsonValue> array_;
+  std::vector<std::pair<std::string, JsonValue>> members_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_SIGNALING_JSON_H_
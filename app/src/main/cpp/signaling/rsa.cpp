@@ -0,0 +1,185 @@
+#include "signaling/rsa.h"
+
+#include <cstring>
+
+namespace vc {
+
+namespace {
+
+// 8192-bit moduli; JWKS keys in practice are 2048.
+constexpr size_t kMaxLimbs = 256;
+
+// DER prefix of the DigestInfo for SHA-256 (RFC 8017 section 9.2, note 1).
+constexpr uint8_t kSha256DigestInfo[] = {0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60,
+                                         0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02,
+                                         0x01, 0x05, 0x00, 0x04, 0x20};
+
+// a >= b over `count` limbs, least significant first.
+bool GreaterOrEqual(const uint32_t* a, const uint32_t* b, size_t count) {
+  for (size_t i = count; i-- > 0;) {
+    if (a[i] != b[i]) return a[i] > b[i];
+  }
+  return true;
+}
+
+void SubtractInPlace(uint32_t* a, const uint32_t* b, size_t count) {
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const uint64_t d = static_cast<uint64_t>(a[i]) - b[i] - borrow;
+    a[i] = static_cast<uint32_t>(d);
+    borrow = (d >> 32) & 1;
+  }
+}
+
+}  // namespace
+
+RsaModulus::RsaModulus(const uint8_t* n, size_t size) {
+  while (size > 0 && *n == 0) {
+    ++n;
+    --size;
+  }
+  if (size < 64 || size > kMaxLimbs * 4 || (n[size - 1] & 1) == 0) return;
+  size_bytes_ = size;
+  const size_t count = (size + 3) / 4;
+  Limbs limbs(count, 0);
+  for (size_t i = 0; i < size; ++i) {
+    limbs[i / 4] |= static_cast<uint32_t>(n[size - 1 - i]) << (8 * (i % 4));
+  }
+
+  // Newton iteration for n0^-1 mod 2^32; each step doubles the correct bits.
+  uint32_t inv = 1;
+  for (int i = 0; i < 5; ++i) inv *= 2 - limbs[0] * inv;
+  n0_inv_ = ~inv + 1;
+
+  // R^2 mod n, R = 2^(32 * count): start from 1 and double 2 * 32 * count
+  // times, reducing as we go.
+  Limbs r(count + 1, 0);
+  r[0] = 1;
+  for (size_t bit = 0; bit < 64 * count; ++bit) {
+    uint32_t carry = 0;
+    for (size_t i = 0; i <= count; ++i) {
+      const uint32_t next = r[i] >> 31;
+      r[i] = r[i] << 1 | carry;
+      carry = next;
+    }
+    if (r[count] != 0 || GreaterOrEqual(r.data(), limbs.data(), count)) {
+      SubtractInPlace(r.data(), limbs.data(), count);
+      r[count] = 0;
+    }
+  }
+  r.resize(count);
+  r_squared_ = std::move(r);
+  limbs_ = std::move(limbs);
+}
+
+void RsaModulus::MontMul(const uint32_t* a, const uint32_t* b, uint32_t* out) const {
+  const size_t count = limbs_.size();
+  const uint32_t* n = limbs_.data();
+  // t has two extra limbs for the running carry.
+  uint32_t t[kMaxLimbs + 2];
+  std::memset(t, 0, (count + 2) * sizeof(uint32_t));
+  for (size_t i = 0; i < count; ++i) {
+    uint64_t carry = 0;
+    for (size_t j = 0; j < count; ++j) {
+      const uint64_t v = static_cast<uint64_t>(a[j]) * b[i] + t[j] + carry;
+      t[j] = static_cast<uint32_t>(v);
+      carry = v >> 32;
+    }
+    uint64_t v = static_cast<uint64_t>(t[count]) + carry;
+    t[count] = static_cast<uint32_t>(v);
+    t[count + 1] = static_cast<uint32_t>(v >> 32);
+
+    const uint32_t m = t[0] * n0_inv_;
+    v = static_cast<uint64_t>(m) * n[0] + t[0];
+    carry = v >> 32;
+    for (size_t j = 1; j < count; ++j) {
+      v = static_cast<uint64_t>(m) * n[j] + t[j] + carry;
+      t[j - 1] = static_cast<uint32_t>(v);
+      carry = v >> 32;
+    }
+    v = static_cast<uint64_t>(t[count]) + carry;
+    t[count - 1] = static_cast<uint32_t>(v);
+    t[count] = t[count + 1] + static_cast<uint32_t>(v >> 32);
+  }
+  if (t[count] != 0 || GreaterOrEqual(t, n, count)) SubtractInPlace(t, n, count);
+  std::memcpy(out, t, count * sizeof(uint32_t));
+}
+
+bool RsaModulus::FromBytes(const uint8_t* bytes, size_t size, Limbs* out) const {
+  while (size > 0 && *bytes == 0) {
+    ++bytes;
+    --size;
+  }
+  const size_t count = limbs_.size();
+  if (size > count * 4) return false;
+  out->assign(count, 0);
+  for (size_t i = 0; i < size; ++i) {
+    (*out)[i / 4] |= static_cast<uint32_t>(bytes[size - 1 - i]) << (8 * (i % 4));
+  }
+  return !GreaterOrEqual(out->data(), limbs_.data(), count);
+}
+
+bool RsaModulus::ModExp(const uint8_t* base, size_t base_size, const uint8_t* exponent,
+                        size_t exponent_size, std::vector<uint8_t>* out) const {
+  if (!valid()) return false;
+  const size_t count = limbs_.size();
+  Limbs x;
+  if (!FromBytes(base, base_size, &x)) return false;
+
+  // To Montgomery form, then left-to-right square and multiply.
+  Limbs base_mont(count), acc(count);
+  MontMul(x.data(), r_squared_.data(), base_mont.data());
+  bool started = false;
+  for (size_t i = 0; i < exponent_size; ++i) {
+    for (int bit = 7; bit >= 0; --bit) {
+      if (started) MontMul(acc.data(), acc.data(), acc.data());
+      if ((exponent[i] >> bit) & 1) {
+        if (started) {
+          MontMul(acc.data(), base_mont.data(), acc.data());
+        } else {
+          acc = base_mont;
+          started = true;
+        }
+      }
+    }
+  }
+  if (!started) {
+    // x^0 = 1.
+    x.assign(count, 0);
+    x[0] = 1;
+  } else {
+    // Out of Montgomery form: multiply by plain 1.
+    Limbs one(count, 0);
+    one[0] = 1;
+    MontMul(acc.data(), one.data(), x.data());
+  }
+
+  out->assign(size_bytes_, 0);
+  for (size_t i = 0; i < size_bytes_; ++i) {
+    (*out)[size_bytes_ - 1 - i] = static_cast<uint8_t>(x[i / 4] >> (8 * (i % 4)));
+  }
+  return true;
+}
+
+bool VerifyRs256(const RsaPublicKey& key, const Sha256Digest& digest,
+                 const uint8_t* signature, size_t signature_size) {
+  const size_t k = key.modulus.size_bytes();
+  if (!key.modulus.valid() || signature_size != k) return false;
+  std::vector<uint8_t> em;
+  if (!key.modulus.ModExp(signature, signature_size, key.exponent.data(),
+                          key.exponent.size(), &em)) {
+    return false;
+  }
+  // EM = 00 01 FF..FF 00 || DigestInfo || digest.
+  const size_t t_len = sizeof(kSha256DigestInfo) + digest.size();
+  if (k < t_len + 11) return false;
+  std::vector<uint8_t> expected(k, 0xff);
+  expected[0] = 0x00;
+  expected[1] = 0x01;
+  expected[k - t_len - 1] = 0x00;
+  std::memcpy(&expected[k - t_len], kSha256DigestInfo, sizeof(kSha256DigestInfo));
+  std::memcpy(&expected[k - digest.size()], digest.data(), digest.size());
+  return em == expected;
+}
+
+}  // namespace vc
@@ -0,0 +1,59 @@
+#ifndef VCMEDIA_SIGNALING_RSA_H_
+#define VCMEDIA_SIGNALING_RSA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "signaling/sha256.h"
+
+namespace vc {
+
+// Modular exponentiation for a fixed odd modulus, in 32-bit limbs with
+// Montgomery multiplication (CIOS). R^2 mod n and -n^-1 mod 2^32 are
+// computed once per key, so a verification with e = 65537 is 17 Montgomery
+// products. Not constant time: it only ever handles public values.
+class RsaModulus {
+ public:
+  // `n` is big-endian, as in a JWK "n". Yields an invalid modulus (valid()
+  // false) if n is even, shorter than 512 bits or longer than 8192.
+  RsaModulus(const uint8_t* n, size_t size);
+
+  bool valid() const { return !limbs_.empty(); }
+  size_t size_bytes() const { return size_bytes_; }
+
+  // base^exponent mod n, all big-endian; `base` must be less than n and the
+  // result is size_bytes() long. Returns false if base >= n.
+  bool ModExp(const uint8_t* base, size_t base_size, const uint8_t* exponent,
+              size_t exponent_size, std::vector<uint8_t>* out) const;
+
+ private:
+  using Limbs = std::vector<uint32_t>;
+
+  void MontMul(const uint32_t* a, const uint32_t* b, uint32_t* out) const;
+  bool FromBytes(const uint8_t* bytes, size_t size, Limbs* out) const;
+
+  Limbs limbs_;
+  Limbs r_squared_;
+  uint32_t n0_inv_ = 0;
+  size_t size_bytes_ = 0;
+};
+
+// An RSA public key as published in a JWKS.
+struct RsaPublicKey {
+  RsaPublicKey(const uint8_t* n, size_t n_size, const uint8_t* e, size_t e_size)
+      : modulus(n, n_size), exponent(e, e + e_size) {}
+
+  RsaModulus modulus;
+  std::vector<uint8_t> exponent;
+};
+
+// RSASSA-PKCS1-v1_5 with SHA-256 (JWS "RS256"): recovers the encoded
+// message from `signature` and compares it with the expected one for
+// `digest`, byte for byte.
+bool VerifyRs256(const RsaPublicKey& key, const Sha256Digest& digest,
+                 const uint8_t* signature, size_t signature_size);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_SIGNALING_RSA_H_
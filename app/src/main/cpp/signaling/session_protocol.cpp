@@ -0,0 +1,368 @@
+#include "signaling/session_protocol.h"
+
+#include <algorithm>
+
+namespace vc {
+
+namespace {
+
+constexpr uint8_t kMagic0 = 'V';
+constexpr uint8_t kMagic1 = 'S';
+constexpr uint8_t kFormat = 1;
+constexpr uint8_t kFlagCodecs = 1 << 0;
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kCodecSize = 12;
+
+void Put8(std::vector<uint8_t>* out, uint8_t v) { out->push_back(v); }
+
+void Put16(std::vector<uint8_t>* out, uint16_t v) {
+  out->push_back(static_cast<uint8_t>(v));
+  out->push_back(static_cast<uint8_t>(v >> 8));
+}
+
+void Put32(std::vector<uint8_t>* out, uint32_t v) {
+  for (int i = 0; i < 4; ++i) out->push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+uint16_t Load16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | p[1] << 8); }
+
+uint32_t Load32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+         static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+void Store16(uint8_t* p, uint16_t v) {
+  p[0] = static_cast<uint8_t>(v);
+  p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+// Fields of `t` that differ from `base`.
+uint16_t ChangedFields(const TrackDescription& base, const TrackDescription& t) {
+  using namespace track_field;
+  uint16_t fields = 0;
+  if (t.kind != base.kind) fields |= kKind;
+  if (t.direction != base.direction) fields |= kDirection;
+  if (t.participant != base.participant) fields |= kParticipant;
+  if (t.ssrc != base.ssrc) fields |= kSsrc;
+  if (t.rtx_ssrc != base.rtx_ssrc) fields |= kRtxSsrc;
+  if (t.codecs != base.codecs) fields |= kCodecs;
+  if (t.max_bitrate_bps != base.max_bitrate_bps) fields |= kMaxBitrate;
+  if (t.width != base.width || t.height != base.height) fields |= kResolution;
+  if (t.max_framerate != base.max_framerate) fields |= kMaxFramerate;
+  if (t.simulcast_layers != base.simulcast_layers) fields |= kSimulcastLayers;
+  if (t.muted != base.muted) fields |= kMuted;
+  return fields;
+}
+
+void PutTrackOp(TrackOpType type, const TrackDescription& t, uint16_t fields,
+                std::vector<uint8_t>* out) {
+  using namespace track_field;
+  Put8(out, static_cast<uint8_t>(type));
+  Put32(out, t.id);
+  Put16(out, fields);
+  if (fields & kKind) Put8(out, static_cast<uint8_t>(t.kind));
+  if (fields & kDirection) Put8(out, static_cast<uint8_t>(t.direction));
+  if (fields & kParticipant) {
+    const size_t size = std::min<size_t>(t.participant.size(), 255);
+    Put8(out, static_cast<uint8_t>(size));
+    out->insert(out->end(), t.participant.begin(), t.participant.begin() + size);
+  }
+  if (fields & kSsrc) Put32(out, t.ssrc);
+  if (fields & kRtxSsrc) Put32(out, t.rtx_ssrc);
+  if (fields & kCodecs) Put32(out, t.codecs);
+  if (fields & kMaxBitrate) Put32(out, t.max_bitrate_bps);
+  if (fields & kResolution) {
+    Put16(out, t.width);
+    Put16(out, t.height);
+  }
+  if (fields & kMaxFramerate) Put8(out, t.max_framerate);
+  if (fields & kSimulcastLayers) Put8(out, t.simulcast_layers);
+  if (fields & kMuted) Put8(out, t.muted ? 1 : 0);
+}
+
+// Writes the header with a zero op count and returns its offset so the
+// count can be patched once the ops are written.
+size_t PutHeader(SignalingMessageType type, uint32_t base_version, uint32_t version,
+                 const std::vector<CodecDescription>* codecs, std::vector<uint8_t>* out) {
+  const size_t start = out->size();
+  const size_t codec_count = codecs ? std::min(codecs->size(), kMaxSessionCodecs) : 0;
+  Put8(out, kMagic0);
+  Put8(out, kMagic1);
+  Put8(out, kFormat);
+  Put8(out, static_cast<uint8_t>(type));
+  Put8(out, codecs ? kFlagCodecs : 0);
+  Put8(out, static_cast<uint8_t>(codec_count));
+  Put16(out, 0);
+  Put32(out, base_version);
+  Put32(out, version);
+  for (size_t i = 0; i < codec_count; ++i) {
+    const CodecDescription& c = (*codecs)[i];
+    Put8(out, c.payload_type);
+    Put8(out, static_cast<uint8_t>(c.id));
+    Put8(out, c.channels);
+    Put8(out, c.feedback);
+    Put8(out, c.rtx_payload_type);
+    Put8(out, 0);
+    Put16(out, 0);
+    Put32(out, c.clock_rate);
+  }
+  return start;
+}
+
+// Size of the fields named by `fields` starting at `p`, or 0 if they run
+// past `end` or hold out-of-range values.
+size_t FieldsSize(uint16_t fields, const uint8_t* p, const uint8_t* end) {
+  using namespace track_field;
+  const uint8_t* const start = p;
+  auto need = [&](size_t n) { return static_cast<size_t>(end - p) >= n; };
+  if (fields & kKind) {
+    if (!need(1) || *p > static_cast<uint8_t>(MediaKind::kVideo)) return 0;
+    p += 1;
+  }
+  if (fields & kDirection) {
+    if (!need(1) || *p > static_cast<uint8_t>(TrackDirection::kInactive)) return 0;
+    p += 1;
+  }
+  if (fields & kParticipant) {
+    if (!need(1) || !need(1 + static_cast<size_t>(*p))) return 0;
+    p += 1 + *p;
+  }
+  size_t fixed = 0;
+  if (fields & kSsrc) fixed += 4;
+  if (fields & kRtxSsrc) fixed += 4;
+  if (fields & kCodecs) fixed += 4;
+  if (fields & kMaxBitrate) fixed += 4;
+  if (fields & kResolution) fixed += 4;
+  if (fields & kMaxFramerate) fixed += 1;
+  if (fields & kSimulcastLayers) fixed += 1;
+  if (!need(fixed)) return 0;
+  p += fixed;
+  if (fields & kMuted) {
+    if (!need(1) || *p > 1) return 0;
+    p += 1;
+  }
+  return static_cast<size_t>(p - start);
+}
+
+void SetFields(const TrackOp& op, TrackDescription* t) {
+  using namespace track_field;
+  const uint16_t f = op.fields;
+  if (f & kKind) t->kind = op.kind;
+  if (f & kDirection) t->direction = op.direction;
+  if (f & kParticipant) t->participant.assign(op.participant.data(), op.participant.size());
+  if (f & kSsrc) t->ssrc = op.ssrc;
+  if (f & kRtxSsrc) t->rtx_ssrc = op.rtx_ssrc;
+  if (f & kCodecs) t->codecs = op.codecs;
+  if (f & kMaxBitrate) t->max_bitrate_bps = op.max_bitrate_bps;
+  if (f & kResolution) {
+    t->width = op.width;
+    t->height = op.height;
+  }
+  if (f & kMaxFramerate) t->max_framerate = op.max_framerate;
+  if (f & kSimulcastLayers) t->simulcast_layers = op.simulcast_layers;
+  if (f & kMuted) t->muted = op.muted;
+}
+
+bool TrackIdLess(const TrackDescription& t, uint32_t id) { return t.id < id; }
+
+}  // namespace
+
+bool CodecDescription::operator==(const CodecDescription& o) const {
+  return payload_type == o.payload_type && id == o.id && channels == o.channels &&
+         feedback == o.feedback && rtx_payload_type == o.rtx_payload_type &&
+         clock_rate == o.clock_rate;
+}
+
+bool TrackDescription::operator==(const TrackDescription& o) const {
+  return id == o.id && ChangedFields(*this, o) == 0;
+}
+
+bool SessionDescription::operator==(const SessionDescription& o) const {
+  return version == o.version && codecs == o.codecs && tracks == o.tracks;
+}
+
+const TrackDescription* SessionDescription::FindTrack(uint32_t id) const {
+  auto it = std::lower_bound(tracks.begin(), tracks.end(), id, TrackIdLess);
+  return it != tracks.end() && it->id == id ? &*it : nullptr;
+}
+
+void WriteSessionSnapshot(const SessionDescription& session, std::vector<uint8_t>* out) {
+  const size_t start =
+      PutHeader(SignalingMessageType::kSnapshot, 0, session.version, &session.codecs, out);
+  const TrackDescription empty;
+  for (const TrackDescription& t : session.tracks) {
+    PutTrackOp(TrackOpType::kAdd, t, ChangedFields(empty, t), out);
+  }
+  Store16(&(*out)[start + 6], static_cast<uint16_t>(session.tracks.size()));
+}
+
+void WriteSessionDelta(const SessionDescription& from, const SessionDescription& to,
+                       std::vector<uint8_t>* out) {
+  const bool codecs_changed = from.codecs != to.codecs;
+  const size_t start = PutHeader(SignalingMessageType::kDelta, from.version, to.version,
+                                 codecs_changed ? &to.codecs : nullptr, out);
+  // Both track lists are sorted by id, so one merge pass finds every change.
+  const TrackDescription empty;
+  uint16_t ops = 0;
+  auto a = from.tracks.begin();
+  auto b = to.tracks.begin();
+  while (a != from.tracks.end() || b != to.tracks.end()) {
+    if (b == to.tracks.end() || (a != from.tracks.end() && a->id < b->id)) {
+      Put8(out, static_cast<uint8_t>(TrackOpType::kRemove));
+      Put32(out, a->id);
+      ++ops;
+      ++a;
+    } else if (a == from.tracks.end() || b->id < a->id) {
+      PutTrackOp(TrackOpType::kAdd, *b, ChangedFields(empty, *b), out);
+      ++ops;
+      ++b;
+    } else {
+      const uint16_t fields = ChangedFields(*a, *b);
+      if (fields != 0) {
+        PutTrackOp(TrackOpType::kUpdate, *b, fields, out);
+        ++ops;
+      }
+      ++a;
+      ++b;
+    }
+  }
+  Store16(&(*out)[start + 6], ops);
+}
+
+bool SignalingMessage::Parse(const uint8_t* data, size_t size) {
+  if (size < kHeaderSize || data[0] != kMagic0 || data[1] != kMagic1 || data[2] != kFormat) {
+    return false;
+  }
+  if (data[3] != static_cast<uint8_t>(SignalingMessageType::kSnapshot) &&
+      data[3] != static_cast<uint8_t>(SignalingMessageType::kDelta)) {
+    return false;
+  }
+  if ((data[4] & ~kFlagCodecs) != 0 || data[5] > kMaxSessionCodecs) return false;
+  type_ = static_cast<SignalingMessageType>(data[3]);
+  has_codecs_ = (data[4] & kFlagCodecs) != 0;
+  codec_count_ = data[5];
+  if (!has_codecs_ && codec_count_ != 0) return false;
+  op_count_ = Load16(data + 6);
+  base_version_ = Load32(data + 8);
+  version_ = Load32(data + 12);
+
+  const uint8_t* end = data + size;
+  const uint8_t* p = data + kHeaderSize;
+  if (static_cast<size_t>(end - p) < kCodecSize * codec_count_) return false;
+  codecs_ = p;
+  for (int i = 0; i < codec_count_; ++i, p += kCodecSize) {
+    if (p[1] > static_cast<uint8_t>(CodecId::kH264)) return false;
+  }
+  ops_ = p;
+  for (int i = 0; i < op_count_; ++i) {
+    if (end - p < 5) return false;
+    const uint8_t op = p[0];
+    p += 5;
+    if (op == static_cast<uint8_t>(TrackOpType::kRemove)) continue;
+    if (op != static_cast<uint8_t>(TrackOpType::kAdd) &&
+        op != static_cast<uint8_t>(TrackOpType::kUpdate)) {
+      return false;
+    }
+    if (end - p < 2) return false;
+    const uint16_t fields = Load16(p);
+    p += 2;
+    if (fields & ~track_field::kAll) return false;
+    if (fields == 0) continue;
+    const size_t n = FieldsSize(fields, p, end);
+    if (n == 0) return false;
+    p += n;
+  }
+  if (p != end) return false;
+  end_ = end;
+  return true;
+}
+
+CodecDescription SignalingMessage::codec(int i) const {
+  const uint8_t* p = codecs_ + kCodecSize * i;
+  CodecDescription c;
+  c.payload_type = p[0];
+  c.id = static_cast<CodecId>(p[1]);
+  c.channels = p[2];
+  c.feedback = p[3];
+  c.rtx_payload_type = p[4];
+  c.clock_rate = Load32(p + 8);
+  return c;
+}
+
+bool SignalingMessage::OpReader::Next(TrackOp* op) {
+  using namespace track_field;
+  if (p_ >= end_) return false;
+  *op = TrackOp();
+  op->type = static_cast<TrackOpType>(p_[0]);
+  op->track_id = Load32(p_ + 1);
+  p_ += 5;
+  if (op->type == TrackOpType::kRemove) return true;
+  const uint16_t f = op->fields = Load16(p_);
+  p_ += 2;
+  if (f & kKind) op->kind = static_cast<MediaKind>(*p_++);
+  if (f & kDirection) op->direction = static_cast<TrackDirection>(*p_++);
+  if (f & kParticipant) {
+    const size_t size = *p_++;
+    op->participant = std::string_view(reinterpret_cast<const char*>(p_), size);
+    p_ += size;
+  }
+  if (f & kSsrc) op->ssrc = Load32(p_), p_ += 4;
+  if (f & kRtxSsrc) op->rtx_ssrc = Load32(p_), p_ += 4;
+  if (f & kCodecs) op->codecs = Load32(p_), p_ += 4;
+  if (f & kMaxBitrate) op->max_bitrate_bps = Load32(p_), p_ += 4;
+  if (f & kResolution) {
+    op->width = Load16(p_);
+    op->height = Load16(p_ + 2);
+    p_ += 4;
+  }
+  if (f & kMaxFramerate) op->max_framerate = *p_++;
+  if (f & kSimulcastLayers) op->simulcast_layers = *p_++;
+  if (f & kMuted) op->muted = *p_++ != 0;
+  return true;
+}
+
+bool ApplySignalingMessage(const SignalingMessage& message, SessionDescription* session) {
+  if (message.type() == SignalingMessageType::kSnapshot) {
+    session->codecs.clear();
+    session->tracks.clear();
+  } else if (session->version != message.base_version()) {
+    return false;
+  }
+  if (message.has_codecs()) {
+    session->codecs.resize(message.codec_count());
+    for (int i = 0; i < message.codec_count(); ++i) session->codecs[i] = message.codec(i);
+  }
+
+  std::vector<TrackDescription>& tracks = session->tracks;
+  if (message.type() == SignalingMessageType::kSnapshot) tracks.reserve(message.op_count());
+  SignalingMessage::OpReader reader = message.ops();
+  TrackOp op;
+  while (reader.Next(&op)) {
+    // Ops come in id order from WriteSessionDelta, so appends are the
+    // common case for adds.
+    auto it = !tracks.empty() && tracks.back().id < op.track_id
+                  ? tracks.end()
+                  : std::lower_bound(tracks.begin(), tracks.end(), op.track_id, TrackIdLess);
+    const bool found = it != tracks.end() && it->id == op.track_id;
+    switch (op.type) {
+      case TrackOpType::kAdd:
+        if (found) return false;
+        it = tracks.emplace(it);
+        it->id = op.track_id;
+        SetFields(op, &*it);
+        break;
+      case TrackOpType::kRemove:
+        if (!found) return false;
+        tracks.erase(it);
+        break;
+      case TrackOpType::kUpdate:
+        if (!found) return false;
+        SetFields(op, &*it);
+        break;
+    }
+  }
+  session->version = message.version();
+  return true;
+}
+
+}  // namespace vc
@@ -0,0 +1,197 @@
+#ifndef VCMEDIA_SIGNALING_SESSION_PROTOCOL_H_
+#define VCMEDIA_SIGNALING_SESSION_PROTOCOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vc {
+
+// Media state of a call as the signaling server and clients exchange it:
+// the room's codec table and one entry per published track. This is what
+// an SDP offer/answer carries for us, minus the transport lines (ICE and
+// DTLS are set up once per connection, not per renegotiation).
+
+enum class CodecId : uint8_t { kOpus, kRed, kVcv, kVp8, kH264 };
+enum class MediaKind : uint8_t { kAudio, kVideo };
+enum class TrackDirection : uint8_t { kSendRecv, kSendOnly, kRecvOnly, kInactive };
+
+// RTCP feedback a codec negotiates (bit flags).
+constexpr uint8_t kFeedbackNack = 1 << 0;
+constexpr uint8_t kFeedbackPli = 1 << 1;
+constexpr uint8_t kFeedbackFir = 1 << 2;
+constexpr uint8_t kFeedbackTransportCc = 1 << 3;
+
+struct CodecDescription {
+  uint8_t payload_type = 0;
+  CodecId id = CodecId::kOpus;
+  uint8_t channels = 1;
+  uint8_t feedback = 0;
+  // Payload type of the codec's RTX stream, or 0 for none.
+  uint8_t rtx_payload_type = 0;
+  uint32_t clock_rate = 0;
+
+  bool operator==(const CodecDescription& o) const;
+  bool operator!=(const CodecDescription& o) const { return !(*this == o); }
+};
+
+// Codec tables are at most this long so a track's codecs fit a bit mask.
+constexpr size_t kMaxSessionCodecs = 32;
+
+struct TrackDescription {
+  // Unique within the session and never reused; plays the role of the SDP mid.
+  uint32_t id = 0;
+  MediaKind kind = MediaKind::kAudio;
+  TrackDirection direction = TrackDirection::kSendRecv;
+  // Owner's user ID; at most 255 bytes.
+  std::string participant;
+  uint32_t ssrc = 0;
+  uint32_t rtx_ssrc = 0;
+  // Bit i set if codecs[i] of the session may be used, in preference order
+  // of the table.
+  uint32_t codecs = 0;
+  uint32_t max_bitrate_bps = 0;
+  uint16_t width = 0;
+  uint16_t height = 0;
+  uint8_t max_framerate = 0;
+  uint8_t simulcast_layers = 0;
+  bool muted = false;
+
+  bool operator==(const TrackDescription& o) const;
+  bool operator!=(const TrackDescription& o) const { return !(*this == o); }
+};
+
+struct SessionDescription {
+  // Bumped by every message; a delta applies only to the version it was
+  // computed from.
+  uint32_t version = 0;
+  std::vector<CodecDescription> codecs;
+  // Sorted by id.
+  std::vector<TrackDescription> tracks;
+
+  bool operator==(const SessionDescription& o) const;
+  const TrackDescription* FindTrack(uint32_t id) const;
+};
+
+// Wire format, all integers little-endian and nothing aligned:
+//
+//   header   magic "VS", format 1, type (1 snapshot, 2 delta), flags
+//            (bit 0: codec table present), codec count u8, op count u16,
+//            base version u32, version u32                         16 bytes
+//   codecs   pt, id, channels, feedback, rtx pt, 3 reserved,
+//            clock rate u32                                  12 bytes each
+//   ops      op u8 (1 add, 2 remove, 3 update), track id u32, then for add
+//            and update a u16 field mask and the fields it names, in bit
+//            order: kind u8, direction u8, participant (u8 length and
+//            bytes), ssrc u32, rtx ssrc u32, codecs u32, max bitrate u32,
+//            width u16 and height u16, max framerate u8, simulcast layers
+//            u8, muted u8.
+//
+// An add names only the fields that differ from a default TrackDescription
+// and an update only those that changed, so a mute is 8 bytes of op and a
+// join is a few dozen bytes however large the room is. A snapshot is a
+// delta from the empty session.
+
+enum class SignalingMessageType : uint8_t { kSnapshot = 1, kDelta = 2 };
+enum class TrackOpType : uint8_t { kAdd = 1, kRemove = 2, kUpdate = 3 };
+
+namespace track_field {
+constexpr uint16_t kKind = 1 << 0;
+constexpr uint16_t kDirection = 1 << 1;
+constexpr uint16_t kParticipant = 1 << 2;
+constexpr uint16_t kSsrc = 1 << 3;
+constexpr uint16_t kRtxSsrc = 1 << 4;
+constexpr uint16_t kCodecs = 1 << 5;
+constexpr uint16_t kMaxBitrate = 1 << 6;
+constexpr uint16_t kResolution = 1 << 7;
+constexpr uint16_t kMaxFramerate = 1 << 8;
+constexpr uint16_t kSimulcastLayers = 1 << 9;
+constexpr uint16_t kMuted = 1 << 10;
+constexpr uint16_t kAll = (1 << 11) - 1;
+}  // namespace track_field
+
+// Appends the whole session; `session.version` becomes the message version.
+void WriteSessionSnapshot(const SessionDescription& session, std::vector<uint8_t>* out);
+
+// Appends what changed from `from` to `to`: the codec table if it differs,
+// and adds, removes and field updates for tracks. The message applies to
+// `from.version` and produces `to.version`.
+void WriteSessionDelta(const SessionDescription& from, const SessionDescription& to,
+                       std::vector<uint8_t>* out);
+
+// One track operation decoded in place; `participant` points into the
+// message buffer. Fields not named in `fields` are zero.
+struct TrackOp {
+  TrackOpType type = TrackOpType::kAdd;
+  uint32_t track_id = 0;
+  uint16_t fields = 0;
+  MediaKind kind = MediaKind::kAudio;
+  TrackDirection direction = TrackDirection::kSendRecv;
+  std::string_view participant;
+  uint32_t ssrc = 0;
+  uint32_t rtx_ssrc = 0;
+  uint32_t codecs = 0;
+  uint32_t max_bitrate_bps = 0;
+  uint16_t width = 0;
+  uint16_t height = 0;
+  uint8_t max_framerate = 0;
+  uint8_t simulcast_layers = 0;
+  bool muted = false;
+};
+
+// Zero-copy reader: Parse() checks the whole message in one pass without
+// allocating, and the accessors then decode straight from the caller's
+// buffer, which must outlive the view. The server can inspect and relay a
+// message (e.g. check that every op is for the sender's own tracks) without
+// materialising it.
+class SignalingMessage {
+ public:
+  // False for a wrong magic or format, truncation, trailing bytes, unknown
+  // op or field bits, or enum values out of range.
+  bool Parse(const uint8_t* data, size_t size);
+
+  SignalingMessageType type() const { return type_; }
+  uint32_t base_version() const { return base_version_; }
+  uint32_t version() const { return version_; }
+  bool has_codecs() const { return has_codecs_; }
+  int codec_count() const { return codec_count_; }
+  CodecDescription codec(int i) const;
+  int op_count() const { return op_count_; }
+
+  // Iterates the ops in message order.
+  class OpReader {
+   public:
+    bool Next(TrackOp* op);
+
+   private:
+    friend class SignalingMessage;
+    OpReader(const uint8_t* p, const uint8_t* end) : p_(p), end_(end) {}
+    const uint8_t* p_;
+    const uint8_t* end_;
+  };
+  OpReader ops() const { return OpReader(ops_, end_); }
+
+ private:
+  const uint8_t* codecs_ = nullptr;
+  const uint8_t* ops_ = nullptr;
+  const uint8_t* end_ = nullptr;
+  SignalingMessageType type_ = SignalingMessageType::kSnapshot;
+  uint32_t base_version_ = 0;
+  uint32_t version_ = 0;
+  bool has_codecs_ = false;
+  int codec_count_ = 0;
+  int op_count_ = 0;
+};
+
+// Applies a parsed message. A snapshot replaces `session`; a delta needs
+// session->version == base_version(). Returns false if the versions do not
+// match (nothing is changed) or an op does not fit the state: adding an
+// existing track, or updating or removing a missing one. In the latter case
+// `session` is partly updated and must be replaced by a fresh snapshot.
+bool ApplySignalingMessage(const SignalingMessage& message, SessionDescription* session);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_SIGNALING_SESSION_PROTOCOL_H_
@@ -0,0 +1,35 @@
+#ifndef VCMEDIA_SIGNALING_SHA256_H_
+#define VCMEDIA_SIGNALING_SHA256_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vc {
+
+using Sha256Digest = std::array<uint8_t, 32>;
+
+// FIPS 180-4 SHA-256, incremental.
+class Sha256 {
+ public:
+  Sha256();
+
+  void Update(const void* data, size_t size);
+  Sha256Digest Finish();
+
+  static Sha256Digest Hash(const void* data, size_t size);
+  static Sha256Digest Hash(const std::string& data) { return Hash(data.data(), data.size()); }
+
+ private:
+  void Compress(const uint8_t* block);
+
+  uint32_t state_[8];
+  uint8_t buffer_[64];
+  size_t buffered_ = 0;
+  uint64_t length_ = 0;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_SIGNALING_SHA256_H_
@@ -0,0 +1,388 @@
+#include "signaling/token_verifier.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "signaling/base64url.h"
+#include "signaling/json.h"
+
+namespace vc {
+
+namespace {
+
+constexpr size_t kMaxSubjectLength = 128;
+constexpr int kMaxBatchThreads = 8;
+// Below this many signatures a batch is checked on the calling thread;
+// starting threads would cost more than it saves.
+constexpr size_t kMinParallelSignatures = 4;
+
+bool ParseKeySet(const std::string& body, std::vector<std::pair<std::string, RsaPublicKey>>* out) {
+  JsonValue root;
+  if (!JsonValue::Parse(body, &root) || !root.is_object()) return false;
+  const JsonValue* keys = root.Find("keys");
+  if (!keys || !keys->is_array()) return false;
+  std::string n, e;
+  for (const JsonValue& jwk : keys->array()) {
+    const std::string* kty = jwk.FindString("kty");
+    const std::string* kid = jwk.FindString("kid");
+    const std::string* n64 = jwk.FindString("n");
+    const std::string* e64 = jwk.FindString("e");
+    const std::string* use = jwk.FindString("use");
+    const std::string* alg = jwk.FindString("alg");
+    if (!kty || *kty != "RSA" || !kid || !n64 || !e64) continue;
+    if ((use && *use != "sig") || (alg && *alg != "RS256")) continue;
+    if (!Base64UrlDecode(*n64, &n) || !Base64UrlDecode(*e64, &e) || e.empty()) continue;
+    RsaPublicKey key(reinterpret_cast<const uint8_t*>(n.data()), n.size(),
+                     reinterpret_cast<const uint8_t*>(e.data()), e.size());
+    if (!key.modulus.valid()) continue;
+    out->emplace_back(*kid, std::move(key));
+  }
+  return !out->empty();
+}
+
+}  // namespace
+
+const char* TokenStatusName(TokenStatus status) {
+  switch (status) {
+    case TokenStatus::kValid:
+      return "valid";
+    case TokenStatus::kMalformed:
+      return "malformed";
+    case TokenStatus::kUnsupportedAlgorithm:
+      return "unsupported-algorithm";
+    case TokenStatus::kUnknownKey:
+      return "unknown-key";
+    case TokenStatus::kKeysUnavailable:
+      return "keys-unavailable";
+    case TokenStatus::kBadSignature:
+      return "bad-signature";
+    case TokenStatus::kExpired:
+      return "expired";
+    case TokenStatus::kIssuedInFuture:
+      return "issued-in-future";
+    case TokenStatus::kWrongAudience:
+      return "wrong-audience";
+    case TokenStatus::kWrongIssuer:
+      return "wrong-issuer";
+    case TokenStatus::kBadSubject:
+      return "bad-subject";
+  }
+  return "unknown";
+}
+
+const RsaPublicKey* FirebaseTokenVerifier::KeySet::Find(const std::string& kid) const {
+  for (const auto& key : keys) {
+    if (key.first == kid) return &key.second;
+  }
+  return nullptr;
+}
+
+size_t FirebaseTokenVerifier::DigestHash::operator()(const Sha256Digest& digest) const {
+  // The digest is already uniformly distributed.
+  size_t h;
+  std::memcpy(&h, digest.data(), sizeof(h));
+  return h;
+}
+
+FirebaseTokenVerifier::FirebaseTokenVerifier(const Config& config, KeyFetcher fetcher,
+                                             Clock clock)
+    : config_(config),
+      issuer_("https://securetoken.google.com/" + config.project_id),
+      fetcher_(std::move(fetcher)),
+      clock_(std::move(clock)) {}
+
+int64_t FirebaseTokenVerifier::NowMs() const {
+  if (clock_) return clock_();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+VerifiedToken FirebaseTokenVerifier::Verify(const std::string& token) {
+  const int64_t now_s = NowMs() / 1000;
+  Pending pending;
+  pending.token = &token;
+  pending.digest = Sha256::Hash(token);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.verifications;
+    if (LookupLocked(pending.digest, now_s, &pending.result)) return pending.result;
+  }
+  Parse(now_s, &pending);
+  if (pending.needs_signature) {
+    pending.keys = KeysFor(pending.kid);
+    CheckSignature(&pending);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  StoreLocked(pending, now_s);
+  return pending.result;
+}
+
+std::vector<VerifiedToken> FirebaseTokenVerifier::VerifyBatch(
+    const std::vector<std::string>& tokens) {
+  const int64_t now_s = NowMs() / 1000;
+  std::vector<VerifiedToken> results(tokens.size());
+
+  // Duplicates (one client retrying, or a fan-out of the same session) are
+  // verified once; `owner[i]` is the first index with the same token.
+  std::vector<Pending> pending;
+  std::vector<size_t> owner(tokens.size());
+  {
+    std::unordered_map<Sha256Digest, size_t, DigestHash> first;
+    first.reserve(tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+      const Sha256Digest digest = Sha256::Hash(tokens[i]);
+      auto inserted = first.emplace(digest, pending.size());
+      owner[i] = inserted.first->second;
+      if (!inserted.second) continue;
+      pending.emplace_back();
+      pending.back().token = &tokens[i];
+      pending.back().digest = digest;
+    }
+  }
+
+  std::vector<Pending*> misses;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.verifications += static_cast<int64_t>(tokens.size());
+    for (Pending& p : pending) {
+      if (LookupLocked(p.digest, now_s, &p.result)) {
+        p.resolved = true;
+      } else {
+        misses.push_back(&p);
+      }
+    }
+  }
+
+  std::vector<Pending*> signatures;
+  for (Pending* p : misses) {
+    Parse(now_s, p);
+    if (p->needs_signature) signatures.push_back(p);
+  }
+  // One key lookup per distinct kid; an unknown one triggers at most one
+  // (rate-limited) fetch for the whole batch.
+  for (size_t i = 0; i < signatures.size(); ++i) {
+    Pending* p = signatures[i];
+    for (size_t j = 0; j < i && !p->keys; ++j) {
+      if (signatures[j]->kid == p->kid) p->keys = signatures[j]->keys;
+    }
+    if (!p->keys) p->keys = KeysFor(p->kid);
+  }
+
+  int threads = config_.batch_threads;
+  if (threads <= 0) {
+    threads = std::min<int>(kMaxBatchThreads,
+                            std::max(1u, std::thread::hardware_concurrency()));
+  }
+  threads = static_cast<int>(std::min<size_t>(threads, signatures.size()));
+  if (threads > 1 && signatures.size() >= kMinParallelSignatures) {
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+      for (size_t i; (i = next.fetch_add(1)) < signatures.size();) CheckSignature(signatures[i]);
+    };
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; ++t) workers.emplace_back(work);
+    work();
+    for (std::thread& worker : workers) worker.join();
+  } else {
+    for (Pending* p : signatures) CheckSignature(p);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Pending* p : misses) StoreLocked(*p, now_s);
+  }
+  for (size_t i = 0; i < tokens.size(); ++i) results[i] = pending[owner[i]].result;
+  return results;
+}
+
+bool FirebaseTokenVerifier::RefreshKeys() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  fetched_.wait(lock, [this] { return !fetching_; });
+  return FetchKeys(&lock);
+}
+
+size_t FirebaseTokenVerifier::cached_tokens() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tokens_.size();
+}
+
+FirebaseTokenVerifier::Stats FirebaseTokenVerifier::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+bool FirebaseTokenVerifier::LookupLocked(const Sha256Digest& digest, int64_t now_s,
+                                         VerifiedToken* out) {
+  auto it = tokens_.find(digest);
+  if (it == tokens_.end()) return false;
+  if (it->second.expires_at_s <= now_s - config_.clock_skew_s) {
+    tokens_.erase(it);
+    out->status = TokenStatus::kExpired;
+    ++stats_.rejected;
+    return true;
+  }
+  out->status = TokenStatus::kValid;
+  out->uid = it->second.uid;
+  out->expires_at_s = it->second.expires_at_s;
+  out->auth_time_s = it->second.auth_time_s;
+  out->cached = true;
+  ++stats_.cache_hits;
+  return true;
+}
+
+void FirebaseTokenVerifier::Parse(int64_t now_s, Pending* pending) const {
+  const std::string& token = *pending->token;
+  VerifiedToken& result = pending->result;
+  result.status = TokenStatus::kMalformed;
+  const size_t dot1 = token.find('.');
+  if (dot1 == std::string::npos) return;
+  const size_t dot2 = token.find('.', dot1 + 1);
+  if (dot2 == std::string::npos || token.find('.', dot2 + 1) != std::string::npos) return;
+
+  std::string decoded;
+  JsonValue header, claims;
+  if (!Base64UrlDecode(token.data(), dot1, &decoded) || !JsonValue::Parse(decoded, &header) ||
+      !header.is_object()) {
+    return;
+  }
+  const std::string* alg = header.FindString("alg");
+  if (!alg || *alg != "RS256") {
+    result.status = alg ? TokenStatus::kUnsupportedAlgorithm : TokenStatus::kMalformed;
+    return;
+  }
+  const std::string* kid = header.FindString("kid");
+  if (!kid) return;
+
+  if (!Base64UrlDecode(token.data() + dot1 + 1, dot2 - dot1 - 1, &decoded) ||
+      !JsonValue::Parse(decoded, &claims) || !claims.is_object()) {
+    return;
+  }
+  int64_t exp, iat, auth_time;
+  const std::string* aud = claims.FindString("aud");
+  const std::string* iss = claims.FindString("iss");
+  const std::string* sub = claims.FindString("sub");
+  if (!claims.FindInt("exp", &exp) || !claims.FindInt("iat", &iat) ||
+      !claims.FindInt("auth_time", &auth_time) || !aud || !iss || !sub) {
+    return;
+  }
+
+  // Claims are checked before the signature so that stale or misdirected
+  // tokens never cost an RSA operation.
+  const int64_t skew = config_.clock_skew_s;
+  if (exp <= now_s - skew) {
+    result.status = TokenStatus::kExpired;
+  } else if (iat > now_s + skew || auth_time > now_s + skew) {
+    result.status = TokenStatus::kIssuedInFuture;
+  } else if (*aud != config_.project_id) {
+    result.status = TokenStatus::kWrongAudience;
+  } else if (*iss != issuer_) {
+    result.status = TokenStatus::kWrongIssuer;
+  } else if (sub->empty() || sub->size() > kMaxSubjectLength) {
+    result.status = TokenStatus::kBadSubject;
+  } else if (Base64UrlDecode(token.data() + dot2 + 1, token.size() - dot2 - 1,
+                             &pending->signature)) {
+    result.status = TokenStatus::kValid;
+    result.uid = *sub;
+    result.expires_at_s = exp;
+    result.auth_time_s = auth_time;
+    pending->kid = *kid;
+    pending->signing_input_size = dot2;
+    pending->needs_signature = true;
+  }
+}
+
+std::shared_ptr<const FirebaseTokenVerifier::KeySet> FirebaseTokenVerifier::KeysFor(
+    const std::string& kid) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const int64_t now_ms = NowMs();
+  if (keys_ && keys_->expires_at_ms > now_ms && keys_->Find(kid)) return keys_;
+  if (fetching_) {
+    // Someone else is already fetching; use whatever that produces.
+    fetched_.wait(lock, [this] { return !fetching_; });
+    return keys_;
+  }
+  if (fetch_attempted_ && now_ms - last_fetch_ms_ < config_.min_refetch_interval_ms) {
+    return keys_;
+  }
+  FetchKeys(&lock);
+  return keys_;
+}
+
+bool FirebaseTokenVerifier::FetchKeys(std::unique_lock<std::mutex>* lock) {
+  fetching_ = true;
+  fetch_attempted_ = true;
+  last_fetch_ms_ = NowMs();
+  ++stats_.key_fetches;
+  lock->unlock();
+
+  // Fetching and parsing (a few modular reductions per key) run unlocked so
+  // that cache hits are never held up by the network.
+  std::string body;
+  int64_t max_age_s = -1;
+  auto set = std::make_shared<KeySet>();
+  const bool ok = fetcher_ && fetcher_(&body, &max_age_s) && ParseKeySet(body, &set->keys);
+  if (ok) {
+    if (max_age_s < 0) max_age_s = config_.default_key_max_age_s;
+    set->expires_at_ms = NowMs() + max_age_s * 1000;
+  }
+
+  lock->lock();
+  if (ok) {
+    keys_ = std::move(set);
+  } else {
+    ++stats_.key_fetch_failures;
+  }
+  fetching_ = false;
+  fetched_.notify_all();
+  return ok;
+}
+
+void FirebaseTokenVerifier::CheckSignature(Pending* pending) {
+  if (!pending->keys) {
+    pending->result.status = TokenStatus::kKeysUnavailable;
+    return;
+  }
+  const RsaPublicKey* key = pending->keys->Find(pending->kid);
+  if (!key) {
+    pending->result.status = TokenStatus::kUnknownKey;
+    return;
+  }
+  pending->signature_checked = true;
+  const Sha256Digest digest =
+      Sha256::Hash(pending->token->data(), pending->signing_input_size);
+  if (!VerifyRs256(*key, digest, reinterpret_cast<const uint8_t*>(pending->signature.data()),
+                   pending->signature.size())) {
+    pending->result.status = TokenStatus::kBadSignature;
+  }
+}
+
+void FirebaseTokenVerifier::StoreLocked(const Pending& pending, int64_t now_s) {
+  if (pending.resolved) return;
+  if (pending.signature_checked) ++stats_.signature_checks;
+  const VerifiedToken& result = pending.result;
+  if (!result.ok()) {
+    ++stats_.rejected;
+    return;
+  }
+  if (tokens_.size() >= config_.max_cached_tokens) {
+    for (auto it = tokens_.begin(); it != tokens_.end();) {
+      if (it->second.expires_at_s <= now_s - config_.clock_skew_s) {
+        it = tokens_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    while (!tokens_.empty() && tokens_.size() >= config_.max_cached_tokens) {
+      tokens_.erase(tokens_.begin());
+    }
+  }
+  if (config_.max_cached_tokens == 0) return;
+  tokens_[pending.digest] =
+      CachedToken{result.uid, result.expires_at_s, result.auth_time_s};
+}
+
+}  // namespace vc
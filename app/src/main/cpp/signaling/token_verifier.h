@@ -0,0 +1,180 @@
+#ifndef VCMEDIA_SIGNALING_TOKEN_VERIFIER_H_
+#define VCMEDIA_SIGNALING_TOKEN_VERIFIER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "signaling/rsa.h"
+#include "signaling/sha256.h"
+
+namespace vc {
+
+enum class TokenStatus {
+  kValid,
+  kMalformed,             // Not three base64url parts of JSON, or claims missing.
+  kUnsupportedAlgorithm,  // Header alg is not RS256.
+  kUnknownKey,            // No published key has the header's kid.
+  kKeysUnavailable,       // The key set has never been fetched successfully.
+  kBadSignature,
+  kExpired,
+  kIssuedInFuture,        // iat or auth_time later than now.
+  kWrongAudience,
+  kWrongIssuer,
+  kBadSubject,            // sub empty or longer than 128 characters.
+};
+
+const char* TokenStatusName(TokenStatus status);
+
+struct VerifiedToken {
+  TokenStatus status = TokenStatus::kMalformed;
+  // Set when status is kValid.
+  std::string uid;
+  int64_t expires_at_s = 0;
+  int64_t auth_time_s = 0;
+  // True if the result came from the verified-token cache.
+  bool cached = false;
+
+  bool ok() const { return status == TokenStatus::kValid; }
+};
+
+// Verifies Firebase Auth ID tokens (RS256 JWTs) for the signaling server on
+// every connect without an RSA operation or a key fetch per request:
+//
+//  - The signing keys (Google's securetoken JWKS) are held in memory as a
+//    parsed, immutable set and refetched only when the server's max-age
+//    runs out or a token names an unknown kid. Refetches are single-flight
+//    and at most one per min_refetch_interval_ms, so a flood of tokens with
+//    made-up kids cannot turn into a flood of key fetches. If a refetch
+//    fails the previous set stays in use.
+//  - Tokens that verified are cached by SHA-256 of the token until their
+//    exp, so a client reconnecting with the same token costs one hash and a
+//    map lookup. Rejections are not cached.
+//  - VerifyBatch() handles a burst of connects: duplicates are verified
+//    once, the cache is consulted under one lock acquisition, and the
+//    remaining signatures are checked on up to batch_threads threads.
+//
+// The checks are those Firebase documents for ID tokens: alg RS256, kid
+// among the published keys, exp in the future, iat and auth_time in the
+// past, aud the project ID, iss https://securetoken.google.com/<project>
+// and a non-empty sub of at most 128 characters. Revocation is not checked
+// (that needs the Admin API); revoked sessions run out at exp.
+//
+// Thread safe.
+class FirebaseTokenVerifier {
+ public:
+  // Fetches the JWKS document. Returns false on failure; on success sets
+  // `max_age_s` from the response's Cache-Control, or -1 if it had none.
+  using KeyFetcher = std::function<bool(std::string* body, int64_t* max_age_s)>;
+  // Wall-clock milliseconds since the Unix epoch.
+  using Clock = std::function<int64_t()>;
+
+  struct Config {
+    std::string project_id;
+    // Tolerance for exp, iat and auth_time against the local clock.
+    int64_t clock_skew_s = 30;
+    // Minimum time between two key fetches made on demand (unknown kid or
+    // expired key set); RefreshKeys() is not limited.
+    int64_t min_refetch_interval_ms = 30000;
+    // Key set lifetime when the fetch reported no max-age.
+    int64_t default_key_max_age_s = 3600;
+    // Expired entries are swept when the cache reaches this size; if it is
+    // still full, arbitrary entries are dropped.
+    size_t max_cached_tokens = 100000;
+    // Threads for signature checks in VerifyBatch(); 0 means one per core
+    // (at most 8).
+    int batch_threads = 0;
+  };
+
+  struct Stats {
+    int64_t verifications = 0;
+    int64_t cache_hits = 0;
+    int64_t signature_checks = 0;
+    int64_t rejected = 0;
+    int64_t key_fetches = 0;
+    int64_t key_fetch_failures = 0;
+  };
+
+  FirebaseTokenVerifier(const Config& config, KeyFetcher fetcher, Clock clock = nullptr);
+
+  VerifiedToken Verify(const std::string& token);
+  std::vector<VerifiedToken> VerifyBatch(const std::vector<std::string>& tokens);
+
+  // Fetches the key set now, ignoring max-age and the refetch interval, e.g.
+  // at server start so the first connect does not wait for it.
+  bool RefreshKeys();
+
+  size_t cached_tokens() const;
+  Stats GetStats() const;
+
+ private:
+  struct KeySet {
+    std::vector<std::pair<std::string, RsaPublicKey>> keys;
+    int64_t expires_at_ms = 0;
+
+    const RsaPublicKey* Find(const std::string& kid) const;
+  };
+
+  struct CachedToken {
+    std::string uid;
+    int64_t expires_at_s;
+    int64_t auth_time_s;
+  };
+
+  struct DigestHash {
+    size_t operator()(const Sha256Digest& digest) const;
+  };
+
+  // One token on its way through verification. After Parse(), `result`
+  // holds the rejection if the claims already failed, or the would-be
+  // result pending the signature check.
+  struct Pending {
+    const std::string* token = nullptr;
+    Sha256Digest digest;
+    VerifiedToken result;
+    // Answered from the cache.
+    bool resolved = false;
+    std::string kid;
+    size_t signing_input_size = 0;
+    std::string signature;
+    bool needs_signature = false;
+    std::shared_ptr<const KeySet> keys;
+    bool signature_checked = false;
+  };
+
+  // Looks `digest` up; mutex_ must be held. Returns true with `out` filled
+  // on a hit, or for a cached token that has since expired.
+  bool LookupLocked(const Sha256Digest& digest, int64_t now_s, VerifiedToken* out);
+  void Parse(int64_t now_s, Pending* pending) const;
+  // Returns a key set that contains `kid` if one can be had.
+  std::shared_ptr<const KeySet> KeysFor(const std::string& kid);
+  bool FetchKeys(std::unique_lock<std::mutex>* lock);
+  static void CheckSignature(Pending* pending);
+  void StoreLocked(const Pending& pending, int64_t now_s);
+  int64_t NowMs() const;
+
+  const Config config_;
+  const std::string issuer_;
+  const KeyFetcher fetcher_;
+  const Clock clock_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable fetched_;
+  std::shared_ptr<const KeySet> keys_;
+  bool fetching_ = false;
+  bool fetch_attempted_ = false;
+  int64_t last_fetch_ms_ = 0;
+  std::unordered_map<Sha256Digest, CachedToken, DigestHash> tokens_;
+  Stats stats_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_SIGNALING_TOKEN_VERIFIER_H_
@@ -0,0 +1,66 @@
+#include "sync/av_synchronizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vc {
+
+AvSynchronizer::AvSynchronizer(int audio_clock_hz, int video_clock_hz)
+    : AvSynchronizer(audio_clock_hz, video_clock_hz, Config()) {}
+
+AvSynchronizer::AvSynchronizer(int audio_clock_hz, int video_clock_hz,
+                               const Config& config)
+    : config_(config), audio_ntp_(audio_clock_hz), video_ntp_(video_clock_hz) {}
+
+void AvSynchronizer::OnAudioSenderReport(double ntp_ms,
+                                         uint32_t rtp_timestamp) {
+  audio_ntp_.OnSenderReport(ntp_ms, rtp_timestamp);
+}
+
+void AvSynchronizer::OnVideoSenderReport(double ntp_ms,
+                                         uint32_t rtp_timestamp) {
+  video_ntp_.OnSenderReport(ntp_ms, rtp_timestamp);
+}
+
+bool AvSynchronizer::Update(const StreamTiming& audio,
+                            const StreamTiming& video) {
+  if (!audio_ntp_.valid() || !video_ntp_.valid()) return false;
+
+  // Capture-to-playout time of each stream. The unknown offset between the
+  // sender's and our clock appears in both and cancels in the difference.
+  double audio_path = audio.receive_time_ms -
+                      audio_ntp_.Estimate(audio.rtp_timestamp) +
+                      audio.current_delay_ms;
+  double video_path = video.receive_time_ms -
+                      video_ntp_.Estimate(video.rtp_timestamp) +
+                      video.current_delay_ms;
+  double relative = video_path - audio_path;
+  if (!has_filtered_) {
+    filtered_ms_ = relative;
+    has_filtered_ = true;
+  } else {
+    filtered_ms_ += config_.filter_alpha * (relative - filtered_ms_);
+  }
+
+  double error = filtered_ms_ + delays_.extra_video_delay_ms -
+                 delays_.extra_audio_delay_ms;
+  if (std::fabs(error) < config_.deadband_ms) return true;
+  int step = static_cast<int>(std::lround(
+      std::clamp(error * config_.correction_gain,
+                 static_cast<double>(-config_.max_step_ms),
+                 static_cast<double>(config_.max_step_ms))));
+
+  // Undo extra delay on the lagging stream before adding it to the leading
+  // one, so total latency only grows when it has to.
+  int& lagging = step > 0 ? delays_.extra_video_delay_ms
+                          : delays_.extra_audio_delay_ms;
+  int& leading = step > 0 ? delays_.extra_audio_delay_ms
+                          : delays_.extra_video_delay_ms;
+  int amount = std::abs(step);
+  int undo = std::min(amount, lagging);
+  lagging -= undo;
+  leading = std::min(config_.max_extra_delay_ms, leading + amount - undo);
+  return true;
+}
+
+}  // namespace vc
@@ -0,0 +1,70 @@
+#ifndef VCMEDIA_SYNC_AV_SYNCHRONIZER_H_
+#define VCMEDIA_SYNC_AV_SYNCHRONIZER_H_
+
+#include <cstdint>
+
+#include "sync/rtp_to_ntp_estimator.h"
+
+namespace vc {
+
+// Keeps one participant's audio and video in sync. Both streams are mapped to
+// the sender's wall clock through their RTCP sender reports; comparing how
+// long each took from capture to playout (network transit plus jitter buffer
+// delay) gives the relative delay, which is removed gradually by delaying
+// whichever stream is ahead.
+class AvSynchronizer {
+ public:
+  struct Config {
+    // Relative delay below this is left alone to avoid hunting.
+    int deadband_ms = 5;
+    // Fraction of the remaining error corrected per update, and its cap, so
+    // adjustments stay inaudible and invisible.
+    double correction_gain = 0.5;
+    int max_step_ms = 30;
+    int max_extra_delay_ms = 500;
+    // Smoothing of the relative delay measurement.
+    double filter_alpha = 0.3;
+  };
+
+  // Latest frame handed to the jitter buffer and the buffer's current delay.
+  struct StreamTiming {
+    uint32_t rtp_timestamp = 0;
+    int64_t receive_time_ms = 0;
+    int current_delay_ms = 0;
+  };
+
+  struct Delays {
+    // Added to the audio jitter buffer's target delay.
+    int extra_audio_delay_ms = 0;
+    // Added to the render time of every video frame.
+    int extra_video_delay_ms = 0;
+  };
+
+  AvSynchronizer(int audio_clock_hz, int video_clock_hz);
+  AvSynchronizer(int audio_clock_hz, int video_clock_hz, const Config& config);
+
+  void OnAudioSenderReport(double ntp_ms, uint32_t rtp_timestamp);
+  void OnVideoSenderReport(double ntp_ms, uint32_t rtp_timestamp);
+
+  // Call periodically (e.g. every 200 ms). Returns false until both streams
+  // have sender reports; `current_delay_ms` must exclude the extra delays
+  // previously returned.
+  bool Update(const StreamTiming& audio, const StreamTiming& video);
+
+  const Delays& delays() const { return delays_; }
+  // Filtered video-minus-audio delay before correction, in ms. Positive
+  // means video would play out later than audio.
+  double relative_delay_ms() const { return filtered_ms_; }
+
+ private:
+  Config config_;
+  RtpToNtpEstimator audio_ntp_;
+  RtpToNtpEstimator video_ntp_;
+  double filtered_ms_ = 0.0;
+  bool has_filtered_ = false;
+  Delays delays_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_SYNC_AV_SYNCHRONIZER_H_
@@ -0,0 +1,87 @@
+#include "sync/rtp_to_ntp_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vc {
+
+namespace {
+
+// A report this far off the nominal clock means the stream was reset.
+constexpr double kMaxClockError = 0.1;
+constexpr double kMinToleranceMs = 100.0;
+
+}  // namespace
+
+double NtpToMs(uint64_t ntp) {
+  double seconds = static_cast<double>(ntp >> 32);
+  double fraction = static_cast<double>(ntp & 0xffffffffu) / 4294967296.0;
+  return (seconds + fraction) * 1000.0;
+}
+
+RtpToNtpEstimator::RtpToNtpEstimator(int clock_rate_hz)
+    : clock_rate_hz_(clock_rate_hz) {}
+
+int64_t RtpToNtpEstimator::Unwrap(uint32_t rtp_timestamp) const {
+  int64_t reference = rtp_[newest_];
+  return reference + static_cast<int32_t>(rtp_timestamp -
+                                          static_cast<uint32_t>(reference));
+}
+
+bool RtpToNtpEstimator::OnSenderReport(double ntp_ms, uint32_t rtp_timestamp) {
+  bool consistent = true;
+  int64_t rtp = rtp_timestamp;
+  if (count_ > 0) {
+    rtp = Unwrap(rtp_timestamp);
+    double elapsed_ntp = ntp_ms - ntp_ms_[newest_];
+    double elapsed_rtp = (rtp - rtp_[newest_]) * 1000.0 / clock_rate_hz_;
+    if (elapsed_ntp <= 0.0) return true;  // Duplicate or reordered report.
+    double tolerance = std::max(kMinToleranceMs, kMaxClockError * elapsed_ntp);
+    if (std::fabs(elapsed_rtp - elapsed_ntp) > tolerance) {
+      count_ = 0;
+      newest_ = -1;
+      rtp = rtp_timestamp;
+      consistent = false;
+    }
+  }
+  newest_ = (newest_ + 1) % kMaxReports;
+  ntp_ms_[newest_] = ntp_ms;
+  rtp_[newest_] = rtp;
+  count_ = std::min(count_ + 1, kMaxReports);
+  Fit();
+  return consistent;
+}
+
+void RtpToNtpEstimator::Fit() {
+  const double nominal = 1000.0 / clock_rate_hz_;
+  slope_ = nominal;
+  offset_ms_ = ntp_ms_[newest_];
+  if (count_ < 2) return;
+
+  double mean_x = 0.0, mean_y = 0.0;
+  for (int i = 0; i < count_; ++i) {
+    mean_x += static_cast<double>(rtp_[i] - rtp_[newest_]);
+    mean_y += ntp_ms_[i];
+  }
+  mean_x /= count_;
+  mean_y /= count_;
+  double cov = 0.0, var = 0.0;
+  for (int i = 0; i < count_; ++i) {
+    double dx = static_cast<double>(rtp_[i] - rtp_[newest_]) - mean_x;
+    cov += dx * (ntp_ms_[i] - mean_y);
+    var += dx * dx;
+  }
+  if (var <= 0.0) return;
+  double slope = cov / var;
+  if (std::fabs(slope / nominal - 1.0) > kMaxClockError) return;
+  slope_ = slope;
+  offset_ms_ = mean_y - slope * mean_x;
+}
+
+double RtpToNtpEstimator::Estimate(uint32_t rtp_timestamp) const {
+  if (count_ == 0) return 0.0;
+  return offset_ms_ +
+         slope_ * static_cast<double>(Unwrap(rtp_timestamp) - rtp_[newest_]);
+}
+
+}  // namespace vc
@@ -0,0 +1,44 @@
+#ifndef VCMEDIA_SYNC_RTP_TO_NTP_ESTIMATOR_H_
+#define VCMEDIA_SYNC_RTP_TO_NTP_ESTIMATOR_H_
+
+#include <cstdint>
+
+namespace vc {
+
+// Converts a 64-bit RTCP NTP timestamp (32.32 fixed point) to milliseconds.
+double NtpToMs(uint64_t ntp);
+
+// Maps a stream's RTP timestamps to the sender's NTP wall clock using the
+// (NTP, RTP) pairs in RTCP sender reports. With two or more reports the
+// mapping is a least-squares fit, which absorbs small clock rate errors.
+class RtpToNtpEstimator {
+ public:
+  explicit RtpToNtpEstimator(int clock_rate_hz);
+
+  // Returns false if the report is inconsistent with the previous ones
+  // (e.g. the stream was restarted); the history is then reset.
+  bool OnSenderReport(double ntp_ms, uint32_t rtp_timestamp);
+
+  bool valid() const { return count_ > 0; }
+  // Sender wall-clock time in ms at which `rtp_timestamp` was captured.
+  double Estimate(uint32_t rtp_timestamp) const;
+
+ private:
+  static constexpr int kMaxReports = 4;
+
+  int64_t Unwrap(uint32_t rtp_timestamp) const;
+  void Fit();
+
+  const int clock_rate_hz_;
+  double ntp_ms_[kMaxReports] = {};
+  int64_t rtp_[kMaxReports] = {};
+  int count_ = 0;
+  int newest_ = -1;
+  // ntp_ms = offset_ms_ + slope_ * (rtp - rtp_[newest_]).
+  double slope_ = 0.0;
+  double offset_ms_ = 0.0;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_SYNC_RTP_TO_NTP_ESTIMATOR_H_
@@ -0,0 +1,232 @@
+// Runs the capture -> AGC -> playout loop through the host audio device
+// backends: free-running on the file backend for throughput, and in real time
+// on the null and file backends for callback jitter and underruns. Also
+// checks restarting after the input runs out and WAV chunk padding.
+//
+//   audio_device_bench [--check]
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include "audio/audio_device.h"
+#include "audio/automatic_gain_control.h"
+#include "audio/capture_chain.h"
+#include "audio/wav_file.h"
+
+namespace {
+
+constexpr int kSampleRate = 48000;
+constexpr int kFrame = kSampleRate / 100;
+constexpr double kPi = 3.14159265358979323846;
+
+// Loops processed capture audio straight back to both playout channels.
+class LoopbackTransport : public vc::AudioTransport {
+ public:
+  LoopbackTransport() : frame_(kFrame) { chain_.SetGainControl(&agc_); }
+
+  void OnCapturedFrame(const float* samples, int frames) override {
+    std::copy(samples, samples + frames, frame_.begin());
+    chain_.ProcessFrame(frame_.data(), frames);
+    ++captured_;
+  }
+
+  void OnPlayoutFrame(float* samples, int frames, int channels) override {
+    for (int i = 0; i < frames; ++i) {
+      for (int c = 0; c < channels; ++c) samples[i * channels + c] = frame_[i];
+    }
+  }
+
+  long long captured() const { return captured_; }
+
+ private:
+  vc::AutomaticGainControl agc_;
+  vc::CaptureChain chain_;
+  std::vector<float> frame_;
+  long long captured_ = 0;
+};
+
+void WriteTestInput(const std::string& path, int seconds) {
+  vc::WavWriter writer;
+  writer.Open(path, kSampleRate, 1);
+  std::vector<float> frame(kFrame);
+  for (int f = 0; f < seconds * 100; ++f) {
+    for (int i = 0; i < kFrame; ++i) {
+      double t = static_cast<double>(f * kFrame + i) / kSampleRate;
+      frame[i] = static_cast<float>(0.05 * std::sin(2 * kPi * 220 * t) *
+                                    (0.5 + 0.5 * std::sin(2 * kPi * 3 * t)));
+    }
+    writer.Write(frame.data(), kFrame);
+  }
+}
+
+void PrintStats(const char* name, const vc::AudioDeviceStats& s,
+                double seconds) {
+  std::printf("%-22s %7llu %10.2f %10.1f %10.1f %10.2f %10.2f %7llu %7llu\n",
+              name, static_cast<unsigned long long>(s.frames),
+              s.frames / 100.0 / seconds, s.mean_jitter_us, s.max_jitter_us,
+              s.mean_callback_us, s.max_callback_us,
+              static_cast<unsigned long long>(s.playout_underruns),
+              static_cast<unsigned long long>(s.capture_underruns));
+}
+
+bool RunUntilDone(vc::AudioDevice* device, LoopbackTransport* transport,
+                  double max_seconds, double* seconds) {
+  auto start = std::chrono::steady_clock::now();
+  if (!device->Start(transport)) return false;
+  while (device->Playing()) {
+    *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             start).count();
+    if (*seconds >= max_seconds) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  device->Stop();
+  *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                           start).count();
+  return true;
+}
+
+// A non-looping file input that runs out ends the run on its own; starting
+// the device again must work without a Stop() in between.
+bool CheckRestartAfterEndOfInput(const std::string& input) {
+  vc::AudioDeviceConfig config;
+  config.realtime = false;
+  config.input_path = input;
+  auto device = vc::CreateAudioDevice(vc::AudioDeviceBackend::kFile, config);
+  LoopbackTransport transport;
+  for (int run = 0; run < 2; ++run) {
+    if (!device || !device->Start(&transport)) return false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (device->Playing()) {
+      if (std::chrono::steady_clock::now() > deadline) return false;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  }
+  device->Stop();
+  return true;
+}
+
+// Odd-sized chunks are followed by a pad byte, here after a LIST chunk and
+// an extended fmt chunk ahead of the data.
+bool CheckOddSizedChunks(const std::string& path) {
+  const uint8_t list[] = {'L', 'I', 'S', 'T', 5, 0, 0, 0, 'I', 'N', 'F', 'O', 'x', 0};
+  const uint8_t fmt[] = {'f', 'm', 't', ' ', 17, 0, 0, 0,
+                         1, 0, 1, 0, 0x80, 0xbb, 0, 0, 0, 0x77, 1, 0, 2, 0, 16, 0,
+                         0, 0};
+  const int16_t samples[] = {16384, -16384, 16384, -16384};
+  uint8_t data[8] = {'d', 'a', 't', 'a', sizeof(samples), 0, 0, 0};
+  const uint32_t riff_size = 4 + sizeof(list) + sizeof(fmt) + sizeof(data) + sizeof(samples);
+  uint8_t riff[12] = {'R', 'I', 'F', 'F',
+                      static_cast<uint8_t>(riff_size), 0, 0, 0,
+                      'W', 'A', 'V', 'E'};
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+  std::fwrite(riff, 1, sizeof(riff), f);
+  std::fwrite(list, 1, sizeof(list), f);
+  std::fwrite(fmt, 1, sizeof(fmt), f);
+  std::fwrite(data, 1, sizeof(data), f);
+  std::fwrite(samples, 1, sizeof(samples), f);
+  std::fclose(f);
+
+  vc::WavReader reader;
+  // Opened twice: the second Open() replaces the first file.
+  if (!reader.Open(path) || !reader.Open(path)) return false;
+  float out[4] = {};
+  return reader.sample_rate() == kSampleRate && reader.channels() == 1 &&
+         reader.frames() == 4 && reader.ReadMono(out, 4) == 4 && out[0] == 0.5f &&
+         out[1] == -0.5f;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  const int input_seconds = check ? 10 : 60;
+  const double realtime_seconds = check ? 1.0 : 10.0;
+  bool ok = true;
+
+  auto dir = std::filesystem::temp_directory_path();
+  std::string input = (dir / "vcmedia_bench_in.wav").string();
+  std::string output = (dir / "vcmedia_bench_out.wav").string();
+  WriteTestInput(input, input_seconds);
+
+  std::printf("%-22s %7s %10s %10s %10s %10s %10s %7s %7s\n", "backend",
+              "frames", "x_realtime", "jit_avg_us", "jit_max_us", "cb_avg_us",
+              "cb_max_us", "p_xrun", "c_xrun");
+
+  {
+    vc::AudioDeviceConfig config;
+    config.realtime = false;
+    config.input_path = input;
+    config.output_path = output;
+    auto device = vc::CreateAudioDevice(vc::AudioDeviceBackend::kFile, config);
+    LoopbackTransport transport;
+    double seconds = 0.0;
+    if (!device || !RunUntilDone(device.get(), &transport, 60.0, &seconds)) {
+      std::printf("FAIL: could not run file backend\n");
+      return 1;
+    }
+    vc::AudioDeviceStats stats = device->GetStats();
+    device.reset();  // Finalises the output file.
+    // Jitter is meaningless when not paced; only callback cost matters here.
+    stats.mean_jitter_us = stats.max_jitter_us = 0.0;
+    PrintStats("file (free-running)", stats, seconds);
+    vc::WavReader reader;
+    if (transport.captured() != input_seconds * 100 || !reader.Open(output) ||
+        reader.frames() != static_cast<int64_t>(input_seconds) * kSampleRate ||
+        reader.channels() != 2) {
+      std::printf("FAIL: file backend did not process the whole input\n");
+      ok = false;
+    }
+  }
+
+  const struct {
+    const char* name;
+    vc::AudioDeviceBackend backend;
+  } realtime[] = {
+      {"null (realtime)", vc::AudioDeviceBackend::kNull},
+      {"file (realtime)", vc::AudioDeviceBackend::kFile},
+  };
+  for (const auto& r : realtime) {
+    vc::AudioDeviceConfig config;
+    config.input_path = input;
+    config.output_path = output;
+    config.loop_input = true;
+    auto device = vc::CreateAudioDevice(r.backend, config);
+    LoopbackTransport transport;
+    double seconds = 0.0;
+    if (!device || !RunUntilDone(device.get(), &transport, realtime_seconds,
+                                 &seconds)) {
+      std::printf("FAIL: could not run %s\n", r.name);
+      ok = false;
+      continue;
+    }
+    vc::AudioDeviceStats stats = device->GetStats();
+    PrintStats(r.name, stats, seconds);
+    double expected = seconds * 100.0;
+    if (std::fabs(stats.frames - expected) > expected * 0.1) {
+      std::printf("  FAIL: %llu callbacks in %.2f s, expected ~%.0f\n",
+                  static_cast<unsigned long long>(stats.frames), seconds,
+                  expected);
+      ok = false;
+    }
+  }
+
+  if (!CheckRestartAfterEndOfInput(input)) {
+    std::printf("  FAIL: could not restart after the input ran out\n");
+    ok = false;
+  }
+  if (!CheckOddSizedChunks(output)) {
+    std::printf("  FAIL: misread a WAV file with odd-sized chunks\n");
+    ok = false;
+  }
+
+  std::filesystem::remove(input);
+  std::filesystem::remove(output);
+  return check && !ok ? 1 : 0;
+}
@@ -0,0 +1,205 @@
+// Simulates one participant's audio and video arriving over separate jitter
+// buffers whose delays follow changing network jitter, and reports the A/V
+// offset at playout over time with and without AvSynchronizer.
+//
+//   av_sync_sim [--check]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "sync/av_synchronizer.h"
+
+namespace {
+
+constexpr int kAudioClock = 48000;
+constexpr int kVideoClock = 90000;
+constexpr double kAudioFrameMs = 20.0;
+constexpr double kVideoFrameMs = 1000.0 / 30.0;
+constexpr double kSimulationMs = 120000.0;
+constexpr double kStepMs = 10.0;
+constexpr double kSyncIntervalMs = 200.0;
+constexpr double kSenderReportIntervalMs = 1000.0;
+// The sender's wall clock is this far ahead of ours; sync must not care.
+constexpr double kClockOffsetMs = 12345.0;
+// ITU-R BT.1359 detectability window: audio may lead video by 45 ms and lag
+// it by 125 ms. Offsets here are video minus audio playout time.
+constexpr double kMaxAudioLeadMs = 45.0;
+constexpr double kMaxAudioLagMs = 125.0;
+
+struct Phase {
+  double until_ms;
+  double audio_jitter_ms;
+  double video_jitter_ms;
+};
+
+const Phase kPhases[] = {
+    {30000, 5, 10},   // Calm.
+    {60000, 5, 45},   // Congested uplink hits large video frames.
+    {90000, 30, 15},  // Wi-Fi retransmissions hit audio.
+    {120000, 5, 10},  // Calm again.
+};
+
+const Phase& PhaseAt(double t) {
+  for (const Phase& p : kPhases) {
+    if (t < p.until_ms) return p;
+  }
+  return kPhases[3];
+}
+
+// Jitter buffer whose target delay follows the 95th percentile of recent
+// arrival jitter: grows at once, shrinks slowly.
+class JitterBuffer {
+ public:
+  explicit JitterBuffer(double base_delay_ms) : base_delay_ms_(base_delay_ms) {}
+
+  void OnArrival(double now_ms, double jitter_ms) {
+    window_.push_back({now_ms, jitter_ms});
+    while (!window_.empty() && window_.front().first < now_ms - 2000.0) {
+      window_.pop_front();
+    }
+    std::vector<double> v;
+    for (const auto& s : window_) v.push_back(s.second);
+    std::sort(v.begin(), v.end());
+    double p95 = v[static_cast<size_t>(0.95 * (v.size() - 1))] + 10.0;
+    target_ms_ = p95 > target_ms_ ? p95 : std::max(p95, target_ms_ - 0.5);
+  }
+
+  double target_ms() const { return target_ms_; }
+  double base_delay_ms() const { return base_delay_ms_; }
+
+ private:
+  double base_delay_ms_;
+  double target_ms_ = 20.0;
+  std::deque<std::pair<double, double>> window_;
+};
+
+struct Sample {
+  double t;
+  double offset_unsynced;
+  double offset_synced;
+  int extra_audio;
+  int extra_video;
+  double audio_jb;
+  double video_jb;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+
+  std::mt19937 rng(42);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  const uint32_t audio_rtp_base = 0x9abc0000u;
+  const uint32_t video_rtp_base = 0xfff00000u;  // Wraps during the run.
+  auto audio_rtp = [&](double capture_ms) {
+    return audio_rtp_base + static_cast<uint32_t>(
+        std::llround(capture_ms * kAudioClock / 1000.0));
+  };
+  auto video_rtp = [&](double capture_ms) {
+    return video_rtp_base + static_cast<uint32_t>(
+        std::llround(capture_ms * kVideoClock / 1000.0));
+  };
+
+  JitterBuffer audio_jb(40.0);  // Audio takes the short path.
+  JitterBuffer video_jb(70.0);  // Video is paced and larger.
+  vc::AvSynchronizer sync(kAudioClock, kVideoClock);
+  vc::AvSynchronizer::StreamTiming audio_timing, video_timing;
+
+  double next_audio = 0.0, next_video = 0.0, next_sr = 0.0, next_sync = 0.0;
+  int previous_extra_audio = 0, previous_extra_video = 0, max_step = 0;
+  std::vector<Sample> samples;
+
+  for (double now = 0.0; now < kSimulationMs; now += kStepMs) {
+    const Phase& phase = PhaseAt(now);
+
+    if (now >= next_sr) {
+      sync.OnAudioSenderReport(now + kClockOffsetMs, audio_rtp(now));
+      sync.OnVideoSenderReport(now + kClockOffsetMs, video_rtp(now));
+      next_sr += kSenderReportIntervalMs;
+    }
+    // Frames captured at `next_*` arrive after base delay plus jitter; the
+    // simulation hands them over at the step in which they were captured.
+    while (next_audio <= now) {
+      double jitter = std::fabs(normal(rng)) * phase.audio_jitter_ms;
+      audio_jb.OnArrival(now, jitter);
+      audio_timing.rtp_timestamp = audio_rtp(next_audio);
+      audio_timing.receive_time_ms = std::llround(
+          next_audio + audio_jb.base_delay_ms() + jitter);
+      next_audio += kAudioFrameMs;
+    }
+    while (next_video <= now) {
+      double jitter = std::fabs(normal(rng)) * phase.video_jitter_ms;
+      video_jb.OnArrival(now, jitter);
+      video_timing.rtp_timestamp = video_rtp(next_video);
+      video_timing.receive_time_ms = std::llround(
+          next_video + video_jb.base_delay_ms() + jitter);
+      next_video += kVideoFrameMs;
+    }
+
+    if (now >= next_sync) {
+      audio_timing.current_delay_ms = static_cast<int>(audio_jb.target_ms());
+      video_timing.current_delay_ms = static_cast<int>(video_jb.target_ms());
+      sync.Update(audio_timing, video_timing);
+      const vc::AvSynchronizer::Delays& d = sync.delays();
+      max_step = std::max({max_step,
+                           std::abs(d.extra_audio_delay_ms - previous_extra_audio),
+                           std::abs(d.extra_video_delay_ms - previous_extra_video)});
+      previous_extra_audio = d.extra_audio_delay_ms;
+      previous_extra_video = d.extra_video_delay_ms;
+      next_sync += kSyncIntervalMs;
+    }
+
+    // Playout schedule: capture + transit floor + jitter buffer target.
+    const vc::AvSynchronizer::Delays& d = sync.delays();
+    double audio_playout = audio_jb.base_delay_ms() + audio_jb.target_ms();
+    double video_playout = video_jb.base_delay_ms() + video_jb.target_ms();
+    double unsynced = video_playout - audio_playout;
+    double synced = unsynced + d.extra_video_delay_ms - d.extra_audio_delay_ms;
+    samples.push_back({now, unsynced, synced, d.extra_audio_delay_ms,
+                       d.extra_video_delay_ms, audio_jb.target_ms(),
+                       video_jb.target_ms()});
+  }
+
+  std::printf("%6s %9s %9s %11s %11s %9s %9s\n", "t_s", "audio_jb",
+              "video_jb", "offset_off", "offset_on", "extra_a", "extra_v");
+  for (const Sample& s : samples) {
+    if (std::fmod(s.t, check ? 10000.0 : 2000.0) != 0.0) continue;
+    std::printf("%6.0f %9.1f %9.1f %11.1f %11.1f %9d %9d\n", s.t / 1000.0,
+                s.audio_jb, s.video_jb, s.offset_unsynced, s.offset_synced,
+                s.extra_audio, s.extra_video);
+  }
+
+  auto summarize = [&](bool synced, double* mean_abs, double* in_window) {
+    int n = 0, ok = 0;
+    double sum = 0.0;
+    for (const Sample& s : samples) {
+      if (s.t < 5000.0) continue;  // Initial convergence.
+      double o = synced ? s.offset_synced : s.offset_unsynced;
+      sum += std::fabs(o);
+      ok += o <= kMaxAudioLeadMs && o >= -kMaxAudioLagMs;
+      ++n;
+    }
+    *mean_abs = sum / n;
+    *in_window = 100.0 * ok / n;
+  };
+  double off_mean, off_window, on_mean, on_window;
+  summarize(false, &off_mean, &off_window);
+  summarize(true, &on_mean, &on_window);
+  std::printf("\nwithout sync: mean |offset| %.1f ms, %.1f%% within "
+              "[-%.0f, +%.0f] ms\n", off_mean, off_window, kMaxAudioLagMs,
+              kMaxAudioLeadMs);
+  std::printf("with sync:    mean |offset| %.1f ms, %.1f%% within "
+              "[-%.0f, +%.0f] ms, largest delay step %d ms\n", on_mean,
+              on_window, kMaxAudioLagMs, kMaxAudioLeadMs, max_step);
+
+  bool ok = on_window >= 95.0 && on_mean < off_mean &&
+            max_step <= vc::AvSynchronizer::Config().max_step_ms;
+  if (!ok) std::printf("FAIL: synchronizer did not keep A/V in the window\n");
+  return check && !ok ? 1 : 0;
+}
@@ -0,0 +1,359 @@
+// Runs the background effect over a synthetic 720p call scene: a textured
+// background and a moving person-shaped ellipse. With a ground-truth
+// segmenter it verifies that the person is left untouched, the background is
+// blurred (or replaced) and that steady-state frames do not allocate. With the
+// int8 segmentation model (random weights, same shapes and cost as the
+// shipped one) it reports per-stage ms/frame and checks the total against the
+// 30 fps frame budget. Also checks that a rotated frame gets a rescaled
+// mask and that a model without a single-channel output is rejected.
+//
+//   background_blur_bench [--check]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "tools/cpu_time.h"
+#include "video/background_effect.h"
+#include "video/i420_frame.h"
+#include "video/int8_conv_net.h"
+#include "video/person_segmenter.h"
+
+namespace {
+
+long long g_allocations = 0;
+
+constexpr int kWidth = 1280;
+constexpr int kHeight = 720;
+constexpr int kMaskWidth = 160;
+constexpr int kMaskHeight = 96;
+constexpr double kFrameBudgetMs = 1000.0 / 30.0;
+constexpr double kPi = 3.14159265358979323846;
+
+struct Ellipse {
+  double cx, cy, rx, ry;
+
+  // Normalised radius: <1 inside.
+  double Radius(double x, double y) const {
+    double dx = (x - cx) / rx;
+    double dy = (y - cy) / ry;
+    return std::sqrt(dx * dx + dy * dy);
+  }
+};
+
+Ellipse PersonAt(int frame) {
+  return {kWidth / 2 + 160 * std::sin(2 * kPi * frame / 300.0), kHeight * 0.6,
+          190, 300};
+}
+
+class Scene {
+ public:
+  Scene() : texture_(static_cast<size_t>(kWidth) * kHeight) {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> noise(-24, 24);
+    for (int y = 0; y < kHeight; ++y) {
+      for (int x = 0; x < kWidth; ++x) {
+        // Bookshelf-like stripes and checks with sensor noise.
+        int v = 110 + 50 * (((x / 24) + (y / 40)) & 1) +
+                static_cast<int>(30 * std::sin(x * 0.21)) + noise(rng);
+        texture_[static_cast<size_t>(y) * kWidth + x] =
+            static_cast<uint8_t>(std::min(255, std::max(0, v)));
+      }
+    }
+  }
+
+  void Render(int frame, vc::I420Frame* out) const {
+    const Ellipse person = PersonAt(frame);
+    for (int y = 0; y < kHeight; ++y) {
+      uint8_t* row = out->y() + static_cast<size_t>(y) * out->stride_y();
+      for (int x = 0; x < kWidth; ++x) {
+        if (person.Radius(x, y) < 1.0) {
+          row[x] = static_cast<uint8_t>(150 + ((x + y) & 15));
+        } else {
+          row[x] = texture_[static_cast<size_t>(y) * kWidth + x];
+        }
+      }
+    }
+    for (int y = 0; y < out->chroma_height(); ++y) {
+      uint8_t* u = out->u() + static_cast<size_t>(y) * out->stride_uv();
+      uint8_t* v = out->v() + static_cast<size_t>(y) * out->stride_uv();
+      for (int x = 0; x < out->chroma_width(); ++x) {
+        bool skin = person.Radius(2 * x, 2 * y) < 1.0;
+        u[x] = static_cast<uint8_t>(skin ? 110 : 128 + ((x / 12) & 1) * 20);
+        v[x] = static_cast<uint8_t>(skin ? 155 : 120 + ((y / 20) & 1) * 16);
+      }
+    }
+  }
+
+ private:
+  std::vector<uint8_t> texture_;
+};
+
+// Knows where the person is; stands in for a perfectly trained model.
+class GroundTruthSegmenter : public vc::PersonSegmenter {
+ public:
+  int input_width() const override { return kMaskWidth; }
+  int input_height() const override { return kMaskHeight; }
+  void Segment(const vc::I420Frame&, uint8_t* mask) override {
+    const Ellipse person = PersonAt(frame);
+    const double sx = static_cast<double>(kWidth) / kMaskWidth;
+    const double sy = static_cast<double>(kHeight) / kMaskHeight;
+    for (int y = 0; y < kMaskHeight; ++y) {
+      for (int x = 0; x < kMaskWidth; ++x) {
+        mask[y * kMaskWidth + x] =
+            person.Radius((x + 0.5) * sx, (y + 0.5) * sy) < 1.0 ? 255 : 0;
+      }
+    }
+  }
+
+  int frame = 0;
+};
+
+// Sum of absolute horizontal luma differences over pixels selected by `keep`.
+template <typename Keep>
+double GradientEnergy(const vc::I420Frame& f, Keep keep) {
+  double sum = 0.0;
+  for (int y = 0; y < f.height(); y += 2) {
+    const uint8_t* row = f.y() + static_cast<size_t>(y) * f.stride_y();
+    for (int x = 0; x + 1 < f.width(); x += 2) {
+      if (keep(x, y)) sum += std::abs(row[x + 1] - row[x]);
+    }
+  }
+  return sum;
+}
+
+struct Quality {
+  int max_foreground_error = 0;
+  double background_gradient_ratio = 0.0;
+  int max_replacement_error = 0;
+  long long steady_allocations = 0;
+};
+
+Quality RunQuality(vc::BackgroundEffect::Mode mode, int frames) {
+  Scene scene;
+  GroundTruthSegmenter segmenter;
+  vc::BackgroundEffect::Config config;
+  config.mode = mode;
+  // Correctness run: segment every frame regardless of timing.
+  config.budget_ms = 1e9;
+  vc::BackgroundEffect effect(&segmenter, config);
+
+  vc::I420Frame replacement(kWidth, kHeight);
+  for (int y = 0; y < kHeight; ++y) {
+    std::memset(replacement.y() + static_cast<size_t>(y) * kWidth,
+                40 + y * 160 / kHeight, kWidth);
+  }
+  std::memset(replacement.u(), 140, replacement.chroma_width() * replacement.chroma_height());
+  std::memset(replacement.v(), 100, replacement.chroma_width() * replacement.chroma_height());
+  effect.SetReplacement(replacement);
+
+  vc::I420Frame input(kWidth, kHeight);
+  vc::I420Frame frame(kWidth, kHeight);
+  Quality q;
+  double in_energy = 0.0, out_energy = 0.0;
+  for (int i = 0; i < frames; ++i) {
+    scene.Render(i, &input);
+    std::memcpy(frame.y(), input.y(), input.size_bytes());
+    segmenter.frame = i;
+    long long before = g_allocations;
+    effect.Process(&frame);
+    if (i > 0) q.steady_allocations += g_allocations - before;
+
+    // Skip the first frames while the temporal filter settles.
+    if (i < 20) continue;
+    const Ellipse person = PersonAt(i);
+    auto core = [&](int x, int y) { return person.Radius(x, y) < 0.8; };
+    auto outside = [&](int x, int y) { return person.Radius(x, y) > 1.25; };
+    for (int y = 0; y < kHeight; ++y) {
+      for (int x = 0; x < kWidth; ++x) {
+        size_t k = static_cast<size_t>(y) * kWidth + x;
+        if (core(x, y)) {
+          q.max_foreground_error = std::max(
+              q.max_foreground_error, std::abs(frame.y()[k] - input.y()[k]));
+        } else if (outside(x, y) && mode == vc::BackgroundEffect::Mode::kReplace) {
+          q.max_replacement_error = std::max(
+              q.max_replacement_error, std::abs(frame.y()[k] - replacement.y()[k]));
+        }
+      }
+    }
+    in_energy += GradientEnergy(input, outside);
+    out_energy += GradientEnergy(frame, outside);
+  }
+  q.background_gradient_ratio = in_energy > 0 ? out_energy / in_energy : 0.0;
+  return q;
+}
+
+// Marks the left half of its input as the person.
+class LeftHalfSegmenter : public vc::PersonSegmenter {
+ public:
+  int input_width() const override { return 32; }
+  int input_height() const override { return 32; }
+  void Segment(const vc::I420Frame&, uint8_t* mask) override {
+    for (int y = 0; y < 32; ++y) {
+      for (int x = 0; x < 32; ++x) mask[y * 32 + x] = x < 16 ? 255 : 0;
+    }
+  }
+};
+
+// Turning a frame from landscape to portrait keeps its area; the mask must
+// still be rescaled to the new shape, also on a frame that reuses the last
+// segmentation. Returns the largest luma error away from the person's edge.
+int RotatedFrameError() {
+  LeftHalfSegmenter segmenter;
+  vc::BackgroundEffect::Config config;
+  config.mode = vc::BackgroundEffect::Mode::kReplace;
+  // Always over budget: segmentation backs off to every fourth frame, and
+  // the fifth frame (the first portrait one) is not segmented.
+  config.budget_ms = 0.0;
+  vc::BackgroundEffect effect(&segmenter, config);
+  vc::I420Frame replacement(16, 16);
+  std::memset(replacement.y(), 16, replacement.size_bytes());
+  effect.SetReplacement(replacement);
+
+  int max_error = 0;
+  const int sizes[][2] = {
+      {640, 360}, {640, 360}, {640, 360}, {640, 360}, {360, 640}};
+  for (const auto& size : sizes) {
+    const int w = size[0];
+    const int h = size[1];
+    vc::I420Frame frame(w, h);
+    std::memset(frame.y(), 200, frame.size_bytes());
+    effect.Process(&frame);
+    for (int y = 0; y < h; ++y) {
+      const uint8_t* row = frame.y() + static_cast<size_t>(y) * frame.stride_y();
+      for (int x = 0; x < w; ++x) {
+        if (std::abs(x - w / 2) < w / 8) continue;
+        const int expected = x < w / 2 ? 200 : 16;
+        max_error = std::max(max_error, std::abs(row[x] - expected));
+      }
+    }
+  }
+  return max_error;
+}
+
+// A model whose head emits more than one channel cannot be read as a mask.
+bool RejectsMultiChannelModel() {
+  vc::Int8ConvNet net = vc::CreateSyntheticSegmentationNet(7);
+  vc::Int8ConvNet::Layer head;
+  head.in_channels = 1;
+  head.out_channels = 2;
+  head.weights = {64, -64};
+  head.bias = {0, 0};
+  head.multiplier = {1 << 24, 1 << 24};
+  head.shift = {30, 30};
+  net.AddLayer(std::move(head));
+  vc::Int8PersonSegmenter segmenter;
+  return !segmenter.Init(std::move(net), kMaskWidth, kMaskHeight);
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  ++g_allocations;
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  const int quality_frames = check ? 40 : 120;
+  const int timing_frames = check ? 60 : 300;
+  bool ok = true;
+
+  std::printf("%-8s %10s %12s %12s %7s\n", "mode", "fg_err", "bg_grad", "repl_err",
+              "allocs");
+  const struct {
+    const char* name;
+    vc::BackgroundEffect::Mode mode;
+  } modes[] = {{"blur", vc::BackgroundEffect::Mode::kBlur},
+               {"replace", vc::BackgroundEffect::Mode::kReplace}};
+  for (const auto& m : modes) {
+    Quality q = RunQuality(m.mode, quality_frames);
+    std::printf("%-8s %10d %12.3f %12d %7lld\n", m.name, q.max_foreground_error,
+                q.background_gradient_ratio, q.max_replacement_error,
+                q.steady_allocations);
+    if (q.max_foreground_error > 2) {
+      std::printf("  FAIL: person pixels were modified\n");
+      ok = false;
+    }
+    if (m.mode == vc::BackgroundEffect::Mode::kBlur &&
+        q.background_gradient_ratio > 0.5) {
+      std::printf("  FAIL: background not blurred\n");
+      ok = false;
+    }
+    if (m.mode == vc::BackgroundEffect::Mode::kReplace &&
+        q.max_replacement_error > 2) {
+      std::printf("  FAIL: background not replaced\n");
+      ok = false;
+    }
+    if (q.steady_allocations != 0) {
+      std::printf("  FAIL: steady-state frames allocated\n");
+      ok = false;
+    }
+  }
+
+  const int rotated_error = RotatedFrameError();
+  if (rotated_error > 2) {
+    std::printf("  FAIL: mask not rescaled for a rotated frame (error %d)\n",
+                rotated_error);
+    ok = false;
+  }
+  if (!RejectsMultiChannelModel()) {
+    std::printf("  FAIL: accepted a model with a multi-channel output\n");
+    ok = false;
+  }
+
+  // Cost with the int8 model at the shipped input size.
+  vc::Int8PersonSegmenter segmenter;
+  if (!segmenter.Init(vc::CreateSyntheticSegmentationNet(7), kMaskWidth,
+                      kMaskHeight)) {
+    std::printf("FAIL: could not initialise the segmentation model\n");
+    return 1;
+  }
+  Scene scene;
+  vc::I420Frame frame(kWidth, kHeight);
+  for (int adaptive = 0; adaptive < 2; ++adaptive) {
+    vc::BackgroundEffect::Config config;
+    if (!adaptive) config.budget_ms = 1e9;
+    vc::BackgroundEffect effect(&segmenter, config);
+    // The budget check uses thread CPU time; the effect's own stage
+    // timings are wall clock.
+    double cpu_ms = 0.0;
+    for (int i = 0; i < timing_frames; ++i) {
+      scene.Render(i, &frame);
+      double start = vc::CpuNowMs();
+      effect.Process(&frame);
+      if (i > 4) cpu_ms += vc::CpuNowMs() - start;
+      if (i == 4) effect.ResetStats();  // Exclude warm-up.
+    }
+    const vc::BackgroundEffect::Stats& s = effect.stats();
+    const double n = s.frames;
+    if (adaptive) {
+      std::printf("\nadaptive segmentation (budget %.1f ms)", config.budget_ms);
+    } else {
+      std::printf("\nsegment every frame");
+    }
+    std::printf(", ms/frame at %dx%d over %d frames:\n", kWidth, kHeight,
+                s.frames);
+    std::printf("  scale %.2f  segment %.2f  refine %.2f  background %.2f  "
+                "composite %.2f  total %.2f\n",
+                s.scale_ms / n, s.segment_ms / n, s.refine_ms / n,
+                s.background_ms / n, s.composite_ms / n, s.total_ms / n);
+    std::printf("  cpu %.2f, segmentations %d, final interval %d\n",
+                cpu_ms / n, s.segmentations, s.segmentation_interval);
+    if (cpu_ms / n > kFrameBudgetMs) {
+      std::printf("  FAIL: exceeds the %.1f ms frame budget\n", kFrameBudgetMs);
+      ok = false;
+    }
+  }
+  return check && !ok ? 1 : 0;
+}
@@ -0,0 +1,223 @@
+// Simulates a low-end phone sending 720p30 while the number of decoded
+// tiles (and so the CPU left for encoding) changes over a call, including a
+// period of thermal throttling. Encode time scales with pixels and inversely
+// with available CPU, with frame-to-frame noise. Compares a fixed operating
+// point with the overuse detector driving each degradation preference, and
+// reports dropped frames, encode latency, adaptation count, oscillations
+// and a quality score of the chosen operating points.
+//
+//   cpu_adaptation_sim [--check]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "video/cpu_overuse_detector.h"
+#include "video/degradation_ladder.h"
+
+namespace {
+
+constexpr int kWidth = 1280;
+constexpr int kHeight = 720;
+constexpr int kFramerate = 30;
+// Encode time of one 720p frame with the whole core available.
+constexpr double kEncodeMs720p = 12.0;
+
+struct Phase {
+  double until_s;
+  const char* name;
+  // CPU consumed by decoding and rendering, relative to the encoder's share.
+  double decode_load;
+  double throttle;
+};
+
+const Phase kPhases[] = {
+    {60, "4 tiles", 0.4, 1.0},
+    {150, "9 tiles", 1.4, 1.0},
+    {180, "9 tiles, throttled", 1.4, 0.7},
+    {300, "1 tile", 0.1, 1.0},
+};
+
+const Phase& PhaseAt(double t) {
+  for (const Phase& p : kPhases) {
+    if (t < p.until_s) return p;
+  }
+  return kPhases[std::size(kPhases) - 1];
+}
+
+// Relative perceptual quality of an operating point: resolution and frame
+// rate both matter, with diminishing returns.
+double Quality(const vc::OperatingPoint& p) {
+  double pixels = static_cast<double>(p.width) * p.height / (kWidth * kHeight);
+  return 100.0 * std::pow(pixels, 0.3) * std::pow(p.framerate / 30.0, 0.5);
+}
+
+struct Result {
+  int captured = 0;
+  int dropped = 0;
+  int late = 0;
+  double mean_latency_ms = 0.0;
+  double mean_quality = 0.0;
+  int adaptations = 0;
+  int oscillations = 0;
+  int final_level = 0;
+  std::map<int, double> seconds_at_level;
+  double dropped_under_load_percent = 0.0;
+};
+
+Result Simulate(const vc::DegradationPreference* preference, double seconds,
+                uint32_t seed, bool verbose) {
+  vc::DegradationLadder ladder(kWidth, kHeight, kFramerate,
+                               preference ? *preference
+                                          : vc::DegradationPreference::kBalanced);
+  vc::CpuOveruseDetector detector;
+  std::mt19937 rng(seed);
+  std::lognormal_distribution<double> noise(0.0, 0.15);
+
+  Result r;
+  double t = 0.0;
+  double encoder_free_s = 0.0;
+  double latency_sum = 0.0, quality_sum = 0.0;
+  int encoded = 0;
+  int load_frames = 0, load_dropped = 0;
+  double last_up_s = -1e9;
+  while (t < seconds) {
+    const vc::OperatingPoint& point = ladder.current();
+    const double interval = 1.0 / point.framerate;
+    const Phase& phase = PhaseAt(t);
+    ++r.captured;
+    r.seconds_at_level[ladder.level()] += interval;
+    quality_sum += Quality(point) * interval;
+    const bool under_load = phase.decode_load > 1.0;
+    load_frames += under_load;
+
+    // One encoder thread; a frame arriving while another still waits is
+    // dropped.
+    if (encoder_free_s - t > interval) {
+      ++r.dropped;
+      load_dropped += under_load;
+    } else {
+      double pixels = static_cast<double>(point.width) * point.height;
+      double encode_ms = kEncodeMs720p * pixels / (kWidth * kHeight) *
+                         (1.0 + phase.decode_load) / phase.throttle * noise(rng);
+      double start = std::max(t, encoder_free_s);
+      encoder_free_s = start + encode_ms / 1000.0;
+      double latency_ms = (encoder_free_s - t) * 1000.0;
+      latency_sum += latency_ms;
+      r.late += latency_ms > interval * 1000.0;
+      ++encoded;
+      // The encoder reports wall time from capture to output; queueing
+      // behind the previous frame counts as overuse too.
+      detector.OnFrameEncoded(static_cast<int64_t>(t * 1e6),
+                              static_cast<int64_t>(latency_ms * 1000.0));
+    }
+
+    if (preference) {
+      auto action = detector.Check(static_cast<int64_t>(t * 1000.0));
+      bool changed = false;
+      if (action == vc::CpuOveruseDetector::Action::kAdaptDown) {
+        changed = ladder.StepDown();
+        if (changed && t - last_up_s < 15.0) ++r.oscillations;
+      } else if (action == vc::CpuOveruseDetector::Action::kAdaptUp) {
+        changed = ladder.StepUp();
+        if (changed) last_up_s = t;
+      }
+      if (action != vc::CpuOveruseDetector::Action::kNone && !changed) {
+        detector.OnAdaptationRejected(action);
+      }
+      if (changed) {
+        ++r.adaptations;
+        if (verbose) {
+          const vc::OperatingPoint& p = ladder.current();
+          std::printf("    %6.1fs %-20s %s -> %dx%d@%d\n", t, phase.name,
+                      action == vc::CpuOveruseDetector::Action::kAdaptDown
+                          ? "down" : "up  ",
+                      p.width, p.height, p.framerate);
+        }
+      }
+    }
+    t += interval;
+  }
+  r.mean_latency_ms = encoded ? latency_sum / encoded : 0.0;
+  r.mean_quality = quality_sum / t;
+  r.final_level = ladder.level();
+  r.dropped_under_load_percent = load_frames ? 100.0 * load_dropped / load_frames : 0.0;
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  const double seconds = kPhases[std::size(kPhases) - 1].until_s;
+  bool ok = true;
+
+  std::printf("phases:");
+  for (const Phase& p : kPhases) std::printf("  <%.0fs %s", p.until_s, p.name);
+  std::printf("\n\n");
+
+  const vc::DegradationPreference framerate =
+      vc::DegradationPreference::kMaintainFramerate;
+  const vc::DegradationPreference resolution =
+      vc::DegradationPreference::kMaintainResolution;
+  const vc::DegradationPreference balanced = vc::DegradationPreference::kBalanced;
+  const struct {
+    const char* name;
+    const vc::DegradationPreference* preference;
+  } policies[] = {
+      {"fixed", nullptr},
+      {"maintain-framerate", &framerate},
+      {"maintain-resolution", &resolution},
+      {"balanced", &balanced},
+  };
+
+  std::printf("%-20s %8s %9s %7s %10s %8s %7s %6s %6s\n", "policy", "drop%",
+              "drop%load", "late%", "latency_ms", "quality", "adapts", "oscil",
+              "final");
+  Result fixed;
+  for (const auto& policy : policies) {
+    Result r = Simulate(policy.preference, seconds, 21, false);
+    std::printf("%-20s %8.2f %9.2f %7.2f %10.1f %8.1f %7d %6d %6d\n", policy.name,
+                100.0 * r.dropped / r.captured, r.dropped_under_load_percent,
+                100.0 * r.late / r.captured, r.mean_latency_ms, r.mean_quality,
+                r.adaptations, r.oscillations, r.final_level);
+    if (!policy.preference) {
+      fixed = r;
+      continue;
+    }
+    if (r.dropped_under_load_percent > 2.0 ||
+        r.dropped_under_load_percent > fixed.dropped_under_load_percent / 5) {
+      std::printf("  FAIL: still dropping frames under load\n");
+      ok = false;
+    }
+    if (r.oscillations > 3) {
+      std::printf("  FAIL: operating point oscillates\n");
+      ok = false;
+    }
+    if (r.final_level != 0) {
+      std::printf("  FAIL: did not restore full quality after load dropped\n");
+      ok = false;
+    }
+  }
+
+  if (!check) {
+    for (const auto& policy : policies) {
+      if (!policy.preference) continue;
+      std::printf("\n%s adaptations:\n", policy.name);
+      Result r = Simulate(policy.preference, seconds, 21, true);
+      vc::DegradationLadder ladder(kWidth, kHeight, kFramerate, *policy.preference);
+      std::printf("  time per operating point:\n");
+      for (const auto& [level, s] : r.seconds_at_level) {
+        const vc::OperatingPoint& p = ladder.at(level);
+        std::printf("    %4dx%-4d@%-2d %6.1fs  quality %5.1f\n", p.width, p.height,
+                    p.framerate, s, Quality(p));
+      }
+    }
+  }
+  return check && !ok ? 1 : 0;
+}
@@ -0,0 +1,19 @@
+#ifndef VCMEDIA_TOOLS_CPU_TIME_H_
+#define VCMEDIA_TOOLS_CPU_TIME_H_
+
+#include <ctime>
+
+namespace vc {
+
+// CPU time of the calling thread in milliseconds. Benches time the work they
+// compare with it, so their checks hold while ctest runs other tools on the
+// same cores.
+inline double CpuNowMs() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+}  // namespace vc
+
+#endif  // VCMEDIA_TOOLS_CPU_TIME_H_
@@ -0,0 +1,183 @@
+// Replays synthetic loss traces through the RED send and receive path and
+// reports concealment rate against bitrate overhead.
+//
+//   red_loss_sim [--check]
+//
+// With --check the process exits non-zero if adaptive RED fails to cut
+// concealment under loss or costs bitrate on a clean link.
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "audio/audio_bitrate_controller.h"
+#include "audio/red_encoder.h"
+#include "audio/red_receiver.h"
+
+namespace {
+
+constexpr int kFrameMs = 20;
+constexpr uint32_t kTicksPerFrame = 48 * kFrameMs;
+constexpr int kFrames = 60 * 1000 / kFrameMs;
+constexpr int kPlayoutDelayFrames = 3;
+constexpr int kRtcpIntervalFrames = 1000 / kFrameMs;
+constexpr int kBandwidthBps = 96000;
+constexpr int kFixedCodecBitrateBps = 24000;
+
+struct Trace {
+  std::string name;
+  std::vector<bool> lost;
+};
+
+// Two-state Gilbert-Elliott model; `mean_burst` of 0 gives independent loss.
+Trace MakeTrace(const char* name, double loss, double mean_burst,
+                uint32_t seed) {
+  Trace t{name, std::vector<bool>(kFrames, false)};
+  if (loss <= 0.0) return t;
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  double r = mean_burst > 0.0 ? 1.0 / mean_burst : 1.0 - loss;
+  double p = loss * r / (1.0 - loss);
+  bool bad = false;
+  for (int i = 0; i < kFrames; ++i) {
+    bad = bad ? u(rng) >= r : u(rng) < p;
+    t.lost[i] = bad;
+  }
+  return t;
+}
+
+struct Result {
+  double concealment = 0.0;
+  double overhead = 0.0;
+  double primary_kbps = 0.0;
+  double wire_kbps = 0.0;
+  double mean_depth = 0.0;
+  uint64_t duplicates_forwarded = 0;
+};
+
+// `fixed_depth` < 0 selects the adaptive controller.
+Result Run(const Trace& trace, int fixed_depth) {
+  vc::RedEncoder encoder(111);
+  vc::RedReceiver receiver(kTicksPerFrame * 50);
+  vc::AudioBitrateController controller;
+  controller.OnBandwidthEstimate(kBandwidthBps);
+
+  std::vector<int> arrival(kFrames, -1);
+  std::set<uint32_t> forwarded;
+  std::vector<uint8_t> frame;
+  std::vector<uint8_t> packet;
+  vc::RedBlock blocks[vc::RedReceiver::kMaxBlocksPerPacket];
+  uint64_t primary_bytes = 0;
+  uint64_t wire_bytes = 0;
+  uint64_t depth_sum = 0;
+  int interval_lost = 0;
+  Result result;
+
+  for (int i = 0; i < kFrames; ++i) {
+    int depth = fixed_depth;
+    int bitrate = kFixedCodecBitrateBps;
+    if (fixed_depth < 0) {
+      depth = controller.target().red_depth;
+      bitrate = controller.target().codec_bitrate_bps;
+    }
+    encoder.SetRedundancyDepth(depth);
+    depth_sum += depth;
+
+    frame.assign(bitrate * kFrameMs / 8000, static_cast<uint8_t>(i));
+    uint32_t ts = 0xfffff000u + static_cast<uint32_t>(i) * kTicksPerFrame;
+    encoder.Encode(frame.data(), frame.size(), ts, &packet);
+    primary_bytes += frame.size();
+    wire_bytes += packet.size();
+
+    if (trace.lost[i]) {
+      ++interval_lost;
+    } else {
+      int n = receiver.OnPacket(packet.data(), packet.size(), ts, blocks,
+                                vc::RedReceiver::kMaxBlocksPerPacket);
+      for (int k = 0; k < n; ++k) {
+        if (!forwarded.insert(blocks[k].timestamp).second) {
+          ++result.duplicates_forwarded;
+        }
+        int index = static_cast<int>(
+            static_cast<uint32_t>(blocks[k].timestamp - 0xfffff000u) /
+            kTicksPerFrame);
+        if (index >= 0 && index < kFrames && arrival[index] < 0) {
+          arrival[index] = i;
+        }
+      }
+    }
+
+    if ((i + 1) % kRtcpIntervalFrames == 0) {
+      controller.OnLossReport(static_cast<double>(interval_lost) /
+                              kRtcpIntervalFrames);
+      interval_lost = 0;
+    }
+  }
+
+  int concealed = 0;
+  for (int i = 0; i < kFrames; ++i) {
+    if (arrival[i] < 0 || arrival[i] - i > kPlayoutDelayFrames) ++concealed;
+  }
+  double seconds = kFrames * kFrameMs / 1000.0;
+  result.concealment = static_cast<double>(concealed) / kFrames;
+  result.overhead = static_cast<double>(wire_bytes) / primary_bytes - 1.0;
+  result.primary_kbps = primary_bytes * 8 / seconds / 1000.0;
+  result.wire_kbps = wire_bytes * 8 / seconds / 1000.0;
+  result.mean_depth = static_cast<double>(depth_sum) / kFrames;
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+
+  std::vector<Trace> traces = {
+      MakeTrace("clean", 0.0, 0.0, 1),
+      MakeTrace("random-2%", 0.02, 0.0, 2),
+      MakeTrace("random-5%", 0.05, 0.0, 3),
+      MakeTrace("random-10%", 0.10, 0.0, 4),
+      MakeTrace("random-20%", 0.20, 0.0, 5),
+      MakeTrace("bursty-10%", 0.10, 3.0, 6),
+  };
+  const int modes[] = {0, 1, 2, -1};
+
+  std::printf("%-12s %-9s %12s %10s %12s %10s %7s\n", "trace", "mode",
+              "concealment", "overhead", "primary_kbps", "wire_kbps",
+              "depth");
+  bool ok = true;
+  for (const Trace& trace : traces) {
+    Result none;
+    for (int mode : modes) {
+      Result r = Run(trace, mode);
+      std::string name =
+          mode < 0 ? "adaptive" : "depth-" + std::to_string(mode);
+      std::printf("%-12s %-9s %11.2f%% %9.1f%% %12.1f %10.1f %7.2f\n",
+                  trace.name.c_str(), name.c_str(), r.concealment * 100,
+                  r.overhead * 100, r.primary_kbps, r.wire_kbps, r.mean_depth);
+      if (mode == 0) none = r;
+      if (r.duplicates_forwarded != 0) {
+        std::printf("  FAIL: %llu duplicate frames reached the jitter buffer\n",
+                    static_cast<unsigned long long>(r.duplicates_forwarded));
+        ok = false;
+      }
+      if (mode >= 0) continue;
+      if (trace.name == "clean" && r.overhead > 0.05) {
+        std::printf("  FAIL: adaptive RED adds overhead on a clean link\n");
+        ok = false;
+      }
+      if (none.concealment >= 0.05 && r.concealment > none.concealment * 0.5) {
+        std::printf("  FAIL: adaptive RED does not halve concealment\n");
+        ok = false;
+      }
+      if (r.wire_kbps * 1000 > kBandwidthBps * 0.5 * 1.05) {
+        std::printf("  FAIL: adaptive RED exceeds the audio bandwidth share\n");
+        ok = false;
+      }
+    }
+  }
+  return check && !ok ? 1 : 0;
+}
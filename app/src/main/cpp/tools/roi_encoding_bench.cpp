@@ -0,0 +1,388 @@
+// Region-of-interest encoding on synthetic talking-head clips: a textured
+// face with speech and head motion over a cluttered background, at several
+// skin tones, one with a skin-coloured desk. Reports face detection and
+// tracking accuracy and cost, then encodes each clip at a sweep of bitrates
+// with and without face QP offsets and compares the bitrate needed for
+// equal PSNR inside the face.
+//
+//   roi_encoding_bench [--check]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "tools/cpu_time.h"
+#include "video/face_detector.h"
+#include "video/face_roi_tracker.h"
+#include "video/i420_frame.h"
+#include "video/software_video_codec.h"
+
+namespace {
+
+constexpr int kWidth = 640;
+constexpr int kHeight = 360;
+constexpr int kFrames = 180;
+// Rate control settles after the keyframe; rates and PSNR are measured
+// from here on.
+constexpr int kWarmupFrames = 60;
+constexpr int kFramerate = 30;
+constexpr int kBitratesKbps[] = {150, 250, 400, 650};
+
+struct Skin {
+  const char* name;
+  int luma;
+  int cb;
+  int cr;
+};
+
+struct Clip {
+  const char* name;
+  Skin skin;
+  bool desk;
+  std::vector<vc::I420Frame> frames;
+  std::vector<vc::FaceBox> truth;
+};
+
+uint8_t Clamp8(double v) {
+  return static_cast<uint8_t>(std::clamp(static_cast<int>(std::lround(v)), 0, 255));
+}
+
+void RenderClip(Clip* clip, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> texel(-10, 10);
+  std::vector<int> texture(static_cast<size_t>(kWidth) * kHeight);
+  for (int& t : texture) t = texel(rng);
+  std::uniform_int_distribution<int> noise(-2, 2);
+
+  for (int f = 0; f < kFrames; ++f) {
+    const double t = static_cast<double>(f) / kFramerate;
+    const double cx = kWidth * (0.5 + 0.06 * std::sin(2 * M_PI * t / 3.0));
+    const double cy = kHeight * (0.42 + 0.02 * std::sin(2 * M_PI * t / 2.3));
+    const double rx = kWidth * 0.1, ry = kHeight * 0.24;
+    const double hairline = cy - 0.55 * ry;
+    const double mouth_open = 0.04 + 0.04 * std::max(0.0, std::sin(2 * M_PI * t * 3.5));
+
+    vc::I420Frame frame(kWidth, kHeight);
+    frame.timestamp_us = static_cast<int64_t>(f) * 1000000 / kFramerate;
+    // Kind of region per pixel: 0 background, 1 desk, 2 shirt, 3 hair, 4 skin,
+    // 5 eye, 6 mouth.
+    auto region = [&](double x, double y) {
+      const double dx = (x - cx) / rx, dy = (y - cy) / ry;
+      const double head = dx * dx + dy * dy;
+      if (head < 1.0) {
+        if (y < hairline) return 3;
+        const double ex = (std::abs(x - cx) - 0.4 * rx) / (0.16 * rx);
+        const double ey = (y - (cy - 0.18 * ry)) / (0.06 * ry);
+        if (ex * ex + ey * ey < 1.0) return 5;
+        const double mx = (x - cx) / (0.35 * rx);
+        const double my = (y - (cy + 0.5 * ry)) / (mouth_open * ry + 0.02 * ry);
+        if (mx * mx + my * my < 1.0) return 6;
+        return 4;
+      }
+      if (std::abs(x - cx) < 0.45 * rx && y > cy && y < cy + 1.35 * ry) return 4;
+      const double sx = (x - cx) / (2.6 * rx), sy = (y - (cy + 2.3 * ry)) / (1.0 * ry);
+      if (sx * sx + sy * sy < 1.0) return 2;
+      if (clip->desk && y > kHeight * 0.86) return 1;
+      return 0;
+    };
+
+    for (int y = 0; y < kHeight; ++y) {
+      uint8_t* row = frame.y() + static_cast<size_t>(y) * frame.stride_y();
+      for (int x = 0; x < kWidth; ++x) {
+        const int tex = texture[static_cast<size_t>(y) * kWidth + x];
+        double v = 0.0;
+        switch (region(x, y)) {
+          case 0:  // Bookshelf: spines of varying brightness with texture.
+            v = 90 + 50 * std::sin(x * 0.21 + std::floor(y / 60.0) * 1.7) + tex;
+            break;
+          case 1:
+            v = 150 + 25 * std::sin(x * 0.05 + y * 0.3) + tex / 2;
+            break;
+          case 2:
+            v = 60 + 12 * std::sin((x - cx) * 0.08 + y * 0.02) + tex / 4;
+            break;
+          case 3:
+            v = 35 + tex / 2;
+            break;
+          case 4: {
+            // Shading across the face plus fine skin texture.
+            const double shade = 18 * std::cos((x - cx) / rx * 1.4) - 9;
+            v = clip->skin.luma + shade + 5 * std::sin(x * 0.6) * std::cos(y * 0.45) +
+                tex / 4;
+            break;
+          }
+          case 5:
+            v = 40 + tex / 4;
+            break;
+          case 6:
+            v = 55 + tex / 4;
+            break;
+        }
+        row[x] = Clamp8(v + noise(rng));
+      }
+    }
+    for (int y = 0; y < frame.chroma_height(); ++y) {
+      for (int x = 0; x < frame.chroma_width(); ++x) {
+        int cb = 128, cr = 128;
+        switch (region(2 * x + 0.5, 2 * y + 0.5)) {
+          case 0:  // Alternating blue and green spines.
+            cb = (x / 12) % 2 ? 150 : 110;
+            cr = (x / 12) % 2 ? 115 : 105;
+            break;
+          case 1:  // Wood: inside the skin range, but the wrong shape.
+            cb = 108;
+            cr = 146;
+            break;
+          case 2:
+            cb = 155;
+            cr = 118;
+            break;
+          case 4:
+            cb = clip->skin.cb;
+            cr = clip->skin.cr;
+            break;
+          case 6:
+            cb = clip->skin.cb - 4;
+            cr = clip->skin.cr + 14;
+            break;
+          default:
+            break;
+        }
+        const size_t k = static_cast<size_t>(y) * frame.stride_uv() + x;
+        frame.u()[k] = static_cast<uint8_t>(cb);
+        frame.v()[k] = static_cast<uint8_t>(cr);
+      }
+    }
+    clip->frames.push_back(std::move(frame));
+
+    vc::FaceBox truth;
+    truth.x = static_cast<int>(cx - rx);
+    truth.y = static_cast<int>(hairline);
+    truth.width = static_cast<int>(2 * rx);
+    truth.height = static_cast<int>(cy + ry - hairline);
+    clip->truth.push_back(truth);
+  }
+}
+
+// Luma squared error inside `box`, and the pixel count.
+void BoxSse(const vc::I420Frame& a, const vc::I420Frame& b, const vc::FaceBox& box,
+            double* sse, double* pixels) {
+  for (int y = box.y; y < box.y + box.height; ++y) {
+    for (int x = box.x; x < box.x + box.width; ++x) {
+      const int d = a.y()[static_cast<size_t>(y) * a.stride_y() + x] -
+                    b.y()[static_cast<size_t>(y) * b.stride_y() + x];
+      *sse += d * d;
+    }
+  }
+  *pixels += static_cast<double>(box.width) * box.height;
+}
+
+double Psnr(double sse, double pixels) {
+  const double mse = sse / pixels;
+  return mse > 0 ? 10 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+struct TrackingResult {
+  double mean_iou = 0.0;
+  double hit_rate = 0.0;
+  int false_positive_frames = 0;
+  double detect_ms = 0.0;
+  double update_ms = 0.0;
+  vc::FaceRoiTracker::Stats stats;
+};
+
+TrackingResult MeasureTracking(const Clip& clip) {
+  TrackingResult r;
+  vc::FaceDetector detector;
+  std::vector<vc::FaceBox> faces;
+  for (const vc::I420Frame& frame : clip.frames) {
+    const double start = vc::CpuNowMs();
+    detector.Detect(frame, &faces);
+    r.detect_ms += vc::CpuNowMs() - start;
+  }
+  r.detect_ms /= clip.frames.size();
+
+  vc::FaceRoiTracker tracker;
+  int hits = 0;
+  for (size_t i = 0; i < clip.frames.size(); ++i) {
+    const double start = vc::CpuNowMs();
+    const std::vector<vc::FaceBox>& tracked = tracker.Update(clip.frames[i]);
+    r.update_ms += vc::CpuNowMs() - start;
+    float best = 0.0f;
+    bool spurious = false;
+    for (const vc::FaceBox& box : tracked) {
+      const float iou = vc::FaceBoxIou(box, clip.truth[i]);
+      best = std::max(best, iou);
+      spurious |= iou < 0.1f;
+    }
+    r.mean_iou += best;
+    hits += best >= 0.5f;
+    r.false_positive_frames += spurious;
+  }
+  r.mean_iou /= clip.frames.size();
+  r.hit_rate = static_cast<double>(hits) / clip.frames.size();
+  r.update_ms /= clip.frames.size();
+  r.stats = tracker.stats();
+  return r;
+}
+
+struct RatePoint {
+  double kbps = 0.0;
+  double face_psnr = 0.0;
+  double frame_psnr = 0.0;
+  bool bit_exact = true;
+};
+
+RatePoint Encode(const Clip& clip, int kbps, bool roi) {
+  vc::SoftwareVideoEncoder encoder;
+  vc::VideoEncoderConfig config;
+  config.width = kWidth;
+  config.height = kHeight;
+  config.bitrate_bps = kbps * 1000;
+  config.framerate = kFramerate;
+  encoder.Init(config);
+  vc::SoftwareVideoDecoder decoder;
+  decoder.Init(kWidth, kHeight);
+  vc::FaceRoiTracker tracker;
+  std::vector<int8_t> offsets;
+  const vc::FaceBox whole{0, 0, kWidth, kHeight, 0.0f};
+
+  RatePoint r;
+  double bytes = 0.0;
+  double face_sse = 0.0, face_pixels = 0.0, frame_sse = 0.0, frame_pixels = 0.0;
+  vc::EncodedFrame encoded;
+  vc::I420Frame decoded;
+  for (size_t i = 0; i < clip.frames.size(); ++i) {
+    const vc::I420Frame& frame = clip.frames[i];
+    if (roi) {
+      tracker.Update(frame);
+      if (tracker.BuildQpOffsetMap(kWidth, kHeight, &offsets)) {
+        encoder.SetQpOffsetMap(offsets.data(), (kWidth + 15) / 16, (kHeight + 15) / 16);
+      } else {
+        encoder.SetQpOffsetMap(nullptr, 0, 0);
+      }
+    }
+    encoder.Encode(frame, false, &encoded);
+    const bool measured = static_cast<int>(i) >= kWarmupFrames;
+    if (measured) bytes += encoded.data.size();
+    if (!decoder.Decode(encoded.data.data(), encoded.data.size(), encoded.timestamp_us,
+                        &decoded)) {
+      r.bit_exact = false;
+      continue;
+    }
+    const vc::I420Frame& recon = encoder.reconstruction();
+    for (int y = 0; y < kHeight && r.bit_exact; ++y) {
+      r.bit_exact = std::memcmp(decoded.y() + static_cast<size_t>(y) * decoded.stride_y(),
+                                recon.y() + static_cast<size_t>(y) * recon.stride_y(),
+                                kWidth) == 0;
+    }
+    if (measured) {
+      BoxSse(frame, decoded, clip.truth[i], &face_sse, &face_pixels);
+      BoxSse(frame, decoded, whole, &frame_sse, &frame_pixels);
+    }
+  }
+  r.kbps = bytes * 8 * kFramerate / (clip.frames.size() - kWarmupFrames) / 1000.0;
+  r.face_psnr = Psnr(face_sse, face_pixels);
+  r.frame_psnr = Psnr(frame_sse, frame_pixels);
+  return r;
+}
+
+// Bitrate the baseline curve needs for `psnr`, interpolating log rate
+// linearly between sweep points; negative if `psnr` is outside the curve.
+double BaselineKbpsAt(const std::vector<RatePoint>& curve, double psnr) {
+  for (size_t i = 1; i < curve.size(); ++i) {
+    const RatePoint& lo = curve[i - 1];
+    const RatePoint& hi = curve[i];
+    if (psnr >= lo.face_psnr && psnr <= hi.face_psnr && hi.face_psnr > lo.face_psnr) {
+      const double a = (psnr - lo.face_psnr) / (hi.face_psnr - lo.face_psnr);
+      return std::exp(std::log(lo.kbps) + a * (std::log(hi.kbps) - std::log(lo.kbps)));
+    }
+  }
+  return -1.0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  bool ok = true;
+
+  Clip clips[] = {
+      {"light skin", {"light", 185, 108, 150}, false, {}, {}},
+      {"medium skin", {"medium", 140, 112, 148}, false, {}, {}},
+      {"dark skin, desk", {"dark", 85, 116, 144}, true, {}, {}},
+  };
+  for (size_t i = 0; i < std::size(clips); ++i) RenderClip(&clips[i], 7 + i);
+
+  std::printf("face tracking (%dx%d, %d frames)\n", kWidth, kHeight, kFrames);
+  std::printf("%-18s %8s %8s %8s %10s %10s %6s %6s\n", "clip", "mean_iou", "hit%",
+              "false_fr", "detect_ms", "update_ms", "detect", "lost");
+  for (const Clip& clip : clips) {
+    TrackingResult r = MeasureTracking(clip);
+    std::printf("%-18s %8.3f %8.1f %8d %10.3f %10.3f %6d %6d\n", clip.name, r.mean_iou,
+                100 * r.hit_rate, r.false_positive_frames, r.detect_ms, r.update_ms,
+                r.stats.detections, r.stats.lost_tracks);
+    if (r.mean_iou < 0.6 || r.hit_rate < 0.95) {
+      std::printf("  FAIL: face boxes do not follow the face\n");
+      ok = false;
+    }
+    if (r.false_positive_frames > kFrames / 50) {
+      std::printf("  FAIL: boxes on non-face regions\n");
+      ok = false;
+    }
+    if (r.update_ms > 1.0) {
+      std::printf("  FAIL: face analysis costs more than 1 ms per frame\n");
+      ok = false;
+    }
+  }
+
+  std::printf("\nrate sweep: kbps / face PSNR / frame PSNR\n");
+  double total_saving = 0.0;
+  for (const Clip& clip : clips) {
+    std::vector<RatePoint> baseline, roi;
+    for (int kbps : kBitratesKbps) {
+      baseline.push_back(Encode(clip, kbps, false));
+      roi.push_back(Encode(clip, kbps, true));
+    }
+    std::printf("%s\n", clip.name);
+    double saving = 0.0;
+    int compared = 0;
+    for (size_t i = 0; i < baseline.size(); ++i) {
+      const RatePoint& b = baseline[i];
+      const RatePoint& r = roi[i];
+      const double equal = BaselineKbpsAt(baseline, r.face_psnr);
+      std::printf("  target %4d  baseline %6.1f %6.2f %6.2f   roi %6.1f %6.2f %6.2f",
+                  kBitratesKbps[i], b.kbps, b.face_psnr, b.frame_psnr, r.kbps,
+                  r.face_psnr, r.frame_psnr);
+      if (equal > 0) {
+        std::printf("   baseline needs %6.1f kbps (%.0f%% saved)", equal,
+                    100 * (1 - r.kbps / equal));
+        saving += 1 - r.kbps / equal;
+        ++compared;
+      }
+      std::printf("\n");
+      if (!b.bit_exact || !r.bit_exact) {
+        std::printf("  FAIL: decoder does not match the encoder\n");
+        ok = false;
+      }
+    }
+    saving = compared ? saving / compared : 0.0;
+    total_saving += saving;
+    std::printf("  mean saving at equal face PSNR: %.1f%% over %d points\n",
+                100 * saving, compared);
+    if (compared < 2 || saving < 0.05) {
+      std::printf("  FAIL: region-of-interest coding saves too little\n");
+      ok = false;
+    }
+  }
+  total_saving /= std::size(clips);
+  std::printf("\nmean saving over all clips: %.1f%%\n", 100 * total_saving);
+  if (total_saving < 0.12) {
+    std::printf("  FAIL: mean saving below 12%%\n");
+    ok = false;
+  }
+  return check && !ok ? 1 : 0;
+}
@@ -0,0 +1,317 @@
+// Frame analysis ahead of the software encoder on synthetic camera clips: a
+// still person (sensor noise and two blinks), a moving pan, a person who
+// sits still and then starts moving, and a clip with hard cuts between three
+// scenes. Compares encoding every frame against skipping static frames and
+// forcing keyframes at detected cuts, with and without complexity hints to
+// rate control: encode CPU (analysis included), bitrate, the largest frame
+// right after a change of content relative to the per-frame budget, displayed PSNR (skipped frames repeat the last decoded one)
+// and cut detection.
+//
+//   scene_analysis_bench [--check]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "tools/cpu_time.h"
+#include "video/frame_analyzer.h"
+#include "video/i420_frame.h"
+#include "video/software_video_codec.h"
+
+namespace {
+
+constexpr int kWidth = 640;
+constexpr int kHeight = 360;
+constexpr int kFrames = 240;
+constexpr int kFramerate = 30;
+constexpr int kBitrateBps = 500000;
+constexpr int kPanMargin = 512;
+
+struct Scene {
+  uint32_t seed;
+  int base_luma;
+  int background_cb;
+  int background_cr;
+  std::vector<uint8_t> texture;
+
+  void Build() {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> texel(-12, 12);
+    const double fx = 0.03 + (seed % 5) * 0.01, fy = 0.02 + (seed % 3) * 0.013;
+    texture.resize(static_cast<size_t>(kWidth + kPanMargin) * kHeight);
+    for (int y = 0; y < kHeight; ++y) {
+      for (int x = 0; x < kWidth + kPanMargin; ++x) {
+        int v = base_luma + static_cast<int>(40 * std::sin(x * fx) * std::cos(y * fy)) +
+                ((x / 40 + y / 40) & 1) * 24 + texel(rng);
+        texture[static_cast<size_t>(y) * (kWidth + kPanMargin) + x] =
+            static_cast<uint8_t>(std::clamp(v, 0, 255));
+      }
+    }
+  }
+};
+
+struct Shot {
+  // Whether the shot starts with a cut; otherwise only the motion changes.
+  bool cut;
+  int scene;
+  // Background pan in pixels per frame and subject sway as a fraction of the
+  // width.
+  int pan;
+  double sway;
+};
+
+struct Clip {
+  const char* name;
+  // Shot for each frame range [start, next start).
+  std::vector<std::pair<int, Shot>> shots;
+  std::vector<int> blinks;
+};
+
+const Shot& ShotAt(const Clip& clip, int frame, int* shot_start) {
+  size_t i = 0;
+  while (i + 1 < clip.shots.size() && clip.shots[i + 1].first <= frame) ++i;
+  *shot_start = clip.shots[i].first;
+  return clip.shots[i].second;
+}
+
+void Render(const Clip& clip, const std::vector<Scene>& scenes, int frame,
+            std::mt19937* rng, vc::I420Frame* out) {
+  int start = 0;
+  const Shot& shot = ShotAt(clip, frame, &start);
+  const Scene& scene = scenes[shot.scene];
+  const int t = frame - start;
+  const int pan = (t * shot.pan) % kPanMargin;
+  const double cx = kWidth * (0.5 + shot.sway * std::sin(t * 0.08));
+  const double cy = kHeight * 0.55, rx = kWidth * 0.13, ry = kHeight * 0.33;
+  bool eyes_closed = false;
+  for (int b : clip.blinks) eyes_closed |= frame >= b && frame < b + 4;
+  std::uniform_int_distribution<int> noise(-2, 2);
+
+  out->Allocate(kWidth, kHeight);
+  out->timestamp_us = static_cast<int64_t>(frame) * 1000000 / kFramerate;
+  for (int y = 0; y < kHeight; ++y) {
+    uint8_t* row = out->y() + static_cast<size_t>(y) * out->stride_y();
+    const uint8_t* tex =
+        scene.texture.data() + static_cast<size_t>(y) * (kWidth + kPanMargin) + pan;
+    for (int x = 0; x < kWidth; ++x) {
+      const double dx = (x - cx) / rx, dy = (y - cy) / ry;
+      int v = tex[x];
+      if (dx * dx + dy * dy < 1.0) {
+        v = 160 + static_cast<int>(15 * std::sin(dx * 5 + dy * 3));
+        const double ex = (std::abs(dx) - 0.4) / 0.15, ey = (dy + 0.3) / 0.06;
+        if (ex * ex + ey * ey < 1.0) v = eyes_closed ? 150 : 40;
+      }
+      row[x] = static_cast<uint8_t>(std::clamp(v + noise(*rng), 0, 255));
+    }
+  }
+  for (int y = 0; y < out->chroma_height(); ++y) {
+    for (int x = 0; x < out->chroma_width(); ++x) {
+      const double dx = (2 * x - cx) / rx, dy = (2 * y - cy) / ry;
+      const bool subject = dx * dx + dy * dy < 1.0;
+      const size_t k = static_cast<size_t>(y) * out->stride_uv() + x;
+      out->u()[k] = static_cast<uint8_t>(subject ? 110 : scene.background_cb);
+      out->v()[k] = static_cast<uint8_t>(subject ? 150 : scene.background_cr);
+    }
+  }
+}
+
+double LumaSse(const vc::I420Frame& a, const vc::I420Frame& b) {
+  double sse = 0.0;
+  for (int y = 0; y < a.height(); ++y) {
+    const uint8_t* ra = a.y() + static_cast<size_t>(y) * a.stride_y();
+    const uint8_t* rb = b.y() + static_cast<size_t>(y) * b.stride_y();
+    for (int x = 0; x < a.width(); ++x) sse += (ra[x] - rb[x]) * (ra[x] - rb[x]);
+  }
+  return sse;
+}
+
+double Psnr(double sse, double pixels) {
+  const double mse = sse / pixels;
+  return mse > 0 ? 10 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+struct Result {
+  double cpu_ms = 0.0;
+  double analysis_ms = 0.0;
+  double kbps = 0.0;
+  // Largest frame over the per-frame budget in the five frames after a shot
+  // change.
+  double burst = 0.0;
+  double psnr = 0.0;
+  double post_cut_psnr = 0.0;
+  int encoded = 0;
+  int keyframes = 0;
+  std::vector<int> detected_cuts;
+  std::vector<int> skipped;
+};
+
+enum class Mode { kEveryFrame, kNoHints, kAnalyzed };
+
+Result Run(const Clip& clip, const std::vector<vc::I420Frame>& frames, Mode mode) {
+  const bool analyze = mode != Mode::kEveryFrame;
+  vc::SoftwareVideoEncoder encoder;
+  vc::VideoEncoderConfig config;
+  config.width = kWidth;
+  config.height = kHeight;
+  config.bitrate_bps = kBitrateBps;
+  config.framerate = kFramerate;
+  encoder.Init(config);
+  vc::SoftwareVideoDecoder decoder;
+  decoder.Init(kWidth, kHeight);
+  vc::FrameAnalyzer analyzer;
+  vc::FrameAnalysis analysis;
+  vc::EncodedFrame encoded;
+  vc::I420Frame displayed;
+
+  Result r;
+  double bytes = 0.0, sse = 0.0, cut_sse = 0.0;
+  int cut_frames = 0;
+  for (int i = 0; i < kFrames; ++i) {
+    const vc::I420Frame& frame = frames[i];
+    const double start = vc::CpuNowMs();
+    bool keyframe = false;
+    bool encode = true;
+    if (analyze) {
+      analyzer.Analyze(frame, &analysis);
+      r.analysis_ms += vc::CpuNowMs() - start;
+      encode = analysis.encode;
+      keyframe = analysis.scene_change;
+      if (keyframe) r.detected_cuts.push_back(i);
+      if (!encode) r.skipped.push_back(i);
+      if (mode == Mode::kAnalyzed) encoder.SetFrameComplexity(analysis.complexity_ratio);
+    }
+    if (encode) {
+      encoder.Encode(frame, keyframe, &encoded);
+      r.cpu_ms += vc::CpuNowMs() - start;
+      bytes += encoded.data.size();
+      for (const auto& shot : clip.shots) {
+        if (shot.first > 0 && i >= shot.first && i < shot.first + 5) {
+          r.burst = std::max(r.burst, encoded.data.size() * 8.0 * kFramerate / kBitrateBps);
+        }
+      }
+      r.keyframes += encoded.keyframe;
+      ++r.encoded;
+      decoder.Decode(encoded.data.data(), encoded.data.size(), encoded.timestamp_us,
+                     &displayed);
+    } else {
+      r.cpu_ms += vc::CpuNowMs() - start;
+    }
+    const double frame_sse = LumaSse(frame, displayed);
+    sse += frame_sse;
+    for (const auto& shot : clip.shots) {
+      if (shot.second.cut && i >= shot.first && i < shot.first + 5) {
+        cut_sse += frame_sse;
+        ++cut_frames;
+      }
+    }
+  }
+  const double pixels = static_cast<double>(kWidth) * kHeight;
+  r.kbps = bytes * 8 * kFramerate / kFrames / 1000.0;
+  r.psnr = Psnr(sse, pixels * kFrames);
+  r.post_cut_psnr = cut_frames ? Psnr(cut_sse, pixels * cut_frames) : 0.0;
+  r.analysis_ms /= kFrames;
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  bool ok = true;
+
+  std::vector<Scene> scenes = {{1, 100, 140, 118, {}}, {2, 150, 100, 120, {}},
+                               {3, 70, 128, 140, {}}};
+  for (Scene& s : scenes) s.Build();
+  const Clip clips[] = {
+      {"static", {{0, {false, 0, 0, 0.0}}}, {90, 180}},
+      {"moving", {{0, {false, 0, 2, 0.15}}}, {}},
+      {"onset", {{0, {false, 0, 0, 0.0}}, {120, {false, 0, 2, 0.15}}}, {}},
+      {"cuts",
+       {{0, {false, 0, 1, 0.1}},
+        {60, {true, 1, 1, 0.1}},
+        {120, {true, 2, 1, 0.1}},
+        {180, {true, 0, 1, 0.1}}},
+       {}},
+  };
+
+  std::printf("%dx%d, %d frames at %d kbps\n", kWidth, kHeight, kFrames,
+              kBitrateBps / 1000);
+  std::printf("%-8s %-9s %8s %8s %8s %8s %8s %8s %5s %9s\n", "clip", "mode",
+              "cpu_ms", "kbps", "burst", "psnr", "cut_psnr", "encoded", "keyfr",
+              "analyz_ms");
+  for (const Clip& clip : clips) {
+    std::mt19937 rng(5);
+    std::vector<vc::I420Frame> frames(kFrames);
+    for (int i = 0; i < kFrames; ++i) Render(clip, scenes, i, &rng, &frames[i]);
+
+    Result base = Run(clip, frames, Mode::kEveryFrame);
+    Result no_hints = Run(clip, frames, Mode::kNoHints);
+    Result analyzed = Run(clip, frames, Mode::kAnalyzed);
+    const struct {
+      const char* name;
+      const Result& r;
+    } rows[] = {{"every", base}, {"no-hints", no_hints}, {"analyzed", analyzed}};
+    for (const auto& row : rows) {
+      const Result& r = row.r;
+      std::printf("%-8s %-9s %8.1f %8.1f %8.2f %8.2f %8.2f %8d %5d %9.3f\n", clip.name,
+                  row.name, r.cpu_ms, r.kbps, r.burst, r.psnr, r.post_cut_psnr,
+                  r.encoded, r.keyframes, r.analysis_ms);
+    }
+    std::printf("  saved: cpu %.0f%%, bitrate %.0f%%; cuts detected at", 
+                100 * (1 - analyzed.cpu_ms / base.cpu_ms),
+                100 * (1 - analyzed.kbps / base.kbps));
+    for (int c : analyzed.detected_cuts) std::printf(" %d", c);
+    std::printf("\n");
+
+    std::vector<int> truth;
+    for (const auto& shot : clip.shots) {
+      if (shot.second.cut) truth.push_back(shot.first);
+    }
+    if (analyzed.detected_cuts != truth) {
+      std::printf("  FAIL: cuts missed or detected where there are none\n");
+      ok = false;
+    }
+    if (analyzed.analysis_ms > 0.5) {
+      std::printf("  FAIL: analysis costs more than 0.5 ms per frame\n");
+      ok = false;
+    }
+    if (std::strcmp(clip.name, "static") == 0) {
+      if (analyzed.encoded > kFrames / 4 ||
+          analyzed.cpu_ms > 0.5 * base.cpu_ms || analyzed.kbps > 0.7 * base.kbps) {
+        std::printf("  FAIL: static frames are not skipped\n");
+        ok = false;
+      }
+      // Encoding every frame keeps refining the still picture with five
+      // times the bits; the frozen picture only has to be close.
+      if (analyzed.psnr < base.psnr - 2.5) {
+        std::printf("  FAIL: skipping static frames costs too much quality\n");
+        ok = false;
+      }
+      for (int b : clip.blinks) {
+        if (std::find(analyzed.skipped.begin(), analyzed.skipped.end(), b) !=
+            analyzed.skipped.end()) {
+          std::printf("  FAIL: blink at frame %d was skipped\n", b);
+          ok = false;
+        }
+      }
+    } else if (std::strcmp(clip.name, "onset") == 0) {
+      if (analyzed.burst > 0.9 * no_hints.burst) {
+        std::printf("  FAIL: complexity hints do not damp the burst at motion onset\n");
+        ok = false;
+      }
+    } else {
+      if (!analyzed.skipped.empty()) {
+        std::printf("  FAIL: %zu moving frames skipped\n", analyzed.skipped.size());
+        ok = false;
+      }
+    }
+    if (!truth.empty() && analyzed.post_cut_psnr < base.post_cut_psnr - 0.5) {
+      std::printf("  FAIL: keyframes at cuts look worse than coding through them\n");
+      ok = false;
+    }
+  }
+  return check && !ok ? 1 : 0;
+}
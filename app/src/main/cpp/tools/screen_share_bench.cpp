@@ -0,0 +1,407 @@
+// Replays synthetic 1080p screen-share sessions (slides, typing, scrolling
+// text, a video playing in a window) through the screen-share preprocessor.
+// Compares against encoding every frame: blocks handed to the encoder, an
+// estimated bitrate from a simple block coding cost model, and CPU per frame
+// for the preprocessor plus that cost model. Also checks the SIMD SAD kernels
+// against the scalar reference.
+//
+//   screen_share_bench [--check]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "tools/cpu_time.h"
+#include "video/block_sad.h"
+#include "video/i420_frame.h"
+#include "video/screen_share_preprocessor.h"
+
+namespace {
+
+constexpr int kWidth = 1920;
+constexpr int kHeight = 1080;
+constexpr int kFps = 30;
+constexpr int kBlock = 16;
+constexpr int kPaper = 235;
+constexpr int kInk = 30;
+
+double MsSince(double start) { return vc::CpuNowMs() - start; }
+
+void FillRect(vc::I420Frame* f, int x, int y, int w, int h, uint8_t luma,
+              uint8_t u = 128, uint8_t v = 128) {
+  for (int r = y; r < y + h && r < f->height(); ++r) {
+    std::memset(f->y() + static_cast<size_t>(r) * f->stride_y() + x, luma,
+                std::min(w, f->width() - x));
+  }
+  for (int r = y / 2; r < (y + h) / 2 && r < f->chroma_height(); ++r) {
+    int cw = std::min(w / 2, f->chroma_width() - x / 2);
+    std::memset(f->u() + static_cast<size_t>(r) * f->stride_uv() + x / 2, u, cw);
+    std::memset(f->v() + static_cast<size_t>(r) * f->stride_uv() + x / 2, v, cw);
+  }
+}
+
+// 8x16 cell holding a 5x7 pseudo glyph, 1px wide strokes doubled vertically.
+void DrawGlyph(vc::I420Frame* f, int x, int y, uint32_t code) {
+  uint32_t bits = code * 2654435761u;
+  for (int gy = 0; gy < 7; ++gy) {
+    for (int gx = 0; gx < 5; ++gx) {
+      if (!((bits >> ((gy * 5 + gx) % 32)) & 1)) continue;
+      for (int dy = 0; dy < 2; ++dy) {
+        f->y()[static_cast<size_t>(y + 1 + gy * 2 + dy) * f->stride_y() + x + 1 + gx] =
+            kInk;
+      }
+    }
+  }
+}
+
+void DrawTextPage(vc::I420Frame* f, int x, int y, int w, int h, int first_line,
+                  uint32_t seed) {
+  FillRect(f, x, y, w, h, kPaper);
+  for (int line = 0; line * 20 + 20 <= h; ++line) {
+    int n = first_line + line;
+    int length = static_cast<int>((n * 7919u + seed) % (w / 8));
+    for (int c = 0; c < length; ++c) {
+      if ((n * 31 + c) % 6 == 0) continue;  // Word gaps.
+      DrawGlyph(f, x + 4 + c * 8, y + line * 20 + 2, seed + n * 131 + c);
+    }
+  }
+}
+
+void DrawDesktop(vc::I420Frame* f) {
+  FillRect(f, 0, 0, kWidth, kHeight, 90, 140, 120);
+  FillRect(f, 0, kHeight - 48, kWidth, 48, 50);
+  for (int i = 0; i < 12; ++i) FillRect(f, 16 + i * 56, kHeight - 40, 32, 32, 200, 100, 170);
+}
+
+class Scenario {
+ public:
+  virtual ~Scenario() = default;
+  virtual const char* name() const = 0;
+  // Expected classification once settled.
+  virtual vc::ScreenContentMode expected() const = 0;
+  virtual void Render(int frame, vc::I420Frame* f) = 0;
+};
+
+class Slides : public Scenario {
+ public:
+  const char* name() const override { return "slides"; }
+  vc::ScreenContentMode expected() const override {
+    return vc::ScreenContentMode::kText;
+  }
+  void Render(int frame, vc::I420Frame* f) override {
+    int slide = frame / (3 * kFps);
+    if (slide == drawn_) return;
+    drawn_ = slide;
+    DrawTextPage(f, 0, 0, kWidth, kHeight, slide * 50, 17 + slide);
+    FillRect(f, 120, 80, 900, 48, kInk);  // Title bar.
+  }
+
+ private:
+  int drawn_ = -1;
+};
+
+class Typing : public Scenario {
+ public:
+  const char* name() const override { return "typing"; }
+  vc::ScreenContentMode expected() const override {
+    return vc::ScreenContentMode::kText;
+  }
+  void Render(int frame, vc::I420Frame* f) override {
+    if (frame == 0) {
+      DrawDesktop(f);
+      DrawTextPage(f, 200, 100, 1400, 860, 0, 3);
+    }
+    // ~9 characters per second, caret blinking at 1 Hz.
+    int typed = frame * 3 / 10;
+    while (chars_ < typed) {
+      int line = 30 + chars_ / 150;
+      int col = chars_ % 150;
+      if (col == 0) FillRect(f, 204, 100 + line * 20 - 18, 1392, 20, kPaper);
+      DrawGlyph(f, 204 + col * 8, 100 + line * 20 - 18, 991 + chars_);
+      ++chars_;
+    }
+    int line = 30 + chars_ / 150;
+    int col = chars_ % 150;
+    FillRect(f, 204 + col * 8 + 8, 100 + line * 20 - 18, 2, 16,
+             (frame / (kFps / 2)) % 2 ? kInk : kPaper);
+  }
+
+ private:
+  int chars_ = 0;
+};
+
+class Scrolling : public Scenario {
+ public:
+  const char* name() const override { return "scrolling"; }
+  vc::ScreenContentMode expected() const override {
+    return vc::ScreenContentMode::kText;
+  }
+  void Render(int frame, vc::I420Frame* f) override {
+    if (frame == 0) DrawDesktop(f);
+    // Scroll a line every other frame for a second, then read for two.
+    int t = frame % (3 * kFps);
+    if (frame == 0 || (t < kFps && t % 2 == 0)) {
+      DrawTextPage(f, 240, 60, 1440, 960, lines_++, 5);
+    }
+  }
+
+ private:
+  int lines_ = 0;
+};
+
+class VideoWindow : public Scenario {
+ public:
+  const char* name() const override { return "video"; }
+  vc::ScreenContentMode expected() const override {
+    return vc::ScreenContentMode::kMotion;
+  }
+  void Render(int frame, vc::I420Frame* f) override {
+    if (frame == 0) DrawDesktop(f);
+    // A 1280x720 player with camera-like content: moving gradients and noise.
+    std::uniform_int_distribution<int> noise(-6, 6);
+    const int x0 = 320, y0 = 180;
+    for (int y = 0; y < 720; ++y) {
+      uint8_t* row = f->y() + static_cast<size_t>(y0 + y) * f->stride_y() + x0;
+      for (int x = 0; x < 1280; ++x) {
+        double v = 120 + 60 * std::sin((x + frame * 4) * 0.011) *
+                             std::cos((y - frame * 2) * 0.017);
+        row[x] = static_cast<uint8_t>(std::clamp(static_cast<int>(v) + noise(rng_), 0, 255));
+      }
+    }
+    for (int y = 0; y < 360; ++y) {
+      for (int x = 0; x < 640; ++x) {
+        size_t k = static_cast<size_t>(y0 / 2 + y) * f->stride_uv() + x0 / 2 + x;
+        f->u()[k] = static_cast<uint8_t>(118 + (x + frame) % 20);
+        f->v()[k] = static_cast<uint8_t>(136 + (y + frame) % 14);
+      }
+    }
+  }
+
+ private:
+  std::mt19937 rng_{9};
+};
+
+// Stand-in for an encoder's cost on one P-frame block against the reference:
+// skipped blocks cost an Exp-Golomb coded run, coded blocks a header plus a
+// per 4x4 residual cost that grows with the log of each residual.
+struct BlockCoder {
+  double frame_bits = 0.0;
+  int skip_run = 0;
+
+  void Begin() {
+    frame_bits = 96.0;
+    skip_run = 0;
+  }
+  void FlushRun() {
+    frame_bits += 1 + 2 * std::floor(std::log2(skip_run + 1.0));
+    skip_run = 0;
+  }
+  void Skip() { ++skip_run; }
+  void Code(const uint8_t* cur, const uint8_t* ref, int stride, int w, int h) {
+    FlushRun();
+    frame_bits += 16;
+    for (int sy = 0; sy < h; sy += 4) {
+      for (int sx = 0; sx < w; sx += 4) {
+        double bits = 0.0;
+        for (int y = sy; y < std::min(sy + 4, h); ++y) {
+          for (int x = sx; x < std::min(sx + 4, w); ++x) {
+            int r = std::abs(cur[y * stride + x] - ref[y * stride + x]);
+            if (r) bits += 1.5 * std::log2(1.0 + r) + 1;
+          }
+        }
+        frame_bits += bits > 0 ? 4 + bits : 1;
+      }
+    }
+  }
+  double End() {
+    FlushRun();
+    return frame_bits;
+  }
+};
+
+// Codes one frame against `ref`. With `map`, only marked blocks are coded;
+// without, every block is examined the way an encoder without dirty-region
+// hints has to.
+double CodeFrame(const vc::I420Frame& cur, const vc::I420Frame& ref,
+                 const std::vector<uint8_t>* map) {
+  BlockCoder coder;
+  coder.Begin();
+  const int bw = (kWidth + kBlock - 1) / kBlock;
+  const int bh = (kHeight + kBlock - 1) / kBlock;
+  for (int by = 0; by < bh; ++by) {
+    for (int bx = 0; bx < bw; ++bx) {
+      int x0 = bx * kBlock, y0 = by * kBlock;
+      int w = std::min(kBlock, kWidth - x0), h = std::min(kBlock, kHeight - y0);
+      size_t offset = static_cast<size_t>(y0) * kWidth + x0;
+      bool examine = map ? (*map)[by * bw + bx] != 0 : true;
+      if (examine && vc::SadBlock(cur.y() + offset, kWidth, ref.y() + offset,
+                                  kWidth, w, h) != 0) {
+        coder.Code(cur.y() + offset, ref.y() + offset, kWidth, w, h);
+      } else {
+        coder.Skip();
+      }
+    }
+  }
+  return coder.End();
+}
+
+struct Result {
+  int frames = 0;
+  int encoded = 0;
+  int text_frames = 0;
+  double baseline_blocks = 0.0;
+  double dirty_blocks = 0.0;
+  double baseline_kbps = 0.0;
+  double kbps = 0.0;
+  double preprocess_ms = 0.0;
+  double baseline_cpu_ms = 0.0;
+  double cpu_ms = 0.0;
+  vc::ScreenContentMode final_mode = vc::ScreenContentMode::kMotion;
+};
+
+Result Run(Scenario* scenario, int seconds) {
+  vc::ScreenSharePreprocessor pre;
+  vc::ScreenFrameDecision decision;
+  vc::I420Frame frame(kWidth, kHeight);
+  vc::I420Frame previous(kWidth, kHeight);
+  vc::I420Frame last_encoded(kWidth, kHeight);
+  Result r;
+  r.frames = seconds * kFps;
+  double baseline_bits = 0.0, bits = 0.0;
+  for (int i = 0; i < r.frames; ++i) {
+    scenario->Render(i, &frame);
+    frame.timestamp_us = static_cast<int64_t>(i) * 1000000 / kFps;
+
+    // Baseline: every frame goes to the encoder, which examines every block.
+    double t = vc::CpuNowMs();
+    if (i > 0) baseline_bits += CodeFrame(frame, previous, nullptr);
+    r.baseline_cpu_ms += MsSince(t);
+    r.baseline_blocks += decision.total_blocks;
+    std::memcpy(previous.y(), frame.y(), frame.size_bytes());
+
+    t = vc::CpuNowMs();
+    pre.Analyze(frame, &decision);
+    double pre_ms = MsSince(t);
+    r.preprocess_ms += pre_ms;
+    t = vc::CpuNowMs();
+    if (decision.encode) {
+      ++r.encoded;
+      r.dirty_blocks += decision.dirty_blocks;
+      if (!decision.full_frame) bits += CodeFrame(frame, last_encoded, &decision.block_map);
+      std::memcpy(last_encoded.y(), frame.y(), frame.size_bytes());
+    }
+    r.cpu_ms += pre_ms + MsSince(t);
+    if (decision.mode == vc::ScreenContentMode::kText) ++r.text_frames;
+  }
+  r.baseline_blocks = static_cast<double>(decision.total_blocks) * r.frames;
+  r.final_mode = pre.mode();
+  r.baseline_kbps = baseline_bits / seconds / 1000.0;
+  r.kbps = bits / seconds / 1000.0;
+  return r;
+}
+
+bool CheckSad() {
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::vector<uint8_t> a(64 * 64), b(64 * 64);
+  for (auto& x : a) x = static_cast<uint8_t>(byte(rng));
+  for (auto& x : b) x = static_cast<uint8_t>(byte(rng));
+  for (int off = 0; off < 40; ++off) {
+    if (vc::Sad16x16(a.data() + off, 64, b.data() + off * 3, 64) !=
+            vc::SadBlock(a.data() + off, 64, b.data() + off * 3, 64, 16, 16) ||
+        vc::Sad8x8(a.data() + off, 64, b.data() + off * 2, 64) !=
+            vc::SadBlock(a.data() + off, 64, b.data() + off * 2, 64, 8, 8)) {
+      return false;
+    }
+  }
+
+  // Full-frame compare at 1080p.
+  vc::I420Frame x(kWidth, kHeight), y(kWidth, kHeight);
+  for (size_t i = 0; i < x.size_bytes(); ++i) {
+    x.y()[i] = static_cast<uint8_t>(byte(rng));
+    y.y()[i] = static_cast<uint8_t>(byte(rng));
+  }
+  uint64_t simd = 0, scalar = 0;
+  const int runs = 20;
+  double t = vc::CpuNowMs();
+  for (int r = 0; r < runs; ++r) {
+    for (int by = 0; by + kBlock <= kHeight; by += kBlock) {
+      for (int bx = 0; bx < kWidth; bx += kBlock) {
+        size_t o = static_cast<size_t>(by) * kWidth + bx;
+        simd += vc::Sad16x16(x.y() + o, kWidth, y.y() + o, kWidth);
+      }
+    }
+  }
+  double simd_ms = MsSince(t) / runs;
+  t = vc::CpuNowMs();
+  for (int r = 0; r < runs; ++r) {
+    for (int by = 0; by + kBlock <= kHeight; by += kBlock) {
+      for (int bx = 0; bx < kWidth; bx += kBlock) {
+        size_t o = static_cast<size_t>(by) * kWidth + bx;
+        scalar += vc::SadBlock(x.y() + o, kWidth, y.y() + o, kWidth, 16, 16);
+      }
+    }
+  }
+  double scalar_ms = MsSince(t) / runs;
+  std::printf("1080p luma SAD: simd %.3f ms, scalar %.3f ms (%.1fx)\n\n", simd_ms,
+              scalar_ms, scalar_ms / simd_ms);
+  return simd == scalar;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  const int seconds = check ? 6 : 20;
+  bool ok = true;
+
+  if (!CheckSad()) {
+    std::printf("FAIL: SIMD SAD differs from scalar reference\n");
+    ok = false;
+  }
+
+  Slides slides;
+  Typing typing;
+  Scrolling scrolling;
+  VideoWindow video;
+  Scenario* scenarios[] = {&slides, &typing, &scrolling, &video};
+
+  std::printf("%-10s %8s %6s %11s %11s %10s %10s %8s %9s %9s\n", "scenario",
+              "encoded", "text%", "base_blk/f", "dirty_blk/f", "base_kbps",
+              "kbps", "pre_ms", "base_cpu", "cpu_ms");
+  for (Scenario* s : scenarios) {
+    Result r = Run(s, seconds);
+    std::printf("%-10s %7.0f%% %5.0f%% %11.0f %11.1f %10.1f %10.1f %8.3f %9.3f %9.3f\n",
+                s->name(), 100.0 * r.encoded / r.frames,
+                100.0 * r.text_frames / r.frames, r.baseline_blocks / r.frames,
+                r.dirty_blocks / r.frames, r.baseline_kbps, r.kbps,
+                r.preprocess_ms / r.frames, r.baseline_cpu_ms / r.frames,
+                r.cpu_ms / r.frames);
+    if (r.final_mode != s->expected()) {
+      std::printf("  FAIL: content classified as %s\n",
+                  r.final_mode == vc::ScreenContentMode::kText ? "text" : "motion");
+      ok = false;
+    }
+    if (r.kbps > r.baseline_kbps) {
+      std::printf("  FAIL: more bits than encoding every frame\n");
+      ok = false;
+    }
+    // Full-motion content changes most blocks, so the preprocessor can only
+    // add its own cost there; elsewhere it must pay for itself.
+    const double allowed = s->expected() == vc::ScreenContentMode::kText
+                               ? r.baseline_cpu_ms : 1.15 * r.baseline_cpu_ms;
+    if (r.cpu_ms > allowed) {
+      std::printf("  FAIL: CPU above encoding every frame\n");
+      ok = false;
+    }
+    if (r.preprocess_ms / r.frames > 5.0) {
+      std::printf("  FAIL: preprocessing above 5 ms per 1080p frame\n");
+      ok = false;
+    }
+  }
+  return check && !ok ? 1 : 0;
+}
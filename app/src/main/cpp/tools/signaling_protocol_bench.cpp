@@ -0,0 +1,588 @@
+// Binary delta signaling against SDP offer/answer for rooms of 10 to 200
+// tracks (one audio and one simulcast video track per participant). The
+// SDP baseline is what a Unified Plan offer to an SFU subscriber looks
+// like (bundled m-sections repeating the transport lines, rtpmap, rtcp-fb,
+// fmtp, ssrc and simulcast attributes) with a string_view parser that
+// fills the same SessionDescription. Reports message sizes and parse
+// times for a full SDP, a binary snapshot, a join delta (two tracks added)
+// and a mute delta, and what one join costs the whole room when every
+// client renegotiates. Checks snapshot and random delta round trips,
+// version mismatches, rejection of every truncation and of corrupt
+// messages, the SDP baseline's own round trip, and size and speed ratios.
+//
+//   signaling_protocol_bench [--check]
+
+#include <algorithm>
+#include <charconv>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "signaling/session_protocol.h"
+#include "tools/cpu_time.h"
+
+namespace {
+
+using vc::CodecDescription;
+using vc::CodecId;
+using vc::SessionDescription;
+using vc::TrackDescription;
+
+std::vector<CodecDescription> RoomCodecs() {
+  const uint8_t video_fb = vc::kFeedbackNack | vc::kFeedbackPli | vc::kFeedbackFir |
+                           vc::kFeedbackTransportCc;
+  return {
+      {111, CodecId::kOpus, 2, vc::kFeedbackTransportCc, 0, 48000},
+      {63, CodecId::kRed, 2, 0, 0, 48000},
+      {96, CodecId::kVcv, 1, video_fb, 97, 90000},
+      {98, CodecId::kVp8, 1, video_fb, 99, 90000},
+      {100, CodecId::kH264, 1, video_fb, 101, 90000},
+  };
+}
+
+std::string Uid(std::mt19937* rng) {
+  static const char kChars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+  std::string uid(28, ' ');
+  for (char& c : uid) c = kChars[(*rng)() % 62];
+  return uid;
+}
+
+// Appends one participant's audio and video tracks with ids from `next_id`.
+void AddParticipant(SessionDescription* s, uint32_t* next_id, std::mt19937* rng) {
+  const std::string uid = Uid(rng);
+  TrackDescription audio;
+  audio.id = (*next_id)++;
+  audio.kind = vc::MediaKind::kAudio;
+  audio.participant = uid;
+  audio.ssrc = (*rng)();
+  audio.codecs = 0x3;
+  audio.max_bitrate_bps = 64000;
+  s->tracks.push_back(audio);
+  TrackDescription video;
+  video.id = (*next_id)++;
+  video.kind = vc::MediaKind::kVideo;
+  video.participant = uid;
+  video.ssrc = (*rng)();
+  video.rtx_ssrc = (*rng)();
+  video.codecs = 0x1c;
+  video.max_bitrate_bps = 1500000;
+  video.width = 1280;
+  video.height = 720;
+  video.max_framerate = 30;
+  video.simulcast_layers = 3;
+  s->tracks.push_back(video);
+}
+
+SessionDescription Room(int tracks, std::mt19937* rng, uint32_t* next_id) {
+  SessionDescription s;
+  s.version = 1;
+  s.codecs = RoomCodecs();
+  *next_id = 1;
+  while (static_cast<int>(s.tracks.size()) < tracks) AddParticipant(&s, next_id, rng);
+  return s;
+}
+
+// --- SDP baseline ----------------------------------------------------------
+
+const char* CodecName(CodecId id) {
+  switch (id) {
+    case CodecId::kOpus:
+      return "opus";
+    case CodecId::kRed:
+      return "red";
+    case CodecId::kVcv:
+      return "VCV";
+    case CodecId::kVp8:
+      return "VP8";
+    case CodecId::kH264:
+      return "H264";
+  }
+  return "";
+}
+
+const char* DirectionName(vc::TrackDirection d) {
+  switch (d) {
+    case vc::TrackDirection::kSendRecv:
+      return "sendrecv";
+    case vc::TrackDirection::kSendOnly:
+      return "sendonly";
+    case vc::TrackDirection::kRecvOnly:
+      return "recvonly";
+    case vc::TrackDirection::kInactive:
+      return "inactive";
+  }
+  return "";
+}
+
+void Append(std::string* out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+void Append(std::string* out, const char* format, ...) {
+  char line[512];
+  va_list args;
+  va_start(args, format);
+  const int n = std::vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  out->append(line, std::min<size_t>(n, sizeof(line) - 1));
+}
+
+std::string WriteSdp(const SessionDescription& s) {
+  std::string sdp;
+  Append(&sdp, "v=0\r\no=- 4611731400430051336 %u IN IP4 127.0.0.1\r\ns=-\r\nt=0 0\r\n",
+         s.version);
+  sdp += "a=group:BUNDLE";
+  for (const TrackDescription& t : s.tracks) Append(&sdp, " %u", t.id);
+  sdp += "\r\na=extmap-allow-mixed\r\na=msid-semantic: WMS\r\n";
+  for (const TrackDescription& t : s.tracks) {
+    const bool video = t.kind == vc::MediaKind::kVideo;
+    Append(&sdp, "m=%s 9 UDP/TLS/RTP/SAVPF", video ? "video" : "audio");
+    for (size_t i = 0; i < s.codecs.size(); ++i) {
+      if (!(t.codecs >> i & 1)) continue;
+      Append(&sdp, " %u", s.codecs[i].payload_type);
+      if (s.codecs[i].rtx_payload_type) Append(&sdp, " %u", s.codecs[i].rtx_payload_type);
+    }
+    sdp +=
+        "\r\nc=IN IP4 0.0.0.0\r\na=rtcp:9 IN IP4 0.0.0.0\r\n"
+        "a=ice-ufrag:Xk3p\r\na=ice-pwd:9LhN0c2bPq8sZ1vY7mW4rT6u\r\na=ice-options:trickle\r\n"
+        "a=fingerprint:sha-256 4A:AD:B9:B1:3F:82:18:3B:54:02:12:DF:3E:5D:49:6B:19:E5:7C:AB:"
+        "3F:82:18:3B:54:02:12:DF:3E:5D:49:6B\r\na=setup:actpass\r\n";
+    Append(&sdp, "a=mid:%u\r\n", t.id);
+    sdp +=
+        "a=extmap:1 urn:ietf:params:rtp-hdrext:ssrc-audio-level\r\n"
+        "a=extmap:2 http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time\r\n"
+        "a=extmap:3 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\r\n"
+        "a=extmap:4 urn:ietf:params:rtp-hdrext:sdes:mid\r\n";
+    Append(&sdp, "a=%s\r\na=msid:%s %u\r\n", DirectionName(t.direction), t.participant.c_str(),
+           t.id);
+    Append(&sdp, "b=TIAS:%u\r\na=rtcp-mux\r\na=rtcp-rsize\r\n", t.max_bitrate_bps);
+    for (size_t i = 0; i < s.codecs.size(); ++i) {
+      if (!(t.codecs >> i & 1)) continue;
+      const CodecDescription& c = s.codecs[i];
+      if (c.channels > 1) {
+        Append(&sdp, "a=rtpmap:%u %s/%u/%u\r\n", c.payload_type, CodecName(c.id), c.clock_rate,
+               c.channels);
+      } else {
+        Append(&sdp, "a=rtpmap:%u %s/%u\r\n", c.payload_type, CodecName(c.id), c.clock_rate);
+      }
+      if (c.feedback & vc::kFeedbackTransportCc) {
+        Append(&sdp, "a=rtcp-fb:%u transport-cc\r\n", c.payload_type);
+      }
+      if (c.feedback & vc::kFeedbackFir) Append(&sdp, "a=rtcp-fb:%u ccm fir\r\n", c.payload_type);
+      if (c.feedback & vc::kFeedbackNack) Append(&sdp, "a=rtcp-fb:%u nack\r\n", c.payload_type);
+      if (c.feedback & vc::kFeedbackPli) Append(&sdp, "a=rtcp-fb:%u nack pli\r\n", c.payload_type);
+      if (c.id == CodecId::kOpus) {
+        Append(&sdp, "a=fmtp:%u minptime=10;useinbandfec=1\r\n", c.payload_type);
+      }
+      if (c.rtx_payload_type) {
+        Append(&sdp, "a=rtpmap:%u rtx/%u\r\na=fmtp:%u apt=%u\r\n", c.rtx_payload_type,
+               c.clock_rate, c.rtx_payload_type, c.payload_type);
+      }
+    }
+    if (t.width) Append(&sdp, "a=imageattr:* send [x=%u,y=%u]\r\n", t.width, t.height);
+    if (t.max_framerate) Append(&sdp, "a=framerate:%u\r\n", t.max_framerate);
+    if (t.simulcast_layers) {
+      for (int i = 0; i < t.simulcast_layers; ++i) Append(&sdp, "a=rid:%d send\r\n", i);
+      sdp += "a=simulcast:send 0";
+      for (int i = 1; i < t.simulcast_layers; ++i) Append(&sdp, ";%d", i);
+      sdp += "\r\n";
+    }
+    // SDP has no mute; apps add an attribute or send it out of band.
+    if (t.muted) sdp += "a=x-muted\r\n";
+    if (t.rtx_ssrc) Append(&sdp, "a=ssrc-group:FID %u %u\r\n", t.ssrc, t.rtx_ssrc);
+    const uint32_t ssrcs[2] = {t.ssrc, t.rtx_ssrc};
+    for (uint32_t ssrc : ssrcs) {
+      if (!ssrc) continue;
+      Append(&sdp, "a=ssrc:%u cname:Y3hkYjE0ZDk2NzA2\r\na=ssrc:%u msid:%s %u\r\n", ssrc, ssrc,
+             t.participant.c_str(), t.id);
+    }
+  }
+  return sdp;
+}
+
+template <typename T>
+bool ParseUint(std::string_view* text, T* out) {
+  while (!text->empty() && text->front() == ' ') text->remove_prefix(1);
+  uint64_t v = 0;
+  const auto r = std::from_chars(text->data(), text->data() + text->size(), v);
+  if (r.ec != std::errc()) return false;
+  *out = static_cast<T>(v);
+  text->remove_prefix(r.ptr - text->data());
+  return true;
+}
+
+bool StartsWith(std::string_view s, std::string_view prefix) {
+  return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Fills `s` from an SDP written by WriteSdp(); lines it does not need are
+// skipped after their prefix is looked at, as any SDP parser has to.
+bool ParseSdp(std::string_view sdp, SessionDescription* s) {
+  *s = SessionDescription();
+  TrackDescription* t = nullptr;
+  // Payload type to codec table index.
+  int codec_of_pt[128];
+  std::fill(std::begin(codec_of_pt), std::end(codec_of_pt), -1);
+  std::vector<uint8_t> m_pts;
+  while (!sdp.empty()) {
+    size_t eol = sdp.find("\r\n");
+    if (eol == std::string_view::npos) eol = sdp.size();
+    std::string_view line = sdp.substr(0, eol);
+    sdp.remove_prefix(std::min(eol + 2, sdp.size()));
+    if (line.size() < 2 || line[1] != '=') return false;
+
+    if (StartsWith(line, "o=")) {
+      // o=<user> <session id> <version> ...
+      line.remove_prefix(line.find(' ', line.find(' ') + 1) + 1);
+      if (!ParseUint(&line, &s->version)) return false;
+    } else if (StartsWith(line, "m=")) {
+      s->tracks.emplace_back();
+      t = &s->tracks.back();
+      t->kind = StartsWith(line, "m=video") ? vc::MediaKind::kVideo : vc::MediaKind::kAudio;
+      line.remove_prefix(line.find("SAVPF") + 5);
+      m_pts.clear();
+      uint8_t pt;
+      while (ParseUint(&line, &pt)) m_pts.push_back(pt);
+    } else if (!t) {
+      continue;
+    } else if (StartsWith(line, "a=mid:")) {
+      line.remove_prefix(6);
+      if (!ParseUint(&line, &t->id)) return false;
+    } else if (StartsWith(line, "a=msid:")) {
+      line.remove_prefix(7);
+      t->participant.assign(line.substr(0, line.find(' ')));
+    } else if (StartsWith(line, "b=TIAS:")) {
+      line.remove_prefix(7);
+      if (!ParseUint(&line, &t->max_bitrate_bps)) return false;
+    } else if (StartsWith(line, "a=rtpmap:")) {
+      line.remove_prefix(9);
+      CodecDescription c;
+      if (!ParseUint(&line, &c.payload_type) || c.payload_type >= 128) return false;
+      line.remove_prefix(1);
+      const std::string_view name = line.substr(0, line.find('/'));
+      line.remove_prefix(name.size() + 1);
+      if (!ParseUint(&line, &c.clock_rate)) return false;
+      if (!line.empty() && line[0] == '/') {
+        line.remove_prefix(1);
+        if (!ParseUint(&line, &c.channels)) return false;
+      }
+      if (name == "rtx") continue;  // Linked by its fmtp apt.
+      if (name == "opus") {
+        c.id = CodecId::kOpus;
+      } else if (name == "red") {
+        c.id = CodecId::kRed;
+      } else if (name == "VCV") {
+        c.id = CodecId::kVcv;
+      } else if (name == "VP8") {
+        c.id = CodecId::kVp8;
+      } else if (name == "H264") {
+        c.id = CodecId::kH264;
+      } else {
+        continue;
+      }
+      if (codec_of_pt[c.payload_type] < 0) {
+        codec_of_pt[c.payload_type] = static_cast<int>(s->codecs.size());
+        s->codecs.push_back(c);
+      }
+      t->codecs |= 1u << codec_of_pt[c.payload_type];
+    } else if (StartsWith(line, "a=rtcp-fb:")) {
+      line.remove_prefix(10);
+      uint8_t pt;
+      if (!ParseUint(&line, &pt) || pt >= 128 || codec_of_pt[pt] < 0) return false;
+      CodecDescription& c = s->codecs[codec_of_pt[pt]];
+      line.remove_prefix(1);
+      if (line == "transport-cc") c.feedback |= vc::kFeedbackTransportCc;
+      if (line == "ccm fir") c.feedback |= vc::kFeedbackFir;
+      if (line == "nack") c.feedback |= vc::kFeedbackNack;
+      if (line == "nack pli") c.feedback |= vc::kFeedbackPli;
+    } else if (StartsWith(line, "a=fmtp:")) {
+      line.remove_prefix(7);
+      uint8_t pt, apt;
+      if (!ParseUint(&line, &pt) || pt >= 128) return false;
+      const size_t at = line.find("apt=");
+      if (at == std::string_view::npos) continue;
+      line.remove_prefix(at + 4);
+      if (!ParseUint(&line, &apt) || apt >= 128 || codec_of_pt[apt] < 0) return false;
+      s->codecs[codec_of_pt[apt]].rtx_payload_type = pt;
+    } else if (StartsWith(line, "a=imageattr:")) {
+      line.remove_prefix(line.find("x=") + 2);
+      if (!ParseUint(&line, &t->width)) return false;
+      line.remove_prefix(line.find("y=") + 2);
+      if (!ParseUint(&line, &t->height)) return false;
+    } else if (StartsWith(line, "a=framerate:")) {
+      line.remove_prefix(12);
+      if (!ParseUint(&line, &t->max_framerate)) return false;
+    } else if (StartsWith(line, "a=simulcast:send ")) {
+      t->simulcast_layers = static_cast<uint8_t>(
+          1 + std::count(line.begin(), line.end(), ';'));
+    } else if (StartsWith(line, "a=ssrc-group:FID ")) {
+      line.remove_prefix(17);
+      if (!ParseUint(&line, &t->ssrc) || !ParseUint(&line, &t->rtx_ssrc)) return false;
+    } else if (StartsWith(line, "a=ssrc:")) {
+      line.remove_prefix(7);
+      if (!t->ssrc && !ParseUint(&line, &t->ssrc)) return false;
+    } else if (line == "a=x-muted") {
+      t->muted = true;
+    } else if (line == "a=sendrecv") {
+      t->direction = vc::TrackDirection::kSendRecv;
+    } else if (line == "a=sendonly") {
+      t->direction = vc::TrackDirection::kSendOnly;
+    } else if (line == "a=recvonly") {
+      t->direction = vc::TrackDirection::kRecvOnly;
+    } else if (line == "a=inactive") {
+      t->direction = vc::TrackDirection::kInactive;
+    }
+  }
+  std::sort(s->tracks.begin(), s->tracks.end(),
+            [](const TrackDescription& a, const TrackDescription& b) { return a.id < b.id; });
+  return true;
+}
+
+// --- checks ----------------------------------------------------------------
+
+bool Decode(const std::vector<uint8_t>& bytes, SessionDescription* s) {
+  vc::SignalingMessage message;
+  return message.Parse(bytes.data(), bytes.size()) && vc::ApplySignalingMessage(message, s);
+}
+
+// A random change: adds, removes, field updates and now and then a new
+// codec table.
+void Mutate(SessionDescription* s, uint32_t* next_id, std::mt19937* rng) {
+  const int changes = 1 + (*rng)() % 4;
+  for (int i = 0; i < changes; ++i) {
+    const int what = (*rng)() % 10;
+    if (what < 2 || s->tracks.empty()) {
+      AddParticipant(s, next_id, rng);
+    } else if (what < 4) {
+      s->tracks.erase(s->tracks.begin() + (*rng)() % s->tracks.size());
+    } else if (what == 9) {
+      s->codecs[(*rng)() % s->codecs.size()].feedback ^= vc::kFeedbackNack;
+    } else {
+      TrackDescription& t = s->tracks[(*rng)() % s->tracks.size()];
+      switch ((*rng)() % 8) {
+        case 0:
+          t.muted = !t.muted;
+          break;
+        case 1:
+          t.max_bitrate_bps = (*rng)() % 3000000;
+          break;
+        case 2:
+          t.width = static_cast<uint16_t>((*rng)() % 1921);
+          t.height = static_cast<uint16_t>((*rng)() % 1081);
+          break;
+        case 3:
+          t.direction = static_cast<vc::TrackDirection>((*rng)() % 4);
+          break;
+        case 4:
+          t.simulcast_layers = static_cast<uint8_t>((*rng)() % 4);
+          break;
+        case 5:
+          t.codecs = (*rng)() & 0x1f;
+          break;
+        case 6:
+          t.participant = (*rng)() % 5 ? Uid(rng) : "";
+          break;
+        default:
+          t.ssrc = (*rng)();
+          t.rtx_ssrc = (*rng)() % 2 ? (*rng)() : 0;
+          t.max_framerate = static_cast<uint8_t>((*rng)());
+          break;
+      }
+    }
+  }
+  std::sort(s->tracks.begin(), s->tracks.end(),
+            [](const TrackDescription& a, const TrackDescription& b) { return a.id < b.id; });
+  ++s->version;
+}
+
+bool CheckRoundTrips(std::mt19937* rng) {
+  bool ok = true;
+  uint32_t next_id;
+  SessionDescription session = Room(40, rng, &next_id);
+  std::vector<uint8_t> bytes;
+  vc::WriteSessionSnapshot(session, &bytes);
+  SessionDescription decoded;
+  if (!Decode(bytes, &decoded) || !(decoded == session)) {
+    std::printf("  FAIL: snapshot round trip\n");
+    ok = false;
+  }
+
+  SessionDescription from_sdp;
+  if (!ParseSdp(WriteSdp(session), &from_sdp) || !(from_sdp == session)) {
+    std::printf("  FAIL: SDP baseline round trip\n");
+    ok = false;
+  }
+
+  // A replica that follows only deltas stays equal to the source.
+  SessionDescription replica = session;
+  for (int i = 0; i < 500 && ok; ++i) {
+    SessionDescription next = session;
+    Mutate(&next, &next_id, rng);
+    bytes.clear();
+    vc::WriteSessionDelta(session, next, &bytes);
+    if (!Decode(bytes, &replica) || !(replica == next)) {
+      std::printf("  FAIL: delta %d does not reproduce the change\n", i);
+      ok = false;
+    }
+    session = next;
+  }
+
+  bytes.clear();
+  SessionDescription same = session;
+  same.version++;
+  vc::WriteSessionDelta(session, same, &bytes);
+  vc::SignalingMessage message;
+  if (bytes.size() != 16 || !message.Parse(bytes.data(), bytes.size()) ||
+      message.op_count() != 0 || message.has_codecs()) {
+    std::printf("  FAIL: an empty delta is %zu bytes\n", bytes.size());
+    ok = false;
+  }
+
+  // A delta for another version is refused without touching the state.
+  SessionDescription stale = replica;
+  stale.version -= 1;
+  const SessionDescription before = stale;
+  bytes.clear();
+  SessionDescription next = replica;
+  Mutate(&next, &next_id, rng);
+  vc::WriteSessionDelta(replica, next, &bytes);
+  if (Decode(bytes, &stale) || !(stale == before)) {
+    std::printf("  FAIL: delta applied to the wrong version\n");
+    ok = false;
+  }
+  return ok;
+}
+
+bool CheckCorruption(std::mt19937* rng) {
+  bool ok = true;
+  uint32_t next_id;
+  const SessionDescription session = Room(20, rng, &next_id);
+  SessionDescription next = session;
+  Mutate(&next, &next_id, rng);
+  std::vector<uint8_t> snapshot, delta;
+  vc::WriteSessionSnapshot(session, &snapshot);
+  vc::WriteSessionDelta(session, next, &delta);
+  for (const std::vector<uint8_t>* bytes : {&snapshot, &delta}) {
+    vc::SignalingMessage message;
+    for (size_t size = 0; size < bytes->size(); ++size) {
+      if (message.Parse(bytes->data(), size)) {
+        std::printf("  FAIL: message truncated to %zu of %zu bytes parsed\n", size,
+                    bytes->size());
+        ok = false;
+        break;
+      }
+    }
+    std::vector<uint8_t> longer = *bytes;
+    longer.push_back(0);
+    if (message.Parse(longer.data(), longer.size())) {
+      std::printf("  FAIL: trailing byte accepted\n");
+      ok = false;
+    }
+  }
+  // The first op of the snapshot starts after the header and codec table;
+  // the high byte of its field mask is at +6.
+  std::vector<uint8_t> bad = snapshot;
+  bad[16 + 12 * session.codecs.size() + 6] |= 0x80;
+  vc::SignalingMessage message;
+  if (message.Parse(bad.data(), bad.size())) {
+    std::printf("  FAIL: unknown field bit accepted\n");
+    ok = false;
+  }
+  bad = snapshot;
+  bad[16 + 12 * session.codecs.size()] = 9;
+  if (message.Parse(bad.data(), bad.size())) {
+    std::printf("  FAIL: unknown op accepted\n");
+    ok = false;
+  }
+  return ok;
+}
+
+template <typename F>
+double TimeUs(int iterations, F&& f) {
+  const double start = vc::CpuNowMs();
+  for (int i = 0; i < iterations; ++i) f();
+  return (vc::CpuNowMs() - start) * 1e3 / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  std::mt19937 rng(7);
+  bool ok = CheckRoundTrips(&rng);
+  ok = CheckCorruption(&rng) && ok;
+
+  std::printf("\n%-6s %9s %9s %6s %5s | %9s %9s %9s %9s | %11s %11s\n", "tracks", "SDP B",
+              "snap B", "join B", "mute", "SDP us", "snap us", "join us", "mute us",
+              "room SDP KB", "room bin KB");
+  const int sizes[] = {10, 50, 100, 200};
+  for (int tracks : sizes) {
+    uint32_t next_id;
+    const SessionDescription room = Room(tracks, &rng, &next_id);
+    SessionDescription joined = room;
+    AddParticipant(&joined, &next_id, &rng);
+    joined.version++;
+    SessionDescription left = room;
+    left.version += 2;
+    SessionDescription muted = room;
+    muted.tracks[0].muted = true;
+    muted.version++;
+
+    const std::string sdp = WriteSdp(room);
+    std::vector<uint8_t> snapshot, join, leave, mute, unmute;
+    vc::WriteSessionSnapshot(room, &snapshot);
+    vc::WriteSessionDelta(room, joined, &join);
+    vc::WriteSessionDelta(joined, left, &leave);
+    vc::WriteSessionDelta(room, muted, &mute);
+    vc::WriteSessionDelta(muted, room, &unmute);
+
+    const int iterations = (check ? 20000 : 100000) / tracks;
+    SessionDescription parsed;
+    const double sdp_us = TimeUs(iterations, [&] { ok = ParseSdp(sdp, &parsed) && ok; });
+    const double snapshot_us = TimeUs(iterations, [&] { ok = Decode(snapshot, &parsed) && ok; });
+
+    // Join then leave, so the state returns to where it started; the leave
+    // delta takes it to a new version, so patch the next join's base.
+    SessionDescription state = room;
+    const double join_us = TimeUs(iterations * 20, [&] {
+      state.version = room.version;
+      ok = Decode(join, &state) && ok;
+      ok = Decode(leave, &state) && ok;
+    }) / 2;
+    state = room;
+    const double mute_us = TimeUs(iterations * 20, [&] {
+      state.version = room.version;
+      ok = Decode(mute, &state) && ok;
+      ok = Decode(unmute, &state) && ok;
+    }) / 2;
+
+    // A join makes every client renegotiate: each receives the whole offer,
+    // against one delta each.
+    const double participants = tracks / 2.0 + 1;
+    std::printf("%-6d %9zu %9zu %6zu %5zu | %9.1f %9.2f %9.3f %9.3f | %11.0f %11.1f\n",
+                tracks, sdp.size(), snapshot.size(), join.size(), mute.size(), sdp_us,
+                snapshot_us, join_us, mute_us, participants * sdp.size() / 1024.0,
+                participants * join.size() / 1024.0);
+
+    if (snapshot.size() * 10 > sdp.size()) {
+      std::printf("  FAIL: snapshot is over a tenth of the SDP at %d tracks\n", tracks);
+      ok = false;
+    }
+    if (join.size() > 160 || mute.size() > 32) {
+      std::printf("  FAIL: join delta %zu bytes, mute delta %zu bytes\n", join.size(),
+                  mute.size());
+      ok = false;
+    }
+    if (snapshot_us * 5 > sdp_us) {
+      std::printf("  FAIL: snapshot decode not 5x faster than SDP parsing at %d tracks\n",
+                  tracks);
+      ok = false;
+    }
+    if (join_us * 100 > sdp_us) {
+      std::printf("  FAIL: join delta not 100x faster than SDP parsing at %d tracks\n", tracks);
+      ok = false;
+    }
+  }
+  return check && !ok ? 1 : 0;
+}
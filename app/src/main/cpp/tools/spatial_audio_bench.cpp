@@ -0,0 +1,121 @@
+// Measures CPU per stream of the spatial audio renderer at 48 kHz and checks
+// its output against direct time-domain convolution.
+//
+//   spatial_audio_bench [--check]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "audio/hrtf.h"
+#include "audio/spatial_audio_renderer.h"
+
+namespace {
+
+constexpr int kSampleRate = 48000;
+constexpr int kFrame = kSampleRate / 100;
+constexpr int kHrirLength = 256;
+
+std::vector<float> Noise(int n, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> d(0.0f, 0.1f);
+  std::vector<float> v(n);
+  for (float& x : v) x = d(rng);
+  return v;
+}
+
+// Renders one stream at `azimuth` and compares with direct convolution.
+bool CheckAgainstDirect(const vc::HrtfSet& hrtf, float azimuth,
+                        double* max_error, double* right_to_left_db) {
+  vc::SpatialAudioRenderer::Config config;
+  vc::SpatialAudioRenderer renderer(hrtf, config);
+  int id = renderer.AddStream(azimuth);
+  const int frames = 50;
+  std::vector<float> input = Noise(frames * kFrame, 7);
+  std::vector<float> output(2 * frames * kFrame);
+  std::vector<const float*> inputs(config.max_streams, nullptr);
+  for (int f = 0; f < frames; ++f) {
+    inputs[id] = input.data() + f * kFrame;
+    renderer.Render(inputs.data(), kFrame, output.data() + 2 * f * kFrame);
+  }
+
+  const vc::HrtfSet::Direction& dir = hrtf.direction(hrtf.NearestIndex(azimuth));
+  int latency = renderer.latency_samples();
+  double error = 0.0, energy[2] = {0.0, 0.0};
+  for (int n = latency; n < frames * kFrame; ++n) {
+    int t = n - latency;
+    for (int ear = 0; ear < 2; ++ear) {
+      const std::vector<float>& h = ear == 0 ? dir.left : dir.right;
+      double y = 0.0;
+      for (int k = 0; k < kHrirLength && k <= t; ++k) y += h[k] * input[t - k];
+      double got = output[2 * n + ear];
+      error = std::max(error, std::fabs(got - y));
+      energy[ear] += got * got;
+    }
+  }
+  *max_error = error;
+  *right_to_left_db = 10.0 * std::log10(energy[1] / energy[0]);
+  return error < 1e-3;
+}
+
+double MicrosPerFrame(const vc::HrtfSet& hrtf, int streams, int spatialized,
+                      int frames) {
+  vc::SpatialAudioRenderer::Config config;
+  config.max_spatialized = spatialized;
+  vc::SpatialAudioRenderer renderer(hrtf, config);
+  std::vector<std::vector<float>> audio;
+  std::vector<const float*> inputs(config.max_streams, nullptr);
+  for (int i = 0; i < streams; ++i) {
+    int id = renderer.AddStream(
+        vc::SpatialAudioRenderer::AzimuthForTile(i % 5, 5, 60.0f));
+    audio.push_back(Noise(kFrame, 100 + i));
+    inputs[id] = audio.back().data();
+  }
+  std::vector<float> output(2 * kFrame);
+  for (int f = 0; f < 20; ++f) renderer.Render(inputs.data(), kFrame, output.data());
+
+  auto start = std::chrono::steady_clock::now();
+  for (int f = 0; f < frames; ++f) {
+    renderer.Render(inputs.data(), kFrame, output.data());
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::micro>(elapsed).count() / frames;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  vc::HrtfSet hrtf = vc::HrtfSet::SphericalHead(kSampleRate, kHrirLength, 5.0f);
+  bool ok = true;
+
+  double error = 0.0, ild = 0.0;
+  if (!CheckAgainstDirect(hrtf, 60.0f, &error, &ild)) {
+    std::printf("FAIL: partitioned convolution differs from direct (%.2e)\n",
+                error);
+    ok = false;
+  }
+  if (ild < 3.0) {
+    std::printf("FAIL: source at +60 deg is not louder on the right (%.1f dB)\n",
+                ild);
+    ok = false;
+  }
+  std::printf("convolution max error %.2e, +60 deg right/left %.1f dB\n\n",
+              error, ild);
+
+  const int frames = check ? 200 : 3000;
+  const int counts[] = {1, 2, 4, 8, 16, 32};
+  std::printf("%8s %12s %14s %14s %10s\n", "streams", "spatialized",
+              "us/10ms frame", "us/stream", "%realtime");
+  for (int limit : {4, 32}) {
+    for (int n : counts) {
+      double us = MicrosPerFrame(hrtf, n, limit, frames);
+      std::printf("%8d %12d %14.1f %14.2f %9.2f%%\n", n, std::min(n, limit), us,
+                  us / n, us / 100.0);
+    }
+  }
+  return check && !ok ? 1 : 0;
+}
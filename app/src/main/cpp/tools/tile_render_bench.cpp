@@ -0,0 +1,273 @@
+// CPU gallery rendering into a 1280x720 memory render target: 4, 9 and 25
+// participants (640x360 sources, 320x180 for the 25-tile grid) are scaled,
+// converted to RGBA and composed into one buffer per output frame. Reports
+// ms per composed frame and raw I420-to-RGBA throughput, and checks the
+// conversion against a per-pixel scalar run and BT.601 reference colours,
+// the grid layout (in bounds, no overlaps, equal cells) and that tiles land
+// in their cells with the background in the gaps, and compares scaled
+// tiles with ScaleFrameBilinear.
+//
+//   tile_render_bench [--check]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "tools/cpu_time.h"
+#include "video/i420_frame.h"
+#include "video/render_target.h"
+#include "video/tile_compositor.h"
+#include "video/yuv_to_rgba.h"
+
+namespace {
+
+constexpr int kWidth = 1280;
+constexpr int kHeight = 720;
+
+void FillFlat(vc::I420Frame* f, int y, int u, int v) {
+  std::memset(f->y(), y, static_cast<size_t>(f->stride_y()) * f->height());
+  std::memset(f->u(), u, static_cast<size_t>(f->stride_uv()) * f->chroma_height());
+  std::memset(f->v(), v, static_cast<size_t>(f->stride_uv()) * f->chroma_height());
+}
+
+// A participant-like picture: shaded background, a bright oval for a face
+// and some texture, different per seed.
+void RenderParticipant(vc::I420Frame* f, int seed) {
+  std::mt19937 rng(seed);
+  const int cx = f->width() / 2 + static_cast<int>(rng() % 41) - 20;
+  const int cy = f->height() * 2 / 5;
+  const double rx = f->width() * 0.14, ry = f->height() * 0.3;
+  for (int y = 0; y < f->height(); ++y) {
+    for (int x = 0; x < f->width(); ++x) {
+      const double dx = (x - cx) / rx, dy = (y - cy) / ry;
+      int v = 60 + (x * 50) / f->width() + (y * 30) / f->height();
+      if (dx * dx + dy * dy < 1.0) v = 170 + ((x ^ y) & 7);
+      v += static_cast<int>(rng() % 9) - 4;
+      f->y()[static_cast<size_t>(y) * f->stride_y() + x] =
+          static_cast<uint8_t>(std::clamp(v, 16, 235));
+    }
+  }
+  const int u = 100 + seed % 50, v = 140 - seed % 30;
+  for (int y = 0; y < f->chroma_height(); ++y) {
+    for (int x = 0; x < f->chroma_width(); ++x) {
+      const size_t k = static_cast<size_t>(y) * f->stride_uv() + x;
+      f->u()[k] = static_cast<uint8_t>(u + (x * 20) / f->chroma_width());
+      f->v()[k] = static_cast<uint8_t>(v - (y * 20) / f->chroma_height());
+    }
+  }
+}
+
+bool RgbNear(const uint8_t* px, int r, int g, int b, int tolerance) {
+  return std::abs(px[0] - r) <= tolerance && std::abs(px[1] - g) <= tolerance &&
+         std::abs(px[2] - b) <= tolerance && px[3] == 255;
+}
+
+bool CheckConversion() {
+  bool ok = true;
+  // The SIMD body against the scalar tail, one pixel at a time.
+  std::mt19937 rng(5);
+  for (int width : {1, 15, 17, 33, 127, 641}) {
+    std::vector<uint8_t> y(width), u((width + 1) / 2), v((width + 1) / 2);
+    for (auto& s : y) s = static_cast<uint8_t>(rng());
+    for (auto& s : u) s = static_cast<uint8_t>(rng());
+    for (auto& s : v) s = static_cast<uint8_t>(rng());
+    std::vector<uint8_t> row(4 * width), pixel(4);
+    vc::I420RowToRgba(y.data(), u.data(), v.data(), row.data(), width);
+    for (int x = 0; x < width; ++x) {
+      vc::I420RowToRgba(&y[x], &u[x / 2], &v[x / 2], pixel.data(), 1);
+      if (std::memcmp(&row[4 * x], pixel.data(), 4) != 0) {
+        std::printf("  FAIL: width %d pixel %d differs from the scalar path\n", width, x);
+        ok = false;
+        break;
+      }
+    }
+  }
+  // Reference colours: black, white, grey and the BT.601 primaries.
+  struct Colour {
+    const char* name;
+    int y, u, v, r, g, b;
+  };
+  const Colour colours[] = {
+      {"black", 16, 128, 128, 0, 0, 0},       {"white", 235, 128, 128, 255, 255, 255},
+      {"grey", 126, 128, 128, 128, 128, 128}, {"red", 81, 90, 240, 255, 0, 0},
+      {"green", 145, 54, 34, 0, 255, 0},      {"blue", 41, 240, 110, 0, 0, 255},
+  };
+  for (const Colour& c : colours) {
+    vc::I420Frame frame(18, 2);
+    FillFlat(&frame, c.y, c.u, c.v);
+    std::vector<uint8_t> rgba(18 * 2 * 4);
+    vc::I420ToRgba(frame, rgba.data(), 18 * 4);
+    if (!RgbNear(&rgba[4 * 17], c.r, c.g, c.b, 3)) {
+      std::printf("  FAIL: %s converts to %d,%d,%d\n", c.name, rgba[68], rgba[69],
+                  rgba[70]);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+bool CheckLayout() {
+  bool ok = true;
+  for (int tiles = 1; tiles <= 25; ++tiles) {
+    const auto cells = vc::TileCompositor::GridLayout(tiles, kWidth, kHeight, 4, 16.0f / 9);
+    bool good = static_cast<int>(cells.size()) == tiles;
+    for (size_t i = 0; good && i < cells.size(); ++i) {
+      const vc::TileRect& a = cells[i];
+      good = a.x >= 0 && a.y >= 0 && a.x + a.width <= kWidth &&
+             a.y + a.height <= kHeight && a.width == cells[0].width &&
+             a.height == cells[0].height && a.width > 0;
+      for (size_t j = 0; good && j < i; ++j) {
+        const vc::TileRect& b = cells[j];
+        good = a.x >= b.x + b.width || b.x >= a.x + a.width || a.y >= b.y + b.height ||
+               b.y >= a.y + a.height;
+      }
+    }
+    if (!good) {
+      std::printf("  FAIL: bad layout for %d tiles\n", tiles);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+// Flat tiles of distinct colours in a 3x3 grid: the centre of each cell has
+// its tile's colour and the gaps between cells the background.
+bool CheckPlacement() {
+  bool ok = true;
+  for (auto fit : {vc::TileCompositor::Fit::kCrop, vc::TileCompositor::Fit::kLetterbox}) {
+    vc::TileCompositor::Config config;
+    config.fit = fit;
+    vc::TileCompositor compositor(config);
+    std::vector<vc::I420Frame> frames(9);
+    std::vector<const vc::I420Frame*> tiles(9);
+    for (int i = 0; i < 9; ++i) {
+      frames[i].Allocate(i % 2 ? 480 : 640, 360);
+      FillFlat(&frames[i], 40 + i * 20, 128, 128);
+      tiles[i] = &frames[i];
+    }
+    tiles[4] = nullptr;  // an empty cell
+    vc::MemoryRenderTarget target(kWidth, kHeight);
+    if (!compositor.Compose(tiles.data(), 9, &target) || target.posted_frames() != 1) {
+      std::printf("  FAIL: compose did not post\n");
+      return false;
+    }
+    const vc::RgbaBuffer& buffer = target.buffer();
+    auto at = [&](int x, int y) {
+      return buffer.pixels + static_cast<size_t>(y) * buffer.stride + 4 * x;
+    };
+    const auto cells = vc::TileCompositor::GridLayout(9, kWidth, kHeight, config.gap,
+                                                      config.cell_aspect);
+    for (int i = 0; i < 9; ++i) {
+      const vc::TileRect& c = cells[i];
+      uint8_t expected[4];
+      vc::I420RowToRgba(frames[i].y(), frames[i].u(), frames[i].v(), expected, 1);
+      const uint8_t* centre = at(c.x + c.width / 2, c.y + c.height / 2);
+      const bool good = i == 4 ? RgbNear(centre, 24, 24, 24, 0)
+                               : RgbNear(centre, expected[0], expected[1], expected[2], 2);
+      const uint8_t* gap = at(c.x + c.width + 1, c.y + c.height / 2);
+      if (!good || !RgbNear(gap, 24, 24, 24, 0)) {
+        std::printf("  FAIL: %s cell %d centre %d,%d,%d gap %d,%d,%d\n",
+                    fit == vc::TileCompositor::Fit::kCrop ? "crop" : "letterbox", i,
+                    centre[0], centre[1], centre[2], gap[0], gap[1], gap[2]);
+        ok = false;
+      }
+      // 4:3 tiles letterbox with bars at the cell's sides.
+      if (fit == vc::TileCompositor::Fit::kLetterbox && i % 2 == 1) {
+        if (!RgbNear(at(c.x + 2, c.y + c.height / 2), 24, 24, 24, 0)) {
+          std::printf("  FAIL: no letterbox bar in cell %d\n", i);
+          ok = false;
+        }
+      } else if (i != 4 &&
+                 !RgbNear(at(c.x + 2, c.y + c.height / 2), expected[0], expected[1],
+                          expected[2], 2)) {
+        std::printf("  FAIL: cell %d not filled to its edge\n", i);
+        ok = false;
+      }
+    }
+  }
+  return ok;
+}
+
+// DrawTile at 1:1 must reproduce the plain conversion exactly, and at 1/2
+// stay close to ScaleFrameBilinear followed by the conversion.
+bool CheckScaling() {
+  bool ok = true;
+  vc::I420Frame frame(640, 360);
+  RenderParticipant(&frame, 3);
+  for (int scale : {1, 2}) {
+    const int w = 640 / scale, h = 360 / scale;
+    vc::I420Frame scaled(w, h);
+    vc::ScaleFrameBilinear(frame, &scaled);
+    std::vector<uint8_t> reference(static_cast<size_t>(w) * h * 4);
+    vc::I420ToRgba(scaled, reference.data(), w * 4);
+    vc::MemoryRenderTarget target(w, h);
+    vc::TileCompositor compositor;
+    compositor.DrawTile(frame, {0, 0, w, h}, target.buffer());
+    double diff = 0;
+    for (size_t i = 0; i < reference.size(); ++i) {
+      diff += std::abs(reference[i] - target.buffer().pixels[i]);
+    }
+    diff /= reference.size();
+    std::printf("draw at 1/%d: mean abs difference %.3f\n", scale, diff);
+    if (scale == 1 ? diff != 0.0 : diff > 1.5) {
+      std::printf("  FAIL: scaled tile differs from the reference\n");
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  const int frames = check ? 30 : 200;
+  bool ok = CheckConversion();
+  ok = CheckLayout() && ok;
+  ok = CheckPlacement() && ok;
+  ok = CheckScaling() && ok;
+
+  {
+    vc::I420Frame frame(kWidth, kHeight);
+    RenderParticipant(&frame, 1);
+    std::vector<uint8_t> rgba(static_cast<size_t>(kWidth) * kHeight * 4);
+    const double start = vc::CpuNowMs();
+    for (int i = 0; i < frames; ++i) vc::I420ToRgba(frame, rgba.data(), kWidth * 4);
+    const double ms = (vc::CpuNowMs() - start) / frames;
+    std::printf("I420 to RGBA 720p: %.3f ms per frame, %.0f Mpixel/s\n", ms,
+                kWidth * kHeight / (ms * 1e3));
+  }
+
+  std::printf("\n%-6s %-9s %12s\n", "tiles", "source", "ms/frame");
+  struct Grid {
+    int tiles, width, height;
+    double max_ms;
+  };
+  const Grid grids[] = {{4, 640, 360, 8.0}, {9, 640, 360, 8.0}, {25, 320, 180, 8.0}};
+  for (const Grid& grid : grids) {
+    std::vector<vc::I420Frame> sources(grid.tiles);
+    std::vector<const vc::I420Frame*> tiles(grid.tiles);
+    for (int i = 0; i < grid.tiles; ++i) {
+      sources[i].Allocate(grid.width, grid.height);
+      RenderParticipant(&sources[i], i + 1);
+      tiles[i] = &sources[i];
+    }
+    vc::TileCompositor compositor;
+    vc::MemoryRenderTarget target(kWidth, kHeight);
+    compositor.Compose(tiles.data(), grid.tiles, &target);  // warm-up
+    const double start = vc::CpuNowMs();
+    for (int i = 0; i < frames; ++i) compositor.Compose(tiles.data(), grid.tiles, &target);
+    const double ms = (vc::CpuNowMs() - start) / frames;
+    std::printf("%-6d %4dx%-4d %12.3f\n", grid.tiles, grid.width, grid.height, ms);
+    if (ms > grid.max_ms) {
+      std::printf("  FAIL: composing %d tiles takes over %.1f ms\n", grid.tiles,
+                  grid.max_ms);
+      ok = false;
+    }
+  }
+  return check && !ok ? 1 : 0;
+}
@@ -0,0 +1,480 @@
+// Firebase ID token verification for the signaling server against an
+// in-process stand-in for Google's securetoken JWKS endpoint, serving two
+// 2048-bit test keys (generated for this tool; they sign nothing else).
+// Tokens are minted here with the private exponents. Checks that valid
+// tokens verify and that tampered, expired, misdirected and alg-none tokens
+// are rejected (claim failures without an RSA operation), key rotation with
+// one refetch, rate-limited refetches for unknown kids, single-flight
+// fetches under concurrent connects, key max-age and stale keys on fetch
+// failure, cache hits and expiry, and batch results and de-duplication.
+// Reports verifications per second cold (RSA per token), from the
+// verified-token cache and batched.
+//
+//   token_verifier_bench [--check]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "signaling/base64url.h"
+#include "signaling/rsa.h"
+#include "signaling/sha256.h"
+#include "signaling/token_verifier.h"
+#include "tools/cpu_time.h"
+
+namespace {
+
+// openssl genrsa 2048; e = 65537.
+constexpr char kKeyAN[] =
+    "b38ac56398a89b97c7635ba6cfa06f5dfa4cfc5be8528374210f97ed310a6392"
+    "5730640c9b0ac8494fb3de30113b8a7fe6f926943e186645153be7c0976f3818"
+    "11e1861be247847347c307b17ff1342aa79bdb7227c67e90b9e37b4fb956de24"
+    "a1d2112e1d5b82dea3d85e8b461400510ff3080a9b20a290978c0d528bfd2664"
+    "4aa08f784e46a0ce3b55e4a0049f1f3f37dbfe9ffab2b9d9ef1019049aedb536"
+    "3bdb0751f02c30277133c87ad29656c7bf27346ce30f06cb818bab1987c18bbe"
+    "58f410d478ca3b9c31f6daaccf19345d317981ace09638e7340099f7ce157b03"
+    "d8fe70c1c000cd261e06a369537b3fe91a4f870d877f0209a6e2c0306212a66f";
+constexpr char kKeyAD[] =
+    "4cd452e06a48a8805c31dfdbf3984f5fd346d36cceef545242fd85c159cd7ccb"
+    "7824fc834a6b6446bee514ecd3cafb5afd2f5bfb6ed1091e81d627378a75ecf6"
+    "9bdc3a83bf226482e2500a8041e42933219337e653300524106fd06a4ec0e601"
+    "9dffa31b6d33a63e78b593cb9c7adda1d2a5e8a88536836a45778891ecd6b0f0"
+    "dd2100c415b818c09017dc9f3c51351c3e37a551a9ba82a2b4da94a6a7ac208c"
+    "0940fe96e05ed40d2844839685291d3dd54c38ca59943613411b948d36de27ac"
+    "ad678d758aa9b2a201b16fe2f9f922ead35acca7cd254593f6d9ec9a7dc77fd7"
+    "c290e6dd0f09fb5fc2126b166c9bad551231550d164ea229dfadec0209c67b79";
+constexpr char kKeyBN[] =
+    "bd104a767cc1c99770f2afb887f9525678685a8cbd575035d69c3ce218ad9851"
+    "3e73ae00583bb9374615f455b28b13670a7f6e934eed3f1d8dfbe5118e24f868"
+    "f7bbbaec2ca2cd989e19d8220bc1dbad836390de5de19ee8244bf3ae17056fc1"
+    "0bea644d8f3c18e6b91ebea413ebd015aa8aa562fac55f567df2da31f646cbb4"
+    "217b471dd8895aa870b140f3d8681c66267066c2bc4806cf0ad5087b68b15363"
+    "6ad91bf9f34d2a0f75f8e4dcd03e10ea867747d409f51cc5e4def3148e2b296e"
+    "262abc7cb515cf39ad9139a6ca3e2ebfd1c7f4825285d777b67c9a05c0f45cb1"
+    "c69c8e1c890f547415b852d2700de2047cb44a18f4c663ae26845b5680e04f6d";
+constexpr char kKeyBD[] =
+    "01967e30461120ec0e6fb4b045a614a8b36caef1567d6ca7f3198f5257cce21b"
+    "5be7fffab29857d07771ce4247a9aedbf344dee275012841f6341023085baba1"
+    "6d63e1d343770a3d2bfb6c15b1c86af0fcb4ec9dcd7c8c5cdc972db5ffd7ff6d"
+    "b28d0152d1c48fb1fa5fe0252e775121541ec37a5415adc76319e92163ca8997"
+    "41ea7bcfb32ef58d579dca7aeaf8855e12adb0ef6de56ca2cfd52b0c3c546bf0"
+    "e2c36db10bb1b12be74b1d1a227e3e588eb838e34c20ed79a1a9adbc99090996"
+    "ed519bf6a73517679b476c1fecd791203af85e73aa341df43c336973fa61bc7d"
+    "7c61d8089f36df0d1bfd1f97b61d9a9de43e5f389ecaf22007e9efc78b666409";
+
+constexpr char kProject[] = "vc-test-project";
+constexpr int64_t kStartMs = 1760000000000;
+constexpr uint8_t kExponent[] = {0x01, 0x00, 0x01};
+constexpr uint8_t kSha256DigestInfo[] = {0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60,
+                                         0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02,
+                                         0x01, 0x05, 0x00, 0x04, 0x20};
+
+double WallNowMs() {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+std::vector<uint8_t> FromHex(const char* hex) {
+  std::vector<uint8_t> out;
+  for (size_t i = 0; hex[i] && hex[i + 1]; i += 2) {
+    auto nibble = [](char c) { return c <= '9' ? c - '0' : c - 'a' + 10; };
+    out.push_back(static_cast<uint8_t>(nibble(hex[i]) << 4 | nibble(hex[i + 1])));
+  }
+  return out;
+}
+
+struct TestKey {
+  TestKey(const char* kid_, const char* n_hex, const char* d_hex)
+      : kid(kid_), n(FromHex(n_hex)), d(FromHex(d_hex)), modulus(n.data(), n.size()) {}
+
+  std::string kid;
+  std::vector<uint8_t> n;
+  std::vector<uint8_t> d;
+  vc::RsaModulus modulus;
+};
+
+struct Claims {
+  std::string alg = "RS256";
+  std::string aud = kProject;
+  std::string iss = std::string("https://securetoken.google.com/") + kProject;
+  std::string sub;
+  int64_t iat_s = 0;
+  int64_t exp_s = 0;
+};
+
+// A token as Firebase Auth issues them, signed with `key`'s private exponent.
+std::string Mint(const TestKey& key, const Claims& c) {
+  const std::string header =
+      "{\"alg\":\"" + c.alg + "\",\"kid\":\"" + key.kid + "\",\"typ\":\"JWT\"}";
+  const std::string payload =
+      "{\"iss\":\"" + c.iss + "\",\"aud\":\"" + c.aud + "\",\"auth_time\":" +
+      std::to_string(c.iat_s) + ",\"user_id\":\"" + c.sub + "\",\"sub\":\"" + c.sub +
+      "\",\"iat\":" + std::to_string(c.iat_s) + ",\"exp\":" + std::to_string(c.exp_s) +
+      ",\"firebase\":{\"identities\":{},\"sign_in_provider\":\"google.com\"}}";
+  const std::string input = vc::Base64UrlEncode(header) + "." + vc::Base64UrlEncode(payload);
+  const vc::Sha256Digest digest = vc::Sha256::Hash(input);
+  const size_t k = key.modulus.size_bytes();
+  std::vector<uint8_t> em(k, 0xff);
+  em[0] = 0x00;
+  em[1] = 0x01;
+  const size_t t_len = sizeof(kSha256DigestInfo) + digest.size();
+  em[k - t_len - 1] = 0x00;
+  std::memcpy(&em[k - t_len], kSha256DigestInfo, sizeof(kSha256DigestInfo));
+  std::memcpy(&em[k - digest.size()], digest.data(), digest.size());
+  std::vector<uint8_t> signature;
+  key.modulus.ModExp(em.data(), em.size(), key.d.data(), key.d.size(), &signature);
+  return input + "." + vc::Base64UrlEncode(signature.data(), signature.size());
+}
+
+Claims ValidClaims(const std::string& uid, int64_t now_ms) {
+  Claims c;
+  c.sub = uid;
+  c.iat_s = now_ms / 1000 - 10;
+  c.exp_s = c.iat_s + 3600;
+  return c;
+}
+
+// Stands in for https://www.googleapis.com/service_accounts/v1/jwk/
+// securetoken@system.gserviceaccount.com.
+class KeyServer {
+ public:
+  void Publish(const std::vector<const TestKey*>& keys) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    keys_ = keys;
+  }
+  void set_max_age_s(int64_t s) { max_age_s_ = s; }
+  void set_failing(bool failing) { failing_ = failing; }
+  void set_delay_ms(int ms) { delay_ms_ = ms; }
+  int fetches() const { return fetches_; }
+
+  vc::FirebaseTokenVerifier::KeyFetcher Fetcher() {
+    return [this](std::string* body, int64_t* max_age_s) { return Serve(body, max_age_s); };
+  }
+
+ private:
+  bool Serve(std::string* body, int64_t* max_age_s) {
+    ++fetches_;
+    if (delay_ms_ > 0) std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms_));
+    if (failing_) return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    *body = "{\"keys\":[";
+    for (size_t i = 0; i < keys_.size(); ++i) {
+      if (i > 0) *body += ",";
+      *body += "{\"kty\":\"RSA\",\"alg\":\"RS256\",\"use\":\"sig\",\"kid\":\"" + keys_[i]->kid +
+               "\",\"n\":\"" + vc::Base64UrlEncode(keys_[i]->n.data(), keys_[i]->n.size()) +
+               "\",\"e\":\"" + vc::Base64UrlEncode(kExponent, sizeof(kExponent)) + "\"}";
+    }
+    *body += "]}";
+    *max_age_s = max_age_s_;
+    return true;
+  }
+
+  std::mutex mutex_;
+  std::vector<const TestKey*> keys_;
+  int64_t max_age_s_ = 21600;
+  std::atomic<bool> failing_{false};
+  int delay_ms_ = 0;
+  std::atomic<int> fetches_{0};
+};
+
+vc::FirebaseTokenVerifier::Config TestConfig() {
+  vc::FirebaseTokenVerifier::Config config;
+  config.project_id = kProject;
+  return config;
+}
+
+bool Expect(bool condition, const char* what) {
+  if (!condition) std::printf("  FAIL: %s\n", what);
+  return condition;
+}
+
+bool ExpectStatus(const vc::VerifiedToken& result, vc::TokenStatus want, const char* what) {
+  if (result.status == want) return true;
+  std::printf("  FAIL: %s: %s, expected %s\n", what, vc::TokenStatusName(result.status),
+              vc::TokenStatusName(want));
+  return false;
+}
+
+bool CheckClaims(const TestKey& key) {
+  KeyServer server;
+  server.Publish({&key});
+  int64_t now_ms = kStartMs;
+  vc::FirebaseTokenVerifier verifier(TestConfig(), server.Fetcher(), [&] { return now_ms; });
+
+  bool ok = true;
+  const std::string token = Mint(key, ValidClaims("alice", now_ms));
+  vc::VerifiedToken r = verifier.Verify(token);
+  ok = ExpectStatus(r, vc::TokenStatus::kValid, "valid token") && ok;
+  ok = Expect(r.uid == "alice" && !r.cached, "valid token uid") && ok;
+  r = verifier.Verify(token);
+  ok = Expect(r.ok() && r.cached && r.uid == "alice", "second verify from cache") && ok;
+  ok = Expect(verifier.GetStats().signature_checks == 1, "cache hit checked a signature") && ok;
+
+  // Payload swapped for another user's, signature kept.
+  const std::string other = Mint(key, ValidClaims("mallory", now_ms));
+  const std::string spliced =
+      other.substr(0, other.rfind('.')) + token.substr(token.rfind('.'));
+  ok = ExpectStatus(verifier.Verify(spliced), vc::TokenStatus::kBadSignature,
+                    "spliced payload") && ok;
+  std::string flipped = token;
+  flipped[flipped.size() - 10] = flipped[flipped.size() - 10] == 'A' ? 'B' : 'A';
+  ok = ExpectStatus(verifier.Verify(flipped), vc::TokenStatus::kBadSignature,
+                    "altered signature") && ok;
+
+  const int64_t checks = verifier.GetStats().signature_checks;
+  Claims c = ValidClaims("bob", now_ms);
+  c.exp_s = now_ms / 1000 - 120;
+  ok = ExpectStatus(verifier.Verify(Mint(key, c)), vc::TokenStatus::kExpired, "expired") && ok;
+  c = ValidClaims("bob", now_ms);
+  c.iat_s += 600;
+  ok = ExpectStatus(verifier.Verify(Mint(key, c)), vc::TokenStatus::kIssuedInFuture,
+                    "issued in the future") && ok;
+  c = ValidClaims("bob", now_ms);
+  c.aud = "some-other-project";
+  ok = ExpectStatus(verifier.Verify(Mint(key, c)), vc::TokenStatus::kWrongAudience,
+                    "wrong audience") && ok;
+  c = ValidClaims("bob", now_ms);
+  c.iss = "https://securetoken.google.com/some-other-project";
+  ok = ExpectStatus(verifier.Verify(Mint(key, c)), vc::TokenStatus::kWrongIssuer,
+                    "wrong issuer") && ok;
+  c = ValidClaims("", now_ms);
+  ok = ExpectStatus(verifier.Verify(Mint(key, c)), vc::TokenStatus::kBadSubject,
+                    "empty subject") && ok;
+  c = ValidClaims("bob", now_ms);
+  c.alg = "none";
+  ok = ExpectStatus(verifier.Verify(Mint(key, c)), vc::TokenStatus::kUnsupportedAlgorithm,
+                    "alg none") && ok;
+  ok = ExpectStatus(verifier.Verify("not.a-token"), vc::TokenStatus::kMalformed,
+                    "garbage") && ok;
+  ok = ExpectStatus(verifier.Verify(""), vc::TokenStatus::kMalformed, "empty") && ok;
+  ok = Expect(verifier.GetStats().signature_checks == checks,
+              "claim rejections ran an RSA operation") && ok;
+
+  // The cached token runs out at exp (plus the skew).
+  now_ms += 3600 * 1000 + 60 * 1000;
+  ok = ExpectStatus(verifier.Verify(token), vc::TokenStatus::kExpired, "cached token expired") &&
+       ok;
+  ok = Expect(verifier.cached_tokens() == 0, "expired token left in the cache") && ok;
+  return ok;
+}
+
+bool CheckKeyFetching(const TestKey& a, const TestKey& b) {
+  bool ok = true;
+  KeyServer server;
+  server.Publish({&a});
+  server.set_max_age_s(600);
+  int64_t now_ms = kStartMs;
+  vc::FirebaseTokenVerifier::Config config = TestConfig();
+  config.min_refetch_interval_ms = 30000;
+  vc::FirebaseTokenVerifier verifier(config, server.Fetcher(), [&] { return now_ms; });
+
+  ok = ExpectStatus(verifier.Verify(Mint(a, ValidClaims("u1", now_ms))), vc::TokenStatus::kValid,
+                    "first token") && ok;
+  ok = Expect(server.fetches() == 1, "first verify fetched once") && ok;
+
+  // Rotation: key b appears; the first token signed with it refetches.
+  now_ms += 60000;
+  server.Publish({&a, &b});
+  ok = ExpectStatus(verifier.Verify(Mint(b, ValidClaims("u2", now_ms))), vc::TokenStatus::kValid,
+                    "token with the rotated-in key") && ok;
+  ok = Expect(server.fetches() == 2, "rotation refetched once") && ok;
+
+  // A flood of unknown kids costs at most one fetch per interval.
+  TestKey bogus("bogus-kid", kKeyBN, kKeyBD);
+  const std::string forged = Mint(bogus, ValidClaims("u3", now_ms));
+  for (int i = 0; i < 200; ++i) {
+    if (verifier.Verify(forged).status != vc::TokenStatus::kUnknownKey) {
+      ok = Expect(false, "unknown kid accepted");
+      break;
+    }
+  }
+  ok = Expect(server.fetches() == 2, "unknown kids refetched within the interval") && ok;
+  now_ms += 31000;
+  verifier.Verify(forged);
+  ok = Expect(server.fetches() == 3, "unknown kid after the interval did not refetch") && ok;
+
+  // Max-age: the set expires and is refetched; if that fails the stale set
+  // stays in use.
+  now_ms += 601 * 1000;
+  server.set_failing(true);
+  ok = ExpectStatus(verifier.Verify(Mint(a, ValidClaims("u4", now_ms))), vc::TokenStatus::kValid,
+                    "stale keys after a failed refetch") && ok;
+  ok = Expect(server.fetches() == 4 && verifier.GetStats().key_fetch_failures == 1,
+              "expired key set not refetched") && ok;
+  server.set_failing(false);
+  now_ms += 31000;
+  ok = ExpectStatus(verifier.Verify(Mint(a, ValidClaims("u5", now_ms))), vc::TokenStatus::kValid,
+                    "after recovery") && ok;
+  ok = Expect(server.fetches() == 5, "key set not refetched after recovery") && ok;
+
+  KeyServer down;
+  down.set_failing(true);
+  vc::FirebaseTokenVerifier cold(TestConfig(), down.Fetcher(), [&] { return now_ms; });
+  ok = ExpectStatus(cold.Verify(Mint(a, ValidClaims("u6", now_ms))),
+                    vc::TokenStatus::kKeysUnavailable, "no keys ever fetched") && ok;
+
+  // Concurrent first connects share one fetch.
+  KeyServer slow;
+  slow.Publish({&a});
+  slow.set_delay_ms(30);
+  vc::FirebaseTokenVerifier shared(TestConfig(), slow.Fetcher(), [&] { return now_ms; });
+  std::vector<std::string> tokens;
+  for (int i = 0; i < 4; ++i) tokens.push_back(Mint(a, ValidClaims("c" + std::to_string(i), now_ms)));
+  std::atomic<int> valid{0};
+  std::vector<std::thread> threads;
+  for (const std::string& t : tokens) {
+    threads.emplace_back([&shared, &valid, &t] { valid += shared.Verify(t).ok(); });
+  }
+  for (std::thread& t : threads) t.join();
+  ok = Expect(valid == 4, "concurrent connects rejected") && ok;
+  ok = Expect(slow.fetches() == 1, "concurrent connects fetched more than once") && ok;
+  return ok;
+}
+
+bool CheckBatch(const TestKey& key, const std::vector<std::string>& tokens) {
+  KeyServer server;
+  server.Publish({&key});
+  vc::FirebaseTokenVerifier::Config config = TestConfig();
+  config.batch_threads = 3;
+  vc::FirebaseTokenVerifier verifier(config, server.Fetcher(), [] { return kStartMs; });
+
+  // Every token twice, plus rejections, in one burst.
+  std::vector<std::string> batch;
+  for (const std::string& t : tokens) batch.push_back(t);
+  for (const std::string& t : tokens) batch.push_back(t);
+  batch.push_back("garbage");
+  std::string bad = tokens[0];
+  bad[bad.size() - 5] = bad[bad.size() - 5] == 'A' ? 'B' : 'A';
+  batch.push_back(bad);
+  const std::vector<vc::VerifiedToken> results = verifier.VerifyBatch(batch);
+
+  bool ok = Expect(results.size() == batch.size(), "batch result count");
+  for (size_t i = 0; ok && i < 2 * tokens.size(); ++i) {
+    ok = Expect(results[i].ok() &&
+                    results[i].uid == "user" + std::to_string(i % tokens.size()),
+                "batched token not verified");
+  }
+  ok = ExpectStatus(results[batch.size() - 2], vc::TokenStatus::kMalformed, "batched garbage") &&
+       ok;
+  ok = ExpectStatus(results[batch.size() - 1], vc::TokenStatus::kBadSignature,
+                    "batched bad signature") && ok;
+  const vc::FirebaseTokenVerifier::Stats stats = verifier.GetStats();
+  ok = Expect(stats.signature_checks == static_cast<int64_t>(tokens.size()) + 1,
+              "duplicates in a batch verified more than once") && ok;
+  ok = Expect(server.fetches() == 1, "batch fetched keys more than once") && ok;
+
+  const std::vector<vc::VerifiedToken> again = verifier.VerifyBatch(batch);
+  ok = Expect(again[0].cached && verifier.GetStats().signature_checks == stats.signature_checks + 1,
+              "second batch not served from the cache") && ok;
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  const TestKey a("key-a", kKeyAN, kKeyAD);
+  const TestKey b("key-b", kKeyBN, kKeyBD);
+  if (!a.modulus.valid() || !b.modulus.valid()) {
+    std::printf("  FAIL: test keys did not load\n");
+    return 1;
+  }
+
+  // Minting costs a private-key operation (no CRT) per token, so the timed
+  // set is small and reused across fresh verifiers.
+  const int distinct = check ? 24 : 64;
+  std::vector<std::string> tokens;
+  for (int i = 0; i < distinct; ++i) {
+    tokens.push_back(Mint(a, ValidClaims("user" + std::to_string(i), kStartMs)));
+  }
+
+  bool ok = CheckClaims(a);
+  ok = CheckKeyFetching(a, b) && ok;
+  ok = CheckBatch(a, tokens) && ok;
+
+  KeyServer server;
+  server.Publish({&a, &b});
+  auto make_verifier = [&](int threads) {
+    vc::FirebaseTokenVerifier::Config config = TestConfig();
+    config.batch_threads = threads;
+    auto verifier = std::make_unique<vc::FirebaseTokenVerifier>(config, server.Fetcher(),
+                                                                [] { return kStartMs; });
+    verifier->RefreshKeys();
+    return verifier;
+  };
+
+  const int rounds = check ? 8 : 40;
+  double cold_ms = 0;
+  for (int r = 0; r < rounds; ++r) {
+    auto verifier = make_verifier(1);
+    const double start = vc::CpuNowMs();
+    for (const std::string& t : tokens) ok = verifier->Verify(t).ok() && ok;
+    cold_ms += vc::CpuNowMs() - start;
+  }
+  const double cold_rate = rounds * tokens.size() / cold_ms * 1e3;
+
+  auto warm = make_verifier(1);
+  for (const std::string& t : tokens) warm->Verify(t);
+  const int cached_rounds = check ? 2000 : 10000;
+  double start = vc::CpuNowMs();
+  for (int r = 0; r < cached_rounds; ++r) {
+    for (const std::string& t : tokens) ok = warm->Verify(t).cached && ok;
+  }
+  const double cached_rate = cached_rounds * tokens.size() / (vc::CpuNowMs() - start) * 1e3;
+
+  // Batches of 256 connects: every token several times over, as in a
+  // reconnect storm, cold and then warm.
+  std::vector<std::string> storm;
+  for (size_t i = 0; storm.size() < 256; ++i) storm.push_back(tokens[(i * 7) % tokens.size()]);
+  double batch_cold_ms = 0;
+  for (int r = 0; r < rounds; ++r) {
+    auto verifier = make_verifier(1);
+    start = vc::CpuNowMs();
+    for (const vc::VerifiedToken& v : verifier->VerifyBatch(storm)) ok = v.ok() && ok;
+    batch_cold_ms += vc::CpuNowMs() - start;
+  }
+  const double batch_cold_rate = rounds * storm.size() / batch_cold_ms * 1e3;
+  start = vc::CpuNowMs();
+  for (int r = 0; r < cached_rounds / 4; ++r) warm->VerifyBatch(storm);
+  const double batch_cached_rate =
+      cached_rounds / 4 * storm.size() / (vc::CpuNowMs() - start) * 1e3;
+
+  // All cores, wall clock: distinct tokens only, so every one is an RSA check.
+  double parallel_ms = 0;
+  for (int r = 0; r < rounds; ++r) {
+    auto verifier = make_verifier(0);
+    start = WallNowMs();
+    verifier->VerifyBatch(tokens);
+    parallel_ms += WallNowMs() - start;
+  }
+  const double parallel_rate = rounds * tokens.size() / parallel_ms * 1e3;
+
+  std::printf("\n%-34s %14s\n", "path", "verifications/s");
+  std::printf("%-34s %14.0f\n", "cold (RSA per token)", cold_rate);
+  std::printf("%-34s %14.0f\n", "cached (token hash hit)", cached_rate);
+  std::printf("%-34s %14.0f\n", "batch of 256, cold, duplicates", batch_cold_rate);
+  std::printf("%-34s %14.0f\n", "batch of 256, cached", batch_cached_rate);
+  std::printf("%-34s %14.0f  (%u threads, wall clock)\n", "batch, distinct, all cores",
+              parallel_rate, std::thread::hardware_concurrency());
+
+  if (cold_rate < 1000) {
+    std::printf("  FAIL: cold verification under 1000/s\n");
+    ok = false;
+  }
+  if (cached_rate < 20 * cold_rate) {
+    std::printf("  FAIL: cached verification not 20x faster than cold\n");
+    ok = false;
+  }
+  if (batch_cold_rate < 2 * cold_rate) {
+    std::printf("  FAIL: a batch with duplicates is not 2x faster than one by one\n");
+    ok = false;
+  }
+  return check && !ok ? 1 : 0;
+}
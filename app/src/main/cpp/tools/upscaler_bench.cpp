@@ -0,0 +1,318 @@
+// Display upscaling of low-resolution received video on synthetic 720p
+// scenes (a slide with text and diagonal shapes, a portrait, a textured
+// outdoor shot): each scene is box-downscaled to 360p and 180p, as a sender
+// under bandwidth pressure would, then scaled back to 720p bilinearly and
+// with the super-resolution upscaler. Reports luma PSNR / SSIM against the
+// original and the per-frame CPU cost of both paths, and checks that the
+// upscaler falls back to bilinear when over its time budget, under CPU
+// pressure and at small scale factors.
+//
+//   upscaler_bench [--check]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "tools/cpu_time.h"
+#include "video/i420_frame.h"
+#include "video/quality_metrics.h"
+#include "video/super_resolution_upscaler.h"
+
+namespace {
+
+constexpr int kWidth = 1280;
+constexpr int kHeight = 720;
+
+void SetLuma(vc::I420Frame* f, int x, int y, int v) {
+  if (x < 0 || y < 0 || x >= f->width() || y >= f->height()) return;
+  f->y()[static_cast<size_t>(y) * f->stride_y() + x] =
+      static_cast<uint8_t>(std::clamp(v, 0, 255));
+}
+
+void FillChroma(vc::I420Frame* f, int u, int v) {
+  for (int y = 0; y < f->chroma_height(); ++y) {
+    for (int x = 0; x < f->chroma_width(); ++x) {
+      size_t k = static_cast<size_t>(y) * f->stride_uv() + x;
+      f->u()[k] = static_cast<uint8_t>(u + (x * 16 / f->chroma_width()));
+      f->v()[k] = static_cast<uint8_t>(v - (y * 16 / f->chroma_height()));
+    }
+  }
+}
+
+// Light background with lines of blocky glyphs, an outlined circle and a few
+// diagonal bars.
+void RenderSlide(vc::I420Frame* f) {
+  f->Allocate(kWidth, kHeight);
+  std::memset(f->y(), 235, static_cast<size_t>(kWidth) * kHeight);
+  std::mt19937 rng(11);
+  for (int line = 0; line < 9; ++line) {
+    const int top = 60 + line * 48, size = 24 + (line % 3) * 6;
+    for (int x = 80; x + size < 760; x += size + size / 3) {
+      if (rng() % 6 == 0) continue;  // word gap
+      const int stroke = std::max(3, size / 7);
+      const unsigned glyph = rng();
+      for (int y = 0; y < size; ++y) {
+        for (int dx = 0; dx < size * 3 / 4; ++dx) {
+          bool on = ((glyph & 1) && dx < stroke) ||
+                    ((glyph & 2) && dx >= size * 3 / 4 - stroke) ||
+                    ((glyph & 4) && y < stroke) ||
+                    ((glyph & 8) && std::abs(y - size / 2) < stroke / 2 + 1) ||
+                    ((glyph & 16) && y >= size - stroke) ||
+                    ((glyph & 32) && std::abs(dx - y * 3 / 4) < stroke / 2 + 1);
+          if (on) SetLuma(f, x + dx, top + y, 30);
+        }
+      }
+    }
+  }
+  for (int y = 0; y < kHeight; ++y) {
+    for (int x = 820; x < kWidth; ++x) {
+      double r = std::hypot(x - 1020.0, y - 220.0);
+      if (std::fabs(r - 140.0) < 5.0) SetLuma(f, x, y, 60);
+      for (int k = 0; k < 4; ++k) {
+        if (y > 420 && std::abs((x - 820) - (y - 420) * (k + 1) / 2 - k * 60) < 4) {
+          SetLuma(f, x, y, 90 + 30 * k);
+        }
+      }
+    }
+  }
+  FillChroma(f, 124, 132);
+}
+
+// Soft shaded face in front of a gradient wall, hair as fine dark strands,
+// a striped shirt.
+void RenderPortrait(vc::I420Frame* f) {
+  f->Allocate(kWidth, kHeight);
+  for (int y = 0; y < kHeight; ++y) {
+    for (int x = 0; x < kWidth; ++x) {
+      double v = 90 + 60.0 * x / kWidth + 20.0 * y / kHeight;
+      double dx = (x - 640.0) / 170.0, dy = (y - 330.0) / 220.0;
+      double face = dx * dx + dy * dy;
+      if (face < 1.0) {
+        v = 185 - 45 * face + 18 * std::sin(dx * 3.0) - (std::fabs(dy + 0.15) < 0.04 &&
+                                                          std::fabs(std::fabs(dx) - 0.4) < 0.15
+                                                      ? 90 : 0);
+      } else if (face < 1.5 && dy < 0.2) {
+        v = 45 + 25 * std::sin(x * 0.9 + y * 0.15);
+      } else if (y > 540 && std::fabs(x - 640.0) < 360) {
+        v = ((x + y / 3) / 9) % 2 ? 70 : 160;
+      }
+      SetLuma(f, x, y, static_cast<int>(v));
+    }
+  }
+  FillChroma(f, 116, 142);
+}
+
+// Foliage-like texture: octaves of value noise over a sky gradient and a
+// roof line.
+void RenderOutdoor(vc::I420Frame* f) {
+  f->Allocate(kWidth, kHeight);
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int> lattice(0, 255);
+  std::vector<int> grid(64 * 64);
+  for (int& g : grid) g = lattice(rng);
+  auto noise = [&](double x, double y) {
+    int xi = static_cast<int>(x), yi = static_cast<int>(y);
+    double fx = x - xi, fy = y - yi;
+    auto at = [&](int gx, int gy) { return grid[(gy & 63) * 64 + (gx & 63)]; };
+    double top = at(xi, yi) * (1 - fx) + at(xi + 1, yi) * fx;
+    double bottom = at(xi, yi + 1) * (1 - fx) + at(xi + 1, yi + 1) * fx;
+    return top * (1 - fy) + bottom * fy;
+  };
+  for (int y = 0; y < kHeight; ++y) {
+    for (int x = 0; x < kWidth; ++x) {
+      double v;
+      if (y < 200 + x / 8) {
+        v = 200 - y * 0.2;
+      } else {
+        v = 0.5 * noise(x / 40.0, y / 40.0) + 0.3 * noise(x / 12.0, y / 12.0) +
+            0.2 * noise(x / 5.0, y / 5.0) - 20;
+      }
+      SetLuma(f, x, y, static_cast<int>(v));
+    }
+  }
+  FillChroma(f, 110, 128);
+}
+
+void Downscale2x(const vc::I420Frame& src, vc::I420Frame* dst) {
+  dst->Allocate((src.width() + 1) / 2, (src.height() + 1) / 2);
+  for (int p = 0; p < 3; ++p) {
+    vc::DownscalePlane2x(src.plane(p), src.stride(p), src.plane_width(p),
+                         src.plane_height(p), dst->plane(p), dst->stride(p));
+  }
+}
+
+double LumaPsnr(const vc::I420Frame& a, const vc::I420Frame& b) {
+  return vc::PsnrFromSse(vc::PlaneSse(a.y(), a.stride_y(), b.y(), b.stride_y(),
+                                      a.width(), a.height()),
+                         static_cast<uint64_t>(a.width()) * a.height());
+}
+
+double LumaSsim(const vc::I420Frame& a, const vc::I420Frame& b) {
+  return vc::PlaneSsim(a.y(), a.stride_y(), b.y(), b.stride_y(), a.width(),
+                       a.height());
+}
+
+bool SameFrame(const vc::I420Frame& a, const vc::I420Frame& b) {
+  return a.size_bytes() == b.size_bytes() &&
+         std::memcmp(a.y(), b.y(), a.size_bytes()) == 0;
+}
+
+struct Quality {
+  double bilinear_psnr, sr_psnr, bilinear_ssim, sr_ssim;
+};
+
+Quality Compare(const vc::I420Frame& original, const vc::I420Frame& low) {
+  vc::I420Frame bilinear(kWidth, kHeight), sr(kWidth, kHeight);
+  vc::ScaleFrameBilinear(low, &bilinear);
+  vc::SuperResolutionUpscaler::Config config;
+  config.budget_ms = 1e9;
+  vc::SuperResolutionUpscaler upscaler(config);
+  upscaler.Upscale(low, &sr);
+  return {LumaPsnr(original, bilinear), LumaPsnr(original, sr),
+          LumaSsim(original, bilinear), LumaSsim(original, sr)};
+}
+
+// Mean thread CPU time per frame of both paths for one input size.
+void MeasureCost(const vc::I420Frame& low, int frames, double* bilinear_ms,
+                 double* sr_ms) {
+  vc::I420Frame out(kWidth, kHeight);
+  double start = vc::CpuNowMs();
+  for (int i = 0; i < frames; ++i) vc::ScaleFrameBilinear(low, &out);
+  *bilinear_ms = (vc::CpuNowMs() - start) / frames;
+  vc::SuperResolutionUpscaler::Config config;
+  config.budget_ms = 1e9;
+  vc::SuperResolutionUpscaler upscaler(config);
+  start = vc::CpuNowMs();
+  for (int i = 0; i < frames; ++i) upscaler.Upscale(low, &out);
+  *sr_ms = (vc::CpuNowMs() - start) / frames;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  const int frames = check ? 30 : 200;
+  bool ok = true;
+
+  struct Scene {
+    const char* name;
+    void (*render)(vc::I420Frame*);
+  };
+  const Scene scenes[] = {
+      {"slide", RenderSlide}, {"portrait", RenderPortrait}, {"outdoor", RenderOutdoor}};
+
+  std::printf("%-9s %-6s %10s %10s %10s %10s\n", "scene", "input", "bil_psnr",
+              "sr_psnr", "bil_ssim", "sr_ssim");
+  double gain[2] = {0.0, 0.0};
+  vc::I420Frame original, half, quarter;
+  for (const Scene& s : scenes) {
+    s.render(&original);
+    Downscale2x(original, &half);
+    Downscale2x(half, &quarter);
+    const vc::I420Frame* inputs[] = {&half, &quarter};
+    for (int k = 0; k < 2; ++k) {
+      Quality q = Compare(original, *inputs[k]);
+      std::printf("%-9s %-6s %10.2f %10.2f %10.4f %10.4f\n", s.name,
+                  k ? "180p" : "360p", q.bilinear_psnr, q.sr_psnr,
+                  q.bilinear_ssim, q.sr_ssim);
+      gain[k] += (q.sr_psnr - q.bilinear_psnr) / std::size(scenes);
+      if (q.sr_psnr < q.bilinear_psnr || q.sr_ssim < q.bilinear_ssim) {
+        std::printf("  FAIL: upscaler below bilinear\n");
+        ok = false;
+      }
+    }
+  }
+  std::printf("mean PSNR gain over bilinear: 360p %.2f dB, 180p %.2f dB\n",
+              gain[0], gain[1]);
+  if (gain[0] < 0.8 || gain[1] < 0.8) {
+    std::printf("  FAIL: mean gain below 0.8 dB\n");
+    ok = false;
+  }
+
+  // Cost to 720p, CPU time per frame.
+  RenderPortrait(&original);
+  Downscale2x(original, &half);
+  Downscale2x(half, &quarter);
+  double bilinear_ms[2], sr_ms[2];
+  MeasureCost(half, frames, &bilinear_ms[0], &sr_ms[0]);
+  MeasureCost(quarter, frames, &bilinear_ms[1], &sr_ms[1]);
+  std::printf("\nto 720p, ms per frame: 360p bilinear %.3f sr %.3f; "
+              "180p bilinear %.3f sr %.3f\n",
+              bilinear_ms[0], sr_ms[0], bilinear_ms[1], sr_ms[1]);
+  const double budget_ms = vc::SuperResolutionUpscaler::Config().budget_ms;
+  if (sr_ms[0] > budget_ms || sr_ms[1] > budget_ms) {
+    std::printf("  FAIL: upscaling to 720p exceeds the default %.1f ms budget\n",
+                budget_ms);
+    ok = false;
+  }
+
+  // Fallbacks. Budget: every enhanced frame is over budget, so after
+  // over_budget_frames it drops to bilinear, and each retry waits longer.
+  vc::I420Frame out(kWidth, kHeight), reference(kWidth, kHeight);
+  vc::ScaleFrameBilinear(quarter, &reference);
+  {
+    vc::SuperResolutionUpscaler::Config config;
+    config.budget_ms = 0.0;
+    config.retry_frames = 10;
+    vc::SuperResolutionUpscaler upscaler(config);
+    bool last_bilinear = true;
+    for (int i = 0; i < 90; ++i) {
+      bool enhancing = upscaler.enhancing();
+      upscaler.Upscale(quarter, &out);
+      last_bilinear = last_bilinear && (enhancing || SameFrame(out, reference));
+    }
+    const vc::SuperResolutionUpscaler::Stats& st = upscaler.stats();
+    // Runs of 3 enhanced frames with 10, 20, 40 bilinear frames between.
+    std::printf("over budget: %d of %d frames enhanced, %d fallbacks\n",
+                st.enhanced_frames, st.frames, st.budget_fallbacks);
+    if (st.enhanced_frames > 12 || st.budget_fallbacks < 3 || !last_bilinear) {
+      std::printf("  FAIL: no bilinear fallback when over budget\n");
+      ok = false;
+    }
+  }
+  {
+    vc::SuperResolutionUpscaler::Config config;
+    config.budget_ms = 1e9;
+    vc::SuperResolutionUpscaler upscaler(config);
+    upscaler.Upscale(quarter, &out);
+    const bool enhanced_before = !SameFrame(out, reference);
+    upscaler.SetCpuUsagePercent(95);
+    upscaler.Upscale(quarter, &out);
+    const bool bilinear_under_load = SameFrame(out, reference);
+    upscaler.SetCpuUsagePercent(80);
+    const bool held = !upscaler.enhancing();
+    upscaler.SetCpuUsagePercent(50);
+    upscaler.Upscale(quarter, &out);
+    const bool enhanced_after = !SameFrame(out, reference);
+    std::printf("cpu pressure: enhanced %s, under load %s, at 80%% %s, after %s\n",
+                enhanced_before ? "yes" : "no", bilinear_under_load ? "bilinear" : "ENHANCED",
+                held ? "bilinear" : "ENHANCED", enhanced_after ? "enhanced" : "NO");
+    if (!enhanced_before || !bilinear_under_load || !held || !enhanced_after) {
+      std::printf("  FAIL: CPU pressure did not switch the upscaler off and on\n");
+      ok = false;
+    }
+  }
+  {
+    vc::I420Frame small(800, 450), small_reference(800, 450);
+    vc::ScaleFrameBilinear(half, &small_reference);
+    vc::SuperResolutionUpscaler upscaler;
+    upscaler.Upscale(half, &small);
+    if (!SameFrame(small, small_reference) || upscaler.stats().enhanced_frames) {
+      std::printf("  FAIL: 1.25x scale was not left to bilinear\n");
+      ok = false;
+    }
+    // 1.5x takes one doubling and a bilinear step down.
+    vc::I420Frame mid(960, 540), mid_reference(960, 540);
+    vc::ScaleFrameBilinear(half, &mid_reference);
+    upscaler.Upscale(half, &mid);
+    if (upscaler.stats().enhanced_frames != 1 || LumaPsnr(mid, mid_reference) < 30.0) {
+      std::printf("  FAIL: 1.5x scale not enhanced or far from bilinear\n");
+      ok = false;
+    }
+  }
+  return check && !ok ? 1 : 0;
+}
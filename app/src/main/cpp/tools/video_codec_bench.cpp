@@ -0,0 +1,335 @@
+// Encode/decode throughput of the software video codec per resolution on a
+// synthetic call scene (textured, slowly panning background with a moving
+// subject and sensor noise). Verifies that the decoder reproduces the
+// encoder's reconstruction bit for bit, that quality and bitrate are sane,
+// that corrupt and hostile input is rejected, and measures time to first
+// encoded frame with and without the encoder pool.
+//
+//   video_codec_bench [--check]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "tools/cpu_time.h"
+#include "video/bit_stream.h"
+#include "video/i420_frame.h"
+#include "video/software_video_codec.h"
+#include "video/video_codec.h"
+#include "video/video_encoder_pool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double MsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+class SceneGenerator {
+ public:
+  SceneGenerator(int width, int height) : width_(width), height_(height) {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> texel(-30, 30);
+    texture_.resize(static_cast<size_t>(width + 256) * height);
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width + 256; ++x) {
+        int v = 100 + static_cast<int>(40 * std::sin(x * 0.05) * std::cos(y * 0.031)) +
+                ((x / 32 + y / 32) & 1) * 30 + texel(rng) / 3;
+        texture_[static_cast<size_t>(y) * (width + 256) + x] =
+            static_cast<uint8_t>(std::clamp(v, 0, 255));
+      }
+    }
+  }
+
+  void Render(int frame, vc::I420Frame* out) {
+    out->Allocate(width_, height_);
+    std::uniform_int_distribution<int> noise(-2, 2);
+    const int pan = (frame / 2) % 256;
+    const double cx = width_ * (0.5 + 0.2 * std::sin(frame * 0.05));
+    const double cy = height_ * 0.55;
+    const double rx = width_ * 0.15, ry = height_ * 0.35;
+    for (int y = 0; y < height_; ++y) {
+      uint8_t* row = out->y() + static_cast<size_t>(y) * out->stride_y();
+      const uint8_t* tex = texture_.data() + static_cast<size_t>(y) * (width_ + 256) + pan;
+      for (int x = 0; x < width_; ++x) {
+        double dx = (x - cx) / rx, dy = (y - cy) / ry;
+        int v = dx * dx + dy * dy < 1.0
+                    ? 170 + static_cast<int>(20 * std::sin(dx * 6 + dy * 4))
+                    : tex[x];
+        row[x] = static_cast<uint8_t>(std::clamp(v + noise(rng_), 0, 255));
+      }
+    }
+    for (int y = 0; y < out->chroma_height(); ++y) {
+      for (int x = 0; x < out->chroma_width(); ++x) {
+        double dx = (2 * x - cx) / rx, dy = (2 * y - cy) / ry;
+        bool subject = dx * dx + dy * dy < 1.0;
+        size_t k = static_cast<size_t>(y) * out->stride_uv() + x;
+        out->u()[k] = static_cast<uint8_t>(subject ? 110 : 128 + ((x + pan / 2) / 40 % 2) * 12);
+        out->v()[k] = static_cast<uint8_t>(subject ? 150 : 124);
+      }
+    }
+    out->timestamp_us = static_cast<int64_t>(frame) * 1000000 / 30;
+  }
+
+ private:
+  const int width_;
+  const int height_;
+  std::vector<uint8_t> texture_;
+  std::mt19937 rng_{2};
+};
+
+double LumaPsnr(const vc::I420Frame& a, const vc::I420Frame& b) {
+  double sse = 0.0;
+  for (int y = 0; y < a.height(); ++y) {
+    for (int x = 0; x < a.width(); ++x) {
+      int d = a.y()[static_cast<size_t>(y) * a.stride_y() + x] -
+              b.y()[static_cast<size_t>(y) * b.stride_y() + x];
+      sse += d * d;
+    }
+  }
+  double mse = sse / (static_cast<double>(a.width()) * a.height());
+  return mse > 0 ? 10 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+bool SameAsReconstruction(const vc::I420Frame& decoded, const vc::I420Frame& recon) {
+  for (int p = 0; p < 3; ++p) {
+    for (int y = 0; y < decoded.plane_height(p); ++y) {
+      if (std::memcmp(decoded.plane(p) + static_cast<size_t>(y) * decoded.stride(p),
+                      recon.plane(p) + static_cast<size_t>(y) * recon.stride(p),
+                      decoded.plane_width(p)) != 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+struct Result {
+  double encode_fps = 0.0;
+  double decode_fps = 0.0;
+  double kbps = 0.0;
+  double psnr = 0.0;
+  size_t keyframe_bytes = 0;
+  int final_qp = 0;
+  bool bit_exact = true;
+};
+
+Result Run(int width, int height, int bitrate_bps, int frames) {
+  vc::SoftwareVideoEncoder encoder;
+  vc::SoftwareVideoDecoder decoder;
+  vc::VideoEncoderConfig config;
+  config.width = width;
+  config.height = height;
+  config.bitrate_bps = bitrate_bps;
+  config.framerate = 30;
+  encoder.Init(config);
+  decoder.Init(width, height);
+
+  SceneGenerator scene(width, height);
+  vc::I420Frame frame, decoded;
+  vc::EncodedFrame encoded;
+  Result r;
+  double encode_ms = 0.0, decode_ms = 0.0, psnr = 0.0;
+  size_t settled_bytes = 0;
+  int settled = 0;
+  for (int i = 0; i < frames; ++i) {
+    scene.Render(i, &frame);
+    Clock::time_point t = Clock::now();
+    encoder.Encode(frame, false, &encoded);
+    encode_ms += MsSince(t);
+    t = Clock::now();
+    bool ok = decoder.Decode(encoded.data.data(), encoded.data.size(),
+                             encoded.timestamp_us, &decoded);
+    decode_ms += MsSince(t);
+    r.bit_exact = r.bit_exact && ok &&
+                  SameAsReconstruction(decoded, encoder.reconstruction());
+    if (i == 0) r.keyframe_bytes = encoded.data.size();
+    psnr += LumaPsnr(frame, decoded);
+    // Rate control settles within a second.
+    if (i >= 30) {
+      settled_bytes += encoded.data.size();
+      ++settled;
+    }
+  }
+  r.encode_fps = frames * 1000.0 / encode_ms;
+  r.decode_fps = frames * 1000.0 / decode_ms;
+  r.kbps = settled ? settled_bytes * 8.0 * 30 / settled / 1000.0 : 0.0;
+  r.psnr = psnr / frames;
+  r.final_qp = encoder.qp();
+  return r;
+}
+
+// Truncated and bit-flipped frames must be rejected or decoded without
+// crashing; a following keyframe must recover.
+bool CheckCorruptInput() {
+  vc::SoftwareVideoEncoder encoder;
+  vc::SoftwareVideoDecoder decoder;
+  vc::VideoEncoderConfig config;
+  config.width = 320;
+  config.height = 180;
+  encoder.Init(config);
+  decoder.Init(320, 180);
+  SceneGenerator scene(320, 180);
+  vc::I420Frame frame, decoded;
+  vc::EncodedFrame encoded;
+  std::mt19937 rng(4);
+  for (int i = 0; i < 40; ++i) {
+    scene.Render(i, &frame);
+    encoder.Encode(frame, false, &encoded);
+    std::vector<uint8_t> bad = encoded.data;
+    if (i % 2) {
+      bad.resize(bad.size() / 2);
+    } else {
+      for (int k = 0; k < 8; ++k) {
+        bad[8 + rng() % (bad.size() - 8)] ^= static_cast<uint8_t>(1 << (rng() % 8));
+      }
+    }
+    decoder.Decode(bad.data(), bad.size(), 0, &decoded);
+  }
+  scene.Render(40, &frame);
+  encoder.Encode(frame, true, &encoded);
+  return decoder.Decode(encoded.data.data(), encoded.data.size(), 0, &decoded) &&
+         SameAsReconstruction(decoded, encoder.reconstruction());
+}
+
+// A 16x16 frame header followed by a macroblock layer from `write`.
+template <typename Write>
+std::vector<uint8_t> CraftFrame(bool keyframe, bool qp_deltas, Write write) {
+  std::vector<uint8_t> data = {'V', 'C', static_cast<uint8_t>((keyframe ? 1 : 0) | (qp_deltas ? 2 : 0)),
+                               0, 16, 0, 16, 30};
+  vc::BitWriter bw(&data);
+  write(&bw);
+  bw.Flush();
+  return data;
+}
+
+// Well-formed headers carrying values a real encoder never writes: a
+// coefficient run past the block, motion and QP deltas at the Exp-Golomb
+// limits, and an oversized frame. Each must be rejected without touching
+// memory outside the decoder's buffers, and a keyframe must still decode
+// afterwards.
+bool CheckMalformedInput() {
+  vc::SoftwareVideoDecoder decoder;
+  decoder.Init(16, 16);
+  vc::I420Frame decoded;
+  const auto decode = [&](const std::vector<uint8_t>& data) {
+    return decoder.Decode(data.data(), data.size(), 0, &decoded);
+  };
+  const std::vector<uint8_t> flat = CraftFrame(true, false, [](vc::BitWriter* bw) {
+    bw->WriteBits(0, 6);  // cbp: no coefficients.
+  });
+  bool ok = decode(flat);
+  // One coefficient after a run of 2^32 - 2 zeros.
+  ok = ok && !decode(CraftFrame(true, false, [](vc::BitWriter* bw) {
+    bw->WriteBits(1, 6);
+    bw->WriteUe(0);
+    bw->WriteUe(4294967294u);
+    bw->WriteSe(1);
+  }));
+  ok = ok && decode(flat);
+  // An inter macroblock whose vector delta overflows the prediction.
+  ok = ok && !decode(CraftFrame(false, false, [](vc::BitWriter* bw) {
+    bw->WriteUe(1);
+    bw->WriteSe(2147483647);
+    bw->WriteSe(-2147483647);
+  }));
+  // A QP delta that overflows the previous QP.
+  ok = ok && !decode(CraftFrame(true, true, [](vc::BitWriter* bw) {
+    bw->WriteSe(2147483647);
+    bw->WriteBits(0, 6);
+  }));
+  // 65535 x 65535 would need about 6 GB of reference frames.
+  std::vector<uint8_t> huge = flat;
+  huge[3] = huge[4] = huge[5] = huge[6] = 0xff;
+  ok = ok && !decode(huge);
+  return ok && decode(flat);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  const int frames = check ? 60 : 300;
+  bool ok = true;
+
+  struct Case {
+    const char* name;
+    int width, height, bitrate_bps;
+  };
+  const Case cases[] = {
+      {"360p", 640, 360, 500000},
+      {"540p", 960, 540, 900000},
+      {"720p", 1280, 720, 1500000},
+      {"1080p", 1920, 1080, 3000000},
+  };
+  std::printf("%-6s %10s %10s %9s %9s %8s %10s %4s %6s\n", "res", "target",
+              "kbps", "enc_fps", "dec_fps", "psnr", "key_bytes", "qp", "exact");
+  for (const Case& c : cases) {
+    Result r = Run(c.width, c.height, c.bitrate_bps, frames);
+    std::printf("%-6s %10d %10.0f %9.1f %9.1f %8.2f %10zu %4d %6s\n", c.name,
+                c.bitrate_bps / 1000, r.kbps, r.encode_fps, r.decode_fps,
+                r.psnr, r.keyframe_bytes, r.final_qp, r.bit_exact ? "yes" : "NO");
+    if (!r.bit_exact) {
+      std::printf("  FAIL: decoder output differs from encoder reconstruction\n");
+      ok = false;
+    }
+    if (r.psnr < 30.0) {
+      std::printf("  FAIL: PSNR below 30 dB\n");
+      ok = false;
+    }
+    if (std::fabs(r.kbps - c.bitrate_bps / 1000.0) > 0.3 * c.bitrate_bps / 1000.0) {
+      std::printf("  FAIL: bitrate more than 30%% off target\n");
+      ok = false;
+    }
+  }
+
+  if (!CheckCorruptInput()) {
+    std::printf("FAIL: decoder did not recover from corrupt input\n");
+    ok = false;
+  }
+  if (!CheckMalformedInput()) {
+    std::printf("FAIL: decoder accepted a malformed bitstream\n");
+    ok = false;
+  }
+
+  // Time to first encoded frame at 720p, with and without a warm pool.
+  vc::VideoEncoderConfig config;
+  config.width = 1280;
+  config.height = 720;
+  config.bitrate_bps = 1500000;
+  SceneGenerator scene(1280, 720);
+  vc::I420Frame frame;
+  scene.Render(0, &frame);
+  vc::EncodedFrame encoded;
+  vc::VideoEncoderPool pool;
+  double acquire_ms[2], first_frame_ms[2];
+  for (int warm = 0; warm < 2; ++warm) {
+    if (warm) {
+      pool.Warm({vc::VideoCodecBackend::kSoftware, vc::VideoCodecType::kVcv, config});
+      pool.WaitUntilWarm();
+    }
+    Clock::time_point t = Clock::now();
+    const double cpu_start = vc::CpuNowMs();
+    std::unique_ptr<vc::VideoEncoder> encoder = pool.Acquire(
+        vc::VideoCodecBackend::kSoftware, vc::VideoCodecType::kVcv, config);
+    acquire_ms[warm] = vc::CpuNowMs() - cpu_start;
+    encoder->Encode(frame, true, &encoded);
+    first_frame_ms[warm] = MsSince(t);
+  }
+  vc::VideoEncoderPool::Stats stats = pool.GetStats();
+  std::printf("\n720p time to first frame: cold %.3f ms (acquire %.3f cpu), "
+              "pooled %.3f ms (acquire %.3f cpu); hits %d, cold starts %d\n",
+              first_frame_ms[0], acquire_ms[0], first_frame_ms[1],
+              acquire_ms[1], stats.warm_hits, stats.cold_starts);
+  if (stats.warm_hits != 1 || acquire_ms[1] > acquire_ms[0]) {
+    std::printf("  FAIL: pooled encoder was not ready\n");
+    ok = false;
+  }
+  return check && !ok ? 1 : 0;
+}
@@ -0,0 +1,418 @@
+// Quality versus bitrate of the whole video chain, as the gate for media
+// pipeline changes. Synthetic 360p sequences (a talking head over a
+// textured wall, a fast pan over detail, slides with cuts) are encoded
+// with the software codec at a ladder of bitrates, packetised and sent
+// over a link with optional packet loss (lost frames freeze the picture
+// until a keyframe requested one round trip later arrives), decoded and
+// compared with the source as displayed: PSNR, SSIM and the perceptual
+// score from video/quality_metrics.h.
+//
+// Also checks the metrics themselves: identical frames score perfectly,
+// the SIMD paths match scalar references on odd sizes, and every metric
+// falls as noise or blur increase.
+//
+//   video_quality_bench [--check]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "tools/cpu_time.h"
+#include "video/i420_frame.h"
+#include "video/quality_metrics.h"
+#include "video/software_video_codec.h"
+
+namespace {
+
+constexpr int kWidth = 640;
+constexpr int kHeight = 360;
+constexpr int kFramerate = 30;
+constexpr size_t kMaxPacketBytes = 1200;
+// Keyframe requests reach the sender this many frames after a loss.
+constexpr int kRoundTripFrames = 3;
+constexpr int kBitratesKbps[] = {150, 300, 600, 1200};
+// Rate control cannot go below what the codec spends at its coarsest QP.
+constexpr int kMaxQp = 50;
+// Regression floors per sequence and rung without loss: pooled PSNR and
+// mean perceptual score, about 1 dB and 5 points under the current chain.
+constexpr double kMinPsnr[3][4] = {
+    {31.5, 33.0, 36.5, 40.0}, {27.5, 28.0, 30.5, 36.0}, {26.0, 37.0, 48.0, 57.5}};
+constexpr double kMinPerceptual[3][4] = {
+    {80.0, 87.0, 90.0, 93.0}, {36.0, 38.0, 64.0, 87.0}, {52.0, 88.0, 94.0, 94.0}};
+
+void FillChroma(vc::I420Frame* f, int u, int v, int shift) {
+  for (int y = 0; y < f->chroma_height(); ++y) {
+    for (int x = 0; x < f->chroma_width(); ++x) {
+      size_t k = static_cast<size_t>(y) * f->stride_uv() + x;
+      f->u()[k] = static_cast<uint8_t>(u + ((x + shift) / 40 % 2) * 10);
+      f->v()[k] = static_cast<uint8_t>(v - (y / 30 % 2) * 8);
+    }
+  }
+}
+
+class Sequence {
+ public:
+  enum class Kind { kTalking, kPan, kSlides };
+
+  explicit Sequence(Kind kind) : kind_(kind) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> texel(-25, 25);
+    texture_.resize(static_cast<size_t>(kTextureWidth) * kHeight);
+    for (int y = 0; y < kHeight; ++y) {
+      for (int x = 0; x < kTextureWidth; ++x) {
+        int v = 110 + static_cast<int>(45 * std::sin(x * 0.07) * std::cos(y * 0.045)) +
+                ((x / 24 + y / 24) & 1) * 25 + texel(rng) / 2;
+        texture_[static_cast<size_t>(y) * kTextureWidth + x] =
+            static_cast<uint8_t>(std::clamp(v, 0, 255));
+      }
+    }
+  }
+
+  const char* name() const {
+    return kind_ == Kind::kTalking ? "talking" : kind_ == Kind::kPan ? "pan" : "slides";
+  }
+
+  void Render(int frame, vc::I420Frame* out) {
+    out->Allocate(kWidth, kHeight);
+    out->timestamp_us = static_cast<int64_t>(frame) * 1000000 / kFramerate;
+    switch (kind_) {
+      case Kind::kTalking:
+        RenderTalking(frame, out);
+        break;
+      case Kind::kPan:
+        RenderPan(frame, out);
+        break;
+      case Kind::kSlides:
+        RenderSlides(frame, out);
+        break;
+    }
+  }
+
+ private:
+  static constexpr int kTextureWidth = kWidth + 1024;
+
+  void RenderTalking(int frame, vc::I420Frame* out) {
+    std::uniform_int_distribution<int> noise(-2, 2);
+    const double cx = kWidth * (0.5 + 0.08 * std::sin(frame * 0.09));
+    const double cy = kHeight * (0.5 + 0.03 * std::sin(frame * 0.13));
+    for (int y = 0; y < kHeight; ++y) {
+      uint8_t* row = out->y() + static_cast<size_t>(y) * out->stride_y();
+      const uint8_t* tex = texture_.data() + static_cast<size_t>(y) * kTextureWidth;
+      for (int x = 0; x < kWidth; ++x) {
+        double dx = (x - cx) / (kWidth * 0.14), dy = (y - cy) / (kHeight * 0.36);
+        double r = dx * dx + dy * dy;
+        int v = r < 1.0 ? 175 - static_cast<int>(40 * r) +
+                              static_cast<int>(12 * std::sin(dx * 5 + frame * 0.2))
+                        : tex[x];
+        row[x] = static_cast<uint8_t>(std::clamp(v + noise(rng_), 0, 255));
+      }
+    }
+    FillChroma(out, 122, 136, 0);
+  }
+
+  void RenderPan(int frame, vc::I420Frame* out) {
+    const int pan = (frame * 9) % (kTextureWidth - kWidth);
+    for (int y = 0; y < kHeight; ++y) {
+      std::memcpy(out->y() + static_cast<size_t>(y) * out->stride_y(),
+                  texture_.data() + static_cast<size_t>(y) * kTextureWidth + pan, kWidth);
+    }
+    FillChroma(out, 118, 132, pan / 2);
+  }
+
+  // A new slide every second: dark glyph rows on a light background.
+  void RenderSlides(int frame, vc::I420Frame* out) {
+    std::memset(out->y(), 230, static_cast<size_t>(kWidth) * kHeight);
+    std::mt19937 rng(100 + frame / kFramerate);
+    for (int line = 0; line < 8; ++line) {
+      const int top = 30 + line * 40, size = 18 + (line % 2) * 6;
+      for (int x = 40; x + size < kWidth - 40; x += size) {
+        const unsigned glyph = rng();
+        if (glyph % 7 == 0) continue;
+        for (int y = 0; y < size - 4; ++y) {
+          for (int dx = 0; dx < size - 6; ++dx) {
+            bool on = ((glyph & 1) && dx < 3) || ((glyph & 2) && y < 3) ||
+                      ((glyph & 4) && std::abs(dx - y) < 2) ||
+                      ((glyph & 8) && y >= size - 7);
+            if (on) out->y()[static_cast<size_t>(top + y) * out->stride_y() + x + dx] = 40;
+          }
+        }
+      }
+    }
+    FillChroma(out, 128, 128, 0);
+  }
+
+  const Kind kind_;
+  std::vector<uint8_t> texture_;
+  std::mt19937 rng_{3};
+};
+
+struct ChainResult {
+  double kbps = 0.0;
+  double psnr = 0.0;
+  double ssim = 0.0;
+  double perceptual = 0.0;
+  double min_perceptual = 0.0;
+  int frozen_frames = 0;
+  int final_qp = 0;
+};
+
+ChainResult RunChain(Sequence* sequence, int bitrate_kbps, double packet_loss,
+                     int frames) {
+  vc::SoftwareVideoEncoder encoder;
+  vc::SoftwareVideoDecoder decoder;
+  vc::VideoEncoderConfig config;
+  config.width = kWidth;
+  config.height = kHeight;
+  config.bitrate_bps = bitrate_kbps * 1000;
+  config.framerate = kFramerate;
+  encoder.Init(config);
+  decoder.Init(kWidth, kHeight);
+
+  std::mt19937 rng(static_cast<unsigned>(bitrate_kbps));
+  std::bernoulli_distribution lost(packet_loss);
+  vc::I420Frame source, displayed(kWidth, kHeight), decoded;
+  std::memset(displayed.y(), 128, displayed.size_bytes());
+  vc::EncodedFrame encoded;
+  vc::QualityAccumulator quality;
+  ChainResult r;
+  size_t bytes = 0;
+  bool waiting_for_keyframe = false;
+  int keyframe_request_at = -1;
+  for (int i = 0; i < frames; ++i) {
+    sequence->Render(i, &source);
+    const bool force_keyframe = i == keyframe_request_at;
+    encoder.Encode(source, force_keyframe, &encoded);
+    bytes += encoded.data.size();
+
+    const size_t packets = (encoded.data.size() + kMaxPacketBytes - 1) / kMaxPacketBytes;
+    bool frame_lost = false;
+    for (size_t p = 0; p < packets; ++p) frame_lost = lost(rng) || frame_lost;
+    // Request a keyframe on the first loss, and again if the one that
+    // answered the request is lost too.
+    if (frame_lost && (!waiting_for_keyframe || i >= keyframe_request_at)) {
+      waiting_for_keyframe = true;
+      keyframe_request_at = i + kRoundTripFrames;
+    }
+    if (!frame_lost && (encoded.keyframe || !waiting_for_keyframe) &&
+        decoder.Decode(encoded.data.data(), encoded.data.size(), encoded.timestamp_us,
+                       &decoded)) {
+      waiting_for_keyframe = false;
+      std::swap(displayed, decoded);
+    } else {
+      ++r.frozen_frames;
+    }
+    quality.Add(source, displayed);
+  }
+  r.final_qp = encoder.qp();
+  r.kbps = bytes * 8.0 * kFramerate / frames / 1000.0;
+  r.psnr = quality.pooled_psnr();
+  r.ssim = quality.mean_ssim();
+  r.perceptual = quality.mean_perceptual();
+  r.min_perceptual = quality.min_perceptual();
+  return r;
+}
+
+// Scalar references for the SIMD paths.
+uint64_t ReferenceSse(const vc::I420Frame& a, const vc::I420Frame& b) {
+  uint64_t sse = 0;
+  for (int y = 0; y < a.height(); ++y) {
+    for (int x = 0; x < a.width(); ++x) {
+      int d = a.y()[static_cast<size_t>(y) * a.stride_y() + x] -
+              b.y()[static_cast<size_t>(y) * b.stride_y() + x];
+      sse += d * d;
+    }
+  }
+  return sse;
+}
+
+double ReferenceSsim(const vc::I420Frame& a, const vc::I420Frame& b) {
+  double total = 0.0;
+  int windows = 0;
+  for (int y = 0; y + 8 <= a.height() / 4 * 4; y += 4) {
+    for (int x = 0; x + 8 <= a.width() / 4 * 4; x += 4) {
+      double sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+      for (int j = 0; j < 8; ++j) {
+        for (int i = 0; i < 8; ++i) {
+          double va = a.y()[static_cast<size_t>(y + j) * a.stride_y() + x + i];
+          double vb = b.y()[static_cast<size_t>(y + j) * b.stride_y() + x + i];
+          sa += va;
+          sb += vb;
+          saa += va * va;
+          sbb += vb * vb;
+          sab += va * vb;
+        }
+      }
+      double ma = sa / 64, mb = sb / 64;
+      double va = saa / 64 - ma * ma, vb = sbb / 64 - mb * mb, cov = sab / 64 - ma * mb;
+      total += (2 * ma * mb + 6.5025) * (2 * cov + 58.5225) /
+               ((ma * ma + mb * mb + 6.5025) * (va + vb + 58.5225));
+      ++windows;
+    }
+  }
+  return total / windows;
+}
+
+void AddNoise(double sigma, unsigned seed, vc::I420Frame* frame) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> noise(0.0, sigma);
+  for (size_t k = 0; k < frame->size_bytes(); ++k) {
+    frame->y()[k] = static_cast<uint8_t>(std::clamp(
+        static_cast<int>(std::lround(frame->y()[k] + noise(rng))), 0, 255));
+  }
+}
+
+// Separable box blur of every plane with the given radius.
+void Blur(int radius, vc::I420Frame* frame) {
+  for (int p = 0; p < 3; ++p) {
+    const int w = frame->plane_width(p), h = frame->plane_height(p);
+    uint8_t* data = frame->plane(p);
+    std::vector<uint8_t> copy(data, data + static_cast<size_t>(w) * h);
+    for (int pass = 0; pass < 2; ++pass) {
+      for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+          int sum = 0;
+          for (int k = -radius; k <= radius; ++k) {
+            int sx = pass ? x : std::clamp(x + k, 0, w - 1);
+            int sy = pass ? std::clamp(y + k, 0, h - 1) : y;
+            sum += copy[static_cast<size_t>(sy) * w + sx];
+          }
+          data[static_cast<size_t>(y) * w + x] =
+              static_cast<uint8_t>((sum + radius) / (2 * radius + 1));
+        }
+      }
+      std::memcpy(copy.data(), data, copy.size());
+    }
+  }
+}
+
+bool CheckMetrics() {
+  bool ok = true;
+  Sequence talking(Sequence::Kind::kTalking);
+  vc::I420Frame reference, distorted;
+  talking.Render(0, &reference);
+
+  vc::FrameQuality same = vc::MeasureFrameQuality(reference, reference);
+  std::printf("identical: psnr %.1f ssim %.6f perceptual %.2f\n", same.psnr,
+              same.ssim, same.perceptual);
+  if (same.psnr != vc::kMaxPsnr || std::fabs(same.ssim - 1.0) > 1e-12 ||
+      same.perceptual != 100.0) {
+    std::printf("  FAIL: identical frames do not score perfectly\n");
+    ok = false;
+  }
+
+  // Odd sizes exercise the scalar tails next to the SIMD loops.
+  vc::I420Frame odd_a(333, 187), odd_b(333, 187);
+  vc::ScaleFrameBilinear(reference, &odd_a);
+  odd_b = odd_a;
+  AddNoise(6.0, 1, &odd_b);
+  const uint64_t sse = vc::PlaneSse(odd_a.y(), odd_a.stride_y(), odd_b.y(),
+                                    odd_b.stride_y(), odd_a.width(), odd_a.height());
+  const double ssim = vc::PlaneSsim(odd_a.y(), odd_a.stride_y(), odd_b.y(),
+                                    odd_b.stride_y(), odd_a.width(), odd_a.height());
+  std::printf("333x187: sse %llu (reference %llu), ssim %.9f (reference %.9f)\n",
+              static_cast<unsigned long long>(sse),
+              static_cast<unsigned long long>(ReferenceSse(odd_a, odd_b)), ssim,
+              ReferenceSsim(odd_a, odd_b));
+  if (sse != ReferenceSse(odd_a, odd_b) ||
+      std::fabs(ssim - ReferenceSsim(odd_a, odd_b)) > 1e-9) {
+    std::printf("  FAIL: SIMD metrics differ from the scalar reference\n");
+    ok = false;
+  }
+
+  std::printf("%-10s %8s %8s %10s\n", "distortion", "psnr", "ssim", "perceptual");
+  vc::FrameQuality last = same;
+  for (double sigma : {2.0, 5.0, 10.0}) {
+    distorted = reference;
+    AddNoise(sigma, 2, &distorted);
+    vc::FrameQuality q = vc::MeasureFrameQuality(reference, distorted);
+    std::printf("noise %-4.0f %8.2f %8.4f %10.2f\n", sigma, q.psnr, q.ssim, q.perceptual);
+    if (q.psnr >= last.psnr || q.ssim >= last.ssim || q.perceptual >= last.perceptual) {
+      std::printf("  FAIL: metrics do not fall with more noise\n");
+      ok = false;
+    }
+    last = q;
+  }
+  last = same;
+  for (int radius : {1, 2, 3}) {
+    distorted = reference;
+    Blur(radius, &distorted);
+    vc::FrameQuality q = vc::MeasureFrameQuality(reference, distorted);
+    std::printf("blur %-5d %8.2f %8.4f %10.2f\n", radius, q.psnr, q.ssim, q.perceptual);
+    if (q.psnr >= last.psnr || q.ssim >= last.ssim || q.perceptual >= last.perceptual) {
+      std::printf("  FAIL: metrics do not fall with more blur\n");
+      ok = false;
+    }
+    last = q;
+  }
+
+  vc::I420Frame big_a(1280, 720), big_b(1280, 720);
+  vc::ScaleFrameBilinear(reference, &big_a);
+  big_b = big_a;
+  AddNoise(3.0, 3, &big_b);
+  const int runs = 20;
+  const double start = vc::CpuNowMs();
+  double sink = 0.0;
+  for (int i = 0; i < runs; ++i) sink += vc::MeasureFrameQuality(big_a, big_b).psnr;
+  std::printf("720p frame metrics: %.2f ms (psnr %.2f)\n\n",
+              (vc::CpuNowMs() - start) / runs, sink / runs);
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  const int frames = check ? 90 : 300;
+  bool ok = CheckMetrics();
+
+  const Sequence::Kind kinds[] = {Sequence::Kind::kTalking, Sequence::Kind::kPan,
+                                  Sequence::Kind::kSlides};
+  std::printf("%-8s %5s %6s %8s %8s %8s %8s %8s %7s\n", "sequence", "loss",
+              "target", "kbps", "psnr", "ssim", "percept", "worst", "frozen");
+  for (int s = 0; s < 3; ++s) {
+    const Sequence::Kind kind = kinds[s];
+    ChainResult previous;
+    for (int rung = 0; rung < 4; ++rung) {
+      const int kbps = kBitratesKbps[rung];
+      Sequence sequence(kind);
+      ChainResult r = RunChain(&sequence, kbps, 0.0, frames);
+      std::printf("%-8s %4.0f%% %6d %8.0f %8.2f %8.4f %8.2f %8.2f %7d\n",
+                  sequence.name(), 0.0, kbps, r.kbps, r.psnr, r.ssim, r.perceptual,
+                  r.min_perceptual, r.frozen_frames);
+      if (std::fabs(r.kbps - kbps) > 0.35 * kbps && r.final_qp < kMaxQp) {
+        std::printf("  FAIL: bitrate more than 35%% off target\n");
+        ok = false;
+      }
+      if (r.psnr < kMinPsnr[s][rung] || r.perceptual < kMinPerceptual[s][rung]) {
+        std::printf("  FAIL: quality below the regression floor (%.1f dB, %.0f)\n",
+                    kMinPsnr[s][rung], kMinPerceptual[s][rung]);
+        ok = false;
+      }
+      if (rung > 0 &&
+          (r.psnr < previous.psnr - 0.1 || r.ssim < previous.ssim - 0.002 ||
+           r.perceptual < previous.perceptual - 1.0)) {
+        std::printf("  FAIL: quality fell as bitrate rose\n");
+        ok = false;
+      }
+      previous = r;
+    }
+    // 1% packet loss at the middle rate: frames freeze until the requested
+    // keyframe lands, and quality drops below the lossless run.
+    Sequence sequence(kind);
+    const int kbps = kBitratesKbps[2];
+    ChainResult lossy = RunChain(&sequence, kbps, 0.01, frames);
+    Sequence clean_sequence(kind);
+    ChainResult clean = RunChain(&clean_sequence, kbps, 0.0, frames);
+    std::printf("%-8s %4.0f%% %6d %8.0f %8.2f %8.4f %8.2f %8.2f %7d\n",
+                sequence.name(), 1.0, kbps, lossy.kbps, lossy.psnr, lossy.ssim,
+                lossy.perceptual, lossy.min_perceptual, lossy.frozen_frames);
+    if (lossy.frozen_frames > frames / 4 || lossy.psnr > clean.psnr) {
+      std::printf("  FAIL: loss recovery\n");
+      ok = false;
+    }
+  }
+  return check && !ok ? 1 : 0;
+}
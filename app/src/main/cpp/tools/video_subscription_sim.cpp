@@ -0,0 +1,468 @@
+// A 49-participant call on a phone (1080x2160 gallery, two tiles across)
+// receiving every participant's simulcast video (640x360, 320x180 and
+// 160x90 VCV at 15 fps) while the user scrolls the gallery, opens the chat
+// panel, switches to speaker view with a filmstrip, backgrounds the app and
+// comes back. Compares decoding every stream at the top layer with
+// VideoSubscriptionManager driven by the visible tiles, with subscription
+// changes reaching the SFU one frame later. Reports per phase the tiles
+// shown, decoders held, frames decoded and decode CPU, and checks that
+// hidden tiles cost no decoding, thumbnails get the small layer, a tile
+// that appears shows a picture within two frames, decoders are reused
+// rather than churned while scrolling and decode CPU drops well below the
+// baseline, and that a track announcing too many layers still decodes and
+// one no decoder accepts stays paused.
+//
+//   video_subscription_sim [--check]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "tools/cpu_time.h"
+#include "video/i420_frame.h"
+#include "video/software_video_codec.h"
+#include "video/video_codec.h"
+#include "video/video_subscription_manager.h"
+
+namespace {
+
+constexpr int kParticipants = 49;
+constexpr int kFps = 15;
+constexpr int kLayers = 3;
+constexpr int kTopWidth = 640;
+constexpr int kTopHeight = 360;
+// Frames each layer's stream loops over; the first is a keyframe.
+constexpr int kLoopFrames = 30;
+
+constexpr int kScreenWidth = 1080;
+constexpr int kScreenHeight = 2160;
+constexpr int kGap = 8;
+constexpr int kTileWidth = (kScreenWidth - 3 * kGap) / 2;
+constexpr int kTileHeight = kTileWidth * 9 / 16;
+constexpr int kRowPitch = kTileHeight + kGap;
+constexpr int kMaxScroll =
+    ((kParticipants + 1) / 2) * kRowPitch + kGap - kScreenHeight;
+
+constexpr int64_t kDecoderLingerMs = 1000;
+
+enum class View { kGrid, kSpeaker };
+
+struct Phase {
+  double until_s;
+  const char* name;
+  View view;
+  // Gallery scroll over the phase, as fractions of the full scroll.
+  double scroll_from;
+  double scroll_to;
+  // Fraction of the screen, from the bottom, under the chat panel.
+  double panel;
+  bool foreground;
+};
+
+const Phase kPhases[] = {
+    {0.5, "grid", View::kGrid, 0.0, 0.0, 0.0, true},
+    {3.5, "scrolling", View::kGrid, 0.0, 1.0, 0.0, true},
+    {4.5, "chat panel", View::kGrid, 1.0, 1.0, 0.6, true},
+    {5.5, "speaker view", View::kSpeaker, 0.0, 0.0, 0.0, true},
+    {7.0, "background", View::kGrid, 0.0, 0.0, 0.0, false},
+    {8.0, "grid again", View::kGrid, 0.0, 0.0, 0.0, true},
+};
+
+constexpr int kPhaseCount = static_cast<int>(std::size(kPhases));
+constexpr int kGridPhase = 0;
+constexpr int kPanelPhase = 2;
+constexpr int kBackgroundPhase = 4;
+constexpr int kSpeakerThumbnails = 6;
+
+int PhaseIndex(int tick) {
+  const double t = static_cast<double>(tick) / kFps;
+  for (int i = 0; i < kPhaseCount; ++i) {
+    if (t < kPhases[i].until_s) return i;
+  }
+  return kPhaseCount - 1;
+}
+
+uint32_t TrackId(int participant) { return static_cast<uint32_t>(participant + 1); }
+
+// The tiles on screen at `tick`, as the UI would report them: gallery tiles
+// intersecting the part of the screen above the chat panel, or the speaker
+// and a row of thumbnails.
+std::vector<vc::TileVisibility> Layout(int tick) {
+  const int index = PhaseIndex(tick);
+  const Phase& phase = kPhases[index];
+  std::vector<vc::TileVisibility> tiles;
+  if (phase.view == View::kSpeaker) {
+    tiles.push_back({TrackId(0), kScreenWidth, kScreenWidth * 9 / 16});
+    for (int i = 1; i <= kSpeakerThumbnails; ++i) {
+      const int width = kScreenWidth / kSpeakerThumbnails;
+      tiles.push_back({TrackId(i), width, width * 9 / 16});
+    }
+    return tiles;
+  }
+  const double start = index == 0 ? 0.0 : kPhases[index - 1].until_s;
+  const double progress = std::min(
+      1.0, (static_cast<double>(tick) / kFps - start) / (phase.until_s - start));
+  const int scroll = static_cast<int>(
+      kMaxScroll * (phase.scroll_from + (phase.scroll_to - phase.scroll_from) * progress));
+  const int bottom = static_cast<int>(kScreenHeight * (1.0 - phase.panel));
+  for (int i = 0; i < kParticipants; ++i) {
+    const int top = kGap + (i / 2) * kRowPitch - scroll;
+    if (top < bottom && top + kTileHeight > 0) {
+      tiles.push_back({TrackId(i), kTileWidth, kTileHeight});
+    }
+  }
+  return tiles;
+}
+
+// A participant-like picture at frame `k`: shaded background, a bright
+// oval drifting sideways and sensor noise.
+void RenderScene(vc::I420Frame* f, int k, std::mt19937* rng) {
+  const int cx = f->width() / 3 + k * f->width() / (3 * kLoopFrames);
+  const int cy = f->height() * 2 / 5;
+  const double rx = f->width() * 0.14, ry = f->height() * 0.3;
+  for (int y = 0; y < f->height(); ++y) {
+    for (int x = 0; x < f->width(); ++x) {
+      const double dx = (x - cx) / rx, dy = (y - cy) / ry;
+      int v = 60 + (x * 50) / f->width() + (y * 30) / f->height();
+      if (dx * dx + dy * dy < 1.0) v = 170 + ((x ^ y) & 7);
+      v += static_cast<int>((*rng)() % 5) - 2;
+      f->y()[static_cast<size_t>(y) * f->stride_y() + x] =
+          static_cast<uint8_t>(std::clamp(v, 16, 235));
+    }
+  }
+  std::memset(f->u(), 118, static_cast<size_t>(f->stride_uv()) * f->chroma_height());
+  std::memset(f->v(), 136, static_cast<size_t>(f->stride_uv()) * f->chroma_height());
+}
+
+// One simulcast layer as the SFU holds it: the loop as the sender encodes
+// it, and each frame encoded as a keyframe to answer keyframe requests.
+struct LayerStream {
+  int width = 0;
+  int height = 0;
+  std::vector<vc::EncodedFrame> deltas;
+  std::vector<vc::EncodedFrame> keyframes;
+};
+
+std::vector<LayerStream> EncodeLayers() {
+  std::vector<LayerStream> layers(kLayers);
+  std::mt19937 rng(7);
+  vc::I420Frame source(kTopWidth, kTopHeight);
+  std::vector<vc::I420Frame> scaled(kLayers);
+  std::vector<vc::SoftwareVideoEncoder> chains(kLayers), keys(kLayers);
+  for (int l = 0; l < kLayers; ++l) {
+    const int shift = kLayers - 1 - l;
+    layers[l].width = kTopWidth >> shift;
+    layers[l].height = kTopHeight >> shift;
+    scaled[l].Allocate(layers[l].width, layers[l].height);
+    vc::VideoEncoderConfig config;
+    config.width = layers[l].width;
+    config.height = layers[l].height;
+    config.bitrate_bps = 500000 >> (2 * shift);
+    config.framerate = kFps;
+    chains[l].Init(config);
+    keys[l].Init(config);
+  }
+  for (int k = 0; k < kLoopFrames; ++k) {
+    RenderScene(&source, k, &rng);
+    for (int l = 0; l < kLayers; ++l) {
+      vc::I420Frame* frame = &source;
+      if (l != kLayers - 1) {
+        vc::ScaleFrameBilinear(source, &scaled[l]);
+        frame = &scaled[l];
+      }
+      frame->timestamp_us = k * 1000000LL / kFps;
+      vc::EncodedFrame delta, key;
+      chains[l].Encode(*frame, k == 0, &delta);
+      keys[l].Encode(*frame, true, &key);
+      layers[l].deltas.push_back(std::move(delta));
+      layers[l].keyframes.push_back(std::move(key));
+    }
+  }
+  return layers;
+}
+
+struct PhaseResult {
+  int ticks = 0;
+  double visible = 0.0;  // Summed per tick; averaged when printed.
+  double held = 0.0;
+  int max_held = 0;
+  int64_t frames = 0;
+  double decode_ms = 0.0;
+};
+
+struct Result {
+  PhaseResult phases[kPhaseCount];
+  int64_t frames = 0;
+  double decode_ms = 0.0;
+  int max_visible = 0;
+  int max_held = 0;
+  // Frames between a tile appearing and its first decoded picture.
+  int max_first_frame_ticks = 0;
+  int wrong_size_frames = 0;
+  int thumbnail_layer = -1;
+  int speaker_layer = -1;
+  int decoders_after_background = -1;
+  // Before the background phase tears decoders down.
+  int created_before_background = 0;
+  vc::VideoSubscriptionManager::Stats stats;
+};
+
+// Every stream decoded at the top layer, whatever is on screen.
+Result RunBaseline(const std::vector<LayerStream>& layers, int ticks) {
+  Result r;
+  std::vector<vc::SoftwareVideoDecoder> decoders(kParticipants);
+  for (vc::SoftwareVideoDecoder& d : decoders) d.Init(kTopWidth, kTopHeight);
+  const LayerStream& top = layers[kLayers - 1];
+  vc::I420Frame out;
+  for (int tick = 0; tick < ticks; ++tick) {
+    PhaseResult& p = r.phases[PhaseIndex(tick)];
+    ++p.ticks;
+    if (kPhases[PhaseIndex(tick)].foreground) {
+      p.visible += static_cast<double>(Layout(tick).size());
+    }
+    p.held += kParticipants;
+    p.max_held = kParticipants;
+    const vc::EncodedFrame& frame = top.deltas[tick % kLoopFrames];
+    const double t0 = vc::CpuNowMs();
+    for (vc::SoftwareVideoDecoder& d : decoders) {
+      if (d.Decode(frame.data.data(), frame.data.size(), frame.timestamp_us, &out)) ++p.frames;
+    }
+    p.decode_ms += vc::CpuNowMs() - t0;
+  }
+  for (const PhaseResult& p : r.phases) {
+    r.frames += p.frames;
+    r.decode_ms += p.decode_ms;
+  }
+  r.max_held = kParticipants;
+  return r;
+}
+
+Result RunManaged(const std::vector<LayerStream>& layers, int ticks) {
+  Result r;
+  vc::VideoSubscriptionManager::Config config;
+  config.decoder_linger_ms = kDecoderLingerMs;
+  vc::VideoSubscriptionManager manager(config);
+  for (int i = 0; i < kParticipants; ++i) {
+    manager.AddTrack(TrackId(i), kTopWidth, kTopHeight, kLayers);
+  }
+
+  // What the SFU forwards per participant, from requests a frame old.
+  struct Forward {
+    int layer = vc::VideoSubscriptionManager::kPaused;
+    bool keyframe = false;
+  };
+  std::vector<Forward> sfu(kParticipants);
+  std::vector<vc::LayerRequest> in_flight, requests;
+  // Tick each tile appeared at, or -1 once it has shown a picture or is hidden.
+  std::vector<int> waiting_since(kParticipants, -1);
+  std::vector<bool> shown(kParticipants, false);
+  vc::I420Frame out;
+
+  for (int tick = 0; tick < ticks; ++tick) {
+    const int index = PhaseIndex(tick);
+    const Phase& phase = kPhases[index];
+    const int64_t now_ms = tick * 1000LL / kFps;
+    const std::vector<vc::TileVisibility> tiles = Layout(tick);
+
+    manager.SetForeground(phase.foreground, now_ms);
+    manager.SetVisibleTiles(tiles.data(), tiles.size(), now_ms);
+    requests.clear();
+    manager.Update(now_ms, &requests);
+
+    std::vector<bool> visible(kParticipants, false);
+    if (phase.foreground) {
+      for (const vc::TileVisibility& t : tiles) visible[t.track_id - 1] = true;
+    }
+    for (int i = 0; i < kParticipants; ++i) {
+      if (visible[i] && !shown[i]) waiting_since[i] = tick;
+      if (!visible[i]) waiting_since[i] = -1;
+      shown[i] = visible[i];
+    }
+
+    for (const vc::LayerRequest& q : in_flight) {
+      Forward& f = sfu[q.track_id - 1];
+      f.layer = q.layer;
+      f.keyframe = f.keyframe || q.keyframe;
+    }
+    std::swap(in_flight, requests);
+
+    PhaseResult& p = r.phases[index];
+    const int k = tick % kLoopFrames;
+    const double t0 = vc::CpuNowMs();
+    for (int i = 0; i < kParticipants; ++i) {
+      Forward& f = sfu[i];
+      if (f.layer == vc::VideoSubscriptionManager::kPaused) continue;
+      const LayerStream& stream = layers[f.layer];
+      const bool key = f.keyframe || k == 0;
+      const vc::EncodedFrame& frame = f.keyframe ? stream.keyframes[k] : stream.deltas[k];
+      f.keyframe = false;
+      if (!manager.OnFrame(TrackId(i), frame.data.data(), frame.data.size(), key,
+                           frame.timestamp_us, &out)) {
+        continue;
+      }
+      ++p.frames;
+      if (out.width() != stream.width || out.height() != stream.height) ++r.wrong_size_frames;
+      if (waiting_since[i] >= 0) {
+        r.max_first_frame_ticks = std::max(r.max_first_frame_ticks, tick - waiting_since[i]);
+        waiting_since[i] = -1;
+      }
+    }
+    p.decode_ms += vc::CpuNowMs() - t0;
+
+    const vc::VideoSubscriptionManager::Stats s = manager.GetStats();
+    const int held = s.active_decoders + s.pooled_decoders;
+    ++p.ticks;
+    p.visible += s.visible;
+    p.held += held;
+    p.max_held = std::max(p.max_held, held);
+    r.max_visible = std::max(r.max_visible, s.visible);
+    r.max_held = std::max(r.max_held, held);
+    if (phase.view == View::kSpeaker) {
+      r.speaker_layer = manager.layer(TrackId(0));
+      r.thumbnail_layer = manager.layer(TrackId(1));
+    }
+    if (index < kBackgroundPhase) r.created_before_background = s.decoders_created;
+    if (!phase.foreground) r.decoders_after_background = s.active_decoders;
+  }
+  // Tiles still waiting for a picture at the end count as late.
+  for (int i = 0; i < kParticipants; ++i) {
+    if (waiting_since[i] >= 0) {
+      r.max_first_frame_ticks = std::max(r.max_first_frame_ticks, ticks - waiting_since[i]);
+    }
+  }
+  for (const PhaseResult& p : r.phases) {
+    r.frames += p.frames;
+    r.decode_ms += p.decode_ms;
+  }
+  r.stats = manager.GetStats();
+  return r;
+}
+
+void PrintPhases(const char* name, const Result& r) {
+  std::printf("%s\n%-14s %8s %10s %9s %8s %10s\n", name, "phase", "visible",
+              "decoders", "max_dec", "frames", "cpu_ms/s");
+  for (int i = 0; i < kPhaseCount; ++i) {
+    const PhaseResult& p = r.phases[i];
+    if (p.ticks == 0) continue;
+    std::printf("%-14s %8.1f %10.1f %9d %8lld %10.1f\n", kPhases[i].name,
+                p.visible / p.ticks, p.held / p.ticks, p.max_held,
+                static_cast<long long>(p.frames), p.decode_ms * kFps / p.ticks);
+  }
+}
+
+// A track announcing more layers than its size allows, as a malformed
+// session could: its smallest layer must still be one a decoder accepts.
+bool CheckOversizedLayerCount() {
+  vc::VideoSubscriptionManager manager;
+  manager.AddTrack(TrackId(0), kTopWidth, kTopHeight, 255);
+  const vc::TileVisibility tile{TrackId(0), 2, 1};
+  manager.SetVisibleTiles(&tile, 1, 0);
+  return manager.layer(TrackId(0)) == 0 && manager.GetStats().active_decoders == 1;
+}
+
+// A visible track no decoder can be initialised for stays paused at the SFU
+// rather than receiving frames it drops, and resumes once it can decode.
+bool CheckUndecodableTrackStaysPaused() {
+  vc::VideoSubscriptionManager manager;
+  manager.AddTrack(TrackId(0), 8192, 8192, 1);
+  const vc::TileVisibility tile{TrackId(0), kTileWidth, kTileHeight};
+  manager.SetVisibleTiles(&tile, 1, 0);
+  std::vector<vc::LayerRequest> requests;
+  manager.Update(0, &requests);
+  if (manager.layer(TrackId(0)) != vc::VideoSubscriptionManager::kPaused ||
+      !requests.empty()) {
+    return false;
+  }
+  manager.AddTrack(TrackId(0), kTopWidth, kTopHeight, 1);
+  manager.Update(1, &requests);
+  return requests.size() == 1 && requests[0].layer == 0 && requests[0].keyframe;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool check = argc > 1 && std::strcmp(argv[1], "--check") == 0;
+  bool ok = true;
+  const int ticks = static_cast<int>(kPhases[kPhaseCount - 1].until_s * kFps);
+
+  const std::vector<LayerStream> layers = EncodeLayers();
+  std::printf("%d participants, %d fps, layers", kParticipants, kFps);
+  for (const LayerStream& l : layers) {
+    std::printf(" %dx%d (%zu B/frame)", l.width, l.height, l.deltas[1].data.size());
+  }
+  std::printf("; tiles %dx%d\n\n", kTileWidth, kTileHeight);
+
+  const Result baseline = RunBaseline(layers, ticks);
+  const Result managed = RunManaged(layers, ticks);
+  PrintPhases("decode everything", baseline);
+  std::printf("\n");
+  PrintPhases("visibility-driven", managed);
+
+  const double seconds = static_cast<double>(ticks) / kFps;
+  const vc::VideoSubscriptionManager::Stats& s = managed.stats;
+  std::printf(
+      "\ndecode CPU: %.1f ms/s for everything, %.1f ms/s visibility-driven (%.0f%%)\n",
+      baseline.decode_ms / seconds, managed.decode_ms / seconds,
+      100.0 * managed.decode_ms / baseline.decode_ms);
+  std::printf(
+      "decoders: peak %d held (%d visible), %d created, %d reused from the pool, "
+      "%d destroyed\n",
+      managed.max_held, managed.max_visible, s.decoders_created, s.decoders_reused,
+      s.decoders_destroyed);
+  std::printf(
+      "subscriptions: %d pauses, %d resumes, %d layer switches; %lld frames "
+      "dropped undecoded; first picture within %d frames of a tile appearing\n",
+      s.pauses, s.resumes, s.layer_switches, static_cast<long long>(s.frames_dropped),
+      managed.max_first_frame_ticks);
+
+  if (managed.decode_ms > 0.4 * baseline.decode_ms) {
+    std::printf("  FAIL: decode CPU not well below decoding every stream\n");
+    ok = false;
+  }
+  const PhaseResult& background = managed.phases[kBackgroundPhase];
+  if (background.frames != 0 || managed.decoders_after_background != 0) {
+    std::printf("  FAIL: decoding or holding decoders in the background\n");
+    ok = false;
+  }
+  if (managed.phases[kPanelPhase].visible >= managed.phases[kGridPhase].visible) {
+    std::printf("  FAIL: tiles under the chat panel still shown\n");
+    ok = false;
+  }
+  if (managed.speaker_layer != kLayers - 1 || managed.thumbnail_layer != 0) {
+    std::printf("  FAIL: speaker on layer %d, thumbnails on layer %d\n",
+                managed.speaker_layer, managed.thumbnail_layer);
+    ok = false;
+  }
+  if (managed.max_first_frame_ticks > 2) {
+    std::printf("  FAIL: a tile waited %d frames for a picture\n",
+                managed.max_first_frame_ticks);
+    ok = false;
+  }
+  if (managed.wrong_size_frames != 0 || s.decode_failures != 0) {
+    std::printf("  FAIL: %d frames at the wrong layer size, %lld decode failures\n",
+                managed.wrong_size_frames, static_cast<long long>(s.decode_failures));
+    ok = false;
+  }
+  if (s.decoders_reused == 0 || managed.created_before_background > managed.max_held) {
+    std::printf("  FAIL: decoders churned instead of pooled\n");
+    ok = false;
+  }
+  if (managed.max_held >= kParticipants / 2) {
+    std::printf("  FAIL: holding %d decoders for %d visible tiles\n", managed.max_held,
+                managed.max_visible);
+    ok = false;
+  }
+  if (!CheckOversizedLayerCount()) {
+    std::printf("  FAIL: no decoder for a track with too many layers\n");
+    ok = false;
+  }
+  if (!CheckUndecodableTrackStaysPaused()) {
+    std::printf("  FAIL: a track without a decoder was not kept paused\n");
+    ok = false;
+  }
+  return check && !ok ? 1 : 0;
+}
@@ -0,0 +1,224 @@
+#include "video/background_effect.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace vc {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double MsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// EMA weights in 1/256. A mean mask change above kLargeChange (e.g. the
+// person stood up or walked in) switches to the fast weight so the mask does
+// not ghost.
+constexpr int kSlowAlpha = 90;
+constexpr int kFastAlpha = 205;
+constexpr int kLargeChange = 24;
+
+}  // namespace
+
+void CompositeRow(const uint8_t* fg, const uint8_t* bg, const uint8_t* mask,
+                  uint8_t* out, int width) {
+  int x = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i full = _mm_set1_epi16(256);
+  const __m128i round = _mm_set1_epi16(128);
+  auto blend = [&](__m128i f, __m128i b, __m128i m) {
+    m = _mm_add_epi16(m, _mm_srli_epi16(m, 7));
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(f, m),
+                                _mm_mullo_epi16(b, _mm_sub_epi16(full, m)));
+    return _mm_srli_epi16(_mm_add_epi16(sum, round), 8);
+  };
+  for (; x + 16 <= width; x += 16) {
+    __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fg + x));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bg + x));
+    __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + x));
+    __m128i lo = blend(_mm_unpacklo_epi8(f, zero), _mm_unpacklo_epi8(b, zero),
+                       _mm_unpacklo_epi8(m, zero));
+    __m128i hi = blend(_mm_unpackhi_epi8(f, zero), _mm_unpackhi_epi8(b, zero),
+                       _mm_unpackhi_epi8(m, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x),
+                     _mm_packus_epi16(lo, hi));
+  }
+#elif defined(__ARM_NEON)
+  const uint16x8_t full = vdupq_n_u16(256);
+  auto blend = [&](uint8x8_t f, uint8x8_t b, uint8x8_t m8) {
+    uint16x8_t m = vmovl_u8(m8);
+    m = vaddq_u16(m, vshrq_n_u16(m, 7));
+    uint16x8_t sum = vmulq_u16(vmovl_u8(f), m);
+    sum = vmlaq_u16(sum, vmovl_u8(b), vsubq_u16(full, m));
+    return vrshrn_n_u16(sum, 8);
+  };
+  for (; x + 16 <= width; x += 16) {
+    uint8x16_t f = vld1q_u8(fg + x);
+    uint8x16_t b = vld1q_u8(bg + x);
+    uint8x16_t m = vld1q_u8(mask + x);
+    uint8x8_t lo = blend(vget_low_u8(f), vget_low_u8(b), vget_low_u8(m));
+    uint8x8_t hi = blend(vget_high_u8(f), vget_high_u8(b), vget_high_u8(m));
+    vst1q_u8(out + x, vcombine_u8(lo, hi));
+  }
+#endif
+  for (; x < width; ++x) {
+    int m = mask[x] + (mask[x] >> 7);
+    out[x] = static_cast<uint8_t>((fg[x] * m + bg[x] * (256 - m) + 128) >> 8);
+  }
+}
+
+BackgroundEffect::BackgroundEffect(PersonSegmenter* segmenter,
+                                   const Config& config)
+    : segmenter_(segmenter), config_(config) {
+  const size_t mask_size =
+      static_cast<size_t>(segmenter_->input_width()) * segmenter_->input_height();
+  small_.Allocate(segmenter_->input_width(), segmenter_->input_height());
+  raw_mask_.resize(mask_size);
+  refined_.resize(mask_size);
+  smoothed_.resize(mask_size);
+}
+
+void BackgroundEffect::SetReplacement(const I420Frame& image) {
+  replacement_ = image;
+  replacement_scaled_ = false;
+}
+
+void BackgroundEffect::ResetStats() {
+  int interval = stats_.segmentation_interval;
+  stats_ = Stats();
+  stats_.segmentation_interval = interval;
+}
+
+void BackgroundEffect::Process(I420Frame* frame) {
+  const Clock::time_point start = Clock::now();
+  const int mw = segmenter_->input_width();
+  const int mh = segmenter_->input_height();
+
+  if (!have_mask_ || --frames_until_segmentation_ <= 0) {
+    Clock::time_point t = Clock::now();
+    ScaleFrameBilinear(*frame, &small_);
+    stats_.scale_ms += MsSince(t);
+
+    t = Clock::now();
+    segmenter_->Segment(small_, raw_mask_.data());
+    stats_.segment_ms += MsSince(t);
+    ++stats_.segmentations;
+    frames_until_segmentation_ = stats_.segmentation_interval;
+
+    t = Clock::now();
+    Refine();
+    stats_.refine_ms += MsSince(t);
+  }
+
+  Clock::time_point t = Clock::now();
+  BuildBackground(*frame);
+  stats_.background_ms += MsSince(t);
+
+  t = Clock::now();
+  const int cw = frame->chroma_width();
+  const int ch = frame->chroma_height();
+  const size_t luma_size = static_cast<size_t>(frame->width()) * frame->height();
+  if (mask_changed_ || mask_width_ != frame->width() ||
+      mask_height_ != frame->height()) {
+    mask_width_ = frame->width();
+    mask_height_ = frame->height();
+    luma_mask_.resize(luma_size);
+    chroma_mask_.resize(static_cast<size_t>(cw) * ch);
+    ScalePlaneBilinear(smoothed_.data(), mw, mw, mh, luma_mask_.data(),
+                       frame->width(), frame->width(), frame->height());
+    ScalePlaneBilinear(smoothed_.data(), mw, mw, mh, chroma_mask_.data(), cw,
+                       cw, ch);
+    mask_changed_ = false;
+  }
+  for (int p = 0; p < 3; ++p) {
+    const uint8_t* mask = p == 0 ? luma_mask_.data() : chroma_mask_.data();
+    const int w = frame->plane_width(p);
+    for (int y = 0; y < frame->plane_height(p); ++y) {
+      uint8_t* row = frame->plane(p) + static_cast<size_t>(y) * frame->stride(p);
+      CompositeRow(row,
+                   background_.plane(p) + static_cast<size_t>(y) * background_.stride(p),
+                   mask + static_cast<size_t>(y) * w, row, w);
+    }
+  }
+  stats_.composite_ms += MsSince(t);
+
+  const double total = MsSince(start);
+  stats_.total_ms += total;
+  ++stats_.frames;
+  if (total > config_.budget_ms) {
+    stats_.segmentation_interval = std::min(stats_.segmentation_interval + 1,
+                                            config_.max_segmentation_interval);
+  } else if (total < 0.6 * config_.budget_ms) {
+    stats_.segmentation_interval = std::max(stats_.segmentation_interval - 1, 1);
+  }
+}
+
+void BackgroundEffect::Refine() {
+  const size_t n = raw_mask_.size();
+  if (!have_mask_) {
+    std::copy(raw_mask_.begin(), raw_mask_.end(), refined_.begin());
+    have_mask_ = true;
+  } else {
+    long long change = 0;
+    for (size_t i = 0; i < n; ++i) change += std::abs(raw_mask_[i] - refined_[i]);
+    const int alpha = change > kLargeChange * static_cast<long long>(n)
+                          ? kFastAlpha : kSlowAlpha;
+    for (size_t i = 0; i < n; ++i) {
+      int d = raw_mask_[i] - refined_[i];
+      int step = d * alpha / 256;
+      // Always move at least one level so the mask settles on the target.
+      if (step == 0 && d != 0) step = d > 0 ? 1 : -1;
+      refined_[i] = static_cast<uint8_t>(refined_[i] + step);
+    }
+  }
+  std::copy(refined_.begin(), refined_.end(), smoothed_.begin());
+  mask_changed_ = true;
+  const int mw = segmenter_->input_width();
+  blur_.Apply(smoothed_.data(), mw, mw, segmenter_->input_height(), 1, 1);
+}
+
+void BackgroundEffect::BuildBackground(const I420Frame& frame) {
+  const bool resized = background_.width() != frame.width() ||
+                       background_.height() != frame.height();
+  if (resized) background_.Allocate(frame.width(), frame.height());
+
+  if (config_.mode == Mode::kReplace) {
+    if (resized || !replacement_scaled_) {
+      if (replacement_.width() > 0) {
+        ScaleFrameBilinear(replacement_, &background_);
+      } else {
+        // No image yet: flat grey.
+        std::fill(background_.y(), background_.y() + background_.size_bytes(), 128);
+      }
+      replacement_scaled_ = replacement_.width() > 0;
+    }
+    return;
+  }
+
+  // Blurring at half resolution quarters the work and halves the radius; the
+  // bilinear upsample hides the lost detail, which the blur removes anyway.
+  for (int p = 0; p < 3; ++p) {
+    const int w = frame.plane_width(p);
+    const int h = frame.plane_height(p);
+    const int hw = (w + 1) / 2;
+    const int hh = (h + 1) / 2;
+    half_.resize(static_cast<size_t>(hw) * hh);
+    DownscalePlane2x(frame.plane(p), frame.stride(p), w, h, half_.data(), hw);
+    const int radius = std::max(1, config_.blur_radius / (p == 0 ? 2 : 4));
+    blur_.Apply(half_.data(), hw, hw, hh, radius, 2);
+    ScalePlaneBilinear(half_.data(), hw, hw, hh, background_.plane(p),
+                       background_.stride(p), w, h);
+  }
+}
+
+}  // namespace vc
@@ -0,0 +1,96 @@
+#ifndef VCMEDIA_VIDEO_BACKGROUND_EFFECT_H_
+#define VCMEDIA_VIDEO_BACKGROUND_EFFECT_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "video/box_blur.h"
+#include "video/i420_frame.h"
+#include "video/person_segmenter.h"
+
+namespace vc {
+
+// Background blur / replacement on I420 frames ahead of the encoder, entirely
+// on the CPU. Per frame:
+//   1. downscale to the segmenter's input size and segment the person,
+//   2. refine the mask temporally (EMA, faster on large changes) and smooth,
+//   3. build the background: a box blur run at half resolution, or a
+//      replacement image scaled once to the frame size,
+//   4. composite foreground over background with the upsampled mask (SIMD).
+// When a frame takes longer than the budget, segmentation is run only every
+// N-th frame (up to max_segmentation_interval) and the refined mask is
+// reused in between. No allocations happen after the first frame at a size.
+class BackgroundEffect {
+ public:
+  enum class Mode { kBlur, kReplace };
+
+  struct Config {
+    Mode mode = Mode::kBlur;
+    // Blur radius in full resolution luma pixels.
+    int blur_radius = 12;
+    // Processing time target for the whole effect per frame.
+    double budget_ms = 12.0;
+    int max_segmentation_interval = 4;
+  };
+
+  // Cumulative per-stage wall time.
+  struct Stats {
+    int frames = 0;
+    int segmentations = 0;
+    int segmentation_interval = 1;
+    double scale_ms = 0.0;
+    double segment_ms = 0.0;
+    double refine_ms = 0.0;
+    double background_ms = 0.0;
+    double composite_ms = 0.0;
+    double total_ms = 0.0;
+  };
+
+  // `segmenter` must outlive this object.
+  BackgroundEffect(PersonSegmenter* segmenter, const Config& config);
+
+  // Image used in Mode::kReplace; any size, scaled to the frame.
+  void SetReplacement(const I420Frame& image);
+
+  void Process(I420Frame* frame);
+
+  const Stats& stats() const { return stats_; }
+  void ResetStats();
+  // Smoothed person mask at the segmenter's input size.
+  const uint8_t* mask() const { return smoothed_.data(); }
+
+ private:
+  void Refine();
+  void BuildBackground(const I420Frame& frame);
+
+  PersonSegmenter* const segmenter_;
+  const Config config_;
+  Stats stats_;
+  int frames_until_segmentation_ = 0;
+  bool have_mask_ = false;
+  bool mask_changed_ = false;
+
+  I420Frame small_;
+  std::vector<uint8_t> raw_mask_;
+  std::vector<uint8_t> refined_;
+  std::vector<uint8_t> smoothed_;
+  // Size of the frame the full-resolution masks were scaled to.
+  int mask_width_ = 0;
+  int mask_height_ = 0;
+  std::vector<uint8_t> luma_mask_;
+  std::vector<uint8_t> chroma_mask_;
+  I420Frame background_;
+  std::vector<uint8_t> half_;
+  BoxBlur blur_;
+  I420Frame replacement_;
+  bool replacement_scaled_ = false;
+};
+
+// out = (fg * m + bg * (256 - m)) >> 8 with m = mask + (mask >> 7), so a mask
+// of 255 keeps the foreground exactly. Rows are `width` bytes, no stride.
+void CompositeRow(const uint8_t* fg, const uint8_t* bg, const uint8_t* mask,
+                  uint8_t* out, int width);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_BACKGROUND_EFFECT_H_
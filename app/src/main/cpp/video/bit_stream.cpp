@@ -0,0 +1,72 @@
+#include "video/bit_stream.h"
+
+namespace vc {
+
+void BitWriter::WriteBits(uint32_t value, int count) {
+  buffer_ = (buffer_ << count) | (value & ((uint64_t{1} << count) - 1));
+  bits_ += count;
+  while (bits_ >= 8) {
+    bits_ -= 8;
+    out_->push_back(static_cast<uint8_t>(buffer_ >> bits_));
+  }
+}
+
+void BitWriter::WriteUe(uint32_t value) {
+  uint64_t v = uint64_t{value} + 1;
+  int length = 0;
+  while ((v >> length) > 1) ++length;
+  WriteBits(0, length);
+  // At most 33 bits; split so WriteBits never shifts by 32 or more.
+  if (length >= 16) {
+    WriteBits(static_cast<uint32_t>(v >> 16), length + 1 - 16);
+    WriteBits(static_cast<uint32_t>(v & 0xffff), 16);
+  } else {
+    WriteBits(static_cast<uint32_t>(v), length + 1);
+  }
+}
+
+void BitWriter::WriteSe(int32_t value) {
+  WriteUe(value > 0 ? 2 * static_cast<uint32_t>(value) - 1
+                    : 2 * static_cast<uint32_t>(-static_cast<int64_t>(value)));
+}
+
+void BitWriter::Flush() {
+  if (bits_ > 0) WriteBits(0, 8 - bits_);
+}
+
+uint32_t BitReader::ReadBits(int count) {
+  while (cache_bits_ < count) {
+    uint8_t byte = 0;
+    if (pos_ < size_) {
+      byte = data_[pos_++];
+    } else {
+      overrun_ = true;
+    }
+    cache_ = (cache_ << 8) | byte;
+    cache_bits_ += 8;
+  }
+  cache_bits_ -= count;
+  return static_cast<uint32_t>((cache_ >> cache_bits_) &
+                               ((uint64_t{1} << count) - 1));
+}
+
+uint32_t BitReader::ReadUe() {
+  int zeros = 0;
+  while (ReadBits(1) == 0) {
+    if (overrun_ || ++zeros > 31) {
+      overrun_ = true;
+      return 0;
+    }
+  }
+  if (zeros == 0) return 0;
+  uint64_t v = (uint64_t{1} << zeros) | ReadBits(zeros);
+  return static_cast<uint32_t>(v - 1);
+}
+
+int32_t BitReader::ReadSe() {
+  uint32_t u = ReadUe();
+  return u & 1 ? static_cast<int32_t>((u + 1) / 2)
+               : -static_cast<int32_t>(u / 2);
+}
+
+}  // namespace vc
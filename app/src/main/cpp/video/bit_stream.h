@@ -0,0 +1,50 @@
+#ifndef VCMEDIA_VIDEO_BIT_STREAM_H_
+#define VCMEDIA_VIDEO_BIT_STREAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vc {
+
+// MSB-first bit writer with Exp-Golomb codes, appending to a byte vector.
+class BitWriter {
+ public:
+  explicit BitWriter(std::vector<uint8_t>* out) : out_(out) {}
+
+  void WriteBits(uint32_t value, int count);
+  // Unsigned and signed Exp-Golomb (0, 1, -1, 2, -2, ...).
+  void WriteUe(uint32_t value);
+  void WriteSe(int32_t value);
+  // Pads the last byte with zeros.
+  void Flush();
+
+ private:
+  std::vector<uint8_t>* out_;
+  uint64_t buffer_ = 0;
+  int bits_ = 0;
+};
+
+// Reader for BitWriter output. Reads past the end return zeros and set
+// overrun(), so a truncated frame is detected once instead of per call.
+class BitReader {
+ public:
+  BitReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  uint32_t ReadBits(int count);
+  uint32_t ReadUe();
+  int32_t ReadSe();
+  bool overrun() const { return overrun_; }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t pos_ = 0;
+  uint64_t cache_ = 0;
+  int cache_bits_ = 0;
+  bool overrun_ = false;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_BIT_STREAM_H_
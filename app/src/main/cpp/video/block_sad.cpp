@@ -0,0 +1,78 @@
+#include "video/block_sad.h"
+
+#include <cstdlib>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace vc {
+
+uint32_t Sad16x16(const uint8_t* a, int a_stride, const uint8_t* b,
+                  int b_stride) {
+#if defined(__SSE2__)
+  __m128i acc = _mm_setzero_si128();
+  for (int y = 0; y < 16; ++y) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + y * a_stride));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + y * b_stride));
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+  }
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(acc) +
+                               _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+#elif defined(__ARM_NEON)
+  uint16x8_t acc = vdupq_n_u16(0);
+  for (int y = 0; y < 16; ++y) {
+    uint8x16_t va = vld1q_u8(a + y * a_stride);
+    uint8x16_t vb = vld1q_u8(b + y * b_stride);
+    acc = vabal_u8(acc, vget_low_u8(va), vget_low_u8(vb));
+    acc = vabal_u8(acc, vget_high_u8(va), vget_high_u8(vb));
+  }
+  uint32x4_t s = vpaddlq_u16(acc);
+  return vgetq_lane_u32(s, 0) + vgetq_lane_u32(s, 1) + vgetq_lane_u32(s, 2) +
+         vgetq_lane_u32(s, 3);
+#else
+  return SadBlock(a, a_stride, b, b_stride, 16, 16);
+#endif
+}
+
+uint32_t Sad8x8(const uint8_t* a, int a_stride, const uint8_t* b, int b_stride) {
+#if defined(__SSE2__)
+  __m128i acc = _mm_setzero_si128();
+  for (int y = 0; y < 8; y += 2) {
+    __m128i va = _mm_unpacklo_epi64(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + y * a_stride)),
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + (y + 1) * a_stride)));
+    __m128i vb = _mm_unpacklo_epi64(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + y * b_stride)),
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + (y + 1) * b_stride)));
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+  }
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(acc) +
+                               _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+#elif defined(__ARM_NEON)
+  uint16x8_t acc = vdupq_n_u16(0);
+  for (int y = 0; y < 8; ++y) {
+    acc = vabal_u8(acc, vld1_u8(a + y * a_stride), vld1_u8(b + y * b_stride));
+  }
+  uint32x4_t s = vpaddlq_u16(acc);
+  return vgetq_lane_u32(s, 0) + vgetq_lane_u32(s, 1) + vgetq_lane_u32(s, 2) +
+         vgetq_lane_u32(s, 3);
+#else
+  return SadBlock(a, a_stride, b, b_stride, 8, 8);
+#endif
+}
+
+uint32_t SadBlock(const uint8_t* a, int a_stride, const uint8_t* b,
+                  int b_stride, int width, int height) {
+  uint32_t sum = 0;
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* ra = a + y * a_stride;
+    const uint8_t* rb = b + y * b_stride;
+    for (int x = 0; x < width; ++x) sum += std::abs(ra[x] - rb[x]);
+  }
+  return sum;
+}
+
+}  // namespace vc
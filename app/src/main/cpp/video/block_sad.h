@@ -0,0 +1,19 @@
+#ifndef VCMEDIA_VIDEO_BLOCK_SAD_H_
+#define VCMEDIA_VIDEO_BLOCK_SAD_H_
+
+#include <cstdint>
+
+namespace vc {
+
+// Sum of absolute differences between two 8-bit blocks. The fixed-size
+// versions use SSE2 (psadbw) or NEON; SadBlock is the scalar reference and
+// handles partial blocks at frame edges.
+uint32_t Sad16x16(const uint8_t* a, int a_stride, const uint8_t* b,
+                  int b_stride);
+uint32_t Sad8x8(const uint8_t* a, int a_stride, const uint8_t* b, int b_stride);
+uint32_t SadBlock(const uint8_t* a, int a_stride, const uint8_t* b,
+                  int b_stride, int width, int height);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_BLOCK_SAD_H_
@@ -0,0 +1,141 @@
+#include "video/box_blur.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace vc {
+
+namespace {
+
+// sums += add - sub, for one row.
+void UpdateSums(uint16_t* sums, const uint8_t* add, const uint8_t* sub,
+                int width) {
+  int x = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  for (; x + 16 <= width; x += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(add + x));
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sub + x));
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x + 8));
+    lo = _mm_sub_epi16(_mm_add_epi16(lo, _mm_unpacklo_epi8(a, zero)),
+                       _mm_unpacklo_epi8(s, zero));
+    hi = _mm_sub_epi16(_mm_add_epi16(hi, _mm_unpackhi_epi8(a, zero)),
+                       _mm_unpackhi_epi8(s, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + x), lo);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + x + 8), hi);
+  }
+#elif defined(__ARM_NEON)
+  for (; x + 16 <= width; x += 16) {
+    uint8x16_t a = vld1q_u8(add + x);
+    uint8x16_t s = vld1q_u8(sub + x);
+    uint16x8_t lo = vld1q_u16(sums + x);
+    uint16x8_t hi = vld1q_u16(sums + x + 8);
+    lo = vsubq_u16(vaddw_u8(lo, vget_low_u8(a)), vmovl_u8(vget_low_u8(s)));
+    hi = vsubq_u16(vaddw_u8(hi, vget_high_u8(a)), vmovl_u8(vget_high_u8(s)));
+    vst1q_u16(sums + x, lo);
+    vst1q_u16(sums + x + 8, hi);
+  }
+#endif
+  for (; x < width; ++x) {
+    sums[x] = static_cast<uint16_t>(sums[x] + add[x] - sub[x]);
+  }
+}
+
+// out = (sums + half) * recip >> 16, i.e. sums / window rounded.
+void EmitRow(const uint16_t* sums, uint16_t half, uint16_t recip, uint8_t* out,
+             int width) {
+  int x = 0;
+#if defined(__SSE2__)
+  const __m128i h = _mm_set1_epi16(static_cast<short>(half));
+  const __m128i r = _mm_set1_epi16(static_cast<short>(recip));
+  for (; x + 16 <= width; x += 16) {
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x + 8));
+    lo = _mm_mulhi_epu16(_mm_add_epi16(lo, h), r);
+    hi = _mm_mulhi_epu16(_mm_add_epi16(hi, h), r);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x),
+                     _mm_packus_epi16(lo, hi));
+  }
+#elif defined(__ARM_NEON)
+  const uint16x8_t h = vdupq_n_u16(half);
+  const uint16x4_t r = vdup_n_u16(recip);
+  for (; x + 16 <= width; x += 16) {
+    uint16x8_t lo = vaddq_u16(vld1q_u16(sums + x), h);
+    uint16x8_t hi = vaddq_u16(vld1q_u16(sums + x + 8), h);
+    uint16x8_t qlo = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(lo), r), 16),
+                                  vshrn_n_u32(vmull_u16(vget_high_u16(lo), r), 16));
+    uint16x8_t qhi = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(hi), r), 16),
+                                  vshrn_n_u32(vmull_u16(vget_high_u16(hi), r), 16));
+    vst1q_u8(out + x, vcombine_u8(vqmovn_u16(qlo), vqmovn_u16(qhi)));
+  }
+#endif
+  for (; x < width; ++x) {
+    out[x] = static_cast<uint8_t>(((sums[x] + half) * recip) >> 16);
+  }
+}
+
+}  // namespace
+
+void BoxBlur::Apply(uint8_t* plane, int stride, int width, int height,
+                    int radius, int passes) {
+  radius = std::clamp(radius, 1, 127);
+  for (int i = 0; i < passes; ++i) {
+    Horizontal(plane, stride, width, height, radius);
+    Vertical(plane, stride, width, height, radius);
+  }
+}
+
+void BoxBlur::Horizontal(uint8_t* plane, int stride, int width, int height,
+                         int radius) {
+  const int window = 2 * radius + 1;
+  const uint32_t recip = (65536 + window / 2) / window;
+  row_.resize(width);
+  for (int y = 0; y < height; ++y) {
+    uint8_t* p = plane + static_cast<size_t>(y) * stride;
+    std::memcpy(row_.data(), p, width);
+    const uint8_t* r = row_.data();
+    uint32_t sum = (radius + 1) * r[0];
+    for (int k = 1; k <= radius; ++k) sum += r[std::min(k, width - 1)];
+    for (int x = 0; x < width; ++x) {
+      p[x] = static_cast<uint8_t>(((sum + window / 2) * recip) >> 16);
+      sum += r[std::min(x + radius + 1, width - 1)];
+      sum -= r[std::max(x - radius, 0)];
+    }
+  }
+}
+
+void BoxBlur::Vertical(uint8_t* plane, int stride, int width, int height,
+                       int radius) {
+  const int window = 2 * radius + 1;
+  const uint16_t recip = static_cast<uint16_t>((65536 + window / 2) / window);
+  const uint16_t half = static_cast<uint16_t>(window / 2);
+  scratch_.resize(static_cast<size_t>(width) * height);
+  sums_.assign(width, 0);
+  auto row = [&](int y) {
+    return plane + static_cast<size_t>(std::clamp(y, 0, height - 1)) * stride;
+  };
+
+  for (int x = 0; x < width; ++x) sums_[x] = static_cast<uint16_t>((radius + 1) * plane[x]);
+  for (int k = 1; k <= radius; ++k) {
+    const uint8_t* r = row(k);
+    for (int x = 0; x < width; ++x) sums_[x] = static_cast<uint16_t>(sums_[x] + r[x]);
+  }
+  for (int y = 0; y < height; ++y) {
+    EmitRow(sums_.data(), half, recip,
+            scratch_.data() + static_cast<size_t>(y) * width, width);
+    UpdateSums(sums_.data(), row(y + radius + 1), row(y - radius), width);
+  }
+  for (int y = 0; y < height; ++y) {
+    std::memcpy(plane + static_cast<size_t>(y) * stride,
+                scratch_.data() + static_cast<size_t>(y) * width, width);
+  }
+}
+
+}  // namespace vc
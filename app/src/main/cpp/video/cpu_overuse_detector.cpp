@@ -0,0 +1,90 @@
+#include "video/cpu_overuse_detector.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vc {
+
+namespace {
+
+// Measurements need this many frames before a check can act on them.
+constexpr int kMinSamples = 15;
+
+}  // namespace
+
+CpuOveruseDetector::CpuOveruseDetector(const Config& config)
+    : config_(config), rampup_delay_ms_(config.initial_rampup_delay_ms) {}
+
+void CpuOveruseDetector::OnFrameEncoded(int64_t capture_time_us,
+                                        int64_t encode_time_us) {
+  const double encode_ms = encode_time_us / 1000.0;
+  if (last_capture_us_ < 0 || capture_time_us <= last_capture_us_) {
+    // The first frame after a reset has no interval yet.
+    last_capture_us_ = capture_time_us;
+    return;
+  }
+  const double interval_ms = (capture_time_us - last_capture_us_) / 1000.0;
+  last_capture_us_ = capture_time_us;
+  if (samples_ == 0) {
+    encode_ms_ = encode_ms;
+    interval_ms_ = interval_ms;
+  } else {
+    // Time-based weight, so the filter responds equally at any frame rate.
+    const double alpha =
+        1.0 - std::exp(-interval_ms / config_.filter_time_constant_ms);
+    encode_ms_ += alpha * (encode_ms - encode_ms_);
+    interval_ms_ += alpha * (interval_ms - interval_ms_);
+  }
+  ++samples_;
+}
+
+int CpuOveruseDetector::usage_percent() const {
+  if (samples_ == 0 || interval_ms_ <= 0.0) return 0;
+  return static_cast<int>(std::lround(100.0 * encode_ms_ / interval_ms_));
+}
+
+CpuOveruseDetector::Action CpuOveruseDetector::Check(int64_t now_ms) {
+  if (last_check_ms_ >= 0 && now_ms - last_check_ms_ < config_.check_interval_ms) {
+    return Action::kNone;
+  }
+  last_check_ms_ = now_ms;
+  if (samples_ < kMinSamples) return Action::kNone;
+
+  const int usage = usage_percent();
+  if (usage >= config_.high_threshold_percent) {
+    if (++overused_checks_ < config_.overuse_checks) return Action::kNone;
+    if (last_rampup_ms_ >= 0 &&
+        now_ms - last_rampup_ms_ < config_.premature_rampup_ms) {
+      rampup_delay_ms_ = std::min(rampup_delay_ms_ * 2, config_.max_rampup_delay_ms);
+    } else {
+      rampup_delay_ms_ = config_.initial_rampup_delay_ms;
+    }
+    last_rampup_ms_ = -1;
+    last_change_ms_ = now_ms;
+    ResetMeasurements();
+    return Action::kAdaptDown;
+  }
+  overused_checks_ = 0;
+  if (usage < config_.low_threshold_percent &&
+      now_ms - last_change_ms_ >= rampup_delay_ms_) {
+    last_rampup_ms_ = now_ms;
+    last_change_ms_ = now_ms;
+    ResetMeasurements();
+    return Action::kAdaptUp;
+  }
+  return Action::kNone;
+}
+
+void CpuOveruseDetector::OnAdaptationRejected(Action action) {
+  // Already at the top: nothing was probed, so a later overuse is not a
+  // premature ramp-up.
+  if (action == Action::kAdaptUp) last_rampup_ms_ = -1;
+}
+
+void CpuOveruseDetector::ResetMeasurements() {
+  samples_ = 0;
+  overused_checks_ = 0;
+  last_capture_us_ = -1;
+}
+
+}  // namespace vc
@@ -0,0 +1,67 @@
+#ifndef VCMEDIA_VIDEO_CPU_OVERUSE_DETECTOR_H_
+#define VCMEDIA_VIDEO_CPU_OVERUSE_DETECTOR_H_
+
+#include <cstdint>
+
+namespace vc {
+
+// Watches encode time against the capture frame interval and tells the
+// caller when to step video quality down (CPU overused) or back up
+// (headroom returned).
+//
+// Usage is the smoothed encode time as a percentage of the smoothed frame
+// interval; once it passes 100% frames queue up and the call lags. Checks
+// run once per check interval. Stepping down needs several consecutive
+// overused checks; stepping up needs low usage and a ramp-up delay since the
+// last change. If a step up is followed by overuse soon after, the ramp-up
+// delay doubles, so a device that cannot sustain a level stops probing it.
+class CpuOveruseDetector {
+ public:
+  struct Config {
+    int high_threshold_percent = 85;
+    int low_threshold_percent = 45;
+    int check_interval_ms = 1000;
+    int overuse_checks = 2;
+    int initial_rampup_delay_ms = 10000;
+    int max_rampup_delay_ms = 240000;
+    // A step up that is reverted within this time counts as premature.
+    int premature_rampup_ms = 15000;
+    // Smoothing time constant for encode time and frame interval.
+    int filter_time_constant_ms = 1000;
+  };
+
+  enum class Action { kNone, kAdaptDown, kAdaptUp };
+
+  CpuOveruseDetector() : CpuOveruseDetector(Config()) {}
+  explicit CpuOveruseDetector(const Config& config);
+
+  // Call once per encoded frame with its capture time and encode duration.
+  void OnFrameEncoded(int64_t capture_time_us, int64_t encode_time_us);
+  // Call periodically (e.g. from the encoder thread's timer); returns at most
+  // one action per check interval. After acting the caller changes the
+  // operating point and measurements restart.
+  Action Check(int64_t now_ms);
+  // When the caller cannot go further in the requested direction.
+  void OnAdaptationRejected(Action action);
+
+  int usage_percent() const;
+  int rampup_delay_ms() const { return rampup_delay_ms_; }
+
+ private:
+  void ResetMeasurements();
+
+  const Config config_;
+  double encode_ms_ = 0.0;
+  double interval_ms_ = 0.0;
+  int samples_ = 0;
+  int64_t last_capture_us_ = -1;
+  int64_t last_check_ms_ = -1;
+  int64_t last_rampup_ms_ = -1;
+  int64_t last_change_ms_ = 0;
+  int overused_checks_ = 0;
+  int rampup_delay_ms_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_CPU_OVERUSE_DETECTOR_H_
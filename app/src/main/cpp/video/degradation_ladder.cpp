@@ -0,0 +1,74 @@
+#include "video/degradation_ladder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace vc {
+
+namespace {
+
+// Each resolution step keeps about 3/4 of the width and height (roughly
+// half the pixels: 720p, 540p, 360p, 270p...); frame rates follow common
+// capture rates.
+constexpr double kScaleSteps[] = {1.0, 0.75, 0.5, 0.375, 0.25};
+constexpr int kFrameRates[] = {30, 24, 20, 15, 10, 7};
+constexpr int kMinBalancedFramerate = 10;
+
+int Even(double v) { return std::max(2, static_cast<int>(std::lround(v / 2)) * 2); }
+
+}  // namespace
+
+DegradationLadder::DegradationLadder(int width, int height, int framerate,
+                                     DegradationPreference preference) {
+  std::vector<int> rates = {framerate};
+  for (int r : kFrameRates) {
+    if (r < framerate) rates.push_back(r);
+  }
+  auto point = [&](double scale, int fps) {
+    return OperatingPoint{Even(width * scale), Even(height * scale), fps};
+  };
+
+  switch (preference) {
+    case DegradationPreference::kMaintainFramerate:
+      for (double s : kScaleSteps) points_.push_back(point(s, framerate));
+      break;
+    case DegradationPreference::kMaintainResolution:
+      for (int r : rates) points_.push_back(point(1.0, r));
+      break;
+    case DegradationPreference::kBalanced: {
+      // Alternate a frame rate step and a resolution step, never going below
+      // kMinBalancedFramerate; once the frame rate floor is reached, only
+      // resolution drops.
+      size_t s = 0, r = 0;
+      points_.push_back(point(kScaleSteps[s], rates[r]));
+      bool drop_rate = true;
+      while (s + 1 < std::size(kScaleSteps)) {
+        bool can_drop_rate =
+            r + 1 < rates.size() && rates[r + 1] >= kMinBalancedFramerate;
+        if (drop_rate && can_drop_rate) {
+          ++r;
+        } else {
+          ++s;
+        }
+        drop_rate = !drop_rate;
+        points_.push_back(point(kScaleSteps[s], rates[r]));
+      }
+      break;
+    }
+  }
+}
+
+bool DegradationLadder::StepDown() {
+  if (level_ + 1 >= levels()) return false;
+  ++level_;
+  return true;
+}
+
+bool DegradationLadder::StepUp() {
+  if (level_ == 0) return false;
+  --level_;
+  return true;
+}
+
+}  // namespace vc
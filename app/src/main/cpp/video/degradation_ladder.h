@@ -0,0 +1,44 @@
+#ifndef VCMEDIA_VIDEO_DEGRADATION_LADDER_H_
+#define VCMEDIA_VIDEO_DEGRADATION_LADDER_H_
+
+#include <vector>
+
+namespace vc {
+
+enum class DegradationPreference {
+  kMaintainFramerate,   // Camera: drop resolution first.
+  kMaintainResolution,  // Screen share: drop frame rate first.
+  kBalanced,            // Alternate, keeping at least 10 fps.
+};
+
+struct OperatingPoint {
+  int width = 0;
+  int height = 0;
+  int framerate = 0;
+};
+
+// The ordered list of operating points a sender steps through when CPU
+// (or another resource) is short, from the source format downwards.
+// Resolutions are kept even so I420 chroma planes stay whole.
+class DegradationLadder {
+ public:
+  DegradationLadder(int width, int height, int framerate,
+                    DegradationPreference preference);
+
+  const OperatingPoint& current() const { return points_[level_]; }
+  int level() const { return level_; }
+  int levels() const { return static_cast<int>(points_.size()); }
+  const OperatingPoint& at(int level) const { return points_[level]; }
+
+  // Return false when already at the bottom / top.
+  bool StepDown();
+  bool StepUp();
+
+ private:
+  std::vector<OperatingPoint> points_;
+  int level_ = 0;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_DEGRADATION_LADDER_H_
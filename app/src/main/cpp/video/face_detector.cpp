@@ -0,0 +1,152 @@
+#include "video/face_detector.h"
+
+#include <algorithm>
+
+namespace vc {
+
+namespace {
+
+constexpr int kCell = 4;
+
+// Skin chroma ranges from Chai & Ngan, "Face segmentation using skin-color
+// map in videophone applications" (1999).
+constexpr int kMinCb = 77;
+constexpr int kMaxCb = 127;
+constexpr int kMinCr = 133;
+constexpr int kMaxCr = 173;
+// Too dark or blown out to trust the chroma.
+constexpr int kMinLuma = 30;
+constexpr int kMaxLuma = 245;
+
+// Ellipse area over its bounding box.
+constexpr float kEllipseFill = 0.785f;
+constexpr float kMinAspect = 0.8f;
+constexpr float kMaxAspect = 2.0f;
+// A row narrower than this fraction of the widest one starts the neck.
+constexpr float kNeckWidth = 0.5f;
+
+}  // namespace
+
+float FaceBoxIou(const FaceBox& a, const FaceBox& b) {
+  const int x0 = std::max(a.x, b.x);
+  const int y0 = std::max(a.y, b.y);
+  const int x1 = std::min(a.x + a.width, b.x + b.width);
+  const int y1 = std::min(a.y + a.height, b.y + b.height);
+  if (x1 <= x0 || y1 <= y0) return 0.0f;
+  const float inter = static_cast<float>(x1 - x0) * (y1 - y0);
+  const float uni = static_cast<float>(a.width) * a.height +
+                    static_cast<float>(b.width) * b.height - inter;
+  return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+void FaceDetector::Detect(const I420Frame& frame, std::vector<FaceBox>* faces) {
+  faces->clear();
+  const int gw = frame.width() / kCell;
+  const int gh = frame.height() / kCell;
+  if (gw < 3 || gh < 3) return;
+  const size_t cells = static_cast<size_t>(gw) * gh;
+  skin_.assign(cells, 0);
+  cleaned_.assign(cells, 0);
+  labels_.assign(cells, 0);
+
+  // Each cell is 2x2 chroma samples; luma is sampled at the cell centre.
+  for (int gy = 0; gy < gh; ++gy) {
+    const uint8_t* u0 = frame.u() + static_cast<size_t>(2 * gy) * frame.stride_uv();
+    const uint8_t* v0 = frame.v() + static_cast<size_t>(2 * gy) * frame.stride_uv();
+    const uint8_t* u1 = u0 + frame.stride_uv();
+    const uint8_t* v1 = v0 + frame.stride_uv();
+    const uint8_t* luma =
+        frame.y() + static_cast<size_t>(gy * kCell + kCell / 2) * frame.stride_y();
+    uint8_t* out = skin_.data() + static_cast<size_t>(gy) * gw;
+    for (int gx = 0; gx < gw; ++gx) {
+      const int cb = (u0[2 * gx] + u0[2 * gx + 1] + u1[2 * gx] + u1[2 * gx + 1] + 2) >> 2;
+      const int cr = (v0[2 * gx] + v0[2 * gx + 1] + v1[2 * gx] + v1[2 * gx + 1] + 2) >> 2;
+      const int y = luma[gx * kCell + kCell / 2];
+      out[gx] = cb >= kMinCb && cb <= kMaxCb && cr >= kMinCr && cr <= kMaxCr &&
+                y >= kMinLuma && y <= kMaxLuma;
+    }
+  }
+
+  // 3x3 majority vote removes speckle and fills small holes (eyes, mouth)
+  // that would otherwise split a face.
+  for (int gy = 1; gy < gh - 1; ++gy) {
+    for (int gx = 1; gx < gw - 1; ++gx) {
+      int count = 0;
+      for (int dy = -1; dy <= 1; ++dy) {
+        const uint8_t* row = skin_.data() + static_cast<size_t>(gy + dy) * gw + gx;
+        count += row[-1] + row[0] + row[1];
+      }
+      cleaned_[static_cast<size_t>(gy) * gw + gx] = count >= 5;
+    }
+  }
+
+  const int min_cells = std::max(2, config_.min_face_size / kCell);
+  int next_label = 0;
+  for (size_t start = 0; start < cells; ++start) {
+    if (!cleaned_[start] || labels_[start]) continue;
+    // Breadth-first fill; `stack_` keeps every cell of the region so it can
+    // be revisited after the neck cut.
+    ++next_label;
+    stack_.clear();
+    stack_.push_back(static_cast<int32_t>(start));
+    labels_[start] = next_label;
+    int min_x = gw, min_y = gh, max_x = -1, max_y = -1;
+    for (size_t head = 0; head < stack_.size(); ++head) {
+      const int idx = stack_[head];
+      const int x = idx % gw, y = idx / gw;
+      min_x = std::min(min_x, x);
+      max_x = std::max(max_x, x);
+      min_y = std::min(min_y, y);
+      max_y = std::max(max_y, y);
+      const int neighbours[4] = {x > 0 ? idx - 1 : -1, x + 1 < gw ? idx + 1 : -1,
+                                 y > 0 ? idx - gw : -1, y + 1 < gh ? idx + gw : -1};
+      for (int n : neighbours) {
+        if (n >= 0 && cleaned_[n] && !labels_[n]) {
+          labels_[n] = next_label;
+          stack_.push_back(n);
+        }
+      }
+    }
+
+    const int w = max_x - min_x + 1;
+    int h = max_y - min_y + 1;
+    if (w < min_cells || h < min_cells) continue;
+    // Cut at the neck: the first row below the widest one that is much
+    // narrower than it.
+    row_width_.assign(h, 0);
+    for (int32_t idx : stack_) ++row_width_[idx / gw - min_y];
+    const int widest = static_cast<int>(
+        std::max_element(row_width_.begin(), row_width_.end()) - row_width_.begin());
+    for (int r = widest + 1; r < h; ++r) {
+      if (row_width_[r] < kNeckWidth * row_width_[widest]) {
+        h = r;
+        break;
+      }
+    }
+    const float aspect = static_cast<float>(h) / w;
+    if (aspect < kMinAspect || aspect > kMaxAspect) continue;
+    int inside = 0;
+    for (int r = 0; r < h; ++r) inside += row_width_[r];
+    const float fill = static_cast<float>(inside) / (w * h);
+    if (fill < config_.min_fill) continue;
+
+    FaceBox box;
+    box.x = min_x * kCell;
+    box.y = min_y * kCell;
+    box.width = w * kCell;
+    box.height = h * kCell;
+    box.score = std::min(1.0f, fill / kEllipseFill) *
+                (aspect >= 1.0f && aspect <= 1.6f ? 1.0f : 0.7f);
+    faces->push_back(box);
+  }
+
+  std::sort(faces->begin(), faces->end(), [](const FaceBox& a, const FaceBox& b) {
+    return a.score != b.score ? a.score > b.score
+                              : a.width * a.height > b.width * b.height;
+  });
+  if (static_cast<int>(faces->size()) > config_.max_faces) {
+    faces->resize(config_.max_faces);
+  }
+}
+
+}  // namespace vc
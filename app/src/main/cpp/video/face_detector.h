@@ -0,0 +1,62 @@
+#ifndef VCMEDIA_VIDEO_FACE_DETECTOR_H_
+#define VCMEDIA_VIDEO_FACE_DETECTOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "video/i420_frame.h"
+
+namespace vc {
+
+// Axis-aligned face rectangle in luma pixels.
+struct FaceBox {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+  // 0..1; how face-like the skin region's shape is.
+  float score = 0.0f;
+};
+
+// Intersection over union of two boxes, 0 when either is empty.
+float FaceBoxIou(const FaceBox& a, const FaceBox& b);
+
+// Lightweight face detector for region-of-interest coding. Classifies 4x4
+// luma cells as skin from their chroma (Chai & Ngan ranges, which hold
+// across skin tones), cleans the mask with a 3x3 majority filter, and keeps
+// connected skin regions with a face-like size, aspect ratio and fill. A
+// region that continues into the neck is cut where it narrows below the
+// widest row.
+//
+// This is a detector for steering bits, not for recognition: it favours
+// recall and cheapness (well under a millisecond at 360p) over precise
+// boxes. Callers run it every few frames and track in between; see
+// FaceRoiTracker.
+class FaceDetector {
+ public:
+  struct Config {
+    // Smallest face width in luma pixels.
+    int min_face_size = 32;
+    int max_faces = 4;
+    // Minimum fraction of the region's bounding box that is skin.
+    float min_fill = 0.45f;
+  };
+
+  FaceDetector() : FaceDetector(Config()) {}
+  explicit FaceDetector(const Config& config) : config_(config) {}
+
+  // Replaces `faces` with the detections in `frame`, best first.
+  void Detect(const I420Frame& frame, std::vector<FaceBox>* faces);
+
+ private:
+  const Config config_;
+  std::vector<uint8_t> skin_;
+  std::vector<uint8_t> cleaned_;
+  std::vector<int32_t> labels_;
+  std::vector<int32_t> stack_;
+  std::vector<int> row_width_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_FACE_DETECTOR_H_
@@ -0,0 +1,151 @@
+#include "video/face_roi_tracker.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "video/block_sad.h"
+
+namespace vc {
+
+namespace {
+
+constexpr int kBlock = 16;
+
+}  // namespace
+
+void FaceRoiTracker::Reset() {
+  faces_.clear();
+  previous_luma_.clear();
+  width_ = height_ = 0;
+  frames_until_detection_ = 0;
+  missed_detections_ = 0;
+}
+
+const std::vector<FaceBox>& FaceRoiTracker::Update(const I420Frame& frame) {
+  const bool have_previous = frame.width() == width_ && frame.height() == height_ &&
+                             !previous_luma_.empty();
+  if (!have_previous) frames_until_detection_ = 0;
+
+  bool detected = false;
+  if (frames_until_detection_ <= 0) {
+    detector_.Detect(frame, &detected_);
+    ++stats_.detections;
+    frames_until_detection_ = config_.detection_interval;
+    if (!detected_.empty()) {
+      faces_ = detected_;
+      missed_detections_ = 0;
+      detected = true;
+    } else if (++missed_detections_ > config_.max_missed_detections) {
+      faces_.clear();
+    } else {
+      // Keep following the old boxes and look again on the next frame.
+      frames_until_detection_ = 1;
+    }
+  }
+  if (!detected && have_previous && !faces_.empty()) {
+    ++stats_.tracked_frames;
+    for (FaceBox& box : faces_) {
+      if (!Track(frame, &box)) {
+        ++stats_.lost_tracks;
+        frames_until_detection_ = 1;
+      }
+    }
+  }
+  --frames_until_detection_;
+
+  width_ = frame.width();
+  height_ = frame.height();
+  previous_luma_.resize(static_cast<size_t>(width_) * height_);
+  for (int y = 0; y < height_; ++y) {
+    std::memcpy(previous_luma_.data() + static_cast<size_t>(y) * width_,
+                frame.y() + static_cast<size_t>(y) * frame.stride_y(), width_);
+  }
+  return faces_;
+}
+
+bool FaceRoiTracker::Track(const I420Frame& frame, FaceBox* box) const {
+  // Match the whole 16x16 blocks inside the box; a face is mostly texture
+  // that moves rigidly between frames.
+  const int blocks_wide = box->width / kBlock;
+  const int blocks_high = box->height / kBlock;
+  if (blocks_wide == 0 || blocks_high == 0) return false;
+  const int span_w = blocks_wide * kBlock;
+  const int span_h = blocks_high * kBlock;
+  const int x0 = box->x + (box->width - span_w) / 2;
+  const int y0 = box->y + (box->height - span_h) / 2;
+
+  auto cost = [&](int dx, int dy) -> uint32_t {
+    uint32_t sad = 0;
+    for (int by = 0; by < blocks_high; ++by) {
+      for (int bx = 0; bx < blocks_wide; ++bx) {
+        const int x = x0 + bx * kBlock, y = y0 + by * kBlock;
+        sad += Sad16x16(previous_luma_.data() + static_cast<size_t>(y) * width_ + x,
+                        width_,
+                        frame.y() + static_cast<size_t>(y + dy) * frame.stride_y() + x + dx,
+                        frame.stride_y());
+      }
+    }
+    return sad;
+  };
+  const int min_dx = std::max(-config_.search_range, -x0);
+  const int max_dx = std::min(config_.search_range, width_ - x0 - span_w);
+  const int min_dy = std::max(-config_.search_range, -y0);
+  const int max_dy = std::min(config_.search_range, height_ - y0 - span_h);
+  if (min_dx > max_dx || min_dy > max_dy) return false;
+
+  int best_x = std::clamp(0, min_dx, max_dx);
+  int best_y = std::clamp(0, min_dy, max_dy);
+  uint32_t best = cost(best_x, best_y);
+  for (int step = 8; step >= 1; step /= 2) {
+    for (bool moved = true; moved;) {
+      moved = false;
+      const int cx = best_x, cy = best_y;
+      static const int kDirections[8][2] = {{1, 0},  {-1, 0}, {0, 1},  {0, -1},
+                                            {1, 1},  {1, -1}, {-1, 1}, {-1, -1}};
+      for (const auto& d : kDirections) {
+        const int dx = cx + d[0] * step, dy = cy + d[1] * step;
+        if (dx < min_dx || dx > max_dx || dy < min_dy || dy > max_dy) continue;
+        const uint32_t sad = cost(dx, dy);
+        if (sad < best) {
+          best = sad;
+          best_x = dx;
+          best_y = dy;
+          moved = true;
+        }
+      }
+    }
+  }
+
+  box->x = std::clamp(box->x + best_x, 0, width_ - box->width);
+  box->y = std::clamp(box->y + best_y, 0, height_ - box->height);
+  return best <= static_cast<uint32_t>(config_.max_track_error) * span_w * span_h;
+}
+
+bool FaceRoiTracker::BuildQpOffsetMap(int width, int height,
+                                      std::vector<int8_t>* offsets) const {
+  const int blocks_wide = (width + kBlock - 1) / kBlock;
+  const int blocks_high = (height + kBlock - 1) / kBlock;
+  offsets->assign(static_cast<size_t>(blocks_wide) * blocks_high, 0);
+  if (faces_.empty()) return false;
+  for (int by = 0; by < blocks_high; ++by) {
+    for (int bx = 0; bx < blocks_wide; ++bx) {
+      const int cx = bx * kBlock + kBlock / 2;
+      const int cy = by * kBlock + kBlock / 2;
+      int offset = config_.background_qp_offset;
+      for (const FaceBox& f : faces_) {
+        if (cx >= f.x && cx < f.x + f.width && cy >= f.y && cy < f.y + f.height) {
+          offset = config_.face_qp_offset;
+          break;
+        }
+        if (cx >= f.x - kBlock && cx < f.x + f.width + kBlock && cy >= f.y - kBlock &&
+            cy < f.y + f.height + kBlock) {
+          offset = std::min(offset, config_.ring_qp_offset);
+        }
+      }
+      (*offsets)[static_cast<size_t>(by) * blocks_wide + bx] = static_cast<int8_t>(offset);
+    }
+  }
+  return true;
+}
+
+}  // namespace vc
@@ -0,0 +1,79 @@
+#ifndef VCMEDIA_VIDEO_FACE_ROI_TRACKER_H_
+#define VCMEDIA_VIDEO_FACE_ROI_TRACKER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "video/face_detector.h"
+#include "video/i420_frame.h"
+
+namespace vc {
+
+// Keeps face boxes current for region-of-interest encoding at a fraction
+// of the detector's cost: FaceDetector runs every `detection_interval`
+// frames and each box is followed in between by a coarse-to-fine luma SAD
+// search against the previous frame. A box whose match error grows too
+// large triggers a detection on the next frame.
+//
+// The boxes become a per-macroblock QP offset map for
+// VideoEncoder::SetQpOffsetMap: faces get finer quantisation, a one-block
+// ring around them a smaller boost so the transition is not visible, and
+// the background pays for it.
+class FaceRoiTracker {
+ public:
+  struct Config {
+    FaceDetector::Config detector;
+    int detection_interval = 15;
+    // Largest per-frame motion followed between detections, in pixels.
+    int search_range = 16;
+    // Mean absolute luma difference above which a track is considered lost.
+    int max_track_error = 20;
+    // Detections that may come back empty before tracked faces are dropped.
+    int max_missed_detections = 2;
+    int face_qp_offset = -4;
+    int ring_qp_offset = -2;
+    int background_qp_offset = 4;
+  };
+
+  struct Stats {
+    int detections = 0;
+    int tracked_frames = 0;
+    int lost_tracks = 0;
+  };
+
+  FaceRoiTracker() : FaceRoiTracker(Config()) {}
+  explicit FaceRoiTracker(const Config& config)
+      : config_(config), detector_(config.detector) {}
+
+  // Detects or tracks faces in `frame`; frames must share one size until
+  // Reset().
+  const std::vector<FaceBox>& Update(const I420Frame& frame);
+  void Reset();
+
+  const std::vector<FaceBox>& faces() const { return faces_; }
+  const Stats& stats() const { return stats_; }
+
+  // Fills `offsets` with ceil(width / 16) x ceil(height / 16) QP offsets
+  // for the current faces. Returns false, leaving every offset 0, when
+  // there is no face to favour.
+  bool BuildQpOffsetMap(int width, int height, std::vector<int8_t>* offsets) const;
+
+ private:
+  // Moves `box` to its best match in `frame`; false if the match is poor.
+  bool Track(const I420Frame& frame, FaceBox* box) const;
+
+  const Config config_;
+  FaceDetector detector_;
+  std::vector<FaceBox> faces_;
+  std::vector<FaceBox> detected_;
+  std::vector<uint8_t> previous_luma_;
+  int width_ = 0;
+  int height_ = 0;
+  int frames_until_detection_ = 0;
+  int missed_detections_ = 0;
+  Stats stats_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_FACE_ROI_TRACKER_H_
@@ -0,0 +1,140 @@
+#include "video/frame_analyzer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "video/block_sad.h"
+
+namespace vc {
+
+namespace {
+
+constexpr int kBlock = 16;
+// Added to both sides of a complexity ratio so near-static frames, whose
+// difference is mostly noise, do not produce huge swings.
+constexpr float kCostFloor = 2.0f;
+constexpr float kMinRatio = 0.25f;
+constexpr float kMaxRatio = 4.0f;
+constexpr float kAverageAlpha = 0.1f;
+
+}  // namespace
+
+void FrameAnalyzer::BuildThumbnail(const I420Frame& frame) {
+  const int half_width = (frame.width() + 1) / 2;
+  const int half_height = (frame.height() + 1) / 2;
+  thumb_width_ = (half_width + 1) / 2;
+  thumb_height_ = (half_height + 1) / 2;
+  // Padded to whole blocks by edge replication so every block can use the
+  // fixed-size SAD.
+  thumb_stride_ = (thumb_width_ + kBlock - 1) / kBlock * kBlock;
+  const int padded_height = (thumb_height_ + kBlock - 1) / kBlock * kBlock;
+  half_.resize(static_cast<size_t>(half_width) * half_height);
+  thumbnail_.resize(static_cast<size_t>(thumb_stride_) * padded_height);
+
+  DownscalePlane2x(frame.y(), frame.stride_y(), frame.width(), frame.height(),
+                   half_.data(), half_width);
+  DownscalePlane2x(half_.data(), half_width, half_width, half_height,
+                   thumbnail_.data(), thumb_stride_);
+  for (int y = 0; y < padded_height; ++y) {
+    uint8_t* row = thumbnail_.data() + static_cast<size_t>(y) * thumb_stride_;
+    if (y >= thumb_height_) {
+      std::memcpy(row, row - thumb_stride_, thumb_stride_);
+      continue;
+    }
+    std::memset(row + thumb_width_, row[thumb_width_ - 1], thumb_stride_ - thumb_width_);
+  }
+
+  histogram_.fill(0);
+  for (int y = 0; y < thumb_height_; ++y) {
+    const uint8_t* row = thumbnail_.data() + static_cast<size_t>(y) * thumb_stride_;
+    for (int x = 0; x < thumb_width_; ++x) ++histogram_[row[x] >> 2];
+  }
+}
+
+void FrameAnalyzer::Analyze(const I420Frame& frame, FrameAnalysis* analysis) {
+  *analysis = FrameAnalysis();
+  BuildThumbnail(frame);
+  const int pixels = thumb_width_ * thumb_height_;
+
+  uint32_t gradient = 0;
+  for (int y = 0; y + 1 < thumb_height_; ++y) {
+    const uint8_t* row = thumbnail_.data() + static_cast<size_t>(y) * thumb_stride_;
+    for (int x = 0; x + 1 < thumb_width_; ++x) {
+      gradient += std::abs(row[x] - row[x + 1]) + std::abs(row[x] - row[x + thumb_stride_]);
+    }
+  }
+  analysis->spatial_complexity = static_cast<float>(gradient) / pixels;
+
+  if (!have_reference_ || frame.width() != source_width_ ||
+      frame.height() != source_height_) {
+    // The encoder starts with a keyframe anyway; nothing to compare with.
+    source_width_ = frame.width();
+    source_height_ = frame.height();
+    have_reference_ = true;
+    average_difference_ = 0.0f;
+    last_cost_ = -1.0f;
+    static_frames_ = 0;
+    last_encoded_us_ = frame.timestamp_us;
+    std::swap(reference_, thumbnail_);
+    reference_histogram_ = histogram_;
+    return;
+  }
+
+  const int blocks_wide = thumb_stride_ / kBlock;
+  const int blocks_high = static_cast<int>(thumbnail_.size()) / thumb_stride_ / kBlock;
+  const uint32_t block_threshold =
+      static_cast<uint32_t>(config_.block_threshold * kBlock * kBlock);
+  uint64_t total_sad = 0;
+  int changed = 0;
+  for (int by = 0; by < blocks_high; ++by) {
+    for (int bx = 0; bx < blocks_wide; ++bx) {
+      const size_t offset = static_cast<size_t>(by * kBlock) * thumb_stride_ + bx * kBlock;
+      const uint32_t sad = Sad16x16(thumbnail_.data() + offset, thumb_stride_,
+                                    reference_.data() + offset, thumb_stride_);
+      total_sad += sad;
+      changed += sad > block_threshold;
+    }
+  }
+  analysis->temporal_difference =
+      static_cast<float>(total_sad) / (static_cast<float>(thumbnail_.size()));
+  analysis->changed_fraction = static_cast<float>(changed) / (blocks_wide * blocks_high);
+
+  uint32_t histogram_difference = 0;
+  for (int i = 0; i < kHistogramBins; ++i) {
+    histogram_difference += std::abs(static_cast<int>(histogram_[i]) -
+                                     static_cast<int>(reference_histogram_[i]));
+  }
+  const float td = analysis->temporal_difference;
+  analysis->scene_change =
+      td > config_.cut_difference &&
+      histogram_difference > config_.cut_histogram * 2 * pixels &&
+      td > config_.cut_ratio * average_difference_;
+
+  static_frames_ = changed == 0 && !analysis->scene_change ? static_frames_ + 1 : 0;
+  if (static_frames_ > config_.refine_frames &&
+      frame.timestamp_us - last_encoded_us_ <
+          static_cast<int64_t>(config_.max_skip_ms) * 1000) {
+    analysis->encode = false;
+    return;
+  }
+
+  if (analysis->scene_change) {
+    // Inter costs before and after a cut are unrelated; the keyframe
+    // budget is the encoder's business.
+    last_cost_ = -1.0f;
+  } else {
+    if (last_cost_ >= 0.0f) {
+      analysis->complexity_ratio =
+          std::clamp((td + kCostFloor) / (last_cost_ + kCostFloor), kMinRatio, kMaxRatio);
+    }
+    last_cost_ = td;
+    average_difference_ += kAverageAlpha * (td - average_difference_);
+  }
+  last_encoded_us_ = frame.timestamp_us;
+  std::swap(reference_, thumbnail_);
+  reference_histogram_ = histogram_;
+}
+
+}  // namespace vc
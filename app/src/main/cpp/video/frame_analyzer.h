@@ -0,0 +1,96 @@
+#ifndef VCMEDIA_VIDEO_FRAME_ANALYZER_H_
+#define VCMEDIA_VIDEO_FRAME_ANALYZER_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "video/i420_frame.h"
+
+namespace vc {
+
+struct FrameAnalysis {
+  // False for a near-static frame the caller should drop; the receiver
+  // keeps showing the last encoded one.
+  bool encode = true;
+  // Content unrelated to the last encoded frame; encode it as a keyframe.
+  bool scene_change = false;
+  // Mean absolute luma difference to the last encoded frame, per pixel of
+  // the 4x downscaled thumbnail.
+  float temporal_difference = 0.0f;
+  // Share of thumbnail blocks (64x64 source pixels) that changed.
+  float changed_fraction = 0.0f;
+  // Mean absolute neighbour difference within the thumbnail.
+  float spatial_complexity = 0.0f;
+  // Expected coding cost relative to the last encoded frame, for
+  // VideoEncoder::SetFrameComplexity.
+  float complexity_ratio = 1.0f;
+};
+
+// Camera front end ahead of the encoder. Each frame is reduced to a 4x
+// downscaled luma thumbnail and compared with the thumbnail of the last
+// encoded frame in 16x16 blocks using SIMD SAD, plus a luma histogram.
+//
+// Once a few static frames have been encoded, frames where no block changed
+// beyond sensor noise are skipped, up to `max_skip_ms` in a row, so a still
+// person costs almost nothing to send.
+// Skipped frames leave the reference untouched, so slow drift accumulates
+// until it is worth encoding. A frame that differs strongly both in pixels
+// and in histogram, and far more than recent frames did, is a cut and is
+// flagged for a keyframe. Changes in the difference between encoded frames
+// become a complexity ratio that lets rate control raise QP before an
+// expensive frame instead of after it.
+class FrameAnalyzer {
+ public:
+  struct Config {
+    // Mean absolute difference per thumbnail pixel above which a block
+    // counts as changed; the 4x4 averaging leaves sensor noise well below.
+    float block_threshold = 2.0f;
+    // Static frames still encoded after a change, so the encoder can sharpen
+    // the still picture before it is frozen.
+    int refine_frames = 10;
+    // Longest run of skipped frames, so slow lighting changes and the
+    // receiver's freeze detection are not starved.
+    int max_skip_ms = 1000;
+    // A cut needs a mean absolute difference above this, a histogram
+    // difference (0..1) above `cut_histogram`, and `cut_ratio` times the
+    // recent average difference.
+    float cut_difference = 20.0f;
+    float cut_histogram = 0.35f;
+    float cut_ratio = 3.0f;
+  };
+
+  FrameAnalyzer() : FrameAnalyzer(Config()) {}
+  explicit FrameAnalyzer(const Config& config) : config_(config) {}
+
+  // `frame.timestamp_us` bounds runs of skipped frames.
+  void Analyze(const I420Frame& frame, FrameAnalysis* analysis);
+
+ private:
+  static constexpr int kHistogramBins = 64;
+
+  void BuildThumbnail(const I420Frame& frame);
+
+  const Config config_;
+  std::vector<uint8_t> half_;
+  std::vector<uint8_t> thumbnail_;
+  std::vector<uint8_t> reference_;
+  std::array<uint32_t, kHistogramBins> histogram_{};
+  std::array<uint32_t, kHistogramBins> reference_histogram_{};
+  int thumb_width_ = 0;
+  int thumb_height_ = 0;
+  int thumb_stride_ = 0;
+  int source_width_ = 0;
+  int source_height_ = 0;
+  bool have_reference_ = false;
+  int64_t last_encoded_us_ = 0;
+  int static_frames_ = 0;
+  // Smoothed difference of encoded frames and the cost estimate of the
+  // last encoded frame.
+  float average_difference_ = 0.0f;
+  float last_cost_ = 0.0f;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_FRAME_ANALYZER_H_
@@ -0,0 +1,76 @@
+#include "video/i420_frame.h"
+
+#include <algorithm>
+
+namespace vc {
+
+void I420Frame::Allocate(int width, int height) {
+  width_ = width;
+  height_ = height;
+  data_.resize(size_bytes());
+}
+
+void ScalePlaneBilinear(const uint8_t* src, int src_stride, int src_width,
+                        int src_height, uint8_t* dst, int dst_stride,
+                        int dst_width, int dst_height) {
+  // Column taps are the same for every row; keep them between calls.
+  thread_local std::vector<int> x0, frac;
+  x0.resize(dst_width);
+  frac.resize(dst_width);
+  for (int x = 0; x < dst_width; ++x) {
+    // Centre-aligned source position in 16.16 fixed point.
+    int64_t sx = ((2 * x + 1) * static_cast<int64_t>(src_width) << 15) /
+                     dst_width - (1 << 15);
+    sx = std::clamp<int64_t>(sx, 0, static_cast<int64_t>(src_width - 1) << 16);
+    x0[x] = static_cast<int>(sx >> 16);
+    frac[x] = static_cast<int>((sx >> 8) & 0xff);
+  }
+  for (int y = 0; y < dst_height; ++y) {
+    int64_t sy = ((2 * y + 1) * static_cast<int64_t>(src_height) << 15) /
+                     dst_height - (1 << 15);
+    sy = std::clamp<int64_t>(sy, 0, static_cast<int64_t>(src_height - 1) << 16);
+    int y0 = static_cast<int>(sy >> 16);
+    int y1 = std::min(y0 + 1, src_height - 1);
+    int fy = static_cast<int>((sy >> 8) & 0xff);
+    const uint8_t* r0 = src + static_cast<size_t>(y0) * src_stride;
+    const uint8_t* r1 = src + static_cast<size_t>(y1) * src_stride;
+    uint8_t* out = dst + static_cast<size_t>(y) * dst_stride;
+    for (int x = 0; x < dst_width; ++x) {
+      int a = x0[x];
+      int b = std::min(a + 1, src_width - 1);
+      int fx = frac[x];
+      int top = r0[a] * (256 - fx) + r0[b] * fx;
+      int bottom = r1[a] * (256 - fx) + r1[b] * fx;
+      out[x] = static_cast<uint8_t>((top * (256 - fy) + bottom * fy + 32768) >> 16);
+    }
+  }
+}
+
+void ScaleFrameBilinear(const I420Frame& src, I420Frame* dst) {
+  for (int p = 0; p < 3; ++p) {
+    ScalePlaneBilinear(src.plane(p), src.stride(p), src.plane_width(p),
+                       src.plane_height(p), dst->plane(p), dst->stride(p),
+                       dst->plane_width(p), dst->plane_height(p));
+  }
+}
+
+void DownscalePlane2x(const uint8_t* src, int src_stride, int src_width,
+                      int src_height, uint8_t* dst, int dst_stride) {
+  const int dst_width = (src_width + 1) / 2;
+  const int dst_height = (src_height + 1) / 2;
+  for (int y = 0; y < dst_height; ++y) {
+    const uint8_t* r0 = src + static_cast<size_t>(2 * y) * src_stride;
+    const uint8_t* r1 = 2 * y + 1 < src_height ? r0 + src_stride : r0;
+    uint8_t* out = dst + static_cast<size_t>(y) * dst_stride;
+    int x = 0;
+    for (; 2 * x + 1 < src_width; ++x) {
+      out[x] = static_cast<uint8_t>(
+          (r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1] + 2) >> 2);
+    }
+    if (x < dst_width) {
+      out[x] = static_cast<uint8_t>((r0[2 * x] + r1[2 * x] + 1) >> 1);
+    }
+  }
+}
+
+}  // namespace vc
@@ -0,0 +1,73 @@
+#ifndef VCMEDIA_VIDEO_I420_FRAME_H_
+#define VCMEDIA_VIDEO_I420_FRAME_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vc {
+
+// Planar YUV 4:2:0 frame with tightly packed planes. Chroma planes are
+// rounded up for odd sizes.
+class I420Frame {
+ public:
+  I420Frame() = default;
+  I420Frame(int width, int height) { Allocate(width, height); }
+
+  // Resizes the frame, reusing the existing allocation when it is big enough.
+  // Contents are unspecified afterwards.
+  void Allocate(int width, int height);
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  int chroma_width() const { return (width_ + 1) / 2; }
+  int chroma_height() const { return (height_ + 1) / 2; }
+  int stride_y() const { return width_; }
+  int stride_uv() const { return chroma_width(); }
+
+  uint8_t* y() { return data_.data(); }
+  uint8_t* u() { return data_.data() + y_size(); }
+  uint8_t* v() { return data_.data() + y_size() + uv_size(); }
+  const uint8_t* y() const { return data_.data(); }
+  const uint8_t* u() const { return data_.data() + y_size(); }
+  const uint8_t* v() const { return data_.data() + y_size() + uv_size(); }
+
+  // Plane 0 is Y, 1 is U, 2 is V.
+  uint8_t* plane(int i) { return i == 0 ? y() : i == 1 ? u() : v(); }
+  const uint8_t* plane(int i) const { return i == 0 ? y() : i == 1 ? u() : v(); }
+  int plane_width(int i) const { return i == 0 ? width_ : chroma_width(); }
+  int plane_height(int i) const { return i == 0 ? height_ : chroma_height(); }
+  int stride(int i) const { return i == 0 ? stride_y() : stride_uv(); }
+
+  size_t size_bytes() const { return y_size() + 2 * uv_size(); }
+
+  int64_t timestamp_us = 0;
+
+ private:
+  size_t y_size() const { return static_cast<size_t>(width_) * height_; }
+  size_t uv_size() const {
+    return static_cast<size_t>(chroma_width()) * chroma_height();
+  }
+
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<uint8_t> data_;
+};
+
+// Bilinear resampling of one plane; handles both up- and downscaling.
+void ScalePlaneBilinear(const uint8_t* src, int src_stride, int src_width,
+                        int src_height, uint8_t* dst, int dst_stride,
+                        int dst_width, int dst_height);
+
+// Scales every plane of `src` into `dst`, which must already be allocated at
+// the target size.
+void ScaleFrameBilinear(const I420Frame& src, I420Frame* dst);
+
+// 2x2 box downscale of one plane; destination is ceil(width / 2) by
+// ceil(height / 2).
+void DownscalePlane2x(const uint8_t* src, int src_stride, int src_width,
+                      int src_height, uint8_t* dst, int dst_stride);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_I420_FRAME_H_
@@ -0,0 +1,183 @@
+#include "video/int8_conv_net.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace vc {
+
+namespace {
+
+class Reader {
+ public:
+  Reader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  bool Read(void* out, size_t n) {
+    if (pos_ + n > size_) return false;
+    std::memcpy(out, data_ + pos_, n);
+    pos_ += n;
+    return true;
+  }
+  template <typename T>
+  bool Read(T* value) {
+    return Read(value, sizeof(T));
+  }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+int OutputSize(int size, int stride) { return (size + stride - 1) / stride; }
+
+}  // namespace
+
+bool Int8ConvNet::Parse(const uint8_t* data, size_t size) {
+  Reader r(data, size);
+  char magic[4];
+  uint32_t version = 0, count = 0;
+  if (!r.Read(magic, 4) || std::memcmp(magic, "VCNN", 4) != 0 ||
+      !r.Read(&version) || version != 1 || !r.Read(&count) || count > 64) {
+    return false;
+  }
+  std::vector<Layer> layers;
+  for (uint32_t i = 0; i < count; ++i) {
+    uint16_t in = 0, out = 0;
+    uint8_t kernel = 0, stride = 0, relu = 0, reserved = 0;
+    if (!r.Read(&in) || !r.Read(&out) || !r.Read(&kernel) || !r.Read(&stride) ||
+        !r.Read(&relu) || !r.Read(&reserved) || in == 0 || out == 0 ||
+        kernel == 0 || kernel % 2 == 0 || stride == 0) {
+      return false;
+    }
+    if (!layers.empty() && layers.back().out_channels != in) return false;
+    Layer layer;
+    layer.in_channels = in;
+    layer.out_channels = out;
+    layer.kernel = kernel;
+    layer.stride = stride;
+    layer.relu = relu != 0;
+    layer.bias.resize(out);
+    layer.multiplier.resize(out);
+    layer.shift.resize(out);
+    for (int oc = 0; oc < out; ++oc) {
+      if (!r.Read(&layer.bias[oc]) || !r.Read(&layer.multiplier[oc]) ||
+          !r.Read(&layer.shift[oc]) || layer.shift[oc] < 0 ||
+          layer.shift[oc] > 62) {
+        return false;
+      }
+    }
+    layer.weights.resize(static_cast<size_t>(out) * kernel * kernel * in);
+    if (!r.Read(layer.weights.data(), layer.weights.size())) return false;
+    layers.push_back(std::move(layer));
+  }
+  layers_ = std::move(layers);
+  return true;
+}
+
+int Int8ConvNet::total_stride() const {
+  int stride = 1;
+  for (const Layer& l : layers_) stride *= l.stride;
+  return stride;
+}
+
+const int8_t* Int8ConvNet::Run(const int8_t* input, int width, int height) {
+  size_t largest = 0;
+  int w = width, h = height;
+  for (const Layer& l : layers_) {
+    w = OutputSize(w, l.stride);
+    h = OutputSize(h, l.stride);
+    largest = std::max(largest, static_cast<size_t>(w) * h * l.out_channels);
+  }
+  ping_.resize(largest);
+  pong_.resize(largest);
+
+  const int8_t* in = input;
+  int8_t* out = ping_.data();
+  w = width;
+  h = height;
+  for (const Layer& l : layers_) {
+    RunLayer(l, in, w, h, out);
+    w = OutputSize(w, l.stride);
+    h = OutputSize(h, l.stride);
+    in = out;
+    out = out == ping_.data() ? pong_.data() : ping_.data();
+  }
+  return in;
+}
+
+void Int8ConvNet::RunLayer(const Layer& l, const int8_t* in, int in_width,
+                           int in_height, int8_t* out) const {
+  const int out_width = OutputSize(in_width, l.stride);
+  const int out_height = OutputSize(in_height, l.stride);
+  const int pad = l.kernel / 2;
+  const int ic_count = l.in_channels;
+  const int lower = l.relu ? 0 : -128;
+
+  for (int oy = 0; oy < out_height; ++oy) {
+    for (int ox = 0; ox < out_width; ++ox) {
+      int8_t* o = out + (static_cast<size_t>(oy) * out_width + ox) * l.out_channels;
+      for (int oc = 0; oc < l.out_channels; ++oc) {
+        int32_t acc = l.bias[oc];
+        const int8_t* wk = l.weights.data() +
+                           static_cast<size_t>(oc) * l.kernel * l.kernel * ic_count;
+        for (int ky = 0; ky < l.kernel; ++ky) {
+          int iy = oy * l.stride + ky - pad;
+          if (iy < 0 || iy >= in_height) continue;
+          for (int kx = 0; kx < l.kernel; ++kx) {
+            int ix = ox * l.stride + kx - pad;
+            if (ix < 0 || ix >= in_width) continue;
+            const int8_t* px = in + (static_cast<size_t>(iy) * in_width + ix) * ic_count;
+            const int8_t* wp = wk + (ky * l.kernel + kx) * ic_count;
+            int32_t dot = 0;
+            for (int ic = 0; ic < ic_count; ++ic) dot += px[ic] * wp[ic];
+            acc += dot;
+          }
+        }
+        int64_t scaled = static_cast<int64_t>(acc) * l.multiplier[oc];
+        int shift = l.shift[oc];
+        if (shift > 0) scaled = (scaled + (int64_t{1} << (shift - 1))) >> shift;
+        o[oc] = static_cast<int8_t>(std::clamp<int64_t>(scaled, lower, 127));
+      }
+    }
+  }
+}
+
+Int8ConvNet CreateSyntheticSegmentationNet(uint32_t seed) {
+  struct Shape {
+    int in, out, kernel, stride;
+    bool relu;
+  };
+  // 1/4 resolution encoder with a 1x1 logit head.
+  const Shape shapes[] = {
+      {3, 8, 3, 2, true},   {8, 16, 3, 2, true}, {16, 16, 3, 1, true},
+      {16, 16, 3, 1, true}, {16, 1, 1, 1, false},
+  };
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> weight(-127, 127);
+  Int8ConvNet net;
+  for (const Shape& s : shapes) {
+    Int8ConvNet::Layer l;
+    l.in_channels = s.in;
+    l.out_channels = s.out;
+    l.kernel = s.kernel;
+    l.stride = s.stride;
+    l.relu = s.relu;
+    l.weights.resize(static_cast<size_t>(s.out) * s.kernel * s.kernel * s.in);
+    for (int8_t& w : l.weights) w = static_cast<int8_t>(weight(rng));
+    // Scale so activations stay in range: ~1 / (127 * sqrt(fan_in)).
+    double fan_in = s.kernel * s.kernel * s.in;
+    double scale = 1.0 / (127.0 * std::sqrt(fan_in));
+    int shift = 30;
+    for (int oc = 0; oc < s.out; ++oc) {
+      l.bias.push_back(0);
+      l.multiplier.push_back(static_cast<int32_t>(std::lround(scale * (1 << shift))));
+      l.shift.push_back(shift);
+    }
+    net.AddLayer(std::move(l));
+  }
+  return net;
+}
+
+}  // namespace vc
@@ -0,0 +1,69 @@
+#ifndef VCMEDIA_VIDEO_INT8_CONV_NET_H_
+#define VCMEDIA_VIDEO_INT8_CONV_NET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vc {
+
+// Minimal inference for small fully convolutional int8 models: a chain of
+// "same"-padded 2D convolutions with int8 weights and activations, int32
+// accumulation and per-output-channel fixed-point requantisation. Tensors are
+// HWC. This is all the on-device segmentation model needs and avoids pulling
+// a general ML runtime into the app.
+//
+// Serialized format (little endian):
+//   "VCNN" u32 version=1 u32 layer_count, then per layer:
+//   u16 in_channels u16 out_channels u8 kernel u8 stride u8 relu u8 reserved
+//   out_channels x (i32 bias, i32 multiplier, i32 shift)
+//   out_channels * kernel * kernel * in_channels x i8 weights [oc][ky][kx][ic]
+class Int8ConvNet {
+ public:
+  struct Layer {
+    int in_channels = 0;
+    int out_channels = 0;
+    int kernel = 1;
+    int stride = 1;
+    bool relu = false;
+    std::vector<int8_t> weights;
+    std::vector<int32_t> bias;
+    // Output = round(acc * multiplier / 2^shift), saturated to int8.
+    std::vector<int32_t> multiplier;
+    std::vector<int32_t> shift;
+  };
+
+  // Returns false on malformed data.
+  bool Parse(const uint8_t* data, size_t size);
+  void AddLayer(Layer layer) { layers_.push_back(std::move(layer)); }
+
+  int input_channels() const {
+    return layers_.empty() ? 0 : layers_.front().in_channels;
+  }
+  int output_channels() const {
+    return layers_.empty() ? 0 : layers_.back().out_channels;
+  }
+  // Overall downsampling factor of the network.
+  int total_stride() const;
+
+  // Runs the network on an int8 HWC tensor. Returns a pointer to the output
+  // tensor (owned by the net, valid until the next call); its size is
+  // ceil(width / total_stride()) by ceil(height / total_stride()).
+  const int8_t* Run(const int8_t* input, int width, int height);
+
+ private:
+  void RunLayer(const Layer& layer, const int8_t* in, int in_width,
+                int in_height, int8_t* out) const;
+
+  std::vector<Layer> layers_;
+  std::vector<int8_t> ping_;
+  std::vector<int8_t> pong_;
+};
+
+// Random weights with the layer shapes of the person segmentation model, for
+// host benchmarks of inference cost. The mask it produces is meaningless.
+Int8ConvNet CreateSyntheticSegmentationNet(uint32_t seed);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_INT8_CONV_NET_H_
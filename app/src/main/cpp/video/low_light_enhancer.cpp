@@ -0,0 +1,104 @@
+#include "video/low_light_enhancer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vc {
+
+namespace {
+
+// Every 4th pixel of every 4th row is plenty for global statistics.
+constexpr int kSampleStep = 4;
+// Histogram tails ignored for the black and white points.
+constexpr float kClipFraction = 0.005f;
+// Limits on the black-level stretch so noise and a single highlight do not
+// drive the curve.
+constexpr float kMaxBlack = 32.0f;
+constexpr float kMinWhite = 160.0f;
+
+void ApplyLut(const uint8_t* lut, uint8_t* plane, int stride, int width,
+              int height) {
+  for (int y = 0; y < height; ++y) {
+    uint8_t* row = plane + static_cast<size_t>(y) * stride;
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+      const uint8_t a = lut[row[x]], b = lut[row[x + 1]];
+      const uint8_t c = lut[row[x + 2]], d = lut[row[x + 3]];
+      row[x] = a;
+      row[x + 1] = b;
+      row[x + 2] = c;
+      row[x + 3] = d;
+    }
+    for (; x < width; ++x) row[x] = lut[row[x]];
+  }
+}
+
+}  // namespace
+
+void LowLightEnhancer::BuildTables() {
+  const float range = std::max(1.0f, white_ - black_);
+  for (int v = 0; v < 256; ++v) {
+    const float x = std::clamp((v - black_) / range, 0.0f, 1.0f);
+    luma_lut_[v] = static_cast<uint8_t>(std::lround(255.0f * std::pow(x, gamma_)));
+    chroma_lut_[v] = static_cast<uint8_t>(
+        std::clamp<long>(std::lround(128.0f + (v - 128) * saturation_), 0, 255));
+  }
+}
+
+void LowLightEnhancer::Process(I420Frame* frame) {
+  uint32_t histogram[256] = {};
+  uint32_t samples = 0;
+  uint64_t sum = 0;
+  for (int y = kSampleStep / 2; y < frame->height(); y += kSampleStep) {
+    const uint8_t* row = frame->y() + static_cast<size_t>(y) * frame->stride_y();
+    for (int x = kSampleStep / 2; x < frame->width(); x += kSampleStep) {
+      ++histogram[row[x]];
+      sum += row[x];
+      ++samples;
+    }
+  }
+  if (samples == 0) return;
+  const float mean = static_cast<float>(sum) / samples;
+
+  // Target curve for this frame; identity for well-lit input.
+  float black = 0.0f, white = 255.0f, gamma = 1.0f;
+  if (mean < config_.dark_mean) {
+    const uint32_t clip = static_cast<uint32_t>(kClipFraction * samples);
+    uint32_t seen = 0;
+    int lo = 0;
+    while (lo < 255 && seen + histogram[lo] <= clip) seen += histogram[lo++];
+    seen = 0;
+    int hi = 255;
+    while (hi > 0 && seen + histogram[hi] <= clip) seen += histogram[hi--];
+    black = std::min(static_cast<float>(lo), kMaxBlack);
+    white = std::max(static_cast<float>(hi), kMinWhite);
+    // Choose gamma so the stretched mean lands on the target.
+    const float m = std::clamp((mean - black) / (white - black), 0.01f, 0.99f);
+    gamma = std::clamp(std::log(config_.target_mean / 255.0f) / std::log(m),
+                       config_.min_gamma, 1.0f);
+  }
+
+  if (!initialised_) {
+    black_ = black;
+    white_ = white;
+    gamma_ = gamma;
+    initialised_ = true;
+  } else {
+    const float a = config_.adaptation;
+    black_ += a * (black - black_);
+    white_ += a * (white - white_);
+    gamma_ += a * (gamma - gamma_);
+  }
+  saturation_ = 1.0f + (config_.max_saturation - 1.0f) * (1.0f - gamma_) /
+                           std::max(1e-3f, 1.0f - config_.min_gamma);
+  if (gamma_ > 0.995f && black_ < 0.5f && white_ > 254.5f) return;
+
+  BuildTables();
+  ApplyLut(luma_lut_, frame->y(), frame->stride_y(), frame->width(), frame->height());
+  for (int p = 1; p <= 2; ++p) {
+    ApplyLut(chroma_lut_, frame->plane(p), frame->stride(p), frame->plane_width(p),
+             frame->plane_height(p));
+  }
+}
+
+}  // namespace vc
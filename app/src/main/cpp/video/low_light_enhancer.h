@@ -0,0 +1,56 @@
+#ifndef VCMEDIA_VIDEO_LOW_LIGHT_ENHANCER_H_
+#define VCMEDIA_VIDEO_LOW_LIGHT_ENHANCER_H_
+
+#include <cstdint>
+
+#include "video/i420_frame.h"
+
+namespace vc {
+
+// Global tone mapping for underexposed camera frames, in place. A sparse
+// luma histogram gives the black point, white point and mean. Dark frames
+// get a black-level stretch and a gamma curve that lifts the mean towards
+// `target_mean`, plus a matching saturation boost, because dim scenes also
+// look washed out. The curve parameters are smoothed over time so exposure
+// changes and noise do not make the picture flicker. Well-lit frames pass
+// through unchanged.
+//
+// Brightening amplifies noise, so run TemporalDenoiser first.
+class LowLightEnhancer {
+ public:
+  struct Config {
+    // Frames with a mean luma below this are enhanced.
+    float dark_mean = 90.0f;
+    float target_mean = 115.0f;
+    // Lower bound on the gamma exponent; smaller lifts shadows harder.
+    float min_gamma = 0.45f;
+    // Saturation gain at min_gamma; scaled down for gentler curves.
+    float max_saturation = 1.3f;
+    // Per-frame smoothing of the curve parameters.
+    float adaptation = 0.15f;
+  };
+
+  LowLightEnhancer() : LowLightEnhancer(Config()) {}
+  explicit LowLightEnhancer(const Config& config) : config_(config) {}
+
+  void Process(I420Frame* frame);
+
+  // The current curve; 1 when frames pass through.
+  float gamma() const { return gamma_; }
+
+ private:
+  void BuildTables();
+
+  const Config config_;
+  bool initialised_ = false;
+  float black_ = 0.0f;
+  float white_ = 255.0f;
+  float gamma_ = 1.0f;
+  float saturation_ = 1.0f;
+  uint8_t luma_lut_[256] = {};
+  uint8_t chroma_lut_[256] = {};
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_LOW_LIGHT_ENHANCER_H_
@@ -0,0 +1,435 @@
+#include "video/media_codec_video_codec.h"
+
+#include <android/log.h>
+#include <dlfcn.h>
+#include <media/NdkMediaCodec.h>
+#include <media/NdkMediaFormat.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+
+#define LOG_TAG "vcmedia"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace vc {
+
+namespace {
+
+constexpr int kColorFormatYuv420Planar = 19;
+constexpr int kColorFormatYuv420SemiPlanar = 21;
+constexpr uint32_t kBufferFlagKeyFrame = 1;
+constexpr int64_t kInputTimeoutUs = 10000;
+constexpr int64_t kOutputTimeoutUs = 10000;
+
+const char* MimeType(VideoCodecType type) {
+  switch (type) {
+    case VideoCodecType::kVp8:
+      return "video/x-vnd.on2.vp8";
+    case VideoCodecType::kH264:
+      return "video/avc";
+    case VideoCodecType::kVcv:
+      return nullptr;
+  }
+  return nullptr;
+}
+
+void* MediaNdkSymbol(const char* name) {
+  static void* lib = dlopen("libmediandk.so", RTLD_NOW);
+  return lib ? dlsym(lib, name) : nullptr;
+}
+
+// AMediaCodec_setParameters is API 26; minSdk is 24, so resolve it at run
+// time and go without runtime bitrate / keyframe requests on older devices.
+using SetParametersFn = media_status_t (*)(AMediaCodec*, const AMediaFormat*);
+
+SetParametersFn GetSetParameters() {
+  static SetParametersFn fn =
+      reinterpret_cast<SetParametersFn>(MediaNdkSymbol("AMediaCodec_setParameters"));
+  return fn;
+}
+
+// AMediaCodec_getInputFormat is API 28; older devices are assumed to take
+// unpadded input.
+using GetInputFormatFn = AMediaFormat* (*)(AMediaCodec*);
+
+GetInputFormatFn GetInputFormat() {
+  static GetInputFormatFn fn =
+      reinterpret_cast<GetInputFormatFn>(MediaNdkSymbol("AMediaCodec_getInputFormat"));
+  return fn;
+}
+
+void SetParameter(AMediaCodec* codec, const char* key, int32_t value) {
+  SetParametersFn set = GetSetParameters();
+  if (!set) return;
+  AMediaFormat* params = AMediaFormat_new();
+  AMediaFormat_setInt32(params, key, value);
+  set(codec, params);
+  AMediaFormat_delete(params);
+}
+
+struct PlaneLayout {
+  int width = 0;
+  int height = 0;
+  int stride = 0;
+  int slice_height = 0;
+  int color_format = kColorFormatYuv420Planar;
+  // Top-left of the visible area within the coded frame.
+  int crop_left = 0;
+  int crop_top = 0;
+};
+
+// The input layout of a started encoder: many pad the planes to an aligned
+// stride and slice height.
+PlaneLayout InputLayout(AMediaCodec* codec, int width, int height, int color_format) {
+  PlaneLayout layout{width, height, width, height, color_format};
+  GetInputFormatFn get = GetInputFormat();
+  AMediaFormat* format = get ? get(codec) : nullptr;
+  if (!format) return layout;
+  int32_t value = 0;
+  if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_STRIDE, &value) && value >= width) {
+    layout.stride = value;
+  }
+  if (AMediaFormat_getInt32(format, "slice-height", &value) && value >= height) {
+    layout.slice_height = value;
+  }
+  AMediaFormat_delete(format);
+  return layout;
+}
+
+// Writes an I420 frame into a codec input buffer in the codec's layout.
+bool WriteInput(const I420Frame& frame, const PlaneLayout& layout,
+                uint8_t* buffer, size_t capacity) {
+  const size_t y_size = static_cast<size_t>(layout.stride) * layout.slice_height;
+  const int cw = frame.chroma_width();
+  const int ch = frame.chroma_height();
+  if (capacity < y_size * 3 / 2) return false;
+  for (int y = 0; y < frame.height(); ++y) {
+    std::memcpy(buffer + static_cast<size_t>(y) * layout.stride,
+                frame.y() + static_cast<size_t>(y) * frame.stride_y(), frame.width());
+  }
+  uint8_t* chroma = buffer + y_size;
+  if (layout.color_format == kColorFormatYuv420SemiPlanar) {
+    for (int y = 0; y < ch; ++y) {
+      uint8_t* row = chroma + static_cast<size_t>(y) * layout.stride;
+      const uint8_t* u = frame.u() + static_cast<size_t>(y) * frame.stride_uv();
+      const uint8_t* v = frame.v() + static_cast<size_t>(y) * frame.stride_uv();
+      for (int x = 0; x < cw; ++x) {
+        row[2 * x] = u[x];
+        row[2 * x + 1] = v[x];
+      }
+    }
+  } else {
+    const int cs = layout.stride / 2;
+    const size_t c_size = static_cast<size_t>(cs) * (layout.slice_height / 2);
+    for (int y = 0; y < ch; ++y) {
+      std::memcpy(chroma + static_cast<size_t>(y) * cs,
+                  frame.u() + static_cast<size_t>(y) * frame.stride_uv(), cw);
+      std::memcpy(chroma + c_size + static_cast<size_t>(y) * cs,
+                  frame.v() + static_cast<size_t>(y) * frame.stride_uv(), cw);
+    }
+  }
+  return true;
+}
+
+// Reads a decoder output buffer in either YUV 4:2:0 layout into `out`.
+bool ReadOutput(const uint8_t* buffer, size_t size, const PlaneLayout& layout,
+                I420Frame* out) {
+  const size_t y_size = static_cast<size_t>(layout.stride) * layout.slice_height;
+  if (size < y_size * 3 / 2) return false;
+  if (layout.crop_left + layout.width > layout.stride ||
+      layout.crop_top + layout.height > layout.slice_height) {
+    return false;
+  }
+  out->Allocate(layout.width, layout.height);
+  const uint8_t* luma =
+      buffer + static_cast<size_t>(layout.crop_top) * layout.stride + layout.crop_left;
+  for (int y = 0; y < layout.height; ++y) {
+    std::memcpy(out->y() + static_cast<size_t>(y) * out->stride_y(),
+                luma + static_cast<size_t>(y) * layout.stride, layout.width);
+  }
+  const uint8_t* chroma = buffer + y_size;
+  const int cw = out->chroma_width();
+  const int cx = layout.crop_left / 2;
+  const int cy = layout.crop_top / 2;
+  for (int y = 0; y < out->chroma_height(); ++y) {
+    uint8_t* u = out->u() + static_cast<size_t>(y) * out->stride_uv();
+    uint8_t* v = out->v() + static_cast<size_t>(y) * out->stride_uv();
+    if (layout.color_format == kColorFormatYuv420SemiPlanar) {
+      const uint8_t* row = chroma + static_cast<size_t>(cy + y) * layout.stride + 2 * cx;
+      for (int x = 0; x < cw; ++x) {
+        u[x] = row[2 * x];
+        v[x] = row[2 * x + 1];
+      }
+    } else {
+      const int cs = layout.stride / 2;
+      const size_t c_size = static_cast<size_t>(cs) * (layout.slice_height / 2);
+      const size_t offset = static_cast<size_t>(cy + y) * cs + cx;
+      std::memcpy(u, chroma + offset, cw);
+      std::memcpy(v, chroma + c_size + offset, cw);
+    }
+  }
+  return true;
+}
+
+class MediaCodecVideoEncoder : public VideoEncoder {
+ public:
+  explicit MediaCodecVideoEncoder(const char* mime) : mime_(mime) {}
+  ~MediaCodecVideoEncoder() override { Release(); }
+
+  bool Init(const VideoEncoderConfig& config) override {
+    Release();
+    config_ = config;
+    // Planar input is not supported everywhere; fall back to NV12. A failed
+    // configure leaves the codec unusable, and AMediaCodec_reset is API 26,
+    // so each attempt gets a new codec.
+    for (int color : {kColorFormatYuv420Planar, kColorFormatYuv420SemiPlanar}) {
+      codec_ = AMediaCodec_createEncoderByType(mime_);
+      if (!codec_) return false;
+      AMediaFormat* format = AMediaFormat_new();
+      AMediaFormat_setString(format, AMEDIAFORMAT_KEY_MIME, mime_);
+      AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_WIDTH, config.width);
+      AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_HEIGHT, config.height);
+      AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_BIT_RATE, config.bitrate_bps);
+      AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_FRAME_RATE, config.framerate);
+      AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_COLOR_FORMAT, color);
+      // Seconds; keyframes are otherwise requested explicitly.
+      int interval = config.keyframe_interval > 0
+                         ? std::max(1, config.keyframe_interval / config.framerate)
+                         : 3600;
+      AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_I_FRAME_INTERVAL, interval);
+      media_status_t status = AMediaCodec_configure(
+          codec_, format, nullptr, nullptr, AMEDIACODEC_CONFIGURE_FLAG_ENCODE);
+      AMediaFormat_delete(format);
+      if (status == AMEDIA_OK && AMediaCodec_start(codec_) == AMEDIA_OK) {
+        layout_ = InputLayout(codec_, config.width, config.height, color);
+        need_keyframe_ = true;
+        return true;
+      }
+      Release();
+    }
+    LOGE("MediaCodec encoder %s: configure/start failed", mime_);
+    return false;
+  }
+
+  bool Encode(const I420Frame& frame, bool force_keyframe,
+              EncodedFrame* out) override {
+    out->data.clear();
+    if (!codec_) return false;
+    if (force_keyframe || need_keyframe_) {
+      SetParameter(codec_, "request-sync", 0);
+      need_keyframe_ = false;
+    }
+    ssize_t index = AMediaCodec_dequeueInputBuffer(codec_, kInputTimeoutUs);
+    if (index >= 0) {
+      size_t capacity = 0;
+      uint8_t* buffer = AMediaCodec_getInputBuffer(codec_, index, &capacity);
+      if (!buffer || !WriteInput(frame, layout_, buffer, capacity)) {
+        AMediaCodec_queueInputBuffer(codec_, index, 0, 0, frame.timestamp_us, 0);
+        return false;
+      }
+      AMediaCodec_queueInputBuffer(
+          codec_, index, 0, static_cast<size_t>(layout_.stride) * layout_.slice_height * 3 / 2,
+          frame.timestamp_us, 0);
+    }
+    // Otherwise the codec is saturated and this frame is dropped.
+    Drain();
+    if (!pending_.empty()) {
+      *out = std::move(pending_.front());
+      pending_.pop_front();
+    }
+    return true;
+  }
+
+  void SetRates(int bitrate_bps, int framerate) override {
+    if (bitrate_bps > 0 && codec_ && bitrate_bps != config_.bitrate_bps) {
+      SetParameter(codec_, "video-bitrate", bitrate_bps);
+      config_.bitrate_bps = bitrate_bps;
+    }
+    // The frame rate is fixed once configured; it only steers rate control.
+    if (framerate > 0) config_.framerate = framerate;
+  }
+
+  const VideoEncoderConfig& config() const override { return config_; }
+  const char* implementation_name() const override { return "mediacodec"; }
+
+ private:
+  void Drain() {
+    AMediaCodecBufferInfo info;
+    int64_t timeout = kOutputTimeoutUs;
+    while (true) {
+      ssize_t index = AMediaCodec_dequeueOutputBuffer(codec_, &info, timeout);
+      if (index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED ||
+          index == AMEDIACODEC_INFO_OUTPUT_BUFFERS_CHANGED) {
+        continue;
+      }
+      if (index < 0) return;
+      timeout = 0;
+      size_t size = 0;
+      uint8_t* buffer = AMediaCodec_getOutputBuffer(codec_, index, &size);
+      if (buffer && info.size > 0) {
+        const uint8_t* data = buffer + info.offset;
+        if (info.flags & AMEDIACODEC_BUFFER_FLAG_CODEC_CONFIG) {
+          // H.264 parameter sets; sent in front of every keyframe.
+          codec_config_.assign(data, data + info.size);
+        } else {
+          EncodedFrame frame;
+          frame.keyframe = (info.flags & kBufferFlagKeyFrame) != 0;
+          if (frame.keyframe) frame.data = codec_config_;
+          frame.data.insert(frame.data.end(), data, data + info.size);
+          frame.timestamp_us = info.presentationTimeUs;
+          frame.width = config_.width;
+          frame.height = config_.height;
+          pending_.push_back(std::move(frame));
+        }
+      }
+      AMediaCodec_releaseOutputBuffer(codec_, index, false);
+    }
+  }
+
+  void Release() {
+    if (!codec_) return;
+    AMediaCodec_stop(codec_);
+    AMediaCodec_delete(codec_);
+    codec_ = nullptr;
+    pending_.clear();
+    codec_config_.clear();
+  }
+
+  const char* const mime_;
+  VideoEncoderConfig config_;
+  AMediaCodec* codec_ = nullptr;
+  PlaneLayout layout_;
+  bool need_keyframe_ = true;
+  std::vector<uint8_t> codec_config_;
+  std::deque<EncodedFrame> pending_;
+};
+
+class MediaCodecVideoDecoder : public VideoDecoder {
+ public:
+  explicit MediaCodecVideoDecoder(const char* mime) : mime_(mime) {}
+  ~MediaCodecVideoDecoder() override { Release(); }
+
+  bool Init(int width, int height) override {
+    Release();
+    codec_ = AMediaCodec_createDecoderByType(mime_);
+    if (!codec_) return false;
+    AMediaFormat* format = AMediaFormat_new();
+    AMediaFormat_setString(format, AMEDIAFORMAT_KEY_MIME, mime_);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_WIDTH, width);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_HEIGHT, height);
+    media_status_t status = AMediaCodec_configure(codec_, format, nullptr, nullptr, 0);
+    AMediaFormat_delete(format);
+    if (status != AMEDIA_OK || AMediaCodec_start(codec_) != AMEDIA_OK) {
+      LOGE("MediaCodec decoder %s: configure/start failed", mime_);
+      Release();
+      return false;
+    }
+    layout_ = {width, height, width, height, kColorFormatYuv420Planar};
+    return true;
+  }
+
+  bool Decode(const uint8_t* data, size_t size, int64_t timestamp_us,
+              I420Frame* out) override {
+    if (!codec_) return false;
+    ssize_t index = AMediaCodec_dequeueInputBuffer(codec_, kInputTimeoutUs);
+    if (index >= 0) {
+      size_t capacity = 0;
+      uint8_t* buffer = AMediaCodec_getInputBuffer(codec_, index, &capacity);
+      const bool fits = buffer && capacity >= size;
+      if (fits) std::memcpy(buffer, data, size);
+      AMediaCodec_queueInputBuffer(codec_, index, 0, fits ? size : 0, timestamp_us, 0);
+    }
+    // Otherwise the codec is saturated and this frame is dropped.
+
+    // Take every frame that is ready, so output cannot back up behind the
+    // input; `out` ends up with the newest. Once nothing more is ready
+    // (AMEDIACODEC_INFO_TRY_AGAIN_LATER) there is no frame yet, which is
+    // not an error.
+    bool decoded = false;
+    int64_t timeout = kOutputTimeoutUs;
+    AMediaCodecBufferInfo info;
+    while (true) {
+      ssize_t out_index = AMediaCodec_dequeueOutputBuffer(codec_, &info, timeout);
+      if (out_index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
+        UpdateLayout();
+        continue;
+      }
+      if (out_index == AMEDIACODEC_INFO_OUTPUT_BUFFERS_CHANGED) continue;
+      if (out_index < 0) return decoded;
+      timeout = 0;
+      size_t out_size = 0;
+      uint8_t* frame = AMediaCodec_getOutputBuffer(codec_, out_index, &out_size);
+      if (frame && ReadOutput(frame + info.offset, info.size, layout_, out)) {
+        out->timestamp_us = info.presentationTimeUs;
+        decoded = true;
+      }
+      AMediaCodec_releaseOutputBuffer(codec_, out_index, false);
+    }
+  }
+
+  const char* implementation_name() const override { return "mediacodec"; }
+
+ private:
+  void UpdateLayout() {
+    AMediaFormat* format = AMediaCodec_getOutputFormat(codec_);
+    if (!format) return;
+    int32_t value = 0;
+    if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_WIDTH, &value)) layout_.width = value;
+    if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_HEIGHT, &value)) layout_.height = value;
+    layout_.stride = layout_.width;
+    layout_.slice_height = layout_.height;
+    if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_STRIDE, &value) && value > 0) {
+      layout_.stride = value;
+    }
+    if (AMediaFormat_getInt32(format, "slice-height", &value) && value > 0) {
+      layout_.slice_height = value;
+    }
+    if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_COLOR_FORMAT, &value)) {
+      layout_.color_format = value;
+    }
+    // The visible area can be smaller than the coded size, and need not
+    // start at its top-left corner.
+    int32_t left = 0, top = 0, right = 0, bottom = 0;
+    layout_.crop_left = 0;
+    layout_.crop_top = 0;
+    if (AMediaFormat_getInt32(format, "crop-left", &left) &&
+        AMediaFormat_getInt32(format, "crop-top", &top) &&
+        AMediaFormat_getInt32(format, "crop-right", &right) &&
+        AMediaFormat_getInt32(format, "crop-bottom", &bottom) && left >= 0 && top >= 0 &&
+        right >= left && bottom >= top) {
+      layout_.crop_left = left;
+      layout_.crop_top = top;
+      layout_.width = right - left + 1;
+      layout_.height = bottom - top + 1;
+    }
+    AMediaFormat_delete(format);
+  }
+
+  void Release() {
+    if (!codec_) return;
+    AMediaCodec_stop(codec_);
+    AMediaCodec_delete(codec_);
+    codec_ = nullptr;
+  }
+
+  const char* const mime_;
+  AMediaCodec* codec_ = nullptr;
+  PlaneLayout layout_;
+};
+
+}  // namespace
+
+std::unique_ptr<VideoEncoder> CreateMediaCodecVideoEncoder(VideoCodecType type) {
+  const char* mime = MimeType(type);
+  if (!mime) return nullptr;
+  return std::make_unique<MediaCodecVideoEncoder>(mime);
+}
+
+std::unique_ptr<VideoDecoder> CreateMediaCodecVideoDecoder(VideoCodecType type) {
+  const char* mime = MimeType(type);
+  if (!mime) return nullptr;
+  return std::make_unique<MediaCodecVideoDecoder>(mime);
+}
+
+}  // namespace vc
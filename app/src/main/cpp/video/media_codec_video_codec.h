@@ -0,0 +1,18 @@
+#ifndef VCMEDIA_VIDEO_MEDIA_CODEC_VIDEO_CODEC_H_
+#define VCMEDIA_VIDEO_MEDIA_CODEC_VIDEO_CODEC_H_
+
+#include <memory>
+
+#include "video/video_codec.h"
+
+namespace vc {
+
+// Hardware (or platform software) VP8 / H.264 codecs through the NDK
+// MediaCodec API, fed and drained synchronously with short timeouts.
+// Returns nullptr for codec types MediaCodec does not provide.
+std::unique_ptr<VideoEncoder> CreateMediaCodecVideoEncoder(VideoCodecType type);
+std::unique_ptr<VideoDecoder> CreateMediaCodecVideoDecoder(VideoCodecType type);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_MEDIA_CODEC_VIDEO_CODEC_H_
@@ -0,0 +1,71 @@
+#include "video/native_window_render_target.h"
+
+#include <android/log.h>
+#include <android/native_window.h>
+
+#define LOG_TAG "vcmedia"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace vc {
+
+namespace {
+
+class NativeWindowRenderTarget : public RenderTarget {
+ public:
+  explicit NativeWindowRenderTarget(ANativeWindow* window) : window_(window) {
+    ANativeWindow_acquire(window_);
+  }
+  ~NativeWindowRenderTarget() override {
+    if (locked_) ANativeWindow_unlockAndPost(window_);
+    ANativeWindow_release(window_);
+  }
+
+  bool Lock(RgbaBuffer* buffer) override {
+    if (locked_) return false;
+    ANativeWindow_Buffer native;
+    if (ANativeWindow_lock(window_, &native, nullptr) != 0) {
+      LOGE("ANativeWindow_lock failed");
+      return false;
+    }
+    if (native.format != WINDOW_FORMAT_RGBA_8888 &&
+        native.format != WINDOW_FORMAT_RGBX_8888) {
+      LOGE("ANativeWindow buffer format %d is not RGBA", native.format);
+      ANativeWindow_unlockAndPost(window_);
+      return false;
+    }
+    locked_ = true;
+    buffer->pixels = static_cast<uint8_t*>(native.bits);
+    buffer->width = native.width;
+    buffer->height = native.height;
+    // The native stride is in pixels.
+    buffer->stride = native.stride * 4;
+    return true;
+  }
+
+  bool Post() override {
+    if (!locked_) return false;
+    locked_ = false;
+    return ANativeWindow_unlockAndPost(window_) == 0;
+  }
+
+  const char* implementation_name() const override { return "native-window"; }
+
+ private:
+  ANativeWindow* const window_;
+  bool locked_ = false;
+};
+
+}  // namespace
+
+std::unique_ptr<RenderTarget> CreateNativeWindowRenderTarget(ANativeWindow* window,
+                                                             int width, int height) {
+  if (!window || width <= 0 || height <= 0) return nullptr;
+  if (ANativeWindow_setBuffersGeometry(window, width, height,
+                                       WINDOW_FORMAT_RGBA_8888) != 0) {
+    LOGE("ANativeWindow_setBuffersGeometry %dx%d failed", width, height);
+    return nullptr;
+  }
+  return std::make_unique<NativeWindowRenderTarget>(window);
+}
+
+}  // namespace vc
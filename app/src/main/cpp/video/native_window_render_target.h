@@ -0,0 +1,23 @@
+#ifndef VCMEDIA_VIDEO_NATIVE_WINDOW_RENDER_TARGET_H_
+#define VCMEDIA_VIDEO_NATIVE_WINDOW_RENDER_TARGET_H_
+
+#include <memory>
+
+#include "video/render_target.h"
+
+struct ANativeWindow;
+
+namespace vc {
+
+// Draws straight into an ANativeWindow's buffers (e.g. from a SurfaceView's
+// Surface via ANativeWindow_fromSurface), so composed frames never pass
+// through the JVM. The window is configured for RGBA8888 at the given size
+// and the compositor scales into that; the system scales it to the view.
+// Holds a reference to the window. Returns nullptr if it cannot be
+// configured.
+std::unique_ptr<RenderTarget> CreateNativeWindowRenderTarget(ANativeWindow* window,
+                                                             int width, int height);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_NATIVE_WINDOW_RENDER_TARGET_H_
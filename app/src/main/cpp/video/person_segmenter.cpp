@@ -0,0 +1,54 @@
+#include "video/person_segmenter.h"
+
+#include <cmath>
+#include <utility>
+
+namespace vc {
+
+Int8PersonSegmenter::Int8PersonSegmenter() {
+  for (int q = -128; q < 128; ++q) {
+    double p = 1.0 / (1.0 + std::exp(-q / 16.0));
+    sigmoid_[static_cast<uint8_t>(q)] = static_cast<uint8_t>(std::lround(255 * p));
+  }
+}
+
+bool Int8PersonSegmenter::Init(Int8ConvNet net, int input_width,
+                               int input_height) {
+  // The output is read as a single-channel mask; anything else would be
+  // misread, or read past the end of the net's output.
+  if (net.input_channels() != 3 || net.output_channels() != 1 ||
+      input_width <= 0 || input_height <= 0) {
+    return false;
+  }
+  net_ = std::move(net);
+  width_ = input_width;
+  height_ = input_height;
+  const int stride = net_.total_stride();
+  logit_width_ = (input_width + stride - 1) / stride;
+  logit_height_ = (input_height + stride - 1) / stride;
+  tensor_.resize(static_cast<size_t>(input_width) * input_height * 3);
+  low_res_.resize(static_cast<size_t>(logit_width_) * logit_height_);
+  return true;
+}
+
+void Int8PersonSegmenter::Segment(const I420Frame& frame, uint8_t* mask) {
+  int8_t* t = tensor_.data();
+  for (int y = 0; y < height_; ++y) {
+    const uint8_t* ry = frame.y() + static_cast<size_t>(y) * frame.stride_y();
+    const uint8_t* ru = frame.u() + static_cast<size_t>(y / 2) * frame.stride_uv();
+    const uint8_t* rv = frame.v() + static_cast<size_t>(y / 2) * frame.stride_uv();
+    for (int x = 0; x < width_; ++x) {
+      *t++ = static_cast<int8_t>(ry[x] - 128);
+      *t++ = static_cast<int8_t>(ru[x / 2] - 128);
+      *t++ = static_cast<int8_t>(rv[x / 2] - 128);
+    }
+  }
+  const int8_t* logits = net_.Run(tensor_.data(), width_, height_);
+  for (size_t i = 0; i < low_res_.size(); ++i) {
+    low_res_[i] = sigmoid_[static_cast<uint8_t>(logits[i])];
+  }
+  ScalePlaneBilinear(low_res_.data(), logit_width_, logit_width_, logit_height_,
+                     mask, width_, width_, height_);
+}
+
+}  // namespace vc
@@ -0,0 +1,54 @@
+#ifndef VCMEDIA_VIDEO_PERSON_SEGMENTER_H_
+#define VCMEDIA_VIDEO_PERSON_SEGMENTER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "video/i420_frame.h"
+#include "video/int8_conv_net.h"
+
+namespace vc {
+
+// Produces a soft person mask for a frame at the segmenter's input size.
+class PersonSegmenter {
+ public:
+  virtual ~PersonSegmenter() = default;
+
+  virtual int input_width() const = 0;
+  virtual int input_height() const = 0;
+
+  // `frame` is input_width() x input_height(). Writes one byte per pixel to
+  // `mask` (row stride input_width()), 255 = person, 0 = background.
+  virtual void Segment(const I420Frame& frame, uint8_t* mask) = 0;
+};
+
+// Runs a quantized fully convolutional model (see Int8ConvNet) that takes
+// centred YUV as a 3-channel int8 tensor and emits one logit channel at
+// 1/total_stride() resolution, in units of 1/16. Logits go through a sigmoid
+// table and are bilinearly upsampled back to the input size.
+class Int8PersonSegmenter : public PersonSegmenter {
+ public:
+  Int8PersonSegmenter();
+
+  // Returns false if `net` does not map a 3-channel input to a single
+  // logit channel, or the input size is empty. Call before Segment().
+  bool Init(Int8ConvNet net, int input_width, int input_height);
+
+  int input_width() const override { return width_; }
+  int input_height() const override { return height_; }
+  void Segment(const I420Frame& frame, uint8_t* mask) override;
+
+ private:
+  Int8ConvNet net_;
+  int width_ = 0;
+  int height_ = 0;
+  int logit_width_ = 0;
+  int logit_height_ = 0;
+  uint8_t sigmoid_[256];
+  std::vector<int8_t> tensor_;
+  std::vector<uint8_t> low_res_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_PERSON_SEGMENTER_H_
@@ -0,0 +1,318 @@
+#include "video/quality_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace vc {
+
+namespace {
+
+// SSIM stabilising constants for 8-bit samples, (0.01 * 255)^2 and
+// (0.03 * 255)^2.
+constexpr double kSsimC1 = 6.5025;
+constexpr double kSsimC2 = 58.5225;
+// GMSD stabilising constant for Prewitt gradients normalised by 3.
+constexpr double kGmsC = 170.0;
+// GMSD at which the perceptual score reaches 0; heavy blocking or a
+// different picture.
+constexpr double kGmsdAtZero = 0.25;
+
+// Sums over one 4x4 block of a and b.
+struct BlockSums {
+  int32_t a, b, aa, bb, ab;
+};
+
+// Sums for every whole 4x4 block in the four rows starting at a / b.
+void BlockRowSums(const uint8_t* a, int a_stride, const uint8_t* b,
+                  int b_stride, int blocks, BlockSums* out) {
+  int k = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi16(1);
+  for (; k + 2 <= blocks; k += 2) {
+    __m128i sa = zero, sb = zero, saa = zero, sbb = zero, sab = zero;
+    for (int r = 0; r < 4; ++r) {
+      __m128i va = _mm_unpacklo_epi8(
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + r * a_stride + 4 * k)), zero);
+      __m128i vb = _mm_unpacklo_epi8(
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + r * b_stride + 4 * k)), zero);
+      sa = _mm_add_epi16(sa, va);
+      sb = _mm_add_epi16(sb, vb);
+      saa = _mm_add_epi32(saa, _mm_madd_epi16(va, va));
+      sbb = _mm_add_epi32(sbb, _mm_madd_epi16(vb, vb));
+      sab = _mm_add_epi32(sab, _mm_madd_epi16(va, vb));
+    }
+    // Lanes 0-1 belong to the first block, 2-3 to the second.
+    alignas(16) int32_t lanes[5][4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[0]), _mm_madd_epi16(sa, ones));
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[1]), _mm_madd_epi16(sb, ones));
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[2]), saa);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[3]), sbb);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes[4]), sab);
+    for (int j = 0; j < 2; ++j) {
+      out[k + j] = {lanes[0][2 * j] + lanes[0][2 * j + 1],
+                    lanes[1][2 * j] + lanes[1][2 * j + 1],
+                    lanes[2][2 * j] + lanes[2][2 * j + 1],
+                    lanes[3][2 * j] + lanes[3][2 * j + 1],
+                    lanes[4][2 * j] + lanes[4][2 * j + 1]};
+    }
+  }
+#elif defined(__ARM_NEON)
+  for (; k + 2 <= blocks; k += 2) {
+    uint32x4_t sa = vdupq_n_u32(0), sb = sa, saa = sa, sbb = sa, sab = sa;
+    for (int r = 0; r < 4; ++r) {
+      uint8x8_t va = vld1_u8(a + r * a_stride + 4 * k);
+      uint8x8_t vb = vld1_u8(b + r * b_stride + 4 * k);
+      sa = vpadalq_u16(sa, vmovl_u8(va));
+      sb = vpadalq_u16(sb, vmovl_u8(vb));
+      saa = vpadalq_u16(saa, vmull_u8(va, va));
+      sbb = vpadalq_u16(sbb, vmull_u8(vb, vb));
+      sab = vpadalq_u16(sab, vmull_u8(va, vb));
+    }
+    uint32_t lanes[5][4];
+    vst1q_u32(lanes[0], sa);
+    vst1q_u32(lanes[1], sb);
+    vst1q_u32(lanes[2], saa);
+    vst1q_u32(lanes[3], sbb);
+    vst1q_u32(lanes[4], sab);
+    for (int j = 0; j < 2; ++j) {
+      out[k + j] = {static_cast<int32_t>(lanes[0][2 * j] + lanes[0][2 * j + 1]),
+                    static_cast<int32_t>(lanes[1][2 * j] + lanes[1][2 * j + 1]),
+                    static_cast<int32_t>(lanes[2][2 * j] + lanes[2][2 * j + 1]),
+                    static_cast<int32_t>(lanes[3][2 * j] + lanes[3][2 * j + 1]),
+                    static_cast<int32_t>(lanes[4][2 * j] + lanes[4][2 * j + 1])};
+    }
+  }
+#endif
+  for (; k < blocks; ++k) {
+    BlockSums s = {0, 0, 0, 0, 0};
+    for (int r = 0; r < 4; ++r) {
+      for (int i = 0; i < 4; ++i) {
+        int va = a[r * a_stride + 4 * k + i], vb = b[r * b_stride + 4 * k + i];
+        s.a += va;
+        s.b += vb;
+        s.aa += va * va;
+        s.bb += vb * vb;
+        s.ab += va * vb;
+      }
+    }
+    out[k] = s;
+  }
+}
+
+// Standard deviation of the gradient magnitude similarity map (Prewitt,
+// borders excluded).
+double Gmsd(const uint8_t* r, int r_stride, const uint8_t* d, int d_stride,
+            int width, int height) {
+  if (width < 3 || height < 3) return 0.0;
+  double sum = 0.0, sum_sq = 0.0;
+  thread_local std::vector<float> gms;
+  gms.resize(width);
+  auto gradient2 = [](const uint8_t* p, int stride, int x) {
+    const uint8_t* up = p - stride;
+    const uint8_t* down = p + stride;
+    float gx = ((up[x + 1] + p[x + 1] + down[x + 1]) - (up[x - 1] + p[x - 1] + down[x - 1])) / 3.0f;
+    float gy = ((down[x - 1] + down[x] + down[x + 1]) - (up[x - 1] + up[x] + up[x + 1])) / 3.0f;
+    return gx * gx + gy * gy;
+  };
+  for (int y = 1; y < height - 1; ++y) {
+    const uint8_t* rr = r + static_cast<size_t>(y) * r_stride;
+    const uint8_t* dr = d + static_cast<size_t>(y) * d_stride;
+    for (int x = 1; x < width - 1; ++x) {
+      float mr2 = gradient2(rr, r_stride, x);
+      float md2 = gradient2(dr, d_stride, x);
+      gms[x] = static_cast<float>((2.0f * std::sqrt(mr2 * md2) + kGmsC) /
+                                  (mr2 + md2 + kGmsC));
+    }
+    for (int x = 1; x < width - 1; ++x) {
+      sum += gms[x];
+      sum_sq += static_cast<double>(gms[x]) * gms[x];
+    }
+  }
+  const double n = static_cast<double>(width - 2) * (height - 2);
+  const double mean = sum / n;
+  return std::sqrt(std::max(0.0, sum_sq / n - mean * mean));
+}
+
+}  // namespace
+
+uint64_t PlaneSse(const uint8_t* a, int a_stride, const uint8_t* b,
+                  int b_stride, int width, int height) {
+  uint64_t total = 0;
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* ra = a + static_cast<size_t>(y) * a_stride;
+    const uint8_t* rb = b + static_cast<size_t>(y) * b_stride;
+    int x = 0;
+    // Per-row 32-bit lanes; a lane gains at most 2 * 255^2 per 8 pixels, so
+    // rows up to 8192 pixels cannot overflow.
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    for (; x + 16 <= width; x += 16) {
+      __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ra + x));
+      __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rb + x));
+      __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+      __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(lo, lo));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(hi, hi));
+    }
+    alignas(16) uint32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    total += static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__ARM_NEON)
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; x + 16 <= width; x += 16) {
+      uint8x16_t diff = vabdq_u8(vld1q_u8(ra + x), vld1q_u8(rb + x));
+      acc = vpadalq_u16(acc, vmull_u8(vget_low_u8(diff), vget_low_u8(diff)));
+      acc = vpadalq_u16(acc, vmull_u8(vget_high_u8(diff), vget_high_u8(diff)));
+    }
+    total += vgetq_lane_u32(acc, 0) + static_cast<uint64_t>(vgetq_lane_u32(acc, 1)) +
+             vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+    for (; x < width; ++x) {
+      int d = ra[x] - rb[x];
+      total += d * d;
+    }
+  }
+  return total;
+}
+
+double PsnrFromSse(uint64_t sse, uint64_t samples) {
+  if (sse == 0 || samples == 0) return kMaxPsnr;
+  const double mse = static_cast<double>(sse) / samples;
+  return std::min(kMaxPsnr, 10.0 * std::log10(255.0 * 255.0 / mse));
+}
+
+double PlaneSsim(const uint8_t* a, int a_stride, const uint8_t* b,
+                 int b_stride, int width, int height) {
+  const int blocks_wide = width / 4;
+  const int blocks_high = height / 4;
+  if (blocks_wide < 2 || blocks_high < 2) return 1.0;
+  thread_local std::vector<BlockSums> rows[2];
+  rows[0].resize(blocks_wide);
+  rows[1].resize(blocks_wide);
+  BlockRowSums(a, a_stride, b, b_stride, blocks_wide, rows[0].data());
+  double total = 0.0;
+  for (int by = 1; by < blocks_high; ++by) {
+    const std::vector<BlockSums>& above = rows[(by - 1) & 1];
+    std::vector<BlockSums>& current = rows[by & 1];
+    BlockRowSums(a + static_cast<size_t>(4 * by) * a_stride, a_stride,
+                 b + static_cast<size_t>(4 * by) * b_stride, b_stride, blocks_wide,
+                 current.data());
+    // Each 8x8 window is the 2x2 blocks whose top left is (bx, by - 1).
+    for (int bx = 0; bx + 1 < blocks_wide; ++bx) {
+      const BlockSums* q[4] = {&above[bx], &above[bx + 1], &current[bx], &current[bx + 1]};
+      double sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+      for (const BlockSums* s : q) {
+        sa += s->a;
+        sb += s->b;
+        saa += s->aa;
+        sbb += s->bb;
+        sab += s->ab;
+      }
+      const double ma = sa / 64, mb = sb / 64;
+      const double va = saa / 64 - ma * ma, vb = sbb / 64 - mb * mb;
+      const double cov = sab / 64 - ma * mb;
+      total += (2 * ma * mb + kSsimC1) * (2 * cov + kSsimC2) /
+               ((ma * ma + mb * mb + kSsimC1) * (va + vb + kSsimC2));
+    }
+  }
+  return total / (static_cast<double>(blocks_wide - 1) * (blocks_high - 1));
+}
+
+double PlanePerceptualScore(const uint8_t* reference, int reference_stride,
+                            const uint8_t* distorted, int distorted_stride,
+                            int width, int height) {
+  // GMSD is defined on a 2x average-downscaled image; a second, coarser
+  // scale catches blocking and low-frequency loss.
+  thread_local std::vector<uint8_t> scaled[2][2];
+  const uint8_t* planes[2] = {reference, distorted};
+  int strides[2] = {reference_stride, distorted_stride};
+  double gmsd = 0.0;
+  for (int scale = 0; scale < 2; ++scale) {
+    const int w = (width + 1) / 2, h = (height + 1) / 2;
+    for (int i = 0; i < 2; ++i) {
+      scaled[scale][i].resize(static_cast<size_t>(w) * h);
+      DownscalePlane2x(planes[i], strides[i], width, height, scaled[scale][i].data(), w);
+      planes[i] = scaled[scale][i].data();
+      strides[i] = w;
+    }
+    width = w;
+    height = h;
+    gmsd += 0.5 * Gmsd(planes[0], strides[0], planes[1], strides[1], width, height);
+  }
+  return 100.0 * std::clamp(1.0 - gmsd / kGmsdAtZero, 0.0, 1.0);
+}
+
+namespace {
+
+FrameQuality Measure(const I420Frame& reference, const I420Frame& distorted,
+                     uint64_t* total_sse, uint64_t* total_samples) {
+  FrameQuality q;
+  *total_sse = 0;
+  *total_samples = 0;
+  for (int p = 0; p < 3; ++p) {
+    const uint64_t sse =
+        PlaneSse(reference.plane(p), reference.stride(p), distorted.plane(p),
+                 distorted.stride(p), reference.plane_width(p),
+                 reference.plane_height(p));
+    const uint64_t samples = static_cast<uint64_t>(reference.plane_width(p)) *
+                             reference.plane_height(p);
+    *total_sse += sse;
+    *total_samples += samples;
+    (p == 0 ? q.psnr_y : p == 1 ? q.psnr_u : q.psnr_v) = PsnrFromSse(sse, samples);
+  }
+  q.psnr = PsnrFromSse(*total_sse, *total_samples);
+  q.ssim = PlaneSsim(reference.y(), reference.stride_y(), distorted.y(),
+                     distorted.stride_y(), reference.width(), reference.height());
+  q.perceptual = PlanePerceptualScore(reference.y(), reference.stride_y(),
+                                      distorted.y(), distorted.stride_y(),
+                                      reference.width(), reference.height());
+  return q;
+}
+
+}  // namespace
+
+FrameQuality MeasureFrameQuality(const I420Frame& reference,
+                                 const I420Frame& distorted) {
+  uint64_t sse, samples;
+  return Measure(reference, distorted, &sse, &samples);
+}
+
+void QualityAccumulator::Add(const I420Frame& reference,
+                             const I420Frame& distorted) {
+  uint64_t sse, samples;
+  const FrameQuality q = Measure(reference, distorted, &sse, &samples);
+  ++frames_;
+  psnr_sum_ += q.psnr;
+  ssim_sum_ += q.ssim;
+  perceptual_sum_ += q.perceptual;
+  min_perceptual_ = std::min(min_perceptual_, q.perceptual);
+  sse_ += sse;
+  samples_ += samples;
+}
+
+double QualityAccumulator::mean_psnr() const {
+  return frames_ ? psnr_sum_ / frames_ : 0.0;
+}
+
+double QualityAccumulator::pooled_psnr() const {
+  return PsnrFromSse(sse_, samples_);
+}
+
+double QualityAccumulator::mean_ssim() const {
+  return frames_ ? ssim_sum_ / frames_ : 0.0;
+}
+
+double QualityAccumulator::mean_perceptual() const {
+  return frames_ ? perceptual_sum_ / frames_ : 0.0;
+}
+
+}  // namespace vc
@@ -0,0 +1,75 @@
+#ifndef VCMEDIA_VIDEO_QUALITY_METRICS_H_
+#define VCMEDIA_VIDEO_QUALITY_METRICS_H_
+
+#include <cstdint>
+
+#include "video/i420_frame.h"
+
+namespace vc {
+
+// Full-reference quality metrics on I420 frames, for benchmarks and
+// regression gates on the media pipeline:
+//   - PSNR per plane and combined over all samples (so luma weighs four
+//     times each chroma plane),
+//   - SSIM on luma over 8x8 windows on a 4-pixel grid (the libvpx / x264
+//     variant),
+//   - a lightweight perceptual score from the gradient magnitude similarity
+//     deviation (GMSD) at half and quarter resolution, mapped to 0..100.
+//     It tracks blur, ringing and blocking much closer to viewers than
+//     PSNR does at a fraction of VMAF's cost; it is not calibrated against
+//     VMAF, so compare scores for the same content only.
+// The sum-of-squares and SSIM window sums use SSE2 / NEON.
+struct FrameQuality {
+  double psnr_y = 0.0;
+  double psnr_u = 0.0;
+  double psnr_v = 0.0;
+  double psnr = 0.0;
+  double ssim = 0.0;
+  double perceptual = 0.0;
+};
+
+// Returned for identical planes.
+constexpr double kMaxPsnr = 99.0;
+
+// Sum of squared differences between two planes.
+uint64_t PlaneSse(const uint8_t* a, int a_stride, const uint8_t* b,
+                  int b_stride, int width, int height);
+double PsnrFromSse(uint64_t sse, uint64_t samples);
+double PlaneSsim(const uint8_t* a, int a_stride, const uint8_t* b,
+                 int b_stride, int width, int height);
+double PlanePerceptualScore(const uint8_t* reference, int reference_stride,
+                            const uint8_t* distorted, int distorted_stride,
+                            int width, int height);
+
+// All metrics for one frame; both frames must have the same size.
+FrameQuality MeasureFrameQuality(const I420Frame& reference,
+                                 const I420Frame& distorted);
+
+// Aggregates per-frame results over a sequence. PSNR is reported both as
+// the mean of per-frame values and from the pooled squared error, which
+// weighs bad frames more; the worst frame's perceptual score is kept
+// because a short burst of artefacts is what viewers notice.
+class QualityAccumulator {
+ public:
+  void Add(const I420Frame& reference, const I420Frame& distorted);
+
+  int frames() const { return frames_; }
+  double mean_psnr() const;
+  double pooled_psnr() const;
+  double mean_ssim() const;
+  double mean_perceptual() const;
+  double min_perceptual() const { return min_perceptual_; }
+
+ private:
+  int frames_ = 0;
+  double psnr_sum_ = 0.0;
+  double ssim_sum_ = 0.0;
+  double perceptual_sum_ = 0.0;
+  double min_perceptual_ = 100.0;
+  uint64_t sse_ = 0;
+  uint64_t samples_ = 0;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_QUALITY_METRICS_H_
@@ -0,0 +1,29 @@
+#include "video/render_target.h"
+
+#include <cstddef>
+
+namespace vc {
+
+MemoryRenderTarget::MemoryRenderTarget(int width, int height)
+    : pixels_(static_cast<size_t>(width) * height * 4) {
+  buffer_.pixels = pixels_.data();
+  buffer_.width = width;
+  buffer_.height = height;
+  buffer_.stride = width * 4;
+}
+
+bool MemoryRenderTarget::Lock(RgbaBuffer* buffer) {
+  if (locked_) return false;
+  locked_ = true;
+  *buffer = buffer_;
+  return true;
+}
+
+bool MemoryRenderTarget::Post() {
+  if (!locked_) return false;
+  locked_ = false;
+  ++posted_frames_;
+  return true;
+}
+
+}  // namespace vc
@@ -0,0 +1,50 @@
+#ifndef VCMEDIA_VIDEO_RENDER_TARGET_H_
+#define VCMEDIA_VIDEO_RENDER_TARGET_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace vc {
+
+// An RGBA8888 buffer being drawn into; `stride` is in bytes.
+struct RgbaBuffer {
+  uint8_t* pixels = nullptr;
+  int width = 0;
+  int height = 0;
+  int stride = 0;
+};
+
+// Where composed video frames go: a window surface on devices, memory on a
+// host. Lock() hands out the next buffer to draw into and Post() presents
+// it; the contents of a freshly locked buffer are unspecified.
+class RenderTarget {
+ public:
+  virtual ~RenderTarget() = default;
+
+  virtual bool Lock(RgbaBuffer* buffer) = 0;
+  virtual bool Post() = 0;
+  virtual const char* implementation_name() const = 0;
+};
+
+// Host mode: a single buffer in memory, kept after Post() for inspection.
+class MemoryRenderTarget : public RenderTarget {
+ public:
+  MemoryRenderTarget(int width, int height);
+
+  bool Lock(RgbaBuffer* buffer) override;
+  bool Post() override;
+  const char* implementation_name() const override { return "memory"; }
+
+  const RgbaBuffer& buffer() const { return buffer_; }
+  int posted_frames() const { return posted_frames_; }
+
+ private:
+  std::vector<uint8_t> pixels_;
+  RgbaBuffer buffer_;
+  bool locked_ = false;
+  int posted_frames_ = 0;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_RENDER_TARGET_H_
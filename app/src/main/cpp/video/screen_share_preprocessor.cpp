@@ -0,0 +1,216 @@
+#include "video/screen_share_preprocessor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "video/block_sad.h"
+
+namespace vc {
+
+namespace {
+
+constexpr int kBlock = 16;
+// Text detection looks at no more than this many dirty blocks per frame.
+constexpr int kMaxSharpnessSamples = 256;
+
+}  // namespace
+
+bool IsSharpSyntheticBlock(const uint8_t* luma, int stride, int width,
+                           int height) {
+  int flat = 0, edges = 0, pairs = 0;
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* row = luma + static_cast<size_t>(y) * stride;
+    for (int x = 0; x + 1 < width; ++x) {
+      int d = std::abs(row[x + 1] - row[x]);
+      flat += d == 0;
+      edges += d >= 48;
+    }
+    pairs += width - 1;
+  }
+  return flat * 2 >= pairs && edges >= 4;
+}
+
+ScreenSharePreprocessor::ScreenSharePreprocessor(const Config& config)
+    : config_(config) {}
+
+void ScreenSharePreprocessor::Analyze(const I420Frame& frame,
+                                      ScreenFrameDecision* d) {
+  const int w = frame.width();
+  const int h = frame.height();
+  d->blocks_wide = (w + kBlock - 1) / kBlock;
+  d->blocks_high = (h + kBlock - 1) / kBlock;
+  d->total_blocks = d->blocks_wide * d->blocks_high;
+  d->block_map.assign(d->total_blocks, 0);
+  d->dirty_rects.clear();
+  d->dirty_blocks = 0;
+  d->dirty_sad = 0;
+  d->encode = false;
+  d->full_frame = !have_reference_ || reference_.width() != w ||
+                  reference_.height() != h;
+
+  if (d->full_frame) {
+    std::fill(d->block_map.begin(), d->block_map.end(), 1);
+    d->dirty_blocks = d->total_blocks;
+  } else {
+    const uint32_t chroma_threshold = config_.sad_threshold / 4;
+    for (int by = 0; by < d->blocks_high; ++by) {
+      const int y0 = by * kBlock;
+      const int bh = std::min(kBlock, h - y0);
+      for (int bx = 0; bx < d->blocks_wide; ++bx) {
+        const int x0 = bx * kBlock;
+        const int bw = std::min(kBlock, w - x0);
+        const uint8_t* cur = frame.y() + static_cast<size_t>(y0) * w + x0;
+        const uint8_t* ref = reference_.y() + static_cast<size_t>(y0) * w + x0;
+        uint32_t sad = bw == kBlock && bh == kBlock
+                           ? Sad16x16(cur, w, ref, w)
+                           : SadBlock(cur, w, ref, w, bw, bh);
+        bool dirty = sad > config_.sad_threshold;
+        if (!dirty) {
+          // Colour-only changes (e.g. a highlight at equal luma).
+          const int cs = frame.stride_uv();
+          const size_t offset = static_cast<size_t>(y0 / 2) * cs + x0 / 2;
+          const int cw = (bw + 1) / 2;
+          const int ch = (bh + 1) / 2;
+          for (int p = 1; p < 3 && !dirty; ++p) {
+            const uint8_t* c = frame.plane(p) + offset;
+            const uint8_t* r = reference_.plane(p) + offset;
+            uint32_t csad = cw == 8 && ch == 8 ? Sad8x8(c, cs, r, cs)
+                                               : SadBlock(c, cs, r, cs, cw, ch);
+            dirty = csad > chroma_threshold;
+          }
+        }
+        if (dirty) {
+          d->block_map[by * d->blocks_wide + bx] = 1;
+          ++d->dirty_blocks;
+          d->dirty_sad += sad;
+        }
+      }
+    }
+    if (d->dirty_blocks == 0) {
+      d->mode = mode_;
+      return;
+    }
+  }
+
+  // Content classification over (a sample of) the changed blocks. Small
+  // updates such as a cursor or a caret barely move the score.
+  const int step = std::max(1, d->dirty_blocks / kMaxSharpnessSamples);
+  int seen = 0, sampled = 0, sharp = 0;
+  for (int i = 0; i < d->total_blocks; ++i) {
+    if (!d->block_map[i] || seen++ % step != 0) continue;
+    const int x0 = (i % d->blocks_wide) * kBlock;
+    const int y0 = (i / d->blocks_wide) * kBlock;
+    ++sampled;
+    sharp += IsSharpSyntheticBlock(frame.y() + static_cast<size_t>(y0) * w + x0,
+                                   w, std::min(kBlock, w - x0),
+                                   std::min(kBlock, h - y0));
+  }
+  const float share = static_cast<float>(sharp) / sampled;
+  if (!have_text_score_) {
+    text_score_ = share;
+    have_text_score_ = true;
+  } else {
+    float alpha = 0.5f * std::min(1.0f, d->dirty_blocks / 64.0f);
+    text_score_ += alpha * (share - text_score_);
+  }
+  if (mode_ == ScreenContentMode::kMotion && text_score_ > config_.text_enter) {
+    mode_ = ScreenContentMode::kText;
+  } else if (mode_ == ScreenContentMode::kText &&
+             text_score_ < config_.text_leave) {
+    mode_ = ScreenContentMode::kMotion;
+  }
+  d->mode = mode_;
+
+  if (!d->full_frame && mode_ == ScreenContentMode::kText &&
+      config_.text_max_fps > 0 &&
+      frame.timestamp_us - last_encoded_us_ < 1000000 / config_.text_max_fps) {
+    // Deferred: the reference is untouched, so these changes are reported
+    // again with the next encoded frame.
+    return;
+  }
+
+  d->encode = true;
+  last_encoded_us_ = frame.timestamp_us;
+  MergeRects(w, h, d);
+  CommitBlocks(frame, *d);
+}
+
+void ScreenSharePreprocessor::MergeRects(int width, int height,
+                                         ScreenFrameDecision* d) const {
+  // Rectangles are built in block units: each horizontal run of dirty blocks
+  // extends a rectangle from the row above with the same columns, or starts
+  // a new one.
+  std::vector<DirtyRect>& rects = d->dirty_rects;
+  bool overflow = false;
+  for (int by = 0; by < d->blocks_high && !overflow; ++by) {
+    const uint8_t* row = d->block_map.data() + by * d->blocks_wide;
+    for (int bx = 0; bx < d->blocks_wide;) {
+      if (!row[bx]) {
+        ++bx;
+        continue;
+      }
+      int end = bx;
+      while (end < d->blocks_wide && row[end]) ++end;
+      auto it = std::find_if(rects.begin(), rects.end(), [&](const DirtyRect& r) {
+        return r.x == bx && r.width == end - bx && r.y + r.height == by;
+      });
+      if (it != rects.end()) {
+        ++it->height;
+      } else if (static_cast<int>(rects.size()) < config_.max_rects) {
+        rects.push_back({bx, by, end - bx, 1});
+      } else {
+        overflow = true;
+        break;
+      }
+      bx = end;
+    }
+  }
+  if (overflow) {
+    int x0 = d->blocks_wide, y0 = d->blocks_high, x1 = 0, y1 = 0;
+    for (int i = 0; i < d->total_blocks; ++i) {
+      if (!d->block_map[i]) continue;
+      int bx = i % d->blocks_wide, by = i / d->blocks_wide;
+      x0 = std::min(x0, bx);
+      y0 = std::min(y0, by);
+      x1 = std::max(x1, bx + 1);
+      y1 = std::max(y1, by + 1);
+    }
+    rects.assign(1, DirtyRect{x0, y0, x1 - x0, y1 - y0});
+  }
+  for (DirtyRect& r : rects) {
+    r.x *= kBlock;
+    r.y *= kBlock;
+    r.width = std::min(r.width * kBlock, width - r.x);
+    r.height = std::min(r.height * kBlock, height - r.y);
+  }
+}
+
+void ScreenSharePreprocessor::CommitBlocks(const I420Frame& frame,
+                                           const ScreenFrameDecision& d) {
+  if (d.full_frame) {
+    reference_.Allocate(frame.width(), frame.height());
+    std::memcpy(reference_.y(), frame.y(), frame.size_bytes());
+    have_reference_ = true;
+    return;
+  }
+  for (int i = 0; i < d.total_blocks; ++i) {
+    if (!d.block_map[i]) continue;
+    const int x0 = (i % d.blocks_wide) * kBlock;
+    const int y0 = (i / d.blocks_wide) * kBlock;
+    for (int p = 0; p < 3; ++p) {
+      const int shift = p == 0 ? 0 : 1;
+      const int px = x0 >> shift;
+      const int py = y0 >> shift;
+      const int bw = std::min(kBlock >> shift, frame.plane_width(p) - px);
+      const int bh = std::min(kBlock >> shift, frame.plane_height(p) - py);
+      const int stride = frame.stride(p);
+      for (int y = 0; y < bh; ++y) {
+        size_t offset = static_cast<size_t>(py + y) * stride + px;
+        std::memcpy(reference_.plane(p) + offset, frame.plane(p) + offset, bw);
+      }
+    }
+  }
+}
+
+}  // namespace vc
@@ -0,0 +1,97 @@
+#ifndef VCMEDIA_VIDEO_SCREEN_SHARE_PREPROCESSOR_H_
+#define VCMEDIA_VIDEO_SCREEN_SHARE_PREPROCESSOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "video/i420_frame.h"
+
+namespace vc {
+
+struct DirtyRect {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+};
+
+enum class ScreenContentMode {
+  // Video, animation or photos: favour frame rate.
+  kMotion,
+  // Text, UI and slides: favour sharpness. The encoder should use a lower QP
+  // and may run at a reduced frame rate (capped here by text_max_fps).
+  kText,
+};
+
+struct ScreenFrameDecision {
+  // False when nothing changed since the last encoded frame, or when the
+  // frame was deferred by the text mode frame-rate cap. Changes are then
+  // carried over to the next encoded frame.
+  bool encode = false;
+  // First frame, or the capture size changed.
+  bool full_frame = false;
+  ScreenContentMode mode = ScreenContentMode::kMotion;
+  int dirty_blocks = 0;
+  int total_blocks = 0;
+  // Luma SAD summed over dirty blocks, a rough measure of coding cost.
+  uint64_t dirty_sad = 0;
+  // Block-aligned regions to encode, merged from dirty 16x16 blocks.
+  std::vector<DirtyRect> dirty_rects;
+  // One entry per block, row major, set for dirty blocks.
+  std::vector<uint8_t> block_map;
+  int blocks_wide = 0;
+  int blocks_high = 0;
+};
+
+// Screen capture front end ahead of the encoder. Each frame is compared with
+// the last encoded one in 16x16 luma (and 8x8 chroma) blocks using SIMD SAD.
+// Unchanged frames are skipped, changed blocks are merged into dirty
+// rectangles, and sharp synthetic content (text, UI) switches the stream to
+// a text mode with hysteresis.
+class ScreenSharePreprocessor {
+ public:
+  struct Config {
+    // A block is dirty when its luma SAD exceeds this. Captured desktops are
+    // noise free, so any change counts by default.
+    uint32_t sad_threshold = 0;
+    // Beyond this many rectangles the dirty region collapses to their
+    // bounding box; per-rectangle overhead would outweigh the savings.
+    int max_rects = 32;
+    // Frame-rate cap in text mode. 0 disables it.
+    int text_max_fps = 10;
+    // Share of sharp dirty blocks (smoothed) to enter / leave text mode.
+    float text_enter = 0.5f;
+    float text_leave = 0.3f;
+  };
+
+  ScreenSharePreprocessor() : ScreenSharePreprocessor(Config()) {}
+  explicit ScreenSharePreprocessor(const Config& config);
+
+  // `frame.timestamp_us` is used for the text mode frame-rate cap. The
+  // decision is overwritten; its vectors keep their capacity between calls.
+  void Analyze(const I420Frame& frame, ScreenFrameDecision* decision);
+
+  ScreenContentMode mode() const { return mode_; }
+
+ private:
+  void MergeRects(int width, int height, ScreenFrameDecision* d) const;
+  void CommitBlocks(const I420Frame& frame, const ScreenFrameDecision& d);
+
+  const Config config_;
+  I420Frame reference_;
+  bool have_reference_ = false;
+  int64_t last_encoded_us_ = 0;
+  float text_score_ = 0.0f;
+  bool have_text_score_ = false;
+  ScreenContentMode mode_ = ScreenContentMode::kMotion;
+};
+
+// True for blocks that look like rendered text or UI: mostly exactly flat
+// neighbouring pixels plus a few hard edges. Camera and video content has
+// noise and soft gradients and so rarely has either.
+bool IsSharpSyntheticBlock(const uint8_t* luma, int stride, int width,
+                           int height);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_SCREEN_SHARE_PREPROCESSOR_H_
@@ -0,0 +1,652 @@
+#include "video/software_video_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "video/bit_stream.h"
+#include "video/block_sad.h"
+
+namespace vc {
+
+namespace {
+
+constexpr int kMb = 16;
+constexpr int kHeaderSize = 8;
+constexpr int kMinQp = 2;
+constexpr int kMaxQp = 50;
+constexpr int kSearchRange = 32;
+constexpr int kMaxLevel = 2047;
+// Largest frame the decoder accepts; the header allows 65535 x 65535, which
+// one hostile packet could use to allocate gigabytes.
+constexpr int kMaxDecodeDimension = 4096;
+constexpr int kMaxDecodePixels = 4096 * 2304;
+// Intra has to beat inter by this much luma SAD; intra blocks cost more bits
+// at equal distortion because their residual is larger.
+constexpr int kIntraBias = 512;
+
+// Orthonormal DCT-II basis scaled by 4096: kIdct[k][n] for frequency k and
+// sample n. Hard coded so every build reconstructs identically.
+constexpr int32_t kIdct[8][8] = {
+    {1448, 1448, 1448, 1448, 1448, 1448, 1448, 1448},
+    {2009, 1703, 1138, 400, -400, -1138, -1703, -2009},
+    {1892, 784, -784, -1892, -1892, -784, 784, 1892},
+    {1703, -400, -2009, -1138, 1138, 2009, 400, -1703},
+    {1448, -1448, -1448, 1448, 1448, -1448, -1448, 1448},
+    {1138, -2009, 400, 1703, -1703, -400, 2009, -1138},
+    {784, -1892, 1892, -784, -784, 1892, -1892, 784},
+    {400, -1138, 1703, -2009, 2009, -1703, 1138, -400},
+};
+
+// Quantiser step in 1/8 units: 0.625 * 2^(qp / 6), doubling every 6 QP.
+constexpr int kStep8[52] = {
+    5,   6,   6,   7,   8,   9,   10,  11,  13,  14,  16,  18,  20,
+    22,  25,  28,  32,  36,  40,  45,  50,  57,  63,  71,  80,  90,
+    101, 113, 127, 143, 160, 180, 202, 226, 254, 285, 320, 359, 403,
+    453, 508, 570, 640, 718, 806, 905, 1016, 1140, 1280, 1437, 1613, 1810,
+};
+
+constexpr uint8_t kZigzag[64] = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+int AlignMb(int v) { return (v + kMb - 1) / kMb * kMb; }
+
+const double (&ForwardBasis())[8][8] {
+  static double basis[8][8];
+  static bool init = [] {
+    const double pi = 3.14159265358979323846;
+    for (int k = 0; k < 8; ++k) {
+      double c = k == 0 ? std::sqrt(1.0 / 8) : std::sqrt(2.0 / 8);
+      for (int n = 0; n < 8; ++n) basis[k][n] = c * std::cos((2 * n + 1) * k * pi / 16);
+    }
+    return true;
+  }();
+  (void)init;
+  return basis;
+}
+
+// Block `b` of a macroblock: 0-3 are the luma quadrants, 4 is U, 5 is V.
+struct BlockPos {
+  int plane;
+  int x;
+  int y;
+};
+
+BlockPos BlockAt(int b, int mbx, int mby) {
+  if (b < 4) return {0, mbx * kMb + (b & 1) * 8, mby * kMb + (b >> 1) * 8};
+  return {b - 3, mbx * 8, mby * 8};
+}
+
+// Mean of the reconstructed row above and column left of a size x size
+// area, or mid grey at the frame corner.
+int DcPrediction(const I420Frame& recon, int plane, int x, int y, int size) {
+  const uint8_t* p = recon.plane(plane);
+  const int stride = recon.stride(plane);
+  int sum = 0, count = 0;
+  if (y > 0) {
+    const uint8_t* row = p + static_cast<size_t>(y - 1) * stride + x;
+    for (int i = 0; i < size; ++i) sum += row[i];
+    count += size;
+  }
+  if (x > 0) {
+    for (int i = 0; i < size; ++i) sum += p[static_cast<size_t>(y + i) * stride + x - 1];
+    count += size;
+  }
+  return count ? (sum + count / 2) / count : 128;
+}
+
+// Quantised zigzag levels of the DCT of src - pred. Returns the number of
+// non-zero levels.
+int Quantize(const uint8_t* src, int src_stride, const uint8_t* pred,
+             int pred_stride, int step8, bool intra, int16_t* levels) {
+  const double (&f)[8][8] = ForwardBasis();
+  double r[8][8], t[8][8];
+  for (int m = 0; m < 8; ++m) {
+    for (int n = 0; n < 8; ++n) {
+      r[m][n] = src[m * src_stride + n] - pred[m * pred_stride + n];
+    }
+  }
+  for (int m = 0; m < 8; ++m) {
+    for (int k = 0; k < 8; ++k) {
+      double s = 0.0;
+      for (int n = 0; n < 8; ++n) s += r[m][n] * f[k][n];
+      t[m][k] = s;
+    }
+  }
+  const double inv_step = 8.0 / step8;
+  // Inter residuals are mostly noise; a wider dead zone drops it.
+  const double rounding = intra ? 1.0 / 3 : 1.0 / 6;
+  int nonzero = 0;
+  for (int i = 0; i < 64; ++i) {
+    const int j = kZigzag[i] >> 3;
+    const int k = kZigzag[i] & 7;
+    double c = 0.0;
+    for (int m = 0; m < 8; ++m) c += f[j][m] * t[m][k];
+    int level = static_cast<int>(std::fabs(c) * inv_step + rounding);
+    level = std::min(level, kMaxLevel);
+    levels[i] = static_cast<int16_t>(c < 0 ? -level : level);
+    nonzero += level != 0;
+  }
+  return nonzero;
+}
+
+// dst = clip(pred + inverse DCT of the dequantised levels). Integer only.
+void Reconstruct(const int16_t* levels, int step8, const uint8_t* pred,
+                 int pred_stride, uint8_t* dst, int dst_stride) {
+  int32_t d[8][8] = {};
+  bool any = false;
+  for (int i = 0; i < 64; ++i) {
+    if (!levels[i]) continue;
+    any = true;
+    d[kZigzag[i] >> 3][kZigzag[i] & 7] =
+        std::clamp(levels[i] * step8, -32767, 32767);
+  }
+  if (!any) {
+    for (int m = 0; m < 8; ++m) {
+      std::memcpy(dst + m * dst_stride, pred + m * pred_stride, 8);
+    }
+    return;
+  }
+  int64_t t[8][8];
+  for (int j = 0; j < 8; ++j) {
+    for (int n = 0; n < 8; ++n) {
+      int64_t s = 0;
+      for (int k = 0; k < 8; ++k) s += int64_t{d[j][k]} * kIdct[k][n];
+      t[j][n] = (s + 2048) >> 12;
+    }
+  }
+  for (int m = 0; m < 8; ++m) {
+    for (int n = 0; n < 8; ++n) {
+      int64_t s = 0;
+      for (int j = 0; j < 8; ++j) s += kIdct[j][m] * t[j][n];
+      // Coefficients carry a factor of 8 from the step table.
+      int residual = static_cast<int>((((s + 2048) >> 12) + 4) >> 3);
+      dst[m * dst_stride + n] = static_cast<uint8_t>(
+          std::clamp(pred[m * pred_stride + n] + residual, 0, 255));
+    }
+  }
+}
+
+void WriteBlock(BitWriter* bw, const int16_t* levels, int nonzero) {
+  bw->WriteUe(nonzero - 1);
+  int run = 0;
+  for (int i = 0; i < 64; ++i) {
+    if (!levels[i]) {
+      ++run;
+      continue;
+    }
+    bw->WriteUe(run);
+    bw->WriteSe(levels[i]);
+    run = 0;
+  }
+}
+
+bool ReadBlock(BitReader* br, int16_t* levels) {
+  std::fill(levels, levels + 64, 0);
+  const uint32_t count = br->ReadUe() + 1;
+  if (count > 64) return false;
+  int pos = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    // Runs are up to 2^32 - 2; compare before adding so `pos` cannot wrap.
+    const uint32_t run = br->ReadUe();
+    if (run >= static_cast<uint32_t>(64 - pos)) return false;
+    pos += static_cast<int>(run);
+    int level = br->ReadSe();
+    if (level == 0 || std::abs(level) > kMaxLevel) return false;
+    levels[pos++] = static_cast<int16_t>(level);
+  }
+  return !br->overrun();
+}
+
+// Copies `src` into the macroblock-aligned `dst`, replicating the right and
+// bottom edges.
+void PadFrame(const I420Frame& src, I420Frame* dst) {
+  for (int p = 0; p < 3; ++p) {
+    const int w = src.plane_width(p);
+    const int h = src.plane_height(p);
+    const int pw = dst->plane_width(p);
+    for (int y = 0; y < dst->plane_height(p); ++y) {
+      const uint8_t* s = src.plane(p) + static_cast<size_t>(std::min(y, h - 1)) * src.stride(p);
+      uint8_t* d = dst->plane(p) + static_cast<size_t>(y) * dst->stride(p);
+      std::memcpy(d, s, w);
+      std::memset(d + w, s[w - 1], pw - w);
+    }
+  }
+}
+
+void CropFrame(const I420Frame& padded, int width, int height, I420Frame* out) {
+  out->Allocate(width, height);
+  for (int p = 0; p < 3; ++p) {
+    for (int y = 0; y < out->plane_height(p); ++y) {
+      std::memcpy(out->plane(p) + static_cast<size_t>(y) * out->stride(p),
+                  padded.plane(p) + static_cast<size_t>(y) * padded.stride(p),
+                  out->plane_width(p));
+    }
+  }
+}
+
+int Median(int a, int b, int c) {
+  return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+// Median of the left, top and top-right neighbours' motion, as in H.264.
+void PredictMv(const int16_t* mv, int mbs_wide, int mbx, int mby, int* px,
+               int* py) {
+  auto at = [&](int x, int y, int c) {
+    return x < 0 || y < 0 || x >= mbs_wide ? 0 : mv[(y * mbs_wide + x) * 2 + c];
+  };
+  *px = Median(at(mbx - 1, mby, 0), at(mbx, mby - 1, 0), at(mbx + 1, mby - 1, 0));
+  *py = Median(at(mbx - 1, mby, 1), at(mbx, mby - 1, 1), at(mbx + 1, mby - 1, 1));
+}
+
+// Pointer to the motion compensated prediction of block `b`.
+const uint8_t* InterPred(const I420Frame& ref, const BlockPos& pos, int mvx,
+                         int mvy) {
+  if (pos.plane == 0) {
+    return ref.y() + static_cast<size_t>(pos.y + mvy) * ref.stride_y() + pos.x + mvx;
+  }
+  return ref.plane(pos.plane) +
+         static_cast<size_t>(pos.y + (mvy >> 1)) * ref.stride_uv() + pos.x + (mvx >> 1);
+}
+
+struct MacroblockCoder {
+  const I420Frame* ref;
+  I420Frame* recon;
+  int16_t* mv;
+  int mbs_wide;
+  int mbs_high;
+  // Frame QP, and the QP of the last macroblock that carried a delta.
+  int qp;
+  int last_qp;
+  // Whether coded macroblocks carry a QP delta (header flag bit 1).
+  bool qp_deltas;
+  // Encoder only: per-macroblock offsets from the frame QP, or nullptr.
+  const int8_t* qp_offsets;
+};
+
+// Writes the intra prediction of every block of a macroblock into `pred`
+// (six 8x8 blocks, stride 8).
+void IntraPredict(const MacroblockCoder& c, int mbx, int mby, uint8_t pred[6][64]) {
+  const int dc[3] = {
+      DcPrediction(*c.recon, 0, mbx * kMb, mby * kMb, kMb),
+      DcPrediction(*c.recon, 1, mbx * 8, mby * 8, 8),
+      DcPrediction(*c.recon, 2, mbx * 8, mby * 8, 8),
+  };
+  for (int b = 0; b < 6; ++b) {
+    std::memset(pred[b], dc[b < 4 ? 0 : b - 3], 64);
+  }
+}
+
+uint32_t LumaSad(const I420Frame& cur, const I420Frame& ref, int x, int y,
+                 int mvx, int mvy) {
+  const int s = cur.stride_y();
+  return Sad16x16(cur.y() + static_cast<size_t>(y) * s + x, s,
+                  ref.y() + static_cast<size_t>(y + mvy) * s + x + mvx, s);
+}
+
+// Length of the Exp-Golomb code for se(v).
+int SeBits(int v) {
+  const uint32_t code = v > 0 ? 2 * v - 1 : -2 * v;
+  int n = 0;
+  while ((code + 1) >> (n + 1)) ++n;
+  return 2 * n + 1;
+}
+
+// Weight of one motion vector bit against luma SAD, after the usual
+// H.264 reference encoder choice of sqrt(0.85 * 2^((qp - 12) / 3)).
+uint32_t MotionLambda(int qp) {
+  return static_cast<uint32_t>(std::lround(std::sqrt(0.85 * std::pow(2.0, (qp - 12) / 3.0))));
+}
+
+// Integer-pel small diamond search seeded with the zero and predicted
+// vectors. Candidates are ranked by SAD plus the rate of coding the vector,
+// so noise does not pull blocks off the zero vector (and out of skip).
+// Returns the SAD of the chosen vector.
+uint32_t MotionSearch(const I420Frame& cur, const I420Frame& ref, int x,
+                      int y, int pred_x, int pred_y, uint32_t lambda, int* best_x,
+                      int* best_y) {
+  const int min_x = std::max(-kSearchRange, -x);
+  const int max_x = std::min(kSearchRange, ref.width() - kMb - x);
+  const int min_y = std::max(-kSearchRange, -y);
+  const int max_y = std::min(kSearchRange, ref.height() - kMb - y);
+  auto rate = [&](int mx, int my) {
+    // The zero vector may become a one-bit skip.
+    return mx == 0 && my == 0 ? lambda
+                              : lambda * (1 + SeBits(mx - pred_x) + SeBits(my - pred_y));
+  };
+  *best_x = 0;
+  *best_y = 0;
+  uint32_t best_sad = LumaSad(cur, ref, x, y, 0, 0);
+  if (best_sad < 64) return best_sad;
+  uint32_t best = best_sad + rate(0, 0);
+  auto consider = [&](int mx, int my) {
+    const uint32_t sad = LumaSad(cur, ref, x, y, mx, my);
+    const uint32_t cost = sad + rate(mx, my);
+    if (cost < best) {
+      best = cost;
+      best_sad = sad;
+      *best_x = mx;
+      *best_y = my;
+    }
+  };
+  const int seed_x = std::clamp(pred_x, min_x, max_x);
+  const int seed_y = std::clamp(pred_y, min_y, max_y);
+  if (seed_x || seed_y) consider(seed_x, seed_y);
+  static const int kDiamond[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+  for (int iter = 0; iter < 2 * kSearchRange; ++iter) {
+    const int cx = *best_x, cy = *best_y;
+    for (const auto& d : kDiamond) {
+      const int mx = cx + d[0], my = cy + d[1];
+      if (mx < min_x || mx > max_x || my < min_y || my > max_y) continue;
+      consider(mx, my);
+    }
+    if (*best_x == cx && *best_y == cy) break;
+  }
+  return best_sad;
+}
+
+void EncodeMacroblock(MacroblockCoder& c, const I420Frame& cur, int mbx,
+                      int mby, bool keyframe, BitWriter* bw) {
+  const int mb_qp =
+      c.qp_offsets ? std::clamp(c.qp + c.qp_offsets[mby * c.mbs_wide + mbx], kMinQp, kMaxQp)
+                   : c.qp;
+  const int step8 = kStep8[mb_qp];
+  int16_t levels[6][64];
+  int nonzero[6];
+  int16_t* mv = c.mv + (mby * c.mbs_wide + mbx) * 2;
+  mv[0] = mv[1] = 0;
+
+  bool intra = keyframe;
+  int mvx = 0, mvy = 0, pmx = 0, pmy = 0;
+  uint8_t intra_pred[6][64];
+  IntraPredict(c, mbx, mby, intra_pred);
+  if (!keyframe) {
+    PredictMv(c.mv, c.mbs_wide, mbx, mby, &pmx, &pmy);
+    uint32_t inter_sad = MotionSearch(cur, *c.ref, mbx * kMb, mby * kMb, pmx,
+                                      pmy, MotionLambda(mb_qp), &mvx, &mvy);
+    uint32_t intra_sad = 0;
+    for (int y = 0; y < kMb; ++y) {
+      const uint8_t* row = cur.y() + static_cast<size_t>(mby * kMb + y) * cur.stride_y() + mbx * kMb;
+      for (int x = 0; x < kMb; ++x) intra_sad += std::abs(row[x] - intra_pred[0][0]);
+    }
+    intra = intra_sad + kIntraBias < inter_sad;
+  }
+
+  const uint8_t* pred[6];
+  int pred_stride[6];
+  int cbp = 0;
+  for (int b = 0; b < 6; ++b) {
+    const BlockPos pos = BlockAt(b, mbx, mby);
+    if (intra) {
+      pred[b] = intra_pred[b];
+      pred_stride[b] = 8;
+    } else {
+      pred[b] = InterPred(*c.ref, pos, mvx, mvy);
+      pred_stride[b] = c.ref->stride(pos.plane);
+    }
+    const int s = cur.stride(pos.plane);
+    nonzero[b] = Quantize(cur.plane(pos.plane) + static_cast<size_t>(pos.y) * s + pos.x,
+                          s, pred[b], pred_stride[b], step8, intra, levels[b]);
+    if (nonzero[b]) cbp |= 1 << b;
+  }
+
+  if (!keyframe) {
+    if (intra) {
+      bw->WriteUe(2);
+    } else if (mvx == 0 && mvy == 0 && cbp == 0) {
+      bw->WriteUe(0);
+    } else {
+      bw->WriteUe(1);
+      bw->WriteSe(mvx - pmx);
+      bw->WriteSe(mvy - pmy);
+      mv[0] = static_cast<int16_t>(mvx);
+      mv[1] = static_cast<int16_t>(mvy);
+    }
+  }
+  const bool skip = !keyframe && !intra && mvx == 0 && mvy == 0 && cbp == 0;
+  if (!skip) {
+    // Deltas chain from the previous coded macroblock so a smooth offset
+    // map costs about a bit per macroblock.
+    if (c.qp_deltas) {
+      bw->WriteSe(mb_qp - c.last_qp);
+      c.last_qp = mb_qp;
+    }
+    bw->WriteBits(cbp, 6);
+  }
+  for (int b = 0; b < 6; ++b) {
+    if (nonzero[b]) WriteBlock(bw, levels[b], nonzero[b]);
+    const BlockPos pos = BlockAt(b, mbx, mby);
+    const int s = c.recon->stride(pos.plane);
+    Reconstruct(levels[b], step8, pred[b], pred_stride[b],
+                c.recon->plane(pos.plane) + static_cast<size_t>(pos.y) * s + pos.x, s);
+  }
+}
+
+bool DecodeMacroblock(MacroblockCoder& c, int mbx, int mby,
+                      bool keyframe, BitReader* br) {
+  int16_t* mv = c.mv + (mby * c.mbs_wide + mbx) * 2;
+  mv[0] = mv[1] = 0;
+  int mode = 2;
+  int mvx = 0, mvy = 0;
+  if (!keyframe) {
+    mode = static_cast<int>(br->ReadUe());
+    if (mode > 2) return false;
+    if (mode == 1) {
+      int pmx, pmy;
+      PredictMv(c.mv, c.mbs_wide, mbx, mby, &pmx, &pmy);
+      // Predictions and vectors both lie within the frame, so a larger
+      // delta is corrupt; checking first keeps the sum from overflowing.
+      const int dx = br->ReadSe();
+      const int dy = br->ReadSe();
+      if (std::abs(dx) > 2 * kMaxDecodeDimension || std::abs(dy) > 2 * kMaxDecodeDimension) {
+        return false;
+      }
+      mvx = pmx + dx;
+      mvy = pmy + dy;
+      const int x = mbx * kMb, y = mby * kMb;
+      if (x + mvx < 0 || y + mvy < 0 || x + mvx + kMb > c.ref->width() ||
+          y + mvy + kMb > c.ref->height()) {
+        return false;
+      }
+      mv[0] = static_cast<int16_t>(mvx);
+      mv[1] = static_cast<int16_t>(mvy);
+    }
+  }
+  if (mode != 0 && c.qp_deltas) {
+    const int delta = br->ReadSe();
+    if (std::abs(delta) > kMaxQp - kMinQp) return false;
+    const int qp = c.last_qp + delta;
+    if (qp < kMinQp || qp > kMaxQp) return false;
+    c.last_qp = qp;
+  }
+  const int step8 = kStep8[mode == 0 ? c.qp : c.last_qp];
+  const int cbp = mode == 0 ? 0 : static_cast<int>(br->ReadBits(6));
+
+  uint8_t intra_pred[6][64];
+  if (mode == 2) IntraPredict(c, mbx, mby, intra_pred);
+  int16_t levels[64];
+  for (int b = 0; b < 6; ++b) {
+    const BlockPos pos = BlockAt(b, mbx, mby);
+    if (cbp & (1 << b)) {
+      if (!ReadBlock(br, levels)) return false;
+    } else {
+      std::fill(levels, levels + 64, 0);
+    }
+    const uint8_t* pred = mode == 2 ? intra_pred[b] : InterPred(*c.ref, pos, mvx, mvy);
+    const int pred_stride = mode == 2 ? 8 : c.ref->stride(pos.plane);
+    const int s = c.recon->stride(pos.plane);
+    Reconstruct(levels, step8, pred, pred_stride,
+                c.recon->plane(pos.plane) + static_cast<size_t>(pos.y) * s + pos.x, s);
+  }
+  return !br->overrun();
+}
+
+}  // namespace
+
+bool SoftwareVideoEncoder::Init(const VideoEncoderConfig& config) {
+  if (config.width <= 0 || config.height <= 0 || config.width > 65535 ||
+      config.height > 65535 || config.bitrate_bps <= 0 || config.framerate <= 0) {
+    return false;
+  }
+  config_ = config;
+  const int w = AlignMb(config.width);
+  const int h = AlignMb(config.height);
+  current_.Allocate(w, h);
+  ref_.Allocate(w, h);
+  recon_.Allocate(w, h);
+  mv_.assign(static_cast<size_t>(w / kMb) * (h / kMb) * 2, 0);
+  ForwardBasis();
+  // Starting QP from bits per pixel; rate control takes over from there.
+  const double bpp = static_cast<double>(config.bitrate_bps) /
+                     (static_cast<double>(config.framerate) * config.width * config.height);
+  qp_ = std::clamp(static_cast<int>(std::lround(30 - 6 * std::log2(bpp / 0.05))),
+                   10, 44);
+  need_keyframe_ = true;
+  frames_since_keyframe_ = 0;
+  rate_debt_bits_ = 0.0;
+  complexity_ratio_ = 1.0f;
+  qp_offsets_.clear();
+  return true;
+}
+
+bool SoftwareVideoEncoder::SetQpOffsetMap(const int8_t* offsets, int blocks_wide,
+                                          int blocks_high) {
+  if (!offsets) {
+    qp_offsets_.clear();
+    return true;
+  }
+  if (blocks_wide != AlignMb(config_.width) / kMb ||
+      blocks_high != AlignMb(config_.height) / kMb) {
+    return false;
+  }
+  qp_offsets_.assign(offsets, offsets + static_cast<size_t>(blocks_wide) * blocks_high);
+  return true;
+}
+
+void SoftwareVideoEncoder::SetFrameComplexity(float ratio) {
+  if (ratio > 0.0f) complexity_ratio_ = ratio;
+}
+
+void SoftwareVideoEncoder::SetRates(int bitrate_bps, int framerate) {
+  if (bitrate_bps > 0) config_.bitrate_bps = bitrate_bps;
+  if (framerate > 0) config_.framerate = framerate;
+}
+
+bool SoftwareVideoEncoder::Encode(const I420Frame& frame, bool force_keyframe,
+                                  EncodedFrame* out) {
+  if (frame.width() != config_.width || frame.height() != config_.height) {
+    return false;
+  }
+  const bool keyframe = need_keyframe_ || force_keyframe ||
+                        (config_.keyframe_interval > 0 &&
+                         frames_since_keyframe_ >= config_.keyframe_interval);
+  PadFrame(frame, &current_);
+  if (fixed_qp_ > 0) {
+    qp_ = std::clamp(fixed_qp_, kMinQp, kMaxQp);
+  } else if (!keyframe && complexity_ratio_ != 1.0f) {
+    // Bits scale roughly with 2^(-qp / 6); take half the step the ratio
+    // suggests and let the feedback below correct the rest.
+    const int delta = static_cast<int>(std::lround(3 * std::log2(complexity_ratio_)));
+    qp_ = std::clamp(qp_ + std::clamp(delta, -4, 4), kMinQp, kMaxQp);
+  }
+  complexity_ratio_ = 1.0f;
+
+  out->data.clear();
+  out->data.push_back('V');
+  out->data.push_back('C');
+  const bool qp_deltas = !qp_offsets_.empty();
+  out->data.push_back((keyframe ? 1 : 0) | (qp_deltas ? 2 : 0));
+  out->data.push_back(static_cast<uint8_t>(config_.width >> 8));
+  out->data.push_back(static_cast<uint8_t>(config_.width));
+  out->data.push_back(static_cast<uint8_t>(config_.height >> 8));
+  out->data.push_back(static_cast<uint8_t>(config_.height));
+  out->data.push_back(static_cast<uint8_t>(qp_));
+
+  BitWriter bw(&out->data);
+  MacroblockCoder coder{&ref_, &recon_, mv_.data(), current_.width() / kMb,
+                        current_.height() / kMb, qp_, qp_, qp_deltas,
+                        qp_deltas ? qp_offsets_.data() : nullptr};
+  for (int mby = 0; mby < coder.mbs_high; ++mby) {
+    for (int mbx = 0; mbx < coder.mbs_wide; ++mbx) {
+      EncodeMacroblock(coder, current_, mbx, mby, keyframe, &bw);
+    }
+  }
+  bw.Flush();
+  std::swap(ref_, recon_);
+
+  out->keyframe = keyframe;
+  out->timestamp_us = frame.timestamp_us;
+  out->width = config_.width;
+  out->height = config_.height;
+  need_keyframe_ = false;
+  frames_since_keyframe_ = keyframe ? 1 : frames_since_keyframe_ + 1;
+
+  if (fixed_qp_ > 0) return true;
+  // Keyframes are expected to be a few times larger than delta frames. The
+  // accumulated over- or undershoot is paid back over about ten frames.
+  double target = static_cast<double>(config_.bitrate_bps) / config_.framerate;
+  if (keyframe) target *= 4;
+  const double bits = out->data.size() * 8.0;
+  const double limit = 2.0 * config_.bitrate_bps;
+  rate_debt_bits_ = std::clamp(rate_debt_bits_ + bits - target, -limit, limit);
+  const double ratio = std::max(bits + rate_debt_bits_ / 10, target / 8) / target;
+  int delta = static_cast<int>(std::lround(2 * std::log2(ratio)));
+  qp_ = std::clamp(qp_ + std::clamp(delta, -2, 2), kMinQp, kMaxQp);
+  return true;
+}
+
+bool SoftwareVideoDecoder::Init(int width, int height) {
+  if (width <= 0 || height <= 0 || width > kMaxDecodeDimension ||
+      height > kMaxDecodeDimension || width * height > kMaxDecodePixels) {
+    return false;
+  }
+  width_ = width;
+  height_ = height;
+  ref_.Allocate(AlignMb(width), AlignMb(height));
+  recon_.Allocate(AlignMb(width), AlignMb(height));
+  mv_.assign(static_cast<size_t>(ref_.width() / kMb) * (ref_.height() / kMb) * 2, 0);
+  have_reference_ = false;
+  return true;
+}
+
+bool SoftwareVideoDecoder::Decode(const uint8_t* data, size_t size,
+                                  int64_t timestamp_us, I420Frame* out) {
+  if (size < kHeaderSize || data[0] != 'V' || data[1] != 'C') return false;
+  const bool keyframe = data[2] & 1;
+  const int width = (data[3] << 8) | data[4];
+  const int height = (data[5] << 8) | data[6];
+  const int qp = data[7];
+  if (width == 0 || height == 0 || qp > kMaxQp) return false;
+  if (width != width_ || height != height_) {
+    // Resolution changes start with a keyframe.
+    if (!keyframe || !Init(width, height)) return false;
+  }
+  if (!keyframe && !have_reference_) return false;
+
+  BitReader br(data + kHeaderSize, size - kHeaderSize);
+  MacroblockCoder coder{&ref_, &recon_, mv_.data(), ref_.width() / kMb,
+                        ref_.height() / kMb, qp, qp, (data[2] & 2) != 0,
+                        nullptr};
+  for (int mby = 0; mby < coder.mbs_high; ++mby) {
+    for (int mbx = 0; mbx < coder.mbs_wide; ++mbx) {
+      if (!DecodeMacroblock(coder, mbx, mby, keyframe, &br)) {
+        // Later delta frames depend on this one; wait for a keyframe.
+        have_reference_ = false;
+        return false;
+      }
+    }
+  }
+  std::swap(ref_, recon_);
+  have_reference_ = true;
+  CropFrame(ref_, width_, height_, out);
+  out->timestamp_us = timestamp_us;
+  return true;
+}
+
+}  // namespace vc
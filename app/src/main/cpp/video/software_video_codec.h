@@ -0,0 +1,79 @@
+#ifndef VCMEDIA_VIDEO_SOFTWARE_VIDEO_CODEC_H_
+#define VCMEDIA_VIDEO_SOFTWARE_VIDEO_CODEC_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "video/i420_frame.h"
+#include "video/video_codec.h"
+
+namespace vc {
+
+// The built-in "VCV" codec, so calls work on any device and host tools can
+// exercise the full media path without a vendored codec library.
+//
+// Frames are coded in 16x16 macroblocks, each skipped, inter predicted
+// (integer-pel motion from a diamond search) or intra predicted (DC from
+// the reconstructed neighbours). Residuals go through an 8x8 DCT, dead-zone
+// quantisation and Exp-Golomb run/level coding. The inverse transform is
+// integer-only so encoder and decoder reconstructions agree bit for bit on
+// any CPU. Frame-level rate control steers QP towards the target bitrate.
+//
+// Bitstream: "VC" u8 flags (bit 0 = keyframe, bit 1 = per-macroblock QP
+// deltas) u16 width u16 height u8 qp, all big endian, followed by the
+// macroblock layer.
+class SoftwareVideoEncoder : public VideoEncoder {
+ public:
+  bool Init(const VideoEncoderConfig& config) override;
+  bool Encode(const I420Frame& frame, bool force_keyframe,
+              EncodedFrame* out) override;
+  void SetRates(int bitrate_bps, int framerate) override;
+  bool SetQpOffsetMap(const int8_t* offsets, int blocks_wide,
+                      int blocks_high) override;
+  void SetFrameComplexity(float ratio) override;
+  const VideoEncoderConfig& config() const override { return config_; }
+  const char* implementation_name() const override { return "vcv-software"; }
+
+  // Holds QP constant and turns rate control off, for comparisons at fixed
+  // quality; 0 restores rate control.
+  void SetFixedQp(int qp) { fixed_qp_ = qp; }
+  int qp() const { return qp_; }
+  // The decoder's view of the last frame, padded to whole macroblocks.
+  const I420Frame& reconstruction() const { return ref_; }
+
+ private:
+  VideoEncoderConfig config_;
+  int qp_ = 30;
+  double rate_debt_bits_ = 0.0;
+  float complexity_ratio_ = 1.0f;
+  int fixed_qp_ = 0;
+  int frames_since_keyframe_ = 0;
+  bool need_keyframe_ = true;
+  I420Frame current_;
+  I420Frame ref_;
+  I420Frame recon_;
+  std::vector<int16_t> mv_;
+  std::vector<int8_t> qp_offsets_;
+};
+
+class SoftwareVideoDecoder : public VideoDecoder {
+ public:
+  // Frames larger than 4096 pixels on a side, or 4096 x 2304 in area, are
+  // rejected.
+  bool Init(int width, int height) override;
+  bool Decode(const uint8_t* data, size_t size, int64_t timestamp_us,
+              I420Frame* out) override;
+  const char* implementation_name() const override { return "vcv-software"; }
+
+ private:
+  int width_ = 0;
+  int height_ = 0;
+  bool have_reference_ = false;
+  I420Frame ref_;
+  I420Frame recon_;
+  std::vector<int16_t> mv_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_SOFTWARE_VIDEO_CODEC_H_
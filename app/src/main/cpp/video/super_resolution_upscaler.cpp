@@ -0,0 +1,467 @@
+#include "video/super_resolution_upscaler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace vc {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double MsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Replicated border around the padded source; the widest tap reaches three
+// pixels out when interpolating the ring of block centres just outside it.
+constexpr int kPad = 4;
+// Block centres are kept for two rows / columns around the plane.
+constexpr int kCentrePad = 2;
+// Consecutive frames within budget after which a retry is considered to
+// hold and the back-off resets.
+constexpr int kRetryHoldFrames = 300;
+
+inline int CubicMid(int p0, int p1, int p2, int p3) {
+  return std::clamp((9 * (p1 + p2) - p0 - p3 + 8) >> 4, 0, 255);
+}
+
+inline int Variation(int p0, int p1, int p2, int p3) {
+  return std::abs(p0 - p1) + std::abs(p1 - p2) + std::abs(p2 - p3);
+}
+
+// out[i] interpolates between samples 1 and 2 of a[k][i] (one direction) or
+// b[k][i] (the orthogonal one), following the direction with less variation
+// by a factor of two and averaging both otherwise.
+void DirectionalRow(const uint8_t* const a[4], const uint8_t* const b[4],
+                    uint8_t* out, int n) {
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i eight = _mm_set1_epi16(8);
+  const __m128i one = _mm_set1_epi16(1);
+  const __m128i max = _mm_set1_epi16(255);
+  auto load = [&](const uint8_t* p) {
+    return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)),
+                             zero);
+  };
+  auto abs_diff = [](__m128i x, __m128i y) {
+    return _mm_max_epi16(_mm_sub_epi16(x, y), _mm_sub_epi16(y, x));
+  };
+  auto cubic = [&](__m128i p0, __m128i p1, __m128i p2, __m128i p3) {
+    __m128i mid = _mm_add_epi16(p1, p2);
+    mid = _mm_add_epi16(_mm_slli_epi16(mid, 3), mid);
+    __m128i v = _mm_srai_epi16(
+        _mm_add_epi16(_mm_sub_epi16(mid, _mm_add_epi16(p0, p3)), eight), 4);
+    return _mm_min_epi16(_mm_max_epi16(v, zero), max);
+  };
+  for (; i + 8 <= n; i += 8) {
+    __m128i a0 = load(a[0] + i), a1 = load(a[1] + i);
+    __m128i a2 = load(a[2] + i), a3 = load(a[3] + i);
+    __m128i b0 = load(b[0] + i), b1 = load(b[1] + i);
+    __m128i b2 = load(b[2] + i), b3 = load(b[3] + i);
+    __m128i ca = cubic(a0, a1, a2, a3);
+    __m128i cb = cubic(b0, b1, b2, b3);
+    __m128i ga = _mm_add_epi16(_mm_add_epi16(abs_diff(a0, a1), abs_diff(a1, a2)),
+                               abs_diff(a2, a3));
+    __m128i gb = _mm_add_epi16(_mm_add_epi16(abs_diff(b0, b1), abs_diff(b1, b2)),
+                               abs_diff(b2, b3));
+    __m128i use_a = _mm_cmplt_epi16(_mm_slli_epi16(ga, 1), gb);
+    __m128i use_b = _mm_cmplt_epi16(_mm_slli_epi16(gb, 1), ga);
+    __m128i mean = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(ca, cb), one), 1);
+    __m128i v = _mm_or_si128(_mm_and_si128(use_b, cb), _mm_andnot_si128(use_b, mean));
+    v = _mm_or_si128(_mm_and_si128(use_a, ca), _mm_andnot_si128(use_a, v));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(v, zero));
+  }
+#elif defined(__ARM_NEON)
+  auto load = [](const uint8_t* p) {
+    return vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)));
+  };
+  auto cubic = [](int16x8_t p0, int16x8_t p1, int16x8_t p2, int16x8_t p3) {
+    int16x8_t v = vmulq_n_s16(vaddq_s16(p1, p2), 9);
+    v = vsubq_s16(v, vaddq_s16(p0, p3));
+    return vminq_s16(vmaxq_s16(vrshrq_n_s16(v, 4), vdupq_n_s16(0)),
+                     vdupq_n_s16(255));
+  };
+  for (; i + 8 <= n; i += 8) {
+    int16x8_t a0 = load(a[0] + i), a1 = load(a[1] + i);
+    int16x8_t a2 = load(a[2] + i), a3 = load(a[3] + i);
+    int16x8_t b0 = load(b[0] + i), b1 = load(b[1] + i);
+    int16x8_t b2 = load(b[2] + i), b3 = load(b[3] + i);
+    int16x8_t ca = cubic(a0, a1, a2, a3);
+    int16x8_t cb = cubic(b0, b1, b2, b3);
+    int16x8_t ga = vaddq_s16(vaddq_s16(vabdq_s16(a0, a1), vabdq_s16(a1, a2)),
+                             vabdq_s16(a2, a3));
+    int16x8_t gb = vaddq_s16(vaddq_s16(vabdq_s16(b0, b1), vabdq_s16(b1, b2)),
+                             vabdq_s16(b2, b3));
+    uint16x8_t use_a = vcltq_s16(vshlq_n_s16(ga, 1), gb);
+    uint16x8_t use_b = vcltq_s16(vshlq_n_s16(gb, 1), ga);
+    int16x8_t mean = vrhaddq_s16(ca, cb);
+    int16x8_t v = vbslq_s16(use_a, ca, vbslq_s16(use_b, cb, mean));
+    vst1_u8(out + i, vqmovun_s16(v));
+  }
+#endif
+  for (; i < n; ++i) {
+    int a0 = a[0][i], a1 = a[1][i], a2 = a[2][i], a3 = a[3][i];
+    int b0 = b[0][i], b1 = b[1][i], b2 = b[2][i], b3 = b[3][i];
+    int ca = CubicMid(a0, a1, a2, a3);
+    int cb = CubicMid(b0, b1, b2, b3);
+    int ga = Variation(a0, a1, a2, a3);
+    int gb = Variation(b0, b1, b2, b3);
+    int v = 2 * ga < gb ? ca : 2 * gb < ga ? cb : (ca + cb + 1) >> 1;
+    out[i] = static_cast<uint8_t>(v);
+  }
+}
+
+// out[i] = cubic between p[1][i] and p[2][i].
+void CubicRow(const uint8_t* const p[4], uint8_t* out, int n) {
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i eight = _mm_set1_epi16(8);
+  auto load = [&](const uint8_t* q) {
+    return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(q)),
+                             zero);
+  };
+  for (; i + 8 <= n; i += 8) {
+    __m128i mid = _mm_add_epi16(load(p[1] + i), load(p[2] + i));
+    mid = _mm_add_epi16(_mm_slli_epi16(mid, 3), mid);
+    __m128i outer = _mm_add_epi16(load(p[0] + i), load(p[3] + i));
+    __m128i v = _mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(mid, outer), eight), 4);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(v, zero));
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 8 <= n; i += 8) {
+    int16x8_t mid = vreinterpretq_s16_u16(vaddl_u8(vld1_u8(p[1] + i), vld1_u8(p[2] + i)));
+    int16x8_t outer = vreinterpretq_s16_u16(vaddl_u8(vld1_u8(p[0] + i), vld1_u8(p[3] + i)));
+    int16x8_t v = vsubq_s16(vmulq_n_s16(mid, 9), outer);
+    vst1_u8(out + i, vqmovun_s16(vrshrq_n_s16(v, 4)));
+  }
+#endif
+  for (; i < n; ++i) {
+    out[i] = static_cast<uint8_t>(CubicMid(p[0][i], p[1][i], p[2][i], p[3][i]));
+  }
+}
+
+// Edge-directed doubling keeps source pixels where they were, which is
+// right for point-sampled input but not for the centre-sited pixels of a
+// scaled frame: after n passes the grid sits (2^n - 1) / 2 pixels off.
+// Resamples it by that amount (an odd number of half pixels, `half_pixels`)
+// in both directions with the same cubic.
+void ShiftPlaneToCentre(const uint8_t* src, int src_stride, int width,
+                        int height, int half_pixels, uint8_t* dst,
+                        int dst_stride) {
+  thread_local std::vector<uint8_t> padded;
+  const int whole = (half_pixels - 1) / 2;
+  padded.resize(width + 2 * kPad + 2 * whole);
+  uint8_t* row = padded.data() + kPad + whole;
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* taps[4];
+    for (int k = 0; k < 4; ++k) {
+      int sy = std::clamp(y - whole - 2 + k, 0, height - 1);
+      taps[k] = src + static_cast<size_t>(sy) * src_stride;
+    }
+    CubicRow(taps, row, width);
+    std::memset(padded.data(), row[0], kPad + whole);
+    std::memset(row + width, row[width - 1], kPad + whole);
+    const uint8_t* across[4] = {row - whole - 2, row - whole - 1, row - whole,
+                                row - whole + 1};
+    CubicRow(across, dst + static_cast<size_t>(y) * dst_stride, width);
+  }
+}
+
+// out[2i] = even[i], out[2i + 1] = odd[i].
+void InterleaveRow(const uint8_t* even, const uint8_t* odd, uint8_t* out, int n) {
+  int i = 0;
+#if defined(__SSE2__)
+  for (; i + 16 <= n; i += 16) {
+    __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(even + i));
+    __m128i o = _mm_loadu_si128(reinterpret_cast<const __m128i*>(odd + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(e, o));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16),
+                     _mm_unpackhi_epi8(e, o));
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 16 <= n; i += 16) {
+    uint8x16x2_t pair = {{vld1q_u8(even + i), vld1q_u8(odd + i)}};
+    vst2q_u8(out + 2 * i, pair);
+  }
+#endif
+  for (; i < n; ++i) {
+    out[2 * i] = even[i];
+    out[2 * i + 1] = odd[i];
+  }
+}
+
+// Centre-aligned 2x linear upsampling (taps 3/4 and 1/4 in each direction)
+// into a 2 * width by 2 * height destination.
+void Upsample2xLinear(const uint8_t* src, int src_stride, int width, int height,
+                      uint8_t* dst, int dst_stride) {
+  // Vertically filtered row (3 * near + far, up to 1020) with one
+  // replicated sample on each side.
+  thread_local std::vector<uint16_t> padded;
+  padded.resize(width + 2);
+  uint16_t* sums = padded.data() + 1;
+  for (int y = 0; y < 2 * height; ++y) {
+    const int near = y / 2;
+    const int far = std::clamp(y & 1 ? near + 1 : near - 1, 0, height - 1);
+    const uint8_t* a = src + static_cast<size_t>(near) * src_stride;
+    const uint8_t* b = src + static_cast<size_t>(far) * src_stride;
+    for (int x = 0; x < width; ++x) sums[x] = static_cast<uint16_t>(3 * a[x] + b[x]);
+    sums[-1] = sums[0];
+    sums[width] = sums[width - 1];
+
+    uint8_t* out = dst + static_cast<size_t>(y) * dst_stride;
+    int x = 0;
+#if defined(__SSE2__)
+    const __m128i eight = _mm_set1_epi16(8);
+    for (; x + 8 <= width; x += 8) {
+      __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x - 1));
+      __m128i mid = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x));
+      __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x + 1));
+      __m128i mid3 = _mm_add_epi16(_mm_add_epi16(mid, mid), _mm_add_epi16(mid, eight));
+      __m128i even = _mm_srli_epi16(_mm_add_epi16(mid3, left), 4);
+      __m128i odd = _mm_srli_epi16(_mm_add_epi16(mid3, right), 4);
+      __m128i packed = _mm_packus_epi16(even, odd);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * x),
+                       _mm_unpacklo_epi8(packed, _mm_srli_si128(packed, 8)));
+    }
+#elif defined(__ARM_NEON)
+    for (; x + 8 <= width; x += 8) {
+      uint16x8_t left = vld1q_u16(sums + x - 1);
+      uint16x8_t mid = vld1q_u16(sums + x);
+      uint16x8_t right = vld1q_u16(sums + x + 1);
+      uint16x8_t mid3 = vmulq_n_u16(mid, 3);
+      uint8x8x2_t pair = {{vrshrn_n_u16(vaddq_u16(mid3, left), 4),
+                           vrshrn_n_u16(vaddq_u16(mid3, right), 4)}};
+      vst2_u8(out + 2 * x, pair);
+    }
+#endif
+    for (; x < width; ++x) {
+      out[2 * x] = static_cast<uint8_t>((3 * sums[x] + sums[x - 1] + 8) >> 4);
+      out[2 * x + 1] = static_cast<uint8_t>((3 * sums[x] + sums[x + 1] + 8) >> 4);
+    }
+  }
+}
+
+// plane = saturate(plane + residual - 128).
+void AddResidualRow(const uint8_t* residual, uint8_t* plane, int width) {
+  int x = 0;
+#if defined(__SSE2__)
+  const __m128i bias = _mm_set1_epi8(static_cast<char>(128));
+  for (; x + 16 <= width; x += 16) {
+    __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(residual + x));
+    __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plane + x));
+    p = _mm_adds_epu8(p, _mm_subs_epu8(r, bias));
+    p = _mm_subs_epu8(p, _mm_subs_epu8(bias, r));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(plane + x), p);
+  }
+#elif defined(__ARM_NEON)
+  const uint8x16_t bias = vdupq_n_u8(128);
+  for (; x + 16 <= width; x += 16) {
+    uint8x16_t r = vld1q_u8(residual + x);
+    uint8x16_t p = vqaddq_u8(vld1q_u8(plane + x), vqsubq_u8(r, bias));
+    vst1q_u8(plane + x, vqsubq_u8(p, vqsubq_u8(bias, r)));
+  }
+#endif
+  for (; x < width; ++x) {
+    plane[x] = static_cast<uint8_t>(std::clamp(plane[x] + residual[x] - 128, 0, 255));
+  }
+}
+
+}  // namespace
+
+void UpscalePlane2xEdgeDirected(const uint8_t* src, int src_stride, int width,
+                                int height, uint8_t* dst, int dst_stride) {
+  thread_local std::vector<uint8_t> padded, centres, horizontal, vertical;
+  const int ps = width + 2 * kPad;
+  padded.resize(static_cast<size_t>(ps) * (height + 2 * kPad));
+  for (int y = -kPad; y < height + kPad; ++y) {
+    const uint8_t* in = src + static_cast<size_t>(std::clamp(y, 0, height - 1)) * src_stride;
+    uint8_t* row = padded.data() + static_cast<size_t>(y + kPad) * ps;
+    std::memset(row, in[0], kPad);
+    std::memcpy(row + kPad, in, width);
+    std::memset(row + kPad + width, in[width - 1], kPad);
+  }
+  // S(x, y) for x, y in [-kPad, size + kPad).
+  auto s = [&](int x, int y) {
+    return padded.data() + static_cast<size_t>(y + kPad) * ps + x + kPad;
+  };
+
+  // Block centres C(x, y) sit between S(x, y) and S(x + 1, y + 1); kept for
+  // x in [-2, width + 2) and y in [-2, height].
+  const int cs = width + 2 * kCentrePad;
+  centres.resize(static_cast<size_t>(cs) * (height + kCentrePad + 1));
+  auto c = [&](int x, int y) {
+    return centres.data() + static_cast<size_t>(y + kCentrePad) * cs + x + kCentrePad;
+  };
+  for (int y = -kCentrePad; y <= height; ++y) {
+    const int x = -kCentrePad;
+    const uint8_t* down[4] = {s(x - 1, y - 1), s(x, y), s(x + 1, y + 1), s(x + 2, y + 2)};
+    const uint8_t* up[4] = {s(x + 2, y - 1), s(x + 1, y), s(x, y + 1), s(x - 1, y + 2)};
+    DirectionalRow(down, up, c(x, y), cs);
+  }
+
+  horizontal.resize(width);
+  vertical.resize(width);
+  for (int y = 0; y < height; ++y) {
+    // Pixels between horizontal neighbours have the centres above and below.
+    const uint8_t* across[4] = {s(-1, y), s(0, y), s(1, y), s(2, y)};
+    const uint8_t* column[4] = {c(0, y - 2), c(0, y - 1), c(0, y), c(0, y + 1)};
+    DirectionalRow(across, column, horizontal.data(), width);
+    // Pixels between vertical neighbours have centres left and right.
+    const uint8_t* down[4] = {s(0, y - 1), s(0, y), s(0, y + 1), s(0, y + 2)};
+    const uint8_t* row[4] = {c(-2, y), c(-1, y), c(0, y), c(1, y)};
+    DirectionalRow(down, row, vertical.data(), width);
+
+    uint8_t* even = dst + static_cast<size_t>(2 * y) * dst_stride;
+    InterleaveRow(s(0, y), horizontal.data(), even, width);
+    InterleaveRow(vertical.data(), c(0, y), even + dst_stride, width);
+  }
+}
+
+SuperResolutionUpscaler::SuperResolutionUpscaler(const Config& config)
+    : config_(config), retry_frames_(config.retry_frames) {}
+
+void SuperResolutionUpscaler::SetCpuUsagePercent(int usage_percent) {
+  if (usage_percent > config_.disable_cpu_percent) {
+    cpu_limited_ = true;
+  } else if (usage_percent < config_.enable_cpu_percent) {
+    cpu_limited_ = false;
+  }
+}
+
+void SuperResolutionUpscaler::Upscale(const I420Frame& src, I420Frame* dst) {
+  ++stats_.frames;
+  const float scale = std::min(static_cast<float>(dst->width()) / src.width(),
+                               static_cast<float>(dst->height()) / src.height());
+  if (scale < config_.min_scale || !enhancing()) {
+    if (frames_until_retry_ > 0) --frames_until_retry_;
+    ScaleFrameBilinear(src, dst);
+    return;
+  }
+
+  const Clock::time_point start = Clock::now();
+  // Double while that stays within the output, but at least once.
+  int passes = 1;
+  while ((src.width() << (passes + 1)) <= dst->width() &&
+         (src.height() << (passes + 1)) <= dst->height()) {
+    ++passes;
+  }
+  const uint8_t* in = src.y();
+  int in_stride = src.stride_y();
+  int w = src.width(), h = src.height();
+  for (int p = 0; p < passes; ++p) {
+    std::vector<uint8_t>& stage = stage_[p & 1];
+    stage.resize(static_cast<size_t>(4) * w * h);
+    UpscalePlane2xEdgeDirected(in, in_stride, w, h, stage.data(), 2 * w);
+    in = stage.data();
+    in_stride = 2 * w;
+    w *= 2;
+    h *= 2;
+  }
+  const bool exact = w == dst->width() && h == dst->height();
+  if (!exact) stage_[passes & 1].resize(static_cast<size_t>(w) * h);
+  uint8_t* luma = exact ? dst->y() : stage_[passes & 1].data();
+  const int luma_stride = exact ? dst->stride_y() : w;
+  ShiftPlaneToCentre(in, in_stride, w, h, (1 << passes) - 1, luma, luma_stride);
+  BackProject(src.y(), src.stride_y(), src.width(), src.height(), passes, luma,
+              luma_stride);
+  if (!exact) {
+    ScalePlaneBilinear(luma, luma_stride, w, h, dst->y(), dst->stride_y(),
+                       dst->width(), dst->height());
+  }
+  for (int p = 1; p < 3; ++p) {
+    if (src.plane_width(p) << passes == dst->plane_width(p) &&
+        src.plane_height(p) << passes == dst->plane_height(p)) {
+      UpsamplePlane(src.plane(p), src.stride(p), src.plane_width(p),
+                    src.plane_height(p), passes, dst->plane(p), dst->stride(p));
+    } else {
+      ScalePlaneBilinear(src.plane(p), src.stride(p), src.plane_width(p),
+                         src.plane_height(p), dst->plane(p), dst->stride(p),
+                         dst->plane_width(p), dst->plane_height(p));
+    }
+  }
+
+  const double elapsed = MsSince(start);
+  ++stats_.enhanced_frames;
+  stats_.enhanced_ms += elapsed;
+  stats_.last_ms = elapsed;
+  UpdateBudget(elapsed);
+}
+
+void SuperResolutionUpscaler::UpsamplePlane(const uint8_t* src, int src_stride,
+                                            int width, int height, int passes,
+                                            uint8_t* dst, int dst_stride) {
+  for (int p = 0; p < passes; ++p) {
+    uint8_t* out = dst;
+    int out_stride = dst_stride;
+    if (p < passes - 1) {
+      std::vector<uint8_t>& buffer = residual_[(p + 1) & 1];
+      buffer.resize(static_cast<size_t>(4) * width * height);
+      out = buffer.data();
+      out_stride = 2 * width;
+    }
+    Upsample2xLinear(src, src_stride, width, height, out, out_stride);
+    src = out;
+    src_stride = out_stride;
+    width *= 2;
+    height *= 2;
+  }
+}
+
+void SuperResolutionUpscaler::BackProject(const uint8_t* low, int low_stride,
+                                          int width, int height, int passes,
+                                          uint8_t* plane, int stride) {
+  // Downscale the estimate the way the sender is assumed to have.
+  const uint8_t* in = plane;
+  int in_stride = stride;
+  for (int p = passes - 1; p >= 0; --p) {
+    std::vector<uint8_t>& buffer = residual_[p & 1];
+    buffer.resize(static_cast<size_t>(width << p) * (height << p));
+    DownscalePlane2x(in, in_stride, width << (p + 1), height << (p + 1),
+                     buffer.data(), width << p);
+    in = buffer.data();
+    in_stride = width << p;
+  }
+  // Residual against the received frame, biased to fit in 8 bits.
+  uint8_t* residual = residual_[0].data();
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* l = low + static_cast<size_t>(y) * low_stride;
+    uint8_t* r = residual + static_cast<size_t>(y) * width;
+    for (int x = 0; x < width; ++x) {
+      r[x] = static_cast<uint8_t>(std::clamp(l[x] - r[x] + 128, 0, 255));
+    }
+  }
+  correction_.resize(static_cast<size_t>(width << passes) * (height << passes));
+  UpsamplePlane(residual, width, width, height, passes, correction_.data(),
+                width << passes);
+  for (int y = 0; y < height << passes; ++y) {
+    AddResidualRow(correction_.data() + static_cast<size_t>(y) * (width << passes),
+                   plane + static_cast<size_t>(y) * stride, width << passes);
+  }
+}
+
+void SuperResolutionUpscaler::UpdateBudget(double elapsed_ms) {
+  if (elapsed_ms <= config_.budget_ms) {
+    over_budget_ = 0;
+    if (++within_budget_ >= kRetryHoldFrames) retry_frames_ = config_.retry_frames;
+    return;
+  }
+  within_budget_ = 0;
+  if (++over_budget_ < config_.over_budget_frames) return;
+  over_budget_ = 0;
+  ++stats_.budget_fallbacks;
+  frames_until_retry_ = retry_frames_;
+  retry_frames_ = std::min(2 * retry_frames_, config_.max_retry_frames);
+}
+
+}  // namespace vc
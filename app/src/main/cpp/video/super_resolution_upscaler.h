@@ -0,0 +1,103 @@
+#ifndef VCMEDIA_VIDEO_SUPER_RESOLUTION_UPSCALER_H_
+#define VCMEDIA_VIDEO_SUPER_RESOLUTION_UPSCALER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "video/i420_frame.h"
+
+namespace vc {
+
+// Upscales low-resolution received video for display, sharper than
+// ScaleFrameBilinear. Luma goes through one or more passes of 2x
+// edge-directed interpolation (UpscalePlane2xEdgeDirected), is shifted back
+// onto the centre-sited pixel grid and refined by one step of
+// back-projection: the estimate is box-downscaled to the received size and
+// the upsampled difference added back, which restores detail the sender's
+// downscale averaged away. A final bilinear step reaches output sizes that
+// are not a power of two times the input. Chroma is scaled linearly.
+//
+// Meant for the one pinned or largest remote tile, where the stream is
+// often far below the display size; other tiles keep ScaleFrameBilinear.
+// The enhanced path has a per-frame time budget: after a few consecutive
+// frames over it the upscaler falls back to bilinear and retries later,
+// backing off further each time a retry fails again. It is also switched
+// off while the CPU is under pressure (SetCpuUsagePercent, e.g. fed from
+// CpuOveruseDetector::usage_percent()).
+class SuperResolutionUpscaler {
+ public:
+  struct Config {
+    // Wall time allowed for the enhanced path per frame.
+    double budget_ms = 4.0;
+    // Smaller scale factors are left to bilinear; there is little to gain.
+    float min_scale = 1.5f;
+    // Consecutive frames over budget before falling back to bilinear.
+    int over_budget_frames = 3;
+    // Bilinear frames before the enhanced path is tried again; doubles after
+    // every fallback up to the maximum and resets once a retry holds.
+    int retry_frames = 150;
+    int max_retry_frames = 2400;
+    // Enhancement is disabled above the first CPU usage and re-enabled below
+    // the second.
+    int disable_cpu_percent = 85;
+    int enable_cpu_percent = 70;
+  };
+
+  struct Stats {
+    int frames = 0;
+    int enhanced_frames = 0;
+    int budget_fallbacks = 0;
+    // Cumulative wall time of the enhanced path.
+    double enhanced_ms = 0.0;
+    double last_ms = 0.0;
+  };
+
+  SuperResolutionUpscaler() : SuperResolutionUpscaler(Config()) {}
+  explicit SuperResolutionUpscaler(const Config& config);
+
+  // Scales `src` into `dst`, which must already be allocated at the output
+  // size.
+  void Upscale(const I420Frame& src, I420Frame* dst);
+
+  void SetCpuUsagePercent(int usage_percent);
+
+  // Whether the next frame at a large enough scale takes the enhanced path.
+  bool enhancing() const { return !cpu_limited_ && frames_until_retry_ == 0; }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  // `passes` rounds of Upsample2xLinear; intermediates in residual_[1]
+  // and residual_[0], alternately.
+  void UpsamplePlane(const uint8_t* src, int src_stride, int width, int height,
+                     int passes, uint8_t* dst, int dst_stride);
+  // One iteration of back-projection on `plane`, an estimate of `low` at
+  // 2^passes times its size.
+  void BackProject(const uint8_t* low, int low_stride, int width, int height,
+                   int passes, uint8_t* plane, int stride);
+  void UpdateBudget(double elapsed_ms);
+
+  const Config config_;
+  Stats stats_;
+  bool cpu_limited_ = false;
+  int over_budget_ = 0;
+  int within_budget_ = 0;
+  int frames_until_retry_ = 0;
+  int retry_frames_;
+  std::vector<uint8_t> stage_[2];
+  std::vector<uint8_t> residual_[2];
+  std::vector<uint8_t> correction_;
+};
+
+// 2x edge-directed interpolation of one plane; the destination is
+// 2 * width by 2 * height. Source pixels are kept; every new pixel is a
+// 4-tap cubic along whichever of two orthogonal directions (the diagonals
+// for block centres, then horizontal / vertical for the rest) the image
+// varies least, or the mean of both when neither dominates. Edges stay
+// continuous instead of picking up bilinear's stair steps and blur.
+// SSE2 / NEON with a scalar tail.
+void UpscalePlane2xEdgeDirected(const uint8_t* src, int src_stride, int width,
+                                int height, uint8_t* dst, int dst_stride);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_SUPER_RESOLUTION_UPSCALER_H_
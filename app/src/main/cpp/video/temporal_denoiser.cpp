@@ -0,0 +1,189 @@
+#include "video/temporal_denoiser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "video/block_sad.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace vc {
+
+namespace {
+
+constexpr int kBlock = 16;
+// A block is filtered when its best match differs by at most this many
+// noise levels on average; more means occlusion or a change of content.
+constexpr float kMatchNoiseLevels = 2.0f;
+// Per-pixel thresholds in noise levels (the noise level is a mean absolute
+// difference, about 0.8 standard deviations).
+constexpr float kStrongNoiseLevels = 1.75f;
+constexpr float kWeakNoiseLevels = 3.5f;
+constexpr float kMinNoiseLevel = 0.5f;
+constexpr float kMaxNoiseLevel = 24.0f;
+constexpr float kNoiseAlpha = 0.1f;
+// The noise level is read from this quantile of block match errors, where
+// blocks are static or well tracked.
+constexpr float kNoiseQuantile = 0.2f;
+
+}  // namespace
+
+void BlendTemporalRow(const uint8_t* cur, const uint8_t* pred, uint8_t* out,
+                      int width, uint8_t strong, uint8_t weak) {
+  int x = 0;
+#if defined(__SSE2__)
+  const __m128i vstrong = _mm_set1_epi8(static_cast<char>(strong));
+  const __m128i vweak = _mm_set1_epi8(static_cast<char>(weak));
+  const __m128i zero = _mm_setzero_si128();
+  for (; x + 16 <= width; x += 16) {
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + x));
+    __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pred + x));
+    __m128i diff = _mm_or_si128(_mm_subs_epu8(c, p), _mm_subs_epu8(p, c));
+    __m128i half = _mm_avg_epu8(c, p);
+    __m128i quarter = _mm_avg_epu8(half, p);
+    __m128i is_strong = _mm_cmpeq_epi8(_mm_subs_epu8(diff, vstrong), zero);
+    __m128i is_weak = _mm_cmpeq_epi8(_mm_subs_epu8(diff, vweak), zero);
+    __m128i weak_or_cur =
+        _mm_or_si128(_mm_and_si128(is_weak, half), _mm_andnot_si128(is_weak, c));
+    __m128i result = _mm_or_si128(_mm_and_si128(is_strong, quarter),
+                                  _mm_andnot_si128(is_strong, weak_or_cur));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), result);
+  }
+#elif defined(__ARM_NEON)
+  const uint8x16_t vstrong = vdupq_n_u8(strong);
+  const uint8x16_t vweak = vdupq_n_u8(weak);
+  for (; x + 16 <= width; x += 16) {
+    uint8x16_t c = vld1q_u8(cur + x);
+    uint8x16_t p = vld1q_u8(pred + x);
+    uint8x16_t diff = vabdq_u8(c, p);
+    uint8x16_t half = vrhaddq_u8(c, p);
+    uint8x16_t quarter = vrhaddq_u8(half, p);
+    uint8x16_t result = vbslq_u8(vcleq_u8(diff, vweak), half, c);
+    result = vbslq_u8(vcleq_u8(diff, vstrong), quarter, result);
+    vst1q_u8(out + x, result);
+  }
+#endif
+  for (; x < width; ++x) {
+    const int c = cur[x], p = pred[x];
+    const int diff = std::abs(c - p);
+    const int half = (c + p + 1) >> 1;
+    out[x] = static_cast<uint8_t>(diff <= strong ? (half + p + 1) >> 1
+                                  : diff <= weak ? half
+                                                 : c);
+  }
+}
+
+void TemporalDenoiser::Reset() { have_previous_ = false; }
+
+void TemporalDenoiser::Process(I420Frame* frame) {
+  const int width = frame->width();
+  const int height = frame->height();
+  if (!have_previous_ || previous_.width() != width || previous_.height() != height ||
+      config_.strength <= 0.0f) {
+    previous_.Allocate(width, height);
+    std::memcpy(previous_.y(), frame->y(), frame->size_bytes());
+    have_previous_ = config_.strength > 0.0f;
+    return;
+  }
+
+  const int blocks_wide = width / kBlock;
+  const int blocks_high = height / kBlock;
+  mv_.assign(static_cast<size_t>(blocks_wide) * blocks_high * 2, 0);
+  block_error_.clear();
+
+  const float strong_f = std::min(255.0f, config_.strength * kStrongNoiseLevels * noise_level_);
+  const float weak_f = std::min(255.0f, config_.strength * kWeakNoiseLevels * noise_level_);
+  const uint8_t strong = static_cast<uint8_t>(strong_f);
+  const uint8_t weak = static_cast<uint8_t>(weak_f);
+  const uint32_t max_match = static_cast<uint32_t>(
+      (kMatchNoiseLevels * config_.strength * noise_level_ + 1.0f) * kBlock * kBlock);
+  const int sy = frame->stride_y();
+  const int suv = frame->stride_uv();
+
+  for (int by = 0; by < blocks_high; ++by) {
+    for (int bx = 0; bx < blocks_wide; ++bx) {
+      const int x = bx * kBlock, y = by * kBlock;
+      const uint8_t* cur = frame->y() + static_cast<size_t>(y) * sy + x;
+      const int min_x = std::max(-config_.search_range, -x);
+      const int max_x = std::min(config_.search_range, width - kBlock - x);
+      const int min_y = std::max(-config_.search_range, -y);
+      const int max_y = std::min(config_.search_range, height - kBlock - y);
+      auto sad_at = [&](int mx, int my) {
+        return Sad16x16(cur, sy,
+                        previous_.y() + static_cast<size_t>(y + my) * sy + x + mx, sy);
+      };
+
+      int best_x = 0, best_y = 0;
+      uint32_t best = sad_at(0, 0);
+      const int16_t* seeds[2] = {
+          bx > 0 ? &mv_[(static_cast<size_t>(by) * blocks_wide + bx - 1) * 2] : nullptr,
+          by > 0 ? &mv_[(static_cast<size_t>(by - 1) * blocks_wide + bx) * 2] : nullptr};
+      for (const int16_t* seed : seeds) {
+        if (!seed || (seed[0] == 0 && seed[1] == 0)) continue;
+        const int mx = std::clamp<int>(seed[0], min_x, max_x);
+        const int my = std::clamp<int>(seed[1], min_y, max_y);
+        const uint32_t sad = sad_at(mx, my);
+        if (sad < best) {
+          best = sad;
+          best_x = mx;
+          best_y = my;
+        }
+      }
+      static const int kDiamond[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+      for (int iter = 0; iter < 2 * config_.search_range; ++iter) {
+        const int cx = best_x, cy = best_y;
+        for (const auto& d : kDiamond) {
+          const int mx = cx + d[0], my = cy + d[1];
+          if (mx < min_x || mx > max_x || my < min_y || my > max_y) continue;
+          const uint32_t sad = sad_at(mx, my);
+          if (sad < best) {
+            best = sad;
+            best_x = mx;
+            best_y = my;
+          }
+        }
+        if (best_x == cx && best_y == cy) break;
+      }
+      int16_t* mv = &mv_[(static_cast<size_t>(by) * blocks_wide + bx) * 2];
+      mv[0] = static_cast<int16_t>(best_x);
+      mv[1] = static_cast<int16_t>(best_y);
+      block_error_.push_back(static_cast<uint16_t>(std::min<uint32_t>(best, 65535)));
+      if (best > max_match) continue;
+
+      for (int r = 0; r < kBlock; ++r) {
+        uint8_t* row = frame->y() + static_cast<size_t>(y + r) * sy + x;
+        BlendTemporalRow(row,
+                         previous_.y() + static_cast<size_t>(y + r + best_y) * sy + x + best_x,
+                         row, kBlock, strong, weak);
+      }
+      for (int p = 1; p <= 2; ++p) {
+        const int cx = x / 2, cy = y / 2;
+        const int mx = best_x >> 1, my = best_y >> 1;
+        for (int r = 0; r < kBlock / 2; ++r) {
+          uint8_t* row = frame->plane(p) + static_cast<size_t>(cy + r) * suv + cx;
+          BlendTemporalRow(
+              row, previous_.plane(p) + static_cast<size_t>(cy + r + my) * suv + cx + mx,
+              row, kBlock / 2, strong, weak);
+        }
+      }
+    }
+  }
+
+  if (!block_error_.empty()) {
+    auto nth = block_error_.begin() +
+               static_cast<ptrdiff_t>(kNoiseQuantile * (block_error_.size() - 1));
+    std::nth_element(block_error_.begin(), nth, block_error_.end());
+    const float level = static_cast<float>(*nth) / (kBlock * kBlock);
+    noise_level_ = std::clamp(noise_level_ + kNoiseAlpha * (level - noise_level_),
+                              kMinNoiseLevel, kMaxNoiseLevel);
+  }
+  std::memcpy(previous_.y(), frame->y(), frame->size_bytes());
+}
+
+}  // namespace vc
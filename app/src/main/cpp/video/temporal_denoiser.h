@@ -0,0 +1,59 @@
+#ifndef VCMEDIA_VIDEO_TEMPORAL_DENOISER_H_
+#define VCMEDIA_VIDEO_TEMPORAL_DENOISER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "video/i420_frame.h"
+
+namespace vc {
+
+// Motion-compensated temporal noise reduction for camera frames, run in
+// place before encoding. Sensor noise is uncorrelated between frames while
+// content is not, so each 16x16 block is matched against the previous
+// denoised frame (small diamond search seeded with the neighbours' vectors)
+// and blended towards it recursively. The blend is per pixel: differences
+// within the noise level are averaged strongly, larger ones less, and real
+// changes pass through untouched, which keeps moving edges free of ghosts.
+// Blocks without a good match are left alone.
+//
+// Thresholds follow a running estimate of the noise level, taken from the
+// best-matching blocks of each frame, so the filter backs off by itself on
+// clean, well-lit input. Chroma reuses the luma vectors.
+class TemporalDenoiser {
+ public:
+  struct Config {
+    // Scales the blend thresholds; 0 disables filtering.
+    float strength = 1.0f;
+    // Motion search range in luma pixels.
+    int search_range = 8;
+  };
+
+  TemporalDenoiser() : TemporalDenoiser(Config()) {}
+  explicit TemporalDenoiser(const Config& config) : config_(config) {}
+
+  void Process(I420Frame* frame);
+  void Reset();
+
+  // Mean absolute difference between a frame and the motion-compensated
+  // previous output that is attributed to noise, in luma levels.
+  float noise_level() const { return noise_level_; }
+
+ private:
+  const Config config_;
+  I420Frame previous_;
+  bool have_previous_ = false;
+  float noise_level_ = 4.0f;
+  std::vector<int16_t> mv_;
+  std::vector<uint16_t> block_error_;
+};
+
+// Per-pixel recursive blend used by TemporalDenoiser: where |cur - pred| is
+// at most `strong` the result is 3/4 pred, at most `weak` 1/2 pred, and cur
+// otherwise. SSE2 / NEON with a scalar tail.
+void BlendTemporalRow(const uint8_t* cur, const uint8_t* pred, uint8_t* out,
+                      int width, uint8_t strong, uint8_t weak);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_TEMPORAL_DENOISER_H_
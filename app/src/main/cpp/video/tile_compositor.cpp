@@ -0,0 +1,262 @@
+#include "video/tile_compositor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "video/yuv_to_rgba.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace vc {
+
+namespace {
+
+// Bilinear weights are 7-bit so a weighted pair of samples fits in int16.
+constexpr int kFracBits = 7;
+constexpr int kFracOne = 1 << kFracBits;
+
+void FillRow(uint8_t* dst, int pixels, const uint8_t rgba[4]) {
+  uint32_t value;
+  std::memcpy(&value, rgba, 4);
+  for (int x = 0; x < pixels; ++x) std::memcpy(dst + 4 * x, &value, 4);
+}
+
+// Centre-aligned bilinear taps mapping `dst` output samples onto `src`
+// source samples: the first source index and the weight of the next one.
+void ComputeTaps(int src, int dst, std::vector<int>* index,
+                 std::vector<uint8_t>* frac) {
+  index->resize(dst);
+  frac->resize(dst);
+  for (int i = 0; i < dst; ++i) {
+    int64_t s = ((2 * i + 1) * static_cast<int64_t>(src) << 15) / dst - (1 << 15);
+    s = std::clamp<int64_t>(s, 0, static_cast<int64_t>(src - 1) << 16);
+    (*index)[i] = static_cast<int>(s >> 16);
+    (*frac)[i] = static_cast<uint8_t>((s >> (16 - kFracBits)) & (kFracOne - 1));
+  }
+}
+
+// out[i] = a[i] * (1 - f) + b[i] * f with f in 1/128ths.
+void BlendRows(const uint8_t* a, const uint8_t* b, int f, uint8_t* out, int n) {
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i wa = _mm_set1_epi16(static_cast<int16_t>(kFracOne - f));
+  const __m128i wb = _mm_set1_epi16(static_cast<int16_t>(f));
+  const __m128i round = _mm_set1_epi16(kFracOne / 2);
+  for (; i + 16 <= n; i += 16) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    __m128i lo = _mm_add_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+                      _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb)),
+        round);
+    __m128i hi = _mm_add_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+                      _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb)),
+        round);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packus_epi16(_mm_srli_epi16(lo, kFracBits),
+                                      _mm_srli_epi16(hi, kFracBits)));
+  }
+#elif defined(__ARM_NEON)
+  const uint8x8_t wa = vdup_n_u8(static_cast<uint8_t>(kFracOne - f));
+  const uint8x8_t wb = vdup_n_u8(static_cast<uint8_t>(f));
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t va = vld1q_u8(a + i);
+    uint8x16_t vb = vld1q_u8(b + i);
+    uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(va), wa), vget_low_u8(vb), wb);
+    uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(va), wa), vget_high_u8(vb), wb);
+    vst1q_u8(out + i, vcombine_u8(vrshrn_n_u16(lo, kFracBits), vrshrn_n_u16(hi, kFracBits)));
+  }
+#endif
+  for (; i < n; ++i) {
+    out[i] = static_cast<uint8_t>((a[i] * (kFracOne - f) + b[i] * f + kFracOne / 2) >>
+                                  kFracBits);
+  }
+}
+
+// One output row of a plane: vertical blend of the two source rows around
+// `dst_row`, then horizontal resampling through the taps. `blend` needs
+// room for src_width + 1 samples (the last is a copy of the edge).
+void ScaleRow(const uint8_t* src, int src_stride, int src_width, int src_height,
+              int dst_row, int dst_height, const std::vector<int>& x_index,
+              const std::vector<uint8_t>& x_frac, uint8_t* blend, uint8_t* out) {
+  int64_t s = ((2 * dst_row + 1) * static_cast<int64_t>(src_height) << 15) / dst_height -
+              (1 << 15);
+  s = std::clamp<int64_t>(s, 0, static_cast<int64_t>(src_height - 1) << 16);
+  const int y0 = static_cast<int>(s >> 16);
+  const int y1 = std::min(y0 + 1, src_height - 1);
+  const int fy = static_cast<int>((s >> (16 - kFracBits)) & (kFracOne - 1));
+  const uint8_t* r0 = src + static_cast<size_t>(y0) * src_stride;
+  if (fy == 0) {
+    std::memcpy(blend, r0, src_width);
+  } else {
+    BlendRows(r0, src + static_cast<size_t>(y1) * src_stride, fy, blend, src_width);
+  }
+  blend[src_width] = blend[src_width - 1];
+  const int n = static_cast<int>(x_index.size());
+  for (int x = 0; x < n; ++x) {
+    const uint8_t* p = blend + x_index[x];
+    out[x] = static_cast<uint8_t>(
+        (p[0] * (kFracOne - x_frac[x]) + p[1] * x_frac[x] + kFracOne / 2) >> kFracBits);
+  }
+}
+
+}  // namespace
+
+std::vector<TileRect> TileCompositor::GridLayout(int tiles, int width, int height,
+                                                 int gap, float cell_aspect) {
+  std::vector<TileRect> cells;
+  if (tiles <= 0) return cells;
+  int best_columns = 1, best_width = 0, best_height = 0;
+  for (int columns = 1; columns <= tiles; ++columns) {
+    const int rows = (tiles + columns - 1) / columns;
+    const int w = (width - gap * (columns + 1)) / columns;
+    const int h = (height - gap * (rows + 1)) / rows;
+    if (w <= 0 || h <= 0) continue;
+    int cell_w = w, cell_h = h;
+    if (w > h * cell_aspect) {
+      cell_w = static_cast<int>(h * cell_aspect);
+    } else {
+      cell_h = static_cast<int>(w / cell_aspect);
+    }
+    if (cell_w * cell_h > best_width * best_height) {
+      best_columns = columns;
+      best_width = cell_w;
+      best_height = cell_h;
+    }
+  }
+  if (best_width == 0) return cells;
+  const int columns = best_columns;
+  const int rows = (tiles + columns - 1) / columns;
+  const int grid_height = rows * best_height + (rows - 1) * gap;
+  const int top = (height - grid_height) / 2;
+  for (int i = 0; i < tiles; ++i) {
+    const int row = i / columns;
+    const int in_row = std::min(columns, tiles - row * columns);
+    const int row_width = in_row * best_width + (in_row - 1) * gap;
+    const int left = (width - row_width) / 2;
+    cells.push_back({left + (i % columns) * (best_width + gap),
+                     top + row * (best_height + gap), best_width, best_height});
+  }
+  return cells;
+}
+
+bool TileCompositor::Compose(const I420Frame* const* tiles, int count,
+                             RenderTarget* target) {
+  RgbaBuffer buffer;
+  if (!target->Lock(&buffer)) return false;
+  ComposeInto(tiles, count, buffer);
+  return target->Post();
+}
+
+void TileCompositor::ComposeInto(const I420Frame* const* tiles, int count,
+                                 const RgbaBuffer& buffer) {
+  if (count != layout_tiles_ || buffer.width != layout_width_ ||
+      buffer.height != layout_height_) {
+    layout_ = GridLayout(count, buffer.width, buffer.height, config_.gap,
+                         config_.cell_aspect);
+    layout_tiles_ = count;
+    layout_width_ = buffer.width;
+    layout_height_ = buffer.height;
+  }
+  // Background everywhere outside the cells; cells are in raster order.
+  for (int y = 0; y < buffer.height; ++y) {
+    uint8_t* row = buffer.pixels + static_cast<size_t>(y) * buffer.stride;
+    int x = 0;
+    for (const TileRect& cell : layout_) {
+      if (y < cell.y || y >= cell.y + cell.height) continue;
+      FillRow(row + 4 * x, cell.x - x, config_.background);
+      x = cell.x + cell.width;
+    }
+    FillRow(row + 4 * x, buffer.width - x, config_.background);
+  }
+  for (size_t i = 0; i < layout_.size(); ++i) {
+    const I420Frame* frame = tiles[i];
+    if (frame && frame->width() > 0 && frame->height() > 0) {
+      DrawTile(*frame, layout_[i], buffer);
+    } else {
+      FillRect(layout_[i], buffer);
+    }
+  }
+}
+
+void TileCompositor::DrawTile(const I420Frame& frame, const TileRect& rect,
+                              const RgbaBuffer& buffer) {
+  if (rect.width <= 0 || rect.height <= 0) return;
+  // Source crop (even, so chroma lines up) and destination rectangle.
+  int sx = 0, sy = 0, sw = frame.width(), sh = frame.height();
+  TileRect dst = rect;
+  const double frame_aspect = static_cast<double>(frame.width()) / frame.height();
+  const double rect_aspect = static_cast<double>(rect.width) / rect.height;
+  if (config_.fit == Fit::kCrop) {
+    if (frame_aspect > rect_aspect) {
+      sw = std::max(2, static_cast<int>(std::lround(sh * rect_aspect)) & ~1);
+      sx = ((frame.width() - sw) / 2) & ~1;
+    } else {
+      sh = std::max(2, static_cast<int>(std::lround(sw / rect_aspect)) & ~1);
+      sy = ((frame.height() - sh) / 2) & ~1;
+    }
+    sw = std::min(sw, frame.width());
+    sh = std::min(sh, frame.height());
+  } else {
+    if (frame_aspect > rect_aspect) {
+      dst.height = std::max(1, static_cast<int>(std::lround(rect.width / frame_aspect)));
+      dst.y = rect.y + (rect.height - dst.height) / 2;
+      FillRect({rect.x, rect.y, rect.width, dst.y - rect.y}, buffer);
+      FillRect({rect.x, dst.y + dst.height, rect.width,
+                rect.y + rect.height - dst.y - dst.height},
+               buffer);
+    } else {
+      dst.width = std::max(1, static_cast<int>(std::lround(rect.height * frame_aspect)));
+      dst.x = rect.x + (rect.width - dst.width) / 2;
+      FillRect({rect.x, rect.y, dst.x - rect.x, rect.height}, buffer);
+      FillRect({dst.x + dst.width, rect.y, rect.x + rect.width - dst.x - dst.width,
+                rect.height},
+               buffer);
+    }
+  }
+
+  const int csx = sx / 2, csy = sy / 2;
+  const int csw = (sw + 1) / 2, csh = (sh + 1) / 2;
+  const int cdw = (dst.width + 1) / 2, cdh = (dst.height + 1) / 2;
+  ComputeTaps(sw, dst.width, &luma_x_, &luma_frac_);
+  ComputeTaps(csw, cdw, &chroma_x_, &chroma_frac_);
+  blend_.resize(std::max(sw, csw) + 1);
+  y_row_.resize(dst.width);
+  u_row_.resize(cdw);
+  v_row_.resize(cdw);
+
+  const uint8_t* y_plane = frame.y() + static_cast<size_t>(sy) * frame.stride_y() + sx;
+  const size_t chroma_offset = static_cast<size_t>(csy) * frame.stride_uv() + csx;
+  int chroma_row = -1;
+  for (int row = 0; row < dst.height; ++row) {
+    ScaleRow(y_plane, frame.stride_y(), sw, sh, row, dst.height, luma_x_, luma_frac_,
+             blend_.data(), y_row_.data());
+    if (row / 2 != chroma_row) {
+      chroma_row = row / 2;
+      ScaleRow(frame.u() + chroma_offset, frame.stride_uv(), csw, csh, chroma_row, cdh,
+               chroma_x_, chroma_frac_, blend_.data(), u_row_.data());
+      ScaleRow(frame.v() + chroma_offset, frame.stride_uv(), csw, csh, chroma_row, cdh,
+               chroma_x_, chroma_frac_, blend_.data(), v_row_.data());
+    }
+    I420RowToRgba(y_row_.data(), u_row_.data(), v_row_.data(),
+                  buffer.pixels + static_cast<size_t>(dst.y + row) * buffer.stride +
+                      4 * dst.x,
+                  dst.width);
+  }
+}
+
+void TileCompositor::FillRect(const TileRect& rect, const RgbaBuffer& buffer) const {
+  for (int y = rect.y; y < rect.y + rect.height; ++y) {
+    FillRow(buffer.pixels + static_cast<size_t>(y) * buffer.stride + 4 * rect.x,
+            rect.width, config_.background);
+  }
+}
+
+}  // namespace vc
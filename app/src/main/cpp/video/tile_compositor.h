@@ -0,0 +1,84 @@
+#ifndef VCMEDIA_VIDEO_TILE_COMPOSITOR_H_
+#define VCMEDIA_VIDEO_TILE_COMPOSITOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "video/i420_frame.h"
+#include "video/render_target.h"
+
+namespace vc {
+
+struct TileRect {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+};
+
+// CPU render path for the gallery view: scales any number of decoded I420
+// frames into a grid of equal cells and converts them to RGBA directly in
+// the output buffer, one output row at a time (vertical blend of two
+// source rows, horizontal bilinear resample, then I420RowToRgba), so no
+// scaled I420 or RGBA copy of a tile is ever made. Gaps, letterbox bars and
+// empty cells are filled with the background colour. Used where the GPU
+// path is unavailable, and on hosts into a MemoryRenderTarget.
+class TileCompositor {
+ public:
+  enum class Fit {
+    kCrop,       // Fill the cell, cropping the frame's excess width or height.
+    kLetterbox,  // Show the whole frame, with bars in the cell.
+  };
+
+  struct Config {
+    // Space between cells and around the grid, in output pixels.
+    int gap = 4;
+    Fit fit = Fit::kCrop;
+    // Aspect ratio of the cells.
+    float cell_aspect = 16.0f / 9.0f;
+    // R, G, B, A of everything outside the pictures.
+    uint8_t background[4] = {24, 24, 24, 255};
+  };
+
+  TileCompositor() : TileCompositor(Config()) {}
+  explicit TileCompositor(const Config& config) : config_(config) {}
+
+  // Cells for `tiles` participants in a width x height output: the column
+  // count that makes cells largest, the grid centred and a partial last row
+  // centred under the others.
+  static std::vector<TileRect> GridLayout(int tiles, int width, int height,
+                                          int gap, float cell_aspect);
+
+  // Composes `count` frames (nullptr draws an empty cell) into the next
+  // buffer of `target` and posts it.
+  bool Compose(const I420Frame* const* tiles, int count, RenderTarget* target);
+  void ComposeInto(const I420Frame* const* tiles, int count,
+                   const RgbaBuffer& buffer);
+
+  // Scales one frame into `rect` of `buffer`.
+  void DrawTile(const I420Frame& frame, const TileRect& rect,
+                const RgbaBuffer& buffer);
+
+ private:
+  void FillRect(const TileRect& rect, const RgbaBuffer& buffer) const;
+
+  const Config config_;
+  std::vector<TileRect> layout_;
+  int layout_tiles_ = -1;
+  int layout_width_ = 0;
+  int layout_height_ = 0;
+  // Horizontal taps (source index and 7-bit fraction) for luma and chroma,
+  // and the rows being built for the current output row.
+  std::vector<int> luma_x_;
+  std::vector<uint8_t> luma_frac_;
+  std::vector<int> chroma_x_;
+  std::vector<uint8_t> chroma_frac_;
+  std::vector<uint8_t> blend_;
+  std::vector<uint8_t> y_row_;
+  std::vector<uint8_t> u_row_;
+  std::vector<uint8_t> v_row_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_TILE_COMPOSITOR_H_
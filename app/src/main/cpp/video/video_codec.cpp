@@ -0,0 +1,43 @@
+#include "video/video_codec.h"
+
+#include "video/software_video_codec.h"
+
+#if defined(__ANDROID__)
+#include "video/media_codec_video_codec.h"
+#endif
+
+namespace vc {
+
+std::unique_ptr<VideoEncoder> CreateVideoEncoder(VideoCodecBackend backend,
+                                                 VideoCodecType type) {
+  switch (backend) {
+    case VideoCodecBackend::kSoftware:
+      if (type != VideoCodecType::kVcv) return nullptr;
+      return std::make_unique<SoftwareVideoEncoder>();
+    case VideoCodecBackend::kMediaCodec:
+#if defined(__ANDROID__)
+      return CreateMediaCodecVideoEncoder(type);
+#else
+      return nullptr;
+#endif
+  }
+  return nullptr;
+}
+
+std::unique_ptr<VideoDecoder> CreateVideoDecoder(VideoCodecBackend backend,
+                                                 VideoCodecType type) {
+  switch (backend) {
+    case VideoCodecBackend::kSoftware:
+      if (type != VideoCodecType::kVcv) return nullptr;
+      return std::make_unique<SoftwareVideoDecoder>();
+    case VideoCodecBackend::kMediaCodec:
+#if defined(__ANDROID__)
+      return CreateMediaCodecVideoDecoder(type);
+#else
+      return nullptr;
+#endif
+  }
+  return nullptr;
+}
+
+}  // namespace vc
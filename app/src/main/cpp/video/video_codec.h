@@ -0,0 +1,90 @@
+#ifndef VCMEDIA_VIDEO_VIDEO_CODEC_H_
+#define VCMEDIA_VIDEO_VIDEO_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "video/i420_frame.h"
+
+namespace vc {
+
+enum class VideoCodecType {
+  kVcv,   // Built-in block DCT codec; software backend only.
+  kVp8,   // MediaCodec only.
+  kH264,  // MediaCodec only.
+};
+
+enum class VideoCodecBackend {
+  kSoftware,    // Portable C++; available everywhere.
+  kMediaCodec,  // Android hardware codecs; unavailable elsewhere.
+};
+
+struct VideoEncoderConfig {
+  int width = 0;
+  int height = 0;
+  int bitrate_bps = 1000000;
+  int framerate = 30;
+  // Frames between keyframes; 0 for keyframes only on request.
+  int keyframe_interval = 0;
+};
+
+struct EncodedFrame {
+  std::vector<uint8_t> data;
+  bool keyframe = false;
+  int64_t timestamp_us = 0;
+  int width = 0;
+  int height = 0;
+};
+
+class VideoEncoder {
+ public:
+  virtual ~VideoEncoder() = default;
+
+  // May be slow (hardware codecs take tens of milliseconds); see
+  // VideoEncoderPool for keeping it off the call setup path.
+  virtual bool Init(const VideoEncoderConfig& config) = 0;
+  // Encodes one frame at the configured size. Asynchronous backends may
+  // return true with empty `out->data` while output is still pending.
+  virtual bool Encode(const I420Frame& frame, bool force_keyframe,
+                      EncodedFrame* out) = 0;
+  virtual void SetRates(int bitrate_bps, int framerate) = 0;
+  // Per 16x16 block QP offsets in raster order, added to the frame QP from
+  // the next frame on; negative offsets spend more bits on a region. The map
+  // must cover ceil(width / 16) x ceil(height / 16) blocks; nullptr clears
+  // it. Returns false if the backend has no region-of-interest control.
+  virtual bool SetQpOffsetMap(const int8_t* /*offsets*/, int /*blocks_wide*/,
+                              int /*blocks_high*/) {
+    return false;
+  }
+  // Expected coding cost of the next frame relative to the previous one,
+  // from a pre-analysis such as FrameAnalyzer. Rate control can then move
+  // QP ahead of a change in content instead of reacting a frame late.
+  virtual void SetFrameComplexity(float /*ratio*/) {}
+  virtual const VideoEncoderConfig& config() const = 0;
+  virtual const char* implementation_name() const = 0;
+};
+
+class VideoDecoder {
+ public:
+  virtual ~VideoDecoder() = default;
+
+  virtual bool Init(int width, int height) = 0;
+  // Returns true when a frame was written to `out`. Asynchronous backends
+  // may return false for the first frames while the pipeline fills.
+  virtual bool Decode(const uint8_t* data, size_t size, int64_t timestamp_us,
+                      I420Frame* out) = 0;
+  virtual const char* implementation_name() const = 0;
+};
+
+// Returns nullptr if the backend is unavailable on this platform or does
+// not support `type`. The codec still needs Init().
+std::unique_ptr<VideoEncoder> CreateVideoEncoder(VideoCodecBackend backend,
+                                                 VideoCodecType type);
+std::unique_ptr<VideoDecoder> CreateVideoDecoder(VideoCodecBackend backend,
+                                                 VideoCodecType type);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_VIDEO_CODEC_H_
@@ -0,0 +1,107 @@
+#include "video/video_encoder_pool.h"
+
+#include <utility>
+
+namespace vc {
+
+VideoEncoderPool::VideoEncoderPool(int encoders_per_profile)
+    : per_profile_(encoders_per_profile), thread_([this] { Run(); }) {}
+
+VideoEncoderPool::~VideoEncoderPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_.notify_all();
+  thread_.join();
+}
+
+void VideoEncoderPool::Warm(const Profile& profile) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Entry& e : entries_) {
+      if (Matches(e.profile, profile.backend, profile.type, profile.config)) return;
+    }
+    entries_.push_back(Entry{profile, {}, false});
+  }
+  work_.notify_one();
+}
+
+void VideoEncoderPool::WaitUntilWarm() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  filled_.wait(lock, [this] { return !busy_ && FindDeficit() == nullptr; });
+}
+
+std::unique_ptr<VideoEncoder> VideoEncoderPool::Acquire(
+    VideoCodecBackend backend, VideoCodecType type,
+    const VideoEncoderConfig& config) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Entry& e : entries_) {
+      if (!Matches(e.profile, backend, type, config) || e.idle.empty()) continue;
+      std::unique_ptr<VideoEncoder> encoder = std::move(e.idle.back());
+      e.idle.pop_back();
+      ++stats_.warm_hits;
+      work_.notify_one();
+      encoder->SetRates(config.bitrate_bps, config.framerate);
+      return encoder;
+    }
+    ++stats_.cold_starts;
+  }
+  std::unique_ptr<VideoEncoder> encoder = CreateVideoEncoder(backend, type);
+  if (!encoder || !encoder->Init(config)) return nullptr;
+  return encoder;
+}
+
+VideoEncoderPool::Stats VideoEncoderPool::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+bool VideoEncoderPool::Matches(const Profile& p, VideoCodecBackend backend,
+                               VideoCodecType type,
+                               const VideoEncoderConfig& config) {
+  return p.backend == backend && p.type == type &&
+         p.config.width == config.width && p.config.height == config.height &&
+         p.config.keyframe_interval == config.keyframe_interval;
+}
+
+VideoEncoderPool::Entry* VideoEncoderPool::FindDeficit() {
+  for (Entry& e : entries_) {
+    if (!e.failed && static_cast<int>(e.idle.size()) < per_profile_) return &e;
+  }
+  return nullptr;
+}
+
+void VideoEncoderPool::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_.wait(lock, [this] { return stop_ || FindDeficit() != nullptr; });
+    if (stop_) return;
+    const Profile profile = FindDeficit()->profile;
+    busy_ = true;
+    lock.unlock();
+
+    // Codec setup runs without the lock so Acquire() never waits for it.
+    std::unique_ptr<VideoEncoder> encoder =
+        CreateVideoEncoder(profile.backend, profile.type);
+    bool ok = encoder && encoder->Init(profile.config);
+
+    lock.lock();
+    busy_ = false;
+    for (Entry& e : entries_) {
+      if (!Matches(e.profile, profile.backend, profile.type, profile.config)) continue;
+      if (ok) {
+        e.idle.push_back(std::move(encoder));
+        ++stats_.initialised;
+      } else {
+        // Unsupported here; stop retrying so Acquire() falls back to cold.
+        e.failed = true;
+        ++stats_.init_failures;
+      }
+    }
+    filled_.notify_all();
+  }
+}
+
+}  // namespace vc
@@ -0,0 +1,77 @@
+#ifndef VCMEDIA_VIDEO_VIDEO_ENCODER_POOL_H_
+#define VCMEDIA_VIDEO_VIDEO_ENCODER_POOL_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "video/video_codec.h"
+
+namespace vc {
+
+// Keeps initialised encoders ready so that starting to send video does not
+// wait for codec setup, which takes tens of milliseconds for hardware
+// encoders. A background thread creates and initialises encoders for the
+// registered profiles; Acquire() hands out a matching one and the thread
+// replaces it. A miss falls back to creating an encoder on the caller.
+class VideoEncoderPool {
+ public:
+  struct Profile {
+    VideoCodecBackend backend = VideoCodecBackend::kSoftware;
+    VideoCodecType type = VideoCodecType::kVcv;
+    // Size and keyframe interval must match on Acquire(); rates are applied
+    // with SetRates().
+    VideoEncoderConfig config;
+  };
+
+  struct Stats {
+    int warm_hits = 0;
+    int cold_starts = 0;
+    int initialised = 0;
+    int init_failures = 0;
+  };
+
+  explicit VideoEncoderPool(int encoders_per_profile = 1);
+  ~VideoEncoderPool();
+
+  // Starts keeping encoders_per_profile encoders ready for `profile`.
+  void Warm(const Profile& profile);
+  // Blocks until every registered profile is filled (or failed to fill).
+  void WaitUntilWarm();
+
+  // Returns an initialised encoder for `config`, or nullptr if the backend
+  // cannot provide one. The first frame from it should be a keyframe.
+  std::unique_ptr<VideoEncoder> Acquire(VideoCodecBackend backend,
+                                        VideoCodecType type,
+                                        const VideoEncoderConfig& config);
+
+  Stats GetStats() const;
+
+ private:
+  struct Entry {
+    Profile profile;
+    std::vector<std::unique_ptr<VideoEncoder>> idle;
+    bool failed = false;
+  };
+
+  static bool Matches(const Profile& p, VideoCodecBackend backend,
+                      VideoCodecType type, const VideoEncoderConfig& config);
+  Entry* FindDeficit();
+  void Run();
+
+  const int per_profile_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_;
+  std::condition_variable filled_;
+  std::vector<Entry> entries_;
+  Stats stats_;
+  bool busy_ = false;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_VIDEO_ENCODER_POOL_H_
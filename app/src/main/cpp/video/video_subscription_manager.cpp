@@ -0,0 +1,225 @@
+#include "video/video_subscription_manager.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+
+namespace vc {
+
+VideoSubscriptionManager::VideoSubscriptionManager(const Config& config)
+    : config_(config) {}
+
+void VideoSubscriptionManager::AddTrack(uint32_t track_id, int width,
+                                        int height, int simulcast_layers) {
+  Track& track = tracks_[track_id];
+  track.width = width;
+  track.height = height;
+  // The layer count comes off the wire; drop layers that would halve either
+  // side below one pixel, which no decoder accepts.
+  track.layers = 1;
+  while (track.layers < simulcast_layers && (width >> track.layers) > 0 &&
+         (height >> track.layers) > 0) {
+    ++track.layers;
+  }
+  // A visible track may now need a different layer.
+  if (track.shown) Apply(&track, 0);
+}
+
+void VideoSubscriptionManager::RemoveTrack(uint32_t track_id) {
+  auto it = tracks_.find(track_id);
+  if (it == tracks_.end()) return;
+  if (it->second.decoder) ReleaseDecoder(std::move(it->second.decoder));
+  tracks_.erase(it);
+}
+
+void VideoSubscriptionManager::SyncTracks(const SessionDescription& session,
+                                          const std::string& self) {
+  std::unordered_set<uint32_t> present;
+  for (const TrackDescription& t : session.tracks) {
+    const bool sending = t.direction == TrackDirection::kSendRecv ||
+                         t.direction == TrackDirection::kSendOnly;
+    if (t.kind != MediaKind::kVideo || !sending || t.muted || t.participant == self) {
+      continue;
+    }
+    present.insert(t.id);
+    AddTrack(t.id, t.width, t.height, t.simulcast_layers);
+  }
+  std::vector<uint32_t> gone;
+  for (const auto& [id, track] : tracks_) {
+    if (present.count(id) == 0) gone.push_back(id);
+  }
+  for (uint32_t id : gone) RemoveTrack(id);
+}
+
+void VideoSubscriptionManager::SetVisibleTiles(const TileVisibility* tiles,
+                                               size_t count, int64_t now_ms) {
+  for (auto& [id, track] : tracks_) {
+    track.tile_width = 0;
+    track.tile_height = 0;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    auto it = tracks_.find(tiles[i].track_id);
+    if (it == tracks_.end()) continue;
+    it->second.tile_width = tiles[i].width;
+    it->second.tile_height = tiles[i].height;
+  }
+  for (auto& [id, track] : tracks_) Apply(&track, now_ms);
+}
+
+void VideoSubscriptionManager::SetForeground(bool foreground, int64_t now_ms) {
+  if (foreground == foreground_) return;
+  foreground_ = foreground;
+  for (auto& [id, track] : tracks_) Apply(&track, now_ms);
+}
+
+void VideoSubscriptionManager::Update(int64_t now_ms,
+                                      std::vector<LayerRequest>* requests) {
+  for (auto& [id, track] : tracks_) {
+    if (!track.shown && track.decoder &&
+        now_ms - track.hidden_since_ms >= config_.decoder_linger_ms) {
+      ReleaseDecoder(std::move(track.decoder));
+    }
+    if (track.shown && !track.decoder) Apply(&track, now_ms);
+    if (!track.dirty) continue;
+    track.dirty = false;
+    requests->push_back(LayerRequest{
+        id, track.layer, track.layer != kPaused && track.need_keyframe});
+  }
+}
+
+bool VideoSubscriptionManager::OnFrame(uint32_t track_id, const uint8_t* data,
+                                       size_t size, bool keyframe,
+                                       int64_t timestamp_us, I420Frame* out) {
+  auto it = tracks_.find(track_id);
+  if (it == tracks_.end()) return false;
+  Track& track = it->second;
+  if (track.layer == kPaused || !track.decoder || (track.need_keyframe && !keyframe)) {
+    ++stats_.frames_dropped;
+    return false;
+  }
+  if (keyframe) track.need_keyframe = false;
+  if (!track.decoder->Decode(data, size, timestamp_us, out)) {
+    ++stats_.decode_failures;
+    // A delta frame without a usable reference; a keyframe that produced
+    // nothing yet may just be filling an asynchronous pipeline.
+    if (!keyframe) {
+      track.need_keyframe = true;
+      track.dirty = true;
+    }
+    return false;
+  }
+  ++stats_.frames_decoded;
+  return true;
+}
+
+int VideoSubscriptionManager::layer(uint32_t track_id) const {
+  auto it = tracks_.find(track_id);
+  return it == tracks_.end() ? kPaused : it->second.layer;
+}
+
+VideoSubscriptionManager::Stats VideoSubscriptionManager::GetStats() const {
+  Stats stats = stats_;
+  stats.tracks = static_cast<int>(tracks_.size());
+  stats.visible = 0;
+  stats.active_decoders = 0;
+  for (const auto& [id, track] : tracks_) {
+    if (track.shown) ++stats.visible;
+    if (track.decoder) ++stats.active_decoders;
+  }
+  stats.pooled_decoders = static_cast<int>(pool_.size());
+  return stats;
+}
+
+int VideoSubscriptionManager::ChooseLayer(const Track& track) const {
+  for (int i = 0; i < track.layers - 1; ++i) {
+    const int shift = track.layers - 1 - i;
+    if ((track.width >> shift) * config_.max_upscale >= track.tile_width &&
+        (track.height >> shift) * config_.max_upscale >= track.tile_height) {
+      return i;
+    }
+  }
+  return track.layers - 1;
+}
+
+void VideoSubscriptionManager::Apply(Track* track, int64_t now_ms) {
+  const bool shown = foreground_ && track->tile_width > 0 && track->tile_height > 0;
+  if (!shown) {
+    if (!track->shown) return;
+    track->shown = false;
+    track->hidden_since_ms = now_ms;
+    track->layer = kPaused;
+    track->dirty = true;
+    ++stats_.pauses;
+    return;
+  }
+  const int layer = ChooseLayer(*track);
+  if (track->shown && track->decoder && layer == track->layer) return;
+  if (!track->shown) {
+    track->shown = true;
+    ++stats_.resumes;
+  } else if (track->decoder) {
+    ++stats_.layer_switches;
+  }
+  if (!track->decoder) {
+    const int shift = track->layers - 1 - layer;
+    track->decoder = AcquireDecoder(track->width >> shift, track->height >> shift);
+    if (!track->decoder) {
+      // Nothing to decode with: keep the SFU paused and retry on Update.
+      if (track->layer != kPaused) {
+        track->layer = kPaused;
+        track->dirty = true;
+      }
+      return;
+    }
+  }
+  // Frames were dropped while paused, and a new layer starts with a
+  // keyframe, so either way the decoder needs one.
+  track->layer = layer;
+  track->need_keyframe = true;
+  track->dirty = true;
+}
+
+std::unique_ptr<VideoDecoder> VideoSubscriptionManager::AcquireDecoder(
+    int width, int height) {
+  while (!pool_.empty()) {
+    std::unique_ptr<VideoDecoder> decoder = std::move(pool_.back());
+    pool_.pop_back();
+    if (decoder->Init(width, height)) {
+      ++stats_.decoders_reused;
+      return decoder;
+    }
+    ++stats_.decoders_destroyed;
+  }
+  // With the pool empty, take the decoder that has lingered longest rather
+  // than hold one more; while scrolling, tiles leaving the screen feed the
+  // ones appearing.
+  Track* oldest = nullptr;
+  for (auto& [id, track] : tracks_) {
+    if (track.shown || !track.decoder) continue;
+    if (!oldest || track.hidden_since_ms < oldest->hidden_since_ms) oldest = &track;
+  }
+  if (oldest) {
+    std::unique_ptr<VideoDecoder> decoder = std::move(oldest->decoder);
+    if (decoder->Init(width, height)) {
+      ++stats_.decoders_reused;
+      return decoder;
+    }
+    ++stats_.decoders_destroyed;
+  }
+  std::unique_ptr<VideoDecoder> decoder =
+      CreateVideoDecoder(config_.backend, config_.type);
+  if (!decoder || !decoder->Init(width, height)) return nullptr;
+  ++stats_.decoders_created;
+  return decoder;
+}
+
+void VideoSubscriptionManager::ReleaseDecoder(
+    std::unique_ptr<VideoDecoder> decoder) {
+  if (static_cast<int>(pool_.size()) < config_.pooled_decoders) {
+    pool_.push_back(std::move(decoder));
+  } else {
+    ++stats_.decoders_destroyed;
+  }
+}
+
+}  // namespace vc
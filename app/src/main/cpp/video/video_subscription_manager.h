@@ -0,0 +1,150 @@
+#ifndef VCMEDIA_VIDEO_VIDEO_SUBSCRIPTION_MANAGER_H_
+#define VCMEDIA_VIDEO_VIDEO_SUBSCRIPTION_MANAGER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "signaling/session_protocol.h"
+#include "video/i420_frame.h"
+#include "video/video_codec.h"
+
+namespace vc {
+
+// A remote video tile as the UI draws it.
+struct TileVisibility {
+  uint32_t track_id = 0;
+  // Rendered size in pixels.
+  int width = 0;
+  int height = 0;
+};
+
+// What the SFU should forward on one track.
+struct LayerRequest {
+  uint32_t track_id = 0;
+  // Simulcast layer, 0 the smallest, or VideoSubscriptionManager::kPaused.
+  int layer = 0;
+  // The decoder has no usable reference: ask the sender for a keyframe.
+  bool keyframe = false;
+};
+
+// Receives remote video only for the tiles on screen. The UI reports the
+// visible tiles and their rendered size; everything else is hidden,
+// whether scrolled off, covered by a panel or the app is in the
+// background.
+//
+// A hidden track is paused at the SFU at once, and frames still in flight
+// are dropped undecoded. Its decoder lingers for a while, so scrolling back
+// and forth does not churn decoders, and is then returned to a small pool
+// of initialised decoders that the next tile to appear takes from; with the
+// pool empty, that tile takes the longest-lingering decoder instead. A
+// visible track gets the smallest simulcast layer that covers its tile
+// within `max_upscale`, so thumbnails cost a fraction of a full tile. A
+// resume or layer switch asks for a keyframe, and delta frames are dropped
+// until it arrives. A visible track that could not get a decoder stays
+// paused, and Update tries again.
+//
+// Layer i of an n-layer track is the track's resolution halved n - 1 - i
+// times; layers that would be under a pixel are ignored. Not thread-safe;
+// call from the receive thread.
+class VideoSubscriptionManager {
+ public:
+  static constexpr int kPaused = -1;
+
+  struct Config {
+    VideoCodecBackend backend = VideoCodecBackend::kSoftware;
+    VideoCodecType type = VideoCodecType::kVcv;
+    // A hidden track keeps its decoder this long.
+    int64_t decoder_linger_ms = 3000;
+    // Released decoders kept initialised; the rest are destroyed.
+    int pooled_decoders = 4;
+    // How far a layer may be scaled up to fill its tile.
+    float max_upscale = 1.25f;
+  };
+
+  struct Stats {
+    int tracks = 0;
+    int visible = 0;
+    // Decoders held by tracks, and idle in the pool.
+    int active_decoders = 0;
+    int pooled_decoders = 0;
+    int decoders_created = 0;
+    int decoders_reused = 0;
+    int decoders_destroyed = 0;
+    int64_t frames_decoded = 0;
+    // Frames of paused tracks and delta frames before a needed keyframe.
+    int64_t frames_dropped = 0;
+    int64_t decode_failures = 0;
+    int pauses = 0;
+    int resumes = 0;
+    int layer_switches = 0;
+  };
+
+  VideoSubscriptionManager() : VideoSubscriptionManager(Config()) {}
+  explicit VideoSubscriptionManager(const Config& config);
+
+  // Adds or updates a remote video track; `width` x `height` is its top
+  // layer. New tracks start hidden.
+  void AddTrack(uint32_t track_id, int width, int height, int simulcast_layers);
+  void RemoveTrack(uint32_t track_id);
+  // Makes the tracks match the session's video tracks that others send.
+  void SyncTracks(const SessionDescription& session, const std::string& self);
+
+  // The tiles now on screen; every other track is hidden. Tiles of unknown
+  // tracks are ignored.
+  void SetVisibleTiles(const TileVisibility* tiles, size_t count, int64_t now_ms);
+  // While the app is in the background every track is hidden; the last
+  // reported tiles come back with it.
+  void SetForeground(bool foreground, int64_t now_ms);
+
+  // Appends the subscription changes the SFU has not been sent yet,
+  // releases decoders that have lingered past `decoder_linger_ms` and
+  // retries visible tracks still without a decoder.
+  void Update(int64_t now_ms, std::vector<LayerRequest>* requests);
+
+  // A frame received on `track_id`. Returns true if it was decoded into
+  // `out`; frames of paused tracks, or delta frames while a keyframe is
+  // awaited, are dropped without decoding.
+  bool OnFrame(uint32_t track_id, const uint8_t* data, size_t size,
+               bool keyframe, int64_t timestamp_us, I420Frame* out);
+
+  // The layer requested for `track_id`, or kPaused (also for unknown tracks).
+  int layer(uint32_t track_id) const;
+  Stats GetStats() const;
+
+ private:
+  struct Track {
+    int width = 0;
+    int height = 0;
+    int layers = 1;
+    // Last reported tile, 0 x 0 if not reported.
+    int tile_width = 0;
+    int tile_height = 0;
+    bool shown = false;
+    int layer = kPaused;
+    int64_t hidden_since_ms = 0;
+    bool need_keyframe = true;
+    // `layer` (and `need_keyframe`) not yet sent.
+    bool dirty = false;
+    std::unique_ptr<VideoDecoder> decoder;
+  };
+
+  int ChooseLayer(const Track& track) const;
+  // Brings `track` in line with its tile and the foreground state.
+  void Apply(Track* track, int64_t now_ms);
+  std::unique_ptr<VideoDecoder> AcquireDecoder(int width, int height);
+  void ReleaseDecoder(std::unique_ptr<VideoDecoder> decoder);
+
+  const Config config_;
+  std::map<uint32_t, Track> tracks_;
+  std::vector<std::unique_ptr<VideoDecoder>> pool_;
+  bool foreground_ = true;
+  Stats stats_;
+};
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_VIDEO_SUBSCRIPTION_MANAGER_H_
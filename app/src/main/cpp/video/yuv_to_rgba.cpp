@@ -0,0 +1,126 @@
+#include "video/yuv_to_rgba.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace vc {
+
+namespace {
+
+// 1.164, 1.596, 0.391, 0.813 and 2.018 in units of 1/64. Sums stay within
+// int16 except where the result saturates above 255 anyway, so the SIMD
+// paths use saturating adds and match the scalar code exactly.
+constexpr int kYScale = 74;
+constexpr int kVToR = 102;
+constexpr int kUToG = 25;
+constexpr int kVToG = 52;
+constexpr int kUToB = 129;
+
+inline uint8_t Clamp255(int v) { return static_cast<uint8_t>(std::clamp(v, 0, 255)); }
+
+inline int SaturateInt16(int v) { return std::clamp(v, -32768, 32767); }
+
+}  // namespace
+
+void I420RowToRgba(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                   uint8_t* rgba, int width) {
+  int x = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i y_offset = _mm_set1_epi16(16);
+  const __m128i uv_offset = _mm_set1_epi16(128);
+  const __m128i round = _mm_set1_epi16(32);
+  const __m128i y_scale = _mm_set1_epi16(kYScale);
+  const __m128i v_to_r = _mm_set1_epi16(kVToR);
+  const __m128i u_to_g = _mm_set1_epi16(kUToG);
+  const __m128i v_to_g = _mm_set1_epi16(kVToG);
+  const __m128i u_to_b = _mm_set1_epi16(kUToB);
+  const __m128i alpha = _mm_set1_epi8(static_cast<char>(0xff));
+  for (; x + 16 <= width; x += 16) {
+    __m128i yy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+    __m128i uu = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2));
+    __m128i vv = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2));
+    // Each chroma sample covers two pixels.
+    uu = _mm_unpacklo_epi8(uu, uu);
+    vv = _mm_unpacklo_epi8(vv, vv);
+    __m128i out[3][2];
+    for (int half = 0; half < 2; ++half) {
+      __m128i c = half ? _mm_unpackhi_epi8(yy, zero) : _mm_unpacklo_epi8(yy, zero);
+      __m128i d = half ? _mm_unpackhi_epi8(uu, zero) : _mm_unpacklo_epi8(uu, zero);
+      __m128i e = half ? _mm_unpackhi_epi8(vv, zero) : _mm_unpacklo_epi8(vv, zero);
+      c = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(c, y_offset), y_scale), round);
+      d = _mm_sub_epi16(d, uv_offset);
+      e = _mm_sub_epi16(e, uv_offset);
+      __m128i r = _mm_adds_epi16(c, _mm_mullo_epi16(e, v_to_r));
+      __m128i g = _mm_subs_epi16(
+          _mm_subs_epi16(c, _mm_mullo_epi16(d, u_to_g)), _mm_mullo_epi16(e, v_to_g));
+      __m128i b = _mm_adds_epi16(c, _mm_mullo_epi16(d, u_to_b));
+      out[0][half] = _mm_srai_epi16(r, 6);
+      out[1][half] = _mm_srai_epi16(g, 6);
+      out[2][half] = _mm_srai_epi16(b, 6);
+    }
+    __m128i r = _mm_packus_epi16(out[0][0], out[0][1]);
+    __m128i g = _mm_packus_epi16(out[1][0], out[1][1]);
+    __m128i b = _mm_packus_epi16(out[2][0], out[2][1]);
+    __m128i rg_lo = _mm_unpacklo_epi8(r, g), rg_hi = _mm_unpackhi_epi8(r, g);
+    __m128i ba_lo = _mm_unpacklo_epi8(b, alpha), ba_hi = _mm_unpackhi_epi8(b, alpha);
+    __m128i* dst = reinterpret_cast<__m128i*>(rgba + 4 * x);
+    _mm_storeu_si128(dst, _mm_unpacklo_epi16(rg_lo, ba_lo));
+    _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(rg_lo, ba_lo));
+    _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(rg_hi, ba_hi));
+    _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(rg_hi, ba_hi));
+  }
+#elif defined(__ARM_NEON)
+  for (; x + 16 <= width; x += 16) {
+    uint8x16_t yy = vld1q_u8(y + x);
+    uint8x8x2_t uu = vzip_u8(vld1_u8(u + x / 2), vld1_u8(u + x / 2));
+    uint8x8x2_t vv = vzip_u8(vld1_u8(v + x / 2), vld1_u8(v + x / 2));
+    uint8x16x4_t pixels;
+    int16x8_t out[3][2];
+    for (int half = 0; half < 2; ++half) {
+      int16x8_t c = vreinterpretq_s16_u16(
+          vmovl_u8(half ? vget_high_u8(yy) : vget_low_u8(yy)));
+      int16x8_t d = vreinterpretq_s16_u16(vmovl_u8(uu.val[half]));
+      int16x8_t e = vreinterpretq_s16_u16(vmovl_u8(vv.val[half]));
+      c = vaddq_s16(vmulq_n_s16(vsubq_s16(c, vdupq_n_s16(16)), kYScale), vdupq_n_s16(32));
+      d = vsubq_s16(d, vdupq_n_s16(128));
+      e = vsubq_s16(e, vdupq_n_s16(128));
+      out[0][half] = vshrq_n_s16(vqaddq_s16(c, vmulq_n_s16(e, kVToR)), 6);
+      out[1][half] = vshrq_n_s16(
+          vqsubq_s16(vqsubq_s16(c, vmulq_n_s16(d, kUToG)), vmulq_n_s16(e, kVToG)), 6);
+      out[2][half] = vshrq_n_s16(vqaddq_s16(c, vmulq_n_s16(d, kUToB)), 6);
+    }
+    for (int k = 0; k < 3; ++k) {
+      pixels.val[k] = vcombine_u8(vqmovun_s16(out[k][0]), vqmovun_s16(out[k][1]));
+    }
+    pixels.val[3] = vdupq_n_u8(255);
+    vst4q_u8(rgba + 4 * x, pixels);
+  }
+#endif
+  for (; x < width; ++x) {
+    const int c = (y[x] - 16) * kYScale + 32;
+    const int d = u[x / 2] - 128;
+    const int e = v[x / 2] - 128;
+    uint8_t* px = rgba + 4 * x;
+    px[0] = Clamp255(SaturateInt16(c + kVToR * e) >> 6);
+    px[1] = Clamp255(SaturateInt16(SaturateInt16(c - kUToG * d) - kVToG * e) >> 6);
+    px[2] = Clamp255(SaturateInt16(c + kUToB * d) >> 6);
+    px[3] = 255;
+  }
+}
+
+void I420ToRgba(const I420Frame& frame, uint8_t* rgba, int stride) {
+  for (int row = 0; row < frame.height(); ++row) {
+    const size_t chroma = static_cast<size_t>(row / 2) * frame.stride_uv();
+    I420RowToRgba(frame.y() + static_cast<size_t>(row) * frame.stride_y(),
+                  frame.u() + chroma, frame.v() + chroma,
+                  rgba + static_cast<size_t>(row) * stride, frame.width());
+  }
+}
+
+}  // namespace vc
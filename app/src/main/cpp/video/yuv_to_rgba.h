@@ -0,0 +1,26 @@
+#ifndef VCMEDIA_VIDEO_YUV_TO_RGBA_H_
+#define VCMEDIA_VIDEO_YUV_TO_RGBA_H_
+
+#include <cstdint>
+
+#include "video/i420_frame.h"
+
+namespace vc {
+
+// BT.601 limited-range YUV (what cameras and the codecs produce) to RGBA8888
+// with opaque alpha, in 6-bit fixed point. Bytes are R, G, B, A in memory,
+// matching WINDOW_FORMAT_RGBA_8888. SSE2 / NEON with a scalar tail; all
+// paths give identical output.
+
+// One row: `u` and `v` hold ceil(width / 2) samples, each shared by two
+// horizontally adjacent pixels.
+void I420RowToRgba(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                   uint8_t* rgba, int width);
+
+// Whole frame into a buffer of frame.width() x frame.height() pixels;
+// `stride` is in bytes.
+void I420ToRgba(const I420Frame& frame, uint8_t* rgba, int stride);
+
+}  // namespace vc
+
+#endif  // VCMEDIA_VIDEO_YUV_TO_RGBA_H_
@@ -1,6 +1,5 @@
 package com.mobilecomputing.videoconferencingapp
 
-import android.content.Context
 import android.os.Bundle
 import androidx.activity.ComponentActivity
 import androidx.activity.compose.setContent
@@ -17,36 +16,102 @@ import androidx.compose.ui.platform.LocalContext
 import androidx.compose.ui.tooling.preview.Preview
 import androidx.compose.ui.unit.dp
 import androidx.compose.ui.unit.sp
-import androidx.credentials.CredentialManager
-import androidx.credentials.GetCredentialRequest
-import androidx.credentials.GetCredentialResponse
-import com.google.android.libraries.identity.googleid.GetGoogleIdOption
-import com.google.firebase.auth.FirebaseAuth
-import com.google.firebase.auth.GoogleAuthProvider
+import androidx.lifecycle.Lifecycle
+import androidx.lifecycle.compose.LifecycleStartEffect
+import androidx.lifecycle.compose.LocalLifecycleOwner
+import androidx.lifecycle.repeatOnLifecycle
+import com.mobilecomputing.videoconferencingapp.auth.AuthRepository
+import com.mobilecomputing.videoconferencingapp.auth.CachedSession
+import com.mobilecomputing.videoconferencingapp.auth.IdTokenRefresher
+import com.mobilecomputing.videoconferencingapp.auth.SignInException
+import com.mobilecomputing.videoconferencingapp.home.HomeSnapshot
+import com.mobilecomputing.videoconferencingapp.startup.StartupPath
+import com.mobilecomputing.videoconferencingapp.ui.meeting.MeetingHomeScreen
 import com.mobilecomputing.videoconferencingapp.ui.theme.VideoConferencingAppTheme
 import kotlinx.coroutines.launch
-import com.google.android.libraries.identity.googleid.GoogleIdTokenCredential
-import androidx.credentials.CustomCredential
-
 
 class MainActivity : ComponentActivity() {
     override fun onCreate(savedInstanceState: Bundle?) {
         super.onCreate(savedInstanceState)
         enableEdgeToEdge()
+        val app = application as VideoConferencingApplication
+        val sessionSource = app.sessionSource
+        val authRepository = app.authRepository
+        val homeRepository = app.homeRepository
+        // FirebaseAuth restores the persisted user synchronously, so a returning
+        // user goes straight to the meeting UI without a Credential Manager round trip.
+        val restored = sessionSource.restore()
+        // Start the home screen reads before the first frame.
+        restored?.let { homeRepository.prefetch(it) }
+        val startupPath = if (restored != null) StartupPath.CACHED_SESSION else StartupPath.COLD_SIGN_IN
         setContent {
+            var session by remember { mutableStateOf(restored) }
             VideoConferencingAppTheme {
                 Scaffold(modifier = Modifier.fillMaxSize()) { innerPadding ->
-                    GoogleSignInScreen(
-                        modifier = Modifier.padding(innerPadding)
-                    )
+                    val current = session
+                    if (current != null) {
+                        // Connected only while the activity is started.
+                        LifecycleStartEffect(current.uid) {
+                            app.realtime().start()
+                            onStopOrDispose { app.stopRealtime() }
+                        }
+                        LaunchedEffect(current.uid) {
+                            // In the lobby: have the call half set up before the user joins.
+                            app.prewarmCall()
+                            IdTokenRefresher(sessionSource, onSessionLost = {
+                                app.cancelCallPrewarm()
+                                app.closeRealtime()
+                                authRepository.signOut()
+                                session = null
+                            }).run()
+                        }
+                        val lifecycle = LocalLifecycleOwner.current.lifecycle
+                        val home by produceState<HomeSnapshot?>(null, current.uid) {
+                            // Again on every return to the screen; a stale snapshot is reloaded.
+                            lifecycle.repeatOnLifecycle(Lifecycle.State.STARTED) {
+                                value = homeRepository.prefetch(current).await()
+                            }
+                        }
+                        MeetingHomeScreen(
+                            session = current,
+                            home = home,
+                            onSignOut = {
+                                app.cancelCallPrewarm()
+                                app.closeRealtime()
+                                authRepository.signOut()
+                                session = null
+                            },
+                            modifier = Modifier.padding(innerPadding)
+                        )
+                    } else {
+                        GoogleSignInScreen(
+                            authRepository = authRepository,
+                            // Call setup overlaps the credential sheet and is dropped if sign-in fails.
+                            onSignInStarted = { app.prewarmCall() },
+                            onSignedIn = { session = it },
+                            onSignInFailed = { app.cancelCallPrewarm() },
+                            modifier = Modifier.padding(innerPadding)
+                        )
+                    }
                 }
             }
+            LaunchedEffect(Unit) {
+                withFrameNanos { }
+                app.startupTrace.markInteractive(startupPath)
+                app.initGraph.onFirstFrame()
+            }
         }
     }
 }
 
 @Composable
-fun GoogleSignInScreen(modifier: Modifier = Modifier) {
+fun GoogleSignInScreen(
+    authRepository: AuthRepository,
+    onSignedIn: (CachedSession) -> Unit,
+    modifier: Modifier = Modifier,
+    onSignInStarted: () -> Unit = {},
+    onSignInFailed: () -> Unit = {}
+) {
     var authStatus by remember { mutableStateOf<String?>(null) }
 
     Column(
@@ -75,8 +140,13 @@ fun GoogleSignInScreen(modifier: Modifier = Modifier) {
         Spacer(modifier = Modifier.height(24.dp))
 
         GoogleSignInButton(
-            onSignInSuccess = { message -> authStatus = message },
-            onSignInFailure = { error -> authStatus = error }
+            authRepository = authRepository,
+            onSignInStarted = onSignInStarted,
+            onSignInSuccess = onSignedIn,
+            onSignInFailure = { error ->
+                authStatus = error
+                onSignInFailed()
+            }
         )
 
         authStatus?.let { status ->
@@ -84,11 +154,7 @@ fun GoogleSignInScreen(modifier: Modifier = Modifier) {
             Text(
                 text = status,
                 style = MaterialTheme.typography.bodyLarge,
-                color = if (status.contains("Signed in")) {
-                    MaterialTheme.colorScheme.primary
-                } else {
-                    MaterialTheme.colorScheme.error
-                }
+                color = MaterialTheme.colorScheme.error
             )
         }
     }
@@ -96,43 +162,23 @@ fun GoogleSignInScreen(modifier: Modifier = Modifier) {
 
 @Composable
 fun GoogleSignInButton(
-    onSignInSuccess: (String) -> Unit,
-    onSignInFailure: (String) -> Unit
+    authRepository: AuthRepository,
+    onSignInSuccess: (CachedSession) -> Unit,
+    onSignInFailure: (String) -> Unit,
+    onSignInStarted: () -> Unit = {}
 ) {
     val context = LocalContext.current
-    val firebaseAuth = remember { FirebaseAuth.getInstance() }
-    val credentialManager = remember { CredentialManager.create(context) }
     val coroutineScope = rememberCoroutineScope()
 
-    suspend fun signInWithGoogle(
-        context: Context,
-        credentialManager: CredentialManager,
-        auth: FirebaseAuth,
-        onSignInSuccess: (String) -> Unit,
-        onSignInFailure: (String) -> Unit
-    ) {
-        val googleIdOption = GetGoogleIdOption.Builder()
-            .setFilterByAuthorizedAccounts(false)
-            .setServerClientId("GoogleWebClientID") // replace with your actual Google client ID
-            .setNonce(generateNonce())
-            .build()
-
-        val request = GetCredentialRequest.Builder()
-            .addCredentialOption(googleIdOption)
-            .build()
-
-        try {
-            val response = credentialManager.getCredential(context, request)
-            handleSignInResponse(response, auth, onSignInSuccess, onSignInFailure)
-        } catch (e: Exception) {
-            onSignInFailure("Sign-in failed: ${e.javaClass.simpleName} - ${e.localizedMessage}")
-        }
-    }
-
     Button(
         onClick = {
+            onSignInStarted()
             coroutineScope.launch {
-                signInWithGoogle(context, credentialManager, firebaseAuth, onSignInSuccess, onSignInFailure)
+                try {
+                    onSignInSuccess(authRepository.signInWithGoogle(context))
+                } catch (e: SignInException) {
+                    onSignInFailure(e.message.orEmpty())
+                }
             }
         },
         shape = RoundedCornerShape(8.dp),
@@ -165,62 +211,6 @@ fun GoogleSignInButton(
 //    }
 }
 
-private fun handleSignInResponse(
-    response: GetCredentialResponse,
-    auth: FirebaseAuth,
-    onSuccess: (String) -> Unit,
-    onFailure: (String) -> Unit
-) {
-    val credential = response.credential
-
-    when {
-        credential is CustomCredential &&
-                credential.type == "com.google.android.libraries.identity.googleid.TYPE_GOOGLE_ID_TOKEN_CREDENTIAL" -> {
-            try {
-                // Parse the received CustomCredential as a GoogleIdTokenCredential
-                val googleIdTokenCredential = GoogleIdTokenCredential.createFrom(credential.data)
-                val idToken = googleIdTokenCredential.idToken
-
-                // Use the token to authenticate with Firebase
-                val firebaseCredential = GoogleAuthProvider.getCredential(idToken, null)
-                auth.signInWithCredential(firebaseCredential)
-                    .addOnCompleteListener { task ->
-                        if (task.isSuccessful) {
-                            onSuccess("Signed in as ${auth.currentUser?.displayName}")
-                        } else {
-                            onFailure("Firebase auth failed: ${task.exception?.message}")
-                        }
-                    }
-            } catch (e: Exception) {
-                onFailure("Failed to process Google ID token: ${e.message}")
-            }
-        }
-        credential is GoogleIdTokenCredential -> {
-            // This is the original path for handling GoogleIdTokenCredential directly
-            val idToken = credential.idToken
-            val firebaseCredential = GoogleAuthProvider.getCredential(idToken, null)
-            auth.signInWithCredential(firebaseCredential)
-                .addOnCompleteListener { task ->
-                    if (task.isSuccessful) {
-                        onSuccess("Signed in as ${auth.currentUser?.displayName}")
-                    } else {
-                        onFailure("Firebase auth failed: ${task.exception?.message}")
-                    }
-                }
-        }
-        else -> {
-            onFailure("Unexpected credential type: ${credential.javaClass.simpleName}")
-        }
-    }
-}
-
-
-private fun generateNonce(): String {
-    val bytes = ByteArray(16)
-    java.security.SecureRandom().nextBytes(bytes)
-    return bytes.joinToString("") { "%02x".format(it) }
-}
-
 //@Preview(showBackground = true)
 //@Composable
 //fun PreviewGoogleSignInScreen() {
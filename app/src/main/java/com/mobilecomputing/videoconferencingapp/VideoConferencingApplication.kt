@@ -0,0 +1,170 @@
+package com.mobilecomputing.videoconferencingapp
+
+import android.app.Application
+import android.media.MediaCodecList
+import android.util.Log
+import androidx.credentials.CredentialManager
+import com.google.firebase.auth.FirebaseAuth
+import com.google.firebase.firestore.FirebaseFirestore
+import com.google.firebase.storage.FirebaseStorage
+import com.mobilecomputing.videoconferencingapp.auth.AuthRepository
+import com.mobilecomputing.videoconferencingapp.auth.FirebaseSessionSource
+import com.mobilecomputing.videoconferencingapp.auth.SessionSource
+import com.mobilecomputing.videoconferencingapp.call.CallPrewarmer
+import com.mobilecomputing.videoconferencingapp.call.EncoderWarmup
+import com.mobilecomputing.videoconferencingapp.call.GatheredCandidates
+import com.mobilecomputing.videoconferencingapp.call.LineSignalingConnection
+import com.mobilecomputing.videoconferencingapp.call.MediaCodecEncoderWarmup
+import com.mobilecomputing.videoconferencingapp.call.SignalingConfig
+import com.mobilecomputing.videoconferencingapp.call.SignalingConnection
+import com.mobilecomputing.videoconferencingapp.call.gatherCandidates
+import com.mobilecomputing.videoconferencingapp.home.DeferredHomeDataSource
+import com.mobilecomputing.videoconferencingapp.home.FirebaseHomeDataSource
+import com.mobilecomputing.videoconferencingapp.home.HomeDataSource
+import com.mobilecomputing.videoconferencingapp.home.HomeRepository
+import com.mobilecomputing.videoconferencingapp.realtime.FrameTransport
+import com.mobilecomputing.videoconferencingapp.realtime.RealtimeConnection
+import com.mobilecomputing.videoconferencingapp.realtime.SocketFrameTransport
+import com.mobilecomputing.videoconferencingapp.room.FirestoreRoomStateSource
+import com.mobilecomputing.videoconferencingapp.room.RoomStateSource
+import com.mobilecomputing.videoconferencingapp.room.RoomStateStore
+import com.mobilecomputing.videoconferencingapp.startup.Component
+import com.mobilecomputing.videoconferencingapp.startup.InitGraph
+import com.mobilecomputing.videoconferencingapp.startup.InitPhase
+import com.mobilecomputing.videoconferencingapp.startup.StartupTrace
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.MainScope
+import kotlinx.coroutines.plus
+import kotlinx.coroutines.withContext
+import java.net.InetSocketAddress
+
+open class VideoConferencingApplication : Application() {
+    lateinit var startupTrace: StartupTrace
+        private set
+
+    /** Outlives activities, so a prefetch survives configuration changes. */
+    private val appScope = MainScope()
+
+    // Only the session is needed for the first frame; see MainActivity.
+    val session = Component("session", InitPhase.MAIN) { createSessionSource() }
+    val homeData = Component("homeData", InitPhase.BACKGROUND) { createHomeDataSource() }
+    val credentials = Component("credentialManager", InitPhase.AFTER_FIRST_FRAME) {
+        CredentialManager.create(this)
+    }
+    val mediaEngine = Component("mediaEngine", InitPhase.AFTER_FIRST_FRAME) { loadMediaEngine() }
+    val codecList = Component("codecList", InitPhase.AFTER_FIRST_FRAME) {
+        // The first query parses the device's codec XML; keep that off the join path.
+        MediaCodecList(MediaCodecList.REGULAR_CODECS).codecInfos.size
+    }
+
+    val initGraph = InitGraph(
+        listOf(session, homeData, credentials, mediaEngine, codecList),
+        appScope,
+        onTiming = { timing ->
+            val status = timing.error?.let { " failed: $it" }.orEmpty()
+            Log.i(TAG, "init ${timing.name} (${timing.phase}) at ${timing.startMillis} ms " +
+                    "took ${timing.durationMillis} ms$status")
+        }
+    )
+
+    val sessionSource: SessionSource get() = initGraph.get(session)
+
+    val homeRepository: HomeRepository by lazy {
+        HomeRepository(DeferredHomeDataSource { initGraph.await(homeData) }, appScope)
+    }
+
+    val authRepository: AuthRepository by lazy {
+        AuthRepository(sessionSource, homeRepository, credentialManager = { initGraph.await(credentials) })
+    }
+
+    open val signalingConfig = SignalingConfig()
+
+    val callPrewarmer: CallPrewarmer by lazy {
+        CallPrewarmer(
+            // Sockets, interface enumeration and encoder creation all block.
+            appScope + Dispatchers.IO,
+            mediaEngine = { initGraph.await(mediaEngine) },
+            connect = { openSignaling() },
+            gather = { gatherCallCandidates() },
+            encoders = createEncoderWarmup()
+        )
+    }
+
+    private var callSetup: CallPrewarmer.CallSetup? = null
+
+    /**
+     * Starts (or keeps) speculative call setup; called when sign-in starts and in the lobby.
+     * A setup that released itself, e.g. after sitting idle, is replaced. Main thread.
+     */
+    fun prewarmCall(): CallPrewarmer.CallSetup =
+        callSetup?.takeUnless { it.isReleased } ?: callPrewarmer.start().also { callSetup = it }
+
+    /** Drops speculative call setup, e.g. when sign-in fails. Main thread. */
+    fun cancelCallPrewarm() {
+        callSetup?.cancel()
+        callSetup = null
+    }
+
+    private var realtimeConnection: RealtimeConnection? = null
+
+    /** The signed-in user's connection to the realtime server, created on first use. Main thread. */
+    fun realtime(): RealtimeConnection = realtimeConnection ?: RealtimeConnection(
+        appScope,
+        connect = { openRealtimeTransport() },
+        idToken = { sessionSource.idToken(forceRefresh = false).token }
+    ).also { realtimeConnection = it }
+
+    /**
+     * Disconnects while no activity is started; the connection would
+     * otherwise keep reconnecting in the background. Main thread.
+     */
+    fun stopRealtime() {
+        realtimeConnection?.stop()
+    }
+
+    /** Disconnects on sign-out; the next [realtime] connects as whoever is signed in then. Main thread. */
+    fun closeRealtime() {
+        realtimeConnection?.close()
+        realtimeConnection = null
+    }
+
+    val roomStateSource: RoomStateSource by lazy { createRoomStateSource() }
+
+    /** Membership of [roomId] for the call screen; [RoomStateStore.close] it on leaving. */
+    fun roomState(roomId: String): RoomStateStore = RoomStateStore(roomStateSource, appScope, roomId)
+
+    override fun onCreate() {
+        startupTrace = StartupTrace()
+        super.onCreate()
+        initGraph.start()
+    }
+
+    protected open fun createSessionSource(): SessionSource = FirebaseSessionSource(FirebaseAuth.getInstance())
+
+    protected open fun createHomeDataSource(): HomeDataSource =
+        FirebaseHomeDataSource(FirebaseFirestore.getInstance(), FirebaseStorage.getInstance())
+
+    protected open fun createRoomStateSource(): RoomStateSource =
+        FirestoreRoomStateSource(FirebaseFirestore.getInstance())
+
+    protected open fun loadMediaEngine() = System.loadLibrary("vcmedia")
+
+    protected open suspend fun openSignaling(): SignalingConnection =
+        LineSignalingConnection.open(signalingConfig.host, signalingConfig.port)
+
+    protected open suspend fun openRealtimeTransport(): FrameTransport =
+        SocketFrameTransport.connect(signalingConfig.host, signalingConfig.realtimePort)
+
+    protected open suspend fun gatherCallCandidates(): GatheredCandidates {
+        val stun = withContext(Dispatchers.IO) {
+            InetSocketAddress(signalingConfig.stunHost, signalingConfig.stunPort).takeUnless { it.isUnresolved }
+        }
+        return gatherCandidates(stun)
+    }
+
+    protected open fun createEncoderWarmup(): EncoderWarmup = MediaCodecEncoderWarmup()
+
+    private companion object {
+        const val TAG = "Startup"
+    }
+}
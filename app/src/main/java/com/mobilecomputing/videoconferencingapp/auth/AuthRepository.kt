@@ -0,0 +1,83 @@
+package com.mobilecomputing.videoconferencingapp.auth
+
+import android.content.Context
+import androidx.credentials.Credential
+import androidx.credentials.CredentialManager
+import androidx.credentials.CustomCredential
+import androidx.credentials.GetCredentialRequest
+import com.google.android.libraries.identity.googleid.GetGoogleIdOption
+import com.google.android.libraries.identity.googleid.GoogleIdTokenCredential
+import com.mobilecomputing.videoconferencingapp.home.HomeRepository
+import kotlinx.coroutines.CancellationException
+
+/** Sign-in could not produce a Firebase session; [message] is shown to the user. */
+class SignInException(message: String, cause: Throwable? = null) : Exception(message, cause)
+
+/**
+ * Google sign-in as one suspend call: the Credential Manager sheet, the
+ * Google ID token, then Firebase. The home screen prefetch starts the moment
+ * Firebase returns, before the UI has reacted to the new session.
+ */
+class AuthRepository(
+    private val sessionSource: SessionSource,
+    private val home: HomeRepository,
+    private val credentialManager: suspend (Context) -> CredentialManager = { CredentialManager.create(it) },
+    private val serverClientId: String = "GoogleWebClientID" // replace with your actual Google client ID
+) {
+    suspend fun signInWithGoogle(context: Context): CachedSession {
+        val googleIdOption = GetGoogleIdOption.Builder()
+            .setFilterByAuthorizedAccounts(false)
+            .setServerClientId(serverClientId)
+            .setNonce(generateNonce())
+            .build()
+
+        val request = GetCredentialRequest.Builder()
+            .addCredentialOption(googleIdOption)
+            .build()
+
+        val response = try {
+            credentialManager(context).getCredential(context, request)
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            throw SignInException("Sign-in failed: ${e.javaClass.simpleName} - ${e.localizedMessage}", e)
+        }
+        val session = try {
+            sessionSource.signInWithGoogleIdToken(googleIdToken(response.credential))
+        } catch (e: SignInException) {
+            throw e
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            throw SignInException("Firebase auth failed: ${e.message}", e)
+        }
+        home.prefetch(session)
+        return session
+    }
+
+    fun signOut() {
+        home.clear()
+        sessionSource.signOut()
+    }
+}
+
+/** The Google ID token carried by a Credential Manager response. */
+internal fun googleIdToken(credential: Credential): String =
+    when {
+        credential is GoogleIdTokenCredential -> credential.idToken
+        credential is CustomCredential &&
+                credential.type == GoogleIdTokenCredential.TYPE_GOOGLE_ID_TOKEN_CREDENTIAL -> {
+            try {
+                GoogleIdTokenCredential.createFrom(credential.data).idToken
+            } catch (e: Exception) {
+                throw SignInException("Failed to process Google ID token: ${e.message}", e)
+            }
+        }
+        else -> throw SignInException("Unexpected credential type: ${credential.javaClass.simpleName}")
+    }
+
+private fun generateNonce(): String {
+    val bytes = ByteArray(16)
+    java.security.SecureRandom().nextBytes(bytes)
+    return bytes.joinToString("") { "%02x".format(it) }
+}
@@ -0,0 +1,37 @@
+package com.mobilecomputing.videoconferencingapp.auth
+
+import com.google.firebase.auth.FirebaseAuth
+import com.google.firebase.auth.FirebaseAuthInvalidUserException
+import com.google.firebase.auth.FirebaseUser
+import com.google.firebase.auth.GoogleAuthProvider
+import kotlinx.coroutines.tasks.await
+
+/**
+ * [SessionSource] backed by FirebaseAuth, which loads the persisted user
+ * synchronously when the instance is created.
+ */
+class FirebaseSessionSource(private val auth: FirebaseAuth) : SessionSource {
+
+    override fun restore(): CachedSession? = auth.currentUser?.toSession()
+
+    override suspend fun signInWithGoogleIdToken(idToken: String): CachedSession {
+        val result = auth.signInWithCredential(GoogleAuthProvider.getCredential(idToken, null)).await()
+        val user = result.user ?: throw IllegalStateException("Firebase returned no user")
+        return user.toSession()
+    }
+
+    override suspend fun idToken(forceRefresh: Boolean): IdToken {
+        val user = auth.currentUser ?: throw SessionLostException("No signed-in user")
+        val result = try {
+            user.getIdToken(forceRefresh).await()
+        } catch (e: FirebaseAuthInvalidUserException) {
+            throw SessionLostException("Session revoked: ${e.errorCode}", e)
+        }
+        // expirationTimestamp is in seconds.
+        return IdToken(result.token.orEmpty(), result.expirationTimestamp * 1000)
+    }
+
+    override fun signOut() = auth.signOut()
+
+    private fun FirebaseUser.toSession() = CachedSession(uid = uid, displayName = displayName)
+}
@@ -0,0 +1,53 @@
+package com.mobilecomputing.videoconferencingapp.auth
+
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.delay
+
+/**
+ * Keeps the ID token of a restored session fresh: refreshes it [refreshMarginMillis]
+ * before it expires, retrying transient failures with exponential backoff, so
+ * whatever the meeting UI connects to next never sees an expired token.
+ * Tokens that live no longer than the margin, or look expired because the
+ * clock is off, are refreshed halfway through their remaining lifetime and
+ * never more often than every [minRefreshIntervalMillis].
+ * [onSessionLost] is called once if the session cannot be refreshed any more.
+ */
+class IdTokenRefresher(
+    private val source: SessionSource,
+    private val onSessionLost: () -> Unit,
+    private val nowMillis: () -> Long = System::currentTimeMillis,
+    private val refreshMarginMillis: Long = 5 * 60_000L,
+    private val minRefreshIntervalMillis: Long = 30_000L,
+    private val initialRetryMillis: Long = 15_000L,
+    private val maxRetryMillis: Long = 5 * 60_000L
+) {
+    /** Number of successful forced refreshes. */
+    var refreshes = 0
+        private set
+
+    /** Runs until cancelled or the session is lost. */
+    suspend fun run() {
+        // The first read takes the cached token if it is still valid.
+        var forceRefresh = false
+        var retryMillis = initialRetryMillis
+        while (true) {
+            val token = try {
+                source.idToken(forceRefresh)
+            } catch (e: SessionLostException) {
+                onSessionLost()
+                return
+            } catch (e: CancellationException) {
+                throw e
+            } catch (e: Exception) {
+                delay(retryMillis)
+                retryMillis = (retryMillis * 2).coerceAtMost(maxRetryMillis)
+                continue
+            }
+            if (forceRefresh) ++refreshes
+            forceRefresh = true
+            retryMillis = initialRetryMillis
+            val remaining = token.expiresAtMillis - nowMillis()
+            delay(maxOf(remaining - refreshMarginMillis, remaining / 2, minRefreshIntervalMillis))
+        }
+    }
+}
@@ -0,0 +1,36 @@
+package com.mobilecomputing.videoconferencingapp.auth
+
+/** The signed-in user as persisted on the device. */
+data class CachedSession(
+    val uid: String,
+    val displayName: String?
+)
+
+/** A Firebase ID token and when it stops being accepted. */
+data class IdToken(
+    val token: String,
+    val expiresAtMillis: Long
+)
+
+/** The persisted session is gone for good (user deleted, disabled or signed out elsewhere). */
+class SessionLostException(message: String, cause: Throwable? = null) : Exception(message, cause)
+
+/**
+ * Where the app gets its signed-in session from. Kept behind an interface so
+ * startup can be exercised without Firebase.
+ */
+interface SessionSource {
+    /** The session restored from disk, without any network round trip, or null. */
+    fun restore(): CachedSession?
+
+    /** Signs in to Firebase with a Google ID token from Credential Manager. */
+    suspend fun signInWithGoogleIdToken(idToken: String): CachedSession
+
+    /**
+     * The current ID token; [forceRefresh] mints a new one from the backend.
+     * Throws [SessionLostException] when the session can no longer be refreshed.
+     */
+    suspend fun idToken(forceRefresh: Boolean): IdToken
+
+    fun signOut()
+}
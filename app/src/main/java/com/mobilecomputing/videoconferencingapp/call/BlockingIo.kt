@@ -0,0 +1,22 @@
+package com.mobilecomputing.videoconferencingapp.call
+
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.coroutineScope
+import java.io.Closeable
+
+/**
+ * Runs blocking socket IO on Dispatchers.IO. Socket calls do not respond to
+ * coroutine cancellation, so cancelling the caller closes [resource], which
+ * unblocks them.
+ */
+internal suspend fun <T> blockingIo(resource: Closeable, block: () -> T): T = coroutineScope {
+    val io = async(Dispatchers.IO) { block() }
+    try {
+        io.await()
+    } catch (e: CancellationException) {
+        resource.close()
+        throw e
+    }
+}
@@ -0,0 +1,127 @@
+package com.mobilecomputing.videoconferencingapp.call
+
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.async
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import java.io.Closeable
+import java.util.concurrent.ConcurrentHashMap
+
+/** A joined call; owns the connection, socket and encoder set up for it. */
+class ActiveCall(
+    val callId: String,
+    val connection: SignalingConnection,
+    val candidates: GatheredCandidates,
+    val encoder: Closeable
+) : Closeable {
+    override fun close() {
+        connection.close()
+        candidates.close()
+        encoder.close()
+    }
+}
+
+/**
+ * Starts the parts of joining a call that do not need a signed-in user —
+ * media engine, signaling connection, candidate gathering and encoder —
+ * all at once, so they overlap the Credential Manager sheet or the time
+ * spent in the lobby. A cold join uses the same path, started at join time.
+ */
+class CallPrewarmer(
+    private val scope: CoroutineScope,
+    private val mediaEngine: suspend () -> Unit,
+    private val connect: suspend () -> SignalingConnection,
+    private val gather: suspend () -> GatheredCandidates,
+    private val encoders: EncoderWarmup,
+    /** An unused setup is released after this long. */
+    private val idleTimeoutMillis: Long = 2 * 60_000L,
+    private val nowMillis: () -> Long = { System.nanoTime() / 1_000_000 }
+) {
+    fun start(): CallSetup = CallSetup()
+
+    /** Setup work in flight or done. Either [join] it or [cancel] it. */
+    inner class CallSetup internal constructor() {
+        private val job = SupervisorJob(scope.coroutineContext[Job])
+        private val setupScope = CoroutineScope(scope.coroutineContext + job)
+        private val lock = Any()
+        private val resources = mutableListOf<Closeable>()
+        private var released = false
+        private var joined = false
+        private val stepMillis = ConcurrentHashMap<String, Long>()
+
+        /** Milliseconds each step took, by name, once it has finished. */
+        val timings: Map<String, Long> get() = stepMillis
+
+        /** True once cancelled, failed or timed out idle; such a setup can no longer be joined. */
+        val isReleased: Boolean get() = synchronized(lock) { released }
+
+        private val engine = setupScope.async { step("mediaEngine") { mediaEngine() } }
+        private val connection = prepare("signaling") { connect() }
+        private val candidates = prepare("candidates") { gather() }
+        private val encoder = prepare("encoder") { encoders.warm() }
+
+        init {
+            setupScope.launch {
+                delay(idleTimeoutMillis)
+                cancel()
+            }
+        }
+
+        /** Finishes setup, authenticates and joins. On failure the setup is released. */
+        suspend fun join(roomId: String, idToken: String): ActiveCall {
+            try {
+                engine.await()
+                val connection = connection.await()
+                connection.authenticate(idToken)
+                val candidates = candidates.await()
+                val encoder = encoder.await()
+                val callId = connection.join(roomId, candidates.candidates)
+                synchronized(lock) {
+                    check(!released) { "Call setup was cancelled" }
+                    joined = true
+                    resources.clear()
+                }
+                job.cancel()
+                return ActiveCall(callId, connection, candidates, encoder)
+            } catch (e: Throwable) {
+                cancel()
+                throw e
+            }
+        }
+
+        /** Stops any step still running and releases what was set up; no-op after [join]. */
+        fun cancel() {
+            val toClose = synchronized(lock) {
+                if (joined || released) return
+                released = true
+                resources.toList().also { resources.clear() }
+            }
+            job.cancel()
+            toClose.forEach { it.close() }
+        }
+
+        private fun <T : Closeable> prepare(name: String, create: suspend () -> T): Deferred<T> =
+            setupScope.async {
+                val value = step(name) { create() }
+                val keep = synchronized(lock) { (!released).also { if (it) resources += value } }
+                // Finished after cancel(): nobody else will close it.
+                if (!keep) value.close()
+                value
+            }
+
+        /** Runs and times one step; if it fails the join cannot succeed, so everything is released now. */
+        private suspend fun <T> step(name: String, block: suspend () -> T): T {
+            val begin = nowMillis()
+            try {
+                return block().also { stepMillis[name] = nowMillis() - begin }
+            } catch (e: Throwable) {
+                if (e !is CancellationException) cancel()
+                throw e
+            }
+        }
+    }
+}
@@ -0,0 +1,138 @@
+package com.mobilecomputing.videoconferencingapp.call
+
+import java.io.Closeable
+import java.net.DatagramPacket
+import java.net.DatagramSocket
+import java.net.Inet4Address
+import java.net.Inet6Address
+import java.net.InetAddress
+import java.net.InetSocketAddress
+import java.net.NetworkInterface
+import java.net.SocketTimeoutException
+import java.nio.ByteBuffer
+import java.security.SecureRandom
+
+data class IceCandidate(val type: Type, val address: InetAddress, val port: Int) {
+    enum class Type(val sdpName: String) {
+        HOST("host"),
+        SERVER_REFLEXIVE("srflx")
+    }
+
+    override fun toString() = "${type.sdpName} ${address.hostAddress} $port"
+}
+
+/** Candidates for one UDP socket, which stays open for the call that uses them. */
+class GatheredCandidates(
+    val socket: DatagramSocket,
+    val candidates: List<IceCandidate>
+) : Closeable {
+    override fun close() = socket.close()
+}
+
+/**
+ * Binds a UDP socket and collects its host candidates (interface addresses)
+ * and, when [stunServer] is given, its server-reflexive address from a STUN
+ * binding request. STUN failures leave only the host candidates.
+ */
+suspend fun gatherCandidates(
+    stunServer: InetSocketAddress?,
+    includeLoopback: Boolean = false,
+    timeoutMillis: Int = 500,
+    attempts: Int = 2
+): GatheredCandidates {
+    val socket = DatagramSocket()
+    try {
+        val port = socket.localPort
+        val candidates = hostAddresses(includeLoopback).map { IceCandidate(IceCandidate.Type.HOST, it, port) }.toMutableList()
+        if (stunServer != null) {
+            val mapped = blockingIo(socket) { stunBinding(socket, stunServer, timeoutMillis, attempts) }
+            if (mapped != null) {
+                candidates += IceCandidate(IceCandidate.Type.SERVER_REFLEXIVE, mapped.address, mapped.port)
+            }
+        }
+        return GatheredCandidates(socket, candidates)
+    } catch (e: Throwable) {
+        socket.close()
+        throw e
+    }
+}
+
+private fun hostAddresses(includeLoopback: Boolean): List<InetAddress> =
+    NetworkInterface.getNetworkInterfaces().toList()
+        .filter { it.isUp && (includeLoopback || !it.isLoopback) }
+        .flatMap { it.inetAddresses.toList() }
+        .filter { !it.isLinkLocalAddress && (includeLoopback || !it.isLoopbackAddress) }
+
+private const val STUN_BINDING_REQUEST = 0x0001
+private const val STUN_BINDING_SUCCESS = 0x0101
+private const val STUN_MAGIC_COOKIE = 0x2112A442
+private const val STUN_MAPPED_ADDRESS = 0x0001
+private const val STUN_XOR_MAPPED_ADDRESS = 0x0020
+
+/** RFC 5389 binding request; the mapped address, or null on timeout or a bad reply. */
+internal fun stunBinding(
+    socket: DatagramSocket,
+    server: InetSocketAddress,
+    timeoutMillis: Int,
+    attempts: Int
+): InetSocketAddress? {
+    val transaction = ByteArray(12).also { SecureRandom().nextBytes(it) }
+    val request = ByteBuffer.allocate(20)
+        .putShort(STUN_BINDING_REQUEST.toShort())
+        .putShort(0)
+        .putInt(STUN_MAGIC_COOKIE)
+        .put(transaction)
+        .array()
+    val buffer = ByteArray(512)
+    socket.soTimeout = timeoutMillis
+    repeat(attempts) {
+        socket.send(DatagramPacket(request, request.size, server))
+        val reply = DatagramPacket(buffer, buffer.size)
+        try {
+            socket.receive(reply)
+        } catch (e: SocketTimeoutException) {
+            return@repeat
+        }
+        parseBindingResponse(ByteBuffer.wrap(buffer, 0, reply.length), transaction)?.let { return it }
+    }
+    return null
+}
+
+private fun parseBindingResponse(data: ByteBuffer, transaction: ByteArray): InetSocketAddress? {
+    if (data.remaining() < 20) return null
+    val type = data.short.toInt() and 0xffff
+    val length = data.short.toInt() and 0xffff
+    if (type != STUN_BINDING_SUCCESS || data.int != STUN_MAGIC_COOKIE) return null
+    val id = ByteArray(12).also { data.get(it) }
+    if (!id.contentEquals(transaction) || data.remaining() < length) return null
+    var mapped: InetSocketAddress? = null
+    while (data.remaining() >= 4) {
+        val attribute = data.short.toInt() and 0xffff
+        val size = data.short.toInt() and 0xffff
+        if (data.remaining() < size) return null
+        val value = ByteArray(size).also { data.get(it) }
+        // Attributes are padded to four bytes.
+        data.position(minOf(data.limit(), data.position() + (4 - size % 4) % 4))
+        when (attribute) {
+            STUN_XOR_MAPPED_ADDRESS -> return decodeAddress(value, xor = true, transaction)
+            STUN_MAPPED_ADDRESS -> mapped = decodeAddress(value, xor = false, transaction)
+        }
+    }
+    return mapped
+}
+
+private fun decodeAddress(value: ByteArray, xor: Boolean, transaction: ByteArray): InetSocketAddress? {
+    if (value.size < 8) return null
+    val family = value[1].toInt()
+    var port = ((value[2].toInt() and 0xff) shl 8) or (value[3].toInt() and 0xff)
+    val address = value.copyOfRange(4, value.size)
+    if ((family == 1 && address.size != 4) || (family == 2 && address.size != 16)) return null
+    if (xor) {
+        port = port xor (STUN_MAGIC_COOKIE ushr 16)
+        val key = ByteBuffer.allocate(16).putInt(STUN_MAGIC_COOKIE).put(transaction).array()
+        for (i in address.indices) address[i] = (address[i].toInt() xor key[i].toInt()).toByte()
+    }
+    val inet = InetAddress.getByAddress(address)
+    if (inet !is Inet4Address && inet !is Inet6Address) return null
+    return InetSocketAddress(inet, port)
+}
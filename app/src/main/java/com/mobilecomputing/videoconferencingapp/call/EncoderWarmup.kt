@@ -0,0 +1,42 @@
+package com.mobilecomputing.videoconferencingapp.call
+
+import android.media.MediaCodec
+import android.media.MediaCodecInfo
+import android.media.MediaFormat
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+import java.io.Closeable
+
+/** Brings up a video encoder ahead of the call; closing the result releases it. */
+fun interface EncoderWarmup {
+    suspend fun warm(): Closeable
+}
+
+/**
+ * Creates and configures a hardware AVC encoder for the first send layer.
+ * Codec allocation and configuration take tens of milliseconds and would
+ * otherwise sit on the join path.
+ */
+class MediaCodecEncoderWarmup(
+    private val width: Int = 640,
+    private val height: Int = 360,
+    private val bitrate: Int = 800_000,
+    private val frameRate: Int = 30
+) : EncoderWarmup {
+    override suspend fun warm(): Closeable = withContext(Dispatchers.IO) {
+        val codec = MediaCodec.createEncoderByType(MediaFormat.MIMETYPE_VIDEO_AVC)
+        try {
+            val format = MediaFormat.createVideoFormat(MediaFormat.MIMETYPE_VIDEO_AVC, width, height).apply {
+                setInteger(MediaFormat.KEY_COLOR_FORMAT, MediaCodecInfo.CodecCapabilities.COLOR_FormatYUV420Flexible)
+                setInteger(MediaFormat.KEY_BIT_RATE, bitrate)
+                setInteger(MediaFormat.KEY_FRAME_RATE, frameRate)
+                setInteger(MediaFormat.KEY_I_FRAME_INTERVAL, 2)
+            }
+            codec.configure(format, null, null, MediaCodec.CONFIGURE_FLAG_ENCODE)
+        } catch (e: Exception) {
+            codec.release()
+            throw e
+        }
+        Closeable { codec.release() }
+    }
+}
@@ -0,0 +1,11 @@
+package com.mobilecomputing.videoconferencingapp.call
+
+/** Where calls are set up. */
+data class SignalingConfig(
+    val host: String = "signaling.example.com", // replace with your signaling server
+    val port: Int = 7443,
+    /** Persistent connection for presence, chat, reactions and in-call signaling. */
+    val realtimePort: Int = 7444,
+    val stunHost: String = "stun.l.google.com",
+    val stunPort: Int = 19302
+)
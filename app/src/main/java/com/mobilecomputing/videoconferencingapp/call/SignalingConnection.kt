@@ -0,0 +1,67 @@
+package com.mobilecomputing.videoconferencingapp.call
+
+import java.io.BufferedReader
+import java.io.BufferedWriter
+import java.io.Closeable
+import java.io.IOException
+import java.net.InetSocketAddress
+import java.net.Socket
+
+/**
+ * Connection to the signaling server. It is opened before the user is signed
+ * in and authenticated afterwards, so connection setup can overlap sign-in.
+ */
+interface SignalingConnection : Closeable {
+    suspend fun authenticate(idToken: String)
+
+    /** Joins [roomId] offering [candidates]; returns the call id. */
+    suspend fun join(roomId: String, candidates: List<IceCandidate>): String
+}
+
+/**
+ * Line-based signaling over TCP: `HELLO` → `WELCOME`, `AUTH <token>` → `OK`,
+ * `JOIN <room> <candidate>;<candidate>…` → `JOINED <call id>`. Anything else
+ * in reply, or end of stream, is an IOException.
+ */
+class LineSignalingConnection private constructor(private val socket: Socket) : SignalingConnection {
+    private val reader: BufferedReader = socket.getInputStream().bufferedReader()
+    private val writer: BufferedWriter = socket.getOutputStream().bufferedWriter()
+
+    override suspend fun authenticate(idToken: String) {
+        request("AUTH $idToken", "OK")
+    }
+
+    override suspend fun join(roomId: String, candidates: List<IceCandidate>): String =
+        request("JOIN $roomId ${candidates.joinToString(";")}", "JOINED")
+
+    override fun close() = socket.close()
+
+    private suspend fun request(line: String, expected: String): String = blockingIo(socket) {
+        writer.write(line)
+        writer.newLine()
+        writer.flush()
+        val reply = reader.readLine() ?: throw IOException("Signaling connection closed")
+        if (reply != expected && !reply.startsWith("$expected ")) {
+            throw IOException("Expected $expected, got: $reply")
+        }
+        reply.removePrefix(expected).trim()
+    }
+
+    companion object {
+        /** Resolves, connects and completes the HELLO exchange. */
+        suspend fun open(host: String, port: Int, timeoutMillis: Int = 5_000): LineSignalingConnection {
+            val socket = Socket()
+            try {
+                blockingIo(socket) {
+                    socket.tcpNoDelay = true
+                    socket.connect(InetSocketAddress(host, port), timeoutMillis)
+                    socket.soTimeout = timeoutMillis
+                }
+                return LineSignalingConnection(socket).also { it.request("HELLO", "WELCOME") }
+            } catch (e: Throwable) {
+                socket.close()
+                throw e
+            }
+        }
+    }
+}
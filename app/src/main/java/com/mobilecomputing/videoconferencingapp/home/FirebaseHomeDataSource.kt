@@ -0,0 +1,61 @@
+package com.mobilecomputing.videoconferencingapp.home
+
+import com.google.firebase.Timestamp
+import com.google.firebase.firestore.FirebaseFirestore
+import com.google.firebase.firestore.Query
+import com.google.firebase.storage.FirebaseStorage
+import com.google.firebase.storage.StorageException
+import kotlinx.coroutines.tasks.await
+import java.util.Date
+
+/**
+ * Profiles in `users/{uid}`, avatars in Storage at `avatars/{uid}.jpg`, and
+ * meetings in `meetings` with a `participants` uid array and a `startsAt`
+ * timestamp.
+ */
+class FirebaseHomeDataSource(
+    private val firestore: FirebaseFirestore,
+    private val storage: FirebaseStorage
+) : HomeDataSource {
+
+    override suspend fun profile(uid: String): UserProfile? {
+        val doc = firestore.collection("users").document(uid).get().await()
+        if (!doc.exists()) return null
+        return UserProfile(
+            displayName = doc.getString("displayName").orEmpty(),
+            email = doc.getString("email")
+        )
+    }
+
+    override suspend fun avatar(uid: String): ByteArray? =
+        try {
+            storage.reference.child("avatars/$uid.jpg").getBytes(MAX_AVATAR_BYTES).await()
+        } catch (e: StorageException) {
+            if (e.errorCode == StorageException.ERROR_OBJECT_NOT_FOUND) null else throw e
+        }
+
+    override suspend fun upcomingMeetings(
+        uid: String,
+        fromMillis: Long,
+        limit: Int
+    ): List<UpcomingMeeting> {
+        val snapshot = firestore.collection("meetings")
+            .whereArrayContains("participants", uid)
+            .whereGreaterThanOrEqualTo("startsAt", Timestamp(Date(fromMillis)))
+            .orderBy("startsAt", Query.Direction.ASCENDING)
+            .limit(limit.toLong())
+            .get()
+            .await()
+        return snapshot.documents.map { doc ->
+            UpcomingMeeting(
+                id = doc.id,
+                title = doc.getString("title").orEmpty(),
+                startsAtMillis = doc.getTimestamp("startsAt")?.toDate()?.time ?: 0L
+            )
+        }
+    }
+
+    private companion object {
+        const val MAX_AVATAR_BYTES = 512L * 1024
+    }
+}
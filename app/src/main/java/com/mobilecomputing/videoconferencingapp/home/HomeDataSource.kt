@@ -0,0 +1,42 @@
+package com.mobilecomputing.videoconferencingapp.home
+
+import androidx.compose.ui.graphics.ImageBitmap
+
+data class UserProfile(
+    val displayName: String,
+    val email: String?
+)
+
+data class UpcomingMeeting(
+    val id: String,
+    val title: String,
+    val startsAtMillis: Long
+)
+
+/** Everything the post-login screen shows, fetched before it is composed. */
+data class HomeSnapshot(
+    val profile: UserProfile,
+    val avatar: ImageBitmap?,
+    val meetings: List<UpcomingMeeting>
+)
+
+/** The backend reads behind [HomeSnapshot]; each may fail independently. */
+interface HomeDataSource {
+    /** The user's profile document, or null if there is none yet. */
+    suspend fun profile(uid: String): UserProfile?
+
+    /** Encoded avatar image, or null if the user has not uploaded one. */
+    suspend fun avatar(uid: String): ByteArray?
+
+    suspend fun upcomingMeetings(uid: String, fromMillis: Long, limit: Int): List<UpcomingMeeting>
+}
+
+/** Forwards to a data source that is still being created (e.g. by the startup graph). */
+class DeferredHomeDataSource(private val source: suspend () -> HomeDataSource) : HomeDataSource {
+    override suspend fun profile(uid: String) = source().profile(uid)
+
+    override suspend fun avatar(uid: String) = source().avatar(uid)
+
+    override suspend fun upcomingMeetings(uid: String, fromMillis: Long, limit: Int) =
+        source().upcomingMeetings(uid, fromMillis, limit)
+}
@@ -0,0 +1,90 @@
+package com.mobilecomputing.videoconferencingapp.home
+
+import android.graphics.BitmapFactory
+import android.util.Log
+import androidx.compose.ui.graphics.ImageBitmap
+import androidx.compose.ui.graphics.asImageBitmap
+import com.mobilecomputing.videoconferencingapp.auth.CachedSession
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.withContext
+
+/**
+ * Loads the post-login [HomeSnapshot]: profile, avatar and upcoming meetings
+ * are fetched concurrently, so the wait is the slowest of the three rather
+ * than their sum. [prefetch] is called as soon as the session is known (on
+ * restore, or when Firebase sign-in returns) and the screen awaits the same
+ * result. A finished snapshot is reused for [maxAgeMillis], after which the
+ * next [prefetch] loads a fresh one. A failed avatar or meeting read leaves
+ * that part empty instead of failing the screen.
+ */
+class HomeRepository(
+    private val source: HomeDataSource,
+    private val scope: CoroutineScope,
+    private val nowMillis: () -> Long = System::currentTimeMillis,
+    private val decodeAvatar: suspend (ByteArray) -> ImageBitmap? = ::decodeOnDefault,
+    private val meetingLimit: Int = 10,
+    private val maxAgeMillis: Long = 5 * 60_000L
+) {
+    private class Pending(val uid: String, val startedMillis: Long, val snapshot: Deferred<HomeSnapshot>)
+
+    private var pending: Pending? = null
+
+    /**
+     * Starts loading for [session], or returns the load already under way or
+     * finished less than [maxAgeMillis] ago. Main thread.
+     */
+    fun prefetch(session: CachedSession): Deferred<HomeSnapshot> {
+        val now = nowMillis()
+        pending?.let {
+            val fresh = !it.snapshot.isCompleted || now - it.startedMillis < maxAgeMillis
+            if (it.uid == session.uid && fresh) return it.snapshot
+        }
+        pending?.snapshot?.cancel()
+        val deferred = scope.async { load(session) }
+        pending = Pending(session.uid, now, deferred)
+        return deferred
+    }
+
+    /** Drops the cached snapshot; called on sign-out. */
+    fun clear() {
+        pending?.snapshot?.cancel()
+        pending = null
+    }
+
+    suspend fun load(session: CachedSession): HomeSnapshot = coroutineScope {
+        val profile = async { orNull("profile") { source.profile(session.uid) } }
+        val avatar = async { orNull("avatar") { source.avatar(session.uid)?.let { decodeAvatar(it) } } }
+        val meetings = async {
+            orNull("meetings") { source.upcomingMeetings(session.uid, nowMillis(), meetingLimit) }
+        }
+        HomeSnapshot(
+            profile = profile.await() ?: UserProfile(session.displayName ?: session.uid, email = null),
+            avatar = avatar.await(),
+            meetings = meetings.await().orEmpty()
+        )
+    }
+
+    private suspend fun <T> orNull(what: String, block: suspend () -> T?): T? =
+        try {
+            block()
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            Log.w(TAG, "Loading $what failed", e)
+            null
+        }
+
+    private companion object {
+        const val TAG = "HomeRepository"
+    }
+}
+
+private suspend fun decodeOnDefault(bytes: ByteArray): ImageBitmap? =
+    withContext(Dispatchers.Default) {
+        BitmapFactory.decodeByteArray(bytes, 0, bytes.size)?.asImageBitmap()
+    }
@@ -0,0 +1,83 @@
+package com.mobilecomputing.videoconferencingapp.realtime
+
+import java.io.DataInputStream
+import java.io.DataOutputStream
+import java.io.IOException
+
+/** What a stream carries; one connection multiplexes all of them. */
+enum class Topic(val code: Int) {
+    SIGNALING(1),
+    PRESENCE(2),
+    CHAT(3),
+    REACTIONS(4);
+
+    companion object {
+        fun of(code: Int): Topic = entries.firstOrNull { it.code == code }
+            ?: throw IOException("Unknown topic $code")
+    }
+}
+
+enum class FrameType(val code: Int) {
+    /** Client → server on stream 0; the payload is the ID token. Answered by HELLO_OK or GOAWAY. */
+    HELLO(1),
+    HELLO_OK(2),
+
+    /** Client → server: opens the stream. Payload `u8 topic | i32 credit | key (UTF-8)`; credit -1 is unlimited. */
+    OPEN(3),
+
+    /** Either way: the stream is finished. */
+    CLOSE(4),
+
+    /** Server → client: one event on the stream. */
+    DATA(5),
+
+    /** Client → server: the stream may be sent `i32` more events. */
+    CREDIT(6),
+
+    /** Client → server on stream 0: `u8 topic | UTF key | body`, for everyone subscribed to the topic and key. */
+    PUBLISH(7),
+
+    /** Either way on stream 0; the payload comes back in a PONG. */
+    PING(8),
+    PONG(9),
+
+    /** Server → client: the server is closing the connection; the payload is the reason. */
+    GOAWAY(10);
+
+    companion object {
+        private val byCode = entries.associateBy { it.code }
+
+        fun of(code: Int): FrameType = byCode[code] ?: throw IOException("Unknown frame type $code")
+    }
+}
+
+/**
+ * Unit of the realtime wire protocol: `i32 length | u8 type | i32 stream | payload`,
+ * big-endian, where length counts everything after itself. Stream 0 is the
+ * connection itself; the client numbers the others.
+ */
+class Frame(val type: FrameType, val stream: Int, val payload: ByteArray = EMPTY) {
+    companion object {
+        val EMPTY = ByteArray(0)
+
+        /** Frames above this are a protocol error rather than an allocation. */
+        const val MAX_PAYLOAD = 1 shl 20
+    }
+}
+
+fun DataOutputStream.writeFrame(frame: Frame) {
+    writeInt(5 + frame.payload.size)
+    writeByte(frame.type.code)
+    writeInt(frame.stream)
+    write(frame.payload)
+}
+
+/** Reads one frame; end of stream is an EOFException. */
+fun DataInputStream.readFrame(): Frame {
+    val length = readInt()
+    if (length < 5 || length - 5 > Frame.MAX_PAYLOAD) throw IOException("Bad frame length $length")
+    val type = FrameType.of(readUnsignedByte())
+    val stream = readInt()
+    val payload = if (length == 5) Frame.EMPTY else ByteArray(length - 5).also { readFully(it) }
+    return Frame(type, stream, payload)
+}
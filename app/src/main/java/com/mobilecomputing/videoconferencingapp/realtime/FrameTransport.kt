@@ -0,0 +1,52 @@
+package com.mobilecomputing.videoconferencingapp.realtime
+
+import com.mobilecomputing.videoconferencingapp.call.blockingIo
+import java.io.BufferedInputStream
+import java.io.BufferedOutputStream
+import java.io.Closeable
+import java.io.DataInputStream
+import java.io.DataOutputStream
+import java.net.InetSocketAddress
+import java.net.Socket
+
+/**
+ * A connected pipe for frames. Both calls block; [read] is only called from
+ * one thread and [write] from one other, and [close] unblocks either.
+ */
+interface FrameTransport : Closeable {
+    fun read(): Frame
+
+    /** Writes [frames] and flushes once, so a burst costs one syscall. */
+    fun write(frames: List<Frame>)
+}
+
+/** Frames over one TCP connection. */
+class SocketFrameTransport private constructor(private val socket: Socket) : FrameTransport {
+    private val input = DataInputStream(BufferedInputStream(socket.getInputStream(), 64 * 1024))
+    private val output = DataOutputStream(BufferedOutputStream(socket.getOutputStream(), 64 * 1024))
+
+    override fun read(): Frame = input.readFrame()
+
+    override fun write(frames: List<Frame>) {
+        frames.forEach { output.writeFrame(it) }
+        output.flush()
+    }
+
+    override fun close() = socket.close()
+
+    companion object {
+        suspend fun connect(host: String, port: Int, timeoutMillis: Int = 5_000): SocketFrameTransport {
+            val socket = Socket()
+            try {
+                blockingIo(socket) {
+                    socket.tcpNoDelay = true
+                    socket.connect(InetSocketAddress(host, port), timeoutMillis)
+                }
+                return SocketFrameTransport(socket)
+            } catch (e: Throwable) {
+                socket.close()
+                throw e
+            }
+        }
+    }
+}
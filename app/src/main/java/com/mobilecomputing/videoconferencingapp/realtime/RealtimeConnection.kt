@@ -0,0 +1,456 @@
+package com.mobilecomputing.videoconferencingapp.realtime
+
+import com.mobilecomputing.videoconferencingapp.call.blockingIo
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.channels.BufferOverflow
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.currentCoroutineContext
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.first
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.isActive
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.selects.select
+import kotlinx.coroutines.withContext
+import java.io.ByteArrayOutputStream
+import java.io.DataOutputStream
+import java.io.IOException
+import java.nio.ByteBuffer
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.atomic.AtomicLong
+
+/** How a stream's events are buffered between the socket and a slow collector. */
+sealed interface Delivery {
+    /**
+     * Lossless. The server may send at most [capacity] events the collector has
+     * not taken yet (credit is returned as it takes them), so a slow collector
+     * holds the server back instead of growing a buffer or stalling other streams.
+     */
+    data class Reliable(val capacity: Int = 64) : Delivery
+
+    /** Lossy: a collector that falls behind sees the newest [capacity] events. */
+    data class DropOldest(val capacity: Int) : Delivery
+
+    /**
+     * Conflated per key: of the events a collector has not taken yet, only the
+     * newest for each [keyOf] is kept, in order of their last update.
+     */
+    class LatestPerKey(val keyOf: (ByteArray) -> Any) : Delivery
+}
+
+/**
+ * One persistent connection to the realtime server carrying signaling,
+ * presence, chat and reactions as multiplexed streams, so chatty events cost
+ * neither a Firestore listener nor a connection each.
+ *
+ * [subscribe] returns cold flows: collecting opens a stream, cancelling the
+ * collector closes it. Frames are read on one IO thread that never waits
+ * for a collector — every stream has its own bounded buffer (see
+ * [Delivery]) — so one slow screen cannot hold up signaling. Outgoing
+ * frames go through one writer that batches whatever is queued into a
+ * single flush.
+ *
+ * The connection reconnects with backoff when it drops, fetching a fresh
+ * ID token, and reopens the open streams. After [maxFailedAttempts] failed
+ * attempts in a row it stops trying and goes [State.IDLE] until started
+ * again; [stop] does the same on purpose, e.g. while the app is in the
+ * background. Open flows stay open across both. Events sent while it was
+ * down are not replayed; state above it (e.g. signaling) resyncs from a
+ * snapshot. Publishes are at most once. After [close], subscribing,
+ * publishing and pinging fail with [IllegalStateException].
+ */
+class RealtimeConnection(
+    private val scope: CoroutineScope,
+    private val connect: suspend () -> FrameTransport,
+    private val idToken: suspend () -> String,
+    private val reconnectDelayMillis: (attempt: Int) -> Long = { attempt ->
+        (250L shl attempt.coerceAtMost(6)).coerceAtMost(10_000L)
+    },
+    private val maxFailedAttempts: Int = 8,
+    publishBuffer: Int = 256
+) {
+    enum class State { IDLE, CONNECTING, CONNECTED, RECONNECTING, CLOSED }
+
+    private val mutableState = MutableStateFlow(State.IDLE)
+    val state: StateFlow<State> = mutableState
+
+    /** Connections made so far, including reconnects. */
+    val connections: Int get() = connectionCount.get()
+
+    private val lock = Any()
+    private var job: Job? = null
+    private var closed = false // Guarded by lock.
+    private val streams = ConcurrentHashMap<Int, Stream>()
+    private val nextStream = AtomicInteger(1)
+    private val connectionCount = AtomicInteger()
+
+    // Frames tagged with the connection they belong to; the writer drops
+    // those of earlier connections. Publishes are not tied to a connection.
+    private class Control(val connection: Int, val frame: Frame)
+
+    private val control = Channel<Control>(Channel.UNLIMITED)
+    private val publishes = Channel<Frame>(publishBuffer)
+
+    /** Current connection number while connected, else 0. Written under [lock]. */
+    @Volatile
+    private var current = 0
+
+    private val nextPing = AtomicLong()
+    private val pings = ConcurrentHashMap<Long, CompletableDeferred<Unit>>()
+
+    /** Connects if not already connecting; [subscribe] and [publish] also do. */
+    fun start() {
+        synchronized(lock) {
+            if (job != null || closed) return
+            mutableState.value = if (connectionCount.get() == 0) State.CONNECTING else State.RECONNECTING
+            job = scope.launch { run() }
+        }
+    }
+
+    /** Disconnects until the next [start]; open flows stay open and pending pings fail. */
+    fun stop() {
+        synchronized(lock) {
+            if (closed) return
+            job?.cancel()
+            job = null
+            current = 0
+            mutableState.value = State.IDLE
+        }
+        failPings(IOException(STOPPED_MESSAGE))
+    }
+
+    /** Disconnects for good; open flows complete and pending pings fail. */
+    fun close() {
+        synchronized(lock) {
+            closed = true
+            job?.cancel()
+            current = 0
+            mutableState.value = State.CLOSED
+        }
+        streams.values.forEach { it.inbox.finish(null) }
+        streams.clear()
+        failPings(IllegalStateException(CLOSED_MESSAGE))
+        // Cancelling after closing also fails publishes already waiting on a
+        // full queue, with ClosedSendChannelException.
+        publishes.close()
+        publishes.cancel()
+    }
+
+    /** Events on [topic] for [key] (e.g. a room ID), buffered as [delivery] says. */
+    fun subscribe(topic: Topic, key: String, delivery: Delivery): Flow<ByteArray> = flow {
+        val stream = open(topic, key, delivery)
+        try {
+            while (true) emit(stream.take() ?: break)
+        } finally {
+            closeStream(stream)
+        }
+    }
+
+    /**
+     * Sends [body] to everyone subscribed to [topic] and [key]; suspends while
+     * the send queue is full, and fails if the connection is closed meanwhile.
+     */
+    suspend fun publish(topic: Topic, key: String, body: ByteArray) {
+        check(!synchronized(lock) { closed }) { CLOSED_MESSAGE }
+        start()
+        val bytes = ByteArrayOutputStream(body.size + key.length + 8)
+        DataOutputStream(bytes).apply {
+            writeByte(topic.code)
+            writeUTF(key)
+            write(body)
+        }
+        publishes.send(Frame(FrameType.PUBLISH, 0, bytes.toByteArray()))
+    }
+
+    /** Round trip to the server in nanoseconds, once connected. Fails if the connection drops or stops first. */
+    suspend fun ping(): Long {
+        start()
+        val id = nextPing.incrementAndGet()
+        val pong = CompletableDeferred<Unit>()
+        try {
+            var connection = 0
+            while (connection == 0) {
+                when (state.first { it == State.CONNECTED || it == State.IDLE || it == State.CLOSED }) {
+                    State.CLOSED -> throw IllegalStateException(CLOSED_MESSAGE)
+                    State.IDLE -> throw IOException(STOPPED_MESSAGE)
+                    else -> Unit
+                }
+                // Registered under the lock, so the session's end (or close) fails it.
+                connection = synchronized(lock) {
+                    if (closed) throw IllegalStateException(CLOSED_MESSAGE)
+                    current.also { if (it != 0) pings[id] = pong }
+                }
+            }
+            val begin = System.nanoTime()
+            send(Frame(FrameType.PING, 0, ByteBuffer.allocate(8).putLong(id).array()), connection)
+            pong.await()
+            return System.nanoTime() - begin
+        } finally {
+            pings.remove(id)
+        }
+    }
+
+    private suspend fun run() {
+        var failures = 0
+        while (true) {
+            setState(if (connectionCount.get() == 0) State.CONNECTING else State.RECONNECTING)
+            try {
+                val transport = connect()
+                try {
+                    session(transport) { failures = 0 }
+                } finally {
+                    transport.close()
+                }
+            } catch (e: CancellationException) {
+                throw e
+            } catch (e: Exception) {
+                // Dropped, refused or rejected: try again.
+            }
+            // E.g. no network or no server: wait for the next start().
+            if (++failures >= maxFailedAttempts) break
+            setState(State.RECONNECTING)
+            delay(reconnectDelayMillis(failures - 1))
+        }
+        val self = currentCoroutineContext()[Job]
+        synchronized(lock) {
+            // Unless stop() and start() already replaced this run.
+            if (job !== self) return
+            job = null
+            if (!closed) mutableState.value = State.IDLE
+        }
+    }
+
+    private suspend fun session(transport: FrameTransport, onConnected: () -> Unit) = coroutineScope {
+        val token = idToken()
+        withContext(Dispatchers.IO) { transport.write(listOf(Frame(FrameType.HELLO, 0, token.encodeToByteArray()))) }
+        val reply = blockingIo(transport) { transport.read() }
+        if (reply.type != FrameType.HELLO_OK) {
+            throw IOException("Realtime server refused the connection: ${reply.payload.decodeToString()}")
+        }
+        val connection = connectionCount.incrementAndGet()
+        synchronized(lock) {
+            // Closed or stopped during the handshake: the job is cancelled and this session ends.
+            if (closed || !isActive) return@coroutineScope
+            current = connection
+            streams.values.forEach { control.trySend(Control(connection, it.openFrame())) }
+            mutableState.value = State.CONNECTED
+        }
+        onConnected()
+
+        val writer = launch(Dispatchers.IO) { writeLoop(transport, connection) }
+        try {
+            // Never suspends: dispatch only hands events to stream buffers.
+            blockingIo(transport) {
+                while (true) dispatch(transport.read(), connection)
+            }
+        } finally {
+            // Closing unblocks a writer stuck on a peer that stopped reading.
+            writer.cancel()
+            transport.close()
+            synchronized(lock) {
+                // Unless stop() and start() already have a newer connection up.
+                if (current == connection) {
+                    current = 0
+                    mutableState.compareAndSet(State.CONNECTED, State.RECONNECTING)
+                }
+            }
+            // Their PONGs cannot arrive any more.
+            failPings(IOException("Realtime connection lost before PONG"))
+        }
+    }
+
+    /** Sets a connecting state unless closed, which is final. */
+    private fun setState(value: State) {
+        synchronized(lock) { if (!closed) mutableState.value = value }
+    }
+
+    private fun failPings(cause: Throwable) {
+        pings.values.forEach { it.completeExceptionally(cause) }
+    }
+
+    private suspend fun writeLoop(transport: FrameTransport, connection: Int) {
+        val batch = ArrayList<Frame>()
+        fun add(c: Control) {
+            if (c.connection == connection) batch += c.frame
+        }
+        while (true) {
+            // Control frames (opens, credit, closes) go ahead of publishes.
+            select {
+                control.onReceive { add(it) }
+                publishes.onReceive { batch += it }
+            }
+            while (true) add(control.tryReceive().getOrNull() ?: break)
+            while (batch.size < MAX_BATCH) batch += publishes.tryReceive().getOrNull() ?: break
+            if (batch.isNotEmpty()) transport.write(batch)
+            batch.clear()
+        }
+    }
+
+    private fun dispatch(frame: Frame, connection: Int) {
+        when (frame.type) {
+            FrameType.DATA -> streams[frame.stream]?.deliver(frame.payload)
+            FrameType.CLOSE -> streams.remove(frame.stream)?.inbox?.finish(null)
+            FrameType.PING -> control.trySend(Control(connection, Frame(FrameType.PONG, 0, frame.payload)))
+            FrameType.PONG -> pings[ByteBuffer.wrap(frame.payload).long]?.complete(Unit)
+            FrameType.GOAWAY -> throw IOException("Realtime server closing: ${frame.payload.decodeToString()}")
+            else -> throw IOException("Unexpected ${frame.type} from the realtime server")
+        }
+    }
+
+    private fun send(frame: Frame, connection: Int = current) {
+        if (connection != 0) control.trySend(Control(connection, frame))
+    }
+
+    private fun open(topic: Topic, key: String, delivery: Delivery): Stream {
+        start()
+        val stream = Stream(nextStream.getAndIncrement(), topic, key, delivery)
+        synchronized(lock) {
+            // Checked under the lock: close() finishes every stream added before it.
+            check(!closed) { CLOSED_MESSAGE }
+            streams[stream.id] = stream
+            // Not connected: the stream is opened when the connection comes up.
+            if (current != 0) control.trySend(Control(current, stream.openFrame()))
+        }
+        return stream
+    }
+
+    private fun closeStream(stream: Stream) {
+        if (streams.remove(stream.id) != null) send(Frame(FrameType.CLOSE, stream.id))
+        stream.inbox.finish(null)
+    }
+
+    private inner class Stream(val id: Int, val topic: Topic, val key: String, val delivery: Delivery) {
+        val inbox: Inbox = when (delivery) {
+            is Delivery.Reliable -> ChannelInbox(Channel(delivery.capacity))
+            is Delivery.DropOldest -> ChannelInbox(Channel(delivery.capacity, BufferOverflow.DROP_OLDEST))
+            is Delivery.LatestPerKey -> KeyedInbox(delivery.keyOf)
+        }
+        private val capacity = (delivery as? Delivery.Reliable)?.capacity ?: 0
+
+        // Reliable only: events received but not taken, and taken but not yet credited back.
+        private var buffered = 0
+        private var uncredited = 0
+
+        /** OPEN granting credit for the room left in the buffer; any credit not yet returned is included. */
+        fun openFrame(): Frame = synchronized(this) {
+            val credit = if (capacity > 0) capacity - buffered else -1
+            uncredited = 0
+            val bytes = ByteArrayOutputStream(key.length + 8)
+            DataOutputStream(bytes).apply {
+                writeByte(topic.code)
+                writeInt(credit)
+                write(key.encodeToByteArray())
+            }
+            Frame(FrameType.OPEN, id, bytes.toByteArray())
+        }
+
+        /** Fails only this stream on a bad event; the connection and other streams carry on. */
+        fun deliver(event: ByteArray) {
+            if (capacity > 0) synchronized(this) { ++buffered }
+            val accepted = try {
+                inbox.offer(event)
+            } catch (e: Exception) {
+                // A key function that cannot read the event.
+                inbox.finish(IOException("Undecodable $topic event", e))
+                return
+            }
+            if (!accepted) {
+                inbox.finish(IOException("Realtime server sent $topic beyond the stream's credit"))
+            }
+        }
+
+        suspend fun take(): ByteArray? {
+            val event = inbox.take() ?: return null
+            if (capacity > 0) {
+                // Return credit in batches of half the buffer, not per event.
+                // The connection is read with the count so a reopen, which
+                // grants the whole free buffer itself, cannot count it twice.
+                var connection = 0
+                val credit = synchronized(this) {
+                    --buffered
+                    ++uncredited
+                    if (uncredited < (capacity / 2).coerceAtLeast(1)) return event
+                    connection = current
+                    uncredited.also { uncredited = 0 }
+                }
+                send(Frame(FrameType.CREDIT, id, ByteBuffer.allocate(4).putInt(credit).array()), connection)
+            }
+            return event
+        }
+    }
+
+    private companion object {
+        const val MAX_BATCH = 256
+        const val CLOSED_MESSAGE = "Realtime connection is closed"
+        const val STOPPED_MESSAGE = "Realtime connection is not running"
+    }
+}
+
+/** A stream's buffer between the reader thread and its collector. */
+private sealed class Inbox {
+    /** Called on the reader thread; false if a bounded, lossless buffer is full. */
+    abstract fun offer(event: ByteArray): Boolean
+
+    /** The next event, or null once finished without an error. */
+    abstract suspend fun take(): ByteArray?
+
+    abstract fun finish(cause: Throwable?)
+}
+
+private class ChannelInbox(private val channel: Channel<ByteArray>) : Inbox() {
+    override fun offer(event: ByteArray) = channel.trySend(event).isSuccess
+
+    override suspend fun take(): ByteArray? {
+        val result = channel.receiveCatching()
+        result.exceptionOrNull()?.let { throw it }
+        return result.getOrNull()
+    }
+
+    override fun finish(cause: Throwable?) {
+        channel.close(cause)
+    }
+}
+
+private class KeyedInbox(private val keyOf: (ByteArray) -> Any) : Inbox() {
+    private val pending = LinkedHashMap<Any, ByteArray>()
+    private val signal = Channel<Unit>(Channel.CONFLATED)
+
+    override fun offer(event: ByteArray): Boolean {
+        val key = keyOf(event)
+        synchronized(pending) {
+            // Re-inserting moves the key behind the others.
+            pending.remove(key)
+            pending[key] = event
+        }
+        signal.trySend(Unit)
+        return true
+    }
+
+    override suspend fun take(): ByteArray? {
+        while (true) {
+            synchronized(pending) {
+                val first = pending.entries.firstOrNull()
+                if (first != null) {
+                    pending.remove(first.key)
+                    return first.value
+                }
+            }
+            val result = signal.receiveCatching()
+            result.exceptionOrNull()?.let { throw it }
+            if (result.isClosed) return null
+        }
+    }
+
+    override fun finish(cause: Throwable?) {
+        signal.close(cause)
+    }
+}
@@ -0,0 +1,95 @@
+package com.mobilecomputing.videoconferencingapp.realtime
+
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.mapNotNull
+import kotlinx.coroutines.flow.runningFold
+import java.io.ByteArrayInputStream
+import java.io.ByteArrayOutputStream
+import java.io.DataInputStream
+import java.io.DataOutputStream
+import java.io.IOException
+
+data class ChatMessage(val senderUid: String, val text: String, val sentAtMillis: Long)
+
+data class Reaction(val senderUid: String, val emoji: String, val sentAtMillis: Long)
+
+enum class PresenceStatus { ONLINE, AWAY, IN_CALL, OFFLINE }
+
+data class PresenceUpdate(val uid: String, val status: PresenceStatus)
+
+/**
+ * A room's events on the shared [RealtimeConnection], typed for the UI. Each
+ * flow is cold and picks the buffering its event rate calls for: chat and
+ * signaling are lossless, reactions keep only the newest when the UI falls
+ * behind, and presence keeps only the latest status per participant.
+ * Events that do not decode, e.g. from a misbehaving peer, are skipped.
+ */
+class RoomChannel(
+    private val connection: RealtimeConnection,
+    private val roomId: String,
+    private val selfUid: String,
+    private val clock: () -> Long = System::currentTimeMillis
+) {
+    /** Signaling messages (see the native session protocol), as sent. */
+    fun signaling(): Flow<ByteArray> =
+        connection.subscribe(Topic.SIGNALING, roomId, Delivery.Reliable(SIGNALING_BUFFER))
+
+    fun chat(): Flow<ChatMessage> =
+        connection.subscribe(Topic.CHAT, roomId, Delivery.Reliable(CHAT_BUFFER)).mapNotNull { decode(it, ::readChat) }
+
+    fun reactions(): Flow<Reaction> =
+        connection.subscribe(Topic.REACTIONS, roomId, Delivery.DropOldest(REACTION_BUFFER))
+            .mapNotNull { decode(it, ::readReaction) }
+
+    /** Everyone's latest status, starting empty; a slow collector skips intermediate states. */
+    fun presence(): Flow<Map<String, PresenceStatus>> =
+        connection.subscribe(Topic.PRESENCE, roomId, Delivery.LatestPerKey(::presenceUid))
+            .mapNotNull { decode(it, ::readPresence) }
+            .runningFold(emptyMap()) { roster, update -> roster + (update.uid to update.status) }
+
+    suspend fun sendSignaling(message: ByteArray) = connection.publish(Topic.SIGNALING, roomId, message)
+
+    suspend fun sendChat(text: String) = connection.publish(
+        Topic.CHAT, roomId, encode { writeUTF(selfUid); writeUTF(text); writeLong(clock()) }
+    )
+
+    suspend fun react(emoji: String) = connection.publish(
+        Topic.REACTIONS, roomId, encode { writeUTF(selfUid); writeUTF(emoji); writeLong(clock()) }
+    )
+
+    suspend fun setPresence(status: PresenceStatus) = connection.publish(
+        Topic.PRESENCE, roomId, encode { writeUTF(selfUid); writeByte(status.ordinal) }
+    )
+
+    private companion object {
+        const val SIGNALING_BUFFER = 128
+        const val CHAT_BUFFER = 64
+        const val REACTION_BUFFER = 32
+
+        fun encode(write: DataOutputStream.() -> Unit): ByteArray =
+            ByteArrayOutputStream(64).also { DataOutputStream(it).write() }.toByteArray()
+
+        /** The decoded event, or null if [bytes] is truncated or malformed. */
+        fun <T> decode(bytes: ByteArray, read: (DataInputStream) -> T): T? = try {
+            read(DataInputStream(ByteArrayInputStream(bytes)))
+        } catch (e: IOException) {
+            null
+        }
+
+        fun readChat(input: DataInputStream) = ChatMessage(input.readUTF(), input.readUTF(), input.readLong())
+
+        fun readReaction(input: DataInputStream) = Reaction(input.readUTF(), input.readUTF(), input.readLong())
+
+        fun readPresence(input: DataInputStream): PresenceUpdate {
+            val uid = input.readUTF()
+            val status = input.readUnsignedByte()
+            return PresenceUpdate(uid, PresenceStatus.entries.getOrNull(status) ?: throw IOException("Bad status $status"))
+        }
+
+        // Reads only the uid, on the connection's reader thread. Malformed
+        // events share one key and are dropped when collected.
+        private val MALFORMED = Any()
+
+        fun presenceUid(bytes: ByteArray): Any = decode(bytes) { it.readUTF() } ?: MALFORMED
+    }
+}
@@ -0,0 +1,95 @@
+package com.mobilecomputing.videoconferencingapp.room
+
+import com.google.firebase.firestore.DocumentChange
+import com.google.firebase.firestore.DocumentSnapshot
+import com.google.firebase.firestore.FieldValue
+import com.google.firebase.firestore.FirebaseFirestore
+import com.google.firebase.firestore.FirebaseFirestoreException
+import com.google.firebase.firestore.SetOptions
+import kotlinx.coroutines.channels.awaitClose
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.callbackFlow
+import kotlinx.coroutines.tasks.await
+
+/**
+ * Shards in `rooms/{roomId}/shards/{n}`, each with a `participants` map from
+ * uid to record. One query listener covers all of a room's shards, and only
+ * changed shard documents are read again.
+ */
+class FirestoreRoomStateSource(private val firestore: FirebaseFirestore) : RoomStateSource {
+
+    override suspend fun commit(roomId: String, writes: List<ShardWrite>) {
+        val batch = firestore.batch()
+        for (write in writes) {
+            val participants = write.changes.mapValues { (_, participant) ->
+                participant?.let(::fields) ?: FieldValue.delete()
+            }
+            // Merging touches only the changed uids, not the rest of the shard.
+            batch.set(
+                shards(roomId).document(write.shard.toString()),
+                mapOf("participants" to participants),
+                SetOptions.merge()
+            )
+        }
+        try {
+            batch.commit().await()
+        } catch (e: FirebaseFirestoreException) {
+            if (e.code in REJECTED) throw RejectedWriteException("Writing room $roomId was rejected: ${e.code}", e)
+            throw e
+        }
+    }
+
+    override fun shards(roomId: String): Flow<List<ShardSnapshot>> = callbackFlow {
+        val registration = shards(roomId).addSnapshotListener { snapshot, error ->
+            if (error != null) {
+                close(error)
+                return@addSnapshotListener
+            }
+            val changed = snapshot?.documentChanges.orEmpty().mapNotNull { change ->
+                val shard = change.document.id.toIntOrNull() ?: return@mapNotNull null
+                val participants = if (change.type == DocumentChange.Type.REMOVED) emptyMap() else read(change.document)
+                ShardSnapshot(shard, participants)
+            }
+            if (changed.isNotEmpty()) trySend(changed)
+        }
+        awaitClose { registration.remove() }
+    }
+
+    private fun shards(roomId: String) = firestore.collection("rooms").document(roomId).collection("shards")
+
+    private fun fields(participant: Participant): Map<String, Any> = mapOf(
+        "displayName" to participant.displayName,
+        "audioMuted" to participant.audioMuted,
+        "videoEnabled" to participant.videoEnabled,
+        "handRaised" to participant.handRaised,
+        "joinedAt" to participant.joinedAtMillis
+    )
+
+    private companion object {
+        /** Codes that fail the same way however often the write is retried. */
+        val REJECTED = setOf(
+            FirebaseFirestoreException.Code.PERMISSION_DENIED,
+            FirebaseFirestoreException.Code.NOT_FOUND,
+            FirebaseFirestoreException.Code.INVALID_ARGUMENT,
+            FirebaseFirestoreException.Code.FAILED_PRECONDITION,
+            FirebaseFirestoreException.Code.OUT_OF_RANGE,
+            FirebaseFirestoreException.Code.UNIMPLEMENTED
+        )
+    }
+
+    private fun read(doc: DocumentSnapshot): Map<String, Participant> {
+        val participants = doc.get("participants") as? Map<*, *> ?: return emptyMap()
+        return participants.entries.mapNotNull { (uid, value) ->
+            val fields = value as? Map<*, *> ?: return@mapNotNull null
+            val id = uid as? String ?: return@mapNotNull null
+            id to Participant(
+                uid = id,
+                displayName = fields["displayName"] as? String ?: "",
+                audioMuted = fields["audioMuted"] as? Boolean ?: false,
+                videoEnabled = fields["videoEnabled"] as? Boolean ?: true,
+                handRaised = fields["handRaised"] as? Boolean ?: false,
+                joinedAtMillis = (fields["joinedAt"] as? Number)?.toLong() ?: 0L
+            )
+        }.toMap()
+    }
+}
@@ -0,0 +1,144 @@
+package com.mobilecomputing.videoconferencingapp.room
+
+import androidx.compose.runtime.Immutable
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+
+/** A participant as the call screen shows them. [flags] holds the fast-changing state. */
+@Immutable
+data class ParticipantItem(
+    val uid: String,
+    val displayName: String,
+    val joinedAtMillis: Long,
+    val flags: Int = 0
+) {
+    val audioMuted: Boolean get() = flags and AUDIO_MUTED != 0
+    val videoEnabled: Boolean get() = flags and VIDEO_OFF == 0
+    val handRaised: Boolean get() = flags and HAND_RAISED != 0
+    val speaking: Boolean get() = flags and SPEAKING != 0
+
+    companion object {
+        const val AUDIO_MUTED = 1
+        const val VIDEO_OFF = 2
+        const val HAND_RAISED = 4
+        const val SPEAKING = 8
+
+        /** Flags stored with the room's membership; the rest come from the call. */
+        const val STORED = AUDIO_MUTED or VIDEO_OFF or HAND_RAISED
+
+        fun of(participant: Participant, flags: Int = 0) = ParticipantItem(
+            uid = participant.uid,
+            displayName = participant.displayName,
+            joinedAtMillis = participant.joinedAtMillis,
+            flags = (flags and STORED.inv()) or
+                (if (participant.audioMuted) AUDIO_MUTED else 0) or
+                (if (participant.videoEnabled) 0 else VIDEO_OFF) or
+                (if (participant.handRaised) HAND_RAISED else 0)
+        )
+    }
+}
+
+/** One change to the participant list. */
+sealed interface ParticipantDelta {
+    val uid: String
+
+    /** Adds [item], or replaces the participant with its uid. */
+    data class Joined(val item: ParticipantItem) : ParticipantDelta {
+        override val uid get() = item.uid
+    }
+
+    data class Left(override val uid: String) : ParticipantDelta
+
+    /** Sets [set] and clears [clear] in the participant's flags, e.g. for mute or speaking. */
+    data class Flags(override val uid: String, val set: Int, val clear: Int = 0) : ParticipantDelta
+}
+
+/**
+ * How one batch of deltas changed the list, in the order applied; each index
+ * is into the list as it was after the previous change.
+ */
+sealed interface ListChange {
+    val index: Int
+
+    data class Inserted(override val index: Int, val uid: String) : ListChange
+    data class Removed(override val index: Int, val uid: String) : ListChange
+    data class Changed(override val index: Int, val uid: String) : ListChange
+}
+
+/** The participant list in join order, with the changes that produced this version from the last. */
+@Immutable
+class ParticipantList(
+    val items: List<ParticipantItem>,
+    val changes: List<ListChange>,
+    val version: Long
+) {
+    companion object {
+        val EMPTY = ParticipantList(emptyList(), emptyList(), 0)
+    }
+}
+
+/**
+ * The call screen's participant list, kept in join order and updated by
+ * deltas rather than rebuilt. Items keep their identity unless they change,
+ * so a lazy list keyed by uid recomposes only the tiles that did; a speaking
+ * indicator flickering on one tile costs one tile. A batch is applied with
+ * one copy of the list and published as one version.
+ *
+ * Not thread-safe: apply from one coroutine and collect [state] anywhere.
+ */
+class ParticipantStore {
+    private val byUid = HashMap<String, ParticipantItem>()
+    private val mutableState = MutableStateFlow(ParticipantList.EMPTY)
+    val state: StateFlow<ParticipantList> = mutableState
+
+    operator fun get(uid: String): ParticipantItem? = byUid[uid]
+
+    /** Applies [deltas] in order; publishes a new version only if something changed. */
+    fun apply(deltas: List<ParticipantDelta>): ParticipantList {
+        val current = mutableState.value
+        var items: ArrayList<ParticipantItem>? = null
+        val changes = ArrayList<ListChange>()
+        for (delta in deltas) {
+            val existing = byUid[delta.uid]
+            val next = when (delta) {
+                is ParticipantDelta.Joined -> delta.item
+                is ParticipantDelta.Left -> null
+                is ParticipantDelta.Flags ->
+                    existing?.let { it.copy(flags = (it.flags or delta.set) and delta.clear.inv()) }
+            }
+            if (next == existing) continue
+            val list = items ?: ArrayList(current.items)
+            items = list
+            if (existing != null && next != null && ORDER.compare(existing, next) == 0) {
+                val index = list.binarySearch(existing, ORDER)
+                list[index] = next
+                changes += ListChange.Changed(index, next.uid)
+            } else {
+                if (existing != null) {
+                    val index = list.binarySearch(existing, ORDER)
+                    list.removeAt(index)
+                    changes += ListChange.Removed(index, existing.uid)
+                }
+                if (next != null) {
+                    val index = -(list.binarySearch(next, ORDER) + 1)
+                    list.add(index, next)
+                    changes += ListChange.Inserted(index, next.uid)
+                }
+            }
+            if (next != null) byUid[next.uid] = next else byUid.remove(delta.uid)
+        }
+        if (items == null) return current
+        return ParticipantList(items, changes, current.version + 1).also { mutableState.value = it }
+    }
+
+    /** Applies a membership change from [RoomStateStore.diffs], keeping call-only flags such as speaking. */
+    fun apply(diff: RoomDiff): ParticipantList = apply(
+        diff.left.map { ParticipantDelta.Left(it) } + (diff.joined + diff.updated).map {
+            ParticipantDelta.Joined(ParticipantItem.of(it, byUid[it.uid]?.flags ?: 0))
+        }
+    )
+
+    private companion object {
+        val ORDER = compareBy<ParticipantItem>({ it.joinedAtMillis }, { it.uid })
+    }
+}
@@ -0,0 +1,48 @@
+package com.mobilecomputing.videoconferencingapp.room
+
+import kotlinx.coroutines.flow.Flow
+import java.io.IOException
+
+/** One participant's record in a room. */
+data class Participant(
+    val uid: String,
+    val displayName: String,
+    val audioMuted: Boolean = false,
+    val videoEnabled: Boolean = true,
+    val handRaised: Boolean = false,
+    val joinedAtMillis: Long = 0
+)
+
+/**
+ * Changes to one shard document, written together: each uid maps to its new
+ * record, or to null if the participant left.
+ */
+class ShardWrite(val shard: Int, val changes: Map<String, Participant?>)
+
+/** A shard document's participants as of one snapshot. */
+class ShardSnapshot(val shard: Int, val participants: Map<String, Participant>)
+
+/**
+ * Where room membership is stored: participant records spread over a fixed
+ * number of shard documents per room, so joins and leaves do not all
+ * contend for one document.
+ */
+interface RoomStateSource {
+    /**
+     * Applies [writes] atomically, at most one write per shard document.
+     * Throws [RejectedWriteException] if retrying cannot help.
+     */
+    suspend fun commit(roomId: String, writes: List<ShardWrite>)
+
+    /**
+     * Shard documents as they change. The first emission holds every
+     * non-empty shard; each later one only the shards that changed.
+     */
+    fun shards(roomId: String): Flow<List<ShardSnapshot>>
+}
+
+/** A commit the store refused, e.g. denied by its security rules, rather than one that failed to get through. */
+class RejectedWriteException(message: String, cause: Throwable? = null) : IOException(message, cause)
+
+/** The shard a participant's record lives in; stable across devices and app versions. */
+fun shardOf(uid: String, shardCount: Int): Int = Math.floorMod(uid.hashCode(), shardCount)
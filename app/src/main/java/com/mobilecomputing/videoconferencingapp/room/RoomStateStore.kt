@@ -0,0 +1,169 @@
+package com.mobilecomputing.videoconferencingapp.room
+
+import android.util.Log
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+
+/** What changed in a room's membership between two emissions. */
+data class RoomDiff(
+    val joined: List<Participant> = emptyList(),
+    val updated: List<Participant> = emptyList(),
+    val left: List<String> = emptyList()
+) {
+    fun isEmpty() = joined.isEmpty() && updated.isEmpty() && left.isEmpty()
+
+    fun applyTo(roster: Map<String, Participant>): Map<String, Participant> {
+        if (isEmpty()) return roster
+        val next = LinkedHashMap(roster)
+        left.forEach { next.remove(it) }
+        joined.forEach { next[it.uid] = it }
+        updated.forEach { next[it.uid] = it }
+        return next
+    }
+}
+
+/**
+ * A room's membership in [RoomStateSource], written and read so that a
+ * crowded room stays within what one document can take.
+ *
+ * Writes are throttled: the first change goes out at once, and changes made
+ * within [minWriteIntervalMillis] of a commit wait for the next one, where
+ * only each participant's latest record is written. A commit touches each
+ * shard at most once, so a client writes a shard document at most once per
+ * interval, and [shardCount] shards spread many clients' joins.
+ *
+ * A commit that fails is retried with the changes made since, backing off
+ * exponentially from [retryDelayMillis] while failures continue; one the
+ * source rejects ([RejectedWriteException]) is dropped.
+ *
+ * [diffs] turns shard snapshots into joined/updated/left changes, so the UI
+ * applies what changed instead of re-reading the whole roster.
+ */
+class RoomStateStore(
+    private val source: RoomStateSource,
+    private val scope: CoroutineScope,
+    private val roomId: String,
+    private val shardCount: Int = DEFAULT_SHARDS,
+    private val minWriteIntervalMillis: Long = 1_000,
+    private val retryDelayMillis: Long = 1_000,
+    private val maxRetryDelayMillis: Long = 60_000
+) {
+    // uid to latest record, null for a removal; guarded by itself.
+    private val pending = LinkedHashMap<String, Participant?>()
+    private val wake = Channel<Unit>(Channel.CONFLATED)
+    private val commitLock = Mutex()
+    private var failures = 0 // Consecutive failed commits; guarded by commitLock.
+
+    init {
+        scope.launch {
+            for (signal in wake) {
+                val failed = commitPending() ?: continue
+                delay(
+                    if (failed == 0) {
+                        minWriteIntervalMillis
+                    } else {
+                        (retryDelayMillis shl (failed - 1).coerceAtMost(20)).coerceAtMost(maxRetryDelayMillis)
+                    }
+                )
+            }
+        }
+    }
+
+    /** Writes [participant]'s record, replacing any change to it not yet written. */
+    fun update(participant: Participant) = enqueue(participant.uid, participant)
+
+    fun remove(uid: String) = enqueue(uid, null)
+
+    /** Writes pending changes now, e.g. a leave before [close]. */
+    suspend fun flush() {
+        commitPending()
+    }
+
+    /** Stops writing; changes not yet written are dropped. */
+    fun close() {
+        wake.close()
+    }
+
+    /** Membership changes, starting with everyone already in the room as joined. */
+    fun diffs(): Flow<RoomDiff> = flow {
+        val shards = HashMap<Int, Map<String, Participant>>()
+        source.shards(roomId).collect { snapshots ->
+            val joined = ArrayList<Participant>()
+            val updated = ArrayList<Participant>()
+            val left = ArrayList<String>()
+            for (snapshot in snapshots) {
+                val before = shards[snapshot.shard].orEmpty()
+                val after = snapshot.participants
+                for ((uid, participant) in after) {
+                    when (before[uid]) {
+                        null -> joined += participant
+                        participant -> {}
+                        else -> updated += participant
+                    }
+                }
+                before.keys.filterTo(left) { it !in after }
+                shards[snapshot.shard] = after
+            }
+            val diff = RoomDiff(joined, updated, left)
+            if (!diff.isEmpty()) emit(diff)
+        }
+    }
+
+    private fun enqueue(uid: String, participant: Participant?) {
+        synchronized(pending) {
+            // Re-inserting keeps writes in the order of their latest change.
+            pending.remove(uid)
+            pending[uid] = participant
+        }
+        wake.trySend(Unit)
+    }
+
+    /**
+     * Commits what is pending; returns the failed commits in a row so far, or
+     * null if there was nothing. Failed writes are retried on the next commit.
+     */
+    private suspend fun commitPending(): Int? = commitLock.withLock {
+        val batch = synchronized(pending) {
+            LinkedHashMap(pending).also { pending.clear() }
+        }
+        if (batch.isEmpty()) return null
+        val writes = batch.entries
+            .groupBy({ shardOf(it.key, shardCount) }, { it.key to it.value })
+            .map { (shard, changes) -> ShardWrite(shard, changes.toMap()) }
+        try {
+            source.commit(roomId, writes)
+            failures = 0
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: RejectedWriteException) {
+            // Would fail the same way every time; newer changes still go out.
+            Log.e(TAG, "Writing room $roomId was rejected; dropping ${batch.size} changes", e)
+            failures = 0
+        } catch (e: Exception) {
+            failures++
+            Log.w(TAG, "Writing room $roomId failed $failures times; retrying", e)
+            synchronized(pending) {
+                // Changes made since are newer than the failed ones.
+                for ((uid, participant) in batch) {
+                    if (uid !in pending) pending[uid] = participant
+                }
+            }
+            wake.trySend(Unit)
+        }
+        failures
+    }
+
+    companion object {
+        /** Spreads a few hundred participants' joins to a handful of writes per shard. */
+        const val DEFAULT_SHARDS = 32
+
+        private const val TAG = "RoomStateStore"
+    }
+}
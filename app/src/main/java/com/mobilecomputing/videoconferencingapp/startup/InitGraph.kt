@@ -0,0 +1,170 @@
+package com.mobilecomputing.videoconferencingapp.startup
+
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.ExperimentalCoroutinesApi
+import kotlinx.coroutines.launch
+import java.util.concurrent.CopyOnWriteArrayList
+
+/** When a component is created. */
+enum class InitPhase {
+    /** Needed for the first frame: created on the main thread in [InitGraph.start]. */
+    MAIN,
+
+    /** Created on a background dispatcher as soon as the graph starts. */
+    BACKGROUND,
+
+    /** Created on a background dispatcher once the first frame has been drawn. */
+    AFTER_FIRST_FRAME
+}
+
+/**
+ * One node of the startup graph. [create] runs once, after everything in
+ * [dependsOn]; MAIN components may only depend on other MAIN components, and
+ * BACKGROUND ones not on AFTER_FIRST_FRAME ones.
+ */
+class Component<T : Any>(
+    val name: String,
+    val phase: InitPhase,
+    val dependsOn: List<Component<*>> = emptyList(),
+    val create: () -> T
+)
+
+data class InitTiming(
+    val name: String,
+    val phase: InitPhase,
+    /** Since the graph started. */
+    val startMillis: Long,
+    val durationMillis: Long,
+    val error: Throwable? = null
+)
+
+/**
+ * Declarative app startup: each component says what it needs and when it is
+ * needed, and the graph creates it on the main thread, in the background at
+ * start, or in the background after the first frame, recording how long
+ * each took. A failing MAIN component throws from [start]; a failing
+ * background one fails its dependents and is rethrown from [await].
+ */
+class InitGraph(
+    components: List<Component<*>>,
+    private val scope: CoroutineScope,
+    private val background: CoroutineDispatcher = Dispatchers.Default,
+    private val nowMillis: () -> Long = { System.nanoTime() / 1_000_000 },
+    private val onTiming: (InitTiming) -> Unit = {}
+) {
+    private val order: List<Component<*>> = topologicalOrder(components)
+    private val results = order.associateWith { CompletableDeferred<Any>() }
+    private val recorded = CopyOnWriteArrayList<InitTiming>()
+    private var startMillis = 0L
+    private var started = false
+    private var firstFrame = false
+
+    val timings: List<InitTiming> get() = recorded.toList()
+
+    /** Time spent creating MAIN components, i.e. blocking the main thread. */
+    val mainThreadMillis: Long
+        get() = recorded.filter { it.phase == InitPhase.MAIN }.sumOf { it.durationMillis }
+
+    /** Creates the MAIN components in place and launches the BACKGROUND ones. Main thread. */
+    fun start() {
+        check(!started) { "InitGraph already started" }
+        started = true
+        startMillis = nowMillis()
+        for (component in order.filter { it.phase == InitPhase.MAIN }) {
+            results.getValue(component).complete(run(component).getOrThrow())
+        }
+        launchPhase(InitPhase.BACKGROUND)
+    }
+
+    /** Releases the AFTER_FIRST_FRAME components; later calls do nothing. Main thread. */
+    fun onFirstFrame() {
+        check(started) { "InitGraph not started" }
+        if (firstFrame) return
+        firstFrame = true
+        launchPhase(InitPhase.AFTER_FIRST_FRAME)
+    }
+
+    @Suppress("UNCHECKED_CAST")
+    suspend fun <T : Any> await(component: Component<T>): T = result(component).await() as T
+
+    /** A component that has already been created; MAIN ones always are after [start]. */
+    @OptIn(ExperimentalCoroutinesApi::class)
+    @Suppress("UNCHECKED_CAST")
+    fun <T : Any> get(component: Component<T>): T {
+        val deferred = result(component)
+        check(deferred.isCompleted) { "${component.name} is not initialized yet" }
+        return deferred.getCompleted() as T
+    }
+
+    private fun result(component: Component<*>) =
+        results[component] ?: throw IllegalArgumentException("${component.name} is not in the graph")
+
+    private fun launchPhase(phase: InitPhase) {
+        for (component in order.filter { it.phase == phase }) {
+            scope.launch(background) {
+                val result = try {
+                    component.dependsOn.forEach { results.getValue(it).await() }
+                    run(component)
+                } catch (e: Exception) {
+                    Result.failure(e)
+                }
+                result.fold(
+                    onSuccess = { results.getValue(component).complete(it) },
+                    onFailure = { results.getValue(component).completeExceptionally(it) }
+                )
+            }
+        }
+    }
+
+    private fun run(component: Component<*>): Result<Any> {
+        val begin = nowMillis()
+        val result = try {
+            Result.success(component.create())
+        } catch (e: Exception) {
+            Result.failure(e)
+        }
+        val timing = InitTiming(
+            name = component.name,
+            phase = component.phase,
+            startMillis = begin - startMillis,
+            durationMillis = nowMillis() - begin,
+            error = result.exceptionOrNull()
+        )
+        recorded += timing
+        onTiming(timing)
+        return result
+    }
+
+    private companion object {
+        fun topologicalOrder(components: List<Component<*>>): List<Component<*>> {
+            require(components.map { it.name }.toSet().size == components.size) {
+                "Duplicate component names"
+            }
+            val order = ArrayList<Component<*>>(components.size)
+            val visiting = HashSet<Component<*>>()
+            val done = HashSet<Component<*>>()
+            fun visit(component: Component<*>) {
+                if (component in done) return
+                require(visiting.add(component)) { "Dependency cycle through ${component.name}" }
+                for (dependency in component.dependsOn) {
+                    require(dependency in components) {
+                        "${component.name} depends on unknown ${dependency.name}"
+                    }
+                    require(dependency.phase <= component.phase) {
+                        "${component.name} (${component.phase}) cannot wait for " +
+                            "${dependency.name} (${dependency.phase})"
+                    }
+                    visit(dependency)
+                }
+                visiting.remove(component)
+                done += component
+                order += component
+            }
+            components.forEach(::visit)
+            return order
+        }
+    }
+}
@@ -0,0 +1,36 @@
+package com.mobilecomputing.videoconferencingapp.startup
+
+import android.util.Log
+
+/** Which screen the app became interactive on. */
+enum class StartupPath {
+    /** A persisted session was restored and the meeting UI shown directly. */
+    CACHED_SESSION,
+
+    /** No session: the sign-in screen was shown. */
+    COLD_SIGN_IN
+}
+
+data class TimeToInteractive(val path: StartupPath, val millis: Long)
+
+/**
+ * Time from application creation to the first frame of the first interactive
+ * screen. Created in Application.onCreate; only the first mark counts.
+ */
+class StartupTrace(private val nowMillis: () -> Long = { System.nanoTime() / 1_000_000 }) {
+    private val startMillis = nowMillis()
+
+    var timeToInteractive: TimeToInteractive? = null
+        private set
+
+    fun markInteractive(path: StartupPath) {
+        if (timeToInteractive != null) return
+        val tti = TimeToInteractive(path, nowMillis() - startMillis)
+        timeToInteractive = tti
+        Log.i(TAG, "time to interactive (${path.name.lowercase()}): ${tti.millis} ms")
+    }
+
+    private companion object {
+        const val TAG = "Startup"
+    }
+}
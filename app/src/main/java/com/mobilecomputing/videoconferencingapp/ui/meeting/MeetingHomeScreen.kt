@@ -0,0 +1,85 @@
+package com.mobilecomputing.videoconferencingapp.ui.meeting
+
+import androidx.compose.foundation.Image
+import androidx.compose.foundation.layout.*
+import androidx.compose.foundation.shape.CircleShape
+import androidx.compose.material3.*
+import androidx.compose.runtime.Composable
+import androidx.compose.ui.Alignment
+import androidx.compose.ui.Modifier
+import androidx.compose.ui.draw.clip
+import androidx.compose.ui.unit.dp
+import androidx.compose.ui.unit.sp
+import com.mobilecomputing.videoconferencingapp.auth.CachedSession
+import com.mobilecomputing.videoconferencingapp.home.HomeSnapshot
+import java.text.DateFormat
+import java.util.Date
+
+/** Post-login screen; [home] is null until the prefetch completes. */
+@Composable
+fun MeetingHomeScreen(
+    session: CachedSession,
+    home: HomeSnapshot?,
+    onSignOut: () -> Unit,
+    modifier: Modifier = Modifier
+) {
+    Column(
+        modifier = modifier
+            .fillMaxSize()
+            .padding(16.dp),
+        horizontalAlignment = Alignment.CenterHorizontally,
+        verticalArrangement = Arrangement.Center
+    ) {
+        Text(
+            text = "Video Conferencing App",
+            style = MaterialTheme.typography.headlineMedium,
+            fontSize = 24.sp
+        )
+
+        Spacer(modifier = Modifier.height(16.dp))
+
+        home?.avatar?.let { avatar ->
+            Image(
+                bitmap = avatar,
+                contentDescription = "Avatar",
+                modifier = Modifier
+                    .size(72.dp)
+                    .clip(CircleShape)
+            )
+            Spacer(modifier = Modifier.height(8.dp))
+        }
+
+        Text(
+            text = "Signed in as ${home?.profile?.displayName ?: session.displayName ?: session.uid}",
+            style = MaterialTheme.typography.bodyLarge,
+            color = MaterialTheme.colorScheme.primary
+        )
+        home?.profile?.email?.let { email ->
+            Text(text = email, style = MaterialTheme.typography.bodyMedium)
+        }
+
+        Spacer(modifier = Modifier.height(24.dp))
+
+        Text(text = "Upcoming meetings", style = MaterialTheme.typography.titleMedium)
+        Spacer(modifier = Modifier.height(8.dp))
+        when {
+            home == null -> CircularProgressIndicator(modifier = Modifier.size(24.dp))
+            home.meetings.isEmpty() -> Text(text = "No upcoming meetings")
+            else -> {
+                val format = DateFormat.getDateTimeInstance(DateFormat.MEDIUM, DateFormat.SHORT)
+                home.meetings.forEach { meeting ->
+                    Text(
+                        text = "${meeting.title} · ${format.format(Date(meeting.startsAtMillis))}",
+                        style = MaterialTheme.typography.bodyMedium
+                    )
+                }
+            }
+        }
+
+        Spacer(modifier = Modifier.height(24.dp))
+
+        OutlinedButton(onClick = onSignOut) {
+            Text(text = "Sign out")
+        }
+    }
+}
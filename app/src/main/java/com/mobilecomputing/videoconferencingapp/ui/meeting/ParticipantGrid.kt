@@ -0,0 +1,86 @@
+package com.mobilecomputing.videoconferencingapp.ui.meeting
+
+import androidx.compose.foundation.BorderStroke
+import androidx.compose.foundation.layout.*
+import androidx.compose.foundation.lazy.grid.GridCells
+import androidx.compose.foundation.lazy.grid.LazyVerticalGrid
+import androidx.compose.foundation.lazy.grid.items
+import androidx.compose.material3.*
+import androidx.compose.runtime.Composable
+import androidx.compose.ui.Alignment
+import androidx.compose.ui.Modifier
+import androidx.compose.ui.graphics.Color
+import androidx.compose.ui.text.style.TextOverflow
+import androidx.compose.ui.unit.dp
+import com.mobilecomputing.videoconferencingapp.room.ParticipantItem
+import com.mobilecomputing.videoconferencingapp.room.ParticipantList
+
+/**
+ * The call's participants as tiles. Keyed by uid, so when one participant
+ * changes only their tile recomposes, and tiles keep their state when others
+ * join or leave. [tile] draws each one. With a [visibility] tracker each
+ * tile reports whether it is on screen and at what size, so only those
+ * streams are received and decoded.
+ */
+@Composable
+fun ParticipantGrid(
+    participants: ParticipantList,
+    modifier: Modifier = Modifier,
+    visibility: TileVisibilityTracker? = null,
+    tile: @Composable (ParticipantItem) -> Unit = { ParticipantTile(it) }
+) {
+    if (visibility != null) TrackForeground(visibility)
+    LazyVerticalGrid(
+        columns = GridCells.Adaptive(minSize = 120.dp),
+        modifier = modifier.fillMaxSize(),
+        contentPadding = PaddingValues(8.dp),
+        horizontalArrangement = Arrangement.spacedBy(8.dp),
+        verticalArrangement = Arrangement.spacedBy(8.dp)
+    ) {
+        items(participants.items, key = { it.uid }, contentType = { "participant" }) { participant ->
+            if (visibility == null) {
+                tile(participant)
+            } else {
+                Box(Modifier.reportVisibility(visibility, participant.uid)) { tile(participant) }
+            }
+        }
+    }
+}
+
+@Composable
+fun ParticipantTile(participant: ParticipantItem, modifier: Modifier = Modifier) {
+    OutlinedCard(
+        modifier = modifier
+            .fillMaxWidth()
+            .aspectRatio(4f / 3f),
+        border = BorderStroke(
+            width = if (participant.speaking) 3.dp else 1.dp,
+            color = if (participant.speaking) MaterialTheme.colorScheme.primary else Color.Transparent
+        )
+    ) {
+        Box(modifier = Modifier.fillMaxSize().padding(8.dp)) {
+            if (!participant.videoEnabled) {
+                Text(
+                    text = participant.displayName.take(1).uppercase(),
+                    style = MaterialTheme.typography.headlineMedium,
+                    modifier = Modifier.align(Alignment.Center)
+                )
+            }
+            Row(
+                modifier = Modifier.align(Alignment.BottomStart),
+                verticalAlignment = Alignment.CenterVertically,
+                horizontalArrangement = Arrangement.spacedBy(4.dp)
+            ) {
+                Text(
+                    text = participant.displayName,
+                    style = MaterialTheme.typography.labelMedium,
+                    maxLines = 1,
+                    overflow = TextOverflow.Ellipsis,
+                    modifier = Modifier.weight(1f, fill = false)
+                )
+                if (participant.audioMuted) Text(text = "Muted", style = MaterialTheme.typography.labelSmall)
+                if (participant.handRaised) Text(text = "✋", style = MaterialTheme.typography.labelSmall)
+            }
+        }
+    }
+}
@@ -0,0 +1,119 @@
+package com.mobilecomputing.videoconferencingapp.ui.meeting
+
+import androidx.compose.runtime.Composable
+import androidx.compose.runtime.DisposableEffect
+import androidx.compose.ui.Modifier
+import androidx.compose.ui.geometry.Rect
+import androidx.compose.ui.layout.boundsInWindow
+import androidx.compose.ui.layout.onGloballyPositioned
+import androidx.compose.ui.unit.IntSize
+import androidx.lifecycle.Lifecycle
+import androidx.lifecycle.LifecycleEventObserver
+import androidx.lifecycle.compose.LocalLifecycleOwner
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+
+/**
+ * A video tile on screen: its rendered size in pixels, which picks the
+ * simulcast layer, and the fraction of it not clipped or covered.
+ */
+data class VisibleTile(val uid: String, val size: IntSize, val visibleFraction: Float)
+
+/**
+ * Which video tiles are on screen, for the media layer to subscribe to only
+ * those. Tiles report themselves with [reportVisibility]; a tile scrolled
+ * off, covered by an [occluder] such as the chat panel, or disposed drops
+ * out, and while the app is in the background [tiles] is empty. Call from
+ * the main thread.
+ */
+class TileVisibilityTracker(
+    // Tiles with less than this much showing count as hidden.
+    private val minVisibleFraction: Float = 0.05f
+) {
+    private val bounds = HashMap<String, Pair<IntSize, Rect>>()
+    private var occluder: Rect? = null
+    private var foreground = true
+    private val _tiles = MutableStateFlow<Map<String, VisibleTile>>(emptyMap())
+
+    /** The visible tiles by uid; only emits when the set or a size changes. */
+    val tiles: StateFlow<Map<String, VisibleTile>> = _tiles.asStateFlow()
+
+    /** A tile laid out at [size], of which [visible] (window coordinates) is unclipped. */
+    fun report(uid: String, size: IntSize, visible: Rect) {
+        bounds[uid] = size to visible
+        publish()
+    }
+
+    fun remove(uid: String) {
+        if (bounds.remove(uid) != null) publish()
+    }
+
+    /** A panel drawn over the tiles, in window coordinates, or null. */
+    fun setOccluder(rect: Rect?) {
+        if (occluder == rect) return
+        occluder = rect
+        publish()
+    }
+
+    fun setForeground(value: Boolean) {
+        if (foreground == value) return
+        foreground = value
+        publish()
+    }
+
+    private fun publish() {
+        if (!foreground) {
+            _tiles.value = emptyMap()
+            return
+        }
+        val visible = HashMap<String, VisibleTile>()
+        for ((uid, entry) in bounds) {
+            val (size, rect) = entry
+            val total = size.width.toFloat() * size.height
+            if (total <= 0f) continue
+            var shown = rect.width * rect.height
+            val covered = occluder?.takeIf { it.overlaps(rect) }?.let { rect.intersect(it) }
+            if (covered != null) shown -= covered.width * covered.height
+            val fraction = (shown / total).coerceIn(0f, 1f)
+            if (fraction >= minVisibleFraction) visible[uid] = VisibleTile(uid, size, fraction)
+        }
+        // Scrolling moves every tile each frame; only a changed set or size matters downstream.
+        val previous = _tiles.value
+        val same = previous.size == visible.size && visible.all { (uid, tile) ->
+            previous[uid]?.size == tile.size
+        }
+        if (!same) _tiles.value = visible
+    }
+}
+
+/**
+ * Reports this tile's rendered size and unclipped bounds to [tracker] on
+ * every layout, and removes it when it leaves the composition.
+ */
+@Composable
+fun Modifier.reportVisibility(tracker: TileVisibilityTracker, uid: String): Modifier {
+    DisposableEffect(tracker, uid) {
+        onDispose { tracker.remove(uid) }
+    }
+    return onGloballyPositioned { coordinates ->
+        tracker.report(uid, coordinates.size, coordinates.boundsInWindow())
+    }
+}
+
+/** Hides every tile in [tracker] while the hosting activity is stopped. */
+@Composable
+fun TrackForeground(tracker: TileVisibilityTracker) {
+    val lifecycle = LocalLifecycleOwner.current.lifecycle
+    DisposableEffect(lifecycle, tracker) {
+        val observer = LifecycleEventObserver { _, event ->
+            when (event) {
+                Lifecycle.Event.ON_START -> tracker.setForeground(true)
+                Lifecycle.Event.ON_STOP -> tracker.setForeground(false)
+                else -> Unit
+            }
+        }
+        lifecycle.addObserver(observer)
+        onDispose { lifecycle.removeObserver(observer) }
+    }
+}
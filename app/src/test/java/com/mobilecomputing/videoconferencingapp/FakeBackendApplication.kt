@@ -0,0 +1,28 @@
+package com.mobilecomputing.videoconferencingapp
+
+import com.mobilecomputing.videoconferencingapp.call.EncoderWarmup
+import com.mobilecomputing.videoconferencingapp.call.FakeSignalingConnection
+import com.mobilecomputing.videoconferencingapp.call.GatheredCandidates
+import com.mobilecomputing.videoconferencingapp.call.SignalingConnection
+import com.mobilecomputing.videoconferencingapp.home.FakeHomeDataSource
+import com.mobilecomputing.videoconferencingapp.home.HomeDataSource
+import com.mobilecomputing.videoconferencingapp.realtime.FrameTransport
+import com.mobilecomputing.videoconferencingapp.room.FakeRoomStateSource
+import com.mobilecomputing.videoconferencingapp.room.RoomStateSource
+import java.io.Closeable
+import java.io.IOException
+import java.net.DatagramSocket
+
+/** The application with every network- or device-backed component replaced by a fake. */
+abstract class FakeBackendApplication : VideoConferencingApplication() {
+    override fun createHomeDataSource(): HomeDataSource = FakeHomeDataSource()
+    override fun loadMediaEngine() {}
+    override suspend fun openSignaling(): SignalingConnection = FakeSignalingConnection()
+    override suspend fun gatherCallCandidates() = GatheredCandidates(DatagramSocket(), emptyList())
+    override fun createEncoderWarmup() = EncoderWarmup { Closeable {} }
+    override fun createRoomStateSource(): RoomStateSource = FakeRoomStateSource(clock = System::currentTimeMillis)
+
+    // The lobby starts the realtime connection; keep it offline, retrying with backoff,
+    // so it never dials out or asks the session for a token.
+    override suspend fun openRealtimeTransport(): FrameTransport = throw IOException("offline")
+}
@@ -0,0 +1,96 @@
+package com.mobilecomputing.videoconferencingapp
+
+import androidx.compose.ui.test.assertIsDisplayed
+import androidx.compose.ui.test.junit4.createAndroidComposeRule
+import androidx.compose.ui.test.onNodeWithText
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import com.mobilecomputing.videoconferencingapp.auth.CachedSession
+import com.mobilecomputing.videoconferencingapp.auth.FakeSessionSource
+import com.mobilecomputing.videoconferencingapp.auth.SessionLostException
+import com.mobilecomputing.videoconferencingapp.auth.SessionSource
+import com.mobilecomputing.videoconferencingapp.home.FakeHomeDataSource
+import com.mobilecomputing.videoconferencingapp.startup.StartupPath
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNotNull
+import org.junit.Rule
+import org.junit.Test
+import org.junit.runner.RunWith
+import org.robolectric.annotation.Config
+
+class CachedSessionApplication : FakeBackendApplication() {
+    override fun createSessionSource(): SessionSource = FakeSessionSource(CachedSession("uid-1", "Ada"))
+}
+
+class RevokedSessionApplication : FakeBackendApplication() {
+    override fun createSessionSource(): SessionSource = FakeSessionSource(
+        CachedSession("uid-1", "Ada"),
+        issue = { throw SessionLostException("revoked") }
+    )
+}
+
+class SignedOutApplication : FakeBackendApplication() {
+    override fun createSessionSource(): SessionSource = FakeSessionSource()
+}
+
+/**
+ * Startup routing and time-to-interactive. The reported times are from
+ * application creation to the first frame of the first screen, under
+ * Robolectric, for comparing the cached and cold paths rather than as
+ * device numbers.
+ */
+@RunWith(AndroidJUnit4::class)
+abstract class StartupTestBase {
+    @get:Rule
+    val composeRule = createAndroidComposeRule<MainActivity>()
+
+    protected val app get() = composeRule.activity.application as VideoConferencingApplication
+    protected val source get() = app.sessionSource as FakeSessionSource
+
+    protected fun reportTimeToInteractive(expected: StartupPath) {
+        composeRule.waitForIdle()
+        val tti = app.startupTrace.timeToInteractive
+        assertNotNull(tti)
+        assertEquals(expected, tti!!.path)
+        println("time to interactive (${tti.path.name.lowercase()}): ${tti.millis} ms")
+    }
+}
+
+@Config(application = CachedSessionApplication::class)
+class CachedSessionStartupTest : StartupTestBase() {
+    @Test
+    fun opensMeetingUiWithoutSignIn() {
+        composeRule.onNodeWithText("Signed in as Ada", substring = true).assertIsDisplayed()
+        composeRule.onNodeWithText("Sign in with Google").assertDoesNotExist()
+        assertEquals(1, source.restoreCalls)
+        // The refresher read the cached token and is waiting for its expiry.
+        assertEquals(listOf(false), source.tokenRequests)
+        reportTimeToInteractive(StartupPath.CACHED_SESSION)
+    }
+
+    @Test
+    fun rendersPrefetchedHomeData() {
+        composeRule.onNodeWithText("Signed in as Ada Lovelace").assertIsDisplayed()
+        composeRule.onNodeWithText("Design review", substring = true).assertIsDisplayed()
+        // One read of each, started from onCreate.
+        assertEquals(3, (app.initGraph.get(app.homeData) as FakeHomeDataSource).reads.size)
+    }
+}
+
+@Config(application = SignedOutApplication::class)
+class ColdStartupTest : StartupTestBase() {
+    @Test
+    fun showsSignInScreen() {
+        composeRule.onNodeWithText("Sign in with Google").assertIsDisplayed()
+        assertEquals(emptyList<Boolean>(), source.tokenRequests)
+        reportTimeToInteractive(StartupPath.COLD_SIGN_IN)
+    }
+}
+
+@Config(application = RevokedSessionApplication::class)
+class RevokedSessionStartupTest : StartupTestBase() {
+    @Test
+    fun fallsBackToSignInWhenTheSessionIsLost() {
+        composeRule.onNodeWithText("Sign in with Google").assertIsDisplayed()
+        assertEquals(1, source.signOuts)
+    }
+}
@@ -0,0 +1,31 @@
+package com.mobilecomputing.videoconferencingapp.auth
+
+/** In-memory [SessionSource]; tokens come from [issue], which may throw. */
+class FakeSessionSource(
+    var session: CachedSession? = null,
+    var issue: suspend (forceRefresh: Boolean) -> IdToken = { IdToken("token", Long.MAX_VALUE / 2) }
+) : SessionSource {
+    var restoreCalls = 0
+        private set
+    val tokenRequests = mutableListOf<Boolean>()
+    var signOuts = 0
+        private set
+
+    override fun restore(): CachedSession? {
+        ++restoreCalls
+        return session
+    }
+
+    override suspend fun signInWithGoogleIdToken(idToken: String): CachedSession =
+        CachedSession(uid = "uid-$idToken", displayName = null).also { session = it }
+
+    override suspend fun idToken(forceRefresh: Boolean): IdToken {
+        tokenRequests += forceRefresh
+        return issue(forceRefresh)
+    }
+
+    override fun signOut() {
+        ++signOuts
+        session = null
+    }
+}
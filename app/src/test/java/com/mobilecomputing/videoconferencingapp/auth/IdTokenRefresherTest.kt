@@ -0,0 +1,83 @@
+package com.mobilecomputing.videoconferencingapp.auth
+
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.test.TestScope
+import kotlinx.coroutines.test.runTest
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import java.io.IOException
+
+class IdTokenRefresherTest {
+    private val hour = 60 * 60_000L
+    private val minute = 60_000L
+
+    private fun TestScope.now() = testScheduler.currentTime
+
+    @Test
+    fun refreshesFiveMinutesBeforeExpiry() = runTest {
+        val source = FakeSessionSource(issue = { IdToken("t", now() + hour) })
+        val refresher = IdTokenRefresher(source, onSessionLost = {}, nowMillis = { now() })
+        backgroundScope.launch { refresher.run() }
+
+        testScheduler.advanceTimeBy(55 * minute - 1)
+        assertEquals(listOf(false), source.tokenRequests)
+        testScheduler.advanceTimeBy(2)
+        assertEquals(1, refresher.refreshes)
+        testScheduler.advanceTimeBy(55 * minute)
+        assertEquals(2, refresher.refreshes)
+        assertEquals(listOf(false, true, true), source.tokenRequests)
+    }
+
+    @Test
+    fun paceShortLivedAndSkewedTokens() = runTest {
+        // Lives four minutes, inside the five-minute margin.
+        val short = FakeSessionSource(issue = { IdToken("t", now() + 4 * minute) })
+        val shortRefresher = IdTokenRefresher(short, onSessionLost = {}, nowMillis = { now() })
+        // Already expired by the local clock.
+        val skewed = FakeSessionSource(issue = { IdToken("t", now() - minute) })
+        val skewedRefresher = IdTokenRefresher(skewed, onSessionLost = {}, nowMillis = { now() })
+        backgroundScope.launch { shortRefresher.run() }
+        backgroundScope.launch { skewedRefresher.run() }
+
+        testScheduler.advanceTimeBy(10 * minute + 1)
+        // Halfway through each four-minute token, and every 30 s for the skewed one.
+        assertEquals(5, shortRefresher.refreshes)
+        assertEquals(20, skewedRefresher.refreshes)
+    }
+
+    @Test
+    fun retriesTransientFailuresWithBackoff() = runTest {
+        var failures = 2
+        val source = FakeSessionSource(issue = { force ->
+            if (force && failures-- > 0) throw IOException("offline")
+            IdToken("t", now() + hour)
+        })
+        val refresher = IdTokenRefresher(source, onSessionLost = {}, nowMillis = { now() })
+        backgroundScope.launch { refresher.run() }
+
+        // Fails at 55 min, again 15 s later, then succeeds 30 s after that.
+        testScheduler.advanceTimeBy(55 * minute + 15_000 + 30_000 - 1)
+        assertEquals(0, refresher.refreshes)
+        testScheduler.advanceTimeBy(2)
+        assertEquals(1, refresher.refreshes)
+        assertEquals(listOf(false, true, true, true), source.tokenRequests)
+    }
+
+    @Test
+    fun reportsLostSessionAndStops() = runTest {
+        var lost = 0
+        val source = FakeSessionSource(issue = { force ->
+            if (force) throw SessionLostException("revoked")
+            IdToken("t", now() + 10 * minute)
+        })
+        val refresher = IdTokenRefresher(source, onSessionLost = { ++lost }, nowMillis = { now() })
+        val job = backgroundScope.launch { refresher.run() }
+
+        testScheduler.advanceTimeBy(hour)
+        assertEquals(1, lost)
+        assertTrue(job.isCompleted)
+        assertFalse(job.isCancelled)
+    }
+}
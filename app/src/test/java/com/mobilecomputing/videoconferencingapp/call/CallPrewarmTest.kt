@@ -0,0 +1,164 @@
+package com.mobilecomputing.videoconferencingapp.call
+
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.cancel
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.withContext
+import org.junit.After
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Assert.fail
+import org.junit.Test
+import java.io.Closeable
+import java.io.IOException
+import java.util.concurrent.CopyOnWriteArrayList
+
+/**
+ * Join latency against loopback stand-ins for the signaling and STUN
+ * servers. Sign-in is modelled as a fixed wait for the credential sheet;
+ * latency is measured from sign-in completing to the server admitting the
+ * client, cold (setup starts at join) and pre-warmed (setup started with
+ * the credential sheet).
+ */
+class CallPrewarmTest {
+    private val scope = CoroutineScope(SupervisorJob() + Dispatchers.Default)
+    private val signaling = LoopbackSignalingServer(helloDelayMillis = 150, joinDelayMillis = 20)
+    private val stun = LoopbackStunServer(delayMillis = 80)
+    private val encoders = CopyOnWriteArrayList<FakeEncoder>()
+
+    private class FakeEncoder : Closeable {
+        @Volatile
+        var closed = false
+
+        override fun close() {
+            closed = true
+        }
+    }
+
+    private val prewarmer = CallPrewarmer(
+        scope,
+        mediaEngine = { delay(100) },
+        connect = { LineSignalingConnection.open("127.0.0.1", signaling.port) },
+        gather = { gatherCandidates(stun.address, includeLoopback = true) },
+        encoders = {
+            withContext(Dispatchers.IO) { Thread.sleep(120) }
+            FakeEncoder().also { encoders += it }
+        }
+    )
+
+    @After
+    fun tearDown() {
+        scope.cancel()
+        signaling.close()
+        stun.close()
+    }
+
+    private suspend fun joinAfterSignIn(prewarm: Boolean): Long {
+        val setup = if (prewarm) prewarmer.start() else null
+        delay(CREDENTIAL_SHEET_MILLIS)
+        val begin = System.nanoTime()
+        val call = (setup ?: prewarmer.start()).join("room1", "id-token")
+        val latency = (System.nanoTime() - begin) / 1_000_000
+        call.close()
+        return latency
+    }
+
+    private suspend fun median(prewarm: Boolean) = List(5) { joinAfterSignIn(prewarm) }.sorted()[2]
+
+    private fun eventually(condition: () -> Boolean) {
+        val deadline = System.nanoTime() + 2_000_000_000L
+        while (!condition()) {
+            if (System.nanoTime() > deadline) fail("condition not met within 2 s")
+            Thread.sleep(10)
+        }
+    }
+
+    @Test
+    fun prewarmTakesSetupOffTheJoinPath() = runBlocking {
+        joinAfterSignIn(prewarm = true) // class loading and JIT
+        val cold = median(prewarm = false)
+        val warm = median(prewarm = true)
+        println("join latency after sign-in: cold $cold ms, pre-warmed $warm ms")
+
+        // Cold pays the slowest step (the 150 ms handshake); warm only AUTH and JOIN.
+        assertTrue("cold $cold ms", cold >= 150)
+        assertTrue("pre-warmed $warm ms", warm < 100)
+        assertTrue(warm * 2 < cold)
+        assertTrue(signaling.joins.all { it.startsWith("room1 ") && "srflx 127.0.0.1" in it })
+    }
+
+    @Test
+    fun cancelReleasesEverythingSetUp() = runBlocking {
+        val setup = prewarmer.start()
+        eventually { signaling.openConnections == 1 }
+        // Sign-in fails during the handshake.
+        setup.cancel()
+
+        eventually { signaling.openConnections == 0 }
+        delay(200) // let the encoder finish warming
+        assertEquals(1, encoders.size)
+        assertTrue(encoders.all { it.closed })
+        assertTrue(signaling.joins.isEmpty())
+    }
+
+    @Test
+    fun failedJoinReleasesTheSetup() = runBlocking {
+        val setup = prewarmer.start()
+        try {
+            setup.join("room1", idToken = "")
+            fail("join with an empty token succeeded")
+        } catch (e: IOException) {
+            assertTrue(e.message!!.contains("DENIED"))
+        }
+        eventually { signaling.openConnections == 0 }
+        assertTrue(encoders.all { it.closed })
+    }
+
+    @Test
+    fun failedStepReleasesTheSetup() = runBlocking {
+        val unreachable = CallPrewarmer(
+            scope,
+            mediaEngine = {},
+            connect = { throw IOException("signaling unreachable") },
+            gather = { gatherCandidates(stun.address, includeLoopback = true) },
+            encoders = { FakeEncoder().also { encoders += it } }
+        )
+        val setup = unreachable.start()
+        eventually { setup.isReleased }
+        delay(200) // let steps already running finish
+        assertTrue(encoders.all { it.closed })
+        try {
+            setup.join("room1", "id-token")
+            fail("joined a setup whose connect failed")
+        } catch (e: Exception) {
+            // The connect failure, or cancellation of a step it cut short.
+        }
+    }
+
+    @Test
+    fun idleSetupReleasesItself() = runBlocking {
+        val idle = CallPrewarmer(
+            scope,
+            mediaEngine = {},
+            connect = { LineSignalingConnection.open("127.0.0.1", signaling.port) },
+            gather = { gatherCandidates(stun.address, includeLoopback = true) },
+            encoders = { FakeEncoder().also { encoders += it } },
+            idleTimeoutMillis = 300
+        )
+        val setup = idle.start()
+        eventually { signaling.openConnections == 1 }
+        assertFalse(setup.isReleased)
+
+        eventually { setup.isReleased }
+        eventually { signaling.openConnections == 0 }
+        assertTrue(encoders.all { it.closed })
+    }
+
+    private companion object {
+        const val CREDENTIAL_SHEET_MILLIS = 400L
+    }
+}
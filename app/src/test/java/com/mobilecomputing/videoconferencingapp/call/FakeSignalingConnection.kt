@@ -0,0 +1,14 @@
+package com.mobilecomputing.videoconferencingapp.call
+
+class FakeSignalingConnection : SignalingConnection {
+    var closed = false
+        private set
+
+    override suspend fun authenticate(idToken: String) {}
+
+    override suspend fun join(roomId: String, candidates: List<IceCandidate>) = "call-$roomId"
+
+    override fun close() {
+        closed = true
+    }
+}
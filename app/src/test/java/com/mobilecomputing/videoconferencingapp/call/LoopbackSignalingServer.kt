@@ -0,0 +1,80 @@
+package com.mobilecomputing.videoconferencingapp.call
+
+import java.io.Closeable
+import java.net.InetAddress
+import java.net.ServerSocket
+import java.net.Socket
+import java.net.SocketException
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicInteger
+import kotlin.concurrent.thread
+
+/**
+ * In-process stand-in for the signaling server on 127.0.0.1, speaking the
+ * LineSignalingConnection protocol. [helloDelayMillis] stands for TLS and
+ * server-side session setup, [joinDelayMillis] for room admission.
+ */
+class LoopbackSignalingServer(
+    private val helloDelayMillis: Long = 0,
+    private val joinDelayMillis: Long = 0
+) : Closeable {
+    private val server = ServerSocket(0, 50, InetAddress.getLoopbackAddress())
+    private val clients = CopyOnWriteArrayList<Socket>()
+    private val nextCall = AtomicInteger()
+
+    val port: Int get() = server.localPort
+
+    /** JOIN lines received, without the verb. */
+    val joins = CopyOnWriteArrayList<String>()
+    val openConnections: Int get() = clients.count { !it.isClosed }
+
+    init {
+        thread(isDaemon = true, name = "loopback-signaling") {
+            while (!server.isClosed) {
+                val client = try {
+                    server.accept()
+                } catch (e: SocketException) {
+                    break
+                }
+                clients += client
+                thread(isDaemon = true) { serve(client) }
+            }
+        }
+    }
+
+    private fun serve(client: Socket) = client.use {
+        val reader = client.getInputStream().bufferedReader()
+        val writer = client.getOutputStream().bufferedWriter()
+        fun reply(line: String) {
+            writer.write(line)
+            writer.newLine()
+            writer.flush()
+        }
+        try {
+            while (true) {
+                val line = reader.readLine() ?: break
+                val parts = line.split(" ", limit = 3)
+                when (parts[0]) {
+                    "HELLO" -> {
+                        Thread.sleep(helloDelayMillis)
+                        reply("WELCOME")
+                    }
+                    "AUTH" -> reply(if (parts.size == 2 && parts[1].isNotEmpty()) "OK" else "DENIED")
+                    "JOIN" -> {
+                        Thread.sleep(joinDelayMillis)
+                        joins += line.removePrefix("JOIN ")
+                        reply("JOINED c${nextCall.incrementAndGet()}")
+                    }
+                    else -> reply("ERROR")
+                }
+            }
+        } catch (e: SocketException) {
+            // Client went away.
+        }
+    }
+
+    override fun close() {
+        server.close()
+        clients.forEach { it.close() }
+    }
+}
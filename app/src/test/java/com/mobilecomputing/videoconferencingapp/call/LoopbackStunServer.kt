@@ -0,0 +1,51 @@
+package com.mobilecomputing.videoconferencingapp.call
+
+import java.io.Closeable
+import java.net.DatagramPacket
+import java.net.DatagramSocket
+import java.net.InetAddress
+import java.net.InetSocketAddress
+import java.net.SocketException
+import java.nio.ByteBuffer
+import kotlin.concurrent.thread
+
+/** Answers STUN binding requests on 127.0.0.1 with XOR-MAPPED-ADDRESS, after [delayMillis]. */
+class LoopbackStunServer(private val delayMillis: Long = 0) : Closeable {
+    private val socket = DatagramSocket(InetSocketAddress(InetAddress.getLoopbackAddress(), 0))
+
+    val address: InetSocketAddress get() = InetSocketAddress(InetAddress.getLoopbackAddress(), socket.localPort)
+
+    init {
+        thread(isDaemon = true, name = "loopback-stun") {
+            val buffer = ByteArray(512)
+            while (!socket.isClosed) {
+                val packet = DatagramPacket(buffer, buffer.size)
+                try {
+                    socket.receive(packet)
+                } catch (e: SocketException) {
+                    break
+                }
+                if (packet.length < 20 || buffer[0].toInt() != 0 || buffer[1].toInt() != 1) continue
+                Thread.sleep(delayMillis)
+                val transaction = buffer.copyOfRange(8, 20)
+                val address = packet.address.address
+                val cookie = ByteBuffer.allocate(4).putInt(0x2112A442).array()
+                val response = ByteBuffer.allocate(32)
+                    .putShort(0x0101)
+                    .putShort(12)
+                    .putInt(0x2112A442)
+                    .put(transaction)
+                    .putShort(0x0020)
+                    .putShort(8)
+                    .put(0)
+                    .put(1)
+                    .putShort((packet.port xor 0x2112).toShort())
+                    .put(ByteArray(4) { (address[it].toInt() xor cookie[it].toInt()).toByte() })
+                    .array()
+                socket.send(DatagramPacket(response, response.size, packet.socketAddress))
+            }
+        }
+    }
+
+    override fun close() = socket.close()
+}
@@ -0,0 +1,35 @@
+package com.mobilecomputing.videoconferencingapp.home
+
+import kotlinx.coroutines.delay
+
+/** Answers each read after a fixed delay; a null result stands for "missing". */
+class FakeHomeDataSource(
+    var profile: UserProfile? = UserProfile("Ada Lovelace", "ada@example.com"),
+    var meetings: List<UpcomingMeeting> = listOf(UpcomingMeeting("m1", "Design review", 0L)),
+    var avatar: ByteArray? = null,
+    var profileDelayMillis: Long = 0,
+    var avatarDelayMillis: Long = 0,
+    var meetingsDelayMillis: Long = 0,
+    var failMeetings: Boolean = false
+) : HomeDataSource {
+    val reads = mutableListOf<String>()
+
+    override suspend fun profile(uid: String): UserProfile? {
+        reads += "profile"
+        delay(profileDelayMillis)
+        return profile
+    }
+
+    override suspend fun avatar(uid: String): ByteArray? {
+        reads += "avatar"
+        delay(avatarDelayMillis)
+        return avatar
+    }
+
+    override suspend fun upcomingMeetings(uid: String, fromMillis: Long, limit: Int): List<UpcomingMeeting> {
+        reads += "meetings"
+        delay(meetingsDelayMillis)
+        if (failMeetings) throw IllegalStateException("offline")
+        return meetings.take(limit)
+    }
+}
@@ -0,0 +1,83 @@
+package com.mobilecomputing.videoconferencingapp.home
+
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import com.mobilecomputing.videoconferencingapp.auth.CachedSession
+import kotlinx.coroutines.test.runTest
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNotSame
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertSame
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import org.junit.runner.RunWith
+
+// Robolectric for android.util.Log.
+@RunWith(AndroidJUnit4::class)
+class HomeRepositoryTest {
+    private val session = CachedSession("uid-1", "Ada")
+
+    @Test
+    fun readsRunConcurrently() = runTest {
+        val source = FakeHomeDataSource(
+            profileDelayMillis = 300,
+            avatarDelayMillis = 200,
+            meetingsDelayMillis = 400
+        )
+        val repository = HomeRepository(source, backgroundScope, decodeAvatar = { null })
+
+        val snapshot = repository.load(session)
+
+        // The slowest read, not the 900 ms sum.
+        assertEquals(400L, testScheduler.currentTime)
+        assertEquals("Ada Lovelace", snapshot.profile.displayName)
+        assertEquals(listOf("Design review"), snapshot.meetings.map { it.title })
+    }
+
+    @Test
+    fun failedOrMissingPartsLeaveTheRestIntact() = runTest {
+        val source = FakeHomeDataSource(profile = null, failMeetings = true)
+        val repository = HomeRepository(source, backgroundScope, decodeAvatar = { null })
+
+        val snapshot = repository.load(session)
+
+        assertEquals("Ada", snapshot.profile.displayName)
+        assertTrue(snapshot.meetings.isEmpty())
+        assertNull(snapshot.avatar)
+    }
+
+    @Test
+    fun prefetchIsSharedUntilCleared() = runTest {
+        val source = FakeHomeDataSource(meetingsDelayMillis = 100)
+        val repository = HomeRepository(source, backgroundScope, decodeAvatar = { null })
+
+        val first = repository.prefetch(session)
+        assertSame(first, repository.prefetch(session))
+        first.await()
+        assertEquals(3, source.reads.size)
+
+        repository.clear()
+        repository.prefetch(session).await()
+        assertEquals(6, source.reads.size)
+    }
+
+    @Test
+    fun staleSnapshotIsReloaded() = runTest {
+        val source = FakeHomeDataSource()
+        var now = 0L
+        val repository = HomeRepository(
+            source, backgroundScope, nowMillis = { now }, decodeAvatar = { null }, maxAgeMillis = 1_000
+        )
+
+        val first = repository.prefetch(session)
+        first.await()
+        now = 999
+        assertSame(first, repository.prefetch(session))
+        assertEquals(3, source.reads.size)
+
+        now = 1_000
+        val second = repository.prefetch(session)
+        assertNotSame(first, second)
+        second.await()
+        assertEquals(6, source.reads.size)
+    }
+}
@@ -0,0 +1,193 @@
+package com.mobilecomputing.videoconferencingapp.realtime
+
+import java.io.BufferedInputStream
+import java.io.BufferedOutputStream
+import java.io.ByteArrayInputStream
+import java.io.Closeable
+import java.io.DataInputStream
+import java.io.DataOutputStream
+import java.io.IOException
+import java.net.InetAddress
+import java.net.ServerSocket
+import java.net.Socket
+import java.nio.ByteBuffer
+import java.util.concurrent.CopyOnWriteArrayList
+import kotlin.concurrent.thread
+
+/**
+ * In-process stand-in for the realtime server on 127.0.0.1: streams with
+ * credit, PUBLISH fan-out to every subscriber (the sender included) and
+ * PING. An empty ID token is refused with GOAWAY. Events beyond a stream's
+ * credit wait here, as on the real server, and [pending] shows them.
+ */
+class LoopbackRealtimeServer : Closeable {
+    private val server = ServerSocket(0, 50, InetAddress.getLoopbackAddress())
+    private val connections = CopyOnWriteArrayList<Connection>()
+
+    val port: Int get() = server.localPort
+    val openConnections: Int get() = connections.count { !it.socket.isClosed }
+
+    /** When false, PINGs go unanswered. */
+    @Volatile
+    var answerPings = true
+
+    /** Connections accepted so far, including refused and dropped ones. */
+    @Volatile
+    var accepted = 0
+        private set
+
+    init {
+        thread(isDaemon = true, name = "loopback-realtime") {
+            while (!server.isClosed) {
+                val socket = try {
+                    server.accept()
+                } catch (e: IOException) {
+                    break
+                }
+                socket.tcpNoDelay = true
+                accepted++
+                val connection = Connection(socket)
+                connections += connection
+                thread(isDaemon = true) { connection.serve() }
+            }
+        }
+    }
+
+    fun transport(): suspend () -> FrameTransport = { SocketFrameTransport.connect("127.0.0.1", port) }
+
+    /** Sends [bodies] to every subscriber of [topic] and [key], as if another client published them. */
+    fun broadcast(topic: Topic, key: String, vararg bodies: ByteArray) {
+        val touched = HashSet<Connection>()
+        bodies.forEach { fanOut(topic, key, it, touched) }
+        touched.forEach { it.flush() }
+    }
+
+    /** Open subscriptions to [topic] and [key] across connections. */
+    fun subscriptions(topic: Topic, key: String): Int =
+        connections.sumOf { c -> synchronized(c) { c.streams.values.count { it.topic == topic && it.key == key } } }
+
+    /** Events for [topic] and [key] held back for lack of credit. */
+    fun pending(topic: Topic, key: String): Int = connections.sumOf { c ->
+        synchronized(c) { c.streams.values.filter { it.topic == topic && it.key == key }.sumOf { it.pending.size } }
+    }
+
+    /** Cuts every connection, as a network change would. */
+    fun dropConnections() {
+        connections.forEach { it.socket.close() }
+    }
+
+    override fun close() {
+        server.close()
+        dropConnections()
+    }
+
+    private fun fanOut(topic: Topic, key: String, body: ByteArray, touched: MutableSet<Connection>) {
+        for (connection in connections) {
+            if (connection.deliver(topic, key, body)) touched += connection
+        }
+    }
+
+    private class Subscription(val topic: Topic, val key: String, var credit: Int) {
+        val pending = ArrayDeque<ByteArray>()
+    }
+
+    private inner class Connection(val socket: Socket) {
+        private val input = DataInputStream(BufferedInputStream(socket.getInputStream(), 64 * 1024))
+        private val output = DataOutputStream(BufferedOutputStream(socket.getOutputStream(), 64 * 1024))
+        val streams = HashMap<Int, Subscription>() // Guarded by this.
+        private var authenticated = false
+
+        /** Queues [body] on matching streams; true if anything was written. */
+        fun deliver(topic: Topic, key: String, body: ByteArray): Boolean = synchronized(this) {
+            if (!authenticated) return false
+            var wrote = false
+            for ((id, sub) in streams) {
+                if (sub.topic != topic || sub.key != key) continue
+                if (sub.credit == 0) {
+                    sub.pending.addLast(body)
+                } else {
+                    if (sub.credit > 0) sub.credit--
+                    write(Frame(FrameType.DATA, id, body))
+                    wrote = true
+                }
+            }
+            wrote
+        }
+
+        fun flush() = synchronized(this) {
+            try {
+                output.flush()
+            } catch (e: IOException) {
+                socket.close()
+            }
+        }
+
+        private fun write(frame: Frame) {
+            try {
+                output.writeFrame(frame)
+            } catch (e: IOException) {
+                socket.close()
+            }
+        }
+
+        fun serve() {
+            val touched = HashSet<Connection>()
+            try {
+                while (true) {
+                    handle(input.readFrame(), touched)
+                    // Flush once the client's burst is read, not per frame.
+                    if (input.available() == 0) {
+                        touched.forEach { it.flush() }
+                        touched.clear()
+                        flush()
+                    }
+                }
+            } catch (e: IOException) {
+                // Client went away, or was cut.
+            } finally {
+                socket.close()
+                synchronized(this) { streams.clear() }
+            }
+        }
+
+        private fun handle(frame: Frame, touched: MutableSet<Connection>) {
+            when (frame.type) {
+                FrameType.HELLO -> synchronized(this) {
+                    if (frame.payload.isEmpty()) {
+                        write(Frame(FrameType.GOAWAY, 0, "unauthenticated".encodeToByteArray()))
+                    } else {
+                        authenticated = true
+                        write(Frame(FrameType.HELLO_OK, 0))
+                    }
+                }
+                FrameType.OPEN -> synchronized(this) {
+                    val buffer = ByteBuffer.wrap(frame.payload)
+                    val topic = Topic.of(buffer.get().toInt() and 0xFF)
+                    val credit = buffer.int
+                    val key = String(frame.payload, 5, frame.payload.size - 5)
+                    streams[frame.stream] = Subscription(topic, key, credit)
+                }
+                FrameType.CLOSE -> synchronized(this) { streams.remove(frame.stream) }
+                FrameType.CREDIT -> synchronized(this) {
+                    // Credit for a stream not (yet) open on this connection is ignored.
+                    val sub = streams[frame.stream] ?: return
+                    sub.credit += ByteBuffer.wrap(frame.payload).int
+                    while (sub.credit > 0 && sub.pending.isNotEmpty()) {
+                        sub.credit--
+                        write(Frame(FrameType.DATA, frame.stream, sub.pending.removeFirst()))
+                    }
+                }
+                FrameType.PUBLISH -> {
+                    val body = DataInputStream(ByteArrayInputStream(frame.payload))
+                    val topic = Topic.of(body.readUnsignedByte())
+                    val key = body.readUTF()
+                    fanOut(topic, key, body.readBytes(), touched)
+                }
+                FrameType.PING -> synchronized(this) {
+                    if (answerPings) write(Frame(FrameType.PONG, 0, frame.payload))
+                }
+                else -> throw IOException("Unexpected ${frame.type}")
+            }
+        }
+    }
+}
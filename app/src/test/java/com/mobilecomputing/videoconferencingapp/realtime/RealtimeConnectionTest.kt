@@ -0,0 +1,370 @@
+package com.mobilecomputing.videoconferencingapp.realtime
+
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitCancellation
+import kotlinx.coroutines.cancel
+import kotlinx.coroutines.cancelAndJoin
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.channels.ClosedSendChannelException
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.drop
+import kotlinx.coroutines.flow.first
+import kotlinx.coroutines.flow.onEach
+import kotlinx.coroutines.flow.take
+import kotlinx.coroutines.flow.toList
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.withTimeout
+import org.junit.After
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Assert.fail
+import org.junit.Test
+import java.io.IOException
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * RealtimeConnection against a loopback stand-in server: multiplexing,
+ * cold flows, throughput and latency, and that a slow collector on one
+ * topic neither loses lossless events nor holds up the others.
+ */
+class RealtimeConnectionTest {
+    private val scope = CoroutineScope(SupervisorJob() + Dispatchers.Default)
+    private val server = LoopbackRealtimeServer()
+    private val connections = CopyOnWriteArrayList<RealtimeConnection>()
+
+    @After
+    fun tearDown() {
+        connections.forEach { it.close() }
+        scope.cancel()
+        server.close()
+    }
+
+    private fun connection() = RealtimeConnection(
+        scope,
+        connect = server.transport(),
+        idToken = { "id-token" },
+        reconnectDelayMillis = { 10 }
+    ).also { connections += it }
+
+    private suspend fun eventually(condition: () -> Boolean) = withTimeout(5_000) {
+        while (!condition()) delay(5)
+    }
+
+    @Test
+    fun allTopicsShareOneConnection() = runBlocking {
+        val room = RoomChannel(connection(), "room1", "alice")
+        val chat = scope.async { room.chat().first() }
+        val reaction = scope.async { room.reactions().first() }
+        val presence = scope.async { room.presence().first { it.isNotEmpty() } }
+        val signaling = scope.async { room.signaling().first() }
+        eventually { Topic.entries.all { server.subscriptions(it, "room1") == 1 } }
+
+        room.sendChat("hi")
+        room.react("👍")
+        room.setPresence(PresenceStatus.IN_CALL)
+        room.sendSignaling(byteArrayOf(1, 2, 3))
+
+        withTimeout(5_000) {
+            assertEquals("hi", chat.await().text)
+            assertEquals("👍", reaction.await().emoji)
+            assertEquals(mapOf("alice" to PresenceStatus.IN_CALL), presence.await())
+            assertEquals(listOf<Byte>(1, 2, 3), signaling.await().toList())
+        }
+        assertEquals(1, server.accepted)
+    }
+
+    @Test
+    fun flowsAreColdAndCancellingClosesTheStream() = runBlocking {
+        val chat = RoomChannel(connection(), "room1", "alice").chat()
+        delay(100)
+        assertEquals(0, server.subscriptions(Topic.CHAT, "room1"))
+
+        val collector = scope.launch { chat.collect {} }
+        eventually { server.subscriptions(Topic.CHAT, "room1") == 1 }
+        collector.cancelAndJoin()
+        eventually { server.subscriptions(Topic.CHAT, "room1") == 0 }
+    }
+
+    @Test
+    fun chatThroughput() = runBlocking {
+        val alice = RoomChannel(connection(), "room1", "alice")
+        val bob = RoomChannel(connection(), "room1", "bob")
+        val received = scope.async { alice.chat().take(MESSAGES).toList() }
+        eventually { server.subscriptions(Topic.CHAT, "room1") == 1 }
+
+        val begin = System.nanoTime()
+        repeat(MESSAGES) { bob.sendChat("m$it") }
+        val messages = withTimeout(30_000) { received.await() }
+        val perSecond = MESSAGES * 1e9 / (System.nanoTime() - begin)
+
+        println("chat throughput: %.0f events/s".format(perSecond))
+        assertEquals(List(MESSAGES) { "m$it" }, messages.map { it.text })
+        assertTrue("only %.0f events/s".format(perSecond), perSecond >= 20_000)
+    }
+
+    @Test
+    fun publishToDeliveryLatency() = runBlocking {
+        val connection = connection()
+        val room = RoomChannel(connection, "room1", "alice")
+        val arrivals = Channel<Long>(Channel.UNLIMITED)
+        scope.launch { room.chat().collect { arrivals.send(System.nanoTime()) } }
+        eventually { server.subscriptions(Topic.CHAT, "room1") == 1 }
+
+        repeat(50) { room.sendChat("warm-up"); arrivals.receive() }
+        val latencies = List(500) {
+            val begin = System.nanoTime()
+            room.sendChat("m$it")
+            (withTimeout(5_000) { arrivals.receive() } - begin) / 1_000
+        }.sorted()
+        val p50 = latencies[latencies.size / 2]
+        val p99 = latencies[latencies.size * 99 / 100]
+        val ping = connection.ping() / 1_000
+
+        println("publish → delivery: p50 $p50 µs, p99 $p99 µs; ping $ping µs")
+        assertTrue("p50 $p50 µs", p50 < 5_000)
+        assertTrue("p99 $p99 µs", p99 < 50_000)
+    }
+
+    @Test
+    fun slowChatCollectorDoesNotStallReactionsOrLoseMessages() = runBlocking {
+        val alice = RoomChannel(connection(), "room1", "alice")
+        val bob = RoomChannel(connection(), "room1", "bob")
+        val release = CompletableDeferred<Unit>()
+        val chat = scope.async { alice.chat().onEach { release.await() }.take(1_000).toList() }
+        eventually { server.subscriptions(Topic.CHAT, "room1") == 1 }
+
+        repeat(1_000) { bob.sendChat("m$it") }
+        // The backlog stays on the server, beyond the stream's credit...
+        eventually { server.pending(Topic.CHAT, "room1") >= 1_000 - 65 }
+
+        // ...and reactions on the same connection still get through.
+        val reactions = scope.async { alice.reactions().take(5).toList() }
+        eventually { server.subscriptions(Topic.REACTIONS, "room1") == 1 }
+        repeat(5) { bob.react("r$it") }
+        assertEquals(List(5) { "r$it" }, withTimeout(5_000) { reactions.await() }.map { it.emoji })
+
+        release.complete(Unit)
+        assertEquals(List(1_000) { "m$it" }, withTimeout(10_000) { chat.await() }.map { it.text })
+        assertEquals(0, server.pending(Topic.CHAT, "room1"))
+    }
+
+    @Test
+    fun slowReactionCollectorSeesTheNewest() = runBlocking {
+        val alice = RoomChannel(connection(), "room1", "alice")
+        val bob = RoomChannel(connection(), "room1", "bob")
+        val release = CompletableDeferred<Unit>()
+        val seen = CopyOnWriteArrayList<String>()
+        val reactions = scope.async {
+            alice.reactions().onEach { seen += it.emoji; release.await() }.first { it.emoji == "r99" }
+        }
+        val marker = scope.async { alice.chat().first() }
+        eventually {
+            server.subscriptions(Topic.REACTIONS, "room1") == 1 && server.subscriptions(Topic.CHAT, "room1") == 1
+        }
+
+        // r0 is taken before the rest arrive, so the buffer holds only later ones.
+        bob.react("r0")
+        eventually { seen.size == 1 }
+        for (i in 1 until 100) bob.react("r$i")
+        // Bob's frames arrive in order, so the chat follows every reaction.
+        bob.sendChat("done")
+        withTimeout(5_000) { marker.await() }
+
+        release.complete(Unit)
+        withTimeout(5_000) { reactions.await() }
+        assertEquals(listOf("r0") + (68 until 100).map { "r$it" }, seen)
+    }
+
+    @Test
+    fun slowPresenceCollectorSeesLatestPerParticipant() = runBlocking {
+        val alice = RoomChannel(connection(), "room1", "alice")
+        val bob = connection()
+        val participants = List(20) { RoomChannel(bob, "room1", "user$it") }
+        val release = CompletableDeferred<Unit>()
+        var emissions = 0
+        val expected = participants.indices.associate { "user$it" to PresenceStatus.entries[it % 4] }
+        val roster = scope.async {
+            alice.presence().drop(1).onEach { emissions++; release.await() }.first { it == expected }
+        }
+        val marker = scope.async { alice.chat().first() }
+        eventually {
+            server.subscriptions(Topic.PRESENCE, "room1") == 1 && server.subscriptions(Topic.CHAT, "room1") == 1
+        }
+
+        // Five updates each, ending on the expected status.
+        for (round in 4 downTo 0) {
+            participants.forEachIndexed { i, p -> p.setPresence(PresenceStatus.entries[(i + round) % 4]) }
+        }
+        participants[0].sendChat("done")
+        withTimeout(5_000) { marker.await() }
+
+        release.complete(Unit)
+        assertEquals(expected, withTimeout(5_000) { roster.await() })
+        // One taken before the stall, then one per participant at most.
+        assertTrue("$emissions emissions for 100 updates", emissions <= 21)
+    }
+
+    @Test
+    fun reconnectsAndReopensStreams() = runBlocking {
+        val alice = connection()
+        val bob = connection()
+        val received = Channel<ChatMessage>(Channel.UNLIMITED)
+        scope.launch { RoomChannel(alice, "room1", "alice").chat().collect { received.send(it) } }
+        eventually { server.subscriptions(Topic.CHAT, "room1") == 1 }
+        bob.start()
+        eventually { bob.state.value == RealtimeConnection.State.CONNECTED }
+
+        server.dropConnections()
+        // Publishes are at most once, so bob waits to be back before sending.
+        eventually { listOf(alice, bob).all { it.connections == 2 && it.state.value == RealtimeConnection.State.CONNECTED } }
+        eventually { server.subscriptions(Topic.CHAT, "room1") == 1 }
+
+        RoomChannel(bob, "room1", "bob").sendChat("after")
+        assertEquals("after", withTimeout(5_000) { received.receive() }.text)
+    }
+
+    @Test
+    fun stopDisconnectsUntilStartedAgain() = runBlocking {
+        val alice = connection()
+        val received = Channel<ChatMessage>(Channel.UNLIMITED)
+        scope.launch { RoomChannel(alice, "room1", "alice").chat().collect { received.send(it) } }
+        eventually { server.subscriptions(Topic.CHAT, "room1") == 1 }
+
+        alice.stop()
+        assertEquals(RealtimeConnection.State.IDLE, alice.state.value)
+        eventually { server.openConnections == 0 }
+        delay(100)
+        assertEquals(1, server.accepted)
+
+        // The open flow carries on once started again.
+        alice.start()
+        eventually { server.subscriptions(Topic.CHAT, "room1") == 1 }
+        RoomChannel(connection(), "room1", "bob").sendChat("back")
+        assertEquals("back", withTimeout(5_000) { received.receive() }.text)
+    }
+
+    @Test
+    fun givesUpAfterRepeatedFailuresUntilStartedAgain() = runBlocking {
+        val attempts = AtomicInteger()
+        val connection = RealtimeConnection(
+            scope,
+            connect = {
+                attempts.incrementAndGet()
+                throw IOException("unreachable")
+            },
+            idToken = { "id-token" },
+            reconnectDelayMillis = { 10 },
+            maxFailedAttempts = 3
+        ).also { connections += it }
+        connection.start()
+        eventually { connection.state.value == RealtimeConnection.State.IDLE }
+        delay(100)
+        assertEquals(3, attempts.get())
+
+        // A ping starts it again, and fails rather than waiting forever.
+        val ping = runCatching { withTimeout(5_000) { connection.ping() } }
+        assertTrue(ping.exceptionOrNull() is IOException)
+        assertEquals(6, attempts.get())
+    }
+
+    @Test
+    fun refusedTokenNeverConnects() = runBlocking {
+        val connection = RealtimeConnection(scope, server.transport(), { "" }, { 10 }).also { connections += it }
+        connection.start()
+        eventually { server.accepted >= 3 }
+        assertTrue(connection.state.value != RealtimeConnection.State.CONNECTED)
+        assertEquals(0, connection.connections)
+    }
+
+    @Test
+    fun malformedEventFailsOnlyItsStream() = runBlocking {
+        val connection = connection()
+        val room = RoomChannel(connection, "room1", "alice")
+        val presence = scope.async { room.presence().first { "alice" in it } }
+        val chat = scope.async { room.chat().first() }
+        // A key function that cannot read the event fails its stream alone.
+        val strict = scope.async {
+            runCatching { connection.subscribe(Topic.PRESENCE, "room2", Delivery.LatestPerKey { error("bad") }).first() }
+        }
+        eventually {
+            server.subscriptions(Topic.PRESENCE, "room1") == 1 && server.subscriptions(Topic.PRESENCE, "room2") == 1 &&
+                server.subscriptions(Topic.CHAT, "room1") == 1
+        }
+
+        // A truncated presence event from another client, then valid ones.
+        server.broadcast(Topic.PRESENCE, "room1", byteArrayOf(0, 9, 'b'.code.toByte()))
+        server.broadcast(Topic.PRESENCE, "room2", byteArrayOf(1))
+        room.setPresence(PresenceStatus.ONLINE)
+        room.sendChat("still here")
+
+        withTimeout(5_000) {
+            assertTrue(strict.await().exceptionOrNull() is IOException)
+            assertEquals(mapOf("alice" to PresenceStatus.ONLINE), presence.await())
+            assertEquals("still here", chat.await().text)
+        }
+        assertEquals(1, connection.connections)
+    }
+
+    @Test
+    fun closedConnectionFailsFast() = runBlocking {
+        val connection = connection()
+        connection.start()
+        eventually { connection.state.value == RealtimeConnection.State.CONNECTED }
+        connection.close()
+
+        withTimeout(5_000) {
+            for (call in listOf<suspend () -> Unit>(
+                { connection.subscribe(Topic.CHAT, "room1", Delivery.Reliable()).first() },
+                { connection.ping() },
+                { connection.publish(Topic.CHAT, "room1", byteArrayOf(1)) }
+            )) {
+                try {
+                    call()
+                    fail("call on a closed connection succeeded")
+                } catch (e: IllegalStateException) {
+                    // Expected.
+                }
+            }
+        }
+    }
+
+    @Test
+    fun publishWaitingOnAFullQueueFailsOnClose() = runBlocking {
+        // Never connects, so nothing drains the one-entry queue.
+        val connection = RealtimeConnection(
+            scope,
+            connect = { awaitCancellation() },
+            idToken = { "id-token" },
+            publishBuffer = 1
+        ).also { connections += it }
+        connection.publish(Topic.CHAT, "room1", byteArrayOf(1))
+        val blocked = scope.async { runCatching { connection.publish(Topic.CHAT, "room1", byteArrayOf(2)) } }
+        delay(100)
+        assertTrue(blocked.isActive)
+
+        connection.close()
+        assertTrue(withTimeout(5_000) { blocked.await() }.exceptionOrNull() is ClosedSendChannelException)
+    }
+
+    @Test
+    fun pingFailsWhenTheConnectionDrops() = runBlocking {
+        val connection = connection()
+        server.answerPings = false
+        val ping = scope.async { runCatching { connection.ping() } }
+        eventually { connection.state.value == RealtimeConnection.State.CONNECTED }
+        delay(100)
+
+        server.dropConnections()
+        assertTrue(withTimeout(5_000) { ping.await() }.exceptionOrNull() is IOException)
+    }
+
+    private companion object {
+        const val MESSAGES = 50_000
+    }
+}
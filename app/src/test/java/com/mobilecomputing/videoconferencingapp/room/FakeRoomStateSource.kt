@@ -0,0 +1,85 @@
+package com.mobilecomputing.videoconferencingapp.room
+
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.channels.SendChannel
+import kotlinx.coroutines.channels.awaitClose
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.buffer
+import kotlinx.coroutines.flow.callbackFlow
+import java.io.IOException
+
+/**
+ * In-memory shard documents with Firestore's listener semantics: a new
+ * listener gets every non-empty shard, then the shards each commit changed.
+ * Commits take [commitDelayMillis]; the next [failCommits] of them fail,
+ * and after those the next [rejectCommits] are rejected.
+ * Every document write is timed with [clock] so tests can check write rates.
+ */
+class FakeRoomStateSource(
+    private val clock: () -> Long,
+    private val commitDelayMillis: Long = 30,
+    var failCommits: Int = 0,
+    var rejectCommits: Int = 0
+) : RoomStateSource {
+    private val docs = HashMap<String, HashMap<Int, Map<String, Participant>>>()
+    private val listeners = HashMap<String, MutableList<SendChannel<List<ShardSnapshot>>>>()
+
+    var commits = 0
+        private set
+
+    /** Write times per shard document, across rooms. */
+    val writeTimes = HashMap<Int, MutableList<Long>>()
+
+    val documentWrites: Int get() = writeTimes.values.sumOf { it.size }
+
+    /** The most writes any one document took within a second. */
+    fun peakWritesPerDocumentSecond(): Int = writeTimes.values.maxOfOrNull { times ->
+        var peak = 0
+        var start = 0
+        for (end in times.indices) {
+            while (times[end] - times[start] >= 1_000) start++
+            peak = maxOf(peak, end - start + 1)
+        }
+        peak
+    } ?: 0
+
+    fun participants(roomId: String): Map<String, Participant> = synchronized(this) {
+        docs[roomId].orEmpty().values.fold(emptyMap()) { all, shard -> all + shard }
+    }
+
+    override suspend fun commit(roomId: String, writes: List<ShardWrite>) {
+        delay(commitDelayMillis)
+        synchronized(this) {
+            if (failCommits > 0) {
+                failCommits--
+                throw IOException("unavailable")
+            }
+            if (rejectCommits > 0) {
+                rejectCommits--
+                throw RejectedWriteException("permission denied")
+            }
+            commits++
+            val room = docs.getOrPut(roomId) { HashMap() }
+            val changed = writes.map { write ->
+                val shard = HashMap(room[write.shard].orEmpty())
+                write.changes.forEach { (uid, participant) ->
+                    if (participant == null) shard.remove(uid) else shard[uid] = participant
+                }
+                room[write.shard] = shard
+                writeTimes.getOrPut(write.shard) { ArrayList() } += clock()
+                ShardSnapshot(write.shard, shard)
+            }
+            listeners[roomId].orEmpty().forEach { it.trySend(changed) }
+        }
+    }
+
+    override fun shards(roomId: String): Flow<List<ShardSnapshot>> = callbackFlow {
+        synchronized(this@FakeRoomStateSource) {
+            listeners.getOrPut(roomId) { ArrayList() } += channel
+            val initial = docs[roomId].orEmpty().filterValues { it.isNotEmpty() }
+            if (initial.isNotEmpty()) trySend(initial.map { (shard, participants) -> ShardSnapshot(shard, participants) })
+        }
+        awaitClose { synchronized(this@FakeRoomStateSource) { listeners[roomId]?.remove(channel) } }
+    }.buffer(Channel.UNLIMITED)
+}
@@ -0,0 +1,60 @@
+package com.mobilecomputing.videoconferencingapp.room
+
+import com.mobilecomputing.videoconferencingapp.room.ParticipantDelta.Flags
+import com.mobilecomputing.videoconferencingapp.room.ParticipantDelta.Joined
+import com.mobilecomputing.videoconferencingapp.room.ParticipantDelta.Left
+import com.mobilecomputing.videoconferencingapp.room.ParticipantItem.Companion.AUDIO_MUTED
+import com.mobilecomputing.videoconferencingapp.room.ParticipantItem.Companion.SPEAKING
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertSame
+import org.junit.Assert.assertTrue
+import org.junit.Test
+
+class ParticipantStoreTest {
+    private val ada = ParticipantItem("ada", "Ada", joinedAtMillis = 10)
+    private val grace = ParticipantItem("grace", "Grace", joinedAtMillis = 20)
+    private val linus = ParticipantItem("linus", "Linus", joinedAtMillis = 30)
+
+    @Test
+    fun keepsJoinOrderAndReportsStructuralChanges() {
+        val store = ParticipantStore()
+        store.apply(listOf(Joined(linus), Joined(ada)))
+        val list = store.apply(listOf(Joined(grace), Left("linus")))
+
+        assertEquals(listOf("ada", "grace"), list.items.map { it.uid })
+        assertEquals(listOf(ListChange.Inserted(1, "grace"), ListChange.Removed(2, "linus")), list.changes)
+    }
+
+    @Test
+    fun flagDeltasReplaceOnlyTheirItem() {
+        val store = ParticipantStore()
+        val before = store.apply(listOf(Joined(ada), Joined(grace), Joined(linus)))
+        val after = store.apply(listOf(Flags("grace", set = SPEAKING or AUDIO_MUTED)))
+
+        assertEquals(listOf(ListChange.Changed(1, "grace")), after.changes)
+        assertTrue(after.items[1].speaking && after.items[1].audioMuted)
+        // Unchanged items are the same instances, so their tiles skip.
+        assertSame(before.items[0], after.items[0])
+        assertSame(before.items[2], after.items[2])
+    }
+
+    @Test
+    fun noOpDeltasPublishNothing() {
+        val store = ParticipantStore()
+        val list = store.apply(listOf(Joined(ada)))
+
+        assertSame(list, store.apply(listOf(Flags("ada", set = 0, clear = SPEAKING), Left("nobody"), Joined(ada))))
+        assertEquals(1L, store.state.value.version)
+    }
+
+    @Test
+    fun roomDiffsKeepCallOnlyFlags() {
+        val store = ParticipantStore()
+        store.apply(listOf(Joined(ada), Flags("ada", set = SPEAKING)))
+        store.apply(RoomDiff(updated = listOf(Participant("ada", "Ada L.", audioMuted = true, joinedAtMillis = 10))))
+
+        val item = store["ada"]!!
+        assertEquals("Ada L.", item.displayName)
+        assertTrue(item.speaking && item.audioMuted)
+    }
+}
@@ -0,0 +1,179 @@
+package com.mobilecomputing.videoconferencingapp.room
+
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.joinAll
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.test.TestScope
+import kotlinx.coroutines.test.advanceTimeBy
+import kotlinx.coroutines.test.advanceUntilIdle
+import kotlinx.coroutines.test.runCurrent
+import kotlinx.coroutines.test.runTest
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import org.junit.runner.RunWith
+
+// Robolectric for android.util.Log.
+@RunWith(AndroidJUnit4::class)
+class RoomStateStoreTest {
+    private val ada = Participant("ada", "Ada", joinedAtMillis = 1)
+
+    @Test
+    fun rapidChangesAreCoalesced() = runTest {
+        val source = FakeRoomStateSource(clock = { testScheduler.currentTime })
+        val store = RoomStateStore(source, backgroundScope, "room1")
+
+        store.update(ada)
+        runCurrent()
+        repeat(10) { store.update(ada.copy(audioMuted = it % 2 == 0, handRaised = true)) }
+        advanceTimeBy(2_000)
+
+        // The join at once, then the latest of the ten.
+        assertEquals(2, source.commits)
+        assertEquals(ada.copy(audioMuted = false, handRaised = true), source.participants("room1")["ada"])
+    }
+
+    @Test
+    fun failedWriteIsRetriedWithoutOverwritingNewerChanges() = runTest {
+        val source = FakeRoomStateSource(clock = { testScheduler.currentTime }, failCommits = 1)
+        val store = RoomStateStore(source, backgroundScope, "room1", minWriteIntervalMillis = 500)
+
+        store.update(ada)
+        store.update(Participant("grace", "Grace"))
+        runCurrent()
+        store.update(ada.copy(audioMuted = true))
+        advanceTimeBy(2_000)
+
+        assertEquals(setOf("ada", "grace"), source.participants("room1").keys)
+        assertTrue(source.participants("room1").getValue("ada").audioMuted)
+    }
+
+    @Test
+    fun repeatedFailuresBackOff() = runTest {
+        val source = FakeRoomStateSource(clock = { testScheduler.currentTime }, failCommits = 4)
+        val store = RoomStateStore(source, backgroundScope, "room1")
+
+        store.update(ada)
+        // Retries after 1, 2, 4 and 8 s rather than every second.
+        advanceTimeBy(10_000)
+        assertEquals(0, source.commits)
+        advanceTimeBy(6_000)
+        assertEquals(1, source.commits)
+        assertEquals(setOf("ada"), source.participants("room1").keys)
+    }
+
+    @Test
+    fun rejectedWriteIsDropped() = runTest {
+        val source = FakeRoomStateSource(clock = { testScheduler.currentTime }, rejectCommits = 1)
+        val store = RoomStateStore(source, backgroundScope, "room1")
+
+        store.update(ada)
+        advanceTimeBy(5_000)
+        store.update(Participant("grace", "Grace"))
+        advanceTimeBy(5_000)
+
+        assertEquals(1, source.commits)
+        assertEquals(setOf("grace"), source.participants("room1").keys)
+    }
+
+    @Test
+    fun diffsCarryOnlyWhatChanged() = runTest {
+        val source = FakeRoomStateSource(clock = { testScheduler.currentTime })
+        val writer = RoomStateStore(source, backgroundScope, "room1", minWriteIntervalMillis = 0)
+        val grace = Participant("grace", "Grace")
+        writer.update(ada)
+        advanceUntilIdle()
+
+        val diffs = ArrayList<RoomDiff>()
+        backgroundScope.launch { RoomStateStore(source, backgroundScope, "room1").diffs().collect { diffs += it } }
+        runCurrent()
+        writer.update(grace)
+        advanceTimeBy(100)
+        writer.update(ada.copy(audioMuted = true))
+        advanceTimeBy(100)
+        writer.remove("grace")
+        advanceTimeBy(100)
+
+        assertEquals(
+            listOf(
+                RoomDiff(joined = listOf(ada)),
+                RoomDiff(joined = listOf(grace)),
+                RoomDiff(updated = listOf(ada.copy(audioMuted = true))),
+                RoomDiff(left = listOf("grace"))
+            ),
+            diffs
+        )
+    }
+
+    private class JoinRun(val source: FakeRoomStateSource, val roster: Map<String, Participant>, val joinMillis: List<Long>)
+
+    // 500 clients join over five seconds, each then changing its record three
+    // times in 300 ms, while one more client watches the roster.
+    private suspend fun TestScope.joinFiveHundred(shardCount: Int, minWriteIntervalMillis: Long): JoinRun {
+        val source = FakeRoomStateSource(clock = { testScheduler.currentTime })
+        val joinedAt = HashMap<String, Long>()
+        val joinMillis = ArrayList<Long>()
+        var roster = emptyMap<String, Participant>()
+        var diffEntries = 0
+        var snapshotEntries = 0
+        backgroundScope.launch {
+            RoomStateStore(source, backgroundScope, "room1", shardCount).diffs().collect { diff ->
+                roster = diff.applyTo(roster)
+                diff.joined.forEach { joinMillis += testScheduler.currentTime - joinedAt.getValue(it.uid) }
+                diffEntries += diff.joined.size + diff.updated.size + diff.left.size
+                snapshotEntries += roster.size
+            }
+        }
+        runCurrent()
+
+        List(JOINERS) { i ->
+            launch {
+                delay(i * 10L)
+                val store = RoomStateStore(source, backgroundScope, "room1", shardCount, minWriteIntervalMillis)
+                val self = Participant("user$i", "User $i", joinedAtMillis = testScheduler.currentTime)
+                joinedAt[self.uid] = testScheduler.currentTime
+                store.update(self)
+                delay(100)
+                store.update(self.copy(audioMuted = true))
+                delay(100)
+                store.update(self.copy(audioMuted = true, videoEnabled = false))
+                delay(100)
+                store.update(self.copy(audioMuted = true, videoEnabled = false, handRaised = true))
+            }
+        }.joinAll()
+        advanceTimeBy(5_000)
+
+        println(
+            "$shardCount shards, ${minWriteIntervalMillis} ms throttle: ${source.commits} commits, " +
+                "${source.documentWrites} document writes, peak ${source.peakWritesPerDocumentSecond()} writes/s " +
+                "to one document; $diffEntries diff entries vs $snapshotEntries in full snapshots"
+        )
+        assertTrue(diffEntries * 50 < snapshotEntries)
+        return JoinRun(source, roster, joinMillis.sorted())
+    }
+
+    @Test
+    fun fiveHundredJoiners() = runTest {
+        val single = joinFiveHundred(shardCount = 1, minWriteIntervalMillis = 0)
+        val sharded = joinFiveHundred(shardCount = RoomStateStore.DEFAULT_SHARDS, minWriteIntervalMillis = 1_000)
+
+        for (run in listOf(single, sharded)) {
+            assertEquals(JOINERS, run.roster.size)
+            assertTrue(run.roster.values.all { it.audioMuted && !it.videoEnabled && it.handRaised })
+        }
+        // Half the writes, spread over the shards.
+        assertTrue(sharded.source.documentWrites * 2 <= single.source.documentWrites)
+        val singlePeak = single.source.peakWritesPerDocumentSecond()
+        val shardedPeak = sharded.source.peakWritesPerDocumentSecond()
+        assertTrue("peak $shardedPeak vs $singlePeak writes/s", shardedPeak * 20 <= singlePeak)
+        // Throttling holds back follow-up changes, not joins.
+        val p99 = sharded.joinMillis[sharded.joinMillis.size * 99 / 100]
+        println("join visible after p50 ${sharded.joinMillis[JOINERS / 2]} ms, p99 $p99 ms")
+        assertTrue("p99 $p99 ms", p99 <= 100)
+    }
+
+    private companion object {
+        const val JOINERS = 500
+    }
+}
@@ -0,0 +1,121 @@
+package com.mobilecomputing.videoconferencingapp.startup
+
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.test.StandardTestDispatcher
+import kotlinx.coroutines.test.TestScope
+import kotlinx.coroutines.test.runTest
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertNotEquals
+import org.junit.Assert.assertNotNull
+import org.junit.Assert.assertTrue
+import org.junit.Assert.fail
+import org.junit.Test
+
+class InitGraphTest {
+    private fun TestScope.graph(vararg components: Component<*>) =
+        InitGraph(components.toList(), backgroundScope, StandardTestDispatcher(testScheduler))
+
+    @Test
+    fun mainComponentsAreReadyAfterStartOnTheCallingThread() = runTest {
+        val caller = Thread.currentThread()
+        var createdOn: Thread? = null
+        val config = Component("config", InitPhase.MAIN) { "cfg" }
+        val session = Component("session", InitPhase.MAIN, listOf(config)) {
+            createdOn = Thread.currentThread()
+            "session:${config.name}"
+        }
+        val graph = graph(session, config)
+
+        graph.start()
+
+        assertEquals("session:config", graph.get(session))
+        assertEquals(caller, createdOn)
+        assertEquals(listOf("config", "session"), graph.timings.map { it.name })
+    }
+
+    @Test
+    fun afterFirstFrameComponentsWaitForTheFirstFrame() = runTest {
+        val created = mutableListOf<String>()
+        val db = Component("db", InitPhase.BACKGROUND) { created += "db" }
+        val codecs = Component("codecs", InitPhase.AFTER_FIRST_FRAME, listOf(db)) { created += "codecs" }
+        val graph = graph(db, codecs)
+
+        graph.start()
+        testScheduler.advanceUntilIdle()
+        assertEquals(listOf("db"), created)
+
+        graph.onFirstFrame()
+        graph.await(codecs)
+        assertEquals(listOf("db", "codecs"), created)
+        assertEquals(0L, graph.mainThreadMillis)
+    }
+
+    @Test
+    fun backgroundComponentsRunInParallelOffTheMainThread() = runBlocking {
+        val caller = Thread.currentThread()
+        val threads = mutableListOf<Thread>()
+        fun slow(name: String) = Component(name, InitPhase.BACKGROUND) {
+            synchronized(threads) { threads += Thread.currentThread() }
+            Thread.sleep(200)
+        }
+        val a = slow("a")
+        val b = slow("b")
+        val c = slow("c")
+        val graph = InitGraph(listOf(a, b, c), CoroutineScope(SupervisorJob()), Dispatchers.Default)
+
+        val begin = System.nanoTime()
+        graph.start()
+        graph.await(a)
+        graph.await(b)
+        graph.await(c)
+        val elapsedMillis = (System.nanoTime() - begin) / 1_000_000
+
+        assertTrue("took $elapsedMillis ms", elapsedMillis < 500)
+        assertFalse(caller in threads)
+        assertEquals(3, graph.timings.size)
+        assertTrue(graph.timings.all { it.durationMillis >= 190 })
+    }
+
+    @Test
+    fun failuresPropagateToDependentsAndAreRecorded() = runTest {
+        val engine = Component<Unit>("engine", InitPhase.BACKGROUND) { throw IllegalStateException("no lib") }
+        val codecs = Component("codecs", InitPhase.BACKGROUND, listOf(engine)) { 1 }
+        val graph = graph(engine, codecs)
+
+        graph.start()
+        try {
+            graph.await(codecs)
+            fail("codecs should have failed")
+        } catch (e: IllegalStateException) {
+            assertEquals("no lib", e.message)
+        }
+        assertNotNull(graph.timings.single { it.name == "engine" }.error)
+    }
+
+    @Test
+    fun rejectsCyclesAndPhaseInversions() = runTest {
+        val late = Component("late", InitPhase.AFTER_FIRST_FRAME) { 0 }
+        val early = Component("early", InitPhase.MAIN, listOf(late)) { 0 }
+        try {
+            graph(late, early)
+            fail("MAIN waiting for AFTER_FIRST_FRAME accepted")
+        } catch (e: IllegalArgumentException) {
+            assertNotEquals(null, e.message)
+        }
+
+        val deps = mutableListOf<Component<*>>()
+        val x = Component("x", InitPhase.BACKGROUND, deps) { 0 }
+        val y = Component("y", InitPhase.BACKGROUND, listOf(x)) { 0 }
+        deps += y
+        try {
+            graph(x, y)
+            fail("cycle accepted")
+        } catch (e: IllegalArgumentException) {
+            assertTrue(e.message!!.contains("cycle"))
+        }
+    }
+}
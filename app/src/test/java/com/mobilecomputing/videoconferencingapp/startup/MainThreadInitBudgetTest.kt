@@ -0,0 +1,41 @@
+package com.mobilecomputing.videoconferencingapp.startup
+
+import androidx.test.core.app.ApplicationProvider
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import com.mobilecomputing.videoconferencingapp.SignedOutApplication
+import com.mobilecomputing.videoconferencingapp.VideoConferencingApplication
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import org.junit.runner.RunWith
+import org.robolectric.annotation.Config
+
+/**
+ * Guards the main thread at startup. Moving a component to InitPhase.MAIN
+ * must be a deliberate change to [MAIN_COMPONENTS]. The main-thread time is
+ * only reported: Robolectric wall-clock numbers say nothing about a device
+ * and would make the build flaky. Check the budget on a device, where
+ * each component's init time is logged at startup.
+ */
+@RunWith(AndroidJUnit4::class)
+@Config(application = SignedOutApplication::class)
+class MainThreadInitBudgetTest {
+    private val app = ApplicationProvider.getApplicationContext<VideoConferencingApplication>()
+
+    @Test
+    fun onlyTheSessionIsCreatedOnTheMainThread() {
+        val main = app.initGraph.timings.filter { it.phase == InitPhase.MAIN }.map { it.name }
+        assertEquals(MAIN_COMPONENTS, main)
+    }
+
+    @Test
+    fun reportsMainThreadInitTime() {
+        val millis = app.initGraph.mainThreadMillis
+        println("main-thread init: $millis ms")
+        assertTrue("main-thread init time not recorded: $millis ms", millis >= 0)
+    }
+
+    private companion object {
+        val MAIN_COMPONENTS = listOf("session")
+    }
+}
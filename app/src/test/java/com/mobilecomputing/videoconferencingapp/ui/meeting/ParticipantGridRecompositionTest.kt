@@ -0,0 +1,80 @@
+package com.mobilecomputing.videoconferencingapp.ui.meeting
+
+import androidx.compose.runtime.SideEffect
+import androidx.compose.runtime.collectAsState
+import androidx.compose.runtime.getValue
+import androidx.compose.ui.test.junit4.createComposeRule
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import com.mobilecomputing.videoconferencingapp.room.ParticipantDelta
+import com.mobilecomputing.videoconferencingapp.room.ParticipantItem
+import com.mobilecomputing.videoconferencingapp.room.ParticipantItem.Companion.AUDIO_MUTED
+import com.mobilecomputing.videoconferencingapp.room.ParticipantItem.Companion.SPEAKING
+import com.mobilecomputing.videoconferencingapp.room.ParticipantStore
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Rule
+import org.junit.Test
+import org.junit.runner.RunWith
+
+/**
+ * Counts tile recompositions in a 1,000-participant grid taking 50 updates
+ * a second for four seconds. Each update lands in its own frame; half of
+ * them hit visible tiles, half participants scrolled out of view.
+ */
+@RunWith(AndroidJUnit4::class)
+class ParticipantGridRecompositionTest {
+    @get:Rule
+    val composeRule = createComposeRule()
+
+    @Test
+    fun updatesRecomposeOnlyTheTilesTheyChange() {
+        val store = ParticipantStore()
+        store.apply(List(PARTICIPANTS) { ParticipantDelta.Joined(ParticipantItem("user$it", "User $it", it.toLong())) })
+        val compositions = HashMap<String, Int>()
+        var gridCompositions = 0
+        composeRule.setContent {
+            val participants by store.state.collectAsState()
+            SideEffect { gridCompositions++ }
+            ParticipantGrid(participants) { participant ->
+                SideEffect { compositions.merge(participant.uid, 1) { a, b -> a + b } }
+                ParticipantTile(participant)
+            }
+        }
+        composeRule.waitForIdle()
+        val visible = compositions.keys.toSet()
+        assertTrue("${visible.size} tiles composed", visible.size in 4 until PARTICIPANTS / 10)
+        compositions.clear()
+        gridCompositions = 0
+
+        val hits = HashMap<String, Int>()
+        repeat(UPDATES) { update ->
+            // Alternate between on-screen tiles and participants far down the list.
+            val uid = if (update % 2 == 0) "user${update / 2 % 4}" else "user${500 + update}"
+            val flag = if (update % 3 == 0) AUDIO_MUTED else SPEAKING
+            val delta = if (store[uid]!!.flags and flag == 0) {
+                ParticipantDelta.Flags(uid, set = flag)
+            } else {
+                ParticipantDelta.Flags(uid, set = 0, clear = flag)
+            }
+            store.apply(listOf(delta))
+            if (uid in visible) hits.merge(uid, 1) { a, b -> a + b }
+            composeRule.mainClock.advanceTimeBy(1_000L / UPDATES_PER_SECOND)
+            composeRule.waitForIdle()
+        }
+
+        val recomposed = compositions.values.sum()
+        println(
+            "$UPDATES updates over ${visible.size} visible of $PARTICIPANTS tiles: $recomposed tile " +
+                "recompositions, $gridCompositions of the grid; rebuilding would recompose ${UPDATES * visible.size}"
+        )
+        // One recomposition per update to a visible tile, none for the rest.
+        assertEquals(hits, compositions)
+        assertTrue(gridCompositions <= UPDATES)
+    }
+
+    private companion object {
+        const val PARTICIPANTS = 1_000
+        const val UPDATES_PER_SECOND = 50
+        const val UPDATES = UPDATES_PER_SECOND * 4
+    }
+}
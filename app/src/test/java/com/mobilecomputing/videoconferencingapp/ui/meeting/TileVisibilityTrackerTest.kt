@@ -0,0 +1,52 @@
+package com.mobilecomputing.videoconferencingapp.ui.meeting
+
+import androidx.compose.ui.geometry.Rect
+import androidx.compose.ui.unit.IntSize
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertSame
+import org.junit.Assert.assertTrue
+import org.junit.Test
+
+class TileVisibilityTrackerTest {
+    private val size = IntSize(528, 297)
+
+    private fun TileVisibilityTracker.tile(uid: String, top: Float, clipTop: Float = top) =
+        report(uid, size, Rect(0f, clipTop, 528f, top + 297f))
+
+    @Test
+    fun scrolledOffAndDisposedTilesDropOut() {
+        val tracker = TileVisibilityTracker()
+        tracker.tile("ada", top = 0f)
+        tracker.tile("grace", top = 305f)
+        // Scrolled up until only a sliver is left above the viewport's edge.
+        tracker.tile("linus", top = -290f, clipTop = 0f)
+        tracker.remove("grace")
+
+        assertEquals(setOf("ada"), tracker.tiles.value.keys)
+        assertEquals(size, tracker.tiles.value.getValue("ada").size)
+    }
+
+    @Test
+    fun occluderAndBackgroundHideTiles() {
+        val tracker = TileVisibilityTracker()
+        tracker.tile("ada", top = 0f)
+        tracker.tile("grace", top = 1500f)
+        tracker.setOccluder(Rect(0f, 1296f, 1080f, 2160f))
+        assertEquals(setOf("ada"), tracker.tiles.value.keys)
+
+        tracker.setForeground(false)
+        assertTrue(tracker.tiles.value.isEmpty())
+        tracker.setForeground(true)
+        assertEquals(setOf("ada"), tracker.tiles.value.keys)
+    }
+
+    @Test
+    fun movingTilesPublishNothing() {
+        val tracker = TileVisibilityTracker()
+        tracker.tile("ada", top = 0f)
+        val before = tracker.tiles.value
+        tracker.tile("ada", top = -40f, clipTop = 0f)
+
+        assertSame(before, tracker.tiles.value)
+    }
+}